@@ -0,0 +1,161 @@
+#pragma once
+
+/**
+ *  @file BindlessDescriptorTable.h
+ *
+ *  @brief A persistent range of shader resource views that shaders index directly.
+ *
+ *  Resources are registered once and keep their index until they are released.
+ *  The descriptors are stored in a CPU visible descriptor heap. The first
+ *  descriptors of every GPU visible descriptor heap that a DynamicDescriptorHeap
+ *  creates are reserved for the bindless descriptor table. The table is only
+ *  copied to a GPU visible descriptor heap when the heap is first used or after
+ *  the table has changed, not for every draw. Only the descriptors that changed
+ *  since the last copy are written, so the descriptors that are used by previous
+ *  commands in a command list are not rewritten while the command list is recorded.
+ *
+ *  A root signature declares the bindless descriptor table as a descriptor table
+ *  with an unbounded SRV range (NumDescriptors = UINT_MAX), for example:
+ *
+ *      Texture2D Textures[] : register( t0, space2 );
+ *
+ *  and binds it with CommandList::SetBindlessDescriptorTable.
+ *
+ *  Registered resources are kept alive by the table. They are not transitioned
+ *  automatically when they are used by a shader, so they must be in a shader
+ *  resource state (see CommandList::TransitionBarrier).
+ */
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dx12lib
+{
+
+class Device;
+class Resource;
+class Texture;
+
+class BindlessDescriptorTable
+{
+public:
+    /**
+     * The index of an invalid (unregistered) descriptor.
+     */
+    static const uint32_t InvalidIndex = 0xffffffff;
+
+    /**
+     * Register the default SRV of a texture. If the texture is already
+     * registered, the existing index is returned.
+     *
+     * @returns The index of the SRV in the bindless descriptor table.
+     */
+    uint32_t RegisterTexture( const std::shared_ptr<Texture>& texture );
+
+    /**
+     * Register an SRV for a resource. The descriptor is copied to the table.
+     * The same resource can be registered multiple times (with different views).
+     */
+    uint32_t RegisterShaderResourceView( const std::shared_ptr<Resource>& resource,
+                                         D3D12_CPU_DESCRIPTOR_HANDLE      srv );
+
+    /**
+     * Release a descriptor. The descriptor (and the resource) is retired until
+     * the work that has been submitted to the command queues before the release
+     * has completed on the GPU. Only then is the index reused by another resource.
+     * Command lists that are still being recorded must not use the descriptor after
+     * it has been released.
+     */
+    void Release( uint32_t index );
+
+    /**
+     * Get the index of a registered texture (or InvalidIndex if the texture is not registered).
+     */
+    uint32_t GetTextureIndex( const std::shared_ptr<Texture>& texture ) const;
+
+    /**
+     * The maximum number of descriptors in the table.
+     */
+    uint32_t GetCapacity() const
+    {
+        return m_Capacity;
+    }
+
+    /**
+     * The number of registered descriptors.
+     */
+    uint32_t GetNumDescriptors() const;
+
+    /**
+     * The version is incremented every time the table changes.
+     */
+    uint64_t GetVersion() const
+    {
+        return m_Version.load();
+    }
+
+    /**
+     * Copy the descriptors of the table that have changed since a version of the
+     * table to the start of a (GPU visible) descriptor heap. Pass 0 to copy all of
+     * the descriptors that have been used.
+     *
+     * @returns The version of the table that was copied.
+     */
+    uint64_t CopyDescriptors( D3D12_CPU_DESCRIPTOR_HANDLE dstDescriptor, uint64_t copiedVersion ) const;
+
+protected:
+    friend class std::default_delete<BindlessDescriptorTable>;
+
+    // Can only be created by the Device.
+    BindlessDescriptorTable( Device& device, uint32_t capacity );
+    virtual ~BindlessDescriptorTable();
+
+private:
+    // The following functions must be called with the mutex locked.
+    void     ProcessRetiredDescriptors();
+    uint32_t AllocateIndex();
+    uint32_t RegisterDescriptor( const std::shared_ptr<Resource>& resource, D3D12_CPU_DESCRIPTOR_HANDLE srv );
+
+    Device& m_Device;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DescriptorHeap;
+    D3D12_CPU_DESCRIPTOR_HANDLE                  m_BaseDescriptor;
+    uint32_t                                     m_DescriptorHandleIncrementSize;
+    uint32_t                                     m_Capacity;
+
+    // A null SRV that is written to released descriptors.
+    D3D12_SHADER_RESOURCE_VIEW_DESC m_NullSRVDesc;
+
+    // The resources that are referenced by the descriptors (indexed by descriptor index).
+    std::vector<std::shared_ptr<Resource>> m_Resources;
+    std::unordered_map<Resource*, uint32_t> m_TextureIndices;
+    std::vector<uint32_t>                   m_FreeIndices;
+    // The version of the table when each descriptor was last written.
+    std::vector<uint64_t> m_DescriptorVersions;
+
+    // A released descriptor and the fence values (for the direct, compute, and
+    // copy queues) that must be reached before its index can be reused.
+    struct RetiredDescriptor
+    {
+        uint32_t                  Index;
+        std::shared_ptr<Resource> Resource;
+        uint64_t                  FenceValues[3];
+    };
+    std::deque<RetiredDescriptor> m_RetiredDescriptors;
+
+    // One past the highest descriptor index that has been used.
+    uint32_t m_NumUsedDescriptors;
+    uint32_t m_NumDescriptors;
+
+    std::atomic_uint64_t m_Version;
+    mutable std::mutex   m_Mutex;
+};
+}  // namespace dx12lib
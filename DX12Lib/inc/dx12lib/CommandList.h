@@ -31,29 +31,37 @@
  *  The CommandList class provides additional functionality that makes working with
  *  DirectX 12 applications easier.
  */
+#include "StagingAllocator.h"
+#include "TextureCooker.h"
+#include "TrackedObjectSet.h"
 #include "VertexTypes.h"
 
 #include <DirectXMath.h>
 #include <d3d12.h>
 #include <wrl.h>
 
-#include <functional>  // For std::function
-#include <map>         // for std::map
-#include <memory>      // for std::unique_ptr
-#include <mutex>       // for std::mutex
-#include <vector>      // for std::vector
+#include <chrono>         // For std::chrono::high_resolution_clock
+#include <functional>     // For std::function
+#include <map>            // for std::map
+#include <memory>         // for std::unique_ptr
+#include <mutex>          // for std::mutex
+#include <unordered_set>  // for std::unordered_set
+#include <vector>         // for std::vector
 
 namespace dx12lib
 {
 
 class Buffer;
 class ByteAddressBuffer;
+class CommandListRecorder;
+class CommandSignature;
 class ConstantBuffer;
 class ConstantBufferView;
 class Device;
 class DynamicDescriptorHeap;
 class GenerateMipsPSO;
 class IndexBuffer;
+class MipGenerator;
 class PanoToCubemapPSO;
 class PipelineStateObject;
 class RenderTarget;
@@ -216,8 +224,37 @@ public:
 
     /**
      * Load a texture by a filename.
+     * If the file does not contain a full mip chain, the mips are generated
+     * with GenerateMips, or on the CPU before the texture is uploaded if a mip
+     * generator is specified. Mips of texture arrays and cubemaps are always
+     * generated on the CPU (GenerateMips only supports single 2D textures).
+     *
+     * @param fileName The path to the texture file.
+     * @param sRGB Load the texture with an sRGB format.
+     * @param mipGenerator The mip generator used to generate the mips on the CPU (optional).
+     */
+    std::shared_ptr<Texture> LoadTextureFromFile( const std::wstring& fileName, bool sRGB = false,
+                                                  const MipGenerator* mipGenerator = nullptr );
+
+    /**
+     * Load a texture that is used in a specific way. If the device has a
+     * texture cooker (see Device::SetTextureCooker), the block compressed
+     * version of the texture is loaded (and cooked if it is not cached yet).
+     * Otherwise the texture is loaded uncompressed (as sRGB for albedo textures).
      */
-    std::shared_ptr<Texture> LoadTextureFromFile( const std::wstring& fileName, bool sRGB = false );
+    std::shared_ptr<Texture> LoadTextureFromFile( const std::wstring& fileName, TextureUsage usage );
+
+    /**
+     * Load a texture from a tiled, mip-mapped EXR file, or from an image that
+     * is converted to a tiled mip pyramid on first load (see TiledImage).
+     * Only the mips that are not larger than maxSize are decoded and uploaded,
+     * one band of tiles at a time, so the full resolution image is never held
+     * in memory unless it is needed.
+     *
+     * @param fileName The path to the .exr or .hdr file.
+     * @param maxSize The maximum width and height of the texture (0 loads all mips).
+     */
+    std::shared_ptr<Texture> LoadTiledTextureFromFile( const std::wstring& fileName, uint32_t maxSize = 0 );
 
     /**
      * Load a scene file.
@@ -323,10 +360,31 @@ public:
 
     /**
      * Copy subresource data to a texture.
+     * The subresource data is copied to staging memory immediately but the copy
+     * to the texture is batched with other pending uploads and recorded before
+     * the texture is used by any other command on the command list.
      */
     void CopyTextureSubresource( const std::shared_ptr<Texture>& texture, uint32_t firstSubresource,
                                  uint32_t numSubresources, D3D12_SUBRESOURCE_DATA* subresourceData );
 
+    /**
+     * Copy data to a region of a texture subresource.
+     * The region starts at (dstX, dstY, dstZ) and has the given size in texels.
+     * For block-compressed formats, the region must be aligned to the block size.
+     */
+    void CopyTextureRegion( const std::shared_ptr<Texture>& texture, uint32_t subresource, uint32_t dstX,
+                            uint32_t dstY, uint32_t dstZ, uint32_t width, uint32_t height, uint32_t depth,
+                            const D3D12_SUBRESOURCE_DATA& subresourceData );
+
+    /**
+     * Copy data to a region of an existing buffer.
+     * As with CopyTextureSubresource, the data is copied to staging memory
+     * immediately and the copy to the buffer is recorded with the next batch of
+     * pending uploads.
+     */
+    void CopyBufferRegion( const std::shared_ptr<Resource>& buffer, size_t dstOffset, size_t numBytes,
+                           const void* bufferData );
+
     /**
      * Set a dynamic constant buffer data to an inline descriptor in the root
      * signature.
@@ -433,6 +491,15 @@ public:
     void SetGraphicsRootSignature( const std::shared_ptr<RootSignature>& rootSignature );
     void SetComputeRootSignature( const std::shared_ptr<RootSignature>& rootSignature );
 
+    /**
+     * Get the (graphics or compute) root signature that is currently bound to
+     * the command list. Root arguments must be rebound when the root signature changes.
+     */
+    ID3D12RootSignature* GetD3D12RootSignature() const
+    {
+        return m_RootSignature;
+    }
+
     /**
      * Set an inline CBV.
      *
@@ -486,6 +553,15 @@ public:
                                                                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
                                 UINT firstSubresource = 0,
                                 UINT numSubresources  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES );
+
+    /**
+     * Bind the bindless descriptor table (see Device::GetBindlessDescriptorTable)
+     * to an unbounded descriptor table in the root signature. Resources that are
+     * registered in the bindless descriptor table are not transitioned or tracked
+     * by the command list.
+     */
+    void SetBindlessDescriptorTable( uint32_t rootParameterIndex );
+
     /**
      * Set the UAV on the graphics pipeline.
      */
@@ -521,6 +597,31 @@ public:
      */
     void Dispatch( uint32_t numGroupsX, uint32_t numGroupsY = 1, uint32_t numGroupsZ = 1 );
 
+    /**
+     * Execute commands that are stored in an argument buffer.
+     *
+     * @param commandSignature Describes the layout of the commands in the argument buffer.
+     * @param maxCommandCount The maximum number of commands to execute.
+     * @param argumentBuffer The buffer that contains the command arguments.
+     * @param argumentBufferOffset The offset (in bytes) of the first command in the argument buffer.
+     * @param [countBuffer] An optional buffer that contains the number of
+     * commands to execute. If specified, the number of executed commands is the
+     * minimum of the value in the count buffer and maxCommandCount.
+     * @param [countBufferOffset] The offset (in bytes) of the command count in the count buffer.
+     */
+    void ExecuteIndirect( const std::shared_ptr<CommandSignature>& commandSignature, uint32_t maxCommandCount,
+                          const std::shared_ptr<Buffer>& argumentBuffer, uint64_t argumentBufferOffset = 0,
+                          const std::shared_ptr<Buffer>& countBuffer = nullptr, uint64_t countBufferOffset = 0 );
+
+    /**
+     * Keep a resource alive until the command list has finished executing on
+     * the GPU. Resources that are bound or copied with the command list are
+     * tracked automatically, but resources that are only referenced by the
+     * arguments of ExecuteIndirect (for example, vertex and index buffer
+     * views in the argument buffer) need to be tracked explicitly.
+     */
+    void TrackResource( const std::shared_ptr<Resource>& res );
+
 protected:
     friend class CommandQueue;
     friend class DynamicDescriptorHeap;
@@ -566,6 +667,37 @@ protected:
     }
 
 private:
+    // Used by the public commands to record the command while a capture is in
+    // progress (see CommandRecorder). Only the outermost command is recorded.
+    class CaptureScope
+    {
+    public:
+        explicit CaptureScope( CommandList& commandList )
+        : m_CommandList( commandList )
+        , m_Recorder( commandList.m_CaptureDepth++ == 0 ? commandList.m_Recorder.get() : nullptr )
+        {}
+
+        ~CaptureScope()
+        {
+            --m_CommandList.m_CaptureDepth;
+        }
+
+        // The recorder (or nullptr if the command is not recorded).
+        CommandListRecorder* operator->() const
+        {
+            return m_Recorder;
+        }
+
+        explicit operator bool() const
+        {
+            return m_Recorder != nullptr;
+        }
+
+    private:
+        CommandList&         m_CommandList;
+        CommandListRecorder* m_Recorder;
+    };
+
     // Used for procedural mesh generation.
     using VertexCollection = std::vector<dx12lib::VertexPositionNormalTangentBitangentTexture>;
     using IndexCollection  = std::vector<uint16_t>;
@@ -586,9 +718,13 @@ private:
                             float radius, bool isTop );
 
     // Add a resource to a list of tracked resources (ensures lifetime while command list is in-flight on a command
-    // queue.
-    void TrackResource( Microsoft::WRL::ComPtr<ID3D12Object> object );
-    void TrackResource( const std::shared_ptr<Resource>& res );
+    // queue. Objects that are already tracked by the command list are not added again.
+    void TrackResource( ID3D12Object* object );
+    template<typename T>
+    void TrackResource( const Microsoft::WRL::ComPtr<T>& object )
+    {
+        TrackResource( object.Get() );
+    }
 
     // Generate mips for UAV compatible textures.
     void GenerateMips_UAV( const std::shared_ptr<Texture>& texture, bool isSRGB );
@@ -597,6 +733,14 @@ private:
     Microsoft::WRL::ComPtr<ID3D12Resource> CopyBuffer( size_t bufferSize, const void* bufferData,
                                                        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE );
 
+    // Allocate staging memory from the device's staging allocator.
+    StagingAllocator::Allocation AllocateStagingMemory( size_t sizeInBytes, size_t alignment );
+
+    // Record all pending (staged) uploads to the command list as a single batch.
+    void FlushPendingUploads();
+    // Record pending uploads only if the resource has a pending upload.
+    void FlushPendingUploads( ID3D12Resource* resource );
+
     // Binds the current descriptor heaps to the command list.
     void BindDescriptorHeaps();
 
@@ -636,19 +780,62 @@ private:
     // heaps if they are different than the currently bound descriptor heaps.
     ID3D12DescriptorHeap* m_DescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
+    // A copy from staging memory to a buffer that has not been recorded yet.
+    struct PendingBufferUpload
+    {
+        ID3D12Resource* Destination;
+        uint64_t        DestinationOffset;
+        ID3D12Resource* Source;
+        uint64_t        SourceOffset;
+        uint64_t        NumBytes;
+    };
+
+    // A copy from staging memory to a texture subresource that has not been recorded yet.
+    struct PendingTextureUpload
+    {
+        ID3D12Resource*                    Destination;
+        UINT                               Subresource;
+        UINT                               DstX;
+        UINT                               DstY;
+        UINT                               DstZ;
+        ID3D12Resource*                    Source;
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT Footprint;
+    };
+
+    // Uploads are staged immediately but the copy commands are deferred until
+    // the destination resource is used (or the command list is closed) so that
+    // all pending uploads can be recorded behind a single set of barriers.
+    std::vector<PendingBufferUpload>    m_PendingBufferUploads;
+    std::vector<PendingTextureUpload>   m_PendingTextureUploads;
+    std::unordered_set<ID3D12Resource*> m_PendingUploadResources;
+    uint64_t                            m_NumPendingUploadBytes;
+
+    // Staging chunks used by this command list. The last chunk is the one that
+    // is currently being allocated from. Chunks are returned to the staging
+    // allocator when the command list is reset.
+    std::vector<std::shared_ptr<StagingAllocator::Chunk>> m_StagingChunks;
+
+    // Used to measure upload throughput.
+    uint64_t                                       m_NumStagedBytes;
+    std::chrono::high_resolution_clock::time_point m_FirstUploadBatchTime;
+
     // Pipeline state object for Mip map generation.
     std::unique_ptr<GenerateMipsPSO> m_GenerateMipsPSO;
     // Pipeline state object for converting panorama (equirectangular) to cubemaps
     std::unique_ptr<PanoToCubemapPSO> m_PanoToCubemapPSO;
 
-    using TrackedObjects = std::vector<Microsoft::WRL::ComPtr<ID3D12Object>>;
-
     // Objects that are being tracked by a command list that is "in-flight" on
     // the command-queue and cannot be deleted. To ensure objects are not deleted
     // until the command list is finished executing, a reference to the object
     // is stored. The referenced objects are released when the command list is
     // reset.
-    TrackedObjects m_TrackedObjects;
+    TrackedObjectSet m_TrackedObjects;
+
+    // Records the commands of the command list while a capture is in progress
+    // (null otherwise). Set by the command queue.
+    std::unique_ptr<CommandListRecorder> m_Recorder;
+    // The number of nested commands that are being executed.
+    uint32_t m_CaptureDepth;
 
     // Keep track of loaded textures to avoid loading the same texture multiple times.
     static std::map<std::wstring, ID3D12Resource*> ms_TextureCache;
@@ -0,0 +1,222 @@
+#pragma once
+
+/**
+ *  @file CommandRecorder.h
+ *
+ *  @brief Captures the commands that are executed on the command queues of a
+ *  device to a file (see CommandStream.h).
+ *
+ *  While a capture is in progress, every command list that is returned from a
+ *  command queue gets a CommandListRecorder that serializes the public
+ *  commands of the command list. Only the outermost command is recorded (the
+ *  barriers and bindings that a command issues internally are issued again
+ *  when the command is replayed). The commands of a command list are appended
+ *  to the capture when the command list is executed on a command queue.
+ *
+ *  Captures are replayed with the CommandStreamPlayer.
+ */
+
+#include "CommandStream.h"
+
+#include <d3d12.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace dx12lib
+{
+
+class CommandRecorder;
+class CommandSignature;
+class ConstantBufferView;
+class PipelineStateObject;
+class Resource;
+class RootSignature;
+class ShaderResourceView;
+class UnorderedAccessView;
+
+/**
+ * Records the commands of a single command list. Objects are referenced by id.
+ * The definition of an object is written to the stream of the command list
+ * the first time the command list references the object.
+ */
+class CommandListRecorder
+{
+public:
+    CommandListRecorder( CommandRecorder& recorder, uint64_t generation );
+
+    CommandStreamWriter& GetWriter()
+    {
+        return m_Writer;
+    }
+
+    const CommandStreamWriter& GetWriter() const
+    {
+        return m_Writer;
+    }
+
+    /**
+     * The capture that the command list recorder belongs to.
+     */
+    uint64_t GetGeneration() const
+    {
+        return m_Generation;
+    }
+
+    /**
+     * Get the id of an object (0 for null objects). The object is defined in
+     * the stream if it was not referenced before.
+     *
+     * @param resource The resource to get the id for.
+     * @param [wrapper] The wrapper of the resource (if any). Used to record
+     * the name and the optimized clear value of the resource.
+     */
+    uint32_t GetResourceId( ID3D12Resource* resource, const Resource* wrapper = nullptr );
+    uint32_t GetResourceId( const Resource* resource );
+    uint32_t GetRootSignatureId( const RootSignature* rootSignature );
+    /**
+     * Get the id of a root signature that was created by the device (0 if the
+     * root signature is unknown).
+     */
+    uint32_t GetRootSignatureId( ID3D12RootSignature* rootSignature );
+    uint32_t GetPipelineStateId( const PipelineStateObject* pipelineState );
+    uint32_t GetCommandSignatureId( const CommandSignature* commandSignature );
+    uint32_t GetViewId( const ShaderResourceView* srv );
+    uint32_t GetViewId( const UnorderedAccessView* uav );
+    uint32_t GetViewId( const ConstantBufferView* cbv );
+
+private:
+    // Returns true and sets id if the object was already defined in the stream.
+    // Otherwise a new id is assigned that must be defined by the caller.
+    bool FindObject( const void* object, uint64_t hash, uint32_t& id );
+
+    CommandRecorder&    m_Recorder;
+    uint64_t            m_Generation;
+    CommandStreamWriter m_Writer;
+
+    // Ids of the objects that are defined in the stream of the command list.
+    std::unordered_map<const void*, uint32_t> m_ObjectIds;
+};
+
+class CommandRecorder
+{
+public:
+    /**
+     * Start capturing commands. The capture starts at the next frame boundary
+     * (see EndFrame).
+     *
+     * @param fileName The file that the capture is written to.
+     * @param numFrames The number of frames to capture. The capture is written
+     * to the file when the last frame ends.
+     */
+    void BeginCapture( const std::wstring& fileName, uint32_t numFrames = 1 );
+
+    /**
+     * Stop capturing commands. The frames that have been captured so far are
+     * written to the file. Captures that are still in progress when the
+     * device is destroyed are discarded.
+     */
+    void EndCapture();
+
+    /**
+     * Check to see if a capture is in progress (or will start at the next
+     * frame boundary).
+     */
+    bool IsCapturing() const;
+
+    /**
+     * Mark the end of a frame. This is called by SwapChain::Present but it
+     * can also be called by applications that do not present.
+     */
+    void EndFrame();
+
+protected:
+    friend class CommandListRecorder;
+    friend class CommandQueue;
+    friend class Device;
+    friend class std::default_delete<CommandRecorder>;
+
+    CommandRecorder();
+    virtual ~CommandRecorder();
+
+    /**
+     * Create a recorder for a command list. Returns nullptr if no frame is
+     * being captured.
+     */
+    std::unique_ptr<CommandListRecorder> CreateCommandListRecorder();
+
+    /**
+     * Append the commands of a command list that is executed on a command
+     * queue to the capture.
+     */
+    void Submit( D3D12_COMMAND_LIST_TYPE type, const CommandListRecorder& commandListRecorder );
+
+    /**
+     * Get the id of an object in the capture. Objects are identified by their
+     * address and a hash of their description (the address of an object can
+     * be reused after the object is destroyed).
+     */
+    uint32_t GetObjectId( const void* object, uint64_t hash );
+
+    /**
+     * Root signatures are referenced by pipeline state streams as
+     * ID3D12RootSignature pointers. The device registers the root signatures
+     * it creates so their descriptions can be recorded.
+     */
+    void                           RegisterRootSignature( const std::shared_ptr<RootSignature>& rootSignature );
+    std::shared_ptr<RootSignature> FindRootSignature( ID3D12RootSignature* rootSignature );
+
+private:
+    enum class State
+    {
+        Idle,
+        Pending,  // Waiting for the next frame boundary.
+        Capturing,
+    };
+
+    // Write the capture to the file. m_Mutex must be locked.
+    void WriteCapture();
+
+    struct ObjectKey
+    {
+        const void* Object;
+        uint64_t    Hash;
+
+        bool operator==( const ObjectKey& other ) const
+        {
+            return Object == other.Object && Hash == other.Hash;
+        }
+    };
+
+    struct ObjectKeyHash
+    {
+        size_t operator()( const ObjectKey& key ) const
+        {
+            return std::hash<const void*>()( key.Object ) ^ static_cast<size_t>( key.Hash );
+        }
+    };
+
+    mutable std::mutex m_Mutex;
+    State              m_State;
+    // Checked by the command queues without locking the mutex.
+    std::atomic_bool m_bCapturing;
+    // Incremented for every capture. Command lists that were recorded for a
+    // previous capture are not added to the current capture.
+    uint64_t m_Generation;
+
+    std::wstring        m_FileName;
+    uint32_t            m_NumFrames;
+    uint32_t            m_NumCapturedFrames;
+    CommandStreamWriter m_Writer;
+
+    std::unordered_map<ObjectKey, uint32_t, ObjectKeyHash> m_ObjectIds;
+    uint32_t                                               m_NextObjectId;
+
+    std::mutex                                                             m_RootSignaturesMutex;
+    std::unordered_map<ID3D12RootSignature*, std::weak_ptr<RootSignature>> m_RootSignatures;
+};
+}  // namespace dx12lib
@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ *  @file CommandSignature.h
+ *
+ *  @brief Wraps an ID3D12CommandSignature that describes the layout of the
+ *  argument buffer that is used by CommandList::ExecuteIndirect.
+ *
+ *  If the command signature changes root arguments (root constants or root
+ *  descriptors), it must be created for the root signature that is bound when
+ *  the commands are executed.
+ */
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <memory>
+#include <vector>
+
+namespace dx12lib
+{
+
+class Device;
+class RootSignature;
+
+class CommandSignature
+{
+public:
+    Microsoft::WRL::ComPtr<ID3D12CommandSignature> GetD3D12CommandSignature() const
+    {
+        return m_d3d12CommandSignature;
+    }
+
+    /**
+     * The root signature that the command signature was created for (or null
+     * if the command signature does not change any root arguments).
+     */
+    std::shared_ptr<RootSignature> GetRootSignature() const
+    {
+        return m_RootSignature;
+    }
+
+    /**
+     * The size (in bytes) of each command in the argument buffer.
+     */
+    uint32_t GetByteStride() const
+    {
+        return m_ByteStride;
+    }
+
+    /**
+     * Check to see if the commands dispatch a compute shader (instead of drawing geometry).
+     */
+    bool IsDispatch() const
+    {
+        return m_IsDispatch;
+    }
+
+    /**
+     * The arguments of each command in the argument buffer.
+     */
+    const std::vector<D3D12_INDIRECT_ARGUMENT_DESC>& GetArgumentDescs() const
+    {
+        return m_ArgumentDescs;
+    }
+
+    /**
+     * The node mask that the command signature was created with.
+     */
+    uint32_t GetNodeMask() const
+    {
+        return m_NodeMask;
+    }
+
+protected:
+    friend class std::default_delete<CommandSignature>;
+
+    CommandSignature( Device& device, const D3D12_COMMAND_SIGNATURE_DESC& commandSignatureDesc,
+                      std::shared_ptr<RootSignature> rootSignature );
+    virtual ~CommandSignature();
+
+private:
+    Device&                                        m_Device;
+    Microsoft::WRL::ComPtr<ID3D12CommandSignature> m_d3d12CommandSignature;
+    std::shared_ptr<RootSignature>                 m_RootSignature;
+    uint32_t                                       m_ByteStride;
+    bool                                           m_IsDispatch;
+    std::vector<D3D12_INDIRECT_ARGUMENT_DESC>      m_ArgumentDescs;
+    uint32_t                                       m_NodeMask;
+};
+}  // namespace dx12lib
@@ -0,0 +1,591 @@
+#pragma once
+
+/**
+ *  @file CommandStream.h
+ *
+ *  @brief The binary format of captured command streams.
+ *
+ *  A capture file starts with a CommandStreamHeader followed by a sequence of
+ *  commands. Every command starts with a CommandHeader that contains the
+ *  command op and the size of the payload so that readers can skip commands
+ *  they are not interested in.
+ *
+ *  The top-level commands of a capture file are ExecuteCommandList (the
+ *  payload is the queue type followed by the commands of the command list) and
+ *  EndFrame. Objects (resources, views, root signatures, pipeline state
+ *  objects, and command signatures) are referenced by id. The definition of an
+ *  object is written to the stream of a command list the first time the command
+ *  list references the object, so an object can be defined more than once in a
+ *  capture (the definitions are identical).
+ *
+ *  The contents of uploads are not stored in the stream, only the size and a
+ *  hash of the data. The replay uploads the same number of bytes.
+ */
+
+#include <d3d12.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace dx12lib
+{
+
+enum class CommandOp : uint16_t
+{
+    // Top-level commands.
+    ExecuteCommandList,
+    EndFrame,
+
+    // Object definitions.
+    DefineResource,
+    DefineRootSignature,
+    DefinePipelineState,
+    DefineCommandSignature,
+    DefineShaderResourceView,
+    DefineUnorderedAccessView,
+    DefineConstantBufferView,
+
+    // Barriers.
+    TransitionBarrier,
+    UAVBarrier,
+    AliasingBarrier,
+    FlushResourceBarriers,
+
+    // Copies and uploads.
+    CopyResource,
+    ResolveSubresource,
+    CopyBufferRegion,
+    CopyTextureSubresource,
+    CopyTextureRegion,
+    GenerateMips,
+    PanoToCubemap,
+    ClearTexture,
+    ClearDepthStencilTexture,
+
+    // Pipeline state and bindings.
+    SetPrimitiveTopology,
+    SetViewports,
+    SetScissorRects,
+    SetPipelineState,
+    SetGraphicsRootSignature,
+    SetComputeRootSignature,
+    SetGraphics32BitConstants,
+    SetCompute32BitConstants,
+    SetGraphicsDynamicConstantBuffer,
+    SetGraphicsDynamicStructuredBuffer,
+    SetVertexBuffers,
+    SetDynamicVertexBuffer,
+    SetIndexBuffer,
+    SetDynamicIndexBuffer,
+    SetInlineConstantBufferView,
+    SetInlineShaderResourceView,
+    SetInlineUnorderedAccessView,
+    SetConstantBufferView,
+    SetShaderResourceView,
+    SetTextureShaderResourceView,
+    SetUnorderedAccessView,
+    SetTextureUnorderedAccessView,
+    SetBindlessDescriptorTable,
+    SetRenderTarget,
+
+    // Draws and dispatches.
+    Draw,
+    DrawIndexed,
+    Dispatch,
+    ExecuteIndirect,
+
+    NumCommandOps
+};
+
+/**
+ * The header of a capture file.
+ */
+struct CommandStreamHeader
+{
+    static const uint32_t MagicValue   = 0x53435844;  // "DXCS"
+    static const uint32_t VersionValue = 1;
+
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t NumFrames;
+    uint32_t Reserved;
+};
+
+struct CommandHeader
+{
+    CommandOp Op;
+    uint16_t  Reserved;
+    uint32_t  Size;  // The size of the payload (in bytes).
+};
+
+/**
+ * Writes commands to a binary stream.
+ */
+class CommandStreamWriter
+{
+public:
+    /**
+     * Start a command. The size of the command is written in EndCommand.
+     */
+    void BeginCommand( CommandOp op )
+    {
+        m_CommandOffset = m_Data.size();
+        Write( CommandHeader { op, 0, 0 } );
+    }
+
+    void EndCommand()
+    {
+        uint32_t size = static_cast<uint32_t>( m_Data.size() - m_CommandOffset - sizeof( CommandHeader ) );
+        std::memcpy( m_Data.data() + m_CommandOffset + offsetof( CommandHeader, Size ), &size, sizeof( size ) );
+    }
+
+    /**
+     * Write a command with a fixed size payload.
+     */
+    template<typename T>
+    void WriteCommand( CommandOp op, const T& payload )
+    {
+        BeginCommand( op );
+        Write( payload );
+        EndCommand();
+    }
+
+    template<typename T>
+    void Write( const T& value )
+    {
+        static_assert( std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written." );
+        WriteBytes( &value, sizeof( T ) );
+    }
+
+    void WriteBytes( const void* data, size_t size )
+    {
+        auto bytes = static_cast<const uint8_t*>( data );
+        m_Data.insert( m_Data.end(), bytes, bytes + size );
+    }
+
+    // Strings are written as the length followed by the characters.
+    void WriteString( const std::string& str )
+    {
+        Write( static_cast<uint32_t>( str.size() ) );
+        WriteBytes( str.data(), str.size() );
+    }
+
+    const std::vector<uint8_t>& GetData() const
+    {
+        return m_Data;
+    }
+
+    size_t GetSize() const
+    {
+        return m_Data.size();
+    }
+
+    void Clear()
+    {
+        m_Data.clear();
+    }
+
+private:
+    std::vector<uint8_t> m_Data;
+    size_t               m_CommandOffset = 0;
+};
+
+/**
+ * Reads commands from a binary stream. Throws an exception if the stream is
+ * truncated.
+ */
+class CommandStreamReader
+{
+public:
+    CommandStreamReader()
+    : m_Data( nullptr )
+    , m_Size( 0 )
+    , m_Offset( 0 )
+    {}
+
+    CommandStreamReader( const void* data, size_t size )
+    : m_Data( static_cast<const uint8_t*>( data ) )
+    , m_Size( size )
+    , m_Offset( 0 )
+    {}
+
+    bool IsEnd() const
+    {
+        return m_Offset >= m_Size;
+    }
+
+    // The number of bytes that have not been read yet.
+    size_t GetRemainingSize() const
+    {
+        return m_Size - m_Offset;
+    }
+
+    /**
+     * Read the next command. The returned reader is used to read the payload
+     * of the command.
+     */
+    CommandStreamReader ReadCommand( CommandOp& op )
+    {
+        auto header = Read<CommandHeader>();
+        if ( header.Op >= CommandOp::NumCommandOps )
+        {
+            throw std::exception( "Invalid command in command stream." );
+        }
+
+        op = header.Op;
+        return CommandStreamReader( ReadBytes( header.Size ), header.Size );
+    }
+
+    template<typename T>
+    T Read()
+    {
+        static_assert( std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read." );
+
+        T value;
+        std::memcpy( &value, ReadBytes( sizeof( T ) ), sizeof( T ) );
+        return value;
+    }
+
+    const void* ReadBytes( size_t size )
+    {
+        if ( size > m_Size - m_Offset )
+        {
+            throw std::exception( "Unexpected end of command stream." );
+        }
+
+        const void* data = m_Data + m_Offset;
+        m_Offset += size;
+
+        return data;
+    }
+
+    std::string ReadString()
+    {
+        uint32_t length = Read<uint32_t>();
+        auto     chars  = static_cast<const char*>( ReadBytes( length ) );
+
+        return std::string( chars, length );
+    }
+
+private:
+    const uint8_t* m_Data;
+    size_t         m_Size;
+    size_t         m_Offset;
+};
+
+/**
+ * Command payloads.
+ * Variable length payloads are followed by the data that is described in the
+ * comment of the payload.
+ */
+namespace commands
+{
+
+// Followed by the name of the resource.
+struct DefineResource
+{
+    uint32_t            Id;
+    D3D12_HEAP_TYPE     HeapType;
+    D3D12_RESOURCE_DESC Desc;
+    uint32_t            HasClearValue;
+    D3D12_CLEAR_VALUE   ClearValue;
+};
+
+// Followed by NumParameters D3D12_ROOT_PARAMETER1 (each descriptor table is
+// followed by its ranges) and NumStaticSamplers D3D12_STATIC_SAMPLER_DESC.
+struct DefineRootSignature
+{
+    uint32_t                   Id;
+    uint32_t                   NumParameters;
+    uint32_t                   NumStaticSamplers;
+    D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+// Followed by the serialized PipelineStateDesc (if IsSerialized is not 0).
+struct DefinePipelineState
+{
+    uint32_t Id;
+    uint32_t IsSerialized;
+};
+
+// Followed by NumArgumentDescs D3D12_INDIRECT_ARGUMENT_DESC.
+struct DefineCommandSignature
+{
+    uint32_t Id;
+    uint32_t RootSignatureId;
+    uint32_t ByteStride;
+    uint32_t NumArgumentDescs;
+    uint32_t NodeMask;
+};
+
+struct DefineShaderResourceView
+{
+    uint32_t                        Id;
+    uint32_t                        ResourceId;
+    uint32_t                        HasDesc;
+    D3D12_SHADER_RESOURCE_VIEW_DESC Desc;
+};
+
+struct DefineUnorderedAccessView
+{
+    uint32_t                         Id;
+    uint32_t                         ResourceId;
+    uint32_t                         CounterResourceId;
+    uint32_t                         HasDesc;
+    D3D12_UNORDERED_ACCESS_VIEW_DESC Desc;
+};
+
+struct DefineConstantBufferView
+{
+    uint32_t Id;
+    uint32_t ResourceId;
+    uint64_t Offset;
+};
+
+struct TransitionBarrier
+{
+    uint32_t              ResourceId;
+    D3D12_RESOURCE_STATES StateAfter;
+    uint32_t              Subresource;
+    uint32_t              FlushBarriers;
+};
+
+struct UAVBarrier
+{
+    uint32_t ResourceId;
+    uint32_t FlushBarriers;
+};
+
+struct AliasingBarrier
+{
+    uint32_t BeforeResourceId;
+    uint32_t AfterResourceId;
+    uint32_t FlushBarriers;
+};
+
+struct CopyResource
+{
+    uint32_t DstResourceId;
+    uint32_t SrcResourceId;
+};
+
+struct ResolveSubresource
+{
+    uint32_t DstResourceId;
+    uint32_t SrcResourceId;
+    uint32_t DstSubresource;
+    uint32_t SrcSubresource;
+};
+
+struct CopyBufferRegion
+{
+    uint32_t ResourceId;
+    uint64_t DstOffset;
+    uint64_t NumBytes;
+    uint64_t DataHash;
+};
+
+struct SubresourceData
+{
+    int64_t  RowPitch;
+    int64_t  SlicePitch;
+    uint64_t NumBytes;
+    uint64_t DataHash;
+};
+
+// Followed by NumSubresources SubresourceData.
+struct CopyTextureSubresource
+{
+    uint32_t ResourceId;
+    uint32_t FirstSubresource;
+    uint32_t NumSubresources;
+};
+
+struct CopyTextureRegion
+{
+    uint32_t        ResourceId;
+    uint32_t        Subresource;
+    uint32_t        DstX, DstY, DstZ;
+    uint32_t        Width, Height, Depth;
+    SubresourceData Data;
+};
+
+struct GenerateMips
+{
+    uint32_t ResourceId;
+};
+
+struct PanoToCubemap
+{
+    uint32_t CubemapResourceId;
+    uint32_t PanoResourceId;
+};
+
+struct ClearTexture
+{
+    uint32_t ResourceId;
+    float    ClearColor[4];
+};
+
+struct ClearDepthStencilTexture
+{
+    uint32_t          ResourceId;
+    D3D12_CLEAR_FLAGS ClearFlags;
+    float             Depth;
+    uint32_t          Stencil;
+};
+
+struct SetPrimitiveTopology
+{
+    D3D_PRIMITIVE_TOPOLOGY PrimitiveTopology;
+};
+
+// Followed by NumViewports D3D12_VIEWPORT.
+struct SetViewports
+{
+    uint32_t NumViewports;
+};
+
+// Followed by NumScissorRects D3D12_RECT.
+struct SetScissorRects
+{
+    uint32_t NumScissorRects;
+};
+
+struct SetPipelineState
+{
+    uint32_t PipelineStateId;
+};
+
+struct SetRootSignature
+{
+    uint32_t RootSignatureId;
+};
+
+// Followed by NumConstants 32-bit constants.
+struct Set32BitConstants
+{
+    uint32_t RootParameterIndex;
+    uint32_t NumConstants;
+};
+
+struct SetDynamicBuffer
+{
+    uint32_t RootParameterIndex;
+    uint32_t Reserved;
+    uint64_t NumElements;
+    uint64_t ElementSize;
+    uint64_t DataHash;
+};
+
+struct VertexBufferBinding
+{
+    uint32_t ResourceId;
+    uint32_t Reserved;
+    uint64_t NumVertices;
+    uint64_t VertexStride;
+};
+
+// Followed by NumVertexBuffers VertexBufferBinding.
+struct SetVertexBuffers
+{
+    uint32_t StartSlot;
+    uint32_t NumVertexBuffers;
+};
+
+struct SetDynamicVertexBuffer
+{
+    uint32_t Slot;
+    uint32_t Reserved;
+    uint64_t NumVertices;
+    uint64_t VertexSize;
+    uint64_t DataHash;
+};
+
+struct SetIndexBuffer
+{
+    uint32_t    ResourceId;
+    DXGI_FORMAT IndexFormat;
+    uint64_t    NumIndices;
+};
+
+struct SetDynamicIndexBuffer
+{
+    DXGI_FORMAT IndexFormat;
+    uint32_t    Reserved;
+    uint64_t    NumIndices;
+    uint64_t    DataHash;
+};
+
+struct SetInlineView
+{
+    uint32_t              RootParameterIndex;
+    uint32_t              ResourceId;
+    D3D12_RESOURCE_STATES StateAfter;
+    uint32_t              Reserved;
+    uint64_t              BufferOffset;
+};
+
+struct SetDescriptor
+{
+    uint32_t              RootParameterIndex;
+    uint32_t              DescriptorOffset;
+    uint32_t              ViewId;  // The resource id for the texture variants.
+    D3D12_RESOURCE_STATES StateAfter;
+    uint32_t              FirstSubresource;
+    uint32_t              NumSubresources;
+    uint32_t              Mip;
+};
+
+struct SetBindlessDescriptorTable
+{
+    uint32_t RootParameterIndex;
+};
+
+// The color attachments followed by the depth-stencil attachment.
+struct SetRenderTarget
+{
+    uint32_t ResourceIds[9];
+};
+
+struct Draw
+{
+    uint32_t VertexCount;
+    uint32_t InstanceCount;
+    uint32_t StartVertex;
+    uint32_t StartInstance;
+};
+
+struct DrawIndexed
+{
+    uint32_t IndexCount;
+    uint32_t InstanceCount;
+    uint32_t StartIndex;
+    int32_t  BaseVertex;
+    uint32_t StartInstance;
+};
+
+struct Dispatch
+{
+    uint32_t NumGroupsX;
+    uint32_t NumGroupsY;
+    uint32_t NumGroupsZ;
+};
+
+struct ExecuteIndirect
+{
+    uint32_t CommandSignatureId;
+    uint32_t MaxCommandCount;
+    uint32_t ArgumentBufferId;
+    uint32_t CountBufferId;
+    uint64_t ArgumentBufferOffset;
+    uint64_t CountBufferOffset;
+};
+
+}  // namespace commands
+}  // namespace dx12lib
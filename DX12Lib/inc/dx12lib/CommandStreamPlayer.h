@@ -0,0 +1,168 @@
+#pragma once
+
+/**
+ *  @file CommandStreamPlayer.h
+ *
+ *  @brief Replays a capture that was recorded with the CommandRecorder.
+ *
+ *  All of the objects that are defined in the capture are created when the
+ *  capture is loaded so that replaying a frame only measures the cost of
+ *  recording and executing the command lists. Uploads are replayed with zeros
+ *  (only the size of the data is stored in the capture) so the output of the
+ *  replay is not expected to match the captured frames.
+ */
+
+#include "CommandStream.h"
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dx12lib
+{
+
+class Buffer;
+class ByteAddressBuffer;
+class CommandList;
+class CommandSignature;
+class ConstantBuffer;
+class ConstantBufferView;
+class Device;
+class IndexBuffer;
+class PipelineStateObject;
+class Resource;
+class RootSignature;
+class ShaderResourceView;
+class Texture;
+class UnorderedAccessView;
+class VertexBuffer;
+
+class CommandStreamPlayer
+{
+public:
+    struct FrameStatistics
+    {
+        // The time (in seconds) to record and submit the command lists of the frame.
+        double CpuTime;
+        // The time (in seconds) that was spent waiting for previous frames to finish.
+        double WaitTime;
+
+        uint32_t NumCommandLists;
+        uint32_t NumCommands;
+        uint32_t NumDraws;
+        uint32_t NumDispatches;
+        // Commands that reference objects that could not be created.
+        uint32_t NumSkippedCommands;
+        uint64_t NumUploadBytes;
+    };
+
+    explicit CommandStreamPlayer( Device& device );
+    ~CommandStreamPlayer();
+
+    /**
+     * Load a capture and create the objects that are referenced by the
+     * capture. Throws an exception if the file is not a valid capture.
+     */
+    void Load( const std::wstring& fileName );
+
+    uint32_t GetNumFrames() const
+    {
+        return static_cast<uint32_t>( m_Frames.size() );
+    }
+
+    /**
+     * Replay a single frame of the capture. Up to MaxFramesInFlight frames are
+     * queued before the CPU waits for the GPU.
+     */
+    FrameStatistics ReplayFrame( uint32_t frame );
+
+    /**
+     * Wait for all replayed frames to finish.
+     */
+    void Flush();
+
+    static const uint32_t MaxFramesInFlight = 3;
+
+private:
+    struct ResourceObject
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> D3D12Resource;
+        std::shared_ptr<Texture>               WrappedTexture;
+
+        // Buffers are wrapped on demand since the capture does not store how a
+        // buffer is used.
+        std::shared_ptr<ByteAddressBuffer>                                        WrappedBuffer;
+        std::shared_ptr<ConstantBuffer>                                           WrappedConstantBuffer;
+        std::map<std::pair<uint64_t, uint64_t>, std::shared_ptr<VertexBuffer>>    VertexBuffers;
+        std::map<std::pair<uint64_t, DXGI_FORMAT>, std::shared_ptr<IndexBuffer>> IndexBuffers;
+    };
+
+    struct CommandListStream
+    {
+        D3D12_COMMAND_LIST_TYPE Type;
+        const void*             Data;
+        size_t                  Size;
+    };
+
+    // Create the objects that are defined in the stream of a command list.
+    void DefineObjects( CommandStreamReader reader );
+    void DefineResource( CommandStreamReader& reader );
+    void DefineRootSignature( CommandStreamReader& reader );
+    void DefinePipelineState( CommandStreamReader& reader );
+    void DefineCommandSignature( CommandStreamReader& reader );
+
+    // Replay the commands of a command list.
+    void ReplayCommandList( CommandList& commandList, CommandStreamReader reader, FrameStatistics& statistics );
+
+    // Get (at least) numBytes of zeros to upload.
+    const void* GetUploadData( uint64_t numBytes, FrameStatistics& statistics );
+
+    std::shared_ptr<Resource>          GetResource( uint32_t id );
+    std::shared_ptr<Texture>           GetTexture( uint32_t id );
+    std::shared_ptr<ByteAddressBuffer> GetBuffer( uint32_t id );
+    std::shared_ptr<ConstantBuffer>    GetConstantBuffer( uint32_t id );
+    std::shared_ptr<VertexBuffer>      GetVertexBuffer( uint32_t id, uint64_t numVertices, uint64_t vertexStride );
+    std::shared_ptr<IndexBuffer>       GetIndexBuffer( uint32_t id, uint64_t numIndices, DXGI_FORMAT indexFormat );
+
+    template<typename T>
+    static std::shared_ptr<T> Find( const std::unordered_map<uint32_t, std::shared_ptr<T>>& objects, uint32_t id )
+    {
+        auto iter = objects.find( id );
+        return iter != objects.end() ? iter->second : nullptr;
+    }
+
+    Device& m_Device;
+
+    // The contents of the capture file.
+    std::vector<uint8_t> m_Data;
+    // The command lists of each frame.
+    std::vector<std::vector<CommandListStream>> m_Frames;
+
+    std::unordered_map<uint32_t, ResourceObject>                       m_Resources;
+    std::unordered_map<uint32_t, std::shared_ptr<RootSignature>>       m_RootSignatures;
+    std::unordered_map<uint32_t, std::shared_ptr<PipelineStateObject>> m_PipelineStates;
+    std::unordered_map<uint32_t, std::shared_ptr<CommandSignature>>    m_CommandSignatures;
+    std::unordered_map<uint32_t, std::shared_ptr<ShaderResourceView>>  m_ShaderResourceViews;
+    std::unordered_map<uint32_t, std::shared_ptr<UnorderedAccessView>> m_UnorderedAccessViews;
+    std::unordered_map<uint32_t, std::shared_ptr<ConstantBufferView>>  m_ConstantBufferViews;
+
+    // Zeros that are uploaded in place of the captured data.
+    std::vector<uint8_t> m_UploadData;
+
+    // The fence values of the frames that are in flight (for the direct,
+    // compute, and copy queues).
+    struct FrameFence
+    {
+        uint64_t FenceValues[3];
+    };
+    std::deque<FrameFence> m_FrameFences;
+};
+}  // namespace dx12lib
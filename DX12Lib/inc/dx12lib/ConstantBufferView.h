@@ -54,6 +54,14 @@ public:
         return m_Descriptor.GetDescriptorHandle();
     }
 
+    /**
+     * The offset (in bytes) of the view in the constant buffer.
+     */
+    size_t GetOffset() const
+    {
+        return m_Offset;
+    }
+
 protected:
     ConstantBufferView( Device& device, const std::shared_ptr<ConstantBuffer>& constantBuffer,
                         size_t offset = 0 );
@@ -63,6 +71,7 @@ private:
     Device&                         m_Device;
     std::shared_ptr<ConstantBuffer> m_ConstantBuffer;
     DescriptorAllocation            m_Descriptor;
+    size_t                          m_Offset;
 };
 
 }  // namespace dx12lib
@@ -44,25 +44,35 @@ namespace dx12lib
 {
 
 class Adapter;
+class BindlessDescriptorTable;
 class ByteAddressBuffer;
 class CommandQueue;
 class CommandList;
+class CommandRecorder;
+class CommandSignature;
 class ConstantBuffer;
 class ConstantBufferView;
 class DescriptorAllocator;
 class GUI;
 class IndexBuffer;
+class MaterialTable;
+class NullDeviceCounters;
+class PipelineStateCache;
 class PipelineStateObject;
 class RenderTarget;
 class Resource;
 class RootSignature;
 class Scene;
 class ShaderResourceView;
+class StagingAllocator;
+class StreamingUploadQueue;
 class StructuredBuffer;
 class SwapChain;
 class Texture;
+class TextureCooker;
 class UnorderedAccessView;
 class VertexBuffer;
+class VirtualTextureStreamer;
 
 class Device
 {
@@ -81,6 +91,14 @@ public:
      */
     static std::shared_ptr<Device> Create( std::shared_ptr<Adapter> adapter = nullptr );
 
+    /**
+     * Create a device that uses the null D3D12 device (see NullDevice.h).
+     * Nothing is executed on the GPU, which makes it possible to measure the
+     * CPU cost of the library without a driver. Swap chains are not supported
+     * on the null device.
+     */
+    static std::shared_ptr<Device> CreateNull();
+
     /**
      * Get a description of the adapter that was used to create the device.
      */
@@ -110,11 +128,36 @@ public:
      */
     std::shared_ptr<GUI> CreateGUI( HWND hWnd, const RenderTarget& renderTarget );
 
+    /**
+     * Create a streaming upload queue that uploads resources in the background
+     * using the copy queue.
+     *
+     * @param frameBudget The maximum number of bytes to upload each frame.
+     */
+    std::shared_ptr<StreamingUploadQueue> CreateStreamingUploadQueue( uint64_t frameBudget = 8 * 1024 * 1024 );
+
+    /**
+     * Create a virtual texture streamer that streams the tiles of reserved
+     * textures into a fixed size tile pool.
+     *
+     * @param tilePoolSize The size of the tile pool in bytes (the memory budget for tiles).
+     * @param maxTilesPerUpdate The maximum number of tiles that are mapped and uploaded each frame.
+     */
+    std::shared_ptr<VirtualTextureStreamer> CreateVirtualTextureStreamer( uint64_t tilePoolSize = 256 * 1024 * 1024,
+                                                                          uint32_t maxTilesPerUpdate = 64 );
+
     /**
      * Create a ConstantBuffer from a given ID3D12Resoure.
      */
     std::shared_ptr<ConstantBuffer> CreateConstantBuffer( Microsoft::WRL::ComPtr<ID3D12Resource> resource );
 
+    /**
+     * Create a material table that stores the properties of materials in a
+     * structured buffer and references their textures in the bindless
+     * descriptor table.
+     */
+    std::shared_ptr<MaterialTable> CreateMaterialTable();
+
     /**
      * Create a ByteAddressBuffer resource.
      *
@@ -154,6 +197,33 @@ public:
 
     std::shared_ptr<RootSignature> CreateRootSignature( const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc );
 
+    /**
+     * Create a command signature for CommandList::ExecuteIndirect.
+     *
+     * @param commandSignatureDesc The layout of the commands in the argument buffer.
+     * @param [rootSignature] The root signature that is used with the command
+     * signature. Required if the command signature changes root arguments.
+     */
+    std::shared_ptr<CommandSignature>
+        CreateCommandSignature( const D3D12_COMMAND_SIGNATURE_DESC& commandSignatureDesc,
+                                std::shared_ptr<RootSignature>      rootSignature = nullptr );
+
+    /**
+     * Create a cache for root signatures and pipeline state objects.
+     *
+     * @param libraryFileName The file that is used to persist the pipeline
+     * library between runs. If empty, pipeline state objects are not persisted.
+     * @param numThreads The number of worker threads used to create pipeline
+     * state objects asynchronously (0 to use half of the hardware threads).
+     */
+    std::shared_ptr<PipelineStateCache> CreatePipelineStateCache( const std::wstring& libraryFileName = L"",
+                                                                  uint32_t            numThreads      = 0 );
+
+    /**
+     * Create a pipeline state object. If an identical pipeline state stream
+     * was used before, the same pipeline state object is returned (see
+     * SetPipelineStateCache).
+     */
     template<class PipelineStateStream>
     std::shared_ptr<PipelineStateObject> CreatePipelineStateObject( PipelineStateStream& pipelineStateStream )
     {
@@ -186,7 +256,8 @@ public:
     void ReleaseStaleDescriptors();
 
     /**
-     * Get the adapter that was used to create this device.
+     * Get the adapter that was used to create this device (nullptr for the
+     * null device).
      */
     std::shared_ptr<Adapter> GetAdapter() const
     {
@@ -202,6 +273,93 @@ public:
      */
     CommandQueue& GetCommandQueue( D3D12_COMMAND_LIST_TYPE type = D3D12_COMMAND_LIST_TYPE_DIRECT );
 
+    /**
+     * Get the staging allocator that is used by command lists to upload
+     * buffer and texture data to the GPU.
+     */
+    StagingAllocator& GetStagingAllocator() const
+    {
+        return *m_StagingAllocator;
+    }
+
+    /**
+     * Get the bindless descriptor table. Shaders can index the resources that
+     * are registered in the bindless descriptor table directly using an
+     * unbounded descriptor table (see CommandList::SetBindlessDescriptorTable).
+     */
+    BindlessDescriptorTable& GetBindlessDescriptorTable() const
+    {
+        return *m_BindlessDescriptorTable;
+    }
+
+    /**
+     * Get the command recorder that is used to capture the commands that are
+     * executed on the command queues of the device (see CommandStreamPlayer
+     * to replay a capture).
+     */
+    CommandRecorder& GetCommandRecorder() const
+    {
+        return *m_CommandRecorder;
+    }
+
+    /**
+     * Get the API call counters of the null device (nullptr if the device was
+     * not created with CreateNull).
+     */
+    std::shared_ptr<NullDeviceCounters> GetNullDeviceCounters() const
+    {
+        return m_NullDeviceCounters;
+    }
+
+    /**
+     * Set the texture cooker that CommandList::LoadTextureFromFile uses to
+     * load block compressed versions of textures (see TextureCooker.h).
+     * Textures are loaded uncompressed if no cooker is set.
+     */
+    void SetTextureCooker( std::shared_ptr<TextureCooker> textureCooker )
+    {
+        m_TextureCooker = textureCooker;
+    }
+
+    std::shared_ptr<TextureCooker> GetTextureCooker() const
+    {
+        return m_TextureCooker;
+    }
+
+    /**
+     * Set the streaming upload queue that CommandList::LoadSceneFromFile loads
+     * the textures of a scene with (see StreamingUploadQueue.h). The scene is
+     * returned when its textures are uploaded, which takes several frames since
+     * only a frame's budget is uploaded each frame. Load the scene on a
+     * different thread than the one that calls StreamingUploadQueue::BeginFrame.
+     * Textures are loaded immediately if no streaming upload queue is set.
+     */
+    void SetStreamingUploadQueue( std::shared_ptr<StreamingUploadQueue> streamingUploadQueue )
+    {
+        m_StreamingUploadQueue = streamingUploadQueue;
+    }
+
+    std::shared_ptr<StreamingUploadQueue> GetStreamingUploadQueue() const
+    {
+        return m_StreamingUploadQueue;
+    }
+
+    /**
+     * Set the cache that CreatePipelineStateObject creates pipeline state
+     * objects with. By default, the device uses a cache without a pipeline
+     * library; set a cache that was created with a library file name to
+     * persist the pipeline state objects between runs.
+     */
+    void SetPipelineStateCache( std::shared_ptr<PipelineStateCache> pipelineStateCache )
+    {
+        m_PipelineStateCache = pipelineStateCache;
+    }
+
+    std::shared_ptr<PipelineStateCache> GetPipelineStateCache() const
+    {
+        return m_PipelineStateCache;
+    }
+
     Microsoft::WRL::ComPtr<ID3D12Device2> GetD3D12Device() const
     {
         return m_d3d12Device;
@@ -220,18 +378,38 @@ public:
         D3D12_MULTISAMPLE_QUALITY_LEVEL_FLAGS flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE ) const;
 
 protected:
+    friend class CommandStreamPlayer;
+
     explicit Device( std::shared_ptr<Adapter> adapter );
+    explicit Device( std::shared_ptr<NullDeviceCounters> nullDeviceCounters );
     virtual ~Device();
 
     std::shared_ptr<PipelineStateObject>
         DoCreatePipelineStateObject( const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc );
 
 private:
+    // Create the objects that are owned by the device (after the D3D12 device
+    // has been created).
+    void Initialize();
+
     Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
 
     // The adapter that was used to create the device:
     std::shared_ptr<Adapter> m_Adapter;
 
+    // The API call counters of the null device (if the device was created with CreateNull).
+    std::shared_ptr<NullDeviceCounters> m_NullDeviceCounters;
+
+    // Pool of upload heap chunks used to stage resource uploads.
+    // Declared before the command queues so that it outlives any command list
+    // that still holds staging chunks.
+    std::unique_ptr<StagingAllocator> m_StagingAllocator;
+
+    // Captures the commands that are executed on the command queues.
+    // Declared before the command queues so that it outlives the command
+    // lists that reference it.
+    std::unique_ptr<CommandRecorder> m_CommandRecorder;
+
     // Default command queues.
     std::unique_ptr<CommandQueue> m_DirectCommandQueue;
     std::unique_ptr<CommandQueue> m_ComputeCommandQueue;
@@ -240,6 +418,18 @@ private:
     // Descriptor allocators.
     std::unique_ptr<DescriptorAllocator> m_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
+    // Persistent SRVs that are copied to the start of every GPU visible descriptor heap.
+    // Declared after the descriptor allocators so that the registered resources
+    // are released before the descriptor allocators are destroyed.
+    std::unique_ptr<BindlessDescriptorTable> m_BindlessDescriptorTable;
+
+    std::shared_ptr<TextureCooker>        m_TextureCooker;
+    std::shared_ptr<StreamingUploadQueue> m_StreamingUploadQueue;
+
+    // Pipeline state objects are created through the cache so that identical
+    // pipeline state streams return the same pipeline state object.
+    std::shared_ptr<PipelineStateCache> m_PipelineStateCache;
+
     D3D_ROOT_SIGNATURE_VERSION m_HighestRootSignatureVersion;
 };
 }  // namespace dx12lib
\ No newline at end of file
@@ -41,10 +41,12 @@
 #include <cstdint>
 #include <memory>
 #include <queue>
+#include <unordered_map>
 
 namespace dx12lib
 {
 
+class BindlessDescriptorTable;
 class Device;
 class CommandList;
 class RootSignature;
@@ -79,6 +81,14 @@ public:
      */
     void StageInlineUAV( uint32_t rootParamterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation );
 
+    /**
+     * Stage the bindless descriptor table (see BindlessDescriptorTable) for an
+     * unbounded descriptor table in the root signature. The bindless descriptor
+     * table is stored at the start of every GPU visible descriptor heap so
+     * no descriptors need to be copied when the descriptor table is bound.
+     */
+    void StageBindlessDescriptorTable( uint32_t rootParameterIndex );
+
     void CommitStagedDescriptorsForDraw( CommandList& commandList );
     void CommitStagedDescriptorsForDispatch( CommandList& commandList );
 
@@ -120,6 +130,13 @@ private:
     // Create a new descriptor heap of no descriptor heap is available.
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap();
 
+    // Switch to a new descriptor heap and bind it to the command list.
+    void SetCurrentDescriptorHeap( CommandList& commandList );
+
+    // Copy the bindless descriptor table to the current descriptor heap
+    // if it has changed since it was last copied to the descriptor heap.
+    void UpdateBindlessDescriptors();
+
     // Compute the number of stale descriptors that need to be copied
     // to GPU visible descriptor heap.
     uint32_t ComputeStaleDescriptorCount() const;
@@ -187,6 +204,12 @@ private:
     // The number of descriptors to allocate in new GPU visible descriptor heaps.
     uint32_t m_NumDescriptorsPerHeap;
 
+    // The bindless descriptor table (only for CBV_SRV_UAV descriptor heaps).
+    BindlessDescriptorTable* m_BindlessDescriptorTable;
+    // The number of descriptors at the start of each GPU visible descriptor heap
+    // that are reserved for the bindless descriptor table.
+    uint32_t m_NumReservedDescriptors;
+
     // The increment size of a descriptor.
     uint32_t m_DescriptorHandleIncrementSize;
 
@@ -213,6 +236,13 @@ private:
     uint32_t m_StaleCBVBitMask;
     uint32_t m_StaleSRVBitMask;
     uint32_t m_StaleUAVBitMask;
+    // Each bit in the bit mask represents the index in the root signature
+    // of an unbounded descriptor table.
+    uint32_t m_BindlessTableBitMask;
+    // The unbounded descriptor tables that have been staged and the ones that
+    // need to be (re)bound to the command list.
+    uint32_t m_StagedBindlessTableBitMask;
+    uint32_t m_StaleBindlessTableBitMask;
 
     using DescriptorHeapPool = std::queue<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>>;
 
@@ -224,5 +254,8 @@ private:
     CD3DX12_CPU_DESCRIPTOR_HANDLE                m_CurrentCPUDescriptorHandle;
 
     uint32_t m_NumFreeHandles;
+
+    // The version of the bindless descriptor table that was last copied to each descriptor heap.
+    std::unordered_map<ID3D12DescriptorHeap*, uint64_t> m_BindlessDescriptorVersions;
 };
 }  // namespace dx12lib
\ No newline at end of file
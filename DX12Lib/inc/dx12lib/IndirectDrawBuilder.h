@@ -0,0 +1,174 @@
+#pragma once
+
+/**
+ *  @file IndirectDrawBuilder.h
+ *
+ *  @brief Builds the argument buffer for indexed draws that are submitted with
+ *  CommandList::ExecuteIndirect.
+ *
+ *  Each command sets two root constants (the index of the material in the
+ *  material table and the index of the transform of the draw), the vertex and
+ *  index buffer views, and the arguments of an indexed draw. Draws are added to
+ *  buckets (for example, one bucket per pipeline state object). After the
+ *  commands are built, the commands of each bucket are stored contiguously in the
+ *  order they were added so that each bucket can be submitted with a single call
+ *  to CommandList::ExecuteIndirect.
+ *
+ *  The builder only produces the contents of the argument buffer. It does not
+ *  create any Direct3D objects so it can be verified and profiled without a
+ *  device.
+ */
+
+#include <d3d12.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dx12lib
+{
+
+/**
+ * The root constants that are set for each draw.
+ */
+struct IndirectDrawConstants
+{
+    uint32_t MaterialIndex;
+    // The transform of the first instance. The transforms of the other
+    // instances follow the transform of the first instance.
+    uint32_t TransformIndex;
+};
+
+/**
+ * The layout of a single command in the argument buffer. The arguments are
+ * tightly packed in the same order as the argument descriptions of the command
+ * signature (see IndirectDrawBuilder::GetArgumentDescs).
+ */
+struct IndirectDrawCommand
+{
+    IndirectDrawConstants        DrawConstants;
+    D3D12_VERTEX_BUFFER_VIEW     VertexBufferView;
+    D3D12_INDEX_BUFFER_VIEW      IndexBufferView;
+    D3D12_DRAW_INDEXED_ARGUMENTS DrawIndexedArguments;
+};
+
+static_assert( offsetof( IndirectDrawCommand, VertexBufferView ) == sizeof( IndirectDrawConstants ),
+               "The vertex buffer view must follow the draw constants." );
+static_assert( offsetof( IndirectDrawCommand, IndexBufferView ) ==
+                   offsetof( IndirectDrawCommand, VertexBufferView ) + sizeof( D3D12_VERTEX_BUFFER_VIEW ),
+               "The index buffer view must follow the vertex buffer view." );
+static_assert( offsetof( IndirectDrawCommand, DrawIndexedArguments ) ==
+                   offsetof( IndirectDrawCommand, IndexBufferView ) + sizeof( D3D12_INDEX_BUFFER_VIEW ),
+               "The draw arguments must follow the index buffer view." );
+
+class IndirectDrawBuilder
+{
+public:
+    static const uint32_t NumArgumentDescs = 4;
+
+    using ArgumentDescs = std::array<D3D12_INDIRECT_ARGUMENT_DESC, NumArgumentDescs>;
+
+    /**
+     * Get the argument descriptions of the command signature that matches
+     * the IndirectDrawCommand structure.
+     *
+     * @param drawConstantsRootParameterIndex The root parameter that receives
+     * the draw constants (2 32-bit constants).
+     * @param vertexBufferSlot The input slot of the vertex buffer.
+     */
+    static ArgumentDescs GetArgumentDescs( uint32_t drawConstantsRootParameterIndex, uint32_t vertexBufferSlot = 0 );
+
+    /**
+     * The commands of a bucket in the command list (see GetCommands).
+     */
+    struct Bucket
+    {
+        uint32_t FirstCommand;
+        uint32_t NumCommands;
+    };
+
+    explicit IndirectDrawBuilder( uint32_t numBuckets = 1 );
+
+    /**
+     * Set the number of buckets. This also removes all draws.
+     */
+    void SetNumBuckets( uint32_t numBuckets );
+
+    uint32_t GetNumBuckets() const
+    {
+        return static_cast<uint32_t>( m_Buckets.size() );
+    }
+
+    /**
+     * Remove all draws. The memory that was allocated for the draws is kept.
+     */
+    void Clear();
+
+    /**
+     * Reserve memory for a number of draws.
+     */
+    void Reserve( size_t numDraws );
+
+    /**
+     * Add a draw to a bucket.
+     */
+    void AddDraw( uint32_t bucket, const IndirectDrawCommand& command );
+
+    /**
+     * Add an indexed draw to a bucket.
+     *
+     * @param indexCount The number of indices to draw.
+     * @param instanceCount The number of instances to draw.
+     * @param startIndex The location of the first index in the index buffer.
+     * @param baseVertex The value that is added to each index before reading
+     * a vertex from the vertex buffer.
+     */
+    void AddDraw( uint32_t bucket, uint32_t materialIndex, uint32_t transformIndex,
+                  const D3D12_VERTEX_BUFFER_VIEW& vertexBufferView, const D3D12_INDEX_BUFFER_VIEW& indexBufferView,
+                  uint32_t indexCount, uint32_t instanceCount = 1, uint32_t startIndex = 0,
+                  int32_t baseVertex = 0 );
+
+    /**
+     * The number of draws that were added since the last call to Clear.
+     */
+    uint32_t GetNumDraws() const
+    {
+        return m_NumDraws;
+    }
+
+    /**
+     * Group the commands by bucket. Must be called after all draws are added
+     * and before the commands are uploaded.
+     */
+    void Build();
+
+    /**
+     * The commands that were built (see Build). The commands of a bucket are
+     * stored contiguously.
+     */
+    const std::vector<IndirectDrawCommand>& GetCommands() const
+    {
+        return m_Commands;
+    }
+
+    const Bucket& GetBucket( uint32_t bucket ) const
+    {
+        return m_Buckets[bucket];
+    }
+
+    const std::vector<Bucket>& GetBuckets() const
+    {
+        return m_Buckets;
+    }
+
+private:
+    // The draws of each bucket in the order they were added.
+    std::vector<std::vector<IndirectDrawCommand>> m_BucketDraws;
+    uint32_t                                      m_NumDraws;
+
+    // The commands of all buckets.
+    std::vector<IndirectDrawCommand> m_Commands;
+    std::vector<Bucket>              m_Buckets;
+};
+}  // namespace dx12lib
@@ -0,0 +1,250 @@
+#pragma once
+
+/**
+ *  @file LightClusterBuilder.h
+ *
+ *  @brief Assigns point and spot lights to the clusters (froxels) of a view frustum.
+ *
+ *  The view frustum is divided into a grid of NumClustersX * NumClustersY screen
+ *  tiles and NumClustersZ depth slices. The depth slices are distributed
+ *  exponentially between the near and far clip planes so that clusters close to
+ *  the camera are not much longer than they are wide.
+ *
+ *  The builder produces a cluster table (an offset into the light index list and
+ *  the number of point and spot lights for each cluster) and a light index list.
+ *  The light indices of a cluster are stored as the point light indices followed
+ *  by the spot light indices, both in increasing order. Both tables can be
+ *  uploaded as structured buffers and consumed by a pixel shader that computes the
+ *  cluster of a pixel from its view space position (see GetClusterIndex).
+ *
+ *  The builder does not depend on Direct3D so the cluster assignment can be
+ *  verified headlessly against brute force assignment (see BuildBruteForce).
+ */
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace dx12lib
+{
+
+/**
+ * The parameters of the cluster grid that the shader needs to compute the
+ * cluster of a view space position. Matches the HLSL constant buffer packing rules.
+ */
+struct LightClusterConstants
+{
+    // The projection terms used to compute the normalized device coordinates
+    // of a view space position: ( _11, _22, _31, _32 ).
+    DirectX::XMFLOAT4 ProjectionScale;
+    //----------------------------------- (16 byte boundary)
+    uint32_t NumClustersX;
+    uint32_t NumClustersY;
+    uint32_t NumClustersZ;
+    // slice = log( z ) * DepthSliceScale + DepthSliceBias
+    float DepthSliceScale;
+    //----------------------------------- (16 byte boundary)
+    float    DepthSliceBias;
+    float    NearZ;
+    float    FarZ;
+    uint32_t Padding;
+    //----------------------------------- (16 byte boundary)
+    // Total:                              16 * 3 = 48 bytes
+};
+
+/**
+ * The lights that affect a cluster.
+ */
+struct LightCluster
+{
+    // The offset of the first light index in the light index list.
+    uint32_t Offset;
+    // The number of point lights ( low 16 bits ) and spot lights ( high 16 bits ).
+    uint32_t Counts;
+
+    uint32_t GetNumPointLights() const
+    {
+        return Counts & 0xffff;
+    }
+
+    uint32_t GetNumSpotLights() const
+    {
+        return Counts >> 16;
+    }
+};
+
+class LightClusterBuilder
+{
+public:
+    /**
+     * A light with an unbounded range affects every cluster.
+     */
+    static constexpr float InfiniteRange = 3.402823466e+38f;
+
+    struct Statistics
+    {
+        uint32_t NumClusters    = 0;
+        uint32_t NumPointLights = 0;
+        uint32_t NumSpotLights  = 0;
+        // The total number of light indices in the light index list.
+        uint32_t NumLightIndices     = 0;
+        uint32_t MaxLightsPerCluster = 0;
+        // The number of light/cluster intersection tests that were performed.
+        uint64_t NumIntersectionTests = 0;
+    };
+
+    LightClusterBuilder( uint32_t numClustersX = 16, uint32_t numClustersY = 9, uint32_t numClustersZ = 24 );
+
+    /**
+     * Get the distance at which the attenuated light drops below 1/256 of its
+     * color. The light is attenuated by
+     * intensity / ( constant + linear * d + quadratic * d^2 ).
+     *
+     * @returns InfiniteRange if the light is not attenuated.
+     */
+    static float GetLightRange( const DirectX::XMFLOAT4& color, float constantAttenuation, float linearAttenuation,
+                                float quadraticAttenuation, float intensity = 1.0f );
+
+    /**
+     * Set the (left-handed, perspective) projection matrix of the camera. The
+     * near and far clip distances are derived from the projection matrix.
+     * The cluster bounds are only recomputed if the projection matrix changes.
+     */
+    void XM_CALLCONV SetProjectionMatrix( DirectX::FXMMATRIX projectionMatrix );
+
+    /**
+     * Remove all lights.
+     */
+    void ClearLights();
+
+    /**
+     * Add a point light. Point lights must be added in the same order as they
+     * appear in the point light buffer.
+     *
+     * @param positionVS The position of the light in view space.
+     * @param range The distance at which the contribution of the light can be ignored.
+     */
+    void AddPointLight( const DirectX::XMFLOAT3& positionVS, float range );
+
+    /**
+     * Add a spot light. Spot lights must be added in the same order as they
+     * appear in the spot light buffer.
+     *
+     * @param directionVS The (normalized) direction of the light in view space.
+     * @param spotAngle The half angle of the cone in radians.
+     */
+    void AddSpotLight( const DirectX::XMFLOAT3& positionVS, const DirectX::XMFLOAT3& directionVS, float range,
+                       float spotAngle );
+
+    /**
+     * Assign the lights to the clusters. Only the clusters that overlap the
+     * bounds of a light are tested against the light.
+     */
+    void Build();
+
+    /**
+     * Assign the lights to the clusters by testing every light against every
+     * cluster. Produces the same result as Build.
+     */
+    void BuildBruteForce();
+
+    /**
+     * Get the cluster that contains a view space position. This is the same
+     * computation that the shader performs.
+     */
+    uint32_t GetClusterIndex( const DirectX::XMFLOAT3& positionVS ) const;
+
+    uint32_t GetNumClusters() const
+    {
+        return m_NumClustersX * m_NumClustersY * m_NumClustersZ;
+    }
+
+    const LightClusterConstants& GetConstants() const
+    {
+        return m_Constants;
+    }
+
+    const std::vector<LightCluster>& GetClusters() const
+    {
+        return m_Clusters;
+    }
+
+    const std::vector<uint32_t>& GetLightIndices() const
+    {
+        return m_LightIndices;
+    }
+
+    const Statistics& GetStatistics() const
+    {
+        return m_Statistics;
+    }
+
+private:
+    struct Sphere
+    {
+        DirectX::XMFLOAT3 Center;
+        float             Radius;
+    };
+
+    struct Cone
+    {
+        Sphere            Bounds;
+        DirectX::XMFLOAT3 Direction;
+        float             CosAngle;
+        float             SinAngle;
+    };
+
+    // The view space bounds of a cluster.
+    struct AABB
+    {
+        DirectX::XMFLOAT3 Min;
+        DirectX::XMFLOAT3 Max;
+    };
+
+    // A light that intersects a cluster.
+    struct ClusterLight
+    {
+        uint32_t ClusterIndex;
+        // Spot light indices are offset by the number of point lights.
+        uint32_t LightIndex;
+    };
+
+    // Compute the view space bounds of each column, row, and slice of clusters.
+    void UpdateClusterBounds();
+
+    AABB GetClusterBounds( uint32_t x, uint32_t y, uint32_t z ) const;
+
+    static bool Intersects( const Sphere& sphere, const AABB& bounds );
+    static bool Intersects( const Cone& cone, const AABB& bounds );
+
+    // Find the clusters that a sphere intersects and add them to the (cluster, light) pairs.
+    template<typename Light>
+    void AssignLight( const Light& light, const Sphere& bounds, uint32_t lightIndex );
+
+    // Build the cluster table and light index list from the (cluster, light) pairs.
+    void BuildClusters();
+
+    uint32_t m_NumClustersX;
+    uint32_t m_NumClustersY;
+    uint32_t m_NumClustersZ;
+
+    DirectX::XMFLOAT4X4   m_ProjectionMatrix;
+    LightClusterConstants m_Constants;
+
+    // The depth of the boundaries between the slices (NumClustersZ + 1).
+    std::vector<float> m_SliceDepths;
+    // The view space extents of the columns and rows of clusters in each slice.
+    std::vector<DirectX::XMFLOAT2> m_ColumnBounds;
+    std::vector<DirectX::XMFLOAT2> m_RowBounds;
+
+    std::vector<Sphere> m_PointLights;
+    std::vector<Cone>   m_SpotLights;
+
+    std::vector<ClusterLight> m_ClusterLights;
+    std::vector<LightCluster> m_Clusters;
+    std::vector<uint32_t>     m_LightIndices;
+
+    Statistics m_Statistics;
+};
+}  // namespace dx12lib
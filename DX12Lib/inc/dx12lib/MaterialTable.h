@@ -0,0 +1,132 @@
+#pragma once
+
+/**
+ *  @file MaterialTable.h
+ *
+ *  @brief Stores the properties of all materials in a single structured buffer.
+ *
+ *  Each material is assigned an index in the material table when it is first
+ *  used. The textures of the material are registered in the bindless
+ *  descriptor table (see BindlessDescriptorTable) and the material table entry
+ *  stores the indices of the textures in the bindless descriptor table. A draw
+ *  call only needs to set the index of the material (for example, using a root
+ *  constant) instead of uploading the material properties and copying the
+ *  texture descriptors for every draw call.
+ *
+ *  The material table is only uploaded to the GPU when a material is added or
+ *  the properties or textures of a material have changed.
+ */
+
+#include "Material.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace dx12lib
+{
+
+class CommandList;
+class Device;
+class StructuredBuffer;
+class Texture;
+
+// clang-format off
+struct alignas( 16 ) MaterialTableEntry
+{
+    MaterialProperties Properties;
+    //------------------------------------ ( 16 * 8 = 128 bytes )
+    // The indices of the textures in the bindless descriptor table (indexed
+    // by Material::TextureType) or 0xffffffff if the material does not have a
+    // texture of that type.
+    uint32_t TextureIndices[static_cast<size_t>( Material::TextureType::NumTypes )];
+    //------------------------------------ ( 16 * 2 = 32 bytes )
+    // Total:                              ( 16 * 10 = 160 bytes )
+};
+// clang-format on
+
+class MaterialTable
+{
+public:
+    /**
+     * Get the index of a material in the material table. The material is added
+     * to the material table if it was not used before. If the properties or
+     * textures of the material have changed, the material table entry is updated.
+     * The material table must be committed (see Commit) before it is used by a draw call.
+     */
+    uint32_t GetMaterialIndex( const std::shared_ptr<Material>& material );
+
+    /**
+     * Check to see if the material table needs to be committed.
+     */
+    bool IsDirty() const
+    {
+        return m_IsDirty;
+    }
+
+    /**
+     * Upload the material table to the GPU if materials were added or changed
+     * since the last commit. Textures that were added since the last commit
+     * are transitioned to the pixel shader resource state on the command list.
+     *
+     * @returns true if a new material buffer was created and must be rebound.
+     */
+    bool Commit( CommandList& commandList );
+
+    /**
+     * Transition all of the textures that are referenced by the material table
+     * to the pixel shader resource state. This should be done once for every
+     * command list that uses the material table.
+     */
+    void TransitionTextures( CommandList& commandList );
+
+    /**
+     * Get the structured buffer that contains the material table entries.
+     */
+    std::shared_ptr<StructuredBuffer> GetMaterialBuffer() const
+    {
+        return m_MaterialBuffer;
+    }
+
+    uint32_t GetNumMaterials() const
+    {
+        return static_cast<uint32_t>( m_Entries.size() );
+    }
+
+protected:
+    friend class std::default_delete<MaterialTable>;
+
+    MaterialTable( Device& device );
+    virtual ~MaterialTable();
+
+private:
+    // The textures of a material the last time its entry was updated.
+    using MaterialTextures = std::shared_ptr<Texture>[static_cast<size_t>( Material::TextureType::NumTypes )];
+
+    struct MaterialRecord
+    {
+        // Keep the material alive so the key is not reused by another material.
+        std::shared_ptr<dx12lib::Material> Instance;
+        uint32_t                           Index;
+        MaterialTextures                   Textures;
+    };
+
+    // Update the material table entry if the material has changed.
+    void UpdateEntry( MaterialRecord& record );
+
+    Device& m_Device;
+
+    std::unordered_map<Material*, MaterialRecord> m_Materials;
+    std::vector<MaterialTableEntry>               m_Entries;
+
+    // All textures that are referenced by the material table and the textures
+    // that need to be transitioned on the next commit.
+    std::unordered_set<std::shared_ptr<Texture>> m_Textures;
+    std::vector<std::shared_ptr<Texture>>        m_PendingTextures;
+
+    std::shared_ptr<StructuredBuffer> m_MaterialBuffer;
+    bool                              m_IsDirty;
+};
+}  // namespace dx12lib
@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ *  @file MipGenerator.h
+ *
+ *  @brief Generates mip chains on the CPU.
+ *
+ *  CommandList::GenerateMips generates mips with a compute shader, which only
+ *  works for single 2D textures (not for arrays or cubemaps) and needs an
+ *  aliased UAV copy of textures whose format can't be used as a UAV. The
+ *  MipGenerator generates the mips on the CPU before the texture is uploaded
+ *  so it works for any 2D texture (array) in a supported format and can be
+ *  used to bake mips into cooked textures.
+ *
+ *  Each mip is filtered from the previous mip, like the GPU path. The filter
+ *  is separable and is applied to RGBA texels with SSE. sRGB textures are
+ *  filtered in linear space. The rows of each mip are split into bands that
+ *  are filtered in parallel.
+ *
+ *  The generator only depends on the standard library so it can be built on
+ *  any platform (for example to validate the output of the GPU path).
+ */
+
+#include <dxgiformat.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dx12lib
+{
+
+enum class MipFilter
+{
+    // Averages the texels that are covered by a texel of the next mip (a 2x2
+    // box filter if the size of the mip is even). Matches the GPU path for
+    // textures with power of two sizes.
+    Box,
+    // Kaiser windowed sinc filter (width 3, alpha 4). Sharper than the box
+    // filter with little ringing, but about 10 times as slow.
+    Kaiser,
+};
+
+struct MipGenerationSettings
+{
+    MipFilter Filter = MipFilter::Box;
+    // Wrap around the edges of the texture instead of clamping (for tiling
+    // textures). Only the Kaiser filter reads texels outside of the texture.
+    bool Wrap = false;
+    // The number of threads that filter a mip (0 to use all hardware threads).
+    uint32_t NumThreads = 0;
+};
+
+class MipGenerator
+{
+public:
+    /**
+     * A mip level of one slice of a texture.
+     */
+    struct Subresource
+    {
+        void*    Pixels;
+        size_t   RowPitch;
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    explicit MipGenerator( const MipGenerationSettings& settings = {} );
+
+    /**
+     * Check to see if mips can be generated for a format. Supported formats
+     * are 8 bit UNORM (and sRGB) formats with 1, 2 or 4 channels, 16 bit UNORM
+     * and FLOAT formats with 1, 2 or 4 channels and 32 bit FLOAT formats.
+     */
+    static bool IsFormatSupported( DXGI_FORMAT format );
+
+    /**
+     * Get the number of mips of a full mip chain.
+     */
+    static uint32_t GetNumMips( uint32_t width, uint32_t height );
+
+    /**
+     * Generate mips 1 to numMips - 1 of every slice of a texture from mip 0.
+     * The subresources are in the same order as the subresources of a D3D12
+     * texture: mip + slice * numMips (for cubemaps, every face is a slice).
+     * The size of each mip must be half the size of the previous mip (rounded
+     * down and at least 1).
+     */
+    void Generate( DXGI_FORMAT format, const Subresource* subresources, uint32_t numMips,
+                   uint32_t arraySize = 1 ) const;
+
+    const MipGenerationSettings& GetSettings() const
+    {
+        return m_Settings;
+    }
+
+private:
+    MipGenerationSettings m_Settings;
+};
+
+}  // namespace dx12lib
@@ -0,0 +1,115 @@
+#pragma once
+
+/**
+ *  @file NullDevice.h
+ *
+ *  @brief A D3D12 device that does not execute any work.
+ *
+ *  The null device implements the D3D12 interfaces that are used by dx12lib
+ *  without a driver or a GPU. Upload and readback resources are backed by CPU
+ *  memory (so they can be mapped), all other resources get fake GPU virtual
+ *  addresses, descriptor heaps hand out fake (but unique) descriptor handles,
+ *  and fences are completed as soon as they are signaled on a command queue.
+ *
+ *  This makes it possible to measure the CPU cost of the library (descriptor
+ *  allocation and binding, resource state tracking, staging allocations, and
+ *  command list submission) without the cost and the variance of the driver.
+ *  Use Device::CreateNull to create a dx12lib device that uses the null device.
+ *
+ *  The null device counts the API calls that are made (see NullDeviceCounters).
+ *  Command lists count their calls locally and add them to the counters of the
+ *  device when the command list is closed so that recording a command list does
+ *  not contend on the counters.
+ */
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace dx12lib
+{
+
+enum class NullDeviceCounter
+{
+    // Device
+    CreateResource,        // Committed, placed, and reserved resources.
+    CreateHeap,            // Resource heaps and descriptor heaps.
+    CreatePipelineState,   // Pipeline states, root signatures, and command signatures.
+    CreateView,            // CBVs, SRVs, UAVs, RTVs, DSVs, and samplers.
+    CopyDescriptors,       // Calls to CopyDescriptors and CopyDescriptorsSimple.
+    NumCopiedDescriptors,  // The number of descriptors that were copied.
+    // Command queue
+    ExecuteCommandLists,
+    NumExecutedCommandLists,
+    Signal,
+    UpdateTileMappings,
+    // Command list
+    ResetCommandList,
+    CloseCommandList,
+    Draw,             // DrawInstanced and DrawIndexedInstanced.
+    Dispatch,
+    ExecuteIndirect,
+    Copy,             // Buffer, texture, tile, and resolve copies.
+    Clear,            // Clear views and discard resources.
+    ResourceBarrier,  // Calls to ResourceBarrier.
+    NumBarriers,      // The number of barriers that were submitted.
+    SetPipelineState,
+    SetRootSignature,
+    SetRootArguments,  // Descriptor tables, root constants, and root views.
+    SetDescriptorHeaps,
+    SetInputAssembler,   // Primitive topology, vertex buffers, and index buffers.
+    SetRasterizerState,  // Viewports, scissor rects, render targets, and other output merger state.
+    OtherCommand,
+    // Memory
+    NumCPUHeapBytes,  // The CPU memory that is currently allocated for upload and readback resources.
+
+    NumCounters
+};
+
+class NullDeviceCounters
+{
+public:
+    NullDeviceCounters();
+
+    void Add( NullDeviceCounter counter, uint64_t value = 1 )
+    {
+        m_Counters[static_cast<size_t>( counter )].fetch_add( value, std::memory_order_relaxed );
+    }
+
+    void Subtract( NullDeviceCounter counter, uint64_t value )
+    {
+        m_Counters[static_cast<size_t>( counter )].fetch_sub( value, std::memory_order_relaxed );
+    }
+
+    uint64_t Get( NullDeviceCounter counter ) const
+    {
+        return m_Counters[static_cast<size_t>( counter )].load( std::memory_order_relaxed );
+    }
+
+    /**
+     * Reset all counters to 0 (except NumCPUHeapBytes, which tracks the memory
+     * that is currently allocated).
+     */
+    void Reset();
+
+    /**
+     * Get the name of a counter (for reporting).
+     */
+    static const char* GetName( NullDeviceCounter counter );
+
+private:
+    std::atomic_uint64_t m_Counters[static_cast<size_t>( NullDeviceCounter::NumCounters )];
+};
+
+/**
+ * Create a null D3D12 device.
+ *
+ * @param counters The counters that are updated by the device and the objects
+ * that are created by the device.
+ */
+Microsoft::WRL::ComPtr<ID3D12Device2> CreateNullD3D12Device( std::shared_ptr<NullDeviceCounters> counters );
+
+}  // namespace dx12lib
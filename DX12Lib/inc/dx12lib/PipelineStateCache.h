@@ -0,0 +1,344 @@
+#pragma once
+
+/**
+ *  @file PipelineStateCache.h
+ *
+ *  @brief A cache for root signatures and pipeline state objects.
+ *
+ *  Root signatures and pipeline state objects are keyed by a hash of their
+ *  description so that identical requests return the same object. The hash of
+ *  a pipeline state stream is computed from the contents of the stream (shader
+ *  bytecode, input layout, etc.) and not from the pointers in the stream.
+ *
+ *  If a library file name is specified, pipeline state objects are stored in an
+ *  ID3D12PipelineLibrary that is loaded from (and can be saved to) disk so that
+ *  the driver does not have to compile the same pipeline state objects again
+ *  on the next run.
+ *
+ *  Pipeline state objects can also be created asynchronously on worker threads.
+ *  A fallback pipeline state object is used until the requested pipeline state
+ *  object is ready.
+ */
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace dx12lib
+{
+
+class CommandStreamReader;
+class CommandStreamWriter;
+class Device;
+class PipelineStateObject;
+class RootSignature;
+
+/**
+ * 64-bit FNV-1a hash. The hash is stable between runs so it can be used to
+ * identify pipeline state objects in a pipeline library.
+ */
+class Hash64
+{
+public:
+    Hash64()
+    : m_Hash( 14695981039346656037ull )
+    {}
+
+    void Add( const void* data, size_t size )
+    {
+        auto bytes = static_cast<const uint8_t*>( data );
+        for ( size_t i = 0; i < size; ++i )
+        {
+            m_Hash ^= bytes[i];
+            m_Hash *= 1099511628211ull;
+        }
+    }
+
+    template<typename T>
+    void Add( const T& value )
+    {
+        Add( &value, sizeof( T ) );
+    }
+
+    // Strings are hashed including the null terminator.
+    void AddString( const char* str )
+    {
+        Add( str, str ? strlen( str ) + 1 : 0 );
+    }
+
+    uint64_t Get() const
+    {
+        return m_Hash;
+    }
+
+private:
+    uint64_t m_Hash;
+};
+
+/**
+ * Compute the hash of a root signature description.
+ */
+uint64_t HashRootSignatureDesc( const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc );
+
+/**
+ * A deep copy of a pipeline state stream. The data that is referenced by the
+ * subobjects of the stream (shader bytecode, input layout, etc.) is copied
+ * so that the stream remains valid after the original stream goes out of scope.
+ */
+class PipelineStateDesc
+{
+public:
+    /**
+     * Returns the hash of a root signature referenced by a stream (or 0 if the
+     * root signature is unknown).
+     */
+    using RootSignatureHashFunc = std::function<uint64_t( ID3D12RootSignature* )>;
+
+    PipelineStateDesc( const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc,
+                       const RootSignatureHashFunc&            getRootSignatureHash = nullptr );
+
+    PipelineStateDesc( const PipelineStateDesc& ) = delete;
+    PipelineStateDesc& operator=( const PipelineStateDesc& ) = delete;
+
+    /**
+     * The hash of the contents of the stream.
+     */
+    uint64_t GetHash() const
+    {
+        return m_Hash;
+    }
+
+    /**
+     * A pipeline state can only be stored in a pipeline library if its hash
+     * does not depend on pointers (the hash of its root signature is known).
+     */
+    bool IsPersistent() const
+    {
+        return m_IsPersistent;
+    }
+
+    D3D12_PIPELINE_STATE_STREAM_DESC GetStreamDesc()
+    {
+        return { m_Stream.size(), m_Stream.data() };
+    }
+
+    /**
+     * Write the stream and the data that is referenced by the stream (see
+     * CommandRecorder). Root signatures are written as the ids that are
+     * returned by getRootSignatureId.
+     */
+    void Serialize( CommandStreamWriter&                                       writer,
+                    const std::function<uint32_t( ID3D12RootSignature* )>& getRootSignatureId ) const;
+
+    /**
+     * Read a stream that was written with Serialize.
+     */
+    static std::shared_ptr<PipelineStateDesc>
+        Deserialize( CommandStreamReader&                                       reader,
+                     const std::function<ID3D12RootSignature*( uint32_t )>& getRootSignature );
+
+private:
+    // Copy data that is referenced by the stream.
+    const void* CopyData( const void* data, size_t size );
+    const char* CopyString( const char* str );
+
+    std::vector<uint8_t>             m_Stream;
+    std::deque<std::vector<uint8_t>> m_Data;
+
+    // Keep the root signature alive while the stream is used.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+
+    uint64_t m_Hash;
+    bool     m_IsPersistent;
+};
+
+/**
+ * A pipeline state object that is being created on a worker thread.
+ */
+class AsyncPipelineStateObject
+{
+public:
+    /**
+     * Check to see if the pipeline state object has been created (or failed to be created).
+     */
+    bool IsReady() const;
+
+    /**
+     * Check to see if the pipeline state object could not be created.
+     */
+    bool IsFailed() const;
+
+    /**
+     * Get the pipeline state object if it is ready, or the fallback pipeline
+     * state object if it is not ready yet (or could not be created).
+     */
+    std::shared_ptr<PipelineStateObject> Get() const;
+
+    /**
+     * Wait for the pipeline state object to be created. Rethrows the
+     * exception if the pipeline state object could not be created.
+     */
+    std::shared_ptr<PipelineStateObject> Wait() const;
+
+protected:
+    friend class PipelineStateCache;
+    friend class std::default_delete<AsyncPipelineStateObject>;
+
+    AsyncPipelineStateObject( std::shared_future<std::shared_ptr<PipelineStateObject>> future,
+                              std::shared_ptr<PipelineStateObject>                     fallback );
+    virtual ~AsyncPipelineStateObject() = default;
+
+private:
+    std::shared_future<std::shared_ptr<PipelineStateObject>> m_Future;
+    std::shared_ptr<PipelineStateObject>                     m_Fallback;
+};
+
+class PipelineStateCache
+{
+public:
+    struct Statistics
+    {
+        uint64_t NumRootSignatureRequests = 0;
+        uint64_t NumRootSignatureHits     = 0;
+        uint64_t NumPipelineStateRequests = 0;
+        // Requests for pipeline state objects that were already created (or being created).
+        uint64_t NumPipelineStateHits = 0;
+        // Pipeline state objects that were loaded from the pipeline library.
+        uint64_t NumLibraryHits = 0;
+        // Pipeline state objects that were compiled by the driver.
+        uint64_t NumPipelineStatesCreated = 0;
+        uint64_t NumPipelineStatesFailed  = 0;
+        // Total time (in milliseconds) spent loading and creating pipeline state objects.
+        double PipelineStateCreationTime = 0.0;
+    };
+
+    /**
+     * Get a root signature. If an identical root signature was already
+     * requested, the same root signature is returned.
+     */
+    std::shared_ptr<RootSignature> GetRootSignature( const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc );
+
+    /**
+     * Get a pipeline state object. If an identical pipeline state object was
+     * already requested, the same pipeline state object is returned. If it is
+     * still being created asynchronously, this function waits for it.
+     */
+    template<class PipelineStateStream>
+    std::shared_ptr<PipelineStateObject> GetPipelineStateObject( PipelineStateStream& pipelineStateStream )
+    {
+        D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = { sizeof( PipelineStateStream ),
+                                                                     &pipelineStateStream };
+
+        return DoGetPipelineStateObject( pipelineStateStreamDesc );
+    }
+
+    /**
+     * Create a pipeline state object on a worker thread. The stream is copied
+     * so it does not need to remain valid after this function returns.
+     *
+     * @param fallback The pipeline state object to use until the requested
+     * pipeline state object is ready.
+     */
+    template<class PipelineStateStream>
+    std::shared_ptr<AsyncPipelineStateObject>
+        GetPipelineStateObjectAsync( PipelineStateStream&                 pipelineStateStream,
+                                     std::shared_ptr<PipelineStateObject> fallback = nullptr )
+    {
+        D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = { sizeof( PipelineStateStream ),
+                                                                     &pipelineStateStream };
+
+        return DoGetPipelineStateObjectAsync( pipelineStateStreamDesc, fallback );
+    }
+
+    /**
+     * Wait for all asynchronous pipeline state objects to be created.
+     */
+    void WaitForPendingPipelineStates();
+
+    /**
+     * Write the pipeline library to disk. Does nothing if the cache does not
+     * have a pipeline library or no pipeline state objects were added to it.
+     */
+    void Save();
+
+    Statistics GetStatistics() const;
+    void       ResetStatistics();
+
+protected:
+    friend class Device;
+    friend class std::default_delete<PipelineStateCache>;
+
+    /**
+     * @param libraryFileName The file to load the pipeline library from. If
+     * empty, no pipeline library is used.
+     * @param numThreads The number of worker threads for asynchronous creation
+     * (0 to use half of the hardware threads).
+     */
+    PipelineStateCache( Device& device, const std::wstring& libraryFileName, uint32_t numThreads );
+    virtual ~PipelineStateCache();
+
+    std::shared_ptr<PipelineStateObject>
+        DoGetPipelineStateObject( const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc );
+    std::shared_ptr<AsyncPipelineStateObject>
+        DoGetPipelineStateObjectAsync( const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc,
+                                       std::shared_ptr<PipelineStateObject>    fallback );
+
+private:
+    using PipelineStateFuture  = std::shared_future<std::shared_ptr<PipelineStateObject>>;
+    using PipelineStatePromise = std::promise<std::shared_ptr<PipelineStateObject>>;
+
+    struct PipelineStateJob
+    {
+        std::shared_ptr<PipelineStateDesc> Desc;
+        PipelineStatePromise               Promise;
+    };
+
+    void LoadPipelineLibrary();
+
+    // Copy a pipeline state stream. Must be called with the cache mutex locked.
+    std::shared_ptr<PipelineStateDesc> CopyPipelineStateDesc( const D3D12_PIPELINE_STATE_STREAM_DESC& desc ) const;
+
+    // Load the pipeline state object from the pipeline library or create it.
+    std::shared_ptr<PipelineStateObject> CreatePipelineStateObject( const std::shared_ptr<PipelineStateDesc>& desc );
+
+    // Create the pipeline state object and fulfill the promise.
+    void Resolve( const std::shared_ptr<PipelineStateDesc>& desc, PipelineStatePromise& promise );
+
+    void WorkerThread();
+
+    Device& m_Device;
+
+    std::wstring                                  m_LibraryFileName;
+    std::vector<uint8_t>                          m_LibraryData;  // Must outlive the pipeline library.
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary1> m_PipelineLibrary;
+    bool                                          m_IsLibraryDirty;
+    std::mutex                                    m_LibraryMutex;
+
+    std::unordered_map<uint64_t, std::shared_ptr<RootSignature>> m_RootSignatures;
+    std::unordered_map<ID3D12RootSignature*, uint64_t>           m_RootSignatureHashes;
+    std::unordered_map<uint64_t, PipelineStateFuture>            m_PipelineStates;
+
+    Statistics         m_Statistics;
+    mutable std::mutex m_Mutex;
+
+    // Asynchronous pipeline state creation.
+    std::deque<PipelineStateJob> m_Jobs;
+    size_t                       m_NumPendingJobs;
+    std::condition_variable      m_JobsCondition;
+    std::condition_variable      m_JobsDoneCondition;
+    std::vector<std::thread>     m_WorkerThreads;
+    bool                         m_bStopWorkers;
+};
+}  // namespace dx12lib
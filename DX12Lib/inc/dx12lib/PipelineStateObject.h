@@ -33,10 +33,13 @@
 #include <d3d12.h>       // For D3D12_PIPELINE_STATE_STREAM_DESC, and ID3D12PipelineState
 #include <wrl/client.h>  // For Microsoft::WRL::ComPtr
 
+#include <memory>  // For std::shared_ptr
+
 namespace dx12lib
 {
 
 class Device;
+class PipelineStateDesc;
 
 class PipelineStateObject
 {
@@ -46,12 +49,26 @@ public:
         return m_d3d12PipelineState;
     }
 
+    /**
+     * Get a copy of the pipeline state stream that was used to create the
+     * pipeline state object (can be null if the pipeline state object was
+     * created from an existing ID3D12PipelineState). Used to serialize the
+     * pipeline state object in command stream captures.
+     */
+    std::shared_ptr<const PipelineStateDesc> GetPipelineStateDesc() const
+    {
+        return m_Desc;
+    }
+
 protected:
     PipelineStateObject( Device& device, const D3D12_PIPELINE_STATE_STREAM_DESC& desc );
+    PipelineStateObject( Device& device, Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState,
+                         std::shared_ptr<PipelineStateDesc> desc = nullptr );
     virtual ~PipelineStateObject() = default;
 
 private:
     Device&                                     m_Device;
     Microsoft::WRL::ComPtr<ID3D12PipelineState> m_d3d12PipelineState;
+    std::shared_ptr<PipelineStateDesc>          m_Desc;
 };
 }  // namespace dx12lib
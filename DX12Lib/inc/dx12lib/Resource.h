@@ -68,6 +68,15 @@ public:
         return resDesc;
     }
 
+    /**
+     * Get the optimized clear value of the resource (or nullptr if the
+     * resource was created without a clear value).
+     */
+    const D3D12_CLEAR_VALUE* GetD3D12ClearValue() const
+    {
+        return m_d3d12ClearValue.get();
+    }
+
     /**
      * Set the name of the resource. Useful for debugging purposes.
      */
@@ -84,7 +93,7 @@ public:
     bool CheckFormatSupport( D3D12_FORMAT_SUPPORT2 formatSupport ) const;
 
 protected:
-//    friend class CommandList;
+    friend class CommandList;
 
     // Resource creation should go through the device.
     Resource( Device& device, const D3D12_RESOURCE_DESC& resourceDesc,
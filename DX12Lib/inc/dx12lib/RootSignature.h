@@ -60,6 +60,17 @@ public:
     uint32_t GetDescriptorTableBitMask( D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType ) const;
     uint32_t GetNumDescriptors( uint32_t rootIndex ) const;
 
+    /**
+     * Get a bit mask that represents the root parameter indices of descriptor
+     * tables with an unbounded range (NumDescriptors = UINT_MAX). These tables
+     * are bound to the bindless descriptor table (see BindlessDescriptorTable)
+     * and are not included in the descriptor table bit mask.
+     */
+    uint32_t GetBindlessTableBitMask() const
+    {
+        return m_BindlessTableBitMask;
+    }
+
 protected:
     friend class std::default_delete<RootSignature>;
 
@@ -86,5 +97,8 @@ private:
     // A bit mask that represents the root parameter indices that are
     // CBV, UAV, and SRV descriptor tables.
     uint32_t m_DescriptorTableBitMask;
+    // A bit mask that represents the root parameter indices that are
+    // unbounded SRV descriptor tables.
+    uint32_t m_BindlessTableBitMask;
 };
 }  // namespace dx12lib
\ No newline at end of file
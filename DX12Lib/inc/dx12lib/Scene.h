@@ -37,6 +37,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 #include "dx12lib/SceneStruct.h"
 
 class aiMaterial;
@@ -51,8 +52,12 @@ class Device;
 class SceneNode;
 class Mesh;
 class Material;
+class StreamingRequest;
+class Texture;
 class Visitor;
 
+enum class TextureUsage;
+
 class Scene
 {
 public:
@@ -107,6 +112,22 @@ private:
     std::shared_ptr<SceneNode> ImportSceneNode( CommandList& commandList, std::shared_ptr<SceneNode> parent,
                                                 const aiNode* aiNode );
 
+    using SetTextureFunc = std::function<void( std::shared_ptr<Texture> )>;
+
+    /**
+     * Load a texture of a material. If the device has a streaming upload queue,
+     * the texture is requested from the queue and passed to setTexture in
+     * FinishStreamingTextures. Otherwise it is loaded immediately.
+     */
+    void LoadTexture( CommandList& commandList, const std::filesystem::path& fileName, TextureUsage usage,
+                      SetTextureFunc setTexture );
+
+    /**
+     * Wait for the textures that were requested from the streaming upload queue
+     * and assign them to their materials.
+     */
+    void FinishStreamingTextures();
+
     using MaterialMap  = std::map<std::string, std::shared_ptr<Material>>;
     using MaterialList = std::vector<std::shared_ptr<Material>>;
     using MeshList     = std::vector<std::shared_ptr<Mesh>>;
@@ -115,6 +136,11 @@ private:
     MaterialList m_Materials;
     MeshList     m_Meshes;
 
+    // Textures that are being streamed while the scene is imported. Textures that
+    // are shared by several materials are only requested once.
+    std::map<std::wstring, std::shared_ptr<StreamingRequest>>                 m_StreamingRequests;
+    std::vector<std::pair<std::shared_ptr<StreamingRequest>, SetTextureFunc>> m_StreamingTextures;
+
     //============== Added by Hanlin ====================
     std::vector<Triangle> m_MeshTrianglefaces;
 
@@ -54,6 +54,15 @@ public:
         return m_Descriptor.GetDescriptorHandle();
     }
 
+    /**
+     * Get the description that was used to create the view (or nullptr if the
+     * view was created with the default description of the resource).
+     */
+    const D3D12_SHADER_RESOURCE_VIEW_DESC* GetShaderResourceViewDesc() const
+    {
+        return m_Desc.get();
+    }
+
 protected:
     ShaderResourceView( Device& device, const std::shared_ptr<Resource>& resource,
                         const D3D12_SHADER_RESOURCE_VIEW_DESC* srv = nullptr );
@@ -63,5 +72,7 @@ private:
     Device&                   m_Device;
     std::shared_ptr<Resource> m_Resource;
     DescriptorAllocation      m_Descriptor;
+
+    std::unique_ptr<D3D12_SHADER_RESOURCE_VIEW_DESC> m_Desc;
 };
 }  // namespace dx12lib
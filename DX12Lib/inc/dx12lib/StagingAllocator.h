@@ -0,0 +1,178 @@
+#pragma once
+
+/**
+ *  @file StagingAllocator.h
+ *
+ *  @brief A device-wide pool of large upload heap chunks used to stage buffer and
+ *  texture data before it is copied to a default heap resource.
+ *
+ *  Command lists request chunks from the pool and sub-allocate their staging
+ *  memory linearly from them. A chunk stays with the command list until the
+ *  command list is reset by the command queue (which only happens after the
+ *  command list's fence value has been reached), at which point the chunk is
+ *  returned to the pool and recycled by the next command list that needs staging
+ *  memory. Used this way, the pool behaves like a ring of chunks that is consumed
+ *  at the head by recording command lists and replenished at the tail as command
+ *  lists retire on the GPU.
+ */
+
+#include "Defines.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace dx12lib
+{
+
+class Device;
+
+class StagingAllocator
+{
+public:
+    // A sub-allocation of staging memory.
+    struct Allocation
+    {
+        void*           CPU;
+        ID3D12Resource* Resource;
+        uint64_t        Offset;
+    };
+
+    // A single upload heap that staging memory is linearly sub-allocated from.
+    class Chunk
+    {
+    public:
+        Chunk( Device& device, size_t sizeInBytes );
+        ~Chunk();
+
+        // Check to see if the chunk has room to satisfy the requested allocation.
+        bool HasSpace( size_t sizeInBytes, size_t alignment ) const;
+
+        // Allocate memory from the chunk.
+        // Throws std::bad_alloc if the the chunk does not have enough space
+        // to satisfy the request.
+        Allocation Allocate( size_t sizeInBytes, size_t alignment );
+
+        // Reset the chunk for reuse.
+        void Reset();
+
+        size_t GetSize() const
+        {
+            return m_Size;
+        }
+
+        ID3D12Resource* GetD3D12Resource() const
+        {
+            return m_d3d12Resource.Get();
+        }
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12Resource;
+
+        // Base pointer.
+        void* m_CPUPtr;
+
+        // Allocated chunk size.
+        size_t m_Size;
+        // Current allocation offset in bytes.
+        size_t m_Offset;
+    };
+
+    /**
+     * Staging statistics accumulated since the last call to ResetStatistics.
+     */
+    struct Statistics
+    {
+        // The number of upload heap resources that have been created.
+        uint64_t NumUploadResourcesCreated = 0;
+        // The number of times a retired chunk was handed out again.
+        uint64_t NumChunksRecycled = 0;
+        // The number of individual buffer or texture uploads that were staged.
+        uint64_t NumUploads = 0;
+        // The number of batches that were recorded to command lists.
+        uint64_t NumBatches = 0;
+        // The total number of bytes that were staged.
+        uint64_t BytesUploaded = 0;
+        // The number of bytes whose batches have completed on the GPU.
+        uint64_t BytesCompleted = 0;
+        // The accumulated time (in seconds) between recording a batch and
+        // the batch retiring on the GPU.
+        double UploadSeconds = 0.0;
+
+        /**
+         * Upload throughput in MB/s measured from the moment a batch is recorded
+         * until the command list containing it has finished executing.
+         */
+        double GetThroughputMBps() const
+        {
+            return UploadSeconds > 0.0 ? ( BytesCompleted / ( 1024.0 * 1024.0 ) ) / UploadSeconds : 0.0;
+        }
+    };
+
+    /**
+     * The default size of a chunk. Staging allocations larger than this
+     * are given a dedicated chunk.
+     */
+    size_t GetChunkSize() const
+    {
+        return m_ChunkSize;
+    }
+
+    /**
+     * Request a chunk that can hold at least sizeInBytes bytes.
+     * A previously retired chunk is reused if possible.
+     */
+    std::shared_ptr<Chunk> RequestChunk( size_t sizeInBytes );
+
+    /**
+     * Return a chunk to the pool. This should only be done when the command list
+     * that used the chunk is finished executing on the command queue.
+     */
+    void RetireChunk( const std::shared_ptr<Chunk>& chunk );
+
+    /**
+     * Release all chunks that are currently in the pool.
+     */
+    void Trim();
+
+    /**
+     * Record that a batch of uploads has been recorded to a command list.
+     */
+    void RecordBatch( uint64_t numUploads, uint64_t numBytes );
+
+    /**
+     * Record that a previously recorded batch has finished executing.
+     */
+    void RecordCompletion( uint64_t numBytes, std::chrono::high_resolution_clock::duration elapsedTime );
+
+    Statistics GetStatistics() const;
+    void       ResetStatistics();
+
+protected:
+    friend class std::default_delete<StagingAllocator>;
+
+    // Can only be created by the Device.
+    explicit StagingAllocator( Device& device, size_t chunkSize = _16MB );
+    virtual ~StagingAllocator();
+
+private:
+    using ChunkPool = std::deque<std::shared_ptr<Chunk>>;
+
+    // The device that was used to create this staging allocator.
+    Device& m_Device;
+
+    // Chunks that are not currently used by any command list.
+    ChunkPool m_AvailableChunks;
+
+    // The size of each (non-dedicated) chunk.
+    size_t m_ChunkSize;
+
+    Statistics         m_Statistics;
+    mutable std::mutex m_Mutex;
+};
+}  // namespace dx12lib
@@ -0,0 +1,388 @@
+#pragma once
+
+/**
+ *  @file StreamingUploadQueue.h
+ *
+ *  @brief A background service that streams buffer and texture data to the GPU
+ *  using the copy queue.
+ *
+ *  Requests are serviced in priority order on a worker thread. Each request is
+ *  split into upload units (a range of rows of a texture subresource or a range
+ *  of a buffer) that fit in a per-frame budget, and the number of bytes that are
+ *  recorded is limited by that budget so that streaming never stalls the frame.
+ *  Texture mips are uploaded from the smallest to the largest so that a low
+ *  resolution version of the texture can be displayed as soon as possible.
+ *
+ *  While a texture is streaming, only the resident mips (see
+ *  StreamingRequest::GetMostDetailedResidentMip) may be used for rendering.
+ *  Create a shader resource view with MostDetailedMip (or ResourceMinLODClamp)
+ *  set to the most detailed resident mip and transition only the resident
+ *  subresources until the request has completed.
+ */
+
+#include "Defines.h"
+
+#include <d3d12.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DirectX
+{
+class ScratchImage;
+}
+
+namespace dx12lib
+{
+
+class CommandList;
+class CommandQueue;
+class Device;
+class Resource;
+class Texture;
+
+enum class StreamingPriority
+{
+    Low,
+    Normal,
+    High,
+    Critical,
+    NumPriorities
+};
+
+class StreamingRequest
+{
+public:
+    using Clock = std::chrono::high_resolution_clock;
+
+    enum class Status
+    {
+        Queued,     // Waiting to be serviced.
+        Uploading,  // At least one upload unit has been recorded.
+        Completed,  // All data has been uploaded and the GPU has finished copying it.
+        Cancelled,  // The request was cancelled before it was completed.
+        Failed      // The request could not be serviced (for example, the file could not be loaded).
+    };
+
+    /**
+     * Invoked on the streaming thread when the request is completed, cancelled
+     * or failed. The argument is true only if the request was completed.
+     */
+    using CompletionCallback = std::function<void( bool )>;
+
+    uint64_t GetId() const
+    {
+        return m_Id;
+    }
+
+    StreamingPriority GetPriority() const
+    {
+        return m_Priority;
+    }
+
+    Status GetStatus() const
+    {
+        return m_Status;
+    }
+
+    /**
+     * Check to see if the request is no longer being serviced.
+     */
+    bool IsDone() const
+    {
+        auto status = GetStatus();
+        return status == Status::Completed || status == Status::Cancelled || status == Status::Failed;
+    }
+
+    /**
+     * Cancel the request. Upload units that are already recorded are not
+     * undone but no further units are recorded.
+     */
+    void Cancel()
+    {
+        m_bCancelled = true;
+    }
+
+    bool IsCancelled() const
+    {
+        return m_bCancelled;
+    }
+
+    /**
+     * Get a future that becomes ready when the request is done. The value is
+     * true if the request completed. If the request failed with an exception,
+     * the exception is rethrown from std::shared_future::get.
+     */
+    std::shared_future<bool> GetFuture() const
+    {
+        return m_Future;
+    }
+
+    /**
+     * Get the resource that is the destination of the request.
+     * For textures that are loaded from a file, this is null until the file
+     * has been loaded by the streaming thread.
+     */
+    std::shared_ptr<Resource> GetResource() const;
+
+    /**
+     * Get the destination resource as a texture (or null if the destination
+     * is not a texture).
+     */
+    std::shared_ptr<Texture> GetTexture() const;
+
+    /**
+     * Get the index of the most detailed mip level that has finished uploading.
+     * Returns -1 if no mip level is resident yet.
+     */
+    int32_t GetMostDetailedResidentMip() const
+    {
+        return m_MostDetailedResidentMip;
+    }
+
+protected:
+    friend class StreamingUploadQueue;
+    friend class std::default_delete<StreamingRequest>;
+
+    StreamingRequest( uint64_t id, StreamingPriority priority, CompletionCallback completionCallback );
+    virtual ~StreamingRequest();
+
+private:
+    // A range of rows of a texture subresource or a range of a buffer.
+    struct UploadUnit
+    {
+        uint32_t MipLevel;
+        uint32_t ArraySlice;
+        // The rows of the subresource (rows of blocks for block-compressed
+        // formats, depth slices for 3D textures).
+        uint32_t FirstRow;
+        uint32_t NumRows;
+        // The range of the buffer.
+        size_t Offset;
+        size_t NumBytes;
+        // True for the last unit of a mip level. The mip level is resident
+        // when this unit has been copied.
+        bool CompletesMip;
+    };
+
+    uint64_t           m_Id;
+    StreamingPriority  m_Priority;
+    CompletionCallback m_CompletionCallback;
+
+    std::promise<bool>       m_Promise;
+    std::shared_future<bool> m_Future;
+
+    std::atomic<Status> m_Status;
+    std::atomic_bool    m_bCancelled;
+    std::atomic_int32_t m_MostDetailedResidentMip;
+    Clock::time_point   m_SubmitTime;
+
+    // Source data. Textures are either loaded from a file or provided as a scratch image.
+    std::wstring                           m_FileName;
+    bool                                   m_sRGB;
+    std::unique_ptr<DirectX::ScratchImage> m_ScratchImage;
+    std::vector<uint8_t>                   m_BufferData;
+
+    // The destination resource.
+    std::shared_ptr<Resource> m_Resource;
+    std::shared_ptr<Texture>  m_Texture;
+    mutable std::mutex        m_ResourceMutex;
+
+    // Upload units are only accessed by the streaming thread.
+    std::vector<UploadUnit> m_UploadUnits;
+    size_t                  m_NextUploadUnit;
+    size_t                  m_NumCompletedUploadUnits;
+};
+
+class StreamingUploadQueue
+{
+public:
+    // Latency buckets are powers of two in milliseconds: [0, 1), [1, 2), [2, 4), ... [2048, inf).
+    static constexpr size_t NumLatencyBuckets = 13;
+    using LatencyHistogram                    = std::array<uint64_t, NumLatencyBuckets>;
+
+    struct Statistics
+    {
+        // The number of requests that still have data that has not been recorded.
+        size_t QueueDepth = 0;
+        // The number of copy command lists that have not finished executing.
+        size_t NumBatchesInFlight = 0;
+
+        // The configured per-frame budget.
+        uint64_t FrameBudget = 0;
+        // The number of bytes recorded in the previous frame.
+        uint64_t BytesLastFrame = 0;
+        // The largest number of bytes recorded in a single frame.
+        uint64_t MaxBytesPerFrame = 0;
+        // The total number of bytes recorded.
+        uint64_t TotalBytes = 0;
+        // The number of frames that were counted.
+        uint64_t NumFrames = 0;
+
+        uint64_t NumCompleted = 0;
+        uint64_t NumCancelled = 0;
+        uint64_t NumFailed    = 0;
+
+        // Time from submitting a request until the first (smallest) mip level is resident.
+        LatencyHistogram FirstMipLatency = {};
+        // Time from submitting a request until the request is completed, per priority.
+        std::array<LatencyHistogram, static_cast<size_t>( StreamingPriority::NumPriorities )> CompletionLatency = {};
+
+        double GetAverageBytesPerFrame() const
+        {
+            return NumFrames > 0 ? static_cast<double>( TotalBytes ) / NumFrames : 0.0;
+        }
+    };
+
+    /**
+     * Stream a texture from a file. The file is loaded on the streaming thread.
+     * If the file does not contain a full mip chain, the mips are generated on
+     * the CPU so that the texture can be uploaded using only the copy queue.
+     */
+    std::shared_ptr<StreamingRequest>
+        RequestTexture( const std::wstring& fileName, bool sRGB = false,
+                        StreamingPriority                    priority           = StreamingPriority::Normal,
+                        StreamingRequest::CompletionCallback completionCallback = nullptr );
+
+    /**
+     * Stream the contents of a scratch image to a texture. The texture is
+     * created immediately and can be retrieved from the request.
+     */
+    std::shared_ptr<StreamingRequest>
+        RequestTexture( std::unique_ptr<DirectX::ScratchImage> scratchImage,
+                        StreamingPriority                      priority           = StreamingPriority::Normal,
+                        StreamingRequest::CompletionCallback   completionCallback = nullptr );
+
+    /**
+     * Stream data to an existing buffer.
+     */
+    std::shared_ptr<StreamingRequest>
+        RequestBuffer( const std::shared_ptr<Resource>& buffer, std::vector<uint8_t> bufferData,
+                       StreamingPriority                    priority           = StreamingPriority::Normal,
+                       StreamingRequest::CompletionCallback completionCallback = nullptr );
+
+    /**
+     * Cancel a request. This is the same as calling StreamingRequest::Cancel.
+     */
+    void Cancel( const std::shared_ptr<StreamingRequest>& request );
+
+    /**
+     * Start a new frame. This replenishes the frame budget and should be called
+     * once per frame (before or after presenting).
+     */
+    void BeginFrame();
+
+    /**
+     * Set the maximum number of bytes that can be recorded each frame.
+     * A single upload unit that is larger than the budget is still recorded
+     * (so that progress is made) but the excess is deducted from the budget
+     * of the following frames.
+     */
+    void SetFrameBudget( uint64_t frameBudget );
+
+    uint64_t GetFrameBudget() const;
+
+    /**
+     * Block until all requests that are currently queued are done.
+     */
+    void Flush();
+
+    Statistics GetStatistics() const;
+    void       ResetStatistics();
+
+protected:
+    friend class std::default_delete<StreamingUploadQueue>;
+
+    // Can only be created by the Device.
+    StreamingUploadQueue( Device& device, uint64_t frameBudget = _8MB );
+    virtual ~StreamingUploadQueue();
+
+private:
+    using RequestQueue = std::deque<std::shared_ptr<StreamingRequest>>;
+
+    // An upload unit that has been recorded to a command list.
+    struct RecordedUnit
+    {
+        std::shared_ptr<StreamingRequest> Request;
+        uint32_t                          MipLevel;
+        bool                              CompletesMip;
+    };
+
+    struct InFlightBatch
+    {
+        uint64_t                  FenceValue;
+        std::vector<RecordedUnit> RecordedUnits;
+    };
+
+    // Add a request to the queue for its priority.
+    std::shared_ptr<StreamingRequest> Enqueue( std::shared_ptr<StreamingRequest> request );
+
+    // Check to see if any of the request queues are not empty.
+    bool HasQueuedRequests() const;
+    // Check if there are no queued requests and no batches in flight.
+    bool IsIdle() const;
+
+    // The streaming thread's main loop.
+    void ProcessRequests();
+
+    // Get the highest priority request that still has upload units to record.
+    // Cancelled requests are removed from the queues and added to doneRequests.
+    std::shared_ptr<StreamingRequest> GetNextRequest( std::vector<std::shared_ptr<StreamingRequest>>& doneRequests );
+
+    // Remove a request from its queue.
+    void RemoveRequest( const std::shared_ptr<StreamingRequest>& request );
+
+    // Load the source data and create the destination resource (if needed) and split it into upload units.
+    void PrepareRequest( StreamingRequest& request );
+
+    // Record upload units to a copy command list until the frame budget is exhausted.
+    void RecordBatch( CommandQueue& commandQueue, std::vector<std::shared_ptr<StreamingRequest>>& doneRequests );
+
+    // Record a single upload unit.
+    void RecordUploadUnit( CommandList& commandList, StreamingRequest& request,
+                           const StreamingRequest::UploadUnit& uploadUnit );
+
+    // Retire batches that have finished executing on the copy queue.
+    void RetireBatches( CommandQueue& commandQueue, std::vector<std::shared_ptr<StreamingRequest>>& doneRequests );
+
+    // Resolve the promise and invoke the callback of a request that is done.
+    void FinishRequest( StreamingRequest& request, std::exception_ptr exception = nullptr );
+
+    static void RecordLatency( LatencyHistogram& histogram, StreamingRequest::Clock::duration latency );
+
+    // The device that was used to create this queue.
+    Device& m_Device;
+
+    std::array<RequestQueue, static_cast<size_t>( StreamingPriority::NumPriorities )> m_RequestQueues;
+    std::deque<InFlightBatch>                                                           m_InFlightBatches;
+    std::atomic_uint64_t                                                                m_NextRequestId;
+
+    // The per-frame budget and the number of bytes that may still be recorded
+    // in the current frame (this can become negative if a unit is larger than
+    // the remaining budget).
+    uint64_t m_FrameBudget;
+    int64_t  m_FrameBudgetRemaining;
+    uint64_t m_BytesThisFrame;
+    // The frame budget is ignored while a flush is in progress.
+    uint32_t m_NumFlushRequests;
+
+    Statistics m_Statistics;
+
+    std::thread             m_ProcessRequestsThread;
+    std::atomic_bool        m_bProcessRequests;
+    mutable std::mutex      m_Mutex;
+    std::condition_variable m_ProcessRequestsCV;
+    std::condition_variable m_RequestDoneCV;
+};
+}  // namespace dx12lib
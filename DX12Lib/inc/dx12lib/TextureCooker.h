@@ -0,0 +1,126 @@
+#pragma once
+
+/**
+ *  @file TextureCooker.h
+ *
+ *  @brief Converts source images to block compressed DDS files with a full mip chain.
+ *
+ *  Textures that are loaded from PNG, JPG, TGA or HDR files are uploaded
+ *  uncompressed and their mips are generated on the GPU. Cooking a texture
+ *  generates the mips on the CPU (with the MipGenerator) and compresses every mip to the BC format
+ *  that suits the way the texture is used:
+ *
+ *  | Usage  | Format                                           |
+ *  |--------|--------------------------------------------------|
+ *  | Albedo | BC7 (sRGB), BC1 or BC3 with FastCompression      |
+ *  | Normal | BC5 (X and Y, Z is reconstructed in the shader)  |
+ *  | Mask   | BC4 (the red channel)                            |
+ *  | HDR    | BC6H (unsigned)                                  |
+ *  | Bump   | BC4 for grayscale images, BC5 for normal maps    |
+ *
+ *  Cooked textures are cached on disk, keyed by a hash of the contents of the
+ *  source file and the cook settings, so a texture is only cooked the first
+ *  time it is loaded (or after the source file has changed).
+ *
+ *  DirectXTex compresses a single image on a single thread (it is built
+ *  without OpenMP), so each mip is split into strips of block rows that are
+ *  compressed in parallel.
+ */
+
+#include "MipGenerator.h"
+
+#include <dxgiformat.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace dx12lib
+{
+
+enum class TextureUsage
+{
+    Albedo,  // Color texture (diffuse, specular, emissive...) that is sampled as sRGB.
+    Normal,  // Tangent space normal map.
+    Mask,    // Single channel linear texture (opacity, roughness, specular power...).
+    HDR,     // High dynamic range color texture.
+    Bump,    // Height map or normal map (materials often store normal maps in the bump slot).
+};
+
+struct TextureCookSettings
+{
+    // Use BC1/BC3 instead of BC7 for albedo textures. BC7 is much slower to
+    // compress (and BC1 is half the size) at the cost of quality.
+    bool FastCompression = false;
+    // The number of threads that compress a texture (0 to use all hardware threads).
+    uint32_t NumThreads = 0;
+    // The filter that is used to generate the mips (see MipGenerator). Mips
+    // are only generated once per texture, so the sharper filter is the default.
+    MipFilter Filter = MipFilter::Kaiser;
+};
+
+class TextureCooker
+{
+public:
+    struct Statistics
+    {
+        uint64_t NumTexturesCooked = 0;
+        // Requests for textures that were already in the cache.
+        uint64_t NumCacheHits = 0;
+        // Requests for textures that were already block compressed (these are not cooked).
+        uint64_t NumPassThrough = 0;
+        // Total size of the uncompressed textures (with mips) and of the cooked textures.
+        uint64_t NumSourceBytes = 0;
+        uint64_t NumCookedBytes = 0;
+        // Total time (in milliseconds) spent cooking textures and the part of it
+        // that was spent generating mips and compressing.
+        double CookTime     = 0.0;
+        double MipTime      = 0.0;
+        double CompressTime = 0.0;
+    };
+
+    /**
+     * @param cacheDirectory The directory to store cooked textures in. It is
+     * created if it does not exist.
+     */
+    explicit TextureCooker( const std::wstring& cacheDirectory, const TextureCookSettings& settings = {} );
+
+    /**
+     * Get the cooked version of a texture, cooking it if it is not in the
+     * cache yet. Returns the path of a DDS file with a full mip chain. DDS files
+     * that are already block compressed are returned as is.
+     * Cooked textures are written to a temporary file that is renamed when it
+     * is complete, so the same texture can be cooked on multiple threads.
+     */
+    std::wstring Cook( const std::wstring& fileName, TextureUsage usage );
+
+    /**
+     * Get the format that a texture is compressed to.
+     *
+     * @param hasAlpha Whether the texture has alpha that is not fully opaque.
+     * @param isGrayscale Whether the texture has a single channel (for bump maps).
+     */
+    DXGI_FORMAT GetCookedFormat( TextureUsage usage, bool hasAlpha, bool isGrayscale ) const;
+
+    const std::wstring& GetCacheDirectory() const
+    {
+        return m_CacheDirectory;
+    }
+
+    const TextureCookSettings& GetSettings() const
+    {
+        return m_Settings;
+    }
+
+    Statistics GetStatistics() const;
+    void       ResetStatistics();
+
+private:
+    std::wstring        m_CacheDirectory;
+    TextureCookSettings m_Settings;
+
+    mutable std::mutex m_StatisticsMutex;
+    Statistics         m_Statistics;
+};
+
+}  // namespace dx12lib
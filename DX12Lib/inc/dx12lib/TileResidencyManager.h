@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ *  @file TileResidencyManager.h
+ *
+ *  @brief CPU-side page table and residency manager for tiled (virtual) textures.
+ *
+ *  The residency manager does not depend on Direct3D. It consumes tile requests
+ *  (decoded from a feedback buffer or generated on the CPU), keeps track of
+ *  which virtual tiles are mapped to which physical tiles of a fixed size tile
+ *  pool and decides which tiles to map and which tiles to evict each frame
+ *  using a least-recently-used policy. This makes it possible to exercise the
+ *  eviction policy with synthetic access traces.
+ *
+ *  Evicted tiles are removed from the residency map immediately but their
+ *  physical tiles are only reused (and reported as unmapped) after a number of
+ *  frames so that frames that are still in flight on the GPU can continue to
+ *  sample them.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace dx12lib
+{
+
+/**
+ * Identifies a single tile of a standard (non-packed) mip level of a virtual texture.
+ */
+struct TileCoord
+{
+    uint32_t TextureId;
+    uint32_t MipLevel;
+    uint32_t X;
+    uint32_t Y;
+
+    /**
+     * Pack the tile coordinate into a 64-bit key.
+     * Layout: | TextureId (24 bits) | MipLevel (8 bits) | Y (16 bits) | X (16 bits) |
+     */
+    uint64_t Pack() const
+    {
+        return ( static_cast<uint64_t>( TextureId & 0xffffff ) << 40 ) |
+               ( static_cast<uint64_t>( MipLevel & 0xff ) << 32 ) | ( static_cast<uint64_t>( Y & 0xffff ) << 16 ) |
+               static_cast<uint64_t>( X & 0xffff );
+    }
+
+    static TileCoord Unpack( uint64_t key )
+    {
+        TileCoord tile;
+        tile.TextureId = static_cast<uint32_t>( ( key >> 40 ) & 0xffffff );
+        tile.MipLevel  = static_cast<uint32_t>( ( key >> 32 ) & 0xff );
+        tile.Y         = static_cast<uint32_t>( ( key >> 16 ) & 0xffff );
+        tile.X         = static_cast<uint32_t>( key & 0xffff );
+
+        return tile;
+    }
+
+    bool operator==( const TileCoord& other ) const
+    {
+        return Pack() == other.Pack();
+    }
+};
+
+class TileResidencyManager
+{
+public:
+    // The size of a standard mip level in tiles.
+    struct MipTiling
+    {
+        uint32_t WidthInTiles;
+        uint32_t HeightInTiles;
+    };
+
+    // A virtual tile that is mapped to a physical tile in the tile pool.
+    struct TileMapping
+    {
+        TileCoord Tile;
+        uint32_t  PhysicalTile;
+    };
+
+    // The result of processing the requests of a frame.
+    struct ResidencyUpdate
+    {
+        // Tiles that need to be mapped and filled, least detailed mips first.
+        std::vector<TileMapping> MappedTiles;
+        // Tiles that should be unmapped. Their physical tiles are free for reuse.
+        std::vector<TileMapping> UnmappedTiles;
+        // Textures whose residency map has changed.
+        std::vector<uint32_t> DirtyTextures;
+    };
+
+    struct Statistics
+    {
+        uint32_t NumPhysicalTiles = 0;
+        uint32_t NumReservedTiles = 0;
+        uint32_t NumResidentTiles = 0;
+
+        // Unique tile requests (including the implied requests for less detailed mips).
+        uint64_t NumRequests = 0;
+        // Requests for tiles that were already resident.
+        uint64_t NumHits = 0;
+        // Requests for tiles that were not resident.
+        uint64_t NumMisses = 0;
+        uint64_t NumMapped = 0;
+        uint64_t NumEvicted = 0;
+        // Misses that could not be serviced this frame (update limit reached or no tile could be evicted).
+        uint64_t NumDeferred = 0;
+
+        double GetHitRate() const
+        {
+            return NumRequests > 0 ? static_cast<double>( NumHits ) / NumRequests : 0.0;
+        }
+    };
+
+    /**
+     * @param numPhysicalTiles The number of tiles in the tile pool.
+     * @param maxTilesPerUpdate The maximum number of tiles that are mapped each frame.
+     * @param evictionDelay The number of frames before an evicted physical tile is reused.
+     * This should be at least the number of frames that can be in flight.
+     */
+    explicit TileResidencyManager( uint32_t numPhysicalTiles, uint32_t maxTilesPerUpdate = 64,
+                                   uint32_t evictionDelay = 3 );
+
+    /**
+     * Register a texture with the residency manager.
+     *
+     * @param mipTiling The size in tiles of each standard mip level (most detailed first).
+     * @returns The ID of the texture.
+     */
+    uint32_t RegisterTexture( const std::vector<MipTiling>& mipTiling );
+
+    /**
+     * Evict all of the tiles of a texture. Texture IDs are not reused so that
+     * pending unmaps can never refer to a different texture.
+     */
+    void UnregisterTexture( uint32_t textureId, uint64_t frameIndex );
+
+    /**
+     * Reserve physical tiles that are never evicted (for example, for packed mips).
+     * Throws std::bad_alloc if there are not enough free tiles.
+     */
+    std::vector<uint32_t> ReservePhysicalTiles( uint32_t numTiles );
+
+    /**
+     * Return reserved tiles to the tile pool. The tiles are reused after the eviction delay.
+     */
+    void ReleasePhysicalTiles( const std::vector<uint32_t>& physicalTiles, uint64_t frameIndex );
+
+    /**
+     * Request a tile to be resident. Requests are accumulated until the next
+     * call to ProcessRequests.
+     */
+    void RequestTile( const TileCoord& tile );
+    void RequestTiles( const uint64_t* packedTiles, size_t numTiles );
+
+    /**
+     * Process the tile requests for a frame. Requests implicitly include the
+     * less detailed mips of the requested tiles so that a fallback is always
+     * resident.
+     */
+    ResidencyUpdate ProcessRequests( uint64_t frameIndex );
+
+    bool IsResident( const TileCoord& tile ) const;
+
+    /**
+     * Get the residency map of a texture. The residency map contains an entry
+     * for each tile of the most detailed mip and stores the most detailed mip
+     * that is resident for that region. If no standard mip is resident for a
+     * region, the entry is the number of standard mips (the packed mips).
+     */
+    const std::vector<uint8_t>& GetResidencyMap( uint32_t textureId ) const;
+
+    const std::vector<MipTiling>& GetMipTiling( uint32_t textureId ) const;
+
+    Statistics GetStatistics() const;
+    void       ResetStatistics();
+
+private:
+    using LRUList = std::list<uint64_t>;
+
+    struct ResidentTile
+    {
+        uint32_t          PhysicalTile;
+        uint64_t          LastUsedFrame;
+        LRUList::iterator LRUIterator;
+    };
+
+    struct PendingFreeTile
+    {
+        TileMapping Mapping;
+        uint64_t    EvictedFrame;
+        // Reserved tiles are not reported as unmapped tiles.
+        bool IsReserved;
+    };
+
+    struct TextureInfo
+    {
+        std::vector<MipTiling> Mips;
+        std::vector<uint8_t>   ResidencyMap;
+        bool                   IsRegistered;
+        bool                   IsDirty;
+    };
+
+    // Get the tile of a less detailed mip that covers the given tile.
+    TileCoord GetParentTile( const TileCoord& tile ) const;
+
+    // Check to see if a tile coordinate refers to a valid tile of a registered texture.
+    bool IsValidTile( const TileCoord& tile ) const;
+
+    // Evict the least recently used tile if it was not used in the current frame.
+    bool EvictLeastRecentlyUsed( uint64_t frameIndex );
+
+    void EvictTile( uint64_t key, uint64_t frameIndex );
+
+    void MarkDirty( uint32_t textureId );
+
+    void UpdateResidencyMap( uint32_t textureId );
+
+    uint32_t m_NumPhysicalTiles;
+    uint32_t m_MaxTilesPerUpdate;
+    uint32_t m_EvictionDelay;
+
+    std::vector<TextureInfo> m_Textures;
+
+    // The page table: resident virtual tiles (by packed tile coordinate).
+    std::unordered_map<uint64_t, ResidentTile> m_ResidentTiles;
+    // Resident tiles ordered from most recently used to least recently used.
+    LRUList m_LRU;
+
+    std::vector<uint32_t>       m_FreeTiles;
+    std::deque<PendingFreeTile> m_PendingFreeTiles;
+
+    std::vector<uint64_t> m_Requests;
+    std::vector<uint32_t> m_DirtyTextures;
+
+    Statistics m_Statistics;
+};
+}  // namespace dx12lib
@@ -0,0 +1,207 @@
+#pragma once
+
+/**
+ *  @file TiledImage.h
+ *
+ *  @brief Lazy reader for tiled, mip-mapped OpenEXR images.
+ *
+ *  Only the header and the chunk offset table are read when an image is
+ *  opened. Pixels are decoded on demand one chunk (a tile or a block of
+ *  scanlines) at a time, so reading a low resolution mip of a very large image
+ *  only touches the chunks of that mip.
+ *
+ *  Images that are not tiled and mip-mapped (Radiance .hdr files and scanline
+ *  or single level .exr files) are converted to a tiled mip pyramid which is
+ *  cached next to the source file (see TiledImage::Open). The pyramid is built
+ *  by streaming the source one band of scanlines at a time so the full
+ *  resolution image is never held in memory.
+ *
+ *  Supported compression methods are NONE, RLE, ZIPS and ZIP. Pixels are
+ *  returned as RGBA in DXGI_FORMAT_R16G16B16A16_FLOAT if all of the color
+ *  channels are half floats, and in DXGI_FORMAT_R32G32B32A32_FLOAT otherwise.
+ */
+
+#include <dxgiformat.h>
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dx12lib
+{
+
+class TiledImage
+{
+public:
+    static constexpr uint32_t DefaultTileSize = 256;
+
+    /**
+     * Open an image for lazy loading.
+     * Tiled EXR files with a full mip chain are opened directly. For any other
+     * image, a tiled mip pyramid is built on first use (see GetPyramidFileName)
+     * and reused as long as it is newer than the source file.
+     */
+    static std::unique_ptr<TiledImage> Open( const std::wstring& fileName );
+
+    /**
+     * Get the name of the cached mip pyramid of a source image.
+     */
+    static std::wstring GetPyramidFileName( const std::wstring& fileName );
+
+    /**
+     * Convert a Radiance .hdr or an EXR file to a tiled, mip-mapped EXR file
+     * with half float channels. Mips are box filtered.
+     * ZIP compression makes the pyramid 2-3 times smaller but building it
+     * (which is on the critical path of the first load) about 4 times slower,
+     * so the cached pyramids are not compressed.
+     */
+    static void BuildPyramid( const std::wstring& sourceFileName, const std::wstring& pyramidFileName,
+                              uint32_t tileSize = DefaultTileSize, bool compress = false );
+
+    /**
+     * Open an EXR file. Throws if the file is not a (single part, flat) EXR file.
+     */
+    explicit TiledImage( const std::wstring& fileName );
+    ~TiledImage();
+
+    uint32_t GetWidth( uint32_t mip = 0 ) const
+    {
+        return m_Levels[mip].Width;
+    }
+
+    uint32_t GetHeight( uint32_t mip = 0 ) const
+    {
+        return m_Levels[mip].Height;
+    }
+
+    uint32_t GetNumMips() const
+    {
+        return static_cast<uint32_t>( m_Levels.size() );
+    }
+
+    /**
+     * Check to see if the image is tiled. Scanline images are read one block
+     * of scanlines at a time (the tile width is the width of the image).
+     */
+    bool IsTiled() const
+    {
+        return m_IsTiled;
+    }
+
+    /**
+     * Check to see if the mip levels have the same sizes as the mips of a
+     * Direct3D texture (the EXR level sizes are rounded down).
+     */
+    bool HasFullMipChain() const;
+
+    uint32_t GetTileWidth() const
+    {
+        return m_TileWidth;
+    }
+
+    uint32_t GetTileHeight() const
+    {
+        return m_TileHeight;
+    }
+
+    /**
+     * Get the format that pixels are returned in (RGBA half or float).
+     */
+    DXGI_FORMAT GetFormat() const
+    {
+        return m_Format;
+    }
+
+    size_t GetTexelSize() const
+    {
+        return m_Format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 16;
+    }
+
+    bool HasAlpha() const
+    {
+        return ( m_ComponentMask & 0x8 ) != 0;
+    }
+
+    /**
+     * Get the most detailed mip whose width and height are not larger than
+     * maxSize. If maxSize is 0, the first mip is returned.
+     */
+    uint32_t GetMostDetailedMip( uint32_t maxSize ) const;
+
+    /**
+     * Decode a region of a mip level to RGBA texels (see GetFormat).
+     * Only the chunks that overlap the region are read and decompressed.
+     * Channels that are not in the file are set to 0 (or 1 for alpha). A
+     * luminance (Y) channel is written to the red, green and blue components.
+     */
+    void ReadRegion( uint32_t mip, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* dst,
+                     size_t rowPitch ) const;
+
+    /**
+     * The number of bytes read from the file and the number of chunks that
+     * were decompressed since the image was opened.
+     */
+    uint64_t GetNumBytesRead() const
+    {
+        return m_NumBytesRead;
+    }
+
+    uint64_t GetNumChunksDecoded() const
+    {
+        return m_NumChunksDecoded;
+    }
+
+private:
+    struct Channel
+    {
+        std::string Name;
+        uint32_t    PixelType;  // 0 = uint, 1 = half, 2 = float (the EXR pixel types).
+        uint32_t    SampleSize;
+        int32_t     Component;  // 0-3 for R, G, B, A; 4 for Y; -1 if the channel is ignored.
+    };
+
+    struct Level
+    {
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t NumTilesX;
+        uint32_t NumTilesY;
+        size_t   FirstChunk;
+    };
+
+    void ReadHeader();
+
+    // Read and decompress a chunk to m_ChunkData, returns the number of rows in the chunk.
+    uint32_t DecodeChunk( uint32_t mip, uint32_t tileX, uint32_t tileY ) const;
+
+    std::wstring          m_FileName;
+    mutable std::ifstream m_File;
+    uint64_t              m_FileSize;
+
+    int32_t              m_DataWindowX;
+    int32_t              m_DataWindowY;
+    uint32_t             m_Compression;
+    std::vector<Channel> m_Channels;
+    bool                 m_IsTiled;
+    bool                 m_RoundUp;
+    uint32_t             m_TileWidth;
+    uint32_t             m_TileHeight;
+    DXGI_FORMAT          m_Format;
+    uint32_t             m_ComponentMask;  // The RGBA components that are in the file.
+    bool                 m_IsLuminance;
+
+    std::vector<Level>    m_Levels;
+    std::vector<uint64_t> m_ChunkOffsets;
+
+    // Reads are serialized, the scratch buffers are reused for every chunk.
+    mutable std::mutex           m_Mutex;
+    mutable std::vector<uint8_t> m_PackedData;
+    mutable std::vector<uint8_t> m_ChunkData;
+    mutable uint64_t             m_NumBytesRead;
+    mutable uint64_t             m_NumChunksDecoded;
+};
+
+}  // namespace dx12lib
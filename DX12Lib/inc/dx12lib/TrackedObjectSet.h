@@ -0,0 +1,169 @@
+#pragma once
+
+/**
+ *  @file TrackedObjectSet.h
+ *
+ *  @brief A set of D3D12 objects that are referenced by a command list.
+ *
+ *  Objects that are used by a command list must not be destroyed until the
+ *  command list has finished executing on the command queue. The set holds a
+ *  single reference to every distinct object that is added to it, no matter
+ *  how many times it is added. Objects are looked up by pointer in an
+ *  open-addressed hash table so adding an object that is already in the set
+ *  does not modify its reference count.
+ *
+ *  Each slot in the hash table is stamped with the generation in which it was
+ *  written. Clearing the set releases the references and increments the
+ *  generation which invalidates all slots without touching the hash table.
+ */
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace dx12lib
+{
+
+class TrackedObjectSet
+{
+public:
+    /**
+     * @param initialCapacity The initial number of slots in the hash table
+     * (rounded up to a power of 2).
+     */
+    explicit TrackedObjectSet( size_t initialCapacity = 512 )
+    : m_Generation( 1 )
+    {
+        size_t capacity = 16;
+        while ( capacity < initialCapacity )
+        {
+            capacity *= 2;
+        }
+
+        m_Slots.resize( capacity );
+        m_Objects.reserve( capacity / 2 );
+    }
+
+    /**
+     * Add an object to the set.
+     *
+     * @returns true if the object was not already in the set.
+     */
+    bool Insert( ID3D12Object* object )
+    {
+        if ( !object )
+        {
+            return false;
+        }
+
+        size_t mask = m_Slots.size() - 1;
+        for ( size_t i = Hash( object ) & mask;; i = ( i + 1 ) & mask )
+        {
+            Slot& slot = m_Slots[i];
+            if ( slot.Generation != m_Generation )
+            {
+                slot.Object     = object;
+                slot.Generation = m_Generation;
+                m_Objects.emplace_back( object );
+
+                // Keep the load factor below 0.5 so probe sequences stay short.
+                if ( m_Objects.size() * 2 > m_Slots.size() )
+                {
+                    Grow();
+                }
+
+                return true;
+            }
+            if ( slot.Object == object )
+            {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * Check to see if an object is in the set.
+     */
+    bool Contains( ID3D12Object* object ) const
+    {
+        size_t mask = m_Slots.size() - 1;
+        for ( size_t i = Hash( object ) & mask;; i = ( i + 1 ) & mask )
+        {
+            const Slot& slot = m_Slots[i];
+            if ( slot.Generation != m_Generation )
+            {
+                return false;
+            }
+            if ( slot.Object == object )
+            {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Release all of the objects in the set.
+     */
+    void Clear()
+    {
+        m_Objects.clear();
+
+        // Slots that were written in a previous generation are considered empty.
+        if ( ++m_Generation == 0 )
+        {
+            // The generation wrapped around. Slots from a very old generation could
+            // appear to be valid so all slots need to be reset.
+            std::fill( m_Slots.begin(), m_Slots.end(), Slot() );
+            m_Generation = 1;
+        }
+    }
+
+    size_t Size() const
+    {
+        return m_Objects.size();
+    }
+
+private:
+    struct Slot
+    {
+        ID3D12Object* Object     = nullptr;
+        uint32_t      Generation = 0;
+    };
+
+    static size_t Hash( ID3D12Object* object )
+    {
+        // Objects are at least 16-byte aligned. Fibonacci hashing distributes
+        // the remaining bits across the table.
+        uint64_t key = reinterpret_cast<uintptr_t>( object ) >> 4;
+        return static_cast<size_t>( ( key * 11400714819323198485ull ) >> 32 );
+    }
+
+    // Double the size of the hash table and reinsert the objects.
+    void Grow()
+    {
+        m_Slots.assign( m_Slots.size() * 2, Slot() );
+        m_Generation = 1;
+
+        size_t mask = m_Slots.size() - 1;
+        for ( auto& object: m_Objects )
+        {
+            size_t i = Hash( object.Get() ) & mask;
+            while ( m_Slots[i].Generation == m_Generation )
+            {
+                i = ( i + 1 ) & mask;
+            }
+
+            m_Slots[i].Object     = object.Get();
+            m_Slots[i].Generation = m_Generation;
+        }
+    }
+
+    std::vector<Slot> m_Slots;
+    // Holds a reference to each object in the set.
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Object>> m_Objects;
+    uint32_t                                          m_Generation;
+};
+}  // namespace dx12lib
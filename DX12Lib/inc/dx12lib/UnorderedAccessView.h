@@ -59,6 +59,15 @@ public:
         return m_Descriptor.GetDescriptorHandle();
     }
 
+    /**
+     * Get the description that was used to create the view (or nullptr if the
+     * view was created with the default description of the resource).
+     */
+    const D3D12_UNORDERED_ACCESS_VIEW_DESC* GetUnorderedAccessViewDesc() const
+    {
+        return m_Desc.get();
+    }
+
 protected:
     UnorderedAccessView( Device& device, const std::shared_ptr<Resource>& resource,
                          const std::shared_ptr<Resource>&        counterResource = nullptr,
@@ -70,5 +79,7 @@ private:
     std::shared_ptr<Resource> m_Resource;
     std::shared_ptr<Resource> m_CounterResource;
     DescriptorAllocation      m_Descriptor;
+
+    std::unique_ptr<D3D12_UNORDERED_ACCESS_VIEW_DESC> m_Desc;
 };
 }  // namespace dx12lib
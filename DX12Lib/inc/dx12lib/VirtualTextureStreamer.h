@@ -0,0 +1,185 @@
+#pragma once
+
+/**
+ *  @file VirtualTextureStreamer.h
+ *
+ *  @brief Streams the tiles of reserved (tiled) textures into a fixed size tile
+ *  pool based on tile requests.
+ *
+ *  Each virtual texture is a reserved resource. Its packed mips are always
+ *  resident; the tiles of the standard mips are mapped into a shared tile pool
+ *  (an ID3D12Heap sized by the memory budget) by the TileResidencyManager when
+ *  they are requested and evicted when the pool is full.
+ *
+ *  Every frame:
+ *  1. Tile requests are added (decoded from a feedback buffer or generated on
+ *     the CPU using RequestRegion).
+ *  2. Update maps/unmaps tiles and uploads the tile data on the copy queue. The
+ *     direct queue is made to wait for the uploads.
+ *  3. UpdateResidencyMaps uploads the residency maps that changed on the
+ *     command list that renders the virtual textures. The residency map
+ *     (an R8_UINT texture with one texel per tile of the most detailed mip)
+ *     should be used to clamp the sampled LOD in the shader.
+ *
+ *  The source texture data is kept in CPU memory.
+ */
+
+#include "TileResidencyManager.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DirectX
+{
+class ScratchImage;
+}
+
+namespace dx12lib
+{
+
+class CommandList;
+class Device;
+class Texture;
+
+class VirtualTexture
+{
+public:
+    uint32_t GetId() const
+    {
+        return m_Id;
+    }
+
+    /**
+     * Get the reserved texture.
+     */
+    std::shared_ptr<Texture> GetTexture() const
+    {
+        return m_Texture;
+    }
+
+    /**
+     * Get the residency map texture (R8_UINT).
+     */
+    std::shared_ptr<Texture> GetResidencyMap() const
+    {
+        return m_ResidencyMap;
+    }
+
+    const D3D12_TILE_SHAPE& GetTileShape() const
+    {
+        return m_TileShape;
+    }
+
+    uint32_t GetNumStandardMips() const
+    {
+        return m_NumStandardMips;
+    }
+
+protected:
+    friend class VirtualTextureStreamer;
+    friend class std::default_delete<VirtualTexture>;
+
+    VirtualTexture();
+    virtual ~VirtualTexture();
+
+private:
+    uint32_t                               m_Id;
+    std::shared_ptr<Texture>               m_Texture;
+    std::shared_ptr<Texture>               m_ResidencyMap;
+    std::unique_ptr<DirectX::ScratchImage> m_SourceImage;
+
+    D3D12_TILE_SHAPE                      m_TileShape;
+    uint32_t                              m_NumStandardMips;
+    std::vector<D3D12_SUBRESOURCE_TILING> m_SubresourceTiling;
+    D3D12_PACKED_MIP_INFO                 m_PackedMipInfo;
+
+    // Physical tiles that are reserved for the packed mips.
+    std::vector<uint32_t> m_PackedTiles;
+};
+
+class VirtualTextureStreamer
+{
+public:
+    /**
+     * Create a virtual texture from a 2D (non-array) image. If the image does
+     * not have a full mip chain, the mips are generated on the CPU.
+     */
+    std::shared_ptr<VirtualTexture> CreateVirtualTexture( std::unique_ptr<DirectX::ScratchImage> image );
+
+    /**
+     * Release a virtual texture. Its tiles are returned to the tile pool.
+     */
+    void DestroyVirtualTexture( const std::shared_ptr<VirtualTexture>& virtualTexture );
+
+    /**
+     * Request tiles to be resident. The packed requests use the layout of TileCoord::Pack.
+     */
+    void RequestTile( const TileCoord& tile );
+    void RequestTiles( const uint64_t* packedTiles, size_t numTiles );
+
+    /**
+     * Request the tiles of a mip level that cover a region (in normalized texture coordinates).
+     */
+    void RequestRegion( const VirtualTexture& virtualTexture, uint32_t mipLevel, float u0, float v0, float u1,
+                        float v1 );
+
+    /**
+     * Process the tile requests and upload the data of the newly mapped tiles
+     * on the copy queue.
+     */
+    void Update( uint64_t frameIndex );
+
+    /**
+     * Upload the residency maps that have changed since the last call.
+     */
+    void UpdateResidencyMaps( CommandList& commandList );
+
+    /**
+     * The size of the tile pool in bytes.
+     */
+    uint64_t GetTilePoolSize() const
+    {
+        return m_TilePoolSize;
+    }
+
+    TileResidencyManager::Statistics GetStatistics() const;
+
+    /**
+     * The number of bytes of tile data that have been uploaded.
+     */
+    uint64_t GetNumBytesUploaded() const;
+
+protected:
+    friend class std::default_delete<VirtualTextureStreamer>;
+
+    // Can only be created by the Device.
+    VirtualTextureStreamer( Device& device, uint64_t tilePoolSize, uint32_t maxTilesPerUpdate );
+    virtual ~VirtualTextureStreamer();
+
+private:
+    // Map a set of tiles of a virtual texture to the tile pool (or unmap them).
+    void UpdateTileMappings( const VirtualTexture& virtualTexture,
+                             const std::vector<TileResidencyManager::TileMapping>& tileMappings, bool map );
+
+    // Copy the data of a tile from the source image to the texture.
+    void CopyTile( CommandList& commandList, const VirtualTexture& virtualTexture, const TileCoord& tile );
+
+    Device& m_Device;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_TilePool;
+    uint64_t                           m_TilePoolSize;
+
+    TileResidencyManager                         m_ResidencyManager;
+    std::vector<std::shared_ptr<VirtualTexture>> m_VirtualTextures;
+    std::vector<uint32_t>                        m_DirtyResidencyMaps;
+
+    uint64_t m_FrameIndex;
+    uint64_t m_NumBytesUploaded;
+
+    mutable std::mutex m_Mutex;
+};
+}  // namespace dx12lib
@@ -12,10 +12,12 @@
 #include "App.h"
 #include "Exceptions.h"
 #include "Graphics\\Profiler.h"
+#include "Graphics\\ShaderCompilation.h"
 #include "Graphics\\Spectrum.h"
 #include "SF12_Math.h"
 #include "FileIO.h"
 #include "Settings.h"
+#include "Tasks.h"
 #include "ImGuiHelper.h"
 #include "ImGui/imgui.h"
 
@@ -177,6 +179,10 @@ void App::Initialize_Internal()
     if(showWindow)
         window.ShowWindow();
 
+    // The shaders that are requested during initialization are compiled in parallel, their
+    // byte code isn't read before the PSOs are created
+    BeginShaderBatch();
+
     // Create a font + SpriteRenderer
     font.Initialize(L"Consolas", 18, SpriteFont::Regular, true);
     spriteRenderer.Initialize();
@@ -191,6 +197,8 @@ void App::Initialize_Internal()
     AppSettings::Initialize();
 
     Initialize();
+
+    EndShaderBatch();
 }
 
 void App::Shutdown_Internal()
@@ -208,6 +216,7 @@ void App::Shutdown_Internal()
 
     Shutdown();
 
+    ShutdownTaskScheduler();
     DX12::Shutdown();
 }
 
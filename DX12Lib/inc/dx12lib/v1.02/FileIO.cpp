@@ -230,6 +230,15 @@ void File::Write(uint64 size, const void* data) const
     Win32Call(WriteFile(fileHandle, data, static_cast<DWORD>(size), &bytesWritten, NULL));
 }
 
+void File::Seek(uint64 position) const
+{
+    Assert_(fileHandle != INVALID_HANDLE_VALUE);
+
+    LARGE_INTEGER filePosition;
+    filePosition.QuadPart = position;
+    Win32Call(SetFilePointerEx(fileHandle, filePosition, NULL, FILE_BEGIN));
+}
+
 uint64 File::Size() const
 {
     Assert_(fileHandle != INVALID_HANDLE_VALUE);
@@ -240,4 +249,74 @@ uint64 File::Size() const
     return fileSize.QuadPart;
 }
 
+// == MappedFile ==================================================================================
+
+MappedFile::MappedFile() : fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL), data(nullptr), size(0)
+{
+}
+
+MappedFile::MappedFile(const wchar* filePath) : fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL),
+                                                data(nullptr), size(0)
+{
+    Open(filePath);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+    Assert_(fileHandle == INVALID_HANDLE_VALUE);
+}
+
+void MappedFile::Open(const wchar* filePath)
+{
+    Assert_(fileHandle == INVALID_HANDLE_VALUE);
+    Assert_(FileExists(filePath));
+
+    fileHandle = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    LARGE_INTEGER fileSize;
+    Win32Call(GetFileSizeEx(fileHandle, &fileSize));
+    size = fileSize.QuadPart;
+
+    // Empty files can't be mapped
+    if(size == 0)
+        return;
+
+    mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mappingHandle == NULL)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to map file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+
+    data = reinterpret_cast<const uint8*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(data == nullptr)
+    {
+        std::wstring errPrefix = std::wstring(L"Failed to map file ") + filePath + L":\n";
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+    }
+}
+
+void MappedFile::Close()
+{
+    if(data != nullptr)
+        Win32Call(UnmapViewOfFile(data));
+    data = nullptr;
+
+    if(mappingHandle != NULL)
+        Win32Call(CloseHandle(mappingHandle));
+    mappingHandle = NULL;
+
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        Win32Call(CloseHandle(fileHandle));
+    fileHandle = INVALID_HANDLE_VALUE;
+
+    size = 0;
+}
+
 }
\ No newline at end of file
@@ -66,10 +66,40 @@ public:
     template<typename T> void Read(T& data) const;
     template<typename T> void Write(const T& data) const;
 
+    void Seek(uint64 position) const;
+
     // Accessors
     uint64 Size() const;
 };
 
+// Read-only view of a whole file, mapped into the address space of the process
+class MappedFile
+{
+
+private:
+
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+    const uint8* data;
+    uint64 size;
+
+public:
+
+    // Lifetime
+    MappedFile();
+    MappedFile(const wchar* filePath);
+    ~MappedFile();
+
+    // Explicit Open and close
+    void Open(const wchar* filePath);
+    void Close();
+
+    // Accessors
+    const uint8* Data() const { return data; }
+    uint64 Size() const { return size; }
+    bool IsOpen() const { return data != nullptr; }
+};
+
 // == File ========================================================================================
 
 template<typename T> void File::Read(T& data) const
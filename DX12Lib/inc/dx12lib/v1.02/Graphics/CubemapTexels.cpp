@@ -0,0 +1,123 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+#include "Textures.h"
+
+// The cubemap texel directions and weights don't depend on D3D12, so they're kept out of Textures.cpp
+
+namespace SampleFramework12
+{
+
+// Utility function to map a XY + Side coordinate to a direction vector
+Float3 MapXYSToDirection(uint64 x, uint64 y, uint64 s, uint64 width, uint64 height)
+{
+    float u = ((x + 0.5f) / float(width)) * 2.0f - 1.0f;
+    float v = ((y + 0.5f) / float(height)) * 2.0f - 1.0f;
+    v *= -1.0f;
+
+    Float3 dir = Float3(0.0f);
+
+    // +x, -x, +y, -y, +z, -z
+    switch(s) {
+    case 0:
+        dir = Float3::Normalize(Float3(1.0f, v, -u));
+        break;
+    case 1:
+        dir = Float3::Normalize(Float3(-1.0f, v, u));
+        break;
+    case 2:
+        dir = Float3::Normalize(Float3(u, 1.0f, -v));
+        break;
+    case 3:
+        dir = Float3::Normalize(Float3(u, -1.0f, v));
+        break;
+    case 4:
+        dir = Float3::Normalize(Float3(u, v, 1.0f));
+        break;
+    case 5:
+        dir = Float3::Normalize(Float3(-u, v, -1.0f));
+        break;
+    }
+
+    return dir;
+}
+
+static std::vector<std::unique_ptr<CubemapTexelTable>> CubemapTexelTables;
+static SRWLOCK CubemapTexelTablesLock = SRWLOCK_INIT;
+
+static void BuildCubemapTexelTable(CubemapTexelTable& table, uint32 width, uint32 height)
+{
+    table.Width = width;
+    table.Height = height;
+    table.NumTexels = uint64(width) * height * 6;
+    table.DirX.Init(table.NumTexels);
+    table.DirY.Init(table.NumTexels);
+    table.DirZ.Init(table.NumTexels);
+    table.Weights.Init(table.NumTexels);
+
+    // Summed in double precision, the float sum drifts with millions of texels
+    double weightSum = 0.0;
+    for(uint32 face = 0; face < 6; ++face)
+    {
+        for(uint32 y = 0; y < height; ++y)
+        {
+            for(uint32 x = 0; x < width; ++x)
+            {
+                const uint64 idx = face * (uint64(width) * height) + y * uint64(width) + x;
+
+                const Float3 dir = MapXYSToDirection(x, y, face, width, height);
+                table.DirX[idx] = dir.x;
+                table.DirY[idx] = dir.y;
+                table.DirZ[idx] = dir.z;
+
+                // Account for cubemap texel distribution
+                const float u = ((x + 0.5f) / width) * 2.0f - 1.0f;
+                const float v = ((y + 0.5f) / height) * 2.0f - 1.0f;
+                const float temp = 1.0f + u * u + v * v;
+                const float weight = 4.0f / (sqrt(temp) * temp);
+                table.Weights[idx] = weight;
+                weightSum += weight;
+            }
+        }
+    }
+
+    table.WeightSum = float(weightSum);
+}
+
+const CubemapTexelTable& GetCubemapTexelTable(uint32 width, uint32 height)
+{
+    Assert_(width > 0 && height > 0);
+
+    AcquireSRWLockExclusive(&CubemapTexelTablesLock);
+
+    const CubemapTexelTable* table = nullptr;
+    for(const auto& cachedTable : CubemapTexelTables)
+    {
+        if(cachedTable->Width == width && cachedTable->Height == height)
+        {
+            table = cachedTable.get();
+            break;
+        }
+    }
+
+    if(table == nullptr)
+    {
+        CubemapTexelTable* newTable = new CubemapTexelTable();
+        BuildCubemapTexelTable(*newTable, width, height);
+        CubemapTexelTables.emplace_back(newTable);
+        table = newTable;
+    }
+
+    ReleaseSRWLockExclusive(&CubemapTexelTablesLock);
+
+    return *table;
+}
+
+}
@@ -91,6 +91,42 @@ static void ProcessDeferredSRVCreates(uint64 frameIdx)
     DeferredSRVCreateCount[frameIdx] = 0;
 }
 
+static void InitializeFrameResources(ID3D12CommandQueue* gfxQueue)
+{
+    for(uint64 i = 0; i < NumCmdAllocators; ++i)
+        DXCall(Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&CmdAllocators[i])));
+
+    DXCall(Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, CmdAllocators[0], nullptr, IID_PPV_ARGS(&CmdList)));
+    DXCall(CmdList->Close());
+    CmdList->SetName(L"Primary Graphics Command List");
+
+    if(gfxQueue != nullptr)
+    {
+        GfxQueue = gfxQueue;
+        GfxQueue->AddRef();
+    }
+    else
+    {
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+        DXCall(Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&GfxQueue)));
+        GfxQueue->SetName(L"Main Gfx Queue");
+    }
+
+    CurrFrameIdx = CurrentCPUFrame % NumCmdAllocators;
+    DXCall(CmdAllocators[CurrFrameIdx]->Reset());
+    DXCall(CmdList->Reset(CmdAllocators[CurrFrameIdx], nullptr));
+
+    FrameFence.Init(0);
+
+    for(uint64 i = 0; i < ArraySize_(DeferredSRVCreates); ++i)
+        DeferredSRVCreates[i].Init(1024);
+
+    Initialize_Helpers();
+    Initialize_Upload();
+}
+
 void Initialize(D3D_FEATURE_LEVEL minFeatureLevel, uint32 adapterIdx)
 {
     ShuttingDown = false;
@@ -184,30 +220,31 @@ void Initialize(D3D_FEATURE_LEVEL minFeatureLevel, uint32 adapterIdx)
         infoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, TRUE);
     #endif
 
-    for(uint64 i = 0; i < NumCmdAllocators; ++i)
-        DXCall(Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&CmdAllocators[i])));
+    InitializeFrameResources(nullptr);
+}
 
-    DXCall(Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, CmdAllocators[0], nullptr, IID_PPV_ARGS(&CmdList)));
-    DXCall(CmdList->Close());
-    CmdList->SetName(L"Primary Graphics Command List");
+void Initialize(ID3D12Device5* device, ID3D12CommandQueue* gfxQueue)
+{
+    Assert_(device != nullptr);
+    Assert_(gfxQueue != nullptr);
 
-    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
-    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-    DXCall(Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&GfxQueue)));
-    GfxQueue->SetName(L"Main Gfx Queue");
+    ShuttingDown = false;
 
-    CurrFrameIdx = CurrentCPUFrame % NumCmdAllocators;
-    DXCall(CmdAllocators[CurrFrameIdx]->Reset());
-    DXCall(CmdList->Reset(CmdAllocators[CurrFrameIdx], nullptr));
+    DXCall(CreateDXGIFactory1(IID_PPV_ARGS(&Factory)));
+    DXCall(Factory->EnumAdapterByLuid(device->GetAdapterLuid(), IID_PPV_ARGS(&Adapter)));
 
-    FrameFence.Init(0);
+    Device = device;
+    Device->AddRef();
 
-    for(uint64 i = 0; i < ArraySize_(DeferredSRVCreates); ++i)
-        DeferredSRVCreates[i].Init(1024);
+    D3D_FEATURE_LEVEL featureLevelsArray[] = { D3D_FEATURE_LEVEL_11_0, D3D_FEATURE_LEVEL_11_1, D3D_FEATURE_LEVEL_12_0,
+                                               D3D_FEATURE_LEVEL_12_1, D3D_FEATURE_LEVEL_12_2 };
+    D3D12_FEATURE_DATA_FEATURE_LEVELS featureLevels = { };
+    featureLevels.NumFeatureLevels = ArraySize_(featureLevelsArray);
+    featureLevels.pFeatureLevelsRequested = featureLevelsArray;
+    DXCall(Device->CheckFeatureSupport(D3D12_FEATURE_FEATURE_LEVELS, &featureLevels, sizeof(featureLevels)));
+    FeatureLevel = featureLevels.MaxSupportedFeatureLevel;
 
-    Initialize_Helpers();
-    Initialize_Upload();
+    InitializeFrameResources(gfxQueue);
 }
 
 void Shutdown()
@@ -304,6 +341,16 @@ void EndFrame(IDXGISwapChain4* swapChain, uint32 syncIntervals)
     ProcessDeferredSRVCreates(CurrFrameIdx);
 }
 
+bool FrameCompleted(uint64 frame)
+{
+    return FrameFence.Signaled(frame);
+}
+
+void WaitForFrame(uint64 frame)
+{
+    FrameFence.Wait(frame);
+}
+
 void FlushGPU()
 {
     Assert_(Device);
@@ -34,11 +34,16 @@ extern uint64 CurrFrameIdx;     // CurrentCPUFrame % RenderLatency
 
 // Lifetime
 void Initialize(D3D_FEATURE_LEVEL minFeatureLevel, uint32 adapterIdx);
+// Shares the device and the graphics queue with another renderer. Both are released on shutdown.
+void Initialize(ID3D12Device5* device, ID3D12CommandQueue* gfxQueue);
 void Shutdown();
 
 // Frame submission synchronization
 void BeginFrame();
 void EndFrame(IDXGISwapChain4* swapChain, uint32 syncIntervals);
+// EndFrame signals the frame fence with CurrentCPUFrame after the frame's command list is submitted
+bool FrameCompleted(uint64 frame);
+void WaitForFrame(uint64 frame);
 void FlushGPU();
 
 void DeferredRelease_(IUnknown* resource, bool forceDeferred = false);
@@ -0,0 +1,391 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "EXRWriter.h"
+#include "..\\Exceptions.h"
+#include "..\\Utility.h"
+#include "..\\FileIO.h"
+#include "..\\Tasks.h"
+#include "TinyEXR.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace SampleFramework12
+{
+
+static const uint32 EXRMagicNumber = 20000630;
+static const uint32 EXRVersion = 2;             // Single-part scanline file, no flags
+
+// Amount of uncompressed pixel data that's compressed in one batch. Two batches are in flight at
+// a time: one that's being compressed and one that's being written to the file.
+static const uint64 EXRBatchSize = 8 * 1024 * 1024;
+
+// Size of the scanline number and data size that come before the pixel data of every block
+static const uint64 EXRBlockHeaderSize = 8;
+
+// RLE runs are at least 3 bytes and at most 128, matching OpenEXR
+static const uint64 RLEMinRunLength = 3;
+static const uint64 RLEMaxRunLength = 127;
+
+struct EXRLayout
+{
+    const Float4* Texels = nullptr;
+    uint32 Width = 0;
+    uint32 Height = 0;
+
+    // Channels have to be sorted by name, so the components are stored as A, B, G, R
+    uint32 NumChannels = 0;
+    uint32 ChannelComponents[4] = { };
+    const char* ChannelNames[4] = { };
+
+    EXRCompression Compression = EXRCompression::ZIP;
+    EXRPixelType PixelType = EXRPixelType::Half;
+    int32 ZipLevel = 4;
+
+    uint64 BytesPerSample = 0;
+    uint64 LinesPerBlock = 0;
+    uint64 NumBlocks = 0;
+    uint64 MaxBlockSize = 0;
+    uint64 MaxCompressedSize = 0;
+};
+
+struct EXRBlock
+{
+    Array<uint8> Pixels;        // Uncompressed pixel data
+    Array<uint8> Scratch;       // Pixel data after the RLE/ZIP predictor
+    Array<uint8> Output;        // Block header followed by the (possibly compressed) pixel data
+    uint64 OutputSize = 0;
+};
+
+// == Header ======================================================================================
+
+static void AppendBytes(GrowableList<uint8>& data, const void* bytes, uint64 numBytes)
+{
+    data.Append(reinterpret_cast<const uint8*>(bytes), numBytes);
+}
+
+template<typename T> static void AppendValue(GrowableList<uint8>& data, const T& value)
+{
+    AppendBytes(data, &value, sizeof(T));
+}
+
+static void AppendAttribute(GrowableList<uint8>& header, const char* name, const char* type, const void* value, uint32 size)
+{
+    AppendBytes(header, name, strlen(name) + 1);
+    AppendBytes(header, type, strlen(type) + 1);
+    AppendValue(header, size);
+    AppendBytes(header, value, size);
+}
+
+static void WriteEXRHeader(const EXRLayout& layout, GrowableList<uint8>& header)
+{
+    AppendValue(header, EXRMagicNumber);
+    AppendValue(header, EXRVersion);
+
+    GrowableList<uint8> channels;
+    for(uint32 c = 0; c < layout.NumChannels; ++c)
+    {
+        const uint8 linear[4] = { 0, 0, 0, 0 };     // pLinear and 3 reserved bytes
+        AppendBytes(channels, layout.ChannelNames[c], strlen(layout.ChannelNames[c]) + 1);
+        AppendValue(channels, uint32(layout.PixelType));
+        AppendBytes(channels, linear, sizeof(linear));
+        AppendValue(channels, int32(1));            // xSampling
+        AppendValue(channels, int32(1));            // ySampling
+    }
+    AppendValue(channels, uint8(0));
+    AppendAttribute(header, "channels", "chlist", channels.Data(), uint32(channels.Count()));
+
+    const uint8 compression = uint8(layout.Compression);
+    AppendAttribute(header, "compression", "compression", &compression, sizeof(compression));
+
+    const int32 window[4] = { 0, 0, int32(layout.Width) - 1, int32(layout.Height) - 1 };
+    AppendAttribute(header, "dataWindow", "box2i", window, sizeof(window));
+    AppendAttribute(header, "displayWindow", "box2i", window, sizeof(window));
+
+    const uint8 lineOrder = 0;                      // Increasing Y
+    AppendAttribute(header, "lineOrder", "lineOrder", &lineOrder, sizeof(lineOrder));
+
+    const float aspectRatio = 1.0f;
+    AppendAttribute(header, "pixelAspectRatio", "float", &aspectRatio, sizeof(aspectRatio));
+
+    const float windowCenter[2] = { 0.0f, 0.0f };
+    AppendAttribute(header, "screenWindowCenter", "v2f", windowCenter, sizeof(windowCenter));
+
+    const float windowWidth = 1.0f;
+    AppendAttribute(header, "screenWindowWidth", "float", &windowWidth, sizeof(windowWidth));
+
+    AppendValue(header, uint8(0));
+}
+
+// == Compression =================================================================================
+
+// Converts the scanlines of a block to the EXR layout, where all of the samples of one channel are stored
+// contiguously for each scanline. Samples are read straight from the RGBA texels with a stride.
+static void PackEXRPixels(const EXRLayout& layout, uint64 startY, uint64 numLines, uint8* dst)
+{
+    const uint64 width = layout.Width;
+    for(uint64 y = startY; y < startY + numLines; ++y)
+    {
+        const float* row = reinterpret_cast<const float*>(layout.Texels + y * width);
+        for(uint32 c = 0; c < layout.NumChannels; ++c)
+        {
+            const float* src = row + layout.ChannelComponents[c];
+            if(layout.PixelType == EXRPixelType::Half)
+            {
+                XMConvertFloatToHalfStream(reinterpret_cast<HALF*>(dst), sizeof(HALF), src, sizeof(Float4), width);
+            }
+            else
+            {
+                float* dstFloats = reinterpret_cast<float*>(dst);
+                for(uint64 x = 0; x < width; ++x)
+                    dstFloats[x] = src[x * 4];
+            }
+
+            dst += width * layout.BytesPerSample;
+        }
+    }
+}
+
+// Splits the bytes into the even and odd halves and delta-encodes the result. This is done by OpenEXR
+// before both RLE and ZIP compression, since the high bytes of neighboring samples are usually similar.
+static void EXRPredictor(const uint8* src, uint8* dst, uint64 size)
+{
+    const uint64 halfSize = (size + 1) / 2;
+    uint8* even = dst;
+    uint8* odd = dst + halfSize;
+    for(uint64 i = 0; i + 1 < size; i += 2)
+    {
+        *even++ = src[i];
+        *odd++ = src[i + 1];
+    }
+    if(size % 2 == 1)
+        *even = src[size - 1];
+
+    // Going backwards means that every delta is computed from the original value before it
+    for(uint64 i = size - 1; i > 0; --i)
+        dst[i] = uint8(dst[i] - dst[i - 1] + 128);
+}
+
+// Same encoding as OpenEXR: a count of (n - 1) followed by a byte for a run of n equal bytes, or a
+// negative count followed by that many bytes for a literal sequence
+static uint64 RLECompress(const uint8* src, uint64 size, uint8* dst)
+{
+    const uint8* srcEnd = src + size;
+    const uint8* runStart = src;
+    const uint8* runEnd = src + 1;
+    uint8* dstStart = dst;
+
+    while(runStart < srcEnd)
+    {
+        while(runEnd < srcEnd && *runStart == *runEnd && uint64(runEnd - runStart - 1) < RLEMaxRunLength)
+            ++runEnd;
+
+        if(uint64(runEnd - runStart) >= RLEMinRunLength)
+        {
+            *dst++ = uint8(runEnd - runStart - 1);
+            *dst++ = *runStart;
+            runStart = runEnd;
+        }
+        else
+        {
+            while(runEnd < srcEnd && ((runEnd + 1 >= srcEnd || *runEnd != *(runEnd + 1)) ||
+                                      (runEnd + 2 >= srcEnd || *(runEnd + 1) != *(runEnd + 2))) &&
+                  uint64(runEnd - runStart) < RLEMaxRunLength)
+                ++runEnd;
+
+            *dst++ = uint8(runStart - runEnd);
+            while(runStart < runEnd)
+                *dst++ = *runStart++;
+        }
+
+        ++runEnd;
+    }
+
+    return uint64(dst - dstStart);
+}
+
+static void CompressEXRBlock(const EXRLayout& layout, uint64 blockIdx, EXRBlock& block)
+{
+    const uint64 startY = blockIdx * layout.LinesPerBlock;
+    const uint64 numLines = Min<uint64>(layout.LinesPerBlock, layout.Height - startY);
+    const uint64 pixelsSize = numLines * layout.Width * layout.NumChannels * layout.BytesPerSample;
+
+    uint8* output = block.Output.Data();
+    uint8* outputPixels = output + EXRBlockHeaderSize;
+    uint64 dataSize = pixelsSize;
+
+    if(layout.Compression == EXRCompression::None)
+    {
+        PackEXRPixels(layout, startY, numLines, outputPixels);
+    }
+    else
+    {
+        PackEXRPixels(layout, startY, numLines, block.Pixels.Data());
+        EXRPredictor(block.Pixels.Data(), block.Scratch.Data(), pixelsSize);
+
+        uint64 compressedSize = pixelsSize;
+        if(layout.Compression == EXRCompression::RLE)
+        {
+            compressedSize = RLECompress(block.Scratch.Data(), pixelsSize, outputPixels);
+        }
+        else
+        {
+            unsigned long zipSize = static_cast<unsigned long>(layout.MaxCompressedSize);
+            if(CompressZlib(outputPixels, &zipSize, block.Scratch.Data(), static_cast<unsigned long>(pixelsSize), layout.ZipLevel) == 0)
+                compressedSize = zipSize;
+        }
+
+        // Blocks that don't get any smaller are stored uncompressed, which is how readers tell them apart
+        if(compressedSize < pixelsSize)
+            dataSize = compressedSize;
+        else
+            memcpy(outputPixels, block.Pixels.Data(), pixelsSize);
+    }
+
+    const int32 blockHeader[2] = { int32(startY), int32(dataSize) };
+    memcpy(output, blockHeader, sizeof(blockHeader));
+    block.OutputSize = EXRBlockHeaderSize + dataSize;
+}
+
+// == WriteEXR ====================================================================================
+
+uint64 WriteEXR(const Float4* texels, uint32 width, uint32 height, const wchar* filePath, const EXRWriteSettings& settings)
+{
+    Assert_(texels != nullptr);
+    Assert_(width > 0 && height > 0);
+    Assert_(uint32(settings.Compression) < uint32(EXRCompression::NumValues));
+    Assert_(settings.PixelType == EXRPixelType::Half || settings.PixelType == EXRPixelType::Float);
+    Assert_(settings.ZipLevel >= 1 && settings.ZipLevel <= 9);
+
+    EXRLayout layout;
+    layout.Texels = texels;
+    layout.Width = width;
+    layout.Height = height;
+    layout.Compression = settings.Compression;
+    layout.PixelType = settings.PixelType;
+    layout.ZipLevel = int32(settings.ZipLevel);
+
+    if(settings.WriteAlpha)
+    {
+        layout.ChannelNames[layout.NumChannels] = "A";
+        layout.ChannelComponents[layout.NumChannels++] = 3;
+    }
+    layout.ChannelNames[layout.NumChannels] = "B";
+    layout.ChannelComponents[layout.NumChannels++] = 2;
+    layout.ChannelNames[layout.NumChannels] = "G";
+    layout.ChannelComponents[layout.NumChannels++] = 1;
+    layout.ChannelNames[layout.NumChannels] = "R";
+    layout.ChannelComponents[layout.NumChannels++] = 0;
+
+    layout.BytesPerSample = settings.PixelType == EXRPixelType::Half ? sizeof(HALF) : sizeof(float);
+    layout.LinesPerBlock = settings.Compression == EXRCompression::ZIP ? 16 : 1;
+    layout.NumBlocks = (height + layout.LinesPerBlock - 1) / layout.LinesPerBlock;
+    layout.MaxBlockSize = layout.LinesPerBlock * width * layout.NumChannels * layout.BytesPerSample;
+    if(layout.MaxBlockSize > uint64(INT32_MAX))
+        throw Exception(L"EXR scanlines are too large to be written (" + ToString(width) + L" pixels wide)");
+
+    layout.MaxCompressedSize = layout.MaxBlockSize;
+    if(settings.Compression == EXRCompression::RLE)
+        layout.MaxCompressedSize = layout.MaxBlockSize + layout.MaxBlockSize / RLEMaxRunLength + 1;
+    else if(settings.Compression == EXRCompression::ZIPS || settings.Compression == EXRCompression::ZIP)
+        layout.MaxCompressedSize = CompressZlibBound(static_cast<unsigned long>(layout.MaxBlockSize));
+
+    enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+    const uint64 minBatchBlocks = taskScheduler.GetNumTaskThreads() * 2;
+    const uint64 batchBlocks = Min(layout.NumBlocks, Max(minBatchBlocks, EXRBatchSize / layout.MaxBlockSize));
+    const uint64 numBatches = (layout.NumBlocks + batchBlocks - 1) / batchBlocks;
+
+    Array<EXRBlock> blocks(batchBlocks * 2);
+    for(uint64 i = 0; i < blocks.Size(); ++i)
+    {
+        if(settings.Compression != EXRCompression::None)
+        {
+            blocks[i].Pixels.Init(layout.MaxBlockSize);
+            blocks[i].Scratch.Init(layout.MaxBlockSize);
+        }
+        blocks[i].Output.Init(EXRBlockHeaderSize + Max(layout.MaxBlockSize, layout.MaxCompressedSize));
+    }
+
+    // The offset table comes before the pixel data, so it's filled in once all of the blocks are written
+    GrowableList<uint8> header;
+    WriteEXRHeader(layout, header);
+    Array<uint64> offsets(layout.NumBlocks, 0);
+
+    File file(filePath, FileOpenMode::Write);
+    file.Write(header.Count(), header.Data());
+    file.Write(offsets.MemorySize(), offsets.Data());
+    uint64 fileOffset = header.Count() + offsets.MemorySize();
+
+    uint64 batchStart[2] = { };
+    enki::TaskSet batchTasks[2];
+    for(uint64 slot = 0; slot < 2; ++slot)
+    {
+        batchTasks[slot].m_Function = [&, slot](enki::TaskSetPartition range, uint32 threadNum)
+        {
+            for(uint64 i = range.start; i < range.end; ++i)
+                CompressEXRBlock(layout, batchStart[slot] + i, blocks[slot * batchBlocks + i]);
+        };
+    }
+
+    auto startBatch = [&](uint64 batchIdx)
+    {
+        const uint64 slot = batchIdx % 2;
+        batchStart[slot] = batchIdx * batchBlocks;
+        batchTasks[slot].m_SetSize = uint32(Min(batchBlocks, layout.NumBlocks - batchStart[slot]));
+        taskScheduler.AddTaskSetToPipe(&batchTasks[slot]);
+    };
+
+    try
+    {
+        startBatch(0);
+        for(uint64 batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+        {
+            const uint64 slot = batchIdx % 2;
+            taskScheduler.WaitforTaskSet(&batchTasks[slot]);
+
+            // Compress the next batch while this one is written out
+            if(batchIdx + 1 < numBatches)
+                startBatch(batchIdx + 1);
+
+            for(uint64 i = 0; i < batchTasks[slot].m_SetSize; ++i)
+            {
+                const EXRBlock& block = blocks[slot * batchBlocks + i];
+                offsets[batchStart[slot] + i] = fileOffset;
+                file.Write(block.OutputSize, block.Output.Data());
+                fileOffset += block.OutputSize;
+            }
+        }
+
+        file.Seek(header.Count());
+        file.Write(offsets.MemorySize(), offsets.Data());
+    }
+    catch(...)
+    {
+        // The tasks use the blocks on the stack, so they have to finish before unwinding
+        taskScheduler.WaitforTaskSet(&batchTasks[0]);
+        taskScheduler.WaitforTaskSet(&batchTasks[1]);
+        throw;
+    }
+
+    return fileOffset;
+}
+
+uint64 WriteEXR(const TextureData<Float4>& texture, const wchar* filePath, const EXRWriteSettings& settings)
+{
+    Assert_(texture.Texels.Size() > 0);
+    Assert_(texture.NumSlices == 1);
+    Assert_(texture.Texels.Size() == uint64(texture.Width) * texture.Height);
+
+    return WriteEXR(texture.Texels.Data(), texture.Width, texture.Height, filePath, settings);
+}
+
+}
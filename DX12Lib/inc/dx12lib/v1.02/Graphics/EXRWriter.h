@@ -0,0 +1,75 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+#include "..\\SF12_Math.h"
+#include "Textures.h"
+
+namespace SampleFramework12
+{
+
+// Values match the compression attribute of the EXR header
+enum class EXRCompression : uint32
+{
+    None = 0,
+    RLE = 1,
+    ZIPS = 2,
+    ZIP = 3,
+
+    NumValues
+};
+
+// Values match the pixel types of the EXR channel list
+enum class EXRPixelType : uint32
+{
+    Half = 1,
+    Float = 2,
+};
+
+struct EXRWriteSettings
+{
+    EXRCompression Compression = EXRCompression::ZIP;
+    EXRPixelType PixelType = EXRPixelType::Half;
+    bool WriteAlpha = false;
+    uint32 ZipLevel = 4;            // zlib level used for ZIP and ZIPS, from 1 (fastest) to 9 (smallest)
+};
+
+// Writes a scanline EXR file straight from RGBA texels. Blocks of scanlines are converted and compressed in
+// parallel on the task scheduler, and batches of blocks are written out while the next batch is compressed,
+// so that only a few blocks are in memory at any time. Returns the size of the file in bytes.
+uint64 WriteEXR(const Float4* texels, uint32 width, uint32 height, const wchar* filePath,
+                const EXRWriteSettings& settings = EXRWriteSettings());
+uint64 WriteEXR(const TextureData<Float4>& texture, const wchar* filePath,
+                const EXRWriteSettings& settings = EXRWriteSettings());
+
+struct EXRWriteJob;
+
+// Writes EXR files on a task scheduler thread from a snapshot of the texels, so that saving the output of a
+// progressive renderer doesn't stall the frame. Only one file is written at a time.
+struct AsyncEXRWriter
+{
+    EXRWriteJob* Job = nullptr;
+
+    // Both return false without writing anything if the previous file is still being written. The texture
+    // version reads back the texture on the calling thread, but compression and I/O are done in the background.
+    bool Write(const TextureData<Float4>& texture, const wchar* filePath, const EXRWriteSettings& settings = EXRWriteSettings());
+    bool Write(const Texture& texture, const wchar* filePath, const EXRWriteSettings& settings = EXRWriteSettings());
+
+    bool Writing() const;
+
+    // Waits for the current file, and throws if writing it failed
+    void Wait();
+
+    void Shutdown();
+    ~AsyncEXRWriter();
+};
+
+}
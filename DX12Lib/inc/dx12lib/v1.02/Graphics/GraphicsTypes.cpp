@@ -10,6 +10,7 @@
 #include "PCH.h"
 
 #include "GraphicsTypes.h"
+#include "SampleSequences.h"
 #include "..\\Exceptions.h"
 #include "..\\Utility.h"
 #include "..\\Serialization.h"
@@ -942,6 +943,18 @@ void RawBuffer::UpdateDynamicSRV() const
     DX12::DeferredCreateSRV(InternalBuffer.Resource, srvDesc, SRV);
 }
 
+// Uploads the sample tables as-is, the rest of SampleTables is in SampleSequences.cpp
+void SampleTables::CreateBuffer(RawBuffer& buffer) const
+{
+    Assert_(Initialized());
+
+    RawBufferInit init;
+    init.NumElements = Size() / RawBuffer::Stride;
+    init.InitData = Data();
+    init.Name = L"Sample Tables";
+    buffer.Initialize(init);
+}
+
 // == ReadbackBuffer ==============================================================================
 
 ReadbackBuffer::ReadbackBuffer()
@@ -1111,8 +1124,16 @@ void RenderTexture::Initialize(const RenderTextureInit& init)
 
     D3D12_CLEAR_VALUE clearValue = { };
     clearValue.Format = init.Format;
-    DXCall(DX12::Device->CreateCommittedResource(DX12::GetDefaultHeapProps(), D3D12_HEAP_FLAG_NONE, &textureDesc,
-                                                 initialState, init.CreateRTV ? &clearValue : nullptr, IID_PPV_ARGS(&Texture.Resource)));
+    if(init.Heap)
+    {
+        DXCall(DX12::Device->CreatePlacedResource(init.Heap, init.HeapOffset, &textureDesc, initialState,
+                                                  init.CreateRTV ? &clearValue : nullptr, IID_PPV_ARGS(&Texture.Resource)));
+    }
+    else
+    {
+        DXCall(DX12::Device->CreateCommittedResource(DX12::GetDefaultHeapProps(), D3D12_HEAP_FLAG_NONE, &textureDesc,
+                                                     initialState, init.CreateRTV ? &clearValue : nullptr, IID_PPV_ARGS(&Texture.Resource)));
+    }
 
     if(init.Name != nullptr)
         Texture.Resource->SetName(init.Name);
@@ -397,6 +397,11 @@ struct RenderTextureInit
     uint32 NumMips = 1;
     D3D12_RESOURCE_STATES InitialState = D3D12_RESOURCE_STATES(-1);
     const wchar* Name = nullptr;
+
+    // Places the texture in a heap instead of creating a committed resource. The heap needs to
+    // allow render targets, and the texture must be initialized (cleared or discarded) before it's used.
+    ID3D12Heap* Heap = nullptr;
+    uint64 HeapOffset = 0;
 };
 
 struct RenderTexture
@@ -14,6 +14,7 @@
 #include "..\\Utility.h"
 #include "ShaderCompilation.h"
 #include "DX12.h"
+#include "DX12_Helpers.h"
 
 namespace AppSettings
 {
@@ -35,18 +36,106 @@ enum RootParams : uint32
     NumRootParams,
 };
 
+uint64 DX12TempRenderTargetDevice::CurrentFence() const
+{
+    // The frame fence is signaled with the incremented frame count at the end of the frame
+    return DX12::CurrentCPUFrame + 1;
+}
+
+uint64 DX12TempRenderTargetDevice::TargetSize(const TempRenderTargetDesc& desc) const
+{
+    D3D12_RESOURCE_DESC textureDesc = { };
+    textureDesc.MipLevels = 1;
+    textureDesc.Format = desc.Format;
+    textureDesc.Width = uint32(desc.Width);
+    textureDesc.Height = uint32(desc.Height);
+    textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    if(desc.UAV)
+        textureDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    textureDesc.DepthOrArraySize = 1;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    textureDesc.Alignment = 0;
+
+    return DX12::Device->GetResourceAllocationInfo(0, 1, &textureDesc).SizeInBytes;
+}
+
+ID3D12Heap* DX12TempRenderTargetDevice::CreateHeap(uint64 size)
+{
+    D3D12_HEAP_DESC heapDesc = { };
+    heapDesc.SizeInBytes = size;
+    heapDesc.Properties = *DX12::GetDefaultHeapProps();
+    heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+    ID3D12Heap* heap = nullptr;
+    DXCall(DX12::Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)));
+    heap->SetName(L"PP Temp Render Target Heap");
+
+    return heap;
+}
+
+void DX12TempRenderTargetDevice::DestroyHeap(ID3D12Heap* heap)
+{
+    DX12::DeferredRelease(heap);
+}
+
+PooledRenderTarget* DX12TempRenderTargetDevice::CreateTarget(const TempRenderTargetDesc& desc, ID3D12Heap* heap)
+{
+    RenderTextureInit rtInit;
+    rtInit.Width = desc.Width;
+    rtInit.Height = desc.Height;
+    rtInit.Format = desc.Format;
+    rtInit.CreateUAV = desc.UAV;
+    rtInit.Name = L"PP Temp Render Target";
+    rtInit.Heap = heap;
+
+    TempRenderTarget* tempRT = new TempRenderTarget();
+    tempRT->RT.Initialize(rtInit);
+    return tempRT;
+}
+
+void DX12TempRenderTargetDevice::DestroyTarget(PooledRenderTarget* target)
+{
+    TempRenderTarget* tempRT = static_cast<TempRenderTarget*>(target);
+    tempRT->RT.Shutdown();
+    delete tempRT;
+}
+
+void DX12TempRenderTargetDevice::AliasTarget(const PooledRenderTarget* target, const PooledRenderTarget* previous)
+{
+    Assert_(CmdList != nullptr);
+
+    const RenderTexture& rt = static_cast<const TempRenderTarget*>(target)->RT;
+
+    D3D12_RESOURCE_BARRIER barrier = { };
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+    barrier.Aliasing.pResourceBefore = previous ? static_cast<const TempRenderTarget*>(previous)->RT.Resource() : nullptr;
+    barrier.Aliasing.pResourceAfter = rt.Resource();
+    CmdList->ResourceBarrier(1, &barrier);
+
+    // The contents of the target are undefined once it takes over the memory, so they
+    // have to be initialized before the target is rendered to or read from
+    rt.MakeWritable(CmdList);
+    CmdList->DiscardResource(rt.Resource(), nullptr);
+    rt.MakeReadable(CmdList);
+}
+
 PostProcessHelper::PostProcessHelper()
 {
 }
 
 PostProcessHelper::~PostProcessHelper()
 {
-    Assert_(tempRenderTargets.Count() == 0);
+    Assert_(tempRenderTargets.NumTargets() == 0);
     Assert_(pipelineStates.Count() == 0);
 }
 
-void PostProcessHelper::Initialize()
+void PostProcessHelper::Initialize(const TempRenderTargetPoolSettings& poolSettings)
 {
+    tempRenderTargets.Initialize(&tempRTDevice, poolSettings);
+
     // Load the shaders
     std::wstring fullScreenTriPath = SampleFrameworkDir() + L"Shaders\\FullScreenTriangle.hlsl";
     fullScreenTriVS = CompileFromFile(fullScreenTriPath.c_str(), "FullScreenTriangleVS", ShaderType::Vertex);
@@ -90,20 +179,14 @@ void PostProcessHelper::Initialize()
 void PostProcessHelper::Shutdown()
 {
     ClearCache();
+    tempRenderTargets.Shutdown();
 
     DX12::Release(rootSignature);
 }
 
 void PostProcessHelper::ClearCache()
 {
-    for(uint64 i = 0; i < tempRenderTargets.Count(); ++i)
-    {
-        TempRenderTarget* tempRT = tempRenderTargets[i];
-        tempRT->RT.Shutdown();
-        delete tempRT;
-    }
-
-    tempRenderTargets.RemoveAll(nullptr);
+    tempRenderTargets.Clear();
 
     for(uint64 i = 0; i < pipelineStates.Count(); ++i)
         DX12::DeferredRelease(pipelineStates[i].PSO);
@@ -113,47 +196,34 @@ void PostProcessHelper::ClearCache()
 
 TempRenderTarget* PostProcessHelper::GetTempRenderTarget(uint64 width, uint64 height, DXGI_FORMAT format, bool useAsUAV)
 {
-    for(uint64 i = 0; i < tempRenderTargets.Count(); ++i)
-    {
-        TempRenderTarget* tempRT = tempRenderTargets[i];
-        if(tempRT->InUse)
-            continue;
-
-        const RenderTexture& rt = tempRT->RT;
-        if(rt.Texture.Width == width && rt.Texture.Height == height && rt.Texture.Format == format && useAsUAV == (rt.UAV.ptr != 0)) {
-            tempRT->InUse = true;
-            return tempRT;
-        }
-    }
-
-    RenderTextureInit rtInit;
-    rtInit.Width = width;
-    rtInit.Height = height;
-    rtInit.Format = format;
-    rtInit.CreateUAV = useAsUAV;
-
-    TempRenderTarget* tempRT = new TempRenderTarget();
-    tempRT->RT.Initialize(rtInit);
-    tempRT->RT.Texture.Resource->SetName(L"PP Temp Render Target");
-    tempRT->InUse = true;
-    tempRenderTargets.Add(tempRT);
-
-    return tempRT;
+    // Placed targets are aliased on the command list, so they can only be used between Begin() and End()
+    Assert_(cmdList != nullptr || tempRenderTargets.Settings().UseSharedHeaps == false);
+
+    TempRenderTargetDesc desc;
+    desc.Width = width;
+    desc.Height = height;
+    desc.Format = format;
+    desc.UAV = useAsUAV;
+    return static_cast<TempRenderTarget*>(tempRenderTargets.Acquire(desc));
 }
 
 void PostProcessHelper::Begin(ID3D12GraphicsCommandList* cmdList_)
 {
     Assert_(cmdList == nullptr);
     cmdList = cmdList_;
+    tempRTDevice.CmdList = cmdList_;
 }
 
 void PostProcessHelper::End()
 {
     Assert_(cmdList != nullptr);
     cmdList = nullptr;
+    tempRTDevice.CmdList = nullptr;
+
+    for(uint64 i = 0; i < tempRenderTargets.NumTargets(); ++i)
+        Assert_(tempRenderTargets.Target(i)->InUse == false);
 
-    for(uint64 i = 0; i < tempRenderTargets.Count(); ++i)
-        Assert_(tempRenderTargets[i]->InUse == false);
+    tempRenderTargets.Trim();
 }
 
 void PostProcessHelper::PostProcess(CompiledShaderPtr pixelShader, const char* name, const RenderTexture& input, const RenderTexture& output)
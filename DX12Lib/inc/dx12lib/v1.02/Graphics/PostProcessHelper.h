@@ -15,17 +15,35 @@
 #include "..\\SF12_Math.h"
 #include "ShaderCompilation.h"
 #include "GraphicsTypes.h"
+#include "TempRenderTargetPool.h"
 
 namespace SampleFramework12
 {
 
-struct TempRenderTarget
+struct TempRenderTarget : public PooledRenderTarget
 {
     RenderTexture RT;
     uint64 Width() const { return RT.Texture.Width; }
     uint64 Height() const { return RT.Texture.Height; }
     DXGI_FORMAT Format() const { return RT.Texture.Format; }
-    bool32 InUse = false;
+};
+
+// Creates the temp render targets of the PostProcessHelper with D3D12. Placed targets are
+// aliased on the command list that was passed to PostProcessHelper::Begin.
+class DX12TempRenderTargetDevice : public TempRenderTargetDevice
+{
+
+public:
+
+    ID3D12GraphicsCommandList* CmdList = nullptr;
+
+    virtual uint64 CurrentFence() const override;
+    virtual uint64 TargetSize(const TempRenderTargetDesc& desc) const override;
+    virtual ID3D12Heap* CreateHeap(uint64 size) override;
+    virtual void DestroyHeap(ID3D12Heap* heap) override;
+    virtual PooledRenderTarget* CreateTarget(const TempRenderTargetDesc& desc, ID3D12Heap* heap) override;
+    virtual void DestroyTarget(PooledRenderTarget* target) override;
+    virtual void AliasTarget(const PooledRenderTarget* target, const PooledRenderTarget* previous) override;
 };
 
 class PostProcessHelper
@@ -36,13 +54,20 @@ public:
     PostProcessHelper();
     ~PostProcessHelper();
 
-    void Initialize();
+    void Initialize(const TempRenderTargetPoolSettings& poolSettings = TempRenderTargetPoolSettings());
     void Shutdown();
 
     void ClearCache();
 
+    // Targets are handed out until they're released by setting InUse to false, after which they can be
+    // reused by later passes (in the same frame or in later frames). With shared heaps, the memory of a
+    // released target can be aliased by the next target, so it can't be read after it's released.
     TempRenderTarget* GetTempRenderTarget(uint64 width, uint64 height, DXGI_FORMAT format, bool useAsUAV = false);
 
+    // Reports the (peak) memory used by the temp render targets
+    const TempRenderTargetPoolStats& TempRenderTargetStats() const { return tempRenderTargets.Stats(); }
+    void ResetTempRenderTargetStats() { tempRenderTargets.ResetPeakStats(); }
+
     void Begin(ID3D12GraphicsCommandList* cmdList);
     void End();
 
@@ -62,7 +87,8 @@ protected:
         Hash Hash;
     };
 
-    GrowableList<TempRenderTarget*> tempRenderTargets;
+    DX12TempRenderTargetDevice tempRTDevice;
+    TempRenderTargetPool tempRenderTargets;
     GrowableList<CachedPSO> pipelineStates;
     ID3D12RootSignature* rootSignature = nullptr;
 
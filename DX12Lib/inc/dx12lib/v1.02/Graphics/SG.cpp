@@ -28,6 +28,9 @@
 #include "SG.h"
 #include "Textures.h"
 #include "..\\Containers.h"
+#include "..\\Tasks.h"
+
+using namespace DirectX;
 
 namespace SampleFramework12
 {
@@ -210,6 +213,21 @@ void ProjectOntoSGs(const Float3& dir, const Float3& color, SG* outSGs, uint64 n
     }
 }
 
+// Weight the projected samples by the monte carlo factor for uniformly sampling the sphere/hemisphere
+static void NormalizeProjection(SG* sgs, uint64 numSGs, uint64 numSamples, SGDistribution distribution)
+{
+    float monteCarloFactor = ((2.0f * Pi) / numSamples);
+    if(distribution == SGDistribution::Spherical)
+        monteCarloFactor *= 2.0f;
+
+    // Fudge factor to help correct the intensity from our bad projection algorithim
+    if(distribution == SGDistribution::Spherical && numSGs == 9)
+        monteCarloFactor *= Pi / 2.46373701f;
+
+    for(uint64 i = 0; i < numSGs; ++i)
+        sgs[i].Amplitude *= monteCarloFactor;
+}
+
 // Do a projection of the colors onto the SG's
 static void SolveProjection(SGSolveParams& params)
 {
@@ -220,17 +238,7 @@ static void SolveProjection(SGSolveParams& params)
     for(uint32 i = 0; i < params.NumSamples; ++i)
         ProjectOntoSGs(params.SampleDirs[i], params.SampleValues[i], params.OutSGs, params.NumSGs);
 
-    // Weight the samples by the monte carlo factor for uniformly sampling the sphere/hemisphere
-    float monteCarloFactor = ((2.0f * Pi) / params.NumSamples);
-    if(params.Distribution == SGDistribution::Spherical)
-        monteCarloFactor *= 2.0f;
-
-    // Fudge factor to help correct the intensity from our bad projection algorithim
-    if(params.Distribution == SGDistribution::Spherical && params.NumSGs == 9)
-        monteCarloFactor *= Pi / 2.46373701f;
-
-    for(uint32 i = 0; i < params.NumSGs; ++i)
-        params.OutSGs[i].Amplitude *= monteCarloFactor;
+    NormalizeProjection(params.OutSGs, params.NumSGs, params.NumSamples, params.Distribution);
 }
 
 // Solve the set of spherical gaussians based on input set of data
@@ -250,31 +258,135 @@ void SolveSGs(SGSolveParams& params)
     #endif
 }
 
-void SolveSGsForCubemap(const Texture& texture, SG* outSGs, uint64 numSGs, SGSolveMode solveMode)
+// Number of texels that are projected by a single task on the worker threads
+static const uint64 CubemapProjectionBatchSize = 4 * 1024;
+
+static float SumLanes(FXMVECTOR v)
 {
-    Assert_(texture.Cubemap);
-    Assert_(numSGs > 0);
-    Assert_(outSGs != nullptr);
+    const Float4 lanes = Float4(v);
+    return (lanes.x + lanes.y) + (lanes.z + lanes.w);
+}
 
-    TextureData<Float4> textureData;
-    GetTextureData(texture, textureData);
-    Assert_(textureData.NumSlices == 6);
-    const uint32 width = textureData.Width;
-    const uint32 height = textureData.Height;
+// Projects 4 texels onto the SGs, each SIMD lane accumulates the contribution of one texel
+static void ProjectTexelsOntoSGs(const CubemapTexelTable& table, const Float4* texels, uint64 idx,
+                                 const SG* sgs, uint64 numSGs, XMVECTOR* sums)
+{
+    const XMVECTOR x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirX.Data() + idx));
+    const XMVECTOR y = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirY.Data() + idx));
+    const XMVECTOR z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirZ.Data() + idx));
+
+    // Transpose the RGBA texels so that each color channel is in its own vector
+    const XMMATRIX samples = XMMatrixTranspose(XMMATRIX(texels[idx + 0].ToSIMD(), texels[idx + 1].ToSIMD(),
+                                                        texels[idx + 2].ToSIMD(), texels[idx + 3].ToSIMD()));
+
+    const XMVECTOR zero = XMVectorZero();
+    const XMVECTOR one = XMVectorSplatOne();
+    for(uint64 i = 0; i < numSGs; ++i)
+    {
+        const SG& sg = sgs[i];
+        XMVECTOR dot = XMVectorMultiply(x, XMVectorReplicate(sg.Axis.x));
+        dot = XMVectorMultiplyAdd(y, XMVectorReplicate(sg.Axis.y), dot);
+        dot = XMVectorMultiplyAdd(z, XMVectorReplicate(sg.Axis.z), dot);
+
+        // Only texels in the hemisphere around the axis contribute
+        XMVECTOR weight = XMVectorExpE(XMVectorScale(XMVectorSubtract(dot, one), sg.Sharpness));
+        weight = XMVectorSelect(zero, weight, XMVectorGreater(dot, zero));
+
+        sums[i * 3 + 0] = XMVectorMultiplyAdd(samples.r[0], weight, sums[i * 3 + 0]);
+        sums[i * 3 + 1] = XMVectorMultiplyAdd(samples.r[1], weight, sums[i * 3 + 1]);
+        sums[i * 3 + 2] = XMVectorMultiplyAdd(samples.r[2], weight, sums[i * 3 + 2]);
+    }
+}
+
+// Projects a range of texels onto the SGs, and returns the (unnormalized) amplitude for each SG
+static void ProjectTexelsOntoSGs(const CubemapTexelTable& table, const Float4* texels, uint64 start, uint64 end,
+                                 const SG* sgs, uint64 numSGs, Float3* outAmplitudes)
+{
+    Array<XMVECTOR> sums(numSGs * 3, XMVectorZero());
+
+    // 8 texels per iteration
+    uint64 idx = start;
+    for(; idx + 8 <= end; idx += 8)
+    {
+        ProjectTexelsOntoSGs(table, texels, idx, sgs, numSGs, sums.Data());
+        ProjectTexelsOntoSGs(table, texels, idx + 4, sgs, numSGs, sums.Data());
+    }
+
+    Array<SG> remainderSGs(numSGs);
+    for(uint64 i = 0; i < numSGs; ++i)
+    {
+        remainderSGs[i] = sgs[i];
+        remainderSGs[i].Amplitude = Float3(0.0f);
+    }
+
+    for(; idx < end; ++idx)
+    {
+        const Float3 dir = Float3(table.DirX[idx], table.DirY[idx], table.DirZ[idx]);
+        ProjectOntoSGs(dir, texels[idx].To3D(), remainderSGs.Data(), numSGs);
+    }
 
-    Array<Float3> sampleDirs(width * height * 6);
-    Array<Float3> sampleValues(width * height * 6);
-    for(uint32 face = 0; face < 6; ++face)
+    for(uint64 i = 0; i < numSGs; ++i)
+        outAmplitudes[i] = Float3(SumLanes(sums[i * 3 + 0]), SumLanes(sums[i * 3 + 1]),
+                                  SumLanes(sums[i * 3 + 2])) + remainderSGs[i].Amplitude;
+}
+
+// Projects all texels of a cubemap onto the SGs on the worker threads
+static void ProjectCubemapOntoSGs(const CubemapTexelTable& table, const Float4* texels, SG* sgs, uint64 numSGs)
+{
+    // Each batch writes its own partial sums, and the sums are added up in order afterwards so that the
+    // result doesn't depend on how the batches were scheduled
+    const uint64 numBatches = (table.NumTexels + CubemapProjectionBatchSize - 1) / CubemapProjectionBatchSize;
+    Array<Float3> batchAmplitudes(numBatches * numSGs);
+
+    enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+    enki::TaskSet projectTask(uint32(numBatches), [&](enki::TaskSetPartition range, uint32 threadNum)
     {
-        for(uint32 y = 0; y < height; ++y)
+        for(uint32 batchIdx = range.start; batchIdx < range.end; ++batchIdx)
         {
-            for(uint32 x = 0; x < width; ++x)
-            {
-                const uint32 idx = face * (width * height) + y * (width) + x;
-                sampleValues[idx] = textureData.Texels[idx].To3D();
-                sampleDirs[idx]  = MapXYSToDirection(x, y, face, width, height);
-            }
+            const uint64 start = batchIdx * CubemapProjectionBatchSize;
+            const uint64 end = std::min(start + CubemapProjectionBatchSize, table.NumTexels);
+            ProjectTexelsOntoSGs(table, texels, start, end, sgs, numSGs, &batchAmplitudes[batchIdx * numSGs]);
         }
+    });
+
+    taskScheduler.AddTaskSetToPipe(&projectTask);
+    taskScheduler.WaitforTaskSet(&projectTask);
+
+    for(uint64 batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+        for(uint64 i = 0; i < numSGs; ++i)
+            sgs[i].Amplitude += batchAmplitudes[batchIdx * numSGs + i];
+}
+
+void SolveSGsForCubemap(const TextureData<Float4>& textureData, SG* outSGs, uint64 numSGs, SGSolveMode solveMode)
+{
+    Assert_(numSGs > 0);
+    Assert_(outSGs != nullptr);
+    Assert_(textureData.NumSlices == 6);
+
+    const CubemapTexelTable& table = GetCubemapTexelTable(textureData.Width, textureData.Height);
+
+    #if EnableEigen_
+        const bool projection = solveMode == SGSolveMode::Projection;
+    #else
+        const bool projection = true;
+    #endif
+
+    // The projection reads the directions straight from the table, the least squares solvers
+    // need the samples as arrays of Float3
+    if(projection)
+    {
+        GenerateUniformSGs(outSGs, numSGs, SGDistribution::Spherical);
+        ProjectCubemapOntoSGs(table, textureData.Texels.Data(), outSGs, numSGs);
+        NormalizeProjection(outSGs, numSGs, table.NumTexels, SGDistribution::Spherical);
+        return;
+    }
+
+    Array<Float3> sampleDirs(table.NumTexels);
+    Array<Float3> sampleValues(table.NumTexels);
+    for(uint64 i = 0; i < table.NumTexels; ++i)
+    {
+        sampleValues[i] = textureData.Texels[i].To3D();
+        sampleDirs[i] = Float3(table.DirX[i], table.DirY[i], table.DirZ[i]);
     }
 
     SGSolveParams params;
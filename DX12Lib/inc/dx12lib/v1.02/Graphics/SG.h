@@ -16,6 +16,7 @@ namespace SampleFramework12
 {
 
 struct Texture;
+template<typename T> struct TextureData;
 
 // SphericalGaussian(dir) := Amplitude * exp(Sharpness * (dot(Axis, Direction) - 1.0f))
 struct SG
@@ -130,5 +131,7 @@ void SolveSGs(SGSolveParams& params);
 void ProjectOntoSGs(const Float3& dir, const Float3& color, SG* outSGs, uint64 numSGs);
 
 void SolveSGsForCubemap(const Texture& texture, SG* outSGs, uint64 numSGs, SGSolveMode solveMode = SGSolveMode::NNLS);
+void SolveSGsForCubemap(const TextureData<Float4>& textureData, SG* outSGs, uint64 numSGs,
+                        SGSolveMode solveMode = SGSolveMode::NNLS);
 
 }
\ No newline at end of file
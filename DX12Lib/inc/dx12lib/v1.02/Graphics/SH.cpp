@@ -10,9 +10,12 @@
 #include "PCH.h"
 #include "SH.h"
 #include "..\\Utility.h"
+#include "..\\Tasks.h"
 #include "ShaderCompilation.h"
 #include "Textures.h"
 
+using namespace DirectX;
+
 namespace SampleFramework12
 {
 
@@ -114,44 +117,114 @@ H4 ConvertToH4(const SH9& sh)
     return hBasis;
 }
 
-SH9Color ProjectCubemapToSH(const Texture& texture)
+// Number of texels that are projected by a single task on the worker threads
+static const uint64 CubemapProjectionBatchSize = 16 * 1024;
+
+// Projects 4 texels onto SH9, each SIMD lane accumulates the weighted coefficients of one texel
+static void ProjectTexelsOntoSH9(const CubemapTexelTable& table, const Float4* texels, uint64 idx,
+                                 XMVECTOR sums[9][3])
 {
-    Assert_(texture.Cubemap);
+    const XMVECTOR x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirX.Data() + idx));
+    const XMVECTOR y = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirY.Data() + idx));
+    const XMVECTOR z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirZ.Data() + idx));
+    const XMVECTOR weight = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.Weights.Data() + idx));
+
+    // Transpose the RGBA texels so that each color channel is in its own vector
+    const XMMATRIX samples = XMMatrixTranspose(XMMATRIX(texels[idx + 0].ToSIMD(), texels[idx + 1].ToSIMD(),
+                                                        texels[idx + 2].ToSIMD(), texels[idx + 3].ToSIMD()));
+    const XMVECTOR colors[3] =
+    {
+        XMVectorMultiply(samples.r[0], weight),
+        XMVectorMultiply(samples.r[1], weight),
+        XMVectorMultiply(samples.r[2], weight),
+    };
 
-    TextureData<Float4> textureData;
-    GetTextureData(texture, textureData);
-    Assert_(textureData.NumSlices == 6);
-    const uint32 width = textureData.Width;
-    const uint32 height = textureData.Height;
+    const XMVECTOR xx = XMVectorMultiply(x, x);
+    const XMVECTOR yy = XMVectorMultiply(y, y);
+    const XMVECTOR zz = XMVectorMultiply(z, z);
+
+    XMVECTOR basis[9];
+    basis[0] = XMVectorReplicate(0.282095f);
+    basis[1] = XMVectorScale(y, 0.488603f);
+    basis[2] = XMVectorScale(z, 0.488603f);
+    basis[3] = XMVectorScale(x, 0.488603f);
+    basis[4] = XMVectorScale(XMVectorMultiply(x, y), 1.092548f);
+    basis[5] = XMVectorScale(XMVectorMultiply(y, z), 1.092548f);
+    basis[6] = XMVectorScale(XMVectorSubtract(XMVectorScale(zz, 3.0f), XMVectorSplatOne()), 0.315392f);
+    basis[7] = XMVectorScale(XMVectorMultiply(x, z), 1.092548f);
+    basis[8] = XMVectorScale(XMVectorSubtract(xx, yy), 0.546274f);
+
+    for(uint64 i = 0; i < 9; ++i)
+        for(uint64 c = 0; c < 3; ++c)
+            sums[i][c] = XMVectorMultiplyAdd(basis[i], colors[c], sums[i][c]);
+}
+
+static float SumLanes(FXMVECTOR v)
+{
+    const Float4 lanes = Float4(v);
+    return (lanes.x + lanes.y) + (lanes.z + lanes.w);
+}
+
+// Projects a range of texels onto SH9, without the final normalization
+static SH9Color ProjectTexelsOntoSH9(const CubemapTexelTable& table, const Float4* texels, uint64 start, uint64 end)
+{
+    XMVECTOR sums[9][3];
+    for(uint64 i = 0; i < 9; ++i)
+        for(uint64 c = 0; c < 3; ++c)
+            sums[i][c] = XMVectorZero();
+
+    // 8 texels per iteration
+    uint64 idx = start;
+    for(; idx + 8 <= end; idx += 8)
+    {
+        ProjectTexelsOntoSH9(table, texels, idx, sums);
+        ProjectTexelsOntoSH9(table, texels, idx + 4, sums);
+    }
 
     SH9Color result;
-    float weightSum = 0.0f;
-    for(uint32 face = 0; face < 6; ++face)
+    for(uint64 i = 0; i < 9; ++i)
+        result.Coefficients[i] = Float3(SumLanes(sums[i][0]), SumLanes(sums[i][1]), SumLanes(sums[i][2]));
+
+    for(; idx < end; ++idx)
     {
-        for(uint32 y = 0; y < height; ++y)
+        const Float3 dir = Float3(table.DirX[idx], table.DirY[idx], table.DirZ[idx]);
+        result += ProjectOntoSH9Color(dir, texels[idx].To3D()) * table.Weights[idx];
+    }
+
+    return result;
+}
+
+SH9Color ProjectCubemapToSH(const TextureData<Float4>& textureData)
+{
+    Assert_(textureData.NumSlices == 6);
+
+    const CubemapTexelTable& table = GetCubemapTexelTable(textureData.Width, textureData.Height);
+    const Float4* texels = textureData.Texels.Data();
+
+    // Each batch writes its own partial sum, and the sums are added up in order afterwards so that the
+    // result doesn't depend on how the batches were scheduled
+    const uint64 numBatches = (table.NumTexels + CubemapProjectionBatchSize - 1) / CubemapProjectionBatchSize;
+    Array<SH9Color> batchResults(numBatches);
+
+    enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+    enki::TaskSet projectTask(uint32(numBatches), [&](enki::TaskSetPartition range, uint32 threadNum)
+    {
+        for(uint32 batchIdx = range.start; batchIdx < range.end; ++batchIdx)
         {
-            for(uint32 x = 0; x < width; ++x)
-            {
-                const uint32 idx = face * (width * height) + y * (width) + x;
-                Float3 sample = textureData.Texels[idx].To3D();
-
-                float u = (x + 0.5f) / width;
-                float v = (y + 0.5f) / height;
-
-                // Account for cubemap texel distribution
-                u = u * 2.0f - 1.0f;
-                v = v * 2.0f - 1.0f;
-                const float temp = 1.0f + u * u + v * v;
-                const float weight = 4.0f / (sqrt(temp) * temp);
-
-                Float3 dir = MapXYSToDirection(x, y, face, width, height);
-                result += ProjectOntoSH9Color(dir, sample) * weight;
-                weightSum += weight;
-            }
+            const uint64 start = batchIdx * CubemapProjectionBatchSize;
+            const uint64 end = std::min(start + CubemapProjectionBatchSize, table.NumTexels);
+            batchResults[batchIdx] = ProjectTexelsOntoSH9(table, texels, start, end);
         }
-    }
+    });
+
+    taskScheduler.AddTaskSetToPipe(&projectTask);
+    taskScheduler.WaitforTaskSet(&projectTask);
+
+    SH9Color result;
+    for(uint64 batchIdx = 0; batchIdx < numBatches; ++batchIdx)
+        result += batchResults[batchIdx];
 
-    result *= (4.0f * 3.14159f) / weightSum;
+    result *= (4.0f * 3.14159f) / table.WeightSum;
     return result;
 }
 
@@ -16,6 +16,7 @@ namespace SampleFramework12
 {
 
 struct Texture;
+template<typename T> struct TextureData;
 
 // Constants
 static const float CosineA0 = 1.0f * Pi;
@@ -227,6 +228,7 @@ H4 ConvertToH4(const SH9& sh);
 
 // Lighting environment generation functions
 SH9Color ProjectCubemapToSH(const Texture& texture);
+SH9Color ProjectCubemapToSH(const TextureData<Float4>& textureData);
 
 // Constants
 static const H4 H4Identity = H4(std::sqrt(2.0f * 3.14159f), 0.0f, 0.0f, 0.0f);
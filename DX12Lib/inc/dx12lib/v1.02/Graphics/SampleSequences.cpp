@@ -0,0 +1,730 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "SampleSequences.h"
+
+#include "..\\Exceptions.h"
+#include "..\\Utility.h"
+#include "..\\Tasks.h"
+
+#include <emmintrin.h>
+
+namespace SampleFramework12
+{
+
+// == Owen-scrambled Sobol ========================================================================
+
+// Generator matrices for the first 4 dimensions of the Sobol sequence, from the Joe-Kuo direction numbers.
+// Stored per bit of the sample index, with the 4 dimensions next to each other so that they can be
+// XOR'ed into a SIMD register.
+static const uint32 SobolMatrices[32][SobolOwenGroupSize] =
+{
+    { 0x80000000, 0x80000000, 0x80000000, 0x80000000 },
+    { 0x40000000, 0xc0000000, 0xc0000000, 0xc0000000 },
+    { 0x20000000, 0xa0000000, 0x60000000, 0x20000000 },
+    { 0x10000000, 0xf0000000, 0x90000000, 0x50000000 },
+    { 0x08000000, 0x88000000, 0xe8000000, 0xf8000000 },
+    { 0x04000000, 0xcc000000, 0x5c000000, 0x74000000 },
+    { 0x02000000, 0xaa000000, 0x8e000000, 0xa2000000 },
+    { 0x01000000, 0xff000000, 0xc5000000, 0x93000000 },
+    { 0x00800000, 0x80800000, 0x68800000, 0xd8800000 },
+    { 0x00400000, 0xc0c00000, 0x9cc00000, 0x25400000 },
+    { 0x00200000, 0xa0a00000, 0xee600000, 0x59e00000 },
+    { 0x00100000, 0xf0f00000, 0x55900000, 0xe6d00000 },
+    { 0x00080000, 0x88880000, 0x80680000, 0x78080000 },
+    { 0x00040000, 0xcccc0000, 0xc09c0000, 0xb40c0000 },
+    { 0x00020000, 0xaaaa0000, 0x60ee0000, 0x82020000 },
+    { 0x00010000, 0xffff0000, 0x90550000, 0xc3050000 },
+    { 0x00008000, 0x80008000, 0xe8808000, 0x208f8000 },
+    { 0x00004000, 0xc000c000, 0x5cc0c000, 0x51474000 },
+    { 0x00002000, 0xa000a000, 0x8e606000, 0xfbea2000 },
+    { 0x00001000, 0xf000f000, 0xc5909000, 0x75d93000 },
+    { 0x00000800, 0x88008800, 0x6868e800, 0xa0858800 },
+    { 0x00000400, 0xcc00cc00, 0x9c9c5c00, 0x914e5400 },
+    { 0x00000200, 0xaa00aa00, 0xeeee8e00, 0xdbe79e00 },
+    { 0x00000100, 0xff00ff00, 0x5555c500, 0x25db6d00 },
+    { 0x00000080, 0x80808080, 0x8000e880, 0x58800080 },
+    { 0x00000040, 0xc0c0c0c0, 0xc0005cc0, 0xe54000c0 },
+    { 0x00000020, 0xa0a0a0a0, 0x60008e60, 0x79e00020 },
+    { 0x00000010, 0xf0f0f0f0, 0x9000c590, 0xb6d00050 },
+    { 0x00000008, 0x88888888, 0xe8006868, 0x800800f8 },
+    { 0x00000004, 0xcccccccc, 0x5c009c9c, 0xc00c0074 },
+    { 0x00000002, 0xaaaaaaaa, 0x8e00eeee, 0x200200a2 },
+    { 0x00000001, 0xffffffff, 0xc5005555, 0x50050093 },
+};
+
+static uint32 HashCombine(uint32 seed, uint32 value)
+{
+    return seed ^ (value + (seed << 6) + (seed >> 2));
+}
+
+// Integer hash from "Hash Prospector" (lowbias32), used to turn seeds into well-distributed scrambles
+static uint32 HashUint32(uint32 x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+static uint32 ReverseBits(uint32 bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return bits;
+}
+
+// Hash-based permutation where every bit only depends on itself and the bits below it. Applied to a
+// bit-reversed value, this gives a nested uniform (Owen) scramble [Laine and Karras 2011, Burley 2020].
+static uint32 LaineKarrasPermutation(uint32 x, uint32 seed)
+{
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+static uint32 NestedUniformScramble(uint32 x, uint32 seed)
+{
+    return ReverseBits(LaineKarrasPermutation(ReverseBits(x), seed));
+}
+
+// SSE2 has no 32-bit multiply that keeps the low bits, so it's done with two 32x32->64 multiplies
+static __m128i MultiplyLow(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static __m128i ReverseBits(__m128i bits)
+{
+    const __m128i mask1 = _mm_set1_epi32(0x55555555);
+    const __m128i mask2 = _mm_set1_epi32(0x33333333);
+    const __m128i mask4 = _mm_set1_epi32(0x0F0F0F0F);
+    const __m128i mask8 = _mm_set1_epi32(0x00FF00FF);
+
+    bits = _mm_or_si128(_mm_slli_epi32(bits, 16), _mm_srli_epi32(bits, 16));
+    bits = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(bits, mask1), 1), _mm_and_si128(_mm_srli_epi32(bits, 1), mask1));
+    bits = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(bits, mask2), 2), _mm_and_si128(_mm_srli_epi32(bits, 2), mask2));
+    bits = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(bits, mask4), 4), _mm_and_si128(_mm_srli_epi32(bits, 4), mask4));
+    bits = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(bits, mask8), 8), _mm_and_si128(_mm_srli_epi32(bits, 8), mask8));
+    return bits;
+}
+
+static __m128i LaineKarrasPermutation(__m128i x, __m128i seed)
+{
+    x = _mm_add_epi32(x, seed);
+    x = _mm_xor_si128(x, MultiplyLow(x, _mm_set1_epi32(0x6c50b47c)));
+    x = _mm_xor_si128(x, MultiplyLow(x, _mm_set1_epi32(int32(0xb82f1e52))));
+    x = _mm_xor_si128(x, MultiplyLow(x, _mm_set1_epi32(int32(0xc7afe638))));
+    x = _mm_xor_si128(x, MultiplyLow(x, _mm_set1_epi32(int32(0x8d22f6e6))));
+    return x;
+}
+
+// The product of the generator matrices with every possible value of each byte of the sample index,
+// so that a group can be computed with 4 table lookups instead of one step per bit
+struct SobolByteTables
+{
+    __m128i Entries[4][256];
+
+    SobolByteTables()
+    {
+        for(uint32 byteIdx = 0; byteIdx < 4; ++byteIdx)
+        {
+            for(uint32 value = 0; value < 256; ++value)
+            {
+                uint32 result[SobolOwenGroupSize] = { };
+                for(uint32 bit = 0; bit < 8; ++bit)
+                    if(value & (1u << bit))
+                        for(uint32 dim = 0; dim < SobolOwenGroupSize; ++dim)
+                            result[dim] ^= SobolMatrices[byteIdx * 8 + bit][dim];
+                Entries[byteIdx][value] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(result));
+            }
+        }
+    }
+};
+
+static const SobolByteTables SobolTables;
+
+struct SobolOwenGroupSeeds
+{
+    uint32 IndexSeed = 0;
+    __m128i DimSeeds;
+};
+
+static SobolOwenGroupSeeds SobolOwenSeeds(uint32 groupIdx, uint32 seed)
+{
+    SobolOwenGroupSeeds seeds;
+    seeds.IndexSeed = HashUint32(HashCombine(seed, groupIdx));
+    seeds.DimSeeds = _mm_setr_epi32(int32(HashUint32(HashCombine(seeds.IndexSeed, 1))), int32(HashUint32(HashCombine(seeds.IndexSeed, 2))),
+                                    int32(HashUint32(HashCombine(seeds.IndexSeed, 3))), int32(HashUint32(HashCombine(seeds.IndexSeed, 4))));
+    return seeds;
+}
+
+// Computes a group of 4 dimensions for a sample as 0.32 fixed point values
+static __m128i SobolOwenGroup(uint32 sampleIdx, const SobolOwenGroupSeeds& seeds)
+{
+    // Shuffle the sample index so that the groups are decorrelated from each other
+    const uint32 index = NestedUniformScramble(sampleIdx, seeds.IndexSeed);
+
+    __m128i result = _mm_xor_si128(SobolTables.Entries[0][index & 0xFF], SobolTables.Entries[1][(index >> 8) & 0xFF]);
+    result = _mm_xor_si128(result, SobolTables.Entries[2][(index >> 16) & 0xFF]);
+    result = _mm_xor_si128(result, SobolTables.Entries[3][index >> 24]);
+
+    return ReverseBits(LaineKarrasPermutation(ReverseBits(result), seeds.DimSeeds));
+}
+
+// Converts 0.32 fixed point values to floats in [0, 1), keeping the top 24 bits so that the result is exact
+static DirectX::XMVECTOR FixedPointToFloat(__m128i x)
+{
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+}
+
+static float FixedPointToFloat(uint32 x)
+{
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+Float4 SampleSobolOwen4D(uint32 sampleIdx, uint32 groupIdx, uint32 seed)
+{
+    return Float4(FixedPointToFloat(SobolOwenGroup(sampleIdx, SobolOwenSeeds(groupIdx, seed))));
+}
+
+// 2D samples use the first 2 dimensions of a separate group, since those form a (0,2)-sequence
+Float2 SampleSobolOwen2D(uint32 sampleIdx, uint32 dimIdx, uint32 seed)
+{
+    const Float4 group = SampleSobolOwen4D(sampleIdx, dimIdx, seed);
+    return Float2(group.x, group.y);
+}
+
+float SampleSobolOwen(uint32 sampleIdx, uint32 dimIdx, uint32 seed)
+{
+    alignas(16) uint32 group[SobolOwenGroupSize];
+    _mm_store_si128(reinterpret_cast<__m128i*>(group), SobolOwenGroup(sampleIdx, SobolOwenSeeds(dimIdx / SobolOwenGroupSize, seed)));
+    return FixedPointToFloat(group[dimIdx % SobolOwenGroupSize]);
+}
+
+void GenerateSobolOwenSamples(float* samples, uint64 numSamples, uint64 numDims, uint32 seed)
+{
+    const uint64 numGroups = (numDims + SobolOwenGroupSize - 1) / SobolOwenGroupSize;
+    for(uint64 groupIdx = 0; groupIdx < numGroups; ++groupIdx)
+    {
+        const SobolOwenGroupSeeds seeds = SobolOwenSeeds(uint32(groupIdx), seed);
+        const uint64 firstDim = groupIdx * SobolOwenGroupSize;
+        for(uint64 sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx)
+        {
+            float* sampleDims = samples + sampleIdx * numDims;
+            const DirectX::XMVECTOR group = FixedPointToFloat(SobolOwenGroup(uint32(sampleIdx), seeds));
+            if(firstDim + SobolOwenGroupSize <= numDims)
+            {
+                _mm_storeu_ps(sampleDims + firstDim, group);
+            }
+            else
+            {
+                alignas(16) float groupDims[SobolOwenGroupSize];
+                _mm_store_ps(groupDims, group);
+                for(uint64 dimIdx = firstDim; dimIdx < numDims; ++dimIdx)
+                    sampleDims[dimIdx] = groupDims[dimIdx - firstDim];
+            }
+        }
+    }
+}
+
+void GenerateSobolOwenSamples2D(Float2* samples, uint64 numSamples, uint64 dimIdx, uint32 seed)
+{
+    const SobolOwenGroupSeeds seeds = SobolOwenSeeds(uint32(dimIdx), seed);
+    for(uint64 i = 0; i < numSamples; ++i)
+    {
+        const Float4 group = Float4(FixedPointToFloat(SobolOwenGroup(uint32(i), seeds)));
+        samples[i] = Float2(group.x, group.y);
+    }
+}
+
+// == Progressive Multi-Jittered (0,2) ============================================================
+
+// Tracks which elementary intervals are occupied for a (0,2)-net with 2^LogNumSamples points. There are
+// LogNumSamples + 1 interval shapes (2^-k x 2^(k-LogNumSamples)), each with 2^LogNumSamples intervals.
+struct ElementaryIntervals
+{
+    uint32 LogNumSamples = 0;
+    Array<uint8> Occupied;
+
+    void Init(uint32 logNumSamples, const uint32* xs, const uint32* ys, uint64 numPoints)
+    {
+        LogNumSamples = logNumSamples;
+        Occupied.Init((uint64(logNumSamples) + 1) << logNumSamples, 0);
+        for(uint64 i = 0; i < numPoints; ++i)
+            Add(xs[i], ys[i]);
+    }
+
+    uint64 Index(uint32 shapeIdx, uint64 xCell, uint64 yCell) const
+    {
+        return (uint64(shapeIdx) << LogNumSamples) + (xCell << (LogNumSamples - shapeIdx)) + yCell;
+    }
+
+    // xCell and yCell are in units of the finest strata (2^-LogNumSamples)
+    bool IsFree(uint64 xCell, uint64 yCell) const
+    {
+        for(uint32 k = 0; k <= LogNumSamples; ++k)
+            if(Occupied[Index(k, xCell >> (LogNumSamples - k), yCell >> k)])
+                return false;
+        return true;
+    }
+
+    void Add(uint32 x, uint32 y)
+    {
+        const uint64 xCell = uint64(x) >> (32 - LogNumSamples);
+        const uint64 yCell = uint64(y) >> (32 - LogNumSamples);
+        for(uint32 k = 0; k <= LogNumSamples; ++k)
+            Occupied[Index(k, xCell >> (LogNumSamples - k), yCell >> k)] = 1;
+    }
+};
+
+// Places a new point inside of a square subquadrant (given in 0.32 fixed point), picking uniformly among
+// all of the finest strata that keep the elementary intervals stratified. Returns false if there are none.
+static bool AddPMJ02Point(ElementaryIntervals& intervals, uint32 quadX, uint32 quadY, uint32 logQuadSize,
+                          uint32& outX, uint32& outY, Random& rng, Array<uint32>& xCells, Array<uint32>& yCells)
+{
+    const uint32 logNumSamples = intervals.LogNumSamples;
+    const uint32 numCells = 1u << (logNumSamples - (32 - logQuadSize));
+    const uint32 firstXCell = uint32(uint64(quadX) >> (32 - logNumSamples));
+    const uint32 firstYCell = uint32(uint64(quadY) >> (32 - logNumSamples));
+
+    // 1D stratification first, since it removes most of the candidates
+    uint32 numXCells = 0;
+    uint32 numYCells = 0;
+    for(uint32 i = 0; i < numCells; ++i)
+    {
+        if(intervals.Occupied[intervals.Index(logNumSamples, firstXCell + i, 0)] == 0)
+            xCells[numXCells++] = firstXCell + i;
+        if(intervals.Occupied[intervals.Index(0, 0, firstYCell + i)] == 0)
+            yCells[numYCells++] = firstYCell + i;
+    }
+
+    // Reservoir sampling over the valid (x, y) pairs
+    uint32 numValid = 0;
+    uint32 chosenX = 0;
+    uint32 chosenY = 0;
+    for(uint32 i = 0; i < numXCells; ++i)
+    {
+        for(uint32 j = 0; j < numYCells; ++j)
+        {
+            if(intervals.IsFree(xCells[i], yCells[j]) == false)
+                continue;
+
+            ++numValid;
+            if(rng.RandomUint() % numValid == 0)
+            {
+                chosenX = xCells[i];
+                chosenY = yCells[j];
+            }
+        }
+    }
+
+    if(numValid == 0)
+        return false;
+
+    // Jitter inside of the finest strata
+    const uint32 jitterMask = logNumSamples < 32 ? (0xFFFFFFFFu >> logNumSamples) : 0;
+    outX = uint32(uint64(chosenX) << (32 - logNumSamples)) | (rng.RandomUint() & jitterMask);
+    outY = uint32(uint64(chosenY) << (32 - logNumSamples)) | (rng.RandomUint() & jitterMask);
+    intervals.Add(outX, outY);
+    return true;
+}
+
+// Generates the sequence as 0.32 fixed point values. Returns false if a point couldn't be placed, in which case
+// the caller should try again with a different random sequence.
+static bool GeneratePMJ02(uint32* xs, uint32* ys, uint64 numSamples, Random& rng)
+{
+    Assert_(numSamples <= (1ull << 30));
+
+    uint64 logMaxSamples = 0;
+    while((1ull << logMaxSamples) < numSamples)
+        ++logMaxSamples;
+    Array<uint32> xCells(1ull << ((logMaxSamples + 1) / 2));
+    Array<uint32> yCells(1ull << ((logMaxSamples + 1) / 2));
+
+    ElementaryIntervals intervals;
+
+    xs[0] = rng.RandomUint();
+    ys[0] = rng.RandomUint();
+
+    // N is the number of samples at the start of each iteration, which is always a power of 4. This gives a
+    // grid of sqrt(N) x sqrt(N) cells with 1 sample each, and each cell is split into 4 subquadrants.
+    for(uint64 N = 1, logN = 0; N < numSamples; N *= 4, logN += 2)
+    {
+        const uint32 logQuadSize = 32 - uint32(logN / 2 + 1);
+
+        // Extend to 2N samples by placing a sample in the subquadrant that's diagonally opposite
+        // to the existing sample of each cell
+        intervals.Init(uint32(logN + 1), xs, ys, N);
+        for(uint64 i = 0; i < N && N + i < numSamples; ++i)
+        {
+            const uint32 quadX = (xs[i] >> logQuadSize) ^ 1;
+            const uint32 quadY = (ys[i] >> logQuadSize) ^ 1;
+            if(AddPMJ02Point(intervals, quadX << logQuadSize, quadY << logQuadSize, logQuadSize,
+                             xs[N + i], ys[N + i], rng, xCells, yCells) == false)
+                return false;
+        }
+
+        // Extend to 4N samples by filling the 2 subquadrants that are still empty in each cell,
+        // in a random order
+        if(2 * N >= numSamples)
+            break;
+
+        intervals.Init(uint32(logN + 2), xs, ys, 2 * N);
+        Array<uint8> flipX(N);
+        for(uint64 i = 0; i < N && 2 * N + i < numSamples; ++i)
+        {
+            const uint32 quadX = xs[i] >> logQuadSize;
+            const uint32 quadY = ys[i] >> logQuadSize;
+            flipX[i] = uint8(rng.RandomUint() & 1);
+
+            // Try the other subquadrant if the first choice can't be stratified
+            for(uint32 attempt = 0; attempt < 2; ++attempt)
+            {
+                const uint32 newQuadX = flipX[i] ? quadX ^ 1 : quadX;
+                const uint32 newQuadY = flipX[i] ? quadY : quadY ^ 1;
+                if(AddPMJ02Point(intervals, newQuadX << logQuadSize, newQuadY << logQuadSize, logQuadSize,
+                                 xs[2 * N + i], ys[2 * N + i], rng, xCells, yCells))
+                    break;
+
+                if(attempt == 1)
+                    return false;
+                flipX[i] ^= 1;
+            }
+        }
+
+        for(uint64 i = 0; i < N && 3 * N + i < numSamples; ++i)
+        {
+            const uint32 quadX = xs[i] >> logQuadSize;
+            const uint32 quadY = ys[i] >> logQuadSize;
+            const uint32 newQuadX = flipX[i] ? quadX : quadX ^ 1;
+            const uint32 newQuadY = flipX[i] ? quadY ^ 1 : quadY;
+            if(AddPMJ02Point(intervals, newQuadX << logQuadSize, newQuadY << logQuadSize, logQuadSize,
+                             xs[3 * N + i], ys[3 * N + i], rng, xCells, yCells) == false)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void GeneratePMJ02Retry(uint32* xs, uint32* ys, uint64 numSamples, Random& rng)
+{
+    const uint32 MaxAttempts = 64;
+    for(uint32 attempt = 0; attempt < MaxAttempts; ++attempt)
+        if(GeneratePMJ02(xs, ys, numSamples, rng))
+            return;
+
+    throw Exception(L"Failed to generate a PMJ02 sequence with " + ToString(numSamples) + L" samples");
+}
+
+void GeneratePMJ02Samples2D(Float2* samples, uint64 numSamples, Random& rng)
+{
+    if(numSamples == 0)
+        return;
+
+    Array<uint32> xs(numSamples);
+    Array<uint32> ys(numSamples);
+    GeneratePMJ02Retry(xs.Data(), ys.Data(), numSamples, rng);
+
+    for(uint64 i = 0; i < numSamples; ++i)
+        samples[i] = Float2(FixedPointToFloat(xs[i]), FixedPointToFloat(ys[i]));
+}
+
+// == Blue Noise ==================================================================================
+
+// Tracks the energy of every texel (a toroidally wrapped Gaussian splatted from every set texel), and
+// finds the tightest clusters and largest voids as in the void-and-cluster algorithm
+struct VoidAndCluster
+{
+    uint32 Size = 0;
+    Array<float> Kernel;
+    Array<float> Energy;
+    Array<uint8> Pattern;
+
+    void Init(uint32 size)
+    {
+        Size = size;
+        const uint64 numTexels = uint64(size) * size;
+        Kernel.Init(numTexels);
+        Energy.Init(numTexels, 0.0f);
+        Pattern.Init(numTexels, 0);
+
+        const float Sigma = 1.5f;
+        for(uint32 y = 0; y < size; ++y)
+        {
+            for(uint32 x = 0; x < size; ++x)
+            {
+                const float dx = float(std::min(x, size - x));
+                const float dy = float(std::min(y, size - y));
+                Kernel[y * size + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * Sigma * Sigma));
+            }
+        }
+    }
+
+    void Toggle(uint64 texelIdx)
+    {
+        const uint32 texelX = uint32(texelIdx % Size);
+        const uint32 texelY = uint32(texelIdx / Size);
+        const float sign = Pattern[texelIdx] ? -1.0f : 1.0f;
+        Pattern[texelIdx] ^= 1;
+
+        for(uint32 y = 0; y < Size; ++y)
+        {
+            const float* kernelRow = &Kernel[((y + Size - texelY) % Size) * Size];
+            float* energyRow = &Energy[y * Size];
+            for(uint32 x = 0; x < Size; ++x)
+                energyRow[x] += sign * kernelRow[(x + Size - texelX) % Size];
+        }
+    }
+
+    uint64 TightestCluster() const
+    {
+        uint64 result = 0;
+        float maxEnergy = -FloatMax;
+        for(uint64 i = 0; i < Energy.Size(); ++i)
+        {
+            if(Pattern[i] && Energy[i] > maxEnergy)
+            {
+                maxEnergy = Energy[i];
+                result = i;
+            }
+        }
+        return result;
+    }
+
+    uint64 LargestVoid() const
+    {
+        uint64 result = 0;
+        float minEnergy = FloatMax;
+        for(uint64 i = 0; i < Energy.Size(); ++i)
+        {
+            if(Pattern[i] == 0 && Energy[i] < minEnergy)
+            {
+                minEnergy = Energy[i];
+                result = i;
+            }
+        }
+        return result;
+    }
+};
+
+void GenerateBlueNoiseRanks(uint16* ranks, uint32 size, uint32 seed)
+{
+    const uint64 numTexels = uint64(size) * size;
+    Assert_(numTexels > 1 && numTexels <= 65536);
+
+    VoidAndCluster voidAndCluster;
+    voidAndCluster.Init(size);
+
+    // Start with a random pattern that has about 10% of the texels set
+    Random rng;
+    rng.Seed(seed);
+    const uint64 numInitial = std::max<uint64>(numTexels / 10, 1);
+    Array<uint64> shuffled(numTexels);
+    for(uint64 i = 0; i < numTexels; ++i)
+        shuffled[i] = i;
+    Shuffle(shuffled.Data(), numTexels, rng);
+    for(uint64 i = 0; i < numInitial; ++i)
+        voidAndCluster.Toggle(shuffled[i]);
+
+    // Move texels from the tightest cluster to the largest void until that converges
+    for(uint64 iteration = 0; iteration < numTexels; ++iteration)
+    {
+        const uint64 cluster = voidAndCluster.TightestCluster();
+        voidAndCluster.Toggle(cluster);
+        const uint64 largestVoid = voidAndCluster.LargestVoid();
+        voidAndCluster.Toggle(largestVoid);
+        if(largestVoid == cluster)
+            break;
+    }
+
+    Array<uint8> prototype(numTexels);
+    Array<float> prototypeEnergy(numTexels);
+    memcpy(prototype.Data(), voidAndCluster.Pattern.Data(), prototype.MemorySize());
+    memcpy(prototypeEnergy.Data(), voidAndCluster.Energy.Data(), prototypeEnergy.MemorySize());
+
+    // Ranks below the initial count come from removing the tightest clusters of the prototype
+    for(uint64 rank = numInitial; rank > 0; --rank)
+    {
+        const uint64 cluster = voidAndCluster.TightestCluster();
+        voidAndCluster.Toggle(cluster);
+        ranks[cluster] = uint16(rank - 1);
+    }
+
+    // The remaining ranks come from filling the largest voids, starting from the prototype again
+    memcpy(voidAndCluster.Pattern.Data(), prototype.Data(), prototype.MemorySize());
+    memcpy(voidAndCluster.Energy.Data(), prototypeEnergy.Data(), prototypeEnergy.MemorySize());
+    for(uint64 rank = numInitial; rank < numTexels; ++rank)
+    {
+        const uint64 largestVoid = voidAndCluster.LargestVoid();
+        voidAndCluster.Toggle(largestVoid);
+        ranks[largestVoid] = uint16(rank);
+    }
+}
+
+// == Sample Tables ===============================================================================
+
+static const uint32 SampleTablesMagic = 0x53504D53; // 'SMPS'
+static const uint32 SampleTablesVersion = 1;
+
+static uint32 AlignSampleTableOffset(uint64 offset)
+{
+    return uint32(AlignTo(offset, 16));
+}
+
+void SampleTables::Generate(const SampleTablesInit& init)
+{
+    Shutdown();
+
+    Assert_(init.NumPMJ02Sets > 0 && init.PMJ02SetSize > 0);
+    Assert_(init.BlueNoiseSize > 1);
+
+    SampleTablesHeader header;
+    header.Magic = SampleTablesMagic;
+    header.Version = SampleTablesVersion;
+    header.NumPMJ02Sets = init.NumPMJ02Sets;
+    header.PMJ02SetSize = init.PMJ02SetSize;
+    header.PMJ02Offset = AlignSampleTableOffset(sizeof(SampleTablesHeader));
+    header.BlueNoiseSize = init.BlueNoiseSize;
+    header.BlueNoiseOffset = AlignSampleTableOffset(header.PMJ02Offset + uint64(init.NumPMJ02Sets) * init.PMJ02SetSize * 2 * sizeof(uint32));
+    header.TotalSize = AlignSampleTableOffset(header.BlueNoiseOffset + uint64(init.BlueNoiseSize) * init.BlueNoiseSize * sizeof(uint16));
+
+    GeneratedData.Init(header.TotalSize);
+    uint8* data = GeneratedData.Data();
+    memset(data, 0, header.TotalSize);
+    memcpy(data, &header, sizeof(header));
+
+    uint32* pmj02 = reinterpret_cast<uint32*>(data + header.PMJ02Offset);
+    uint16* blueNoise = reinterpret_cast<uint16*>(data + header.BlueNoiseOffset);
+
+    // Every PMJ02 set gets its own random generator so that they can be generated in parallel. The blue
+    // noise mask is generated as one extra item.
+    enki::TaskSet generateTask(init.NumPMJ02Sets + 1, [&](enki::TaskSetPartition range, uint32 threadNum)
+    {
+        Array<uint32> xs(init.PMJ02SetSize);
+        Array<uint32> ys(init.PMJ02SetSize);
+
+        for(uint32 itemIdx = range.start; itemIdx < range.end; ++itemIdx)
+        {
+            if(itemIdx == init.NumPMJ02Sets)
+            {
+                GenerateBlueNoiseRanks(blueNoise, init.BlueNoiseSize, init.Seed);
+                continue;
+            }
+
+            Random rng;
+            rng.Seed(HashUint32(HashCombine(init.Seed, itemIdx)));
+            GeneratePMJ02Retry(xs.Data(), ys.Data(), init.PMJ02SetSize, rng);
+
+            uint32* setSamples = pmj02 + uint64(itemIdx) * init.PMJ02SetSize * 2;
+            for(uint32 i = 0; i < init.PMJ02SetSize; ++i)
+            {
+                setSamples[i * 2 + 0] = xs[i];
+                setSamples[i * 2 + 1] = ys[i];
+            }
+        }
+    });
+
+    enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+    taskScheduler.AddTaskSetToPipe(&generateTask);
+    taskScheduler.WaitforTaskSet(&generateTask);
+
+    Header = reinterpret_cast<const SampleTablesHeader*>(data);
+    PMJ02 = pmj02;
+    BlueNoise = blueNoise;
+}
+
+// Memory-maps the tables, so only the pages that are actually used get read from disk
+void SampleTables::Load(const wchar* filePath)
+{
+    Shutdown();
+
+    if(FileExists(filePath) == false)
+        throw Exception(L"Sample table file with path '" + std::wstring(filePath) + L"' does not exist");
+
+    File.Open(filePath);
+
+    const SampleTablesHeader* header = reinterpret_cast<const SampleTablesHeader*>(File.Data());
+    if(File.Size() < sizeof(SampleTablesHeader) || header->Magic != SampleTablesMagic ||
+       header->Version != SampleTablesVersion || header->TotalSize != File.Size())
+    {
+        File.Close();
+        throw Exception(L"'" + std::wstring(filePath) + L"' is not a valid sample table file");
+    }
+
+    Header = header;
+    PMJ02 = reinterpret_cast<const uint32*>(File.Data() + header->PMJ02Offset);
+    BlueNoise = reinterpret_cast<const uint16*>(File.Data() + header->BlueNoiseOffset);
+}
+
+void SampleTables::Save(const wchar* filePath) const
+{
+    Assert_(Initialized());
+
+    SampleFramework12::File file(filePath, FileOpenMode::Write);
+    file.Write(Size(), Data());
+}
+
+void SampleTables::Shutdown()
+{
+    Header = nullptr;
+    PMJ02 = nullptr;
+    BlueNoise = nullptr;
+    GeneratedData.Shutdown();
+    File.Close();
+}
+
+Float2 SampleTables::SamplePMJ02(uint32 setIdx, uint32 sampleIdx) const
+{
+    Assert_(Initialized());
+
+    const uint32* setSamples = PMJ02 + uint64(setIdx % Header->NumPMJ02Sets) * Header->PMJ02SetSize * 2;
+    sampleIdx %= Header->PMJ02SetSize;
+    return Float2(FixedPointToFloat(setSamples[sampleIdx * 2 + 0]), FixedPointToFloat(setSamples[sampleIdx * 2 + 1]));
+}
+
+// Each dimension reads the mask with a different toroidal offset (from the R2 sequence), so that the
+// dimensions of a pixel aren't correlated
+float SampleTables::SampleBlueNoise(uint32 x, uint32 y, uint32 dimIdx) const
+{
+    Assert_(Initialized());
+
+    const uint32 size = Header->BlueNoiseSize;
+    const uint32 offsetX = uint32(dimIdx * 0.7548776662f * size);
+    const uint32 offsetY = uint32(dimIdx * 0.5698402910f * size);
+    const uint32 texelIdx = ((y + offsetY) % size) * size + ((x + offsetX) % size);
+    return (BlueNoise[texelIdx] + 0.5f) / (size * size);
+}
+
+float SampleTables::BlueNoiseDithered(float sample, uint32 pixelX, uint32 pixelY, uint32 dimIdx) const
+{
+    const float dithered = sample + SampleBlueNoise(pixelX, pixelY, dimIdx);
+    return dithered >= 1.0f ? dithered - 1.0f : dithered;
+}
+
+float SampleTables::SampleSobolOwenDithered(uint32 sampleIdx, uint32 dimIdx, uint32 seed, uint32 pixelX, uint32 pixelY) const
+{
+    return BlueNoiseDithered(SampleSobolOwen(sampleIdx, dimIdx, seed), pixelX, pixelY, dimIdx);
+}
+
+}
@@ -0,0 +1,107 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+#include "..\\SF12_Math.h"
+#include "..\\FileIO.h"
+#include "..\\Containers.h"
+
+namespace SampleFramework12
+{
+
+struct RawBuffer;
+
+// == Owen-scrambled Sobol ========================================================================
+
+// Shuffled and Owen-scrambled Sobol sequence, using the hash-based scrambling from "Practical Hash-based
+// Owen Scrambling" [Burley 2020]. Dimensions are handled in groups of 4 that each use the first 4 Sobol
+// dimensions, with the sample index shuffled by a different seed for every group. This means that any
+// number of dimensions can be sampled, and that dimensions 0 and 1 of every group form a (0,2)-sequence.
+static const uint32 SobolOwenGroupSize = 4;
+
+float SampleSobolOwen(uint32 sampleIdx, uint32 dimIdx, uint32 seed);
+Float2 SampleSobolOwen2D(uint32 sampleIdx, uint32 dimIdx, uint32 seed);
+Float4 SampleSobolOwen4D(uint32 sampleIdx, uint32 groupIdx, uint32 seed);
+
+// Generates numDims dimensions for each sample, stored as samples[sampleIdx * numDims + dimIdx]
+void GenerateSobolOwenSamples(float* samples, uint64 numSamples, uint64 numDims, uint32 seed);
+void GenerateSobolOwenSamples2D(Float2* samples, uint64 numSamples, uint64 dimIdx, uint32 seed);
+
+// == Progressive Multi-Jittered (0,2) ============================================================
+
+// Generates a progressive multi-jittered (0,2) sequence [Christensen et al. 2018]. Every prefix with a power
+// of 2 number of samples is stratified in all of the 2D elementary intervals, and is also multi-jittered.
+void GeneratePMJ02Samples2D(Float2* samples, uint64 numSamples, Random& rng);
+
+// == Blue Noise ==================================================================================
+
+// Generates a tileable blue noise dither mask with the void-and-cluster method [Ulichney 1993]. Each texel gets a
+// unique rank in [0, size * size), ranks that are close together are spread out as far as possible in the tile.
+void GenerateBlueNoiseRanks(uint16* ranks, uint32 size, uint32 seed);
+
+// == Sample Tables ===============================================================================
+
+struct SampleTablesInit
+{
+    uint32 NumPMJ02Sets = 32;
+    uint32 PMJ02SetSize = 4096;
+    uint32 BlueNoiseSize = 64;
+    uint32 Seed = 0;
+};
+
+// Layout of the table data, which is the same on disk, in memory, and in GPU buffers. Offsets are in bytes from
+// the start of the data. PMJ02 samples are stored as pairs of 0.32 fixed point values, blue noise is stored as
+// the rank of every texel.
+struct SampleTablesHeader
+{
+    uint32 Magic = 0;
+    uint32 Version = 0;
+    uint32 TotalSize = 0;
+    uint32 NumPMJ02Sets = 0;
+    uint32 PMJ02SetSize = 0;
+    uint32 PMJ02Offset = 0;
+    uint32 BlueNoiseSize = 0;
+    uint32 BlueNoiseOffset = 0;
+};
+
+// Pre-generated PMJ02 sets and a blue noise mask. The tables can be generated at runtime, saved to disk and then
+// memory-mapped on later runs, or uploaded to a RawBuffer and read in shaders through SampleSequences.hlsl.
+struct SampleTables
+{
+    const SampleTablesHeader* Header = nullptr;
+    const uint32* PMJ02 = nullptr;
+    const uint16* BlueNoise = nullptr;
+
+    Array<uint8> GeneratedData;
+    MappedFile File;
+
+    void Generate(const SampleTablesInit& init);
+    void Load(const wchar* filePath);
+    void Save(const wchar* filePath) const;
+    void Shutdown();
+
+    bool Initialized() const { return Header != nullptr; }
+    const uint8* Data() const { return reinterpret_cast<const uint8*>(Header); }
+    uint64 Size() const { return Header ? Header->TotalSize : 0; }
+
+    Float2 SamplePMJ02(uint32 setIdx, uint32 sampleIdx) const;
+    float SampleBlueNoise(uint32 x, uint32 y, uint32 dimIdx = 0) const;
+
+    // Applies a toroidal shift from the blue noise mask to a sample (a Cranley-Patterson rotation), so that the
+    // error of neighboring pixels is distributed as blue noise [Georgiev and Fajardo 2016]
+    float BlueNoiseDithered(float sample, uint32 pixelX, uint32 pixelY, uint32 dimIdx) const;
+    float SampleSobolOwenDithered(uint32 sampleIdx, uint32 dimIdx, uint32 seed, uint32 pixelX, uint32 pixelY) const;
+
+    // Defined in GraphicsTypes.cpp, so that generating and loading the tables doesn't depend on D3D12
+    void CreateBuffer(RawBuffer& buffer) const;
+};
+
+}
@@ -18,6 +18,8 @@
 #include "..\\FileIO.h"
 #include "..\\MurmurHash.h"
 #include "..\\Containers.h"
+#include "..\\Timer.h"
+#include "..\\Tasks.h"
 
 using std::vector;
 using std::wstring;
@@ -59,6 +61,101 @@ static Hash MakeCompilerHash()
 
 static Hash CompilerHash = MakeCompilerHash();
 
+// == Statistics ==================================================================================
+
+// Counters are updated from the compilation tasks
+struct ShaderCompilationCounters
+{
+    volatile int64 NumShaders;
+    volatile int64 NumIndexHits;
+    volatile int64 NumCacheHits;
+    volatile int64 NumCompiled;
+    volatile int64 NumSourceFileReads;
+    volatile int64 NumSourceFileCacheHits;
+    volatile int64 CompileTimeUS;
+};
+
+static ShaderCompilationCounters Counters = { };
+
+static void IncrementCounter(volatile int64& counter, int64 value = 1)
+{
+    InterlockedExchangeAdd64(&counter, value);
+}
+
+// == Source file cache ===========================================================================
+
+// Source files are read once and re-used by every shader and variant that includes them. Entries
+// are invalidated by UpdateShaders when the file changes on disk.
+struct SourceFile
+{
+    uint64 TimeStamp = 0;
+    string Contents;
+};
+
+static map<wstring, SourceFile> SourceFiles;
+static SRWLOCK SourceFilesLock = SRWLOCK_INIT;
+
+static bool ReadSourceFile(const wchar* path, string& contents)
+{
+    AcquireSRWLockShared(&SourceFilesLock);
+
+    auto iter = SourceFiles.find(path);
+    const bool cached = iter != SourceFiles.end();
+    if(cached)
+        contents = iter->second.Contents;
+
+    ReleaseSRWLockShared(&SourceFilesLock);
+
+    if(cached)
+    {
+        IncrementCounter(Counters.NumSourceFileCacheHits);
+        return true;
+    }
+
+    if(FileExists(path) == false)
+        return false;
+
+    // Grab the time stamp before reading so that a change during the read is picked up later
+    SourceFile sourceFile;
+    sourceFile.TimeStamp = GetFileTimestamp(path);
+    sourceFile.Contents = ReadFileAsString(path);
+    contents = sourceFile.Contents;
+
+    AcquireSRWLockExclusive(&SourceFilesLock);
+
+    SourceFiles.emplace(path, std::move(sourceFile));
+
+    ReleaseSRWLockExclusive(&SourceFilesLock);
+
+    IncrementCounter(Counters.NumSourceFileReads);
+
+    return true;
+}
+
+static uint64 GetSourceFileTimestamp(const wchar* path)
+{
+    AcquireSRWLockShared(&SourceFilesLock);
+
+    auto iter = SourceFiles.find(path);
+    const uint64 timeStamp = iter != SourceFiles.end() ? iter->second.TimeStamp : 0;
+
+    ReleaseSRWLockShared(&SourceFilesLock);
+
+    if(timeStamp == 0 && FileExists(path))
+        return GetFileTimestamp(path);
+
+    return timeStamp;
+}
+
+static void InvalidateSourceFile(const wstring& path)
+{
+    AcquireSRWLockExclusive(&SourceFilesLock);
+
+    SourceFiles.erase(path);
+
+    ReleaseSRWLockExclusive(&SourceFilesLock);
+}
+
 static string GetExpandedShaderCode(const wchar* path, GrowableList<wstring>& filePaths)
 {
     for(uint64 i = 0; i < filePaths.Count(); ++i)
@@ -67,7 +164,9 @@ static string GetExpandedShaderCode(const wchar* path, GrowableList<wstring>& fi
 
     filePaths.Add(path);
 
-    string fileContents = ReadFileAsString(path);
+    string fileContents;
+    if(ReadSourceFile(path, fileContents) == false)
+        throw Exception(L"Shader file " + std::wstring(path) + L" does not exist");
 
     wstring fileDirectory = GetDirectoryFromFilePath(path);
     if(fileDirectory.length() > 0)
@@ -171,6 +270,211 @@ static wstring MakeShaderCacheName(const std::string& shaderCode, const char* fu
     return cacheDir + codeHash.ToString() + L".cache";
 }
 
+static void CreateCacheDirectory()
+{
+    if(DirectoryExists(baseCacheDir.c_str()) == false)
+        CreateDirectory(baseCacheDir.c_str(), nullptr);
+
+    if(DirectoryExists(cacheDir.c_str()) == false)
+        CreateDirectory(cacheDir.c_str(), nullptr);
+}
+
+// == Cache index =================================================================================
+
+// The cache index maps each shader (file, entry point, profile and defines) to its cached
+// bytecode and to the time stamps of the files it depends on. If none of the dependencies have
+// changed, the bytecode can be loaded without reading and hashing the source code.
+
+static const uint64 IndexVersion = 1;
+static const wstring cacheIndexPath = cacheDir + L"Index.cache";
+
+struct ShaderCacheIndexEntry
+{
+    wstring CacheName;
+    vector<wstring> Dependencies;
+    vector<uint64> TimeStamps;
+};
+
+static map<wstring, ShaderCacheIndexEntry> CacheIndex;
+static bool CacheIndexLoaded = false;
+static bool CacheIndexDirty = false;
+static SRWLOCK CacheIndexLock = SRWLOCK_INIT;
+
+static void WriteIndexString(const File& file, const wstring& str)
+{
+    file.Write<uint64>(str.length());
+    file.Write(str.length() * sizeof(wchar), str.data());
+}
+
+static wstring ReadIndexString(const File& file)
+{
+    uint64 length = 0;
+    file.Read(length);
+    if(length * sizeof(wchar) > file.Size())
+        throw Exception(L"Invalid shader cache index");
+
+    wstring str(length, L'\0');
+    file.Read(length * sizeof(wchar), &str[0]);
+    return str;
+}
+
+static wstring MakeShaderKey(const wchar* path, const char* functionName, const char* profile,
+                             const D3D_SHADER_MACRO* defines)
+{
+    wstring key = path;
+    key += L"|";
+    if(functionName != nullptr)
+        key += AnsiToWString(functionName);
+    key += L"|";
+    key += AnsiToWString(profile);
+    key += L"|";
+    key += AnsiToWString(MakeDefinesString(defines).c_str());
+
+    return key;
+}
+
+// Must be called with the index lock held
+static void LoadCacheIndex()
+{
+    if(CacheIndexLoaded)
+        return;
+
+    CacheIndexLoaded = true;
+
+    if(FileExists(cacheIndexPath.c_str()) == false)
+        return;
+
+    try
+    {
+        File file(cacheIndexPath.c_str(), FileOpenMode::Read);
+
+        uint64 cacheVersion = 0;
+        uint64 indexVersion = 0;
+        Hash compilerHash;
+        file.Read(cacheVersion);
+        file.Read(indexVersion);
+        file.Read(compilerHash);
+
+        // The index is discarded if the compiler changed, the cached shaders are recompiled anyway
+        if(cacheVersion != CacheVersion || indexVersion != IndexVersion || (compilerHash == CompilerHash) == false)
+            return;
+
+        uint64 numEntries = 0;
+        file.Read(numEntries);
+        if(numEntries > file.Size())
+            throw Exception(L"Invalid shader cache index");
+        for(uint64 i = 0; i < numEntries; ++i)
+        {
+            wstring key = ReadIndexString(file);
+
+            ShaderCacheIndexEntry entry;
+            entry.CacheName = ReadIndexString(file);
+
+            uint64 numDependencies = 0;
+            file.Read(numDependencies);
+            if(numDependencies > file.Size())
+                throw Exception(L"Invalid shader cache index");
+
+            entry.Dependencies.resize(numDependencies);
+            entry.TimeStamps.resize(numDependencies);
+            for(uint64 depIdx = 0; depIdx < numDependencies; ++depIdx)
+            {
+                entry.Dependencies[depIdx] = ReadIndexString(file);
+                file.Read(entry.TimeStamps[depIdx]);
+            }
+
+            CacheIndex[key] = std::move(entry);
+        }
+    }
+    catch(Exception&)
+    {
+        // A truncated or corrupt index is rebuilt
+        WriteLog("Discarding shader cache index %ls\n", cacheIndexPath.c_str());
+        CacheIndex.clear();
+    }
+}
+
+static void SaveCacheIndex()
+{
+    AcquireSRWLockExclusive(&CacheIndexLock);
+
+    if(CacheIndexDirty)
+    {
+        CreateCacheDirectory();
+
+        File file(cacheIndexPath.c_str(), FileOpenMode::Write);
+        file.Write(CacheVersion);
+        file.Write(IndexVersion);
+        file.Write(CompilerHash);
+        file.Write<uint64>(CacheIndex.size());
+
+        for(const auto& indexEntry : CacheIndex)
+        {
+            const ShaderCacheIndexEntry& entry = indexEntry.second;
+            WriteIndexString(file, indexEntry.first);
+            WriteIndexString(file, entry.CacheName);
+            file.Write<uint64>(entry.Dependencies.size());
+            for(uint64 depIdx = 0; depIdx < entry.Dependencies.size(); ++depIdx)
+            {
+                WriteIndexString(file, entry.Dependencies[depIdx]);
+                file.Write(entry.TimeStamps[depIdx]);
+            }
+        }
+
+        CacheIndexDirty = false;
+    }
+
+    ReleaseSRWLockExclusive(&CacheIndexLock);
+}
+
+// Loads the cached bytecode if none of the shader's dependencies changed since it was cached
+static bool LookupCacheIndex(const wstring& shaderKey, GrowableList<wstring>& filePaths, Array<uint8>& byteCode)
+{
+    AcquireSRWLockExclusive(&CacheIndexLock);
+
+    LoadCacheIndex();
+
+    ShaderCacheIndexEntry entry;
+    auto iter = CacheIndex.find(shaderKey);
+    const bool found = iter != CacheIndex.end();
+    if(found)
+        entry = iter->second;
+
+    ReleaseSRWLockExclusive(&CacheIndexLock);
+
+    if(found == false || FileExists(entry.CacheName.c_str()) == false)
+        return false;
+
+    for(uint64 depIdx = 0; depIdx < entry.Dependencies.size(); ++depIdx)
+        if(GetSourceFileTimestamp(entry.Dependencies[depIdx].c_str()) != entry.TimeStamps[depIdx])
+            return false;
+
+    ReadFileAsByteArray(entry.CacheName.c_str(), byteCode);
+
+    for(const wstring& dependency : entry.Dependencies)
+        filePaths.Add(dependency);
+
+    return true;
+}
+
+static void UpdateCacheIndex(const wstring& shaderKey, const wstring& cacheName, const GrowableList<wstring>& filePaths)
+{
+    ShaderCacheIndexEntry entry;
+    entry.CacheName = cacheName;
+    for(uint64 i = 0; i < filePaths.Count(); ++i)
+    {
+        entry.Dependencies.push_back(filePaths[i]);
+        entry.TimeStamps.push_back(GetSourceFileTimestamp(filePaths[i].c_str()));
+    }
+
+    AcquireSRWLockExclusive(&CacheIndexLock);
+
+    CacheIndex[shaderKey] = std::move(entry);
+    CacheIndexDirty = true;
+
+    ReleaseSRWLockExclusive(&CacheIndexLock);
+}
+
 static HRESULT CompileShaderDXC(const wchar* path, const D3D_SHADER_MACRO* defines, const char* functionName,
                                 const char* profileString, IDxcBlobPtr& compiledShader, IDxcBlobEncodingPtr& errorMessages)
 {
@@ -242,6 +546,8 @@ static HRESULT CompileShaderDXC(const wchar* path, const D3D_SHADER_MACRO* defin
     return hr;
 }
 
+static SRWLOCK ErrorMessageLock = SRWLOCK_INIT;
+
 static void CompileShader(const wchar* path, const char* functionName, ShaderType type,
                           const D3D_SHADER_MACRO* defines, GrowableList<wstring>& filePaths,
                           Array<uint8>& byteCode)
@@ -256,6 +562,15 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
     Assert_(profileIdx < ArraySize_(ProfileStrings));
     const char* profileString = ProfileStrings[profileIdx];
 
+    IncrementCounter(Counters.NumShaders);
+
+    wstring shaderKey = MakeShaderKey(path, functionName, profileString, defines);
+    if(LookupCacheIndex(shaderKey, filePaths, byteCode))
+    {
+        IncrementCounter(Counters.NumIndexHits);
+        return;
+    }
+
     // Make a hash off the expanded shader code
     string shaderCode = GetExpandedShaderCode(path, filePaths);
     wstring cacheName = MakeShaderCacheName(shaderCode, functionName, profileString, defines);
@@ -263,6 +578,8 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
     if(FileExists(cacheName.c_str()))
     {
         ReadFileAsByteArray(cacheName.c_str(), byteCode);
+        UpdateCacheIndex(shaderKey, cacheName, filePaths);
+        IncrementCounter(Counters.NumCacheHits);
         return;
     }
 
@@ -283,7 +600,11 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
         IDxcBlobPtr compiledShader;
         IDxcBlobEncodingPtr errorMessages;
 
+        Timer compileTimer;
         HRESULT hr = CompileShaderDXC(path, defines, functionName, profileString, compiledShader, errorMessages);
+        compileTimer.Update();
+        IncrementCounter(Counters.CompileTimeUS, compileTimer.ElapsedMicroseconds());
+
         if(FAILED(hr))
         {
             if(errorMessages)
@@ -291,10 +612,22 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
                 const char* errMsgStr = reinterpret_cast<const char*>(errorMessages->GetBufferPointer());
                 std::wstring fullMessage = MakeString(L"Error compiling shader file \"%s\" - %hs", path, errMsgStr);
 
-                // Pop up a message box allowing user to retry compilation
+                // Pop up a message box allowing user to retry compilation. Shaders can be compiled on
+                // multiple threads, so only show one message box at a time.
+                AcquireSRWLockExclusive(&ErrorMessageLock);
                 int32 retVal = MessageBoxW(nullptr, fullMessage.c_str(), L"Shader Compilation Error", MB_RETRYCANCEL);
+                ReleaseSRWLockExclusive(&ErrorMessageLock);
+
                 if(retVal != IDRETRY)
                     throw DXException(hr, fullMessage.c_str());
+
+                // The source has probably been edited, so re-read it and update the cache name
+                for(uint64 i = 0; i < filePaths.Count(); ++i)
+                    InvalidateSourceFile(filePaths[i]);
+
+                filePaths.RemoveAll();
+                shaderCode = GetExpandedShaderCode(path, filePaths);
+                cacheName = MakeShaderCacheName(shaderCode, functionName, profileString, defines);
             }
             else
             {
@@ -305,21 +638,22 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
         else
         {
             // Create the cache directory if it doesn't exist
-            if(DirectoryExists(baseCacheDir.c_str()) == false)
-                Win32Call(CreateDirectory(baseCacheDir.c_str(), nullptr));
+            CreateCacheDirectory();
 
-            if(DirectoryExists(cacheDir.c_str()) == false)
-                Win32Call(CreateDirectory(cacheDir.c_str(), nullptr));
+            {
+                File cacheFile(cacheName.c_str(), FileOpenMode::Write);
 
-            File cacheFile(cacheName.c_str(), FileOpenMode::Write);
+                // Write the compiled shader to disk
+                const uint64 shaderSize = compiledShader->GetBufferSize();
+                cacheFile.Write(shaderSize, compiledShader->GetBufferPointer());
 
-            // Write the compiled shader to disk
-            const uint64 shaderSize = compiledShader->GetBufferSize();
-            cacheFile.Write(shaderSize, compiledShader->GetBufferPointer());
+                // Return the compiled shader bytecode
+                byteCode.Init(shaderSize);
+                memcpy(byteCode.Data(), compiledShader->GetBufferPointer(), shaderSize);
+            }
 
-            // Return the compiled shader bytecode
-            byteCode.Init(shaderSize);
-            memcpy(byteCode.Data(), compiledShader->GetBufferPointer(), shaderSize);
+            UpdateCacheIndex(shaderKey, cacheName, filePaths);
+            IncrementCounter(Counters.NumCompiled);
 
             return;
         }
@@ -354,6 +688,9 @@ static void CompileShader(CompiledShader* shader)
     CompileShader(shader->FilePath.c_str(), functionName, shader->Type, defines, filePaths, shader->ByteCode);
     shader->ByteCodeHash = GenerateHash(shader->ByteCode.Data(), int(shader->ByteCode.Size()));
 
+    // Shaders can be compiled on multiple threads, so the whole file list needs to be locked
+    AcquireSRWLockExclusive(&ShaderFilesLock);
+
     for(uint64 fileIdx = 0; fileIdx < filePaths.Count(); ++ fileIdx)
     {
         const wstring& filePath = filePaths[fileIdx];
@@ -370,12 +707,9 @@ static void CompileShader(CompiledShader* shader)
         if(shaderFile == nullptr)
         {
             shaderFile = new ShaderFile(filePath);
-
-            AcquireSRWLockExclusive(&ShaderFilesLock);
+            shaderFile->TimeStamp = GetSourceFileTimestamp(filePath.c_str());
 
             ShaderFiles.Add(shaderFile);
-
-            ReleaseSRWLockExclusive(&ShaderFilesLock);
         }
 
         bool containsShader = false;
@@ -391,6 +725,112 @@ static void CompileShader(CompiledShader* shader)
         if(containsShader == false)
             shaderFile->Shaders.Add(shader);
     }
+
+    ReleaseSRWLockExclusive(&ShaderFilesLock);
+}
+
+static void CompileShaderWithRetries(CompiledShader* shader)
+{
+    // Retry a few times to avoid file conflicts with text editors
+    const uint64 NumRetries = 10;
+    for(uint64 retryCount = 0; retryCount < NumRetries; ++retryCount)
+    {
+        try
+        {
+            CompileShader(shader);
+            break;
+        }
+        catch(Win32Exception& exception)
+        {
+            if(retryCount == NumRetries - 1)
+                throw exception;
+            Sleep(15);
+        }
+    }
+}
+
+// == Parallel compilation ========================================================================
+
+static bool BatchActive = false;
+static GrowableList<CompiledShader*> BatchShaders;
+
+// Compiles a list of shaders on the worker threads. Should only be called from the main thread.
+static void CompileShaders(CompiledShader* const* shaders, uint64 numShaders, bool retry)
+{
+    if(numShaders == 0)
+        return;
+
+    if(numShaders == 1)
+    {
+        if(retry)
+            CompileShaderWithRetries(shaders[0]);
+        else
+            CompileShader(shaders[0]);
+
+        return;
+    }
+
+    enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+
+    // Exceptions can't cross thread boundaries, so the first one is re-thrown on this thread
+    std::exception_ptr firstException;
+    SRWLOCK exceptionLock = SRWLOCK_INIT;
+
+    enki::TaskSet compileTask(uint32(numShaders), [&](enki::TaskSetPartition range, uint32 threadNum)
+    {
+        for(uint32 i = range.start; i < range.end; ++i)
+        {
+            try
+            {
+                if(retry)
+                    CompileShaderWithRetries(shaders[i]);
+                else
+                    CompileShader(shaders[i]);
+            }
+            catch(...)
+            {
+                AcquireSRWLockExclusive(&exceptionLock);
+                if(firstException == nullptr)
+                    firstException = std::current_exception();
+                ReleaseSRWLockExclusive(&exceptionLock);
+            }
+        }
+    });
+
+    taskScheduler.AddTaskSetToPipe(&compileTask);
+    taskScheduler.WaitforTaskSet(&compileTask);
+
+    if(firstException != nullptr)
+        std::rethrow_exception(firstException);
+}
+
+void BeginShaderBatch()
+{
+    Assert_(BatchActive == false);
+    BatchActive = true;
+}
+
+void EndShaderBatch()
+{
+    Assert_(BatchActive);
+    BatchActive = false;
+
+    Timer timer;
+    ShaderCompilationStats statsBefore = GetShaderCompilationStats();
+
+    CompileShaders(BatchShaders.Data(), BatchShaders.Count(), false);
+    SaveCacheIndex();
+
+    for(uint64 i = 0; i < BatchShaders.Count(); ++i)
+        BatchShaders[i]->InBatch = false;
+
+    timer.Update();
+    ShaderCompilationStats stats = GetShaderCompilationStats();
+    WriteLog("Built %llu shaders in %.2fms (%llu index hits, %llu cache hits, %llu compiled)\n",
+             BatchShaders.Count(), timer.ElapsedMillisecondsD(), stats.NumIndexHits - statsBefore.NumIndexHits,
+             stats.NumCacheHits - statsBefore.NumCacheHits, stats.NumCompiled - statsBefore.NumCompiled);
+
+    BatchShaders.RemoveAll();
 }
 
 CompiledShaderPtr CompileFromFile(const wchar* path, const char* functionName,
@@ -402,7 +842,15 @@ CompiledShaderPtr CompileFromFile(const wchar* path, const char* functionName,
     }
 
     CompiledShader* compiledShader = new CompiledShader(path, functionName, compileOpts, type);
-    CompileShader(compiledShader);
+
+    // Shaders in a batch are compiled in parallel by EndShaderBatch
+    if(BatchActive)
+    {
+        compiledShader->InBatch = true;
+        BatchShaders.Add(compiledShader);
+    }
+    else
+        CompileShaders(&compiledShader, 1, false);
 
     AcquireSRWLockExclusive(&CompiledShadersLock);
 
@@ -422,54 +870,64 @@ bool UpdateShaders(bool updateAll)
     static uint64 currFile = 0;
 
     const uint64 numShadersToCheck = updateAll ? numShaderFiles : 1;
-    bool shaderChanged = false;
+
+    // Gather the shaders that depend on the changed files, so that a shader that depends on
+    // multiple changed files is only compiled once
+    GrowableList<CompiledShader*> changedShaders;
 
     for(uint64 i = 0; i < numShadersToCheck; ++i)
     {
         currFile = (currFile + 1) % uint64(numShaderFiles);
 
         ShaderFile* file = ShaderFiles[currFile];
-        const uint64 newTimeStamp = GetFileTimestamp(file->FilePath.c_str());
-        if(file->TimeStamp == 0)
-        {
-            file->TimeStamp = newTimeStamp;
-            return false;
-        }
+        if(FileExists(file->FilePath.c_str()) == false)
+            continue;
 
+        const uint64 newTimeStamp = GetFileTimestamp(file->FilePath.c_str());
         if(file->TimeStamp < newTimeStamp)
         {
             WriteLog("Hot-swapping shaders for %ls\n", file->FilePath.c_str());
             file->TimeStamp = newTimeStamp;
-            for(uint64 fileIdx = 0; fileIdx < file->Shaders.Count(); ++fileIdx)
+            InvalidateSourceFile(file->FilePath);
+
+            for(uint64 shaderIdx = 0; shaderIdx < file->Shaders.Count(); ++shaderIdx)
             {
-                // Retry a few times to avoid file conflicts with text editors
-                const uint64 NumRetries = 10;
-                for(uint64 retryCount = 0; retryCount < NumRetries; ++retryCount)
-                {
-                    try
-                    {
-                        CompiledShader* shader = file->Shaders[fileIdx];
-                        CompileShader(shader);
-                        break;
-                    }
-                    catch(Win32Exception& exception)
-                    {
-                        if(retryCount == NumRetries - 1)
-                            throw exception;
-                        Sleep(15);
-                    }
-                }
-            }
+                CompiledShader* shader = file->Shaders[shaderIdx];
+
+                bool alreadyAdded = false;
+                for(uint64 changedIdx = 0; changedIdx < changedShaders.Count(); ++changedIdx)
+                    alreadyAdded = alreadyAdded || changedShaders[changedIdx] == shader;
 
-            shaderChanged = true;
+                if(alreadyAdded == false)
+                    changedShaders.Add(shader);
+            }
         }
     }
 
-    return shaderChanged;
+    CompileShaders(changedShaders.Data(), changedShaders.Count(), true);
+    SaveCacheIndex();
+
+    return changedShaders.Count() > 0;
+}
+
+ShaderCompilationStats GetShaderCompilationStats()
+{
+    ShaderCompilationStats stats;
+    stats.NumShaders = uint64(Counters.NumShaders);
+    stats.NumIndexHits = uint64(Counters.NumIndexHits);
+    stats.NumCacheHits = uint64(Counters.NumCacheHits);
+    stats.NumCompiled = uint64(Counters.NumCompiled);
+    stats.NumSourceFileReads = uint64(Counters.NumSourceFileReads);
+    stats.NumSourceFileCacheHits = uint64(Counters.NumSourceFileCacheHits);
+    stats.CompileTime = Counters.CompileTimeUS / 1000.0;
+
+    return stats;
 }
 
 void ShutdownShaders()
 {
+    SaveCacheIndex();
+
     for(uint64 i = 0; i < ShaderFiles.Count(); ++i)
         delete ShaderFiles[i];
 
@@ -67,6 +67,7 @@ public:
     Array<uint8> ByteCode;
     ShaderType Type;
     Hash ByteCodeHash;
+    bool InBatch = false;
 
     CompiledShader(const wchar* filePath, const char* functionName,
                    const CompileOptions& compileOptions, ShaderType type) : FilePath(filePath),
@@ -110,6 +111,7 @@ public:
     D3D12_SHADER_BYTECODE ByteCode() const
     {
         Assert_(ptr != nullptr);
+        AssertMsg_(ptr->InBatch == false, "Shader byte code was read before EndShaderBatch compiled it");
         D3D12_SHADER_BYTECODE byteCode;
         byteCode.pShaderBytecode = ptr->ByteCode.Data();
         byteCode.BytecodeLength = ptr->ByteCode.Size();
@@ -127,7 +129,25 @@ typedef CompiledShaderPtr ShaderPtr;
 CompiledShaderPtr CompileFromFile(const wchar* path, const char* functionName, ShaderType type,
                                   const CompileOptions& compileOpts = CompileOptions());
 
+// Shaders that are requested with CompileFromFile between BeginShaderBatch and EndShaderBatch
+// are compiled in parallel by EndShaderBatch. Their byte code is not available until then.
+void BeginShaderBatch();
+void EndShaderBatch();
+
 bool UpdateShaders(bool updateAll);
 void ShutdownShaders();
 
+struct ShaderCompilationStats
+{
+    uint64 NumShaders = 0;              // Shaders that were requested (including hot-reloads)
+    uint64 NumIndexHits = 0;            // Loaded through the cache index without reading the source
+    uint64 NumCacheHits = 0;            // Loaded from the cache after hashing the expanded source
+    uint64 NumCompiled = 0;             // Compiled with DXC
+    uint64 NumSourceFileReads = 0;      // Source files that were read from disk
+    uint64 NumSourceFileCacheHits = 0;  // Source files that were already read
+    double CompileTime = 0.0;           // Total time spent in DXC (in milliseconds)
+};
+
+ShaderCompilationStats GetShaderCompilationStats();
+
 }
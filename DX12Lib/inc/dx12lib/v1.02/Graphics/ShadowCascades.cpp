@@ -0,0 +1,681 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+#include "ShadowHelper.h"
+#include "Camera.h"
+
+#include <Utility.h>
+
+namespace SampleFramework12
+{
+
+namespace ShadowHelper
+{
+
+// Transforms from [-1,1] post-projection space to [0,1] UV space
+Float4x4 ShadowScaleOffsetMatrix = Float4x4(Float4(0.5f,  0.0f, 0.0f, 0.0f),
+                                            Float4(0.0f, -0.5f, 0.0f, 0.0f),
+                                            Float4(0.0f,  0.0f, 1.0f, 0.0f),
+                                            Float4(0.5f,  0.5f, 0.0f, 1.0f));
+
+static const float MinDistance = 0.0f;
+static const float MaxDistance = 1.0f;
+
+// Compute the split distances based on the partitioning mode
+static void ComputeCascadeSplits(const Camera& camera, float* cascadeSplits)
+{
+    if(camera.IsOrthographic())
+    {
+        for(uint32 i = 0; i < NumCascades; ++i)
+            cascadeSplits[i] = Lerp(MinDistance, MaxDistance, (i + 1.0f) / NumCascades);
+    }
+    else
+    {
+        float lambda = 0.5f;
+
+        float nearClip = camera.NearClip();
+        float farClip = camera.FarClip();
+        float clipRange = farClip - nearClip;
+
+        float minZ = nearClip + MinDistance * clipRange;
+        float maxZ = nearClip + MaxDistance * clipRange;
+
+        float range = maxZ - minZ;
+        float ratio = maxZ / minZ;
+
+        for(uint32 i = 0; i < NumCascades; ++i)
+        {
+            float p = (i + 1) / static_cast<float>(NumCascades);
+            float log = minZ * std::pow(ratio, p);
+            float uniform = minZ + range * p;
+            float d = lambda * (log - uniform) + uniform;
+            cascadeSplits[i] = (d - nearClip) / clipRange;
+        }
+    }
+}
+
+void PrepareCascades(const Float3& lightDir, uint64 shadowMapSize, bool stabilize, const Camera& camera,
+                     SunShadowConstantsBase& constants, OrthographicCamera* cascadeCameras)
+{
+    float cascadeSplits[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    ComputeCascadeSplits(camera, cascadeSplits);
+
+    Float4x4 c0Matrix;
+
+    // Prepare the projections ofr each cascade
+    for(uint64 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
+    {
+        // Get the 8 points of the view frustum in world space
+        Float3 frustumCornersWS[8] =
+        {
+            Float3(-1.0f,  1.0f, 0.0f),
+            Float3( 1.0f,  1.0f, 0.0f),
+            Float3( 1.0f, -1.0f, 0.0f),
+            Float3(-1.0f, -1.0f, 0.0f),
+            Float3(-1.0f,  1.0f, 1.0f),
+            Float3( 1.0f,  1.0f, 1.0f),
+            Float3( 1.0f, -1.0f, 1.0f),
+            Float3(-1.0f, -1.0f, 1.0f),
+        };
+
+        float prevSplitDist = cascadeIdx == 0 ? MinDistance : cascadeSplits[cascadeIdx - 1];
+        float splitDist = cascadeSplits[cascadeIdx];
+
+        Float4x4 invViewProj = Float4x4::Invert(camera.ViewProjectionMatrix());
+        for(uint64 i = 0; i < 8; ++i)
+            frustumCornersWS[i] = Float3::Transform(frustumCornersWS[i], invViewProj);
+
+        // Get the corners of the current cascade slice of the view frustum
+        for(uint64 i = 0; i < 4; ++i)
+        {
+            Float3 cornerRay = frustumCornersWS[i + 4] - frustumCornersWS[i];
+            Float3 nearCornerRay = cornerRay * prevSplitDist;
+            Float3 farCornerRay = cornerRay * splitDist;
+            frustumCornersWS[i + 4] = frustumCornersWS[i] + farCornerRay;
+            frustumCornersWS[i] = frustumCornersWS[i] + nearCornerRay;
+        }
+
+        // Calculate the centroid of the view frustum slice
+        Float3 frustumCenter = Float3(0.0f);
+        for(uint64 i = 0; i < 8; ++i)
+            frustumCenter += frustumCornersWS[i];
+        frustumCenter *= (1.0f / 8.0f);
+
+        // Pick the up vector to use for the light camera
+        Float3 upDir = camera.Right();
+
+        Float3 minExtents;
+        Float3 maxExtents;
+
+        if(stabilize)
+        {
+            // This needs to be constant for it to be stable
+            upDir = Float3(0.0f, 1.0f, 0.0f);
+
+            // Calculate the radius of a bounding sphere surrounding the frustum corners
+            float sphereRadius = 0.0f;
+            for(uint64 i = 0; i < 8; ++i)
+            {
+                float dist = Float3::Length(Float3(frustumCornersWS[i]) - frustumCenter);
+                sphereRadius = Max(sphereRadius, dist);
+            }
+
+            sphereRadius = std::ceil(sphereRadius * 16.0f) / 16.0f;
+
+            maxExtents = Float3(sphereRadius, sphereRadius, sphereRadius);
+            minExtents = -maxExtents;
+        }
+        else
+        {
+            // Create a temporary view matrix for the light
+            Float3 lightCameraPos = frustumCenter;
+            Float3 lookAt = frustumCenter - lightDir;
+            DirectX::XMMATRIX lightView = DirectX::XMMatrixLookAtLH(lightCameraPos.ToSIMD(), lookAt.ToSIMD(), upDir.ToSIMD());
+
+            // Calculate an AABB around the frustum corners
+            DirectX::XMVECTOR mins = DirectX::XMVectorSet(FloatMax, FloatMax, FloatMax, FloatMax);
+            DirectX::XMVECTOR maxes = DirectX::XMVectorSet(-FloatMax, -FloatMax, -FloatMax, -FloatMax);
+            for(uint32 i = 0; i < 8; ++i)
+            {
+                DirectX::XMVECTOR corner = DirectX::XMVector3TransformCoord(frustumCornersWS[i].ToSIMD(), lightView);
+                mins = DirectX::XMVectorMin(mins, corner);
+                maxes = DirectX::XMVectorMax(maxes, corner);
+            }
+
+            minExtents = Float3(mins);
+            maxExtents = Float3(maxes);
+        }
+
+        // Adjust the min/max to accommodate the filtering size
+        float scale = (shadowMapSize + 7.0f) / shadowMapSize;
+        minExtents.x *= scale;
+        minExtents.y *= scale;
+        maxExtents.x *= scale;
+        maxExtents.y *= scale;
+
+        Float3 cascadeExtents = maxExtents - minExtents;
+
+        // Get position of the shadow camera
+        Float3 shadowCameraPos = frustumCenter + lightDir * -minExtents.z;
+
+        // Come up with a new orthographic camera for the shadow caster
+        OrthographicCamera& shadowCamera = cascadeCameras[cascadeIdx];
+        shadowCamera.Initialize(minExtents.x, minExtents.y, maxExtents.x, maxExtents.y, 0.0f, cascadeExtents.z);
+        shadowCamera.SetLookAt(shadowCameraPos, frustumCenter, upDir);
+
+        if(stabilize)
+        {
+            // Create the rounding matrix, by projecting the world-space origin and determining
+            // the fractional offset in texel space
+            DirectX::XMMATRIX shadowMatrix = shadowCamera.ViewProjectionMatrix().ToSIMD();
+            DirectX::XMVECTOR shadowOrigin = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+            shadowOrigin = DirectX::XMVector4Transform(shadowOrigin, shadowMatrix);
+            shadowOrigin = DirectX::XMVectorScale(shadowOrigin, shadowMapSize / 2.0f);
+
+            DirectX::XMVECTOR roundedOrigin = DirectX::XMVectorRound(shadowOrigin);
+            DirectX::XMVECTOR roundOffset = DirectX::XMVectorSubtract(roundedOrigin, shadowOrigin);
+            roundOffset = DirectX::XMVectorScale(roundOffset, 2.0f / shadowMapSize);
+            roundOffset = DirectX::XMVectorSetZ(roundOffset, 0.0f);
+            roundOffset = DirectX::XMVectorSetW(roundOffset, 0.0f);
+
+            DirectX::XMMATRIX shadowProj = shadowCamera.ProjectionMatrix().ToSIMD();
+            shadowProj.r[3] = DirectX::XMVectorAdd(shadowProj.r[3], roundOffset);
+            shadowCamera.SetProjection(Float4x4(shadowProj));
+        }
+
+        Float4x4 shadowMatrix = shadowCamera.ViewProjectionMatrix();
+        shadowMatrix = shadowMatrix * ShadowScaleOffsetMatrix;
+
+        // Store the split distance in terms of view space depth
+        const float clipDist = camera.FarClip() - camera.NearClip();
+        constants.CascadeSplits[cascadeIdx] = camera.NearClip() + splitDist * clipDist;
+
+        if(cascadeIdx == 0)
+        {
+            c0Matrix = shadowMatrix;
+            constants.ShadowMatrix = shadowMatrix;
+            constants.CascadeOffsets[0] = Float4(0.0f, 0.0f, 0.0f, 0.0f);
+            constants.CascadeScales[0] = Float4(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        else
+        {
+            // Calculate the position of the lower corner of the cascade partition, in the UV space
+            // of the first cascade partition
+            Float4x4 invCascadeMat = Float4x4::Invert(shadowMatrix);
+            Float3 cascadeCorner = Float3::Transform(Float3(0.0f, 0.0f, 0.0f), invCascadeMat);
+            cascadeCorner = Float3::Transform(cascadeCorner, c0Matrix);
+
+            // Do the same for the upper corner
+            Float3 otherCorner = Float3::Transform(Float3(1.0f, 1.0f, 1.0f), invCascadeMat);
+            otherCorner = Float3::Transform(otherCorner, c0Matrix);
+
+            // Calculate the scale and offset
+            Float3 cascadeScale = Float3(1.0f, 1.0f, 1.f) / (otherCorner - cascadeCorner);
+            constants.CascadeOffsets[cascadeIdx] = Float4(-cascadeCorner, 0.0f);
+            constants.CascadeScales[cascadeIdx] = Float4(cascadeScale, 1.0f);
+        }
+    }
+}
+
+}
+
+//=================================================================================================
+// CascadeBuilder
+//=================================================================================================
+
+// Padding for the caster bounds, with a negative extent so that it never overlaps a cascade
+static const float EmptyBoundsExtent = -1.0e30f;
+
+static bool operator==(const CascadeLightDesc& a, const CascadeLightDesc& b)
+{
+    return a.LightDir == b.LightDir && a.ShadowMapSize == b.ShadowMapSize && a.Stabilize == b.Stabilize;
+}
+
+// Dot products of 4 vectors (stored as SoA) with a single vector
+static DirectX::XMVECTOR DotSoA(DirectX::FXMVECTOR x, DirectX::FXMVECTOR y, DirectX::FXMVECTOR z, DirectX::FXMVECTOR v)
+{
+    using namespace DirectX;
+    XMVECTOR result = XMVectorMultiply(x, XMVectorSplatX(v));
+    result = XMVectorMultiplyAdd(y, XMVectorSplatY(v), result);
+    return XMVectorMultiplyAdd(z, XMVectorSplatZ(v), result);
+}
+
+static float ReduceMin(DirectX::FXMVECTOR v)
+{
+    DirectX::XMFLOAT4A f;
+    DirectX::XMStoreFloat4A(&f, v);
+    return Min(Min(f.x, f.y), Min(f.z, f.w));
+}
+
+static float ReduceMax(DirectX::FXMVECTOR v)
+{
+    DirectX::XMFLOAT4A f;
+    DirectX::XMStoreFloat4A(&f, v);
+    return Max(Max(f.x, f.y), Max(f.z, f.w));
+}
+
+void CascadeBuilder::SetCasterBounds(const Float3* aabbMins, const Float3* aabbMaxes, uint64 numAABBs)
+{
+    const uint64 numPadded = AlignTo(numAABBs, 4ull);
+
+    bool changed = numAABBs != numBounds;
+    if(boundsCenterX.Size() < numPadded)
+    {
+        boundsCenterX.Init(numPadded);
+        boundsCenterY.Init(numPadded);
+        boundsCenterZ.Init(numPadded);
+        boundsExtentX.Init(numPadded);
+        boundsExtentY.Init(numPadded);
+        boundsExtentZ.Init(numPadded);
+
+        lightBoundsMinX.Init(numPadded);
+        lightBoundsMinY.Init(numPadded);
+        lightBoundsMinZ.Init(numPadded);
+        lightBoundsMaxX.Init(numPadded);
+        lightBoundsMaxY.Init(numPadded);
+        lightBoundsMaxZ.Init(numPadded);
+
+        changed = true;
+    }
+
+    for(uint64 i = 0; i < numPadded; ++i)
+    {
+        Float3 center = 0.0f;
+        Float3 extent = EmptyBoundsExtent;
+        if(i < numAABBs)
+        {
+            center = (aabbMins[i] + aabbMaxes[i]) * 0.5f;
+            extent = (aabbMaxes[i] - aabbMins[i]) * 0.5f;
+        }
+
+        changed = changed || boundsCenterX[i] != center.x || boundsCenterY[i] != center.y ||
+                  boundsCenterZ[i] != center.z || boundsExtentX[i] != extent.x ||
+                  boundsExtentY[i] != extent.y || boundsExtentZ[i] != extent.z;
+
+        boundsCenterX[i] = center.x;
+        boundsCenterY[i] = center.y;
+        boundsCenterZ[i] = center.z;
+        boundsExtentX[i] = extent.x;
+        boundsExtentY[i] = extent.y;
+        boundsExtentZ[i] = extent.z;
+    }
+
+    // Setting the same bounds every frame keeps the cached cascades
+    numBounds = numAABBs;
+    if(changed)
+        ++boundsVersion;
+}
+
+void CascadeBuilder::ClearCasterBounds()
+{
+    if(numBounds > 0)
+        ++boundsVersion;
+    numBounds = 0;
+}
+
+void CascadeBuilder::Invalidate()
+{
+    for(uint64 i = 0; i < cache.Size(); ++i)
+        cache[i].Valid = false;
+}
+
+void CascadeBuilder::Build(const Camera& camera, const CascadeLightDesc* lights, uint64 numLights,
+                           SunShadowConstantsBase* constants, OrthographicCamera* cascadeCameras)
+{
+    if(cache.Size() < numLights)
+        cache.Resize(numLights);
+
+    float cascadeSplits[NumCascades] = { };
+    Float3 frustumCornersWS[8];
+    bool frustumComputed = false;
+
+    for(uint64 lightIdx = 0; lightIdx < numLights; ++lightIdx)
+    {
+        const CascadeLightDesc& light = lights[lightIdx];
+        CachedLight& cached = cache[lightIdx];
+
+        if(cached.Valid == false || !(cached.Desc == light) ||
+           cached.CameraViewProjection != camera.ViewProjectionMatrix() ||
+           cached.CameraNearClip != camera.NearClip() || cached.CameraFarClip != camera.FarClip() ||
+           cached.BoundsVersion != boundsVersion)
+        {
+            if(frustumComputed == false)
+            {
+                ShadowHelper::ComputeCascadeSplits(camera, cascadeSplits);
+
+                // Get the 8 points of the view frustum in world space (the slices are computed from these)
+                const Float3 frustumCornersCS[8] =
+                {
+                    Float3(-1.0f,  1.0f, 0.0f),
+                    Float3( 1.0f,  1.0f, 0.0f),
+                    Float3( 1.0f, -1.0f, 0.0f),
+                    Float3(-1.0f, -1.0f, 0.0f),
+                    Float3(-1.0f,  1.0f, 1.0f),
+                    Float3( 1.0f,  1.0f, 1.0f),
+                    Float3( 1.0f, -1.0f, 1.0f),
+                    Float3(-1.0f, -1.0f, 1.0f),
+                };
+
+                Float4x4 invViewProj = Float4x4::Invert(camera.ViewProjectionMatrix());
+                for(uint64 i = 0; i < 8; ++i)
+                    frustumCornersWS[i] = Float3::Transform(frustumCornersCS[i], invViewProj);
+
+                frustumComputed = true;
+            }
+
+            BuildLight(camera, light, cascadeSplits, frustumCornersWS, cached.Constants, cached.Cameras);
+
+            cached.Desc = light;
+            cached.CameraViewProjection = camera.ViewProjectionMatrix();
+            cached.CameraNearClip = camera.NearClip();
+            cached.CameraFarClip = camera.FarClip();
+            cached.BoundsVersion = boundsVersion;
+            cached.Valid = true;
+
+            ++numLightsBuilt;
+        }
+        else
+        {
+            ++numCacheHits;
+        }
+
+        constants[lightIdx] = cached.Constants;
+        for(uint64 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
+            cascadeCameras[lightIdx * NumCascades + cascadeIdx] = cached.Cameras[cascadeIdx];
+    }
+}
+
+void CascadeBuilder::BuildLight(const Camera& camera, const CascadeLightDesc& light, const float* cascadeSplits,
+                                const Float3* frustumCornersWS, SunShadowConstantsBase& constants,
+                                OrthographicCamera* cascadeCameras)
+{
+    using namespace DirectX;
+
+    static_assert(NumCascades == 4, "The cascades of a light are computed in the 4 lanes of a SIMD register");
+
+    const uint64 shadowMapSize = light.ShadowMapSize;
+    const bool stabilize = light.Stabilize;
+
+    // The up vector needs to be constant for the cascades to be stable
+    const Float3 upDir = stabilize ? Float3(0.0f, 1.0f, 0.0f) : camera.Right();
+
+    // All cascades share the orientation of the light camera, only the position differs
+    XMMATRIX lightRotation = XMMatrixLookAtLH(XMVectorZero(), (-light.LightDir).ToSIMD(), upDir.ToSIMD());
+    lightRotation = XMMatrixTranspose(lightRotation);
+    const XMVECTOR axisX = lightRotation.r[0];
+    const XMVECTOR axisY = lightRotation.r[1];
+    const XMVECTOR axisZ = lightRotation.r[2];
+
+    // Get the corners of the cascade slices of the view frustum, with one cascade per SIMD lane
+    const float* splits = cascadeSplits;
+    const XMVECTOR prevSplitDists = XMVectorSet(ShadowHelper::MinDistance, splits[0], splits[1], splits[2]);
+    const XMVECTOR splitDists = XMVectorSet(splits[0], splits[1], splits[2], splits[3]);
+
+    XMVECTOR cornersX[8];
+    XMVECTOR cornersY[8];
+    XMVECTOR cornersZ[8];
+    for(uint64 i = 0; i < 4; ++i)
+    {
+        const Float3& nearCorner = frustumCornersWS[i];
+        Float3 cornerRay = frustumCornersWS[i + 4] - nearCorner;
+
+        cornersX[i] = XMVectorMultiplyAdd(XMVectorReplicate(cornerRay.x), prevSplitDists, XMVectorReplicate(nearCorner.x));
+        cornersY[i] = XMVectorMultiplyAdd(XMVectorReplicate(cornerRay.y), prevSplitDists, XMVectorReplicate(nearCorner.y));
+        cornersZ[i] = XMVectorMultiplyAdd(XMVectorReplicate(cornerRay.z), prevSplitDists, XMVectorReplicate(nearCorner.z));
+        cornersX[i + 4] = XMVectorMultiplyAdd(XMVectorReplicate(cornerRay.x), splitDists, XMVectorReplicate(nearCorner.x));
+        cornersY[i + 4] = XMVectorMultiplyAdd(XMVectorReplicate(cornerRay.y), splitDists, XMVectorReplicate(nearCorner.y));
+        cornersZ[i + 4] = XMVectorMultiplyAdd(XMVectorReplicate(cornerRay.z), splitDists, XMVectorReplicate(nearCorner.z));
+    }
+
+    // Calculate the centroids of the view frustum slices
+    XMVECTOR centerX = XMVectorZero();
+    XMVECTOR centerY = XMVectorZero();
+    XMVECTOR centerZ = XMVectorZero();
+    for(uint64 i = 0; i < 8; ++i)
+    {
+        centerX = XMVectorAdd(centerX, cornersX[i]);
+        centerY = XMVectorAdd(centerY, cornersY[i]);
+        centerZ = XMVectorAdd(centerZ, cornersZ[i]);
+    }
+    centerX = XMVectorScale(centerX, 1.0f / 8.0f);
+    centerY = XMVectorScale(centerY, 1.0f / 8.0f);
+    centerZ = XMVectorScale(centerZ, 1.0f / 8.0f);
+
+    // Calculate the extents of the slices in the space of the light: either a bounding sphere
+    // (which doesn't change size when the camera rotates), or an AABB around the corners
+    XMVECTOR minX, minY, minZ, maxX, maxY, maxZ;
+    if(stabilize)
+    {
+        XMVECTOR radiusSq = XMVectorZero();
+        for(uint64 i = 0; i < 8; ++i)
+        {
+            XMVECTOR dx = XMVectorSubtract(cornersX[i], centerX);
+            XMVECTOR dy = XMVectorSubtract(cornersY[i], centerY);
+            XMVECTOR dz = XMVectorSubtract(cornersZ[i], centerZ);
+            XMVECTOR distSq = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+            radiusSq = XMVectorMax(radiusSq, distSq);
+        }
+
+        XMVECTOR sphereRadius = XMVectorSqrt(radiusSq);
+        sphereRadius = XMVectorScale(XMVectorCeiling(XMVectorScale(sphereRadius, 16.0f)), 1.0f / 16.0f);
+
+        maxX = maxY = maxZ = sphereRadius;
+        minX = minY = minZ = XMVectorNegate(sphereRadius);
+    }
+    else
+    {
+        minX = minY = minZ = XMVectorReplicate(FloatMax);
+        maxX = maxY = maxZ = XMVectorReplicate(-FloatMax);
+        for(uint64 i = 0; i < 8; ++i)
+        {
+            XMVECTOR dx = XMVectorSubtract(cornersX[i], centerX);
+            XMVECTOR dy = XMVectorSubtract(cornersY[i], centerY);
+            XMVECTOR dz = XMVectorSubtract(cornersZ[i], centerZ);
+
+            XMVECTOR lx = DotSoA(dx, dy, dz, axisX);
+            XMVECTOR ly = DotSoA(dx, dy, dz, axisY);
+            XMVECTOR lz = DotSoA(dx, dy, dz, axisZ);
+
+            minX = XMVectorMin(minX, lx);
+            minY = XMVectorMin(minY, ly);
+            minZ = XMVectorMin(minZ, lz);
+            maxX = XMVectorMax(maxX, lx);
+            maxY = XMVectorMax(maxY, ly);
+            maxZ = XMVectorMax(maxZ, lz);
+        }
+    }
+
+    // Back to one value per cascade
+    XMFLOAT4A centersX, centersY, centersZ, minsX, minsY, minsZ, maxesX, maxesY, maxesZ;
+    XMStoreFloat4A(&centersX, centerX);
+    XMStoreFloat4A(&centersY, centerY);
+    XMStoreFloat4A(&centersZ, centerZ);
+    XMStoreFloat4A(&minsX, minX);
+    XMStoreFloat4A(&minsY, minY);
+    XMStoreFloat4A(&minsZ, minZ);
+    XMStoreFloat4A(&maxesX, maxX);
+    XMStoreFloat4A(&maxesY, maxY);
+    XMStoreFloat4A(&maxesZ, maxZ);
+
+    // Transform the caster bounds to the space of the light, 4 at a time
+    const uint64 numBoundsGroups = AlignTo(numBounds, 4ull) / 4;
+    for(uint64 groupIdx = 0; groupIdx < numBoundsGroups; ++groupIdx)
+    {
+        const uint64 i = groupIdx * 4;
+        XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsCenterX[i]));
+        XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsCenterY[i]));
+        XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsCenterZ[i]));
+        XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsExtentX[i]));
+        XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsExtentY[i]));
+        XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&boundsExtentZ[i]));
+
+        const XMVECTOR axes[3] = { axisX, axisY, axisZ };
+        float* lightMins[3] = { &lightBoundsMinX[i], &lightBoundsMinY[i], &lightBoundsMinZ[i] };
+        float* lightMaxes[3] = { &lightBoundsMaxX[i], &lightBoundsMaxY[i], &lightBoundsMaxZ[i] };
+        for(uint64 axisIdx = 0; axisIdx < 3; ++axisIdx)
+        {
+            XMVECTOR c = DotSoA(cx, cy, cz, axes[axisIdx]);
+            XMVECTOR e = DotSoA(ex, ey, ez, XMVectorAbs(axes[axisIdx]));
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(lightMins[axisIdx]), XMVectorSubtract(c, e));
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(lightMaxes[axisIdx]), XMVectorAdd(c, e));
+        }
+    }
+
+    Float4x4 c0Matrix;
+
+    for(uint64 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx)
+    {
+        const uint64 lane = cascadeIdx;
+        Float3 frustumCenter = Float3((&centersX.x)[lane], (&centersY.x)[lane], (&centersZ.x)[lane]);
+        Float3 minExtents = Float3((&minsX.x)[lane], (&minsY.x)[lane], (&minsZ.x)[lane]);
+        Float3 maxExtents = Float3((&maxesX.x)[lane], (&maxesY.x)[lane], (&maxesZ.x)[lane]);
+
+        if(numBounds > 0)
+        {
+            // Fit the cascade to the bounds that overlap it. Bounds that are entirely behind the slice
+            // (as seen from the light) can't cast shadows on it, but bounds in front of it can.
+            XMVECTOR center = frustumCenter.ToSIMD();
+            Float3 centerLS = Float3(XMVectorGetX(XMVector3Dot(center, axisX)),
+                                     XMVectorGetX(XMVector3Dot(center, axisY)),
+                                     XMVectorGetX(XMVector3Dot(center, axisZ)));
+            XMVECTOR rectMinX = XMVectorReplicate(centerLS.x + minExtents.x);
+            XMVECTOR rectMinY = XMVectorReplicate(centerLS.y + minExtents.y);
+            XMVECTOR rectMaxX = XMVectorReplicate(centerLS.x + maxExtents.x);
+            XMVECTOR rectMaxY = XMVectorReplicate(centerLS.y + maxExtents.y);
+            XMVECTOR sliceMaxZ = XMVectorReplicate(centerLS.z + maxExtents.z);
+
+            XMVECTOR fitMinX = XMVectorReplicate(FloatMax);
+            XMVECTOR fitMinY = XMVectorReplicate(FloatMax);
+            XMVECTOR fitMinZ = XMVectorReplicate(FloatMax);
+            XMVECTOR fitMaxX = XMVectorReplicate(-FloatMax);
+            XMVECTOR fitMaxY = XMVectorReplicate(-FloatMax);
+            XMVECTOR fitMaxZ = XMVectorReplicate(-FloatMax);
+
+            for(uint64 groupIdx = 0; groupIdx < numBoundsGroups; ++groupIdx)
+            {
+                const uint64 i = groupIdx * 4;
+                XMVECTOR boundsMinX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&lightBoundsMinX[i]));
+                XMVECTOR boundsMinY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&lightBoundsMinY[i]));
+                XMVECTOR boundsMinZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&lightBoundsMinZ[i]));
+                XMVECTOR boundsMaxX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&lightBoundsMaxX[i]));
+                XMVECTOR boundsMaxY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&lightBoundsMaxY[i]));
+                XMVECTOR boundsMaxZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&lightBoundsMaxZ[i]));
+
+                XMVECTOR overlaps = XMVectorLessOrEqual(boundsMinZ, sliceMaxZ);
+                overlaps = XMVectorAndInt(overlaps, XMVectorLessOrEqual(boundsMinX, rectMaxX));
+                overlaps = XMVectorAndInt(overlaps, XMVectorGreaterOrEqual(boundsMaxX, rectMinX));
+                overlaps = XMVectorAndInt(overlaps, XMVectorLessOrEqual(boundsMinY, rectMaxY));
+                overlaps = XMVectorAndInt(overlaps, XMVectorGreaterOrEqual(boundsMaxY, rectMinY));
+
+                fitMinX = XMVectorMin(fitMinX, XMVectorSelect(XMVectorReplicate(FloatMax), boundsMinX, overlaps));
+                fitMinY = XMVectorMin(fitMinY, XMVectorSelect(XMVectorReplicate(FloatMax), boundsMinY, overlaps));
+                fitMinZ = XMVectorMin(fitMinZ, XMVectorSelect(XMVectorReplicate(FloatMax), boundsMinZ, overlaps));
+                fitMaxX = XMVectorMax(fitMaxX, XMVectorSelect(XMVectorReplicate(-FloatMax), boundsMaxX, overlaps));
+                fitMaxY = XMVectorMax(fitMaxY, XMVectorSelect(XMVectorReplicate(-FloatMax), boundsMaxY, overlaps));
+                fitMaxZ = XMVectorMax(fitMaxZ, XMVectorSelect(XMVectorReplicate(-FloatMax), boundsMaxZ, overlaps));
+            }
+
+            const float nearZ = ReduceMin(fitMinZ);
+            const float farZ = ReduceMax(fitMaxZ);
+            if(nearZ <= farZ)
+            {
+                // The bounds contain all of the receivers, so there's nothing to cover outside of them
+                minExtents.z = nearZ - centerLS.z;
+                maxExtents.z = Max(Min(farZ - centerLS.z, maxExtents.z), minExtents.z + 0.01f);
+
+                // Stabilized cascades need to keep their size and position in texel space
+                if(stabilize == false)
+                {
+                    minExtents.x = Max(minExtents.x, ReduceMin(fitMinX) - centerLS.x);
+                    minExtents.y = Max(minExtents.y, ReduceMin(fitMinY) - centerLS.y);
+                    maxExtents.x = Max(Min(maxExtents.x, ReduceMax(fitMaxX) - centerLS.x), minExtents.x + 0.01f);
+                    maxExtents.y = Max(Min(maxExtents.y, ReduceMax(fitMaxY) - centerLS.y), minExtents.y + 0.01f);
+                }
+            }
+        }
+
+        // Adjust the min/max to accommodate the filtering size
+        float scale = (shadowMapSize + 7.0f) / shadowMapSize;
+        minExtents.x *= scale;
+        minExtents.y *= scale;
+        maxExtents.x *= scale;
+        maxExtents.y *= scale;
+
+        Float3 cascadeExtents = maxExtents - minExtents;
+
+        // Get position of the shadow camera. It looks along the light direction rather than at the
+        // center of the slice, since a fitted near plane can be behind the center.
+        Float3 shadowCameraPos = frustumCenter + light.LightDir * -minExtents.z;
+
+        OrthographicCamera& shadowCamera = cascadeCameras[cascadeIdx];
+        shadowCamera.Initialize(minExtents.x, minExtents.y, maxExtents.x, maxExtents.y, 0.0f, cascadeExtents.z);
+        shadowCamera.SetLookAt(shadowCameraPos, shadowCameraPos - light.LightDir, upDir);
+
+        if(stabilize)
+        {
+            // Create the rounding matrix, by projecting the world-space origin and determining
+            // the fractional offset in texel space
+            XMMATRIX shadowMatrix = shadowCamera.ViewProjectionMatrix().ToSIMD();
+            XMVECTOR shadowOrigin = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+            shadowOrigin = XMVector4Transform(shadowOrigin, shadowMatrix);
+            shadowOrigin = XMVectorScale(shadowOrigin, shadowMapSize / 2.0f);
+
+            XMVECTOR roundedOrigin = XMVectorRound(shadowOrigin);
+            XMVECTOR roundOffset = XMVectorSubtract(roundedOrigin, shadowOrigin);
+            roundOffset = XMVectorScale(roundOffset, 2.0f / shadowMapSize);
+            roundOffset = XMVectorSetZ(roundOffset, 0.0f);
+            roundOffset = XMVectorSetW(roundOffset, 0.0f);
+
+            XMMATRIX shadowProj = shadowCamera.ProjectionMatrix().ToSIMD();
+            shadowProj.r[3] = XMVectorAdd(shadowProj.r[3], roundOffset);
+            shadowCamera.SetProjection(Float4x4(shadowProj));
+        }
+
+        Float4x4 shadowMatrix = shadowCamera.ViewProjectionMatrix();
+        shadowMatrix = shadowMatrix * ShadowHelper::ShadowScaleOffsetMatrix;
+
+        // Store the split distance in terms of view space depth
+        const float clipDist = camera.FarClip() - camera.NearClip();
+        constants.CascadeSplits[cascadeIdx] = camera.NearClip() + cascadeSplits[cascadeIdx] * clipDist;
+
+        if(cascadeIdx == 0)
+        {
+            c0Matrix = shadowMatrix;
+            constants.ShadowMatrix = shadowMatrix;
+            constants.CascadeOffsets[0] = Float4(0.0f, 0.0f, 0.0f, 0.0f);
+            constants.CascadeScales[0] = Float4(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        else
+        {
+            // The cascades only differ in their scale and translation in the space of the light, so
+            // each coordinate of this cascade is a scaled and offset coordinate of the first cascade:
+            // uv = a * p + b and uv0 = a0 * p + b0, so uv = (a / a0) * (uv0 + (a0 * b / a - b0)).
+            // This replaces inverting the shadow matrix and transforming the corners of the cascade.
+            XMMATRIX cascadeMat = XMMatrixTranspose(shadowMatrix.ToSIMD());
+            XMMATRIX c0Mat = XMMatrixTranspose(c0Matrix.ToSIMD());
+
+            float cascadeScale[3] = { };
+            float cascadeOffset[3] = { };
+            for(uint64 i = 0; i < 3; ++i)
+            {
+                // The rows of the transposed matrices are a * axis and a0 * axis
+                float scale = XMVectorGetX(XMVector3Dot(cascadeMat.r[i], c0Mat.r[i])) /
+                              XMVectorGetX(XMVector3Dot(c0Mat.r[i], c0Mat.r[i]));
+                cascadeScale[i] = scale;
+                cascadeOffset[i] = XMVectorGetW(cascadeMat.r[i]) / scale - XMVectorGetW(c0Mat.r[i]);
+            }
+
+            constants.CascadeOffsets[cascadeIdx] = Float4(cascadeOffset[0], cascadeOffset[1], cascadeOffset[2], 0.0f);
+            constants.CascadeScales[cascadeIdx] = Float4(cascadeScale[0], cascadeScale[1], cascadeScale[2], 1.0f);
+        }
+    }
+}
+
+}
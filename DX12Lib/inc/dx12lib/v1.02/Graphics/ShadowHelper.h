@@ -11,13 +11,12 @@
 
 #include <PCH.h>
 #include "..\\SF12_Math.h"
+#include "..\\Containers.h"
+#include "Camera.h"
 
 namespace SampleFramework12
 {
 
-class Camera;
-class OrthographicCamera;
-class PerspectiveCamera;
 struct ModelSpotLight;
 struct DepthBuffer;
 struct RenderTexture;
@@ -110,4 +109,83 @@ void PrepareCascades(const Float3& lightDir, uint64 shadowMapSize, bool stabiliz
 
 };
 
+// A directional light that is shadowed with a set of cascades
+struct CascadeLightDesc
+{
+    Float3 LightDir = Float3(0.0f, 1.0f, 0.0f);
+    uint64 ShadowMapSize = 2048;
+    bool Stabilize = true;
+};
+
+// Computes the same cascades as ShadowHelper::PrepareCascades, but for multiple lights at once.
+// The frustum slices of all cascades are processed together (one SIMD lane per cascade), and the
+// results for a light are cached until the camera, the light or the caster bounds change.
+//
+// When caster bounds are set (for instance the AABBs of the meshes of a Model), the depth range of
+// every cascade is fit to the casters that overlap it instead of to the frustum slice, so casters
+// between the light and the slice are no longer clipped and the depth precision isn't wasted on
+// empty space. Cascades that aren't stabilized also shrink to the part of the slice that contains
+// geometry. The bounds need to contain all of the geometry that receives shadows, not just the
+// casters, since nothing outside of them is covered by the fitted cascades.
+class CascadeBuilder
+{
+
+public:
+
+    void SetCasterBounds(const Float3* aabbMins, const Float3* aabbMaxes, uint64 numAABBs);
+    void ClearCasterBounds();
+
+    // Fills out numLights sets of constants and numLights * NumCascades cameras (the cascades of a
+    // light are consecutive)
+    void Build(const Camera& camera, const CascadeLightDesc* lights, uint64 numLights,
+               SunShadowConstantsBase* constants, OrthographicCamera* cascadeCameras);
+
+    // Drops the cached cascades so that the next Build re-computes all of them
+    void Invalidate();
+
+    uint64 NumLightsBuilt() const { return numLightsBuilt; }
+    uint64 NumCacheHits() const { return numCacheHits; }
+
+protected:
+
+    struct CachedLight
+    {
+        CascadeLightDesc Desc;
+        Float4x4 CameraViewProjection;
+        float CameraNearClip = 0.0f;
+        float CameraFarClip = 0.0f;
+        uint64 BoundsVersion = 0;
+        bool Valid = false;
+
+        SunShadowConstantsBase Constants;
+        OrthographicCamera Cameras[NumCascades];
+    };
+
+    void BuildLight(const Camera& camera, const CascadeLightDesc& light, const float* cascadeSplits,
+                    const Float3* frustumCornersWS, SunShadowConstantsBase& constants,
+                    OrthographicCamera* cascadeCameras);
+
+    // Caster bounds as SoA center + extents, padded to a multiple of 4 with empty boxes
+    Array<float> boundsCenterX;
+    Array<float> boundsCenterY;
+    Array<float> boundsCenterZ;
+    Array<float> boundsExtentX;
+    Array<float> boundsExtentY;
+    Array<float> boundsExtentZ;
+    uint64 numBounds = 0;
+    uint64 boundsVersion = 0;
+
+    // Scratch space for the caster bounds in the space of the light
+    Array<float> lightBoundsMinX;
+    Array<float> lightBoundsMinY;
+    Array<float> lightBoundsMinZ;
+    Array<float> lightBoundsMaxX;
+    Array<float> lightBoundsMaxY;
+    Array<float> lightBoundsMaxZ;
+
+    Array<CachedLight> cache;
+    uint64 numLightsBuilt = 0;
+    uint64 numCacheHits = 0;
+};
+
 }
@@ -0,0 +1,423 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Skybox.h"
+
+#include "../SF12_Math.h"
+#include "../Tasks.h"
+#include "../HosekSky/ArHosekSkyModel.h"
+#include "Textures.h"
+#include "Spectrum.h"
+
+// The CPU side of the sky cache doesn't depend on D3D12, so it's kept out of Skybox.cpp
+
+using namespace DirectX;
+
+namespace SampleFramework12
+{
+
+#if EnableSkyModel_
+
+// Actual physical size of the sun, expressed as an angular radius (in radians)
+static const float PhysicalSunSize = DegToRad(0.27f);
+
+// The model only has data for turbidities between 1 and 10
+static const float MaxTurbidity = 10.0f;
+
+static float AngleBetween(const Float3& dir0, const Float3& dir1)
+{
+    return std::acos(std::max(Float3::Dot(dir0, dir1), 0.00001f));
+}
+
+// Returns the result of performing a irradiance integral over the portion
+// of the hemisphere covered by a region with angular radius = theta
+static float IrradianceIntegral(float theta)
+{
+    float sinTheta = std::sin(theta);
+    return Pi * sinTheta * sinTheta;
+}
+
+void ReleaseSkyState(ArHosekSkyModelState*& state)
+{
+    if(state != nullptr)
+    {
+        arhosekskymodelstate_free(state);
+        state = nullptr;
+    }
+}
+
+// == Sun Irradiance LUT ==========================================================================
+
+// The irradiance of the solar disc only depends on the elevation of the sun, the turbidity, and the
+// ground albedo, so it's tabulated for each spectral sample over those parameters. The elevations
+// are placed at 2 nodes for each of the 45 segments of the model's solar radiance fit, turbidity is
+// sampled at the integer values that the model interpolates between, and the albedo is sampled at
+// 0, 0.5 and 1. Nodes are computed the first time a lookup needs them.
+static const uint64 SunLUTNumElevations = 91;
+static const uint64 SunLUTNumTurbidities = 10;
+static const uint64 SunLUTNumAlbedos = 3;
+static const uint64 SunLUTNumCorners = 2 * 2 * SunLUTNumAlbedos;
+static const uint64 SunLUTNumNodes = SunLUTNumElevations * SunLUTNumTurbidities * SunLUTNumAlbedos;
+
+struct SunLUTNode
+{
+    float Irradiance[NumSpectralSamples] = { };
+    bool Valid = false;
+};
+
+static SunLUTNode SunLUT[SunLUTNumNodes];
+static SRWLOCK SunLUTLock = SRWLOCK_INIT;
+
+// Converts a sampled spectrum to RGB with one dot product per channel, the rows are the CIE
+// matching functions multiplied with the XYZ -> RGB matrix
+static float SpectrumToRGB[3][NumSpectralSamples];
+static bool SpectrumToRGBInitialized = false;
+
+// Integrates the solar radiance over the solar disc, for a surface perpendicular to the sun.
+// Note that we use the *actual* sun size here and not the sun size of the sky cache, so that
+// we always end up with the appropriate intensity.
+static void ComputeSunLUTNode(uint64 nodeIdx, SunLUTNode& node)
+{
+    const uint64 elevationIdx = nodeIdx / (SunLUTNumTurbidities * SunLUTNumAlbedos);
+    const uint64 turbidityIdx = (nodeIdx / SunLUTNumAlbedos) % SunLUTNumTurbidities;
+    const uint64 albedoIdx = nodeIdx % SunLUTNumAlbedos;
+
+    const double t = double(elevationIdx) / (SunLUTNumElevations - 1);
+    const double elevation = (Pi / 2.0) * t * t * t;
+    const double thetaS = (Pi / 2.0) - elevation;
+    const double sinElevation = std::sin(elevation);
+    const double cosElevation = std::cos(elevation);
+    const double albedo = double(albedoIdx) / (SunLUTNumAlbedos - 1);
+    ArHosekSkyModelState* skyState = arhosekskymodelstate_alloc_init(thetaS, 1.0 + turbidityIdx, albedo);
+
+    // Uniformly sample the solid area of the solar disc. The angles are computed in double precision,
+    // the angle between the sun and a sample is too small for an accurate acos in single precision.
+    const double cosSunSize = std::cos(double(PhysicalSunSize));
+    double irradiance[NumSpectralSamples] = { };
+    const uint64 NumSamples = 8;
+    for(uint64 x = 0; x < NumSamples; ++x)
+    {
+        for(uint64 y = 0; y < NumSamples; ++y)
+        {
+            const double u1 = (x + 0.5) / NumSamples;
+            const double u2 = (y + 0.5) / NumSamples;
+            const double cosGamma = (1.0 - u1) + u1 * cosSunSize;
+            const double sinGamma = std::sqrt(1.0 - cosGamma * cosGamma);
+            const double phi = u2 * 2.0 * Pi;
+
+            // The disc is oriented around the sun direction, which is rotated into the XY plane
+            const double cosTheta = sinElevation * cosGamma - cosElevation * std::sin(phi) * sinGamma;
+            const double sampleThetaS = std::acos(std::max(cosTheta, 0.00001));
+            const double sampleGamma = std::acos(cosGamma);
+
+            for(int32 i = 0; i < NumSpectralSamples; ++i)
+            {
+                const double wavelength = Lerp(float(SampledLambdaStart), float(SampledLambdaEnd), i / float(NumSpectralSamples));
+                irradiance[i] += arhosekskymodel_solar_radiance(skyState, sampleThetaS, sampleGamma, wavelength) * cosGamma;
+            }
+        }
+    }
+
+    arhosekskymodelstate_free(skyState);
+
+    // Apply the monte carlo factor of 1 / (PDF * N)
+    const double pdf = 1.0 / (2.0 * Pi * (1.0 - cosSunSize));
+    for(int32 i = 0; i < NumSpectralSamples; ++i)
+        node.Irradiance[i] = float(irradiance[i] / (NumSamples * NumSamples * pdf));
+    node.Valid = true;
+}
+
+// Returns the RGB irradiance of the sun by interpolating the LUT for each spectral sample
+static Float3 SunIrradianceFromLUT(float elevation, float turbidity, const SampledSpectrum& groundAlbedo)
+{
+    const float elevationCoord = std::pow(Saturate(elevation / Pi_2), 1.0f / 3.0f) * (SunLUTNumElevations - 1);
+    const uint64 elevationIdx = std::min(uint64(elevationCoord), SunLUTNumElevations - 2);
+    const float elevationLerp = elevationCoord - elevationIdx;
+
+    const float turbidityCoord = Clamp(turbidity, 1.0f, MaxTurbidity) - 1.0f;
+    const uint64 turbidityIdx = std::min(uint64(turbidityCoord), SunLUTNumTurbidities - 2);
+    const float turbidityLerp = turbidityCoord - turbidityIdx;
+
+    // Corners are ordered by elevation, then turbidity, then albedo
+    uint64 nodeIndices[SunLUTNumCorners] = { };
+    for(uint64 e = 0; e < 2; ++e)
+        for(uint64 t = 0; t < 2; ++t)
+            for(uint64 a = 0; a < SunLUTNumAlbedos; ++a)
+                nodeIndices[(e * 2 + t) * SunLUTNumAlbedos + a] = ((elevationIdx + e) * SunLUTNumTurbidities + turbidityIdx + t) * SunLUTNumAlbedos + a;
+
+    AcquireSRWLockExclusive(&SunLUTLock);
+
+    if(SpectrumToRGBInitialized == false)
+    {
+        for(int32 i = 0; i < NumSpectralSamples; ++i)
+        {
+            SampledSpectrum spectrum;
+            spectrum[i] = 1.0f;
+            const Float3 rgb = spectrum.ToRGB();
+            SpectrumToRGB[0][i] = rgb.x;
+            SpectrumToRGB[1][i] = rgb.y;
+            SpectrumToRGB[2][i] = rgb.z;
+        }
+        SpectrumToRGBInitialized = true;
+    }
+
+    uint64 missingNodes[SunLUTNumCorners] = { };
+    uint64 numMissingNodes = 0;
+    for(uint64 i = 0; i < SunLUTNumCorners; ++i)
+        if(SunLUT[nodeIndices[i]].Valid == false)
+            missingNodes[numMissingNodes++] = nodeIndices[i];
+
+    ReleaseSRWLockExclusive(&SunLUTLock);
+
+    // Missing nodes are computed without holding the lock, since waiting on the task set can run
+    // other tasks on this thread
+    if(numMissingNodes > 0)
+    {
+        SunLUTNode computedNodes[SunLUTNumCorners];
+        enki::TaskSet nodeTask(uint32(numMissingNodes), [&](enki::TaskSetPartition range, uint32 threadNum)
+        {
+            for(uint32 i = range.start; i < range.end; ++i)
+                ComputeSunLUTNode(missingNodes[i], computedNodes[i]);
+        });
+
+        enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+        taskScheduler.AddTaskSetToPipe(&nodeTask);
+        taskScheduler.WaitforTaskSet(&nodeTask);
+
+        AcquireSRWLockExclusive(&SunLUTLock);
+        for(uint64 i = 0; i < numMissingNodes; ++i)
+            SunLUT[missingNodes[i]] = computedNodes[i];
+        ReleaseSRWLockExclusive(&SunLUTLock);
+    }
+
+    // Valid nodes are never modified, so they can be read with a shared lock
+    AcquireSRWLockShared(&SunLUTLock);
+
+    // 4 spectral samples at a time. Turbidity is interpolated linearly, which is what the model does for
+    // the direct sunlight. The albedo only affects the inscattered part of the solar radiance, which isn't
+    // linear in the albedo, so that uses a quadratic through the 3 albedo nodes. The elevation is
+    // interpolated in log space, since the irradiance drops off exponentially as the sun approaches the horizon.
+    const XMVECTOR turbidityWeights[2] = { XMVectorReplicate(1.0f - turbidityLerp), XMVectorReplicate(turbidityLerp) };
+    const XMVECTOR minIrradiance = XMVectorReplicate(FLT_MIN);
+    const XMVECTOR one = XMVectorSplatOne();
+    const XMVECTOR half = XMVectorReplicate(0.5f);
+    XMVECTOR rgb[3] = { XMVectorZero(), XMVectorZero(), XMVectorZero() };
+    for(int32 i = 0; i < NumSpectralSamples; i += 4)
+    {
+        const XMVECTOR albedo = XMVectorSaturate(XMVectorSet(groundAlbedo[i + 0], groundAlbedo[i + 1],
+                                                             groundAlbedo[i + 2], groundAlbedo[i + 3]));
+        const XMVECTOR albedoMinusHalf = XMVectorSubtract(albedo, half);
+        const XMVECTOR albedoMinusOne = XMVectorSubtract(albedo, one);
+        const XMVECTOR albedoWeights[SunLUTNumAlbedos] =
+        {
+            XMVectorScale(XMVectorMultiply(albedoMinusHalf, albedoMinusOne), 2.0f),
+            XMVectorScale(XMVectorMultiply(albedo, albedoMinusOne), -4.0f),
+            XMVectorScale(XMVectorMultiply(albedo, albedoMinusHalf), 2.0f),
+        };
+
+        XMVECTOR logIrradiance[2];
+        for(uint64 e = 0; e < 2; ++e)
+        {
+            XMVECTOR irradiance = XMVectorZero();
+            for(uint64 t = 0; t < 2; ++t)
+            {
+                for(uint64 a = 0; a < SunLUTNumAlbedos; ++a)
+                {
+                    const SunLUTNode& node = SunLUT[nodeIndices[(e * 2 + t) * SunLUTNumAlbedos + a]];
+                    const XMVECTOR weight = XMVectorMultiply(turbidityWeights[t], albedoWeights[a]);
+                    irradiance = XMVectorMultiplyAdd(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(node.Irradiance + i)),
+                                                     weight, irradiance);
+                }
+            }
+            logIrradiance[e] = XMVectorLogE(XMVectorMax(irradiance, minIrradiance));
+        }
+
+        const XMVECTOR irradiance = XMVectorExpE(XMVectorLerp(logIrradiance[0], logIrradiance[1], elevationLerp));
+        for(uint64 c = 0; c < 3; ++c)
+            rgb[c] = XMVectorMultiplyAdd(irradiance, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(SpectrumToRGB[c] + i)), rgb[c]);
+    }
+
+    ReleaseSRWLockShared(&SunLUTLock);
+
+    const Float4 r = Float4(rgb[0]);
+    const Float4 g = Float4(rgb[1]);
+    const Float4 b = Float4(rgb[2]);
+    return Float3((r.x + r.y) + (r.z + r.w), (g.x + g.y) + (g.z + g.w), (b.x + b.y) + (b.z + b.w));
+}
+
+// == Sky Cache ===================================================================================
+
+SkyCacheResults::~SkyCacheResults()
+{
+    ReleaseSkyState(StateR);
+    ReleaseSkyState(StateG);
+    ReleaseSkyState(StateB);
+}
+
+void ClampSkyParams(Float3& sunDirection, float& sunSize, Float3& groundAlbedo, float& turbidity)
+{
+    sunDirection.y = Saturate(sunDirection.y);
+    sunDirection = Float3::Normalize(sunDirection);
+    turbidity = Clamp(turbidity, 1.0f, MaxTurbidity);
+    groundAlbedo = Saturate(groundAlbedo);
+    sunSize = Max(sunSize, 0.01f);
+}
+
+// Evaluates the sky for 4 texels of the cubemap at a time. This is the same as calling SkyCache::Sample
+// for each texel, except that it runs in single precision.
+static void SampleSky(const SkyCacheResults& results, const CubemapTexelTable& table, uint64 idx, Float4* texels)
+{
+    const XMVECTOR x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirX.Data() + idx));
+    const XMVECTOR y = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirY.Data() + idx));
+    const XMVECTOR z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(table.DirZ.Data() + idx));
+
+    const XMVECTOR one = XMVectorSplatOne();
+    const XMVECTOR minCos = XMVectorReplicate(0.00001f);
+    XMVECTOR cosGamma = XMVectorMultiply(x, XMVectorReplicate(results.SunDirection.x));
+    cosGamma = XMVectorMultiplyAdd(y, XMVectorReplicate(results.SunDirection.y), cosGamma);
+    cosGamma = XMVectorMultiplyAdd(z, XMVectorReplicate(results.SunDirection.z), cosGamma);
+    cosGamma = XMVectorMax(cosGamma, minCos);
+    const XMVECTOR cosTheta = XMVectorMax(y, minCos);
+
+    const XMVECTOR gamma = XMVectorACos(cosGamma);
+    const XMVECTOR rayM = XMVectorMultiply(cosGamma, cosGamma);
+    const XMVECTOR zenith = XMVectorSqrt(cosTheta);
+    const XMVECTOR horizonExponent = XMVectorReciprocal(XMVectorAdd(cosTheta, XMVectorReplicate(0.01f)));
+
+    // Same as arhosek_tristim_skymodel_radiance, with the luminous efficacy of 683 lm/W and the FP16 scale
+    const ArHosekSkyModelState* states[3] = { results.StateR, results.StateG, results.StateB };
+    XMVECTOR radiance[3];
+    for(uint64 c = 0; c < 3; ++c)
+    {
+        const double* config = states[c]->configs[c];
+
+        const XMVECTOR expM = XMVectorExpE(XMVectorScale(gamma, float(config[4])));
+        const XMVECTOR mieBase = XMVectorNegativeMultiplySubtract(XMVectorReplicate(float(2.0 * config[8])), cosGamma,
+                                                                  XMVectorReplicate(float(1.0 + config[8] * config[8])));
+        const XMVECTOR mieM = XMVectorDivide(XMVectorAdd(one, rayM), XMVectorMultiply(mieBase, XMVectorSqrt(mieBase)));
+        const XMVECTOR horizon = XMVectorMultiplyAdd(XMVectorReplicate(float(config[0])),
+                                                     XMVectorExpE(XMVectorScale(horizonExponent, float(config[1]))), one);
+
+        XMVECTOR lobes = XMVectorReplicate(float(config[2]));
+        lobes = XMVectorMultiplyAdd(XMVectorReplicate(float(config[3])), expM, lobes);
+        lobes = XMVectorMultiplyAdd(XMVectorReplicate(float(config[5])), rayM, lobes);
+        lobes = XMVectorMultiplyAdd(XMVectorReplicate(float(config[6])), mieM, lobes);
+        lobes = XMVectorMultiplyAdd(XMVectorReplicate(float(config[7])), zenith, lobes);
+
+        const float scale = float(states[c]->radiances[c] * 683.0 * FP16Scale);
+        radiance[c] = XMVectorScale(XMVectorMultiply(horizon, lobes), scale);
+    }
+
+    const XMMATRIX rgba = XMMatrixTranspose(XMMATRIX(radiance[0], radiance[1], radiance[2], one));
+    for(uint64 i = 0; i < 4; ++i)
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(texels + idx + i), rgba.r[i]);
+}
+
+// Makes a pre-computed cubemap with the sky radiance values, minus the sun.
+// For this we again pre-scale by our FP16 scale factor so that we can use an FP16 format.
+static void ComputeSkyCubeMap(const SkyCacheResults& results, TextureData<Float4>& skyTexels)
+{
+    const CubemapTexelTable& table = GetCubemapTexelTable(SkyCubeMapRes, SkyCubeMapRes);
+    skyTexels.Init(SkyCubeMapRes, SkyCubeMapRes, 6);
+
+    const uint64 BatchSize = 4 * 1024;
+    Assert_(table.NumTexels % BatchSize == 0);
+    const uint64 numBatches = table.NumTexels / BatchSize;
+    Float4* texels = skyTexels.Texels.Data();
+
+    enki::TaskSet skyTask(uint32(numBatches), [&](enki::TaskSetPartition range, uint32 threadNum)
+    {
+        for(uint64 idx = range.start * BatchSize; idx < range.end * BatchSize; idx += 4)
+            SampleSky(results, table, idx, texels);
+    });
+
+    enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+    taskScheduler.AddTaskSetToPipe(&skyTask);
+    taskScheduler.WaitforTaskSet(&skyTask);
+}
+
+void ComputeSky(const Float3& sunDirection, float sunSize, const Float3& groundAlbedo, float turbidity,
+                bool createCubemap, SkyCacheResults& results)
+{
+    float thetaS = AngleBetween(sunDirection, Float3(0, 1, 0));
+    float elevation = Pi_2 - thetaS;
+    results.StateR = arhosek_rgb_skymodelstate_alloc_init(turbidity, groundAlbedo.x, elevation);
+    results.StateG = arhosek_rgb_skymodelstate_alloc_init(turbidity, groundAlbedo.y, elevation);
+    results.StateB = arhosek_rgb_skymodelstate_alloc_init(turbidity, groundAlbedo.z, elevation);
+
+    results.Albedo = groundAlbedo;
+    results.Elevation = elevation;
+    results.SunDirection = sunDirection;
+    results.Turbidity = turbidity;
+    results.SunSize = sunSize;
+
+    // The irradiance of the sun for a surface perpendicular to the sun comes from the LUT. Note that the
+    // solar radiance function provided by the authors of this sky model only works using spectral
+    // rendering, so the LUT is spectral and we convert to RGB after interpolating.
+    SampledSpectrum groundAlbedoSpectrum = SampledSpectrum::FromRGB(groundAlbedo, SpectrumType::Reflectance);
+    results.SunIrradiance = SunIrradianceFromLUT(elevation, turbidity, groundAlbedoSpectrum);
+
+    // Pre-scale by our FP16 scaling factor, so that we can use the irradiance value
+    // and have the resulting lighting still fit comfortably in an FP16 render target
+    results.SunIrradiance *= FP16Scale;
+
+    // Account for luminous efficiency and coordinate system scaling
+    results.SunIrradiance *= 683.0f * 100.0f;
+
+    // Compute a uniform solar radiance value such that integrating this radiance over a disc with
+    // the provided angular radius
+    results.SunRadiance = results.SunIrradiance / IrradianceIntegral(DegToRad(sunSize));
+
+    // Compute a (clamped) RGB value for direct rendering of the sun
+    Float3 sunColor = results.SunRadiance;
+    float maxComponent = Max(sunColor.x, Max(sunColor.y, sunColor.z));
+    if(maxComponent > FP16Max)
+        sunColor *= (FP16Max / maxComponent);
+    results.SunRenderColor = Float3::Clamp(sunColor, 0.0f, FP16Max);
+
+    if(createCubemap)
+    {
+        TextureData<Float4> skyTexels;
+        ComputeSkyCubeMap(results, skyTexels);
+
+        // We'll also project the sky onto SH coefficients and SG's for use during rendering
+        results.SH = ProjectCubemapToSH(skyTexels);
+        SolveSGsForCubemap(skyTexels, results.SG.Lobes, 9, SGSolveMode::NNLS);
+
+        results.CubeMapTexels.Init(skyTexels.Texels.Size());
+        for(uint64 i = 0; i < skyTexels.Texels.Size(); ++i)
+            results.CubeMapTexels[i] = Half4(skyTexels.Texels[i]);
+    }
+}
+
+Float3 SkyCache::Sample(Float3 sampleDir) const
+{
+    Assert_(StateR != nullptr);
+
+    float gamma = AngleBetween(sampleDir, SunDirection);
+    float theta = AngleBetween(sampleDir, Float3(0, 1, 0));
+
+    Float3 radiance;
+
+    radiance.x = float(arhosek_tristim_skymodel_radiance(StateR, theta, gamma, 0));
+    radiance.y = float(arhosek_tristim_skymodel_radiance(StateG, theta, gamma, 1));
+    radiance.z = float(arhosek_tristim_skymodel_radiance(StateB, theta, gamma, 2));
+
+    // Multiply by standard luminous efficacy of 683 lm/W to bring us in line with the photometric
+    // units used during rendering
+    radiance *= 683.0f;
+
+    return radiance * FP16Scale;
+}
+
+#endif // EnableSkyModel_
+
+}
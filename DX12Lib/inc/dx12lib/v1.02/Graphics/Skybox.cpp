@@ -13,13 +13,14 @@
 
 #include "../Utility.h"
 #include "../SF12_Math.h"
-#include "../HosekSky/ArHosekSkyModel.h"
+#include "../Tasks.h"
 #include "ShaderCompilation.h"
 #include "Textures.h"
-#include "Spectrum.h"
 #include "Sampling.h"
 #include "DX12.h"
 
+using namespace DirectX;
+
 namespace SampleFramework12
 {
 
@@ -28,211 +29,162 @@ static const uint64 NumVertices = 8;
 
 #if EnableSkyModel_
 
-// Actual physical size of the sun, expressed as an angular radius (in radians)
-static const float PhysicalSunSize = DegToRad(0.27f);
-static const float CosPhysicalSunSize = std::cos(PhysicalSunSize);
+// == Sky Cache ===================================================================================
+
+// A sky that's being computed on the worker threads for SkyCache::InitAsync
+struct SkyCacheJob
+{
+    Float3 SunDirection;
+    float SunSize = 0.0f;
+    Float3 Albedo;
+    float Turbidity = 0.0f;
+    bool CreateCubemap = false;
+
+    SkyCacheResults* Results = nullptr;
+    bool Running = false;
+    enki::TaskSet Task;
+
+    SkyCacheJob();
+};
 
-static float AngleBetween(const Float3& dir0, const Float3& dir1)
+// Swaps in a sky that was computed by ComputeSky, and creates the cubemap texture
+static void ApplySkyResults(SkyCache& skyCache, SkyCacheResults& results)
 {
-    return std::acos(std::max(Float3::Dot(dir0, dir1), 0.00001f));
+    ReleaseSkyState(skyCache.StateR);
+    ReleaseSkyState(skyCache.StateG);
+    ReleaseSkyState(skyCache.StateB);
+    skyCache.CubeMap.Shutdown();
+
+    skyCache.StateR = results.StateR;
+    skyCache.StateG = results.StateG;
+    skyCache.StateB = results.StateB;
+    results.StateR = nullptr;
+    results.StateG = nullptr;
+    results.StateB = nullptr;
+
+    skyCache.SunDirection = results.SunDirection;
+    skyCache.SunRadiance = results.SunRadiance;
+    skyCache.SunIrradiance = results.SunIrradiance;
+    skyCache.SunRenderColor = results.SunRenderColor;
+    skyCache.SunSize = results.SunSize;
+    skyCache.Turbidity = results.Turbidity;
+    skyCache.Albedo = results.Albedo;
+    skyCache.Elevation = results.Elevation;
+    skyCache.SH = results.SH;
+    skyCache.SG = results.SG;
+
+    if(results.CubeMapTexels.Size() > 0)
+        Create2DTexture(skyCache.CubeMap, SkyCubeMapRes, SkyCubeMapRes, 1, 1, DXGI_FORMAT_R16G16B16A16_FLOAT, true,
+                        results.CubeMapTexels.Data());
 }
 
-// Returns the result of performing a irradiance integral over the portion
-// of the hemisphere covered by a region with angular radius = theta
-static float IrradianceIntegral(float theta)
+SkyCacheJob::SkyCacheJob() : Task(1, [this](enki::TaskSetPartition range, uint32 threadNum)
 {
-    float sinTheta = std::sin(theta);
-    return Pi * sinTheta * sinTheta;
+    ComputeSky(SunDirection, SunSize, Albedo, Turbidity, CreateCubemap, *Results);
+})
+{
+}
+
+// Waits for a running job and throws away its results
+static void CancelSkyJob(SkyCacheJob* job)
+{
+    if(job == nullptr || job->Running == false)
+        return;
+
+    GetTaskScheduler().WaitforTaskSet(&job->Task);
+    delete job->Results;
+    job->Results = nullptr;
+    job->Running = false;
 }
 
 bool SkyCache::Init(const Float3& sunDirection_, float sunSize, const Float3& groundAlbedo_, float turbidity, bool createCubemap)
 {
     Float3 sunDirection = sunDirection_;
     Float3 groundAlbedo = groundAlbedo_;
-    sunDirection.y = Saturate(sunDirection.y);
-    sunDirection = Float3::Normalize(sunDirection);
-    turbidity = Clamp(turbidity, 1.0f, 32.0f);
-    groundAlbedo = Saturate(groundAlbedo);
-    sunSize = Max(sunSize, 0.01f);
+    ClampSkyParams(sunDirection, sunSize, groundAlbedo, turbidity);
 
     // Do nothing if we're already up-to-date
     if(Initialized() && sunDirection == SunDirection && groundAlbedo == Albedo && turbidity == Turbidity && SunSize == sunSize)
         return false;
 
-    Shutdown();
-
-    sunDirection.y = Saturate(sunDirection.y);
-    sunDirection = Float3::Normalize(sunDirection);
-    turbidity = Clamp(turbidity, 1.0f, 32.0f);
-    groundAlbedo = Saturate(groundAlbedo);
-
-    float thetaS = AngleBetween(sunDirection, Float3(0, 1, 0));
-    float elevation = Pi_2 - thetaS;
-    StateR = arhosek_rgb_skymodelstate_alloc_init(turbidity, groundAlbedo.x, elevation);
-    StateG = arhosek_rgb_skymodelstate_alloc_init(turbidity, groundAlbedo.y, elevation);
-    StateB = arhosek_rgb_skymodelstate_alloc_init(turbidity, groundAlbedo.z, elevation);
-
-    Albedo = groundAlbedo;
-    Elevation = elevation;
-    SunDirection = sunDirection;
-    Turbidity = turbidity;
-    SunSize = sunSize;
-
-    // Compute the irradiance of the sun for a surface perpendicular to the sun using monte carlo integration.
-    // Note that the solar radiance function provided by the authors of this sky model only works using
-    // spectral rendering, so we sample a range of wavelengths and then convert to RGB.
-    SampledSpectrum groundAlbedoSpectrum = SampledSpectrum::FromRGB(Albedo, SpectrumType::Reflectance);
-    SampledSpectrum solarRadiance;
-
-    // Init the Hosek solar radiance model for all wavelengths
-    ArHosekSkyModelState* skyStates[NumSpectralSamples] = { };
-    for(int32 i = 0; i < NumSpectralSamples; ++i)
-        skyStates[i] = arhosekskymodelstate_alloc_init(thetaS, turbidity, groundAlbedoSpectrum[i]);
-
-    SunIrradiance = Float3(0.0f);
-
-    // Uniformly sample the solid area of the solar disc.
-    // Note that we use the *actual* sun size here and not the passed in the sun direction, so that
-    // we always end up with the appropriate intensity. This allows changing the size of the sun
-    // as it appears in the skydome without actually changing the sun intensity.
-    Float3 sunDirX = Float3::Perpendicular(sunDirection);
-    Float3 sunDirY = Float3::Cross(sunDirection, sunDirX);
-    Float3x3 sunOrientation = Float3x3(sunDirX, sunDirY, sunDirection);
-
-    const uint64 NumSamples = 8;
-    for(uint64 x = 0; x < NumSamples; ++x)
-    {
-        for(uint64 y = 0; y < NumSamples; ++y)
-        {
-            float u1 = (x + 0.5f) / NumSamples;
-            float u2 = (y + 0.5f) / NumSamples;
-            Float3 sampleDir = SampleDirectionCone(u1, u2, CosPhysicalSunSize);
-            sampleDir = Float3::Transform(sampleDir, sunOrientation);
-
-            float sampleThetaS = AngleBetween(sampleDir, Float3(0, 1, 0));
-            float sampleGamma = AngleBetween(sampleDir, sunDirection);
-
-            for(int32 i = 0; i < NumSpectralSamples; ++i)
-            {
-                float wavelength = Lerp(float(SampledLambdaStart), float(SampledLambdaEnd), i / float(NumSpectralSamples));
-                solarRadiance[i] = float(arhosekskymodel_solar_radiance(skyStates[i], sampleThetaS, sampleGamma, wavelength));
-            }
-
-            Float3 sampleRadiance = solarRadiance.ToRGB();
-
-            // Pre-scale by our FP16 scaling factor, so that we can use the irradiance value
-            // and have the resulting lighting still fit comfortably in an FP16 render target
-            sampleRadiance *= FP16Scale;
-
-            SunIrradiance += sampleRadiance * Saturate(Float3::Dot(sampleDir, sunDirection));
-        }
-    }
+    CancelSkyJob(Job);
+
+    SkyCacheResults results;
+    ComputeSky(sunDirection, sunSize, groundAlbedo, turbidity, createCubemap, results);
+    ApplySkyResults(*this, results);
+
+    return true;
+}
 
-    // Apply the monte carlo factor of 1 / (PDF * N)
-    float pdf = SampleDirectionCone_PDF(CosPhysicalSunSize);
-    SunIrradiance *= (1.0f / NumSamples) * (1.0f / NumSamples) * (1.0f / pdf);
+bool SkyCache::InitAsync(const Float3& sunDirection_, float sunSize, const Float3& groundAlbedo_, float turbidity, bool createCubemap)
+{
+    Float3 sunDirection = sunDirection_;
+    Float3 groundAlbedo = groundAlbedo_;
+    ClampSkyParams(sunDirection, sunSize, groundAlbedo, turbidity);
 
-    // Account for luminous efficiency and coordinate system scaling
-    SunIrradiance *= 683.0f * 100.0f;
+    if(Job == nullptr)
+        Job = new SkyCacheJob();
 
-    // Clean up
-    for(uint64 i = 0; i < NumSpectralSamples; ++i)
+    bool updated = false;
+    if(Job->Running && Job->Task.GetIsComplete())
     {
-        arhosekskymodelstate_free(skyStates[i]);
-        skyStates[i] = nullptr;
+        ApplySkyResults(*this, *Job->Results);
+        delete Job->Results;
+        Job->Results = nullptr;
+        Job->Running = false;
+        updated = true;
     }
 
-    // Compute a uniform solar radiance value such that integrating this radiance over a disc with
-    // the provided angular radius
-    SunRadiance = SunIrradiance / IrradianceIntegral(DegToRad(SunSize));
+    // Changes made while a job is running are picked up by the first call after it's done
+    if(Job->Running)
+        return updated;
 
-    // Compute a (clamped) RGB value for direct rendering of the sun
-    Float3 sunColor = SunRadiance;
-    float maxComponent = Max(sunColor.x, Max(sunColor.y, sunColor.z));
-    if(maxComponent > FP16Max)
-        sunColor *= (FP16Max / maxComponent);
-    SunRenderColor = Float3::Clamp(sunColor, 0.0f, FP16Max);
+    // Do nothing if we're already up-to-date
+    if(Initialized() && sunDirection == SunDirection && groundAlbedo == Albedo && turbidity == Turbidity && SunSize == sunSize)
+        return updated;
+
+    Job->SunDirection = sunDirection;
+    Job->SunSize = sunSize;
+    Job->Albedo = groundAlbedo;
+    Job->Turbidity = turbidity;
+    Job->CreateCubemap = createCubemap;
+    Job->Results = new SkyCacheResults();
+    Job->Running = true;
+
+    enki::TaskScheduler& taskScheduler = GetTaskScheduler();
+    taskScheduler.AddTaskSetToPipe(&Job->Task);
 
-    if(createCubemap)
+    // There's no previous sky to use in the meantime, so the first one is waited for
+    if(Initialized() == false)
     {
-        // Make a pre-computed cubemap with the sky radiance values, minus the sun.
-        // For this we again pre-scale by our FP16 scale factor so that we can use an FP16 format.
-        const uint64 CubeMapRes = 128;
-        const uint64 NumTexels = CubeMapRes * CubeMapRes * 6;
-        Array<Float3> samples(NumTexels);
-        Array<Float3> sampleDirs(NumTexels);
-        Array<Half4> texels(NumTexels);
-
-        // We'll also project the sky onto SH coefficients for use during rendering
-        SH = SH9Color();
-        float weightSum = 0.0f;
-
-        for(uint64 s = 0; s < 6; ++s)
-        {
-            for(uint64 y = 0; y < CubeMapRes; ++y)
-            {
-                for(uint64 x = 0; x < CubeMapRes; ++x)
-                {
-                    Float3 dir = MapXYSToDirection(x, y, s, CubeMapRes, CubeMapRes);
-                    Float3 radiance = Sample(dir);
-
-                    uint64 idx = (s * CubeMapRes * CubeMapRes) + (y * CubeMapRes) + x;
-                    samples[idx] = radiance;
-                    texels[idx] = Half4(Float4(radiance, 1.0f));
-                    sampleDirs[idx] = dir;
-
-                    float u = (x + 0.5f) / CubeMapRes;
-                    float v = (y + 0.5f) / CubeMapRes;
-
-                    // Account for cubemap texel distribution
-                    u = u * 2.0f - 1.0f;
-                    v = v * 2.0f - 1.0f;
-                    const float temp = 1.0f + u * u + v * v;
-                    const float weight = 4.0f / (std::sqrt(temp) * temp);
-
-                    SH += ProjectOntoSH9Color(dir, radiance) * weight;
-                    weightSum += weight;
-                }
-            }
-        }
-
-        SH *= (4.0f * 3.14159f) / weightSum;
-
-        Create2DTexture(CubeMap, CubeMapRes, CubeMapRes, 1, 1, DXGI_FORMAT_R16G16B16A16_FLOAT, true, texels.Data());
-
-        SGSolveParams solveParams;
-        solveParams.SampleDirs = sampleDirs.Data();
-        solveParams.SampleValues = samples.Data();
-        solveParams.NumSamples = NumTexels;
-        solveParams.SolveMode = SGSolveMode::NNLS;
-        solveParams.Distribution = SGDistribution::Spherical;
-        solveParams.NumSGs = 9;
-        solveParams.OutSGs = SG.Lobes;
-        SolveSGs(solveParams);
+        taskScheduler.WaitforTaskSet(&Job->Task);
+        ApplySkyResults(*this, *Job->Results);
+        delete Job->Results;
+        Job->Results = nullptr;
+        Job->Running = false;
+        updated = true;
     }
 
-    return true;
+    return updated;
 }
 
-void SkyCache::Shutdown()
+bool SkyCache::Updating() const
 {
-    if(StateR != nullptr)
-    {
-        arhosekskymodelstate_free(StateR);
-        StateR = nullptr;
-    }
+    return Job != nullptr && Job->Running;
+}
 
-    if(StateG != nullptr)
+void SkyCache::Shutdown()
+{
+    if(Job != nullptr)
     {
-        arhosekskymodelstate_free(StateG);
-        StateG = nullptr;
+        CancelSkyJob(Job);
+        delete Job;
+        Job = nullptr;
     }
 
-    if(StateB != nullptr)
-    {
-        arhosekskymodelstate_free(StateB);
-        StateB = nullptr;
-    }
+    ReleaseSkyState(StateR);
+    ReleaseSkyState(StateG);
+    ReleaseSkyState(StateB);
 
     CubeMap.Shutdown();
     Turbidity = 0.0f;
@@ -249,26 +201,6 @@ SkyCache::~SkyCache()
     Assert_(Initialized() == false);
 }
 
-Float3 SkyCache::Sample(Float3 sampleDir) const
-{
-    Assert_(StateR != nullptr);
-
-    float gamma = AngleBetween(sampleDir, SunDirection);
-    float theta = AngleBetween(sampleDir, Float3(0, 1, 0));
-
-    Float3 radiance;
-
-    radiance.x = float(arhosek_tristim_skymodel_radiance(StateR, theta, gamma, 0));
-    radiance.y = float(arhosek_tristim_skymodel_radiance(StateG, theta, gamma, 1));
-    radiance.z = float(arhosek_tristim_skymodel_radiance(StateB, theta, gamma, 2));
-
-    // Multiply by standard luminous efficacy of 683 lm/W to bring us in line with the photometric
-    // units used during rendering
-    radiance *= 683.0f;
-
-    return radiance * FP16Scale;
-}
-
 #endif // EnableSkyModel_
 
 // == Skybox ======================================================================================
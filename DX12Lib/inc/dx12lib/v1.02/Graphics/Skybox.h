@@ -26,6 +26,38 @@ namespace SampleFramework12
 
 #if EnableSkyModel_
 
+// Resolution of the sky cubemap that's used for the environment and for computing the SH/SG
+static const uint32 SkyCubeMapRes = 128;
+
+// Everything that SkyCache::Init computes, so that it can also be computed on a worker thread
+struct SkyCacheResults
+{
+    ArHosekSkyModelState* StateR = nullptr;
+    ArHosekSkyModelState* StateG = nullptr;
+    ArHosekSkyModelState* StateB = nullptr;
+    Float3 SunDirection;
+    Float3 SunRadiance;
+    Float3 SunIrradiance;
+    Float3 SunRenderColor;
+    float SunSize = 0.0f;
+    float Turbidity = 0.0f;
+    Float3 Albedo;
+    float Elevation = 0.0f;
+    Array<Half4> CubeMapTexels;
+    SH9Color SH;
+    SG9 SG;
+
+    ~SkyCacheResults();
+};
+
+// The CPU side of the sky cache is in SkyModel.cpp. It doesn't touch the GPU, so it can run on any thread.
+void ClampSkyParams(Float3& sunDirection, float& sunSize, Float3& groundAlbedo, float& turbidity);
+void ComputeSky(const Float3& sunDirection, float sunSize, const Float3& groundAlbedo, float turbidity,
+                bool createCubemap, SkyCacheResults& results);
+void ReleaseSkyState(ArHosekSkyModelState*& state);
+
+struct SkyCacheJob;
+
 // Cached data for the procedural sky model
 struct SkyCache
 {
@@ -43,12 +75,20 @@ struct SkyCache
     Texture CubeMap;
     SH9Color SH;
     SG9 SG;
+    SkyCacheJob* Job = nullptr;
 
     bool Init(const Float3& sunDirection, float sunSize, const Float3& groundAlbedo, float turbidity, bool createCubemap);
+
+    // Same as Init, except that the sky is re-computed on the worker threads. The current sky stays
+    // in place until the new one is ready, and is swapped in by the first call after that (which then
+    // returns true). The very first call waits for the sky so that the cache is always initialized.
+    bool InitAsync(const Float3& sunDirection, float sunSize, const Float3& groundAlbedo, float turbidity, bool createCubemap);
+
     void Shutdown();
     ~SkyCache();
 
     bool Initialized() const { return StateR != nullptr; }
+    bool Updating() const;
 
     Float3 Sample(Float3 sampleDir) const;
 };
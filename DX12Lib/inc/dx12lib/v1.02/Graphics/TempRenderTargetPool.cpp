@@ -0,0 +1,250 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "TempRenderTargetPool.h"
+
+#include "..\\SF12_Math.h"
+
+namespace SampleFramework12
+{
+
+TempRenderTargetPool::TempRenderTargetPool()
+{
+}
+
+TempRenderTargetPool::~TempRenderTargetPool()
+{
+    Assert_(targets.Count() == 0);
+    Assert_(heaps.Count() == 0);
+}
+
+void TempRenderTargetPool::Initialize(TempRenderTargetDevice* device_, const TempRenderTargetPoolSettings& settings_)
+{
+    Assert_(device_ != nullptr);
+    Assert_(targets.Count() == 0);
+
+    device = device_;
+    settings = settings_;
+    stats = TempRenderTargetPoolStats();
+}
+
+void TempRenderTargetPool::Shutdown()
+{
+    Clear();
+    device = nullptr;
+}
+
+void TempRenderTargetPool::Clear()
+{
+    while(targets.Count() > 0)
+    {
+        Assert_(targets[targets.Count() - 1]->InUse == false);
+        DestroyTarget(targets.Count() - 1);
+    }
+
+    for(uint64 i = 0; i < heaps.Count(); ++i)
+    {
+        Assert_(heaps[i]->NumTargets == 0);
+        device->DestroyHeap(heaps[i]->Heap);
+        delete heaps[i];
+    }
+
+    heaps.RemoveAll(nullptr);
+
+    UpdateStats();
+}
+
+PooledRenderTarget* TempRenderTargetPool::Acquire(const TempRenderTargetDesc& desc)
+{
+    Assert_(device != nullptr);
+    Assert_(desc.Width > 0 && desc.Height > 0);
+
+    // Prefer targets whose contents are still in memory (so that they don't need to be aliased),
+    // then targets that exactly match the desc
+    PooledRenderTarget* target = nullptr;
+    uint64 bestRank = uint64(-1);
+    for(uint64 i = 0; i < targets.Count() && bestRank > 0; ++i)
+    {
+        PooledRenderTarget* candidate = targets[i];
+        if(candidate->InUse || IsCompatible(candidate, desc) == false || IsMemoryAvailable(candidate) == false)
+            continue;
+
+        const bool needsAlias = candidate->Heap != nullptr && candidate->Heap->Owner != candidate;
+        const uint64 rank = (needsAlias ? 2 : 0) + (IsExactMatch(candidate, desc) ? 0 : 1);
+        if(rank < bestRank)
+        {
+            target = candidate;
+            bestRank = rank;
+        }
+    }
+
+    if(target != nullptr)
+    {
+        ++stats.NumReused;
+    }
+    else
+    {
+        const uint64 size = device->TargetSize(desc);
+
+        TempRenderTargetHeap* heap = nullptr;
+        if(settings.UseSharedHeaps)
+        {
+            heap = FindFreeHeap(size);
+            if(heap == nullptr)
+            {
+                heap = new TempRenderTargetHeap();
+                heap->Heap = device->CreateHeap(size);
+                heap->Size = size;
+                heaps.Add(heap);
+            }
+
+            heap->NumTargets += 1;
+        }
+
+        target = device->CreateTarget(desc, heap ? heap->Heap : nullptr);
+        target->Desc = desc;
+        target->Size = size;
+        target->Heap = heap;
+        targets.Add(target);
+        ++stats.NumCreated;
+    }
+
+    // A placed target needs to take over the memory of its heap from the last target that used it
+    TempRenderTargetHeap* heap = target->Heap;
+    if(heap != nullptr && heap->Owner != target)
+    {
+        device->AliasTarget(target, heap->Owner);
+        if(heap->Owner != nullptr)
+            ++stats.NumAliased;
+        heap->Owner = target;
+    }
+
+    target->InUse = true;
+    target->LastUseFence = device->CurrentFence();
+
+    UpdateStats();
+
+    return target;
+}
+
+void TempRenderTargetPool::Trim()
+{
+    Assert_(device != nullptr);
+
+    if(settings.TrimFrames > 0)
+    {
+        const uint64 fence = device->CurrentFence();
+        for(uint64 i = targets.Count(); i > 0; --i)
+        {
+            const PooledRenderTarget* target = targets[i - 1];
+            if(target->InUse == false && fence >= target->LastUseFence + settings.TrimFrames)
+            {
+                DestroyTarget(i - 1);
+                ++stats.NumTrimmed;
+            }
+        }
+    }
+
+    for(uint64 i = heaps.Count(); i > 0; --i)
+    {
+        TempRenderTargetHeap* heap = heaps[i - 1];
+        if(heap->NumTargets > 0)
+            continue;
+
+        device->DestroyHeap(heap->Heap);
+        delete heap;
+        heaps.Remove(i - 1);
+    }
+
+    UpdateStats();
+}
+
+void TempRenderTargetPool::ResetPeakStats()
+{
+    stats.PeakAllocatedBytes = stats.AllocatedBytes;
+    stats.PeakInUseBytes = stats.InUseBytes;
+}
+
+bool TempRenderTargetPool::IsCompatible(const PooledRenderTarget* target, const TempRenderTargetDesc& desc)
+{
+    const TempRenderTargetDesc& targetDesc = target->Desc;
+    return targetDesc.Width == desc.Width && targetDesc.Height == desc.Height && targetDesc.Format == desc.Format &&
+           (targetDesc.UAV || desc.UAV == false);
+}
+
+bool TempRenderTargetPool::IsExactMatch(const PooledRenderTarget* target, const TempRenderTargetDesc& desc)
+{
+    return IsCompatible(target, desc) && target->Desc.UAV == desc.UAV;
+}
+
+bool TempRenderTargetPool::IsMemoryAvailable(const PooledRenderTarget* target)
+{
+    // Only one target in a heap can be in use at a time
+    const TempRenderTargetHeap* heap = target->Heap;
+    return heap == nullptr || heap->Owner == nullptr || heap->Owner == target || heap->Owner->InUse == false;
+}
+
+TempRenderTargetHeap* TempRenderTargetPool::FindFreeHeap(uint64 size)
+{
+    // Pick the smallest heap that fits, so that large heaps are kept for large targets
+    TempRenderTargetHeap* bestHeap = nullptr;
+    for(uint64 i = 0; i < heaps.Count(); ++i)
+    {
+        TempRenderTargetHeap* heap = heaps[i];
+        if(heap->Size < size || (heap->Owner != nullptr && heap->Owner->InUse))
+            continue;
+
+        if(bestHeap == nullptr || heap->Size < bestHeap->Size)
+            bestHeap = heap;
+    }
+
+    return bestHeap;
+}
+
+void TempRenderTargetPool::DestroyTarget(uint64 idx)
+{
+    PooledRenderTarget* target = targets[idx];
+    if(target->Heap != nullptr)
+    {
+        Assert_(target->Heap->NumTargets > 0);
+        target->Heap->NumTargets -= 1;
+        if(target->Heap->Owner == target)
+            target->Heap->Owner = nullptr;
+    }
+
+    device->DestroyTarget(target);
+    targets.Remove(idx);
+}
+
+void TempRenderTargetPool::UpdateStats()
+{
+    stats.NumTargets = targets.Count();
+    stats.NumHeaps = heaps.Count();
+    stats.AllocatedBytes = 0;
+    stats.InUseBytes = 0;
+
+    for(uint64 i = 0; i < targets.Count(); ++i)
+    {
+        const PooledRenderTarget* target = targets[i];
+        if(target->Heap == nullptr)
+            stats.AllocatedBytes += target->Size;
+        if(target->InUse)
+            stats.InUseBytes += target->Size;
+    }
+
+    for(uint64 i = 0; i < heaps.Count(); ++i)
+        stats.AllocatedBytes += heaps[i]->Size;
+
+    stats.PeakAllocatedBytes = Max(stats.PeakAllocatedBytes, stats.AllocatedBytes);
+    stats.PeakInUseBytes = Max(stats.PeakInUseBytes, stats.InUseBytes);
+}
+
+}
@@ -0,0 +1,156 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\Containers.h"
+
+namespace SampleFramework12
+{
+
+struct PooledRenderTarget;
+
+struct TempRenderTargetDesc
+{
+    uint64 Width = 0;
+    uint64 Height = 0;
+    DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+    bool32 UAV = false;
+};
+
+struct TempRenderTargetHeap
+{
+    ID3D12Heap* Heap = nullptr;
+    uint64 Size = 0;
+    uint64 NumTargets = 0;
+
+    // The target whose contents currently live in the heap
+    const PooledRenderTarget* Owner = nullptr;
+};
+
+// The part of a temp render target that's managed by the pool. The device creates the
+// targets, so that the pool doesn't depend on the type of the render texture.
+struct PooledRenderTarget
+{
+    bool32 InUse = false;
+
+    TempRenderTargetDesc Desc;
+    uint64 Size = 0;
+    uint64 LastUseFence = 0;
+    TempRenderTargetHeap* Heap = nullptr;
+};
+
+struct TempRenderTargetPoolSettings
+{
+    // Targets that weren't used for this many frames are released (0 to never release them)
+    uint64 TrimFrames = 60;
+
+    // Places targets in heaps that are shared by all targets that aren't in use at the same time,
+    // instead of creating a committed resource for every target
+    bool32 UseSharedHeaps = false;
+};
+
+struct TempRenderTargetPoolStats
+{
+    uint64 NumTargets = 0;
+    uint64 NumHeaps = 0;
+
+    // The memory used by committed targets and shared heaps
+    uint64 AllocatedBytes = 0;
+    uint64 PeakAllocatedBytes = 0;
+
+    // The memory used by the targets that are in use at the same time
+    uint64 InUseBytes = 0;
+    uint64 PeakInUseBytes = 0;
+
+    uint64 NumCreated = 0;
+    uint64 NumReused = 0;
+    uint64 NumAliased = 0;
+    uint64 NumTrimmed = 0;
+};
+
+// Creates the resources for the pool. The pooling policy only talks to the device
+// through this interface, so that it can be tested without D3D12.
+class TempRenderTargetDevice
+{
+
+public:
+
+    virtual ~TempRenderTargetDevice() { }
+
+    // The fence value that's signaled once the GPU is done with the current frame
+    virtual uint64 CurrentFence() const = 0;
+
+    // The size of the memory needed by a target
+    virtual uint64 TargetSize(const TempRenderTargetDesc& desc) const = 0;
+
+    virtual ID3D12Heap* CreateHeap(uint64 size) = 0;
+    virtual void DestroyHeap(ID3D12Heap* heap) = 0;
+
+    // Creates a committed target if heap is null, otherwise places it at the start of the heap
+    virtual PooledRenderTarget* CreateTarget(const TempRenderTargetDesc& desc, ID3D12Heap* heap) = 0;
+    virtual void DestroyTarget(PooledRenderTarget* target) = 0;
+
+    // Called before a placed target is used when another target (or no target, if previous
+    // is null) last used the memory of its heap. Needs an aliasing barrier and has to
+    // initialize the contents of the target.
+    virtual void AliasTarget(const PooledRenderTarget* target, const PooledRenderTarget* previous) = 0;
+};
+
+class TempRenderTargetPool
+{
+
+public:
+
+    TempRenderTargetPool();
+    ~TempRenderTargetPool();
+
+    void Initialize(TempRenderTargetDevice* device, const TempRenderTargetPoolSettings& settings);
+    void Shutdown();
+
+    // Releases all targets and heaps. None of the targets can be in use.
+    void Clear();
+
+    // Returns a target that isn't in use and matches the desc, preferring targets that were
+    // used before. A target that has a UAV can be returned when no UAV was asked for.
+    PooledRenderTarget* Acquire(const TempRenderTargetDesc& desc);
+
+    // Releases the targets that weren't used for the number of frames in the settings,
+    // and the heaps that no longer have targets in them. Call once per frame.
+    void Trim();
+
+    void ResetPeakStats();
+
+    uint64 NumTargets() const { return targets.Count(); }
+    const PooledRenderTarget* Target(uint64 idx) const { return targets[idx]; }
+    uint64 NumHeaps() const { return heaps.Count(); }
+
+    const TempRenderTargetPoolSettings& Settings() const { return settings; }
+    const TempRenderTargetPoolStats& Stats() const { return stats; }
+
+protected:
+
+    static bool IsCompatible(const PooledRenderTarget* target, const TempRenderTargetDesc& desc);
+    static bool IsExactMatch(const PooledRenderTarget* target, const TempRenderTargetDesc& desc);
+    static bool IsMemoryAvailable(const PooledRenderTarget* target);
+
+    TempRenderTargetHeap* FindFreeHeap(uint64 size);
+    void DestroyTarget(uint64 idx);
+    void UpdateStats();
+
+    TempRenderTargetDevice* device = nullptr;
+    TempRenderTargetPoolSettings settings;
+    GrowableList<PooledRenderTarget*> targets;
+    GrowableList<TempRenderTargetHeap*> heaps;
+    TempRenderTargetPoolStats stats;
+};
+
+}
@@ -13,10 +13,13 @@
 #include "..\\Exceptions.h"
 #include "Textures.h"
 #include "..\\FileIO.h"
+#include "..\\Tasks.h"
 #include "ShaderCompilation.h"
 #include "GraphicsTypes.h"
-#include "TinyEXR.h"
+#include "EXRWriter.h"
 #include "DX12.h"
+#include "SH.h"
+#include "SG.h"
 
 namespace SampleFramework12
 {
@@ -443,6 +446,28 @@ void GetTextureData(const Texture& texture, TextureData<Float4>& textureData)
     GetTextureData(texture, DXGI_FORMAT_R32G32B32A32_FLOAT, textureData);
 }
 
+// Reads back a cubemap and projects it onto SH9, the projection itself is in SH.cpp
+SH9Color ProjectCubemapToSH(const Texture& texture)
+{
+    Assert_(texture.Cubemap);
+
+    TextureData<Float4> textureData;
+    GetTextureData(texture, textureData);
+
+    return ProjectCubemapToSH(textureData);
+}
+
+// Reads back a cubemap and solves for a set of SG's, the solve itself is in SG.cpp
+void SolveSGsForCubemap(const Texture& texture, SG* outSGs, uint64 numSGs, SGSolveMode solveMode)
+{
+    Assert_(texture.Cubemap);
+
+    TextureData<Float4> textureData;
+    GetTextureData(texture, textureData);
+
+    SolveSGsForCubemap(textureData, outSGs, numSGs, solveMode);
+}
+
 void Create2DTexture(Texture& texture, const TextureData<UByte4N>& textureData, bool srgb)
 {
     Assert_(textureData.Texels.Size() > 0);
@@ -503,43 +528,144 @@ void SaveTextureAsEXR(const TextureData<Float4>& texture, const wchar* filePath)
 {
     WriteLog("Saving EXR file '%ls'", filePath);
 
-    Assert_(texture.Texels.Size() > 0);
-    Assert_(texture.Width > 0 && texture.Height > 0);
-    Assert_(texture.NumSlices == 1);
-
-    const uint64 numTexels = texture.Texels.Size();
-    std::vector<float> channelDataR;
-    std::vector<float> channelDataG;
-    std::vector<float> channelDataB;
-    channelDataR.resize(numTexels);
-    channelDataG.resize(numTexels);
-    channelDataB.resize(numTexels);
-    for(uint64 i = 0; i < numTexels; ++i)
+    WriteEXR(texture, filePath);
+}
+
+// AsyncEXRWriter lives here rather than in EXRWriter.cpp because it reads back textures and logs, which
+// keeps WriteEXR free of D3D12 and the app
+struct EXRWriteJob
+{
+    TextureData<Float4> Snapshot;
+    std::wstring FilePath;
+    EXRWriteSettings Settings;
+    std::wstring Error;
+
+    bool Running = false;
+    enki::TaskSet Task;
+
+    EXRWriteJob();
+};
+
+EXRWriteJob::EXRWriteJob() : Task(1, [this](enki::TaskSetPartition range, uint32 threadNum)
+{
+    try
     {
-        channelDataR[i] = texture.Texels[i].x;
-        channelDataG[i] = texture.Texels[i].y;
-        channelDataB[i] = texture.Texels[i].z;
+        WriteEXR(Snapshot, FilePath.c_str(), Settings);
     }
+    catch(Exception& e)
+    {
+        Error = e.GetMessage();
+    }
+})
+{
+}
 
-    float* imageChannels[3] = { channelDataB.data(), channelDataG.data(), channelDataR.data() };
-    const char* channelNames[3] = { "B", "G", "R" };
+// Waits for a running job, and throws if it failed
+static void FinishEXRWriteJob(EXRWriteJob* job)
+{
+    if(job == nullptr || job->Running == false)
+        return;
+
+    GetTaskScheduler().WaitforTaskSet(&job->Task);
+    job->Running = false;
+
+    if(job->Error.length() > 0)
+    {
+        const std::wstring error = job->Error;
+        job->Error.clear();
+        throw Exception(error);
+    }
+}
 
-    EXRImage exrImage;
-    exrImage.num_channels = 3;
-    exrImage.width = texture.Width;
-    exrImage.height = texture.Height;
-    exrImage.channel_names = channelNames;
-    exrImage.images = imageChannels;
+// Returns the job if it's free to start a new write
+static EXRWriteJob* AcquireEXRWriteJob(AsyncEXRWriter& writer)
+{
+    if(writer.Job == nullptr)
+        writer.Job = new EXRWriteJob();
 
-    std::string filePathAnsi = WStringToAnsi(filePath);
+    if(writer.Job->Running && writer.Job->Task.GetIsComplete() == false)
+        return nullptr;
 
-    const char* errorString = nullptr;
-    int returnCode = SaveMultiChannelEXR(&exrImage, filePathAnsi.c_str(), &errorString);
-    if(returnCode != 0)
+    FinishEXRWriteJob(writer.Job);
+    return writer.Job;
+}
+
+static void StartEXRWriteJob(EXRWriteJob& job, const wchar* filePath, const EXRWriteSettings& settings)
+{
+    Assert_(job.Snapshot.NumSlices == 1);
+
+    WriteLog("Saving EXR file '%ls'", filePath);
+
+    job.FilePath = filePath;
+    job.Settings = settings;
+    job.Running = true;
+    GetTaskScheduler().AddTaskSetToPipe(&job.Task);
+}
+
+bool AsyncEXRWriter::Write(const TextureData<Float4>& texture, const wchar* filePath, const EXRWriteSettings& settings)
+{
+    EXRWriteJob* job = AcquireEXRWriteJob(*this);
+    if(job == nullptr)
+        return false;
+
+    // The snapshot keeps its memory between writes, so saving every few frames doesn't reallocate
+    TextureData<Float4>& snapshot = job->Snapshot;
+    if(snapshot.Texels.Size() != texture.Texels.Size())
+        snapshot.Texels.Init(texture.Texels.Size());
+    snapshot.Width = texture.Width;
+    snapshot.Height = texture.Height;
+    snapshot.NumSlices = texture.NumSlices;
+    memcpy(snapshot.Texels.Data(), texture.Texels.Data(), texture.Texels.MemorySize());
+
+    StartEXRWriteJob(*job, filePath, settings);
+
+    return true;
+}
+
+bool AsyncEXRWriter::Write(const Texture& texture, const wchar* filePath, const EXRWriteSettings& settings)
+{
+    EXRWriteJob* job = AcquireEXRWriteJob(*this);
+    if(job == nullptr)
+        return false;
+
+    GetTextureData(texture, job->Snapshot);
+    StartEXRWriteJob(*job, filePath, settings);
+
+    return true;
+}
+
+bool AsyncEXRWriter::Writing() const
+{
+    return Job != nullptr && Job->Running && Job->Task.GetIsComplete() == false;
+}
+
+void AsyncEXRWriter::Wait()
+{
+    FinishEXRWriteJob(Job);
+}
+
+void AsyncEXRWriter::Shutdown()
+{
+    if(Job == nullptr)
+        return;
+
+    // Errors can't be reported from here, so they're only logged
+    try
+    {
+        FinishEXRWriteJob(Job);
+    }
+    catch(Exception& e)
     {
-        AssertFail_("%s", errorString);
-        throw Exception(AnsiToWString(errorString));
+        WriteLog(L"Failed to save EXR file '%ls': %ls", Job->FilePath.c_str(), e.GetMessage().c_str());
     }
+
+    delete Job;
+    Job = nullptr;
+}
+
+AsyncEXRWriter::~AsyncEXRWriter()
+{
+    Assert_(Job == nullptr);
 }
 
 void SaveTextureAsPNG(const Texture& texture, const wchar* filePath)
@@ -581,38 +707,4 @@ void SaveTextureAsTIFF(const TextureData<UShort4N>& texture, const wchar* filePa
                          DirectX::GetWICCodec(DirectX::WIC_CODEC_TIFF), filePath));
 }
 
-// Utility function to map a XY + Side coordinate to a direction vector
-Float3 MapXYSToDirection(uint64 x, uint64 y, uint64 s, uint64 width, uint64 height)
-{
-    float u = ((x + 0.5f) / float(width)) * 2.0f - 1.0f;
-    float v = ((y + 0.5f) / float(height)) * 2.0f - 1.0f;
-    v *= -1.0f;
-
-    Float3 dir = Float3(0.0f);
-
-    // +x, -x, +y, -y, +z, -z
-    switch(s) {
-    case 0:
-        dir = Float3::Normalize(Float3(1.0f, v, -u));
-        break;
-    case 1:
-        dir = Float3::Normalize(Float3(-1.0f, v, u));
-        break;
-    case 2:
-        dir = Float3::Normalize(Float3(u, 1.0f, -v));
-        break;
-    case 3:
-        dir = Float3::Normalize(Float3(u, -1.0f, v));
-        break;
-    case 4:
-        dir = Float3::Normalize(Float3(u, v, 1.0f));
-        break;
-    case 5:
-        dir = Float3::Normalize(Float3(-u, v, -1.0f));
-        break;
-    }
-
-    return dir;
 }
-
-}
\ No newline at end of file
@@ -80,6 +80,26 @@ void SaveTextureAsTIFF(const TextureData<UShort4N>& texture, const wchar* filePa
 
 Float3 MapXYSToDirection(uint64 x, uint64 y, uint64 s, uint64 width, uint64 height);
 
+// Per-texel directions and solid angle weights for a cubemap resolution, stored as separate arrays
+// so that they can be loaded straight into SIMD registers. Texels are in the same order as the
+// texels of TextureData (face * width * height + y * width + x).
+struct CubemapTexelTable
+{
+    uint32 Width = 0;
+    uint32 Height = 0;
+    uint64 NumTexels = 0;
+
+    Array<float> DirX;
+    Array<float> DirY;
+    Array<float> DirZ;
+    Array<float> Weights;
+    float WeightSum = 0.0f;
+};
+
+// Returns the table for a cubemap resolution. Tables are built on first use and kept around, so
+// projecting a cubemap that changes every frame doesn't have to recompute the directions.
+const CubemapTexelTable& GetCubemapTexelTable(uint32 width, uint32 height);
+
 // == Texture Sampling Functions ==================================================================
 
 template<typename T> static DirectX::XMVECTOR SampleTexture2D(Float2 uv, uint32 arraySlice, const Array<T>& texels,
@@ -1253,6 +1253,28 @@ void Random::SeedWithRandomValue()
     c = device() % 698769068 + 1;
 }
 
+// Derives the full generator state from a single value, so that separate generators can be
+// seeded deterministically (e.g. one per task)
+void Random::Seed(uint32 seed)
+{
+    // SplitMix-style mixing, so that nearby seeds give unrelated states
+    uint64 state = seed;
+    uint32 values[4] = { };
+    for(uint32 i = 0; i < 4; ++i)
+    {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64 z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        values[i] = uint32(z ^ (z >> 31));
+    }
+
+    x = values[0];
+    y = values[1] != 0 ? values[1] : 987654321;
+    z = values[2];
+    c = values[3] % 698769068 + 1;
+}
+
 uint32 Random::RandomUint()
 {
     x = 314527869 * x + 1234567;
@@ -508,6 +508,7 @@ public:
 
     void Roll(uint32 numRolls);
     void SeedWithRandomValue();
+    void Seed(uint32 seed);
 
     uint32 RandomUint();
     float RandomFloat();
@@ -0,0 +1,168 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#ifndef SAMPLE_SEQUENCES_HLSL_
+#define SAMPLE_SEQUENCES_HLSL_
+
+// Shader versions of the samplers in SampleSequences.h, which return the same values as the CPU code.
+// The PMJ02 and blue noise functions read from a buffer created with SampleTables::CreateBuffer().
+
+// == Owen-scrambled Sobol ========================================================================
+
+// Generator matrices for the first 4 Sobol dimensions, indexed by bit
+static const uint4 SobolMatrices[32] =
+{
+    uint4(0x80000000, 0x80000000, 0x80000000, 0x80000000),
+    uint4(0x40000000, 0xc0000000, 0xc0000000, 0xc0000000),
+    uint4(0x20000000, 0xa0000000, 0x60000000, 0x20000000),
+    uint4(0x10000000, 0xf0000000, 0x90000000, 0x50000000),
+    uint4(0x08000000, 0x88000000, 0xe8000000, 0xf8000000),
+    uint4(0x04000000, 0xcc000000, 0x5c000000, 0x74000000),
+    uint4(0x02000000, 0xaa000000, 0x8e000000, 0xa2000000),
+    uint4(0x01000000, 0xff000000, 0xc5000000, 0x93000000),
+    uint4(0x00800000, 0x80800000, 0x68800000, 0xd8800000),
+    uint4(0x00400000, 0xc0c00000, 0x9cc00000, 0x25400000),
+    uint4(0x00200000, 0xa0a00000, 0xee600000, 0x59e00000),
+    uint4(0x00100000, 0xf0f00000, 0x55900000, 0xe6d00000),
+    uint4(0x00080000, 0x88880000, 0x80680000, 0x78080000),
+    uint4(0x00040000, 0xcccc0000, 0xc09c0000, 0xb40c0000),
+    uint4(0x00020000, 0xaaaa0000, 0x60ee0000, 0x82020000),
+    uint4(0x00010000, 0xffff0000, 0x90550000, 0xc3050000),
+    uint4(0x00008000, 0x80008000, 0xe8808000, 0x208f8000),
+    uint4(0x00004000, 0xc000c000, 0x5cc0c000, 0x51474000),
+    uint4(0x00002000, 0xa000a000, 0x8e606000, 0xfbea2000),
+    uint4(0x00001000, 0xf000f000, 0xc5909000, 0x75d93000),
+    uint4(0x00000800, 0x88008800, 0x6868e800, 0xa0858800),
+    uint4(0x00000400, 0xcc00cc00, 0x9c9c5c00, 0x914e5400),
+    uint4(0x00000200, 0xaa00aa00, 0xeeee8e00, 0xdbe79e00),
+    uint4(0x00000100, 0xff00ff00, 0x5555c500, 0x25db6d00),
+    uint4(0x00000080, 0x80808080, 0x8000e880, 0x58800080),
+    uint4(0x00000040, 0xc0c0c0c0, 0xc0005cc0, 0xe54000c0),
+    uint4(0x00000020, 0xa0a0a0a0, 0x60008e60, 0x79e00020),
+    uint4(0x00000010, 0xf0f0f0f0, 0x9000c590, 0xb6d00050),
+    uint4(0x00000008, 0x88888888, 0xe8006868, 0x800800f8),
+    uint4(0x00000004, 0xcccccccc, 0x5c009c9c, 0xc00c0074),
+    uint4(0x00000002, 0xaaaaaaaa, 0x8e00eeee, 0x200200a2),
+    uint4(0x00000001, 0xffffffff, 0xc5005555, 0x50050093)
+};
+
+uint SobolHashCombine(uint seed, uint value)
+{
+    return seed ^ (value + (seed << 6) + (seed >> 2));
+}
+
+uint SobolHashUint(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+uint4 LaineKarrasPermutation(uint4 x, uint4 seed)
+{
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+uint4 NestedUniformScramble(uint4 x, uint4 seed)
+{
+    return reversebits(LaineKarrasPermutation(reversebits(x), seed));
+}
+
+// Converts 0.32 fixed point values to floats in [0, 1), keeping the top 24 bits so that the result is exact
+float4 SobolFixedPointToFloat(uint4 x)
+{
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+float4 SampleSobolOwen4D(uint sampleIdx, uint groupIdx, uint seed)
+{
+    const uint indexSeed = SobolHashUint(SobolHashCombine(seed, groupIdx));
+    const uint4 dimSeeds = uint4(SobolHashUint(SobolHashCombine(indexSeed, 1)), SobolHashUint(SobolHashCombine(indexSeed, 2)),
+                                 SobolHashUint(SobolHashCombine(indexSeed, 3)), SobolHashUint(SobolHashCombine(indexSeed, 4)));
+
+    // Shuffle the sample index so that the groups are decorrelated from each other
+    uint index = NestedUniformScramble(sampleIdx, indexSeed).x;
+
+    uint4 result = 0;
+    for(uint bit = 0; index != 0; ++bit, index >>= 1)
+    {
+        if(index & 1)
+            result ^= SobolMatrices[bit];
+    }
+
+    return SobolFixedPointToFloat(NestedUniformScramble(result, dimSeeds));
+}
+
+float2 SampleSobolOwen2D(uint sampleIdx, uint dimIdx, uint seed)
+{
+    return SampleSobolOwen4D(sampleIdx, dimIdx / 4, seed).xy;
+}
+
+float SampleSobolOwen(uint sampleIdx, uint dimIdx, uint seed)
+{
+    const float4 group = SampleSobolOwen4D(sampleIdx, dimIdx / 4, seed);
+    return group[dimIdx % 4];
+}
+
+// == Sample Tables ===============================================================================
+
+// Byte offsets of the SampleTablesHeader members
+static const uint SampleTablesNumPMJ02SetsOffset = 12;
+static const uint SampleTablesPMJ02SetSizeOffset = 16;
+static const uint SampleTablesPMJ02Offset = 20;
+static const uint SampleTablesBlueNoiseSizeOffset = 24;
+static const uint SampleTablesBlueNoiseOffset = 28;
+
+float2 SamplePMJ02(ByteAddressBuffer sampleTables, uint setIdx, uint sampleIdx)
+{
+    const uint numSets = sampleTables.Load(SampleTablesNumPMJ02SetsOffset);
+    const uint setSize = sampleTables.Load(SampleTablesPMJ02SetSizeOffset);
+    const uint pmj02Offset = sampleTables.Load(SampleTablesPMJ02Offset);
+
+    const uint elemIdx = (setIdx % numSets) * setSize + (sampleIdx % setSize);
+    const uint2 sample = sampleTables.Load2(pmj02Offset + elemIdx * 8);
+    return SobolFixedPointToFloat(uint4(sample, 0, 0)).xy;
+}
+
+// Each dimension reads the mask with a different toroidal offset (from the R2 sequence), matching
+// SampleTables::SampleBlueNoise()
+float SampleBlueNoise(ByteAddressBuffer sampleTables, uint2 pixelPos, uint dimIdx)
+{
+    const uint size = sampleTables.Load(SampleTablesBlueNoiseSizeOffset);
+    const uint blueNoiseOffset = sampleTables.Load(SampleTablesBlueNoiseOffset);
+
+    const uint2 offset = uint2(dimIdx * 0.7548776662f * size, dimIdx * 0.5698402910f * size);
+    const uint2 texelPos = (pixelPos + offset) % size;
+    const uint texelIdx = texelPos.y * size + texelPos.x;
+
+    // Ranks are 16-bit, so each 32-bit load contains two texels
+    const uint packedRanks = sampleTables.Load(blueNoiseOffset + (texelIdx & ~1u) * 2);
+    const uint rank = (texelIdx & 1) ? (packedRanks >> 16) : (packedRanks & 0xFFFF);
+    return (rank + 0.5f) / (size * size);
+}
+
+float BlueNoiseDithered(ByteAddressBuffer sampleTables, float sample, uint2 pixelPos, uint dimIdx)
+{
+    return frac(sample + SampleBlueNoise(sampleTables, pixelPos, dimIdx));
+}
+
+float SampleSobolOwenDithered(ByteAddressBuffer sampleTables, uint sampleIdx, uint dimIdx, uint seed, uint2 pixelPos)
+{
+    return BlueNoiseDithered(sampleTables, SampleSobolOwen(sampleIdx, dimIdx, seed), pixelPos, dimIdx);
+}
+
+#endif // SAMPLE_SEQUENCES_HLSL_
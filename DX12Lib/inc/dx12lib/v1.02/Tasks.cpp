@@ -0,0 +1,49 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tasks.h"
+
+namespace SampleFramework12
+{
+
+static enki::TaskScheduler TaskScheduler;
+static bool TaskSchedulerInitialized = false;
+static SRWLOCK TaskSchedulerLock = SRWLOCK_INIT;
+
+enki::TaskScheduler& GetTaskScheduler()
+{
+    AcquireSRWLockExclusive(&TaskSchedulerLock);
+
+    if(TaskSchedulerInitialized == false)
+    {
+        TaskScheduler.Initialize();
+        TaskSchedulerInitialized = true;
+    }
+
+    ReleaseSRWLockExclusive(&TaskSchedulerLock);
+
+    return TaskScheduler;
+}
+
+void ShutdownTaskScheduler()
+{
+    AcquireSRWLockExclusive(&TaskSchedulerLock);
+
+    if(TaskSchedulerInitialized)
+    {
+        TaskScheduler.WaitforAllAndShutdown();
+        TaskSchedulerInitialized = false;
+    }
+
+    ReleaseSRWLockExclusive(&TaskSchedulerLock);
+}
+
+}
@@ -0,0 +1,22 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  http://mynameismjp.wordpress.com/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+#include "EnkiTS\\TaskScheduler.h"
+
+namespace SampleFramework12
+{
+
+// Returns the task scheduler that's shared by the framework, its worker threads are created on first use
+enki::TaskScheduler& GetTaskScheduler();
+void ShutdownTaskScheduler();
+
+}
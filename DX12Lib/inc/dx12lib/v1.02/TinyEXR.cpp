@@ -6975,6 +6975,20 @@ void DecompressZip(unsigned char *dst, unsigned long &uncompressedSize,
 
 } // namespace
 
+// == SF12 Changes START ==========================================================================
+int CompressZlib(unsigned char *dst, unsigned long *dst_size,
+                 const unsigned char *src, unsigned long src_size, int level) {
+  miniz::mz_ulong outSize = *dst_size;
+  int ret = miniz::mz_compress2(dst, &outSize, src, src_size, level);
+  *dst_size = outSize;
+  return ret == miniz::MZ_OK ? 0 : -1;
+}
+
+unsigned long CompressZlibBound(unsigned long src_size) {
+  return miniz::mz_compressBound(src_size);
+}
+// == SF12 Changes END ==========================================================================
+
 int LoadEXR(float **out_rgba, int *width, int *height, const char *filename,
             const char **err) {
 
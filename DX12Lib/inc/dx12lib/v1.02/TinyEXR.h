@@ -84,6 +84,17 @@ extern int SaveMultiChannelEXR(const EXRImage *image, const char *filename,
 extern int LoadDeepEXR(DeepImage *out_image, const char *filename,
                        const char **err);
 
+// == SF12 Changes START ==========================================================================
+// Compresses data into a zlib stream with the embedded copy of miniz, so that EXR blocks can be
+// compressed outside of TinyEXR. Thread-safe. Returns 0 if successful.
+extern int CompressZlib(unsigned char *dst, unsigned long *dst_size,
+                        const unsigned char *src, unsigned long src_size,
+                        int level);
+
+// Upper bound on the compressed size of src_size bytes
+extern unsigned long CompressZlibBound(unsigned long src_size);
+// == SF12 Changes END ==========================================================================
+
 // NOT YET IMPLEMENTED:
 // Saves single-frame OpenEXR deep image.
 // Return 0 if success
@@ -0,0 +1,223 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/BindlessDescriptorTable.h>
+
+#include <dx12lib/CommandQueue.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/Texture.h>
+
+using namespace dx12lib;
+
+static const D3D12_COMMAND_LIST_TYPE QueueTypes[] = { D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_TYPE_COMPUTE,
+                                                      D3D12_COMMAND_LIST_TYPE_COPY };
+
+BindlessDescriptorTable::BindlessDescriptorTable( Device& device, uint32_t capacity )
+: m_Device( device )
+, m_Capacity( capacity )
+, m_NullSRVDesc {}
+, m_NumUsedDescriptors( 0 )
+, m_NumDescriptors( 0 )
+, m_Version( 1 )
+{
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
+    descriptorHeapDesc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    descriptorHeapDesc.NumDescriptors             = m_Capacity;
+    descriptorHeapDesc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+    ThrowIfFailed( d3d12Device->CreateDescriptorHeap( &descriptorHeapDesc, IID_PPV_ARGS( &m_DescriptorHeap ) ) );
+
+    m_BaseDescriptor = m_DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_DescriptorHandleIncrementSize =
+        m_Device.GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+
+    // Released descriptors are replaced with a null descriptor so that reading
+    // them in a shader returns 0 instead of undefined results.
+    m_NullSRVDesc.Format                        = DXGI_FORMAT_R8G8B8A8_UNORM;
+    m_NullSRVDesc.ViewDimension                 = D3D12_SRV_DIMENSION_TEXTURE2D;
+    m_NullSRVDesc.Shader4ComponentMapping       = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    m_NullSRVDesc.Texture2D.MipLevels           = 1;
+    m_NullSRVDesc.Texture2D.MostDetailedMip     = 0;
+    m_NullSRVDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+
+    m_Resources.resize( m_Capacity );
+    m_DescriptorVersions.resize( m_Capacity );
+}
+
+BindlessDescriptorTable::~BindlessDescriptorTable() {}
+
+void BindlessDescriptorTable::ProcessRetiredDescriptors()
+{
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    // Descriptors are retired in the order they are released, so the fence values
+    // of each queue only increase.
+    while ( !m_RetiredDescriptors.empty() )
+    {
+        auto& retiredDescriptor = m_RetiredDescriptors.front();
+        for ( size_t i = 0; i < _countof( QueueTypes ); ++i )
+        {
+            if ( !m_Device.GetCommandQueue( QueueTypes[i] ).IsFenceComplete( retiredDescriptor.FenceValues[i] ) )
+            {
+                return;
+            }
+        }
+
+        // The GPU no longer uses the descriptor, replace it with a null descriptor
+        // before the index is reused.
+        uint32_t                      index = retiredDescriptor.Index;
+        CD3DX12_CPU_DESCRIPTOR_HANDLE dstDescriptor( m_BaseDescriptor, index, m_DescriptorHandleIncrementSize );
+        d3d12Device->CreateShaderResourceView( nullptr, &m_NullSRVDesc, dstDescriptor );
+
+        m_DescriptorVersions[index] = ++m_Version;
+        m_FreeIndices.push_back( index );
+        m_RetiredDescriptors.pop_front();
+    }
+}
+
+uint32_t BindlessDescriptorTable::AllocateIndex()
+{
+    ProcessRetiredDescriptors();
+
+    uint32_t index;
+    if ( !m_FreeIndices.empty() )
+    {
+        index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+    }
+    else if ( m_NumUsedDescriptors < m_Capacity )
+    {
+        index = m_NumUsedDescriptors++;
+    }
+    else
+    {
+        throw std::exception( "The bindless descriptor table is full." );
+    }
+
+    ++m_NumDescriptors;
+
+    return index;
+}
+
+uint32_t BindlessDescriptorTable::RegisterTexture( const std::shared_ptr<Texture>& texture )
+{
+    // Textures that don't have a default SRV can't be registered.
+    if ( !texture || ( texture->GetD3D12ResourceDesc().Flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE ) != 0 ||
+         !texture->CheckSRVSupport() )
+    {
+        return InvalidIndex;
+    }
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    auto iter = m_TextureIndices.find( texture.get() );
+    if ( iter != m_TextureIndices.end() )
+    {
+        return iter->second;
+    }
+
+    uint32_t index = RegisterDescriptor( texture, texture->GetShaderResourceView() );
+
+    m_TextureIndices[texture.get()] = index;
+
+    return index;
+}
+
+uint32_t BindlessDescriptorTable::RegisterShaderResourceView( const std::shared_ptr<Resource>& resource,
+                                                              D3D12_CPU_DESCRIPTOR_HANDLE      srv )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    return RegisterDescriptor( resource, srv );
+}
+
+uint32_t BindlessDescriptorTable::RegisterDescriptor( const std::shared_ptr<Resource>& resource,
+                                                      D3D12_CPU_DESCRIPTOR_HANDLE      srv )
+{
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    uint32_t index = AllocateIndex();
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dstDescriptor( m_BaseDescriptor, index, m_DescriptorHandleIncrementSize );
+    d3d12Device->CopyDescriptorsSimple( 1, dstDescriptor, srv, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+
+    m_Resources[index]          = resource;
+    m_DescriptorVersions[index] = ++m_Version;
+
+    return index;
+}
+
+void BindlessDescriptorTable::Release( uint32_t index )
+{
+    // The descriptor can be used by any command list that has been executed
+    // on one of the command queues.
+    RetiredDescriptor retiredDescriptor = { index };
+    for ( size_t i = 0; i < _countof( QueueTypes ); ++i )
+    {
+        retiredDescriptor.FenceValues[i] = m_Device.GetCommandQueue( QueueTypes[i] ).Signal();
+    }
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    if ( index >= m_NumUsedDescriptors || !m_Resources[index] )
+    {
+        return;
+    }
+
+    auto iter = m_TextureIndices.find( m_Resources[index].get() );
+    if ( iter != m_TextureIndices.end() && iter->second == index )
+    {
+        m_TextureIndices.erase( iter );
+    }
+
+    // The resource is kept alive until the descriptor is no longer used on the GPU.
+    retiredDescriptor.Resource = std::move( m_Resources[index] );
+    m_RetiredDescriptors.push_back( std::move( retiredDescriptor ) );
+    --m_NumDescriptors;
+
+    ProcessRetiredDescriptors();
+}
+
+uint32_t BindlessDescriptorTable::GetTextureIndex( const std::shared_ptr<Texture>& texture ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    auto iter = m_TextureIndices.find( texture.get() );
+    return iter != m_TextureIndices.end() ? iter->second : InvalidIndex;
+}
+
+uint32_t BindlessDescriptorTable::GetNumDescriptors() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_NumDescriptors;
+}
+
+uint64_t BindlessDescriptorTable::CopyDescriptors( D3D12_CPU_DESCRIPTOR_HANDLE dstDescriptor,
+                                                   uint64_t                    copiedVersion ) const
+{
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    // Only the descriptors that have been used are copied, and only the ranges of
+    // descriptors that have been written since the copied version.
+    uint32_t index = 0;
+    while ( index < m_NumUsedDescriptors )
+    {
+        if ( m_DescriptorVersions[index] <= copiedVersion )
+        {
+            ++index;
+            continue;
+        }
+
+        uint32_t firstIndex = index;
+        while ( index < m_NumUsedDescriptors && m_DescriptorVersions[index] > copiedVersion ) { ++index; }
+
+        CD3DX12_CPU_DESCRIPTOR_HANDLE dst( dstDescriptor, firstIndex, m_DescriptorHandleIncrementSize );
+        CD3DX12_CPU_DESCRIPTOR_HANDLE src( m_BaseDescriptor, firstIndex, m_DescriptorHandleIncrementSize );
+        d3d12Device->CopyDescriptorsSimple( index - firstIndex, dst, src, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+    }
+
+    return m_Version.load();
+}
@@ -4,6 +4,8 @@
 
 #include <dx12lib/ByteAddressBuffer.h>
 #include <dx12lib/CommandQueue.h>
+#include <dx12lib/CommandRecorder.h>
+#include <dx12lib/CommandSignature.h>
 #include <dx12lib/ConstantBuffer.h>
 #include <dx12lib/ConstantBufferView.h>
 #include <dx12lib/Device.h>
@@ -12,7 +14,9 @@
 #include <dx12lib/IndexBuffer.h>
 #include <dx12lib/Material.h>
 #include <dx12lib/Mesh.h>
+#include <dx12lib/MipGenerator.h>
 #include <dx12lib/PanoToCubemapPSO.h>
+#include <dx12lib/PipelineStateCache.h>
 #include <dx12lib/PipelineStateObject.h>
 #include <dx12lib/RenderTarget.h>
 #include <dx12lib/Resource.h>
@@ -21,8 +25,11 @@
 #include <dx12lib/Scene.h>
 #include <dx12lib/SceneNode.h>
 #include <dx12lib/ShaderResourceView.h>
+#include <dx12lib/StagingAllocator.h>
 #include <dx12lib/StructuredBuffer.h>
 #include <dx12lib/Texture.h>
+#include <dx12lib/TextureCooker.h>
+#include <dx12lib/TiledImage.h>
 #include <dx12lib/UnorderedAccessView.h>
 #include <dx12lib/UploadBuffer.h>
 #include <dx12lib/VertexBuffer.h>
@@ -48,6 +55,9 @@ CommandList::CommandList( Device& device, D3D12_COMMAND_LIST_TYPE type )
 , m_d3d12CommandListType( type )
 , m_RootSignature( nullptr )
 , m_PipelineState( nullptr )
+, m_NumPendingUploadBytes( 0 )
+, m_NumStagedBytes( 0 )
+, m_CaptureDepth( 0 )
 {
     auto d3d12Device = m_Device.GetD3D12Device();
 
@@ -74,8 +84,19 @@ CommandList::~CommandList() {}
 void CommandList::TransitionBarrier( Microsoft::WRL::ComPtr<ID3D12Resource> resource, D3D12_RESOURCE_STATES stateAfter,
                                      UINT subresource, bool flushBarriers )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::TransitionBarrier,
+                                           commands::TransitionBarrier { capture->GetResourceId( resource.Get() ),
+                                                                         stateAfter, subresource, flushBarriers } );
+    }
+
     if ( resource )
     {
+        // Staged uploads to the resource must be recorded before the resource changes state.
+        FlushPendingUploads( resource.Get() );
+
         // The "before" state is not important. It will be resolved by the resource state tracker.
         auto barrier = CD3DX12_RESOURCE_BARRIER::Transition( resource.Get(), D3D12_RESOURCE_STATE_COMMON, stateAfter,
                                                              subresource );
@@ -93,12 +114,29 @@ void CommandList::TransitionBarrier( const std::shared_ptr<Resource>& resource,
 {
     if ( resource )
     {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            capture->GetWriter().WriteCommand( CommandOp::TransitionBarrier,
+                                               commands::TransitionBarrier { capture->GetResourceId( resource.get() ),
+                                                                             stateAfter, subresource, flushBarriers } );
+        }
+
         TransitionBarrier( resource->GetD3D12Resource(), stateAfter, subresource, flushBarriers );
     }
 }
 
 void CommandList::UAVBarrier( Microsoft::WRL::ComPtr<ID3D12Resource> resource, bool flushBarriers )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::UAVBarrier, commands::UAVBarrier { capture->GetResourceId( resource.Get() ), flushBarriers } );
+    }
+
+    FlushPendingUploads( resource.Get() );
+
     auto barrier = CD3DX12_RESOURCE_BARRIER::UAV( resource.Get() );
 
     m_ResourceStateTracker->ResourceBarrier( barrier );
@@ -111,6 +149,13 @@ void CommandList::UAVBarrier( Microsoft::WRL::ComPtr<ID3D12Resource> resource, b
 
 void CommandList::UAVBarrier( const std::shared_ptr<Resource>& resource, bool flushBarriers )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::UAVBarrier, commands::UAVBarrier { capture->GetResourceId( resource.get() ), flushBarriers } );
+    }
+
     auto d3d12Resource = resource ? resource->GetD3D12Resource() : nullptr;
     UAVBarrier( d3d12Resource, flushBarriers );
 }
@@ -118,6 +163,18 @@ void CommandList::UAVBarrier( const std::shared_ptr<Resource>& resource, bool fl
 void CommandList::AliasingBarrier( Microsoft::WRL::ComPtr<ID3D12Resource> beforeResource,
                                    Microsoft::WRL::ComPtr<ID3D12Resource> afterResource, bool flushBarriers )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::AliasingBarrier,
+                                           commands::AliasingBarrier { capture->GetResourceId( beforeResource.Get() ),
+                                                                       capture->GetResourceId( afterResource.Get() ),
+                                                                       flushBarriers } );
+    }
+
+    FlushPendingUploads( beforeResource.Get() );
+    FlushPendingUploads( afterResource.Get() );
+
     auto barrier = CD3DX12_RESOURCE_BARRIER::Aliasing( beforeResource.Get(), afterResource.Get() );
 
     m_ResourceStateTracker->ResourceBarrier( barrier );
@@ -131,6 +188,15 @@ void CommandList::AliasingBarrier( Microsoft::WRL::ComPtr<ID3D12Resource> before
 void CommandList::AliasingBarrier( const std::shared_ptr<Resource>& beforeResource,
                                    const std::shared_ptr<Resource>& afterResource, bool flushBarriers )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::AliasingBarrier,
+                                           commands::AliasingBarrier { capture->GetResourceId( beforeResource.get() ),
+                                                                       capture->GetResourceId( afterResource.get() ),
+                                                                       flushBarriers } );
+    }
+
     auto d3d12BeforeResource = beforeResource ? beforeResource->GetD3D12Resource() : nullptr;
     auto d3d12AfterResource  = afterResource ? afterResource->GetD3D12Resource() : nullptr;
 
@@ -139,6 +205,13 @@ void CommandList::AliasingBarrier( const std::shared_ptr<Resource>& beforeResour
 
 void CommandList::FlushResourceBarriers()
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().BeginCommand( CommandOp::FlushResourceBarriers );
+        capture->GetWriter().EndCommand();
+    }
+
     m_ResourceStateTracker->FlushResourceBarriers( shared_from_this() );
 }
 
@@ -148,6 +221,14 @@ void CommandList::CopyResource( Microsoft::WRL::ComPtr<ID3D12Resource> dstRes,
     assert( dstRes );
     assert( srcRes );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::CopyResource,
+                                           commands::CopyResource { capture->GetResourceId( dstRes.Get() ),
+                                                                    capture->GetResourceId( srcRes.Get() ) } );
+    }
+
     TransitionBarrier( dstRes, D3D12_RESOURCE_STATE_COPY_DEST );
     TransitionBarrier( srcRes, D3D12_RESOURCE_STATE_COPY_SOURCE );
 
@@ -163,6 +244,14 @@ void CommandList::CopyResource( const std::shared_ptr<Resource>& dstRes, const s
 {
     assert( dstRes && srcRes );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::CopyResource,
+                                           commands::CopyResource { capture->GetResourceId( dstRes.get() ),
+                                                                    capture->GetResourceId( srcRes.get() ) } );
+    }
+
     CopyResource( dstRes->GetD3D12Resource(), srcRes->GetD3D12Resource() );
 }
 
@@ -171,6 +260,15 @@ void CommandList::ResolveSubresource( const std::shared_ptr<Resource>& dstRes, c
 {
     assert( dstRes && srcRes );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::ResolveSubresource,
+            commands::ResolveSubresource { capture->GetResourceId( dstRes.get() ), capture->GetResourceId( srcRes.get() ),
+                                           dstSubresource, srcSubresource } );
+    }
+
     TransitionBarrier( dstRes, D3D12_RESOURCE_STATE_RESOLVE_DEST, dstSubresource );
     TransitionBarrier( srcRes, D3D12_RESOURCE_STATE_RESOLVE_SOURCE, srcSubresource );
 
@@ -205,26 +303,28 @@ ComPtr<ID3D12Resource> CommandList::CopyBuffer( size_t bufferSize, const void* b
 
         if ( bufferData != nullptr )
         {
-            // Create an upload resource to use as an intermediate buffer to copy the buffer resource
-            ComPtr<ID3D12Resource> uploadResource;
-            ThrowIfFailed( d3d12Device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES( D3D12_HEAP_TYPE_UPLOAD ), D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer( bufferSize ), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-                IID_PPV_ARGS( &uploadResource ) ) );
-
-            D3D12_SUBRESOURCE_DATA subresourceData = {};
-            subresourceData.pData                  = bufferData;
-            subresourceData.RowPitch               = bufferSize;
-            subresourceData.SlicePitch             = subresourceData.RowPitch;
-
-            m_ResourceStateTracker->TransitionResource( d3d12Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST );
-            FlushResourceBarriers();
-
-            UpdateSubresources( m_d3d12CommandList.Get(), d3d12Resource.Get(), uploadResource.Get(), 0, 0, 1,
-                                &subresourceData );
-
-            // Add references to resources so they stay in scope until the command list is reset.
-            TrackResource( uploadResource );
+            // Stage the buffer data. The copy to the buffer resource is recorded
+            // together with any other pending uploads.
+            auto stagingAllocation = AllocateStagingMemory( bufferSize, D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT );
+            memcpy( stagingAllocation.CPU, bufferData, bufferSize );
+
+            m_PendingBufferUploads.push_back(
+                { d3d12Resource.Get(), 0, stagingAllocation.Resource, stagingAllocation.Offset, bufferSize } );
+            m_PendingUploadResources.insert( d3d12Resource.Get() );
+            m_NumPendingUploadBytes += bufferSize;
+
+            // The buffer is recorded as an upload to a new buffer resource.
+            CaptureScope capture( *this );
+            if ( capture )
+            {
+                Hash64 dataHash;
+                dataHash.Add( bufferData, bufferSize );
+
+                capture->GetWriter().WriteCommand(
+                    CommandOp::CopyBufferRegion,
+                    commands::CopyBufferRegion { capture->GetResourceId( d3d12Resource.Get() ), 0, bufferSize,
+                                                 dataHash.Get() } );
+            }
         }
         TrackResource( d3d12Resource );
     }
@@ -286,10 +386,55 @@ std::shared_ptr<StructuredBuffer> CommandList::CopyStructuredBuffer( size_t numE
 
 void CommandList::SetPrimitiveTopology( D3D_PRIMITIVE_TOPOLOGY primitiveTopology )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::SetPrimitiveTopology,
+                                           commands::SetPrimitiveTopology { primitiveTopology } );
+    }
+
     m_d3d12CommandList->IASetPrimitiveTopology( primitiveTopology );
 }
 
-std::shared_ptr<Texture> CommandList::LoadTextureFromFile( const std::wstring& fileName, bool sRGB )
+// Replace an image that only has the first mip with an image with a full mip chain that is generated on the CPU.
+static void GenerateMipsOnCPU( ScratchImage& scratchImage, TexMetadata& metadata, const MipGenerator& mipGenerator )
+{
+    TexMetadata mipMetadata = metadata;
+    mipMetadata.mipLevels =
+        MipGenerator::GetNumMips( static_cast<uint32_t>( metadata.width ), static_cast<uint32_t>( metadata.height ) );
+
+    ScratchImage mipChain;
+    ThrowIfFailed( mipChain.Initialize( mipMetadata ) );
+
+    std::vector<MipGenerator::Subresource> subresources;
+    for ( size_t item = 0; item < mipMetadata.arraySize; ++item )
+    {
+        const Image* srcImage = scratchImage.GetImage( 0, item, 0 );
+        const Image* dstImage = mipChain.GetImage( 0, item, 0 );
+        for ( size_t y = 0; y < srcImage->height; ++y )
+        {
+            std::memcpy( dstImage->pixels + y * dstImage->rowPitch, srcImage->pixels + y * srcImage->rowPitch,
+                         std::min( srcImage->rowPitch, dstImage->rowPitch ) );
+        }
+
+        for ( size_t mip = 0; mip < mipMetadata.mipLevels; ++mip )
+        {
+            const Image* image = mipChain.GetImage( mip, item, 0 );
+            subresources.push_back( { image->pixels, image->rowPitch, static_cast<uint32_t>( image->width ),
+                                      static_cast<uint32_t>( image->height ) } );
+        }
+    }
+
+    // The format of the metadata is sRGB if the texture is loaded as sRGB, so the mips are filtered in linear space.
+    mipGenerator.Generate( metadata.format, subresources.data(), static_cast<uint32_t>( mipMetadata.mipLevels ),
+                           static_cast<uint32_t>( mipMetadata.arraySize ) );
+
+    scratchImage       = std::move( mipChain );
+    metadata.mipLevels = mipMetadata.mipLevels;
+}
+
+std::shared_ptr<Texture> CommandList::LoadTextureFromFile( const std::wstring& fileName, bool sRGB,
+                                                           const MipGenerator* mipGenerator )
 {
     std::shared_ptr<Texture> texture;
     fs::path                 filePath( fileName );
@@ -298,6 +443,12 @@ std::shared_ptr<Texture> CommandList::LoadTextureFromFile( const std::wstring& f
         throw std::exception( "File not found." );
     }
 
+    // DirectXTex does not load EXR files.
+    if ( filePath.extension() == ".exr" )
+    {
+        return LoadTiledTextureFromFile( fileName );
+    }
+
     std::lock_guard<std::mutex> lock( ms_TextureCacheMutex );
     auto                        iter = ms_TextureCache.find( fileName );
     if ( iter != ms_TextureCache.end() )
@@ -332,6 +483,14 @@ std::shared_ptr<Texture> CommandList::LoadTextureFromFile( const std::wstring& f
             metadata.format = MakeSRGB( metadata.format );
         }
 
+        // GenerateMips can't generate the mips of texture arrays (or cubemaps).
+        if ( metadata.mipLevels == 1 && ( metadata.width > 1 || metadata.height > 1 ) &&
+             metadata.dimension == TEX_DIMENSION_TEXTURE2D && ( mipGenerator || metadata.arraySize > 1 ) &&
+             MipGenerator::IsFormatSupported( metadata.format ) )
+        {
+            GenerateMipsOnCPU( scratchImage, metadata, mipGenerator ? *mipGenerator : MipGenerator() );
+        }
+
         D3D12_RESOURCE_DESC textureDesc = {};
         switch ( metadata.dimension )
         {
@@ -391,6 +550,86 @@ std::shared_ptr<Texture> CommandList::LoadTextureFromFile( const std::wstring& f
     return texture;
 }
 
+std::shared_ptr<Texture> CommandList::LoadTextureFromFile( const std::wstring& fileName, TextureUsage usage )
+{
+    // EXR files are not cooked (DirectXTex does not load them), they are loaded as tiled textures.
+    auto textureCooker = m_Device.GetTextureCooker();
+    if ( textureCooker && fs::path( fileName ).extension() != ".exr" )
+    {
+        // The cooked texture has a full mip chain and the sRGB format is set by the cooker.
+        return LoadTextureFromFile( textureCooker->Cook( fileName, usage ), false );
+    }
+
+    return LoadTextureFromFile( fileName, usage == TextureUsage::Albedo );
+}
+
+std::shared_ptr<Texture> CommandList::LoadTiledTextureFromFile( const std::wstring& fileName, uint32_t maxSize )
+{
+    std::shared_ptr<Texture> texture;
+
+    // The same file can be loaded with different maximum sizes.
+    std::wstring cacheKey = fileName + L"@" + std::to_wstring( maxSize );
+
+    std::lock_guard<std::mutex> lock( ms_TextureCacheMutex );
+    auto                        iter = ms_TextureCache.find( cacheKey );
+    if ( iter != ms_TextureCache.end() )
+    {
+        texture = m_Device.CreateTexture( iter->second );
+    }
+    else
+    {
+        auto image = TiledImage::Open( fileName );
+
+        uint32_t firstMip = image->GetMostDetailedMip( maxSize );
+        uint32_t numMips  = image->GetNumMips() - firstMip;
+
+        auto textureDesc =
+            CD3DX12_RESOURCE_DESC::Tex2D( image->GetFormat(), image->GetWidth( firstMip ), image->GetHeight( firstMip ),
+                                          1, static_cast<UINT16>( numMips ) );
+
+        auto                                   d3d12Device = m_Device.GetD3D12Device();
+        Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
+
+        ThrowIfFailed( d3d12Device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES( D3D12_HEAP_TYPE_DEFAULT ), D3D12_HEAP_FLAG_NONE, &textureDesc,
+            D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS( &textureResource ) ) );
+
+        texture = m_Device.CreateTexture( textureResource );
+        texture->SetName( fileName );
+
+        // Update the global state tracker.
+        ResourceStateTracker::AddGlobalResourceState( textureResource.Get(), D3D12_RESOURCE_STATE_COMMON );
+
+        // Decode and upload one band of tiles at a time. Only the band is held in
+        // memory (besides the staging memory of the upload).
+        size_t               texelSize  = image->GetTexelSize();
+        uint32_t             bandHeight = image->GetTileHeight();
+        std::vector<uint8_t> band( static_cast<size_t>( image->GetWidth( firstMip ) ) * bandHeight * texelSize );
+
+        for ( uint32_t mip = 0; mip < numMips; ++mip )
+        {
+            uint32_t width    = image->GetWidth( firstMip + mip );
+            uint32_t height   = image->GetHeight( firstMip + mip );
+            size_t   rowPitch = width * texelSize;
+
+            for ( uint32_t y = 0; y < height; y += bandHeight )
+            {
+                uint32_t numRows = std::min( bandHeight, height - y );
+                image->ReadRegion( firstMip + mip, 0, y, width, numRows, band.data(), rowPitch );
+
+                D3D12_SUBRESOURCE_DATA subresourceData = { band.data(), static_cast<LONG_PTR>( rowPitch ),
+                                                           static_cast<LONG_PTR>( rowPitch * numRows ) };
+                CopyTextureRegion( texture, mip, 0, y, 0, width, numRows, 1, subresourceData );
+            }
+        }
+
+        // Add the texture resource to the texture cache.
+        ms_TextureCache[cacheKey] = textureResource.Get();
+    }
+
+    return texture;
+}
+
 void CommandList::GenerateMips( const std::shared_ptr<Texture>& texture )
 {
     if ( !texture )
@@ -408,6 +647,13 @@ void CommandList::GenerateMips( const std::shared_ptr<Texture>& texture )
         return;
     }
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::GenerateMips,
+                                           commands::GenerateMips { capture->GetResourceId( texture.get() ) } );
+    }
+
     auto d3d12Resource = texture->GetD3D12Resource();
 
     // If the texture doesn't have a valid resource? Do nothing...
@@ -623,6 +869,14 @@ void CommandList::PanoToCubemap( const std::shared_ptr<Texture>& cubemapTexture,
         return;
     }
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::PanoToCubemap, commands::PanoToCubemap { capture->GetResourceId( cubemapTexture.get() ),
+                                                                capture->GetResourceId( panoTexture.get() ) } );
+    }
+
     if ( !m_PanoToCubemapPSO )
     {
         m_PanoToCubemapPSO = std::make_unique<PanoToCubemapPSO>( m_Device );
@@ -1125,6 +1379,16 @@ void CommandList::ClearTexture( const std::shared_ptr<Texture>& texture, const f
 {
     assert( texture );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        commands::ClearTexture clearTexture;
+        clearTexture.ResourceId = capture->GetResourceId( texture.get() );
+        memcpy( clearTexture.ClearColor, clearColor, sizeof( clearTexture.ClearColor ) );
+
+        capture->GetWriter().WriteCommand( CommandOp::ClearTexture, clearTexture );
+    }
+
     TransitionBarrier( texture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, true );
     m_d3d12CommandList->ClearRenderTargetView( texture->GetRenderTargetView(), clearColor, 0, nullptr );
 
@@ -1136,6 +1400,14 @@ void CommandList::ClearDepthStencilTexture( const std::shared_ptr<Texture>& text
 {
     assert( texture );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::ClearDepthStencilTexture,
+                                           commands::ClearDepthStencilTexture {
+                                               capture->GetResourceId( texture.get() ), clearFlags, depth, stencil } );
+    }
+
     TransitionBarrier( texture, D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, true );
     m_d3d12CommandList->ClearDepthStencilView( texture->GetDepthStencilView(), clearFlags, depth, stencil, 0, nullptr );
 
@@ -1152,24 +1424,172 @@ void CommandList::CopyTextureSubresource( const std::shared_ptr<Texture>& textur
 
     if ( destinationResource )
     {
-        // Resource must be in the copy-destination state.
-        TransitionBarrier( texture, D3D12_RESOURCE_STATE_COPY_DEST );
-        FlushResourceBarriers();
+        auto resourceDesc = destinationResource->GetDesc();
 
-        UINT64 requiredSize =
-            GetRequiredIntermediateSize( destinationResource.Get(), firstSubresource, numSubresources );
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            uint32_t resourceId = capture->GetResourceId( texture.get() );
 
-        // Create a temporary (intermediate) resource for uploading the subresources
-        ComPtr<ID3D12Resource> intermediateResource;
-        ThrowIfFailed( d3d12Device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES( D3D12_HEAP_TYPE_UPLOAD ), D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer( requiredSize ), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-            IID_PPV_ARGS( &intermediateResource ) ) );
+            auto& writer = capture->GetWriter();
+            writer.BeginCommand( CommandOp::CopyTextureSubresource );
+            writer.Write( commands::CopyTextureSubresource { resourceId, firstSubresource, numSubresources } );
+            for ( uint32_t i = 0; i < numSubresources; ++i )
+            {
+                // The slices of 3D textures are halved with every mip.
+                uint32_t mip   = ( firstSubresource + i ) % resourceDesc.MipLevels;
+                uint32_t depth = resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D
+                                     ? std::max( 1u, static_cast<uint32_t>( resourceDesc.DepthOrArraySize ) >> mip )
+                                     : 1u;
+
+                const auto& data     = subresourceData[i];
+                uint64_t    numBytes = static_cast<uint64_t>( data.SlicePitch ) * depth;
+
+                Hash64 dataHash;
+                dataHash.Add( data.pData, static_cast<size_t>( numBytes ) );
+
+                writer.Write( commands::SubresourceData { data.RowPitch, data.SlicePitch, numBytes, dataHash.Get() } );
+            }
+            writer.EndCommand();
+        }
+
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts( numSubresources );
+        std::vector<UINT>                               numRows( numSubresources );
+        std::vector<UINT64>                             rowSizesInBytes( numSubresources );
+        UINT64                                          requiredSize = 0;
+
+        d3d12Device->GetCopyableFootprints( &resourceDesc, firstSubresource, numSubresources, 0, layouts.data(),
+                                            numRows.data(), rowSizesInBytes.data(), &requiredSize );
+
+        auto stagingAllocation =
+            AllocateStagingMemory( static_cast<size_t>( requiredSize ), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT );
+
+        for ( uint32_t i = 0; i < numSubresources; ++i )
+        {
+            auto& layout = layouts[i];
 
-        UpdateSubresources( m_d3d12CommandList.Get(), destinationResource.Get(), intermediateResource.Get(), 0,
-                            firstSubresource, numSubresources, subresourceData );
+            D3D12_MEMCPY_DEST destData = { static_cast<uint8_t*>( stagingAllocation.CPU ) + layout.Offset,
+                                           layout.Footprint.RowPitch,
+                                           SIZE_T( layout.Footprint.RowPitch ) * SIZE_T( numRows[i] ) };
+            MemcpySubresource( &destData, &subresourceData[i], static_cast<SIZE_T>( rowSizesInBytes[i] ),
+                               numRows[i], layout.Footprint.Depth );
+
+            // Footprints are relative to the start of the staging allocation.
+            layout.Offset += stagingAllocation.Offset;
+
+            m_PendingTextureUploads.push_back(
+                { destinationResource.Get(), firstSubresource + i, 0, 0, 0, stagingAllocation.Resource, layout } );
+        }
+
+        m_PendingUploadResources.insert( destinationResource.Get() );
+        m_NumPendingUploadBytes += requiredSize;
+
+        TrackResource( destinationResource );
+    }
+}
+
+void CommandList::CopyTextureRegion( const std::shared_ptr<Texture>& texture, uint32_t subresource, uint32_t dstX,
+                                     uint32_t dstY, uint32_t dstZ, uint32_t width, uint32_t height, uint32_t depth,
+                                     const D3D12_SUBRESOURCE_DATA& subresourceData )
+{
+    assert( texture );
+
+    auto destinationResource = texture->GetD3D12Resource();
+
+    if ( destinationResource )
+    {
+        DXGI_FORMAT format = destinationResource->GetDesc().Format;
+
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            uint64_t numBytes = static_cast<uint64_t>( subresourceData.SlicePitch ) * depth;
+
+            Hash64 dataHash;
+            dataHash.Add( subresourceData.pData, static_cast<size_t>( numBytes ) );
+
+            commands::CopyTextureRegion copyTextureRegion;
+            copyTextureRegion.ResourceId  = capture->GetResourceId( texture.get() );
+            copyTextureRegion.Subresource = subresource;
+            copyTextureRegion.DstX        = dstX;
+            copyTextureRegion.DstY        = dstY;
+            copyTextureRegion.DstZ        = dstZ;
+            copyTextureRegion.Width       = width;
+            copyTextureRegion.Height      = height;
+            copyTextureRegion.Depth       = depth;
+            copyTextureRegion.Data        = { subresourceData.RowPitch, subresourceData.SlicePitch, numBytes,
+                                              dataHash.Get() };
+
+            capture->GetWriter().WriteCommand( CommandOp::CopyTextureRegion, copyTextureRegion );
+        }
+
+        // The footprint of a block-compressed format is a whole number of blocks, also at the
+        // edge of a subresource whose size is not a multiple of the block size.
+        if ( IsCompressed( format ) )
+        {
+            width  = Math::AlignUp( width, 4 );
+            height = Math::AlignUp( height, 4 );
+        }
+
+        size_t rowPitch, slicePitch;
+        ThrowIfFailed( ComputePitch( format, width, height, rowPitch, slicePitch ) );
+        UINT numRows = static_cast<UINT>( slicePitch / rowPitch );
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = {};
+        layout.Footprint.Format                   = format;
+        layout.Footprint.Width                    = width;
+        layout.Footprint.Height                   = height;
+        layout.Footprint.Depth                    = depth;
+        layout.Footprint.RowPitch =
+            static_cast<UINT>( Math::AlignUp( rowPitch, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT ) );
+
+        size_t requiredSize      = static_cast<size_t>( layout.Footprint.RowPitch ) * numRows * depth;
+        auto   stagingAllocation = AllocateStagingMemory( requiredSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT );
+
+        D3D12_MEMCPY_DEST destData = { stagingAllocation.CPU, layout.Footprint.RowPitch,
+                                       SIZE_T( layout.Footprint.RowPitch ) * SIZE_T( numRows ) };
+        MemcpySubresource( &destData, &subresourceData, rowPitch, numRows, depth );
+
+        layout.Offset = stagingAllocation.Offset;
+
+        m_PendingTextureUploads.push_back(
+            { destinationResource.Get(), subresource, dstX, dstY, dstZ, stagingAllocation.Resource, layout } );
+        m_PendingUploadResources.insert( destinationResource.Get() );
+        m_NumPendingUploadBytes += requiredSize;
+
+        TrackResource( destinationResource );
+    }
+}
+
+void CommandList::CopyBufferRegion( const std::shared_ptr<Resource>& buffer, size_t dstOffset, size_t numBytes,
+                                    const void* bufferData )
+{
+    assert( buffer );
+    assert( bufferData );
+
+    auto destinationResource = buffer->GetD3D12Resource();
+
+    if ( destinationResource && numBytes > 0 )
+    {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            Hash64 dataHash;
+            dataHash.Add( bufferData, numBytes );
+
+            capture->GetWriter().WriteCommand( CommandOp::CopyBufferRegion,
+                                               commands::CopyBufferRegion { capture->GetResourceId( buffer.get() ),
+                                                                            dstOffset, numBytes, dataHash.Get() } );
+        }
+
+        auto stagingAllocation = AllocateStagingMemory( numBytes, D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT );
+        memcpy( stagingAllocation.CPU, bufferData, numBytes );
+
+        m_PendingBufferUploads.push_back( { destinationResource.Get(), dstOffset, stagingAllocation.Resource,
+                                            stagingAllocation.Offset, numBytes } );
+        m_PendingUploadResources.insert( destinationResource.Get() );
+        m_NumPendingUploadBytes += numBytes;
 
-        TrackResource( intermediateResource );
         TrackResource( destinationResource );
     }
 }
@@ -1177,6 +1597,17 @@ void CommandList::CopyTextureSubresource( const std::shared_ptr<Texture>& textur
 void CommandList::SetGraphicsDynamicConstantBuffer( uint32_t rootParameterIndex, size_t sizeInBytes,
                                                     const void* bufferData )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        Hash64 dataHash;
+        dataHash.Add( bufferData, sizeInBytes );
+
+        capture->GetWriter().WriteCommand(
+            CommandOp::SetGraphicsDynamicConstantBuffer,
+            commands::SetDynamicBuffer { rootParameterIndex, 0, 1, sizeInBytes, dataHash.Get() } );
+    }
+
     // Constant buffers must be 256-byte aligned.
     auto heapAllococation = m_UploadBuffer->Allocate( sizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT );
     memcpy( heapAllococation.CPU, bufferData, sizeInBytes );
@@ -1186,17 +1617,57 @@ void CommandList::SetGraphicsDynamicConstantBuffer( uint32_t rootParameterIndex,
 
 void CommandList::SetGraphics32BitConstants( uint32_t rootParameterIndex, uint32_t numConstants, const void* constants )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        auto& writer = capture->GetWriter();
+        writer.BeginCommand( CommandOp::SetGraphics32BitConstants );
+        writer.Write( commands::Set32BitConstants { rootParameterIndex, numConstants } );
+        writer.WriteBytes( constants, numConstants * sizeof( uint32_t ) );
+        writer.EndCommand();
+    }
+
     m_d3d12CommandList->SetGraphicsRoot32BitConstants( rootParameterIndex, numConstants, constants, 0 );
 }
 
 void CommandList::SetCompute32BitConstants( uint32_t rootParameterIndex, uint32_t numConstants, const void* constants )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        auto& writer = capture->GetWriter();
+        writer.BeginCommand( CommandOp::SetCompute32BitConstants );
+        writer.Write( commands::Set32BitConstants { rootParameterIndex, numConstants } );
+        writer.WriteBytes( constants, numConstants * sizeof( uint32_t ) );
+        writer.EndCommand();
+    }
+
     m_d3d12CommandList->SetComputeRoot32BitConstants( rootParameterIndex, numConstants, constants, 0 );
 }
 
 void CommandList::SetVertexBuffers( uint32_t                                          startSlot,
                                     const std::vector<std::shared_ptr<VertexBuffer>>& vertexBuffers )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        std::vector<commands::VertexBufferBinding> bindings;
+        for ( const auto& vertexBuffer: vertexBuffers )
+        {
+            if ( vertexBuffer )
+            {
+                bindings.push_back( { capture->GetResourceId( vertexBuffer.get() ), 0, vertexBuffer->GetNumVertices(),
+                                      vertexBuffer->GetVertexStride() } );
+            }
+        }
+
+        auto& writer = capture->GetWriter();
+        writer.BeginCommand( CommandOp::SetVertexBuffers );
+        writer.Write( commands::SetVertexBuffers { startSlot, static_cast<uint32_t>( bindings.size() ) } );
+        writer.WriteBytes( bindings.data(), bindings.size() * sizeof( commands::VertexBufferBinding ) );
+        writer.EndCommand();
+    }
+
     std::vector<D3D12_VERTEX_BUFFER_VIEW> views;
     views.reserve( vertexBuffers.size() );
 
@@ -1224,6 +1695,17 @@ void CommandList::SetDynamicVertexBuffer( uint32_t slot, size_t numVertices, siz
 {
     size_t bufferSize = numVertices * vertexSize;
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        Hash64 dataHash;
+        dataHash.Add( vertexBufferData, bufferSize );
+
+        capture->GetWriter().WriteCommand(
+            CommandOp::SetDynamicVertexBuffer,
+            commands::SetDynamicVertexBuffer { slot, 0, numVertices, vertexSize, dataHash.Get() } );
+    }
+
     auto heapAllocation = m_UploadBuffer->Allocate( bufferSize, vertexSize );
     memcpy( heapAllocation.CPU, vertexBufferData, bufferSize );
 
@@ -1239,6 +1721,15 @@ void CommandList::SetIndexBuffer( const std::shared_ptr<IndexBuffer>& indexBuffe
 {
     if ( indexBuffer )
     {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            capture->GetWriter().WriteCommand(
+                CommandOp::SetIndexBuffer,
+                commands::SetIndexBuffer { capture->GetResourceId( indexBuffer.get() ), indexBuffer->GetIndexFormat(),
+                                           indexBuffer->GetNumIndices() } );
+        }
+
         TransitionBarrier( indexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER );
         TrackResource( indexBuffer );
         m_d3d12CommandList->IASetIndexBuffer( &( indexBuffer->GetIndexBufferView() ) );
@@ -1250,6 +1741,16 @@ void CommandList::SetDynamicIndexBuffer( size_t numIndices, DXGI_FORMAT indexFor
     size_t indexSizeInBytes = indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
     size_t bufferSize       = numIndices * indexSizeInBytes;
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        Hash64 dataHash;
+        dataHash.Add( indexBufferData, bufferSize );
+
+        capture->GetWriter().WriteCommand( CommandOp::SetDynamicIndexBuffer,
+                                           commands::SetDynamicIndexBuffer { indexFormat, 0, numIndices, dataHash.Get() } );
+    }
+
     auto heapAllocation = m_UploadBuffer->Allocate( bufferSize, indexSizeInBytes );
     memcpy( heapAllocation.CPU, indexBufferData, bufferSize );
 
@@ -1266,6 +1767,17 @@ void CommandList::SetGraphicsDynamicStructuredBuffer( uint32_t slot, size_t numE
 {
     size_t bufferSize = numElements * elementSize;
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        Hash64 dataHash;
+        dataHash.Add( bufferData, bufferSize );
+
+        capture->GetWriter().WriteCommand(
+            CommandOp::SetGraphicsDynamicStructuredBuffer,
+            commands::SetDynamicBuffer { slot, 0, numElements, elementSize, dataHash.Get() } );
+    }
+
     auto heapAllocation = m_UploadBuffer->Allocate( bufferSize, elementSize );
 
     memcpy( heapAllocation.CPU, bufferData, bufferSize );
@@ -1280,6 +1792,17 @@ void CommandList::SetViewport( const D3D12_VIEWPORT& viewport )
 void CommandList::SetViewports( const std::vector<D3D12_VIEWPORT>& viewports )
 {
     assert( viewports.size() < D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE );
+
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        auto& writer = capture->GetWriter();
+        writer.BeginCommand( CommandOp::SetViewports );
+        writer.Write( commands::SetViewports { static_cast<uint32_t>( viewports.size() ) } );
+        writer.WriteBytes( viewports.data(), viewports.size() * sizeof( D3D12_VIEWPORT ) );
+        writer.EndCommand();
+    }
+
     m_d3d12CommandList->RSSetViewports( static_cast<UINT>( viewports.size() ), viewports.data() );
 }
 
@@ -1291,6 +1814,17 @@ void CommandList::SetScissorRect( const D3D12_RECT& scissorRect )
 void CommandList::SetScissorRects( const std::vector<D3D12_RECT>& scissorRects )
 {
     assert( scissorRects.size() < D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE );
+
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        auto& writer = capture->GetWriter();
+        writer.BeginCommand( CommandOp::SetScissorRects );
+        writer.Write( commands::SetScissorRects { static_cast<uint32_t>( scissorRects.size() ) } );
+        writer.WriteBytes( scissorRects.data(), scissorRects.size() * sizeof( D3D12_RECT ) );
+        writer.EndCommand();
+    }
+
     m_d3d12CommandList->RSSetScissorRects( static_cast<UINT>( scissorRects.size() ), scissorRects.data() );
 }
 
@@ -1298,6 +1832,13 @@ void CommandList::SetPipelineState( const std::shared_ptr<PipelineStateObject>&
 {
     assert( pipelineState );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::SetPipelineState, commands::SetPipelineState { capture->GetPipelineStateId( pipelineState.get() ) } );
+    }
+
     auto d3d12PipelineStateObject = pipelineState->GetD3D12PipelineState().Get();
     if ( m_PipelineState != d3d12PipelineStateObject )
     {
@@ -1313,6 +1854,14 @@ void CommandList::SetGraphicsRootSignature( const std::shared_ptr<RootSignature>
 {
     assert( rootSignature );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::SetGraphicsRootSignature,
+            commands::SetRootSignature { capture->GetRootSignatureId( rootSignature.get() ) } );
+    }
+
     auto d3d12RootSignature = rootSignature->GetD3D12RootSignature().Get();
     if ( m_RootSignature != d3d12RootSignature )
     {
@@ -1333,6 +1882,14 @@ void CommandList::SetComputeRootSignature( const std::shared_ptr<RootSignature>&
 {
     assert( rootSignature );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::SetComputeRootSignature,
+            commands::SetRootSignature { capture->GetRootSignatureId( rootSignature.get() ) } );
+    }
+
     auto d3d12RootSignature = rootSignature->GetD3D12RootSignature().Get();
     if ( m_RootSignature != d3d12RootSignature )
     {
@@ -1354,6 +1911,15 @@ void CommandList::SetConstantBufferView( uint32_t rootParameterIndex, const std:
 {
     if ( buffer )
     {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            capture->GetWriter().WriteCommand( CommandOp::SetInlineConstantBufferView,
+                                               commands::SetInlineView { rootParameterIndex,
+                                                                         capture->GetResourceId( buffer.get() ),
+                                                                         stateAfter, 0, bufferOffset } );
+        }
+
         auto d3d12Resource = buffer->GetD3D12Resource();
         TransitionBarrier( d3d12Resource, stateAfter );
 
@@ -1369,6 +1935,15 @@ void CommandList::SetShaderResourceView( uint32_t rootParameterIndex, const std:
 {
     if ( buffer )
     {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            capture->GetWriter().WriteCommand( CommandOp::SetInlineShaderResourceView,
+                                               commands::SetInlineView { rootParameterIndex,
+                                                                         capture->GetResourceId( buffer.get() ),
+                                                                         stateAfter, 0, bufferOffset } );
+        }
+
         auto d3d12Resource = buffer->GetD3D12Resource();
         TransitionBarrier( d3d12Resource, stateAfter );
 
@@ -1384,6 +1959,15 @@ void CommandList::SetUnorderedAccessView( uint32_t rootParameterIndex, const std
 {
     if ( buffer )
     {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            capture->GetWriter().WriteCommand( CommandOp::SetInlineUnorderedAccessView,
+                                               commands::SetInlineView { rootParameterIndex,
+                                                                         capture->GetResourceId( buffer.get() ),
+                                                                         stateAfter, 0, bufferOffset } );
+        }
+
         auto d3d12Resource = buffer->GetD3D12Resource();
         TransitionBarrier( d3d12Resource, stateAfter );
 
@@ -1400,6 +1984,15 @@ void CommandList::SetShaderResourceView( uint32_t rootParameterIndex, uint32_t d
 {
     assert( srv );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::SetShaderResourceView,
+                                           commands::SetDescriptor { rootParameterIndex, descriptorOffset,
+                                                                     capture->GetViewId( srv.get() ), stateAfter,
+                                                                     firstSubresource, numSubresources, 0 } );
+    }
+
     auto resource = srv->GetResource();
     if ( resource )
     {
@@ -1428,6 +2021,16 @@ void CommandList::SetShaderResourceView( int32_t rootParameterIndex, uint32_t de
 {
     if ( texture )
     {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            capture->GetWriter().WriteCommand(
+                CommandOp::SetTextureShaderResourceView,
+                commands::SetDescriptor { static_cast<uint32_t>( rootParameterIndex ), descriptorOffset,
+                                          capture->GetResourceId( texture.get() ), stateAfter, firstSubresource,
+                                          numSubresources, 0 } );
+        }
+
         if ( numSubresources < D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES )
         {
             for ( uint32_t i = 0; i < numSubresources; ++i )
@@ -1447,6 +2050,18 @@ void CommandList::SetShaderResourceView( int32_t rootParameterIndex, uint32_t de
     }
 }
 
+void CommandList::SetBindlessDescriptorTable( uint32_t rootParameterIndex )
+{
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::SetBindlessDescriptorTable,
+                                           commands::SetBindlessDescriptorTable { rootParameterIndex } );
+    }
+
+    m_DynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageBindlessDescriptorTable( rootParameterIndex );
+}
+
 void CommandList::SetUnorderedAccessView( uint32_t rootParameterIndex, uint32_t descriptorOffset,
                                           const std::shared_ptr<UnorderedAccessView>& uav,
                                           D3D12_RESOURCE_STATES stateAfter, UINT firstSubresource,
@@ -1454,6 +2069,15 @@ void CommandList::SetUnorderedAccessView( uint32_t rootParameterIndex, uint32_t
 {
     assert( uav );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::SetUnorderedAccessView,
+                                           commands::SetDescriptor { rootParameterIndex, descriptorOffset,
+                                                                     capture->GetViewId( uav.get() ), stateAfter,
+                                                                     firstSubresource, numSubresources, 0 } );
+    }
+
     auto resource = uav->GetResource();
     if ( resource )
     {
@@ -1483,6 +2107,16 @@ void CommandList::SetUnorderedAccessView( uint32_t rootParameterIndex, uint32_t
 {
     if ( texture )
     {
+        CaptureScope capture( *this );
+        if ( capture )
+        {
+            capture->GetWriter().WriteCommand( CommandOp::SetTextureUnorderedAccessView,
+                                               commands::SetDescriptor { rootParameterIndex, descriptorOffset,
+                                                                         capture->GetResourceId( texture.get() ),
+                                                                         stateAfter, firstSubresource, numSubresources,
+                                                                         mip } );
+        }
+
         if ( numSubresources < D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES )
         {
             for ( uint32_t i = 0; i < numSubresources; ++i )
@@ -1508,6 +2142,15 @@ void CommandList::SetConstantBufferView( uint32_t rootParameterIndex, uint32_t d
 {
     assert( cbv );
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::SetConstantBufferView,
+                                           commands::SetDescriptor { rootParameterIndex, descriptorOffset,
+                                                                     capture->GetViewId( cbv.get() ), stateAfter, 0,
+                                                                     D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, 0 } );
+    }
+
     auto constantBuffer = cbv->GetConstantBuffer();
     if ( constantBuffer )
     {
@@ -1526,6 +2169,18 @@ void CommandList::SetRenderTarget( const RenderTarget& renderTarget )
 
     const auto& textures = renderTarget.GetTextures();
 
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        commands::SetRenderTarget setRenderTarget;
+        for ( int i = 0; i < AttachmentPoint::NumAttachmentPoints; ++i )
+        {
+            setRenderTarget.ResourceIds[i] = capture->GetResourceId( textures[i].get() );
+        }
+
+        capture->GetWriter().WriteCommand( CommandOp::SetRenderTarget, setRenderTarget );
+    }
+
     // Bind color targets (max of 8 render targets can be bound to the rendering pipeline.
     for ( int i = 0; i < 8; ++i )
     {
@@ -1559,6 +2214,15 @@ void CommandList::SetRenderTarget( const RenderTarget& renderTarget )
 
 void CommandList::Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::Draw,
+                                           commands::Draw { vertexCount, instanceCount, startVertex, startInstance } );
+    }
+
+    // Resources that are used by the draw or dispatch may have pending uploads.
+    FlushPendingUploads();
     FlushResourceBarriers();
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
@@ -1572,6 +2236,16 @@ void CommandList::Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t s
 void CommandList::DrawIndexed( uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex,
                                uint32_t startInstance )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand(
+            CommandOp::DrawIndexed,
+            commands::DrawIndexed { indexCount, instanceCount, startIndex, baseVertex, startInstance } );
+    }
+
+    // Resources that are used by the draw or dispatch may have pending uploads.
+    FlushPendingUploads();
     FlushResourceBarriers();
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
@@ -1584,6 +2258,15 @@ void CommandList::DrawIndexed( uint32_t indexCount, uint32_t instanceCount, uint
 
 void CommandList::Dispatch( uint32_t numGroupsX, uint32_t numGroupsY, uint32_t numGroupsZ )
 {
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        capture->GetWriter().WriteCommand( CommandOp::Dispatch,
+                                           commands::Dispatch { numGroupsX, numGroupsY, numGroupsZ } );
+    }
+
+    // Resources that are used by the draw or dispatch may have pending uploads.
+    FlushPendingUploads();
     FlushResourceBarriers();
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
@@ -1594,8 +2277,70 @@ void CommandList::Dispatch( uint32_t numGroupsX, uint32_t numGroupsY, uint32_t n
     m_d3d12CommandList->Dispatch( numGroupsX, numGroupsY, numGroupsZ );
 }
 
+void CommandList::ExecuteIndirect( const std::shared_ptr<CommandSignature>& commandSignature, uint32_t maxCommandCount,
+                                   const std::shared_ptr<Buffer>& argumentBuffer, uint64_t argumentBufferOffset,
+                                   const std::shared_ptr<Buffer>& countBuffer, uint64_t countBufferOffset )
+{
+    assert( commandSignature && argumentBuffer );
+
+    CaptureScope capture( *this );
+    if ( capture )
+    {
+        commands::ExecuteIndirect executeIndirect;
+        executeIndirect.CommandSignatureId   = capture->GetCommandSignatureId( commandSignature.get() );
+        executeIndirect.MaxCommandCount      = maxCommandCount;
+        executeIndirect.ArgumentBufferId     = capture->GetResourceId( argumentBuffer.get() );
+        executeIndirect.CountBufferId        = capture->GetResourceId( countBuffer.get() );
+        executeIndirect.ArgumentBufferOffset = argumentBufferOffset;
+        executeIndirect.CountBufferOffset    = countBufferOffset;
+
+        capture->GetWriter().WriteCommand( CommandOp::ExecuteIndirect, executeIndirect );
+    }
+
+    if ( maxCommandCount == 0 )
+    {
+        return;
+    }
+
+    TransitionBarrier( argumentBuffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT );
+    TrackResource( argumentBuffer );
+
+    if ( countBuffer )
+    {
+        TransitionBarrier( countBuffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT );
+        TrackResource( countBuffer );
+    }
+
+    // Resources that are used by the commands may have pending uploads.
+    FlushPendingUploads();
+    FlushResourceBarriers();
+
+    for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
+    {
+        if ( commandSignature->IsDispatch() )
+        {
+            m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDispatch( *this );
+        }
+        else
+        {
+            m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDraw( *this );
+        }
+    }
+
+    auto d3d12CommandSignature = commandSignature->GetD3D12CommandSignature();
+    TrackResource( d3d12CommandSignature );
+
+    m_d3d12CommandList->ExecuteIndirect( d3d12CommandSignature.Get(), maxCommandCount,
+                                         argumentBuffer->GetD3D12Resource().Get(), argumentBufferOffset,
+                                         countBuffer ? countBuffer->GetD3D12Resource().Get() : nullptr,
+                                         countBufferOffset );
+}
+
 bool CommandList::Close( const std::shared_ptr<CommandList>& pendingCommandList )
 {
+    // Record any uploads that are still pending.
+    FlushPendingUploads();
+
     // Flush any remaining barriers.
     FlushResourceBarriers();
 
@@ -1623,6 +2368,20 @@ void CommandList::Reset()
     m_ResourceStateTracker->Reset();
     m_UploadBuffer->Reset();
 
+    // The command list is finished executing so the staging chunks can be recycled.
+    auto& stagingAllocator = m_Device.GetStagingAllocator();
+    if ( m_NumStagedBytes > 0 )
+    {
+        stagingAllocator.RecordCompletion( m_NumStagedBytes,
+                                           std::chrono::high_resolution_clock::now() - m_FirstUploadBatchTime );
+        m_NumStagedBytes = 0;
+    }
+    for ( auto& chunk: m_StagingChunks )
+    {
+        stagingAllocator.RetireChunk( chunk );
+    }
+    m_StagingChunks.clear();
+
     ReleaseTrackedObjects();
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
@@ -1634,23 +2393,106 @@ void CommandList::Reset()
     m_RootSignature      = nullptr;
     m_PipelineState      = nullptr;
     m_ComputeCommandList = nullptr;
+    m_Recorder           = nullptr;
+    m_CaptureDepth       = 0;
+}
+
+StagingAllocator::Allocation CommandList::AllocateStagingMemory( size_t sizeInBytes, size_t alignment )
+{
+    auto& stagingAllocator = m_Device.GetStagingAllocator();
+
+    // Uploads that are larger than a chunk get a dedicated chunk. The current
+    // chunk remains the one at the back of the list so it can still be used
+    // for smaller uploads.
+    if ( sizeInBytes > stagingAllocator.GetChunkSize() )
+    {
+        auto chunk = stagingAllocator.RequestChunk( sizeInBytes );
+        m_StagingChunks.insert( m_StagingChunks.begin(), chunk );
+
+        return chunk->Allocate( sizeInBytes, alignment );
+    }
+
+    if ( m_StagingChunks.empty() || !m_StagingChunks.back()->HasSpace( sizeInBytes, alignment ) )
+    {
+        m_StagingChunks.push_back( stagingAllocator.RequestChunk( sizeInBytes ) );
+    }
+
+    return m_StagingChunks.back()->Allocate( sizeInBytes, alignment );
+}
+
+void CommandList::FlushPendingUploads( ID3D12Resource* resource )
+{
+    if ( resource && m_PendingUploadResources.find( resource ) != m_PendingUploadResources.end() )
+    {
+        FlushPendingUploads();
+    }
+}
+
+void CommandList::FlushPendingUploads()
+{
+    if ( m_PendingBufferUploads.empty() && m_PendingTextureUploads.empty() )
+        return;
+
+    // Transition all of the destination resources with a single flush of barriers.
+    // Only the texture subresources that are written are transitioned so that
+    // subresources that have already been uploaded (for example, mips that have
+    // been streamed in) can still be used on another queue.
+    for ( const auto& upload: m_PendingBufferUploads )
+    {
+        m_ResourceStateTracker->TransitionResource( upload.Destination, D3D12_RESOURCE_STATE_COPY_DEST );
+    }
+    for ( const auto& upload: m_PendingTextureUploads )
+    {
+        m_ResourceStateTracker->TransitionResource( upload.Destination, D3D12_RESOURCE_STATE_COPY_DEST,
+                                                    upload.Subresource );
+    }
+    m_ResourceStateTracker->FlushResourceBarriers( shared_from_this() );
+
+    for ( const auto& upload: m_PendingBufferUploads )
+    {
+        m_d3d12CommandList->CopyBufferRegion( upload.Destination, upload.DestinationOffset, upload.Source,
+                                              upload.SourceOffset, upload.NumBytes );
+    }
+
+    for ( const auto& upload: m_PendingTextureUploads )
+    {
+        CD3DX12_TEXTURE_COPY_LOCATION dst( upload.Destination, upload.Subresource );
+        CD3DX12_TEXTURE_COPY_LOCATION src( upload.Source, upload.Footprint );
+
+        m_d3d12CommandList->CopyTextureRegion( &dst, upload.DstX, upload.DstY, upload.DstZ, &src, nullptr );
+    }
+
+    if ( m_NumStagedBytes == 0 )
+    {
+        m_FirstUploadBatchTime = std::chrono::high_resolution_clock::now();
+    }
+    m_NumStagedBytes += m_NumPendingUploadBytes;
+
+    m_Device.GetStagingAllocator().RecordBatch( m_PendingBufferUploads.size() + m_PendingTextureUploads.size(),
+                                                m_NumPendingUploadBytes );
+
+    m_PendingBufferUploads.clear();
+    m_PendingTextureUploads.clear();
+    m_PendingUploadResources.clear();
+    m_NumPendingUploadBytes = 0;
 }
 
-void CommandList::TrackResource( Microsoft::WRL::ComPtr<ID3D12Object> object )
+void CommandList::TrackResource( ID3D12Object* object )
 {
-    m_TrackedObjects.push_back( object );
+    m_TrackedObjects.Insert( object );
 }
 
 void CommandList::TrackResource( const std::shared_ptr<Resource>& res )
 {
     assert( res );
 
-    TrackResource( res->GetD3D12Resource() );
+    // Avoid the reference count round trip of Resource::GetD3D12Resource.
+    m_TrackedObjects.Insert( res->m_d3d12Resource.Get() );
 }
 
 void CommandList::ReleaseTrackedObjects()
 {
-    m_TrackedObjects.clear();
+    m_TrackedObjects.Clear();
 }
 
 void CommandList::SetDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE heapType, ID3D12DescriptorHeap* heap )
@@ -3,6 +3,7 @@
 #include <dx12lib/CommandQueue.h>
 
 #include <dx12lib/CommandList.h>
+#include <dx12lib/CommandRecorder.h>
 #include <dx12lib/Device.h>
 #include <dx12lib/ResourceStateTracker.h>
 
@@ -132,6 +133,9 @@ std::shared_ptr<CommandList> CommandQueue::GetCommandList()
         commandList = std::make_shared<MakeCommandList>( m_Device, m_CommandListType );
     }
 
+    // Record the commands of the command list if a frame is being captured.
+    commandList->m_Recorder = m_Device.GetCommandRecorder().CreateCommandListRecorder();
+
     return commandList;
 }
 
@@ -159,8 +163,18 @@ uint64_t CommandQueue::ExecuteCommandLists( const std::vector<std::shared_ptr<Co
     d3d12CommandLists.reserve( commandLists.size() *
                                2 );  // 2x since each command list will have a pending command list.
 
+    auto& commandRecorder = m_Device.GetCommandRecorder();
+
     for ( auto commandList: commandLists )
     {
+        // The commands are added to the capture before the command list is
+        // closed (closing the command list flushes internal barriers and
+        // uploads that are not recorded).
+        if ( commandList->m_Recorder )
+        {
+            commandRecorder.Submit( m_CommandListType, *commandList->m_Recorder );
+        }
+
         auto pendingCommandList = GetCommandList();
         bool hasPendingBarriers = commandList->Close( pendingCommandList );
         pendingCommandList->Close();
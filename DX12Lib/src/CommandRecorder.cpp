@@ -0,0 +1,505 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/CommandRecorder.h>
+
+#include <dx12lib/CommandSignature.h>
+#include <dx12lib/ConstantBuffer.h>
+#include <dx12lib/ConstantBufferView.h>
+#include <dx12lib/Helpers.h>
+#include <dx12lib/PipelineStateCache.h>
+#include <dx12lib/PipelineStateObject.h>
+#include <dx12lib/Resource.h>
+#include <dx12lib/RootSignature.h>
+#include <dx12lib/ShaderResourceView.h>
+#include <dx12lib/UnorderedAccessView.h>
+
+#include <fstream>
+
+using namespace dx12lib;
+
+// The name of a D3D12 object (set with ID3D12Object::SetName).
+static std::string GetObjectName( ID3D12Object* object )
+{
+    UINT size = 0;
+    if ( FAILED( object->GetPrivateData( WKPDID_D3DDebugObjectNameW, &size, nullptr ) ) || size == 0 )
+    {
+        return {};
+    }
+
+    std::wstring name( size / sizeof( wchar_t ), L'\0' );
+    object->GetPrivateData( WKPDID_D3DDebugObjectNameW, &size, name.data() );
+    name.resize( wcsnlen( name.c_str(), name.size() ) );
+
+    return ConvertString( name );
+}
+
+CommandListRecorder::CommandListRecorder( CommandRecorder& recorder, uint64_t generation )
+: m_Recorder( recorder )
+, m_Generation( generation )
+{}
+
+bool CommandListRecorder::FindObject( const void* object, uint64_t hash, uint32_t& id )
+{
+    auto iter = m_ObjectIds.find( object );
+    if ( iter != m_ObjectIds.end() )
+    {
+        id = iter->second;
+        return true;
+    }
+
+    id                  = m_Recorder.GetObjectId( object, hash );
+    m_ObjectIds[object] = id;
+
+    return false;
+}
+
+uint32_t CommandListRecorder::GetResourceId( ID3D12Resource* resource, const Resource* wrapper )
+{
+    if ( !resource )
+    {
+        return 0;
+    }
+
+    auto   desc = resource->GetDesc();
+    Hash64 hash;
+    hash.Add( desc );
+
+    uint32_t id;
+    if ( FindObject( resource, hash.Get(), id ) )
+    {
+        return id;
+    }
+
+    commands::DefineResource defineResource = {};
+    defineResource.Id                       = id;
+    defineResource.HeapType                 = D3D12_HEAP_TYPE_DEFAULT;
+    defineResource.Desc                     = desc;
+
+    // Reserved resources don't have heap properties.
+    D3D12_HEAP_PROPERTIES heapProperties;
+    if ( SUCCEEDED( resource->GetHeapProperties( &heapProperties, nullptr ) ) )
+    {
+        defineResource.HeapType = heapProperties.Type;
+    }
+
+    const D3D12_CLEAR_VALUE* clearValue = wrapper ? wrapper->GetD3D12ClearValue() : nullptr;
+    if ( clearValue )
+    {
+        defineResource.HasClearValue = 1;
+        defineResource.ClearValue    = *clearValue;
+    }
+
+    m_Writer.BeginCommand( CommandOp::DefineResource );
+    m_Writer.Write( defineResource );
+    m_Writer.WriteString( GetObjectName( resource ) );
+    m_Writer.EndCommand();
+
+    return id;
+}
+
+uint32_t CommandListRecorder::GetResourceId( const Resource* resource )
+{
+    return resource ? GetResourceId( resource->GetD3D12Resource().Get(), resource ) : 0;
+}
+
+uint32_t CommandListRecorder::GetRootSignatureId( const RootSignature* rootSignature )
+{
+    if ( !rootSignature )
+    {
+        return 0;
+    }
+
+    const auto& rootSignatureDesc = rootSignature->GetRootSignatureDesc();
+
+    uint32_t id;
+    if ( FindObject( rootSignature->GetD3D12RootSignature().Get(), HashRootSignatureDesc( rootSignatureDesc ), id ) )
+    {
+        return id;
+    }
+
+    commands::DefineRootSignature defineRootSignature;
+    defineRootSignature.Id                = id;
+    defineRootSignature.NumParameters     = rootSignatureDesc.NumParameters;
+    defineRootSignature.NumStaticSamplers = rootSignatureDesc.NumStaticSamplers;
+    defineRootSignature.Flags             = rootSignatureDesc.Flags;
+
+    m_Writer.BeginCommand( CommandOp::DefineRootSignature );
+    m_Writer.Write( defineRootSignature );
+    for ( UINT i = 0; i < rootSignatureDesc.NumParameters; ++i )
+    {
+        const D3D12_ROOT_PARAMETER1& rootParameter = rootSignatureDesc.pParameters[i];
+        m_Writer.Write( rootParameter );
+
+        if ( rootParameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE )
+        {
+            m_Writer.WriteBytes( rootParameter.DescriptorTable.pDescriptorRanges,
+                                 sizeof( D3D12_DESCRIPTOR_RANGE1 ) * rootParameter.DescriptorTable.NumDescriptorRanges );
+        }
+    }
+    m_Writer.WriteBytes( rootSignatureDesc.pStaticSamplers,
+                         sizeof( D3D12_STATIC_SAMPLER_DESC ) * rootSignatureDesc.NumStaticSamplers );
+    m_Writer.EndCommand();
+
+    return id;
+}
+
+uint32_t CommandListRecorder::GetRootSignatureId( ID3D12RootSignature* rootSignature )
+{
+    if ( !rootSignature )
+    {
+        return 0;
+    }
+
+    auto iter = m_ObjectIds.find( rootSignature );
+    if ( iter != m_ObjectIds.end() )
+    {
+        return iter->second;
+    }
+
+    auto registeredRootSignature = m_Recorder.FindRootSignature( rootSignature );
+    return GetRootSignatureId( registeredRootSignature.get() );
+}
+
+uint32_t CommandListRecorder::GetPipelineStateId( const PipelineStateObject* pipelineState )
+{
+    if ( !pipelineState )
+    {
+        return 0;
+    }
+
+    auto pipelineStateDesc = pipelineState->GetPipelineStateDesc();
+
+    uint32_t id;
+    if ( FindObject( pipelineState->GetD3D12PipelineState().Get(), pipelineStateDesc ? pipelineStateDesc->GetHash() : 0,
+                     id ) )
+    {
+        return id;
+    }
+
+    // The root signature that is referenced by the stream is defined while
+    // the stream is serialized so the stream is serialized before the
+    // definition of the pipeline state is started.
+    CommandStreamWriter streamWriter;
+    if ( pipelineStateDesc )
+    {
+        pipelineStateDesc->Serialize( streamWriter, [this]( ID3D12RootSignature* rootSignature ) {
+            return GetRootSignatureId( rootSignature );
+        } );
+    }
+
+    m_Writer.BeginCommand( CommandOp::DefinePipelineState );
+    m_Writer.Write( commands::DefinePipelineState { id, pipelineStateDesc ? 1u : 0u } );
+    m_Writer.WriteBytes( streamWriter.GetData().data(), streamWriter.GetSize() );
+    m_Writer.EndCommand();
+
+    return id;
+}
+
+uint32_t CommandListRecorder::GetCommandSignatureId( const CommandSignature* commandSignature )
+{
+    if ( !commandSignature )
+    {
+        return 0;
+    }
+
+    const auto& argumentDescs = commandSignature->GetArgumentDescs();
+
+    Hash64 hash;
+    hash.Add( commandSignature->GetByteStride() );
+    hash.Add( argumentDescs.data(), sizeof( D3D12_INDIRECT_ARGUMENT_DESC ) * argumentDescs.size() );
+
+    uint32_t id;
+    if ( FindObject( commandSignature->GetD3D12CommandSignature().Get(), hash.Get(), id ) )
+    {
+        return id;
+    }
+
+    commands::DefineCommandSignature defineCommandSignature;
+    defineCommandSignature.Id               = id;
+    defineCommandSignature.RootSignatureId  = GetRootSignatureId( commandSignature->GetRootSignature().get() );
+    defineCommandSignature.ByteStride       = commandSignature->GetByteStride();
+    defineCommandSignature.NumArgumentDescs = static_cast<uint32_t>( argumentDescs.size() );
+    defineCommandSignature.NodeMask         = commandSignature->GetNodeMask();
+
+    m_Writer.BeginCommand( CommandOp::DefineCommandSignature );
+    m_Writer.Write( defineCommandSignature );
+    m_Writer.WriteBytes( argumentDescs.data(), sizeof( D3D12_INDIRECT_ARGUMENT_DESC ) * argumentDescs.size() );
+    m_Writer.EndCommand();
+
+    return id;
+}
+
+uint32_t CommandListRecorder::GetViewId( const ShaderResourceView* srv )
+{
+    if ( !srv )
+    {
+        return 0;
+    }
+
+    auto resource = srv->GetResource();
+    auto desc     = srv->GetShaderResourceViewDesc();
+
+    Hash64 hash;
+    hash.Add( resource.get() );
+    if ( desc )
+    {
+        hash.Add( *desc );
+    }
+
+    uint32_t id;
+    if ( FindObject( srv, hash.Get(), id ) )
+    {
+        return id;
+    }
+
+    commands::DefineShaderResourceView defineShaderResourceView = {};
+    defineShaderResourceView.Id                                 = id;
+    defineShaderResourceView.ResourceId                         = GetResourceId( resource.get() );
+    if ( desc )
+    {
+        defineShaderResourceView.HasDesc = 1;
+        defineShaderResourceView.Desc    = *desc;
+    }
+
+    m_Writer.WriteCommand( CommandOp::DefineShaderResourceView, defineShaderResourceView );
+
+    return id;
+}
+
+uint32_t CommandListRecorder::GetViewId( const UnorderedAccessView* uav )
+{
+    if ( !uav )
+    {
+        return 0;
+    }
+
+    auto resource        = uav->GetResource();
+    auto counterResource = uav->GetCounterResource();
+    auto desc            = uav->GetUnorderedAccessViewDesc();
+
+    Hash64 hash;
+    hash.Add( resource.get() );
+    hash.Add( counterResource.get() );
+    if ( desc )
+    {
+        hash.Add( *desc );
+    }
+
+    uint32_t id;
+    if ( FindObject( uav, hash.Get(), id ) )
+    {
+        return id;
+    }
+
+    commands::DefineUnorderedAccessView defineUnorderedAccessView = {};
+    defineUnorderedAccessView.Id                                  = id;
+    defineUnorderedAccessView.ResourceId                          = GetResourceId( resource.get() );
+    defineUnorderedAccessView.CounterResourceId                   = GetResourceId( counterResource.get() );
+    if ( desc )
+    {
+        defineUnorderedAccessView.HasDesc = 1;
+        defineUnorderedAccessView.Desc    = *desc;
+    }
+
+    m_Writer.WriteCommand( CommandOp::DefineUnorderedAccessView, defineUnorderedAccessView );
+
+    return id;
+}
+
+uint32_t CommandListRecorder::GetViewId( const ConstantBufferView* cbv )
+{
+    if ( !cbv )
+    {
+        return 0;
+    }
+
+    auto constantBuffer = cbv->GetConstantBuffer();
+
+    Hash64 hash;
+    hash.Add( constantBuffer.get() );
+    hash.Add( cbv->GetOffset() );
+
+    uint32_t id;
+    if ( FindObject( cbv, hash.Get(), id ) )
+    {
+        return id;
+    }
+
+    commands::DefineConstantBufferView defineConstantBufferView;
+    defineConstantBufferView.Id         = id;
+    defineConstantBufferView.ResourceId = GetResourceId( constantBuffer.get() );
+    defineConstantBufferView.Offset     = cbv->GetOffset();
+
+    m_Writer.WriteCommand( CommandOp::DefineConstantBufferView, defineConstantBufferView );
+
+    return id;
+}
+
+CommandRecorder::CommandRecorder()
+: m_State( State::Idle )
+, m_bCapturing( false )
+, m_Generation( 0 )
+, m_NumFrames( 0 )
+, m_NumCapturedFrames( 0 )
+, m_NextObjectId( 1 )
+{}
+
+CommandRecorder::~CommandRecorder() {}
+
+void CommandRecorder::BeginCapture( const std::wstring& fileName, uint32_t numFrames )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    if ( m_State != State::Idle )
+    {
+        throw std::exception( "A capture is already in progress." );
+    }
+
+    m_State     = State::Pending;
+    m_FileName  = fileName;
+    m_NumFrames = std::max( numFrames, 1u );
+}
+
+void CommandRecorder::EndCapture()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    bool isCapturing = m_State == State::Capturing;
+
+    m_State      = State::Idle;
+    m_bCapturing = false;
+
+    if ( isCapturing )
+    {
+        WriteCapture();
+    }
+}
+
+bool CommandRecorder::IsCapturing() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_State != State::Idle;
+}
+
+void CommandRecorder::EndFrame()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    switch ( m_State )
+    {
+    case State::Pending:
+        m_State = State::Capturing;
+        ++m_Generation;
+
+        m_Writer.Clear();
+        m_ObjectIds.clear();
+        m_NextObjectId      = 1;
+        m_NumCapturedFrames = 0;
+        m_bCapturing        = true;
+        break;
+    case State::Capturing:
+        m_Writer.BeginCommand( CommandOp::EndFrame );
+        m_Writer.EndCommand();
+
+        if ( ++m_NumCapturedFrames == m_NumFrames )
+        {
+            m_State      = State::Idle;
+            m_bCapturing = false;
+
+            WriteCapture();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+std::unique_ptr<CommandListRecorder> CommandRecorder::CreateCommandListRecorder()
+{
+    if ( !m_bCapturing )
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_State == State::Capturing ? std::make_unique<CommandListRecorder>( *this, m_Generation ) : nullptr;
+}
+
+void CommandRecorder::Submit( D3D12_COMMAND_LIST_TYPE type, const CommandListRecorder& commandListRecorder )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    if ( m_State != State::Capturing || commandListRecorder.GetGeneration() != m_Generation )
+    {
+        return;
+    }
+
+    const auto& commandListWriter = commandListRecorder.GetWriter();
+
+    m_Writer.BeginCommand( CommandOp::ExecuteCommandList );
+    m_Writer.Write( type );
+    m_Writer.WriteBytes( commandListWriter.GetData().data(), commandListWriter.GetSize() );
+    m_Writer.EndCommand();
+}
+
+uint32_t CommandRecorder::GetObjectId( const void* object, uint64_t hash )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    auto& id = m_ObjectIds[{ object, hash }];
+    if ( id == 0 )
+    {
+        id = m_NextObjectId++;
+    }
+
+    return id;
+}
+
+void CommandRecorder::RegisterRootSignature( const std::shared_ptr<RootSignature>& rootSignature )
+{
+    std::lock_guard<std::mutex> lock( m_RootSignaturesMutex );
+    m_RootSignatures[rootSignature->GetD3D12RootSignature().Get()] = rootSignature;
+}
+
+std::shared_ptr<RootSignature> CommandRecorder::FindRootSignature( ID3D12RootSignature* rootSignature )
+{
+    std::lock_guard<std::mutex> lock( m_RootSignaturesMutex );
+
+    auto iter = m_RootSignatures.find( rootSignature );
+    if ( iter == m_RootSignatures.end() )
+    {
+        return nullptr;
+    }
+
+    // The address of a root signature that was destroyed can be reused.
+    auto registeredRootSignature = iter->second.lock();
+    if ( !registeredRootSignature || registeredRootSignature->GetD3D12RootSignature().Get() != rootSignature )
+    {
+        m_RootSignatures.erase( iter );
+        return nullptr;
+    }
+
+    return registeredRootSignature;
+}
+
+void CommandRecorder::WriteCapture()
+{
+    CommandStreamHeader header;
+    header.Magic     = CommandStreamHeader::MagicValue;
+    header.Version   = CommandStreamHeader::VersionValue;
+    header.NumFrames = m_NumCapturedFrames;
+    header.Reserved  = 0;
+
+    std::ofstream file( fs::path( m_FileName ), std::ios::binary );
+    if ( !file )
+    {
+        m_Writer.Clear();
+        throw std::exception( "Failed to open the capture file." );
+    }
+
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    file.write( reinterpret_cast<const char*>( m_Writer.GetData().data() ), m_Writer.GetSize() );
+
+    m_Writer.Clear();
+    m_ObjectIds.clear();
+}
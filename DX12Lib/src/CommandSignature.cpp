@@ -0,0 +1,40 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/CommandSignature.h>
+
+#include <dx12lib/Device.h>
+#include <dx12lib/RootSignature.h>
+
+using namespace dx12lib;
+
+CommandSignature::CommandSignature( Device& device, const D3D12_COMMAND_SIGNATURE_DESC& commandSignatureDesc,
+                                    std::shared_ptr<RootSignature> rootSignature )
+: m_Device( device )
+, m_RootSignature( rootSignature )
+, m_ByteStride( commandSignatureDesc.ByteStride )
+, m_IsDispatch( false )
+, m_ArgumentDescs( commandSignatureDesc.pArgumentDescs,
+                   commandSignatureDesc.pArgumentDescs + commandSignatureDesc.NumArgumentDescs )
+, m_NodeMask( commandSignatureDesc.NodeMask )
+{
+    for ( UINT i = 0; i < commandSignatureDesc.NumArgumentDescs; ++i )
+    {
+        if ( commandSignatureDesc.pArgumentDescs[i].Type == D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH )
+        {
+            m_IsDispatch = true;
+        }
+    }
+
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    ComPtr<ID3D12RootSignature> d3d12RootSignature;
+    if ( m_RootSignature )
+    {
+        d3d12RootSignature = m_RootSignature->GetD3D12RootSignature();
+    }
+
+    ThrowIfFailed( d3d12Device->CreateCommandSignature( &commandSignatureDesc, d3d12RootSignature.Get(),
+                                                        IID_PPV_ARGS( &m_d3d12CommandSignature ) ) );
+}
+
+CommandSignature::~CommandSignature() {}
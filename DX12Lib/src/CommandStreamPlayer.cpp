@@ -0,0 +1,1013 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/CommandStreamPlayer.h>
+
+#include <dx12lib/ByteAddressBuffer.h>
+#include <dx12lib/CommandList.h>
+#include <dx12lib/CommandQueue.h>
+#include <dx12lib/CommandSignature.h>
+#include <dx12lib/ConstantBuffer.h>
+#include <dx12lib/ConstantBufferView.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/Helpers.h>
+#include <dx12lib/IndexBuffer.h>
+#include <dx12lib/PipelineStateCache.h>
+#include <dx12lib/PipelineStateObject.h>
+#include <dx12lib/RenderTarget.h>
+#include <dx12lib/ResourceStateTracker.h>
+#include <dx12lib/RootSignature.h>
+#include <dx12lib/ShaderResourceView.h>
+#include <dx12lib/Texture.h>
+#include <dx12lib/UnorderedAccessView.h>
+#include <dx12lib/VertexBuffer.h>
+
+#include <fstream>
+
+using namespace dx12lib;
+
+// The queue types in the order of the fence values of a frame.
+static const D3D12_COMMAND_LIST_TYPE QueueTypes[] = { D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_TYPE_COMPUTE,
+                                                      D3D12_COMMAND_LIST_TYPE_COPY };
+
+static size_t GetQueueIndex( D3D12_COMMAND_LIST_TYPE type )
+{
+    switch ( type )
+    {
+    case D3D12_COMMAND_LIST_TYPE_COMPUTE:
+        return 1;
+    case D3D12_COMMAND_LIST_TYPE_COPY:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+CommandStreamPlayer::CommandStreamPlayer( Device& device )
+: m_Device( device )
+{}
+
+CommandStreamPlayer::~CommandStreamPlayer()
+{
+    // The objects of the capture may still be referenced by frames in flight.
+    m_Device.Flush();
+}
+
+void CommandStreamPlayer::Load( const std::wstring& fileName )
+{
+    Flush();
+
+    m_Frames.clear();
+    m_Resources.clear();
+    m_RootSignatures.clear();
+    m_PipelineStates.clear();
+    m_CommandSignatures.clear();
+    m_ShaderResourceViews.clear();
+    m_UnorderedAccessViews.clear();
+    m_ConstantBufferViews.clear();
+
+    std::ifstream file( fs::path( fileName ), std::ios::binary | std::ios::ate );
+    if ( !file )
+    {
+        throw std::exception( "Failed to open the capture file." );
+    }
+
+    m_Data.resize( static_cast<size_t>( file.tellg() ) );
+    file.seekg( 0 );
+    file.read( reinterpret_cast<char*>( m_Data.data() ), m_Data.size() );
+
+    CommandStreamReader reader( m_Data.data(), m_Data.size() );
+
+    auto header = reader.Read<CommandStreamHeader>();
+    if ( header.Magic != CommandStreamHeader::MagicValue || header.Version != CommandStreamHeader::VersionValue )
+    {
+        throw std::exception( "Invalid capture file." );
+    }
+
+    std::vector<CommandListStream> frame;
+    while ( !reader.IsEnd() )
+    {
+        CommandOp op;
+        auto      command = reader.ReadCommand( op );
+
+        switch ( op )
+        {
+        case CommandOp::ExecuteCommandList:
+        {
+            CommandListStream commandListStream;
+            commandListStream.Type = command.Read<D3D12_COMMAND_LIST_TYPE>();
+            commandListStream.Size = command.GetRemainingSize();
+            commandListStream.Data = command.ReadBytes( commandListStream.Size );
+
+            DefineObjects( CommandStreamReader( commandListStream.Data, commandListStream.Size ) );
+
+            frame.push_back( commandListStream );
+        }
+        break;
+        case CommandOp::EndFrame:
+            m_Frames.push_back( std::move( frame ) );
+            frame.clear();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // A capture that was ended before the end of the frame.
+    if ( !frame.empty() )
+    {
+        m_Frames.push_back( std::move( frame ) );
+    }
+}
+
+void CommandStreamPlayer::DefineObjects( CommandStreamReader reader )
+{
+    while ( !reader.IsEnd() )
+    {
+        CommandOp op;
+        auto      command = reader.ReadCommand( op );
+
+        switch ( op )
+        {
+        case CommandOp::DefineResource:
+            DefineResource( command );
+            break;
+        case CommandOp::DefineRootSignature:
+            DefineRootSignature( command );
+            break;
+        case CommandOp::DefinePipelineState:
+            DefinePipelineState( command );
+            break;
+        case CommandOp::DefineCommandSignature:
+            DefineCommandSignature( command );
+            break;
+        case CommandOp::DefineShaderResourceView:
+        {
+            auto define = command.Read<commands::DefineShaderResourceView>();
+            if ( m_ShaderResourceViews.count( define.Id ) == 0 )
+            {
+                auto  resource = GetResource( define.ResourceId );
+                auto& srv      = m_ShaderResourceViews[define.Id];
+
+                // Null descriptors require a view description.
+                if ( resource || define.HasDesc )
+                {
+                    srv = m_Device.CreateShaderResourceView( resource, define.HasDesc ? &define.Desc : nullptr );
+                }
+            }
+        }
+        break;
+        case CommandOp::DefineUnorderedAccessView:
+        {
+            auto define = command.Read<commands::DefineUnorderedAccessView>();
+            if ( m_UnorderedAccessViews.count( define.Id ) == 0 )
+            {
+                auto  resource = GetResource( define.ResourceId );
+                auto& uav      = m_UnorderedAccessViews[define.Id];
+
+                if ( resource || define.HasDesc )
+                {
+                    uav = m_Device.CreateUnorderedAccessView( resource, GetResource( define.CounterResourceId ),
+                                                              define.HasDesc ? &define.Desc : nullptr );
+                }
+            }
+        }
+        break;
+        case CommandOp::DefineConstantBufferView:
+        {
+            auto define = command.Read<commands::DefineConstantBufferView>();
+            if ( m_ConstantBufferViews.count( define.Id ) == 0 )
+            {
+                auto  constantBuffer = GetConstantBuffer( define.ResourceId );
+                auto& cbv            = m_ConstantBufferViews[define.Id];
+
+                if ( constantBuffer )
+                {
+                    cbv = m_Device.CreateConstantBufferView( constantBuffer, static_cast<size_t>( define.Offset ) );
+                }
+            }
+        }
+        break;
+        default:
+            break;
+        }
+    }
+}
+
+void CommandStreamPlayer::DefineResource( CommandStreamReader& reader )
+{
+    auto define = reader.Read<commands::DefineResource>();
+    auto name   = ConvertString( reader.ReadString() );
+
+    if ( m_Resources.count( define.Id ) )
+    {
+        return;
+    }
+
+    auto& resource = m_Resources[define.Id];
+
+    if ( define.Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER )
+    {
+        // Buffers are created in the same heap as the captured buffer (dynamic
+        // buffers are not captured so upload heaps are rare).
+        D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON;
+        switch ( define.HeapType )
+        {
+        case D3D12_HEAP_TYPE_UPLOAD:
+            initialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+            break;
+        case D3D12_HEAP_TYPE_READBACK:
+            initialState = D3D12_RESOURCE_STATE_COPY_DEST;
+            break;
+        default:
+            break;
+        }
+
+        auto d3d12Device = m_Device.GetD3D12Device();
+        ThrowIfFailed( d3d12Device->CreateCommittedResource( &CD3DX12_HEAP_PROPERTIES( define.HeapType ),
+                                                             D3D12_HEAP_FLAG_NONE, &define.Desc, initialState, nullptr,
+                                                             IID_PPV_ARGS( &resource.D3D12Resource ) ) );
+
+        ResourceStateTracker::AddGlobalResourceState( resource.D3D12Resource.Get(), initialState );
+
+        if ( !name.empty() )
+        {
+            resource.D3D12Resource->SetName( name.c_str() );
+        }
+    }
+    else
+    {
+        resource.WrappedTexture =
+            m_Device.CreateTexture( define.Desc, define.HasClearValue ? &define.ClearValue : nullptr );
+        resource.WrappedTexture->SetName( name );
+
+        resource.D3D12Resource = resource.WrappedTexture->GetD3D12Resource();
+    }
+}
+
+void CommandStreamPlayer::DefineRootSignature( CommandStreamReader& reader )
+{
+    auto define = reader.Read<commands::DefineRootSignature>();
+
+    std::vector<D3D12_ROOT_PARAMETER1>               rootParameters( define.NumParameters );
+    std::vector<std::vector<D3D12_DESCRIPTOR_RANGE1>> descriptorRanges( define.NumParameters );
+    for ( uint32_t i = 0; i < define.NumParameters; ++i )
+    {
+        auto& rootParameter = rootParameters[i];
+        rootParameter       = reader.Read<D3D12_ROOT_PARAMETER1>();
+
+        // The descriptor ranges of a table follow the parameter.
+        if ( rootParameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE )
+        {
+            auto& ranges = descriptorRanges[i];
+            ranges.resize( rootParameter.DescriptorTable.NumDescriptorRanges );
+            memcpy( ranges.data(), reader.ReadBytes( sizeof( D3D12_DESCRIPTOR_RANGE1 ) * ranges.size() ),
+                    sizeof( D3D12_DESCRIPTOR_RANGE1 ) * ranges.size() );
+
+            rootParameter.DescriptorTable.pDescriptorRanges = ranges.data();
+        }
+    }
+
+    std::vector<D3D12_STATIC_SAMPLER_DESC> staticSamplers( define.NumStaticSamplers );
+    memcpy( staticSamplers.data(), reader.ReadBytes( sizeof( D3D12_STATIC_SAMPLER_DESC ) * staticSamplers.size() ),
+            sizeof( D3D12_STATIC_SAMPLER_DESC ) * staticSamplers.size() );
+
+    if ( m_RootSignatures.count( define.Id ) )
+    {
+        return;
+    }
+
+    D3D12_ROOT_SIGNATURE_DESC1 rootSignatureDesc;
+    rootSignatureDesc.NumParameters     = define.NumParameters;
+    rootSignatureDesc.pParameters       = rootParameters.data();
+    rootSignatureDesc.NumStaticSamplers = define.NumStaticSamplers;
+    rootSignatureDesc.pStaticSamplers   = staticSamplers.data();
+    rootSignatureDesc.Flags             = define.Flags;
+
+    m_RootSignatures[define.Id] = m_Device.CreateRootSignature( rootSignatureDesc );
+}
+
+void CommandStreamPlayer::DefinePipelineState( CommandStreamReader& reader )
+{
+    auto define = reader.Read<commands::DefinePipelineState>();
+
+    if ( m_PipelineStates.count( define.Id ) )
+    {
+        return;
+    }
+
+    // Pipeline states that can't be created are null. The draws and
+    // dispatches that use them are skipped.
+    auto& pipelineState = m_PipelineStates[define.Id];
+    if ( !define.IsSerialized )
+    {
+        return;
+    }
+
+    auto pipelineStateDesc =
+        PipelineStateDesc::Deserialize( reader, [this]( uint32_t rootSignatureId ) -> ID3D12RootSignature* {
+            auto rootSignature = Find( m_RootSignatures, rootSignatureId );
+            return rootSignature ? rootSignature->GetD3D12RootSignature().Get() : nullptr;
+        } );
+
+    try
+    {
+        pipelineState = m_Device.DoCreatePipelineStateObject( pipelineStateDesc->GetStreamDesc() );
+    }
+    catch ( const std::exception& )
+    {}
+}
+
+void CommandStreamPlayer::DefineCommandSignature( CommandStreamReader& reader )
+{
+    auto define = reader.Read<commands::DefineCommandSignature>();
+
+    std::vector<D3D12_INDIRECT_ARGUMENT_DESC> argumentDescs( define.NumArgumentDescs );
+    memcpy( argumentDescs.data(), reader.ReadBytes( sizeof( D3D12_INDIRECT_ARGUMENT_DESC ) * argumentDescs.size() ),
+            sizeof( D3D12_INDIRECT_ARGUMENT_DESC ) * argumentDescs.size() );
+
+    if ( m_CommandSignatures.count( define.Id ) )
+    {
+        return;
+    }
+
+    D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc;
+    commandSignatureDesc.ByteStride       = define.ByteStride;
+    commandSignatureDesc.NumArgumentDescs = define.NumArgumentDescs;
+    commandSignatureDesc.pArgumentDescs   = argumentDescs.data();
+    commandSignatureDesc.NodeMask         = define.NodeMask;
+
+    m_CommandSignatures[define.Id] =
+        m_Device.CreateCommandSignature( commandSignatureDesc, Find( m_RootSignatures, define.RootSignatureId ) );
+}
+
+CommandStreamPlayer::FrameStatistics CommandStreamPlayer::ReplayFrame( uint32_t frame )
+{
+    if ( frame >= m_Frames.size() )
+    {
+        throw std::exception( "Invalid frame index." );
+    }
+
+    FrameStatistics statistics = {};
+
+    // Wait for the oldest frame in flight before queuing another frame.
+    auto waitStart = std::chrono::high_resolution_clock::now();
+    if ( m_FrameFences.size() >= MaxFramesInFlight )
+    {
+        const auto& frameFence = m_FrameFences.front();
+        for ( size_t i = 0; i < _countof( QueueTypes ); ++i )
+        {
+            if ( frameFence.FenceValues[i] > 0 )
+            {
+                m_Device.GetCommandQueue( QueueTypes[i] ).WaitForFenceValue( frameFence.FenceValues[i] );
+            }
+        }
+        m_FrameFences.pop_front();
+
+        m_Device.ReleaseStaleDescriptors();
+    }
+    auto cpuStart = std::chrono::high_resolution_clock::now();
+
+    FrameFence    frameFence    = {};
+    CommandQueue* previousQueue = nullptr;
+    for ( const auto& commandListStream: m_Frames[frame] )
+    {
+        auto& commandQueue = m_Device.GetCommandQueue( commandListStream.Type );
+
+        // Command lists that were executed on different queues are executed in
+        // the order they were submitted.
+        if ( previousQueue && previousQueue != &commandQueue )
+        {
+            commandQueue.Wait( *previousQueue );
+        }
+
+        auto commandList = commandQueue.GetCommandList();
+        ReplayCommandList( *commandList, CommandStreamReader( commandListStream.Data, commandListStream.Size ),
+                           statistics );
+
+        frameFence.FenceValues[GetQueueIndex( commandListStream.Type )] =
+            commandQueue.ExecuteCommandList( commandList );
+
+        previousQueue = &commandQueue;
+        ++statistics.NumCommandLists;
+    }
+    m_FrameFences.push_back( frameFence );
+
+    auto cpuEnd = std::chrono::high_resolution_clock::now();
+
+    statistics.WaitTime = std::chrono::duration<double>( cpuStart - waitStart ).count();
+    statistics.CpuTime  = std::chrono::duration<double>( cpuEnd - cpuStart ).count();
+
+    return statistics;
+}
+
+void CommandStreamPlayer::Flush()
+{
+    m_Device.Flush();
+    m_FrameFences.clear();
+}
+
+void CommandStreamPlayer::ReplayCommandList( CommandList& commandList, CommandStreamReader reader,
+                                             FrameStatistics& statistics )
+{
+    // Draws and dispatches are skipped if the pipeline state could not be created.
+    bool hasPipelineState = false;
+
+    while ( !reader.IsEnd() )
+    {
+        CommandOp op;
+        auto      command = reader.ReadCommand( op );
+
+        // Objects are created when the capture is loaded.
+        if ( op >= CommandOp::DefineResource && op <= CommandOp::DefineConstantBufferView )
+        {
+            continue;
+        }
+
+        ++statistics.NumCommands;
+        bool skipped = false;
+
+        switch ( op )
+        {
+        case CommandOp::TransitionBarrier:
+        {
+            auto transitionBarrier = command.Read<commands::TransitionBarrier>();
+            auto resource          = GetResource( transitionBarrier.ResourceId );
+            if ( resource )
+            {
+                commandList.TransitionBarrier( resource, transitionBarrier.StateAfter, transitionBarrier.Subresource,
+                                               transitionBarrier.FlushBarriers != 0 );
+            }
+            skipped = !resource;
+        }
+        break;
+        case CommandOp::UAVBarrier:
+        {
+            auto uavBarrier = command.Read<commands::UAVBarrier>();
+            commandList.UAVBarrier( GetResource( uavBarrier.ResourceId ), uavBarrier.FlushBarriers != 0 );
+        }
+        break;
+        case CommandOp::AliasingBarrier:
+        {
+            auto aliasingBarrier = command.Read<commands::AliasingBarrier>();
+            commandList.AliasingBarrier( GetResource( aliasingBarrier.BeforeResourceId ),
+                                         GetResource( aliasingBarrier.AfterResourceId ),
+                                         aliasingBarrier.FlushBarriers != 0 );
+        }
+        break;
+        case CommandOp::FlushResourceBarriers:
+            commandList.FlushResourceBarriers();
+            break;
+        case CommandOp::CopyResource:
+        {
+            auto copyResource = command.Read<commands::CopyResource>();
+            auto dstResource  = GetResource( copyResource.DstResourceId );
+            auto srcResource  = GetResource( copyResource.SrcResourceId );
+            if ( dstResource && srcResource )
+            {
+                commandList.CopyResource( dstResource, srcResource );
+            }
+            skipped = !dstResource || !srcResource;
+        }
+        break;
+        case CommandOp::ResolveSubresource:
+        {
+            auto resolveSubresource = command.Read<commands::ResolveSubresource>();
+            auto dstResource        = GetResource( resolveSubresource.DstResourceId );
+            auto srcResource        = GetResource( resolveSubresource.SrcResourceId );
+            if ( dstResource && srcResource )
+            {
+                commandList.ResolveSubresource( dstResource, srcResource, resolveSubresource.DstSubresource,
+                                                resolveSubresource.SrcSubresource );
+            }
+            skipped = !dstResource || !srcResource;
+        }
+        break;
+        case CommandOp::CopyBufferRegion:
+        {
+            auto copyBufferRegion = command.Read<commands::CopyBufferRegion>();
+            auto resource         = GetResource( copyBufferRegion.ResourceId );
+            if ( resource )
+            {
+                commandList.CopyBufferRegion( resource, static_cast<size_t>( copyBufferRegion.DstOffset ),
+                                              static_cast<size_t>( copyBufferRegion.NumBytes ),
+                                              GetUploadData( copyBufferRegion.NumBytes, statistics ) );
+            }
+            skipped = !resource;
+        }
+        break;
+        case CommandOp::CopyTextureSubresource:
+        {
+            auto copyTextureSubresource = command.Read<commands::CopyTextureSubresource>();
+
+            std::vector<D3D12_SUBRESOURCE_DATA> subresourceData( copyTextureSubresource.NumSubresources );
+            for ( auto& data: subresourceData )
+            {
+                auto subresource = command.Read<commands::SubresourceData>();
+
+                data.pData      = GetUploadData( subresource.NumBytes, statistics );
+                data.RowPitch   = static_cast<LONG_PTR>( subresource.RowPitch );
+                data.SlicePitch = static_cast<LONG_PTR>( subresource.SlicePitch );
+            }
+
+            auto texture = GetTexture( copyTextureSubresource.ResourceId );
+            if ( texture )
+            {
+                commandList.CopyTextureSubresource( texture, copyTextureSubresource.FirstSubresource,
+                                                    copyTextureSubresource.NumSubresources, subresourceData.data() );
+            }
+            skipped = !texture;
+        }
+        break;
+        case CommandOp::CopyTextureRegion:
+        {
+            auto copyTextureRegion = command.Read<commands::CopyTextureRegion>();
+            auto texture           = GetTexture( copyTextureRegion.ResourceId );
+            if ( texture )
+            {
+                D3D12_SUBRESOURCE_DATA subresourceData;
+                subresourceData.pData      = GetUploadData( copyTextureRegion.Data.NumBytes, statistics );
+                subresourceData.RowPitch   = static_cast<LONG_PTR>( copyTextureRegion.Data.RowPitch );
+                subresourceData.SlicePitch = static_cast<LONG_PTR>( copyTextureRegion.Data.SlicePitch );
+
+                commandList.CopyTextureRegion( texture, copyTextureRegion.Subresource, copyTextureRegion.DstX,
+                                               copyTextureRegion.DstY, copyTextureRegion.DstZ, copyTextureRegion.Width,
+                                               copyTextureRegion.Height, copyTextureRegion.Depth, subresourceData );
+            }
+            skipped = !texture;
+        }
+        break;
+        case CommandOp::GenerateMips:
+        {
+            auto texture = GetTexture( command.Read<commands::GenerateMips>().ResourceId );
+            if ( texture )
+            {
+                commandList.GenerateMips( texture );
+            }
+            skipped = !texture;
+        }
+        break;
+        case CommandOp::PanoToCubemap:
+        {
+            auto panoToCubemap  = command.Read<commands::PanoToCubemap>();
+            auto cubemapTexture = GetTexture( panoToCubemap.CubemapResourceId );
+            auto panoTexture    = GetTexture( panoToCubemap.PanoResourceId );
+            if ( cubemapTexture && panoTexture )
+            {
+                commandList.PanoToCubemap( cubemapTexture, panoTexture );
+            }
+            skipped = !cubemapTexture || !panoTexture;
+        }
+        break;
+        case CommandOp::ClearTexture:
+        {
+            auto clearTexture = command.Read<commands::ClearTexture>();
+            auto texture      = GetTexture( clearTexture.ResourceId );
+            if ( texture )
+            {
+                commandList.ClearTexture( texture, clearTexture.ClearColor );
+            }
+            skipped = !texture;
+        }
+        break;
+        case CommandOp::ClearDepthStencilTexture:
+        {
+            auto clearDepthStencilTexture = command.Read<commands::ClearDepthStencilTexture>();
+            auto texture                  = GetTexture( clearDepthStencilTexture.ResourceId );
+            if ( texture )
+            {
+                commandList.ClearDepthStencilTexture( texture, clearDepthStencilTexture.ClearFlags,
+                                                      clearDepthStencilTexture.Depth,
+                                                      static_cast<uint8_t>( clearDepthStencilTexture.Stencil ) );
+            }
+            skipped = !texture;
+        }
+        break;
+        case CommandOp::SetPrimitiveTopology:
+            commandList.SetPrimitiveTopology( command.Read<commands::SetPrimitiveTopology>().PrimitiveTopology );
+            break;
+        case CommandOp::SetViewports:
+        {
+            auto                        setViewports = command.Read<commands::SetViewports>();
+            std::vector<D3D12_VIEWPORT> viewports( setViewports.NumViewports );
+            memcpy( viewports.data(), command.ReadBytes( sizeof( D3D12_VIEWPORT ) * viewports.size() ),
+                    sizeof( D3D12_VIEWPORT ) * viewports.size() );
+
+            commandList.SetViewports( viewports );
+        }
+        break;
+        case CommandOp::SetScissorRects:
+        {
+            auto                    setScissorRects = command.Read<commands::SetScissorRects>();
+            std::vector<D3D12_RECT> scissorRects( setScissorRects.NumScissorRects );
+            memcpy( scissorRects.data(), command.ReadBytes( sizeof( D3D12_RECT ) * scissorRects.size() ),
+                    sizeof( D3D12_RECT ) * scissorRects.size() );
+
+            commandList.SetScissorRects( scissorRects );
+        }
+        break;
+        case CommandOp::SetPipelineState:
+        {
+            auto pipelineState =
+                Find( m_PipelineStates, command.Read<commands::SetPipelineState>().PipelineStateId );
+            if ( pipelineState )
+            {
+                commandList.SetPipelineState( pipelineState );
+            }
+            hasPipelineState = pipelineState != nullptr;
+            skipped          = !pipelineState;
+        }
+        break;
+        case CommandOp::SetGraphicsRootSignature:
+        case CommandOp::SetComputeRootSignature:
+        {
+            auto rootSignature = Find( m_RootSignatures, command.Read<commands::SetRootSignature>().RootSignatureId );
+            if ( rootSignature )
+            {
+                if ( op == CommandOp::SetGraphicsRootSignature )
+                {
+                    commandList.SetGraphicsRootSignature( rootSignature );
+                }
+                else
+                {
+                    commandList.SetComputeRootSignature( rootSignature );
+                }
+            }
+            skipped = !rootSignature;
+        }
+        break;
+        case CommandOp::SetGraphics32BitConstants:
+        case CommandOp::SetCompute32BitConstants:
+        {
+            auto        set32BitConstants = command.Read<commands::Set32BitConstants>();
+            const void* constants         = command.ReadBytes( sizeof( uint32_t ) * set32BitConstants.NumConstants );
+
+            if ( op == CommandOp::SetGraphics32BitConstants )
+            {
+                commandList.SetGraphics32BitConstants( set32BitConstants.RootParameterIndex,
+                                                       set32BitConstants.NumConstants, constants );
+            }
+            else
+            {
+                commandList.SetCompute32BitConstants( set32BitConstants.RootParameterIndex,
+                                                      set32BitConstants.NumConstants, constants );
+            }
+        }
+        break;
+        case CommandOp::SetGraphicsDynamicConstantBuffer:
+        {
+            auto   setDynamicBuffer = command.Read<commands::SetDynamicBuffer>();
+            size_t sizeInBytes      = static_cast<size_t>( setDynamicBuffer.NumElements * setDynamicBuffer.ElementSize );
+
+            commandList.SetGraphicsDynamicConstantBuffer( setDynamicBuffer.RootParameterIndex, sizeInBytes,
+                                                          GetUploadData( sizeInBytes, statistics ) );
+        }
+        break;
+        case CommandOp::SetGraphicsDynamicStructuredBuffer:
+        {
+            auto setDynamicBuffer = command.Read<commands::SetDynamicBuffer>();
+
+            commandList.SetGraphicsDynamicStructuredBuffer(
+                setDynamicBuffer.RootParameterIndex, static_cast<size_t>( setDynamicBuffer.NumElements ),
+                static_cast<size_t>( setDynamicBuffer.ElementSize ),
+                GetUploadData( setDynamicBuffer.NumElements * setDynamicBuffer.ElementSize, statistics ) );
+        }
+        break;
+        case CommandOp::SetVertexBuffers:
+        {
+            auto setVertexBuffers = command.Read<commands::SetVertexBuffers>();
+
+            std::vector<std::shared_ptr<VertexBuffer>> vertexBuffers;
+            vertexBuffers.reserve( setVertexBuffers.NumVertexBuffers );
+            for ( uint32_t i = 0; i < setVertexBuffers.NumVertexBuffers; ++i )
+            {
+                auto binding      = command.Read<commands::VertexBufferBinding>();
+                auto vertexBuffer = GetVertexBuffer( binding.ResourceId, binding.NumVertices, binding.VertexStride );
+                if ( vertexBuffer )
+                {
+                    vertexBuffers.push_back( vertexBuffer );
+                }
+            }
+
+            commandList.SetVertexBuffers( setVertexBuffers.StartSlot, vertexBuffers );
+        }
+        break;
+        case CommandOp::SetDynamicVertexBuffer:
+        {
+            auto setDynamicVertexBuffer = command.Read<commands::SetDynamicVertexBuffer>();
+
+            commandList.SetDynamicVertexBuffer(
+                setDynamicVertexBuffer.Slot, static_cast<size_t>( setDynamicVertexBuffer.NumVertices ),
+                static_cast<size_t>( setDynamicVertexBuffer.VertexSize ),
+                GetUploadData( setDynamicVertexBuffer.NumVertices * setDynamicVertexBuffer.VertexSize, statistics ) );
+        }
+        break;
+        case CommandOp::SetIndexBuffer:
+        {
+            auto setIndexBuffer = command.Read<commands::SetIndexBuffer>();
+            auto indexBuffer =
+                GetIndexBuffer( setIndexBuffer.ResourceId, setIndexBuffer.NumIndices, setIndexBuffer.IndexFormat );
+            if ( indexBuffer )
+            {
+                commandList.SetIndexBuffer( indexBuffer );
+            }
+            skipped = !indexBuffer;
+        }
+        break;
+        case CommandOp::SetDynamicIndexBuffer:
+        {
+            auto     setDynamicIndexBuffer = command.Read<commands::SetDynamicIndexBuffer>();
+            uint64_t indexSize             = setDynamicIndexBuffer.IndexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+
+            commandList.SetDynamicIndexBuffer(
+                static_cast<size_t>( setDynamicIndexBuffer.NumIndices ), setDynamicIndexBuffer.IndexFormat,
+                GetUploadData( setDynamicIndexBuffer.NumIndices * indexSize, statistics ) );
+        }
+        break;
+        case CommandOp::SetInlineConstantBufferView:
+        {
+            auto setInlineView  = command.Read<commands::SetInlineView>();
+            auto constantBuffer = GetConstantBuffer( setInlineView.ResourceId );
+            if ( constantBuffer )
+            {
+                commandList.SetConstantBufferView( setInlineView.RootParameterIndex, constantBuffer,
+                                                   setInlineView.StateAfter,
+                                                   static_cast<size_t>( setInlineView.BufferOffset ) );
+            }
+            skipped = !constantBuffer;
+        }
+        break;
+        case CommandOp::SetInlineShaderResourceView:
+        case CommandOp::SetInlineUnorderedAccessView:
+        {
+            auto                    setInlineView = command.Read<commands::SetInlineView>();
+            std::shared_ptr<Buffer> buffer        = GetBuffer( setInlineView.ResourceId );
+            if ( buffer )
+            {
+                if ( op == CommandOp::SetInlineShaderResourceView )
+                {
+                    commandList.SetShaderResourceView( setInlineView.RootParameterIndex, buffer,
+                                                       setInlineView.StateAfter,
+                                                       static_cast<size_t>( setInlineView.BufferOffset ) );
+                }
+                else
+                {
+                    commandList.SetUnorderedAccessView( setInlineView.RootParameterIndex, buffer,
+                                                        setInlineView.StateAfter,
+                                                        static_cast<size_t>( setInlineView.BufferOffset ) );
+                }
+            }
+            skipped = !buffer;
+        }
+        break;
+        case CommandOp::SetConstantBufferView:
+        {
+            auto setDescriptor = command.Read<commands::SetDescriptor>();
+            auto cbv           = Find( m_ConstantBufferViews, setDescriptor.ViewId );
+            if ( cbv )
+            {
+                commandList.SetConstantBufferView( setDescriptor.RootParameterIndex, setDescriptor.DescriptorOffset,
+                                                   cbv, setDescriptor.StateAfter );
+            }
+            skipped = !cbv;
+        }
+        break;
+        case CommandOp::SetShaderResourceView:
+        {
+            auto setDescriptor = command.Read<commands::SetDescriptor>();
+            auto srv           = Find( m_ShaderResourceViews, setDescriptor.ViewId );
+            if ( srv )
+            {
+                commandList.SetShaderResourceView( setDescriptor.RootParameterIndex, setDescriptor.DescriptorOffset,
+                                                   srv, setDescriptor.StateAfter, setDescriptor.FirstSubresource,
+                                                   setDescriptor.NumSubresources );
+            }
+            skipped = !srv;
+        }
+        break;
+        case CommandOp::SetTextureShaderResourceView:
+        {
+            auto setDescriptor = command.Read<commands::SetDescriptor>();
+            auto texture       = GetTexture( setDescriptor.ViewId );
+            if ( texture )
+            {
+                commandList.SetShaderResourceView( static_cast<int32_t>( setDescriptor.RootParameterIndex ),
+                                                   setDescriptor.DescriptorOffset, texture, setDescriptor.StateAfter,
+                                                   setDescriptor.FirstSubresource, setDescriptor.NumSubresources );
+            }
+            skipped = !texture;
+        }
+        break;
+        case CommandOp::SetUnorderedAccessView:
+        {
+            auto setDescriptor = command.Read<commands::SetDescriptor>();
+            auto uav           = Find( m_UnorderedAccessViews, setDescriptor.ViewId );
+            if ( uav )
+            {
+                commandList.SetUnorderedAccessView( setDescriptor.RootParameterIndex, setDescriptor.DescriptorOffset,
+                                                    uav, setDescriptor.StateAfter, setDescriptor.FirstSubresource,
+                                                    setDescriptor.NumSubresources );
+            }
+            skipped = !uav;
+        }
+        break;
+        case CommandOp::SetTextureUnorderedAccessView:
+        {
+            auto setDescriptor = command.Read<commands::SetDescriptor>();
+            auto texture       = GetTexture( setDescriptor.ViewId );
+            if ( texture )
+            {
+                commandList.SetUnorderedAccessView( setDescriptor.RootParameterIndex, setDescriptor.DescriptorOffset,
+                                                    texture, setDescriptor.Mip, setDescriptor.StateAfter,
+                                                    setDescriptor.FirstSubresource, setDescriptor.NumSubresources );
+            }
+            skipped = !texture;
+        }
+        break;
+        case CommandOp::SetBindlessDescriptorTable:
+            commandList.SetBindlessDescriptorTable(
+                command.Read<commands::SetBindlessDescriptorTable>().RootParameterIndex );
+            break;
+        case CommandOp::SetRenderTarget:
+        {
+            auto setRenderTarget = command.Read<commands::SetRenderTarget>();
+
+            RenderTarget renderTarget;
+            for ( int i = 0; i < AttachmentPoint::NumAttachmentPoints; ++i )
+            {
+                renderTarget.AttachTexture( static_cast<AttachmentPoint>( i ),
+                                            GetTexture( setRenderTarget.ResourceIds[i] ) );
+            }
+
+            commandList.SetRenderTarget( renderTarget );
+        }
+        break;
+        case CommandOp::Draw:
+        {
+            auto draw = command.Read<commands::Draw>();
+            if ( hasPipelineState )
+            {
+                commandList.Draw( draw.VertexCount, draw.InstanceCount, draw.StartVertex, draw.StartInstance );
+                ++statistics.NumDraws;
+            }
+            skipped = !hasPipelineState;
+        }
+        break;
+        case CommandOp::DrawIndexed:
+        {
+            auto drawIndexed = command.Read<commands::DrawIndexed>();
+            if ( hasPipelineState )
+            {
+                commandList.DrawIndexed( drawIndexed.IndexCount, drawIndexed.InstanceCount, drawIndexed.StartIndex,
+                                         drawIndexed.BaseVertex, drawIndexed.StartInstance );
+                ++statistics.NumDraws;
+            }
+            skipped = !hasPipelineState;
+        }
+        break;
+        case CommandOp::Dispatch:
+        {
+            auto dispatch = command.Read<commands::Dispatch>();
+            if ( hasPipelineState )
+            {
+                commandList.Dispatch( dispatch.NumGroupsX, dispatch.NumGroupsY, dispatch.NumGroupsZ );
+                ++statistics.NumDispatches;
+            }
+            skipped = !hasPipelineState;
+        }
+        break;
+        case CommandOp::ExecuteIndirect:
+        {
+            auto executeIndirect  = command.Read<commands::ExecuteIndirect>();
+            auto commandSignature = Find( m_CommandSignatures, executeIndirect.CommandSignatureId );
+            auto argumentBuffer   = GetBuffer( executeIndirect.ArgumentBufferId );
+            if ( hasPipelineState && commandSignature && argumentBuffer )
+            {
+                commandList.ExecuteIndirect( commandSignature, executeIndirect.MaxCommandCount, argumentBuffer,
+                                             executeIndirect.ArgumentBufferOffset,
+                                             GetBuffer( executeIndirect.CountBufferId ),
+                                             executeIndirect.CountBufferOffset );
+
+                if ( commandSignature->IsDispatch() )
+                {
+                    ++statistics.NumDispatches;
+                }
+                else
+                {
+                    ++statistics.NumDraws;
+                }
+            }
+            skipped = !hasPipelineState || !commandSignature || !argumentBuffer;
+        }
+        break;
+        default:
+            skipped = true;
+            break;
+        }
+
+        if ( skipped )
+        {
+            ++statistics.NumSkippedCommands;
+        }
+    }
+}
+
+const void* CommandStreamPlayer::GetUploadData( uint64_t numBytes, FrameStatistics& statistics )
+{
+    if ( m_UploadData.size() < numBytes )
+    {
+        m_UploadData.resize( static_cast<size_t>( numBytes ) );
+    }
+
+    statistics.NumUploadBytes += numBytes;
+
+    return m_UploadData.data();
+}
+
+std::shared_ptr<Resource> CommandStreamPlayer::GetResource( uint32_t id )
+{
+    auto texture = GetTexture( id );
+    if ( texture )
+    {
+        return texture;
+    }
+
+    return GetBuffer( id );
+}
+
+std::shared_ptr<Texture> CommandStreamPlayer::GetTexture( uint32_t id )
+{
+    auto iter = m_Resources.find( id );
+    return iter != m_Resources.end() ? iter->second.WrappedTexture : nullptr;
+}
+
+std::shared_ptr<ByteAddressBuffer> CommandStreamPlayer::GetBuffer( uint32_t id )
+{
+    auto iter = m_Resources.find( id );
+    if ( iter == m_Resources.end() || iter->second.WrappedTexture )
+    {
+        return nullptr;
+    }
+
+    auto& resource = iter->second;
+    if ( !resource.WrappedBuffer )
+    {
+        resource.WrappedBuffer = m_Device.CreateByteAddressBuffer( resource.D3D12Resource );
+    }
+
+    return resource.WrappedBuffer;
+}
+
+std::shared_ptr<ConstantBuffer> CommandStreamPlayer::GetConstantBuffer( uint32_t id )
+{
+    auto iter = m_Resources.find( id );
+    if ( iter == m_Resources.end() || iter->second.WrappedTexture )
+    {
+        return nullptr;
+    }
+
+    auto& resource = iter->second;
+    if ( !resource.WrappedConstantBuffer )
+    {
+        resource.WrappedConstantBuffer = m_Device.CreateConstantBuffer( resource.D3D12Resource );
+    }
+
+    return resource.WrappedConstantBuffer;
+}
+
+std::shared_ptr<VertexBuffer> CommandStreamPlayer::GetVertexBuffer( uint32_t id, uint64_t numVertices,
+                                                                    uint64_t vertexStride )
+{
+    auto iter = m_Resources.find( id );
+    if ( iter == m_Resources.end() || iter->second.WrappedTexture )
+    {
+        return nullptr;
+    }
+
+    auto& vertexBuffer = iter->second.VertexBuffers[{ numVertices, vertexStride }];
+    if ( !vertexBuffer )
+    {
+        vertexBuffer = m_Device.CreateVertexBuffer( iter->second.D3D12Resource, static_cast<size_t>( numVertices ),
+                                                    static_cast<size_t>( vertexStride ) );
+    }
+
+    return vertexBuffer;
+}
+
+std::shared_ptr<IndexBuffer> CommandStreamPlayer::GetIndexBuffer( uint32_t id, uint64_t numIndices,
+                                                                  DXGI_FORMAT indexFormat )
+{
+    auto iter = m_Resources.find( id );
+    if ( iter == m_Resources.end() || iter->second.WrappedTexture )
+    {
+        return nullptr;
+    }
+
+    auto& indexBuffer = iter->second.IndexBuffers[{ numIndices, indexFormat }];
+    if ( !indexBuffer )
+    {
+        indexBuffer =
+            m_Device.CreateIndexBuffer( iter->second.D3D12Resource, static_cast<size_t>( numIndices ), indexFormat );
+    }
+
+    return indexBuffer;
+}
@@ -11,6 +11,7 @@ ConstantBufferView::ConstantBufferView( Device& device, const std::shared_ptr<Co
                                         size_t offset )
 : m_Device( device )
 , m_ConstantBuffer( constantBuffer )
+, m_Offset( offset )
 {
     assert( constantBuffer );
 
@@ -1,25 +1,34 @@
 #include "DX12LibPCH.h"
 
 #include <dx12lib/Adapter.h>
+#include <dx12lib/BindlessDescriptorTable.h>
 #include <dx12lib/ByteAddressBuffer.h>
 #include <dx12lib/CommandList.h>
 #include <dx12lib/CommandQueue.h>
+#include <dx12lib/CommandRecorder.h>
+#include <dx12lib/CommandSignature.h>
 #include <dx12lib/ConstantBuffer.h>
 #include <dx12lib/ConstantBufferView.h>
 #include <dx12lib/DescriptorAllocator.h>
 #include <dx12lib/Device.h>
 #include <dx12lib/GUI.h>
 #include <dx12lib/IndexBuffer.h>
+#include <dx12lib/MaterialTable.h>
+#include <dx12lib/NullDevice.h>
+#include <dx12lib/PipelineStateCache.h>
 #include <dx12lib/PipelineStateObject.h>
 #include <dx12lib/ResourceStateTracker.h>
 #include <dx12lib/RootSignature.h>
 #include <dx12lib/Scene.h>
 #include <dx12lib/ShaderResourceView.h>
+#include <dx12lib/StagingAllocator.h>
+#include <dx12lib/StreamingUploadQueue.h>
 #include <dx12lib/StructuredBuffer.h>
 #include <dx12lib/SwapChain.h>
 #include <dx12lib/Texture.h>
 #include <dx12lib/UnorderedAccessView.h>
 #include <dx12lib/VertexBuffer.h>
+#include <dx12lib/VirtualTextureStreamer.h>
 
 using namespace dx12lib;
 
@@ -68,15 +77,16 @@ public:
     virtual ~MakeConstantBufferView() {}
 };
 
-class MakePipelineStateObject : public PipelineStateObject
+class MakePipelineStateCache : public PipelineStateCache
 {
 public:
-    MakePipelineStateObject( Device& device, const D3D12_PIPELINE_STATE_STREAM_DESC& desc )
-    : PipelineStateObject( device, desc )
+    MakePipelineStateCache( Device& device, const std::wstring& libraryFileName, uint32_t numThreads )
+    : PipelineStateCache( device, libraryFileName, numThreads )
     {}
 
-    virtual ~MakePipelineStateObject() {}
+    virtual ~MakePipelineStateCache() {}
 };
+
 class MakeRootSignature : public RootSignature
 {
 public:
@@ -87,6 +97,17 @@ public:
     virtual ~MakeRootSignature() {}
 };
 
+class MakeCommandSignature : public CommandSignature
+{
+public:
+    MakeCommandSignature( Device& device, const D3D12_COMMAND_SIGNATURE_DESC& commandSignatureDesc,
+                          std::shared_ptr<RootSignature> rootSignature )
+    : CommandSignature( device, commandSignatureDesc, rootSignature )
+    {}
+
+    virtual ~MakeCommandSignature() {}
+};
+
 class MakeTexture : public Texture
 {
 public:
@@ -178,6 +199,64 @@ public:
     virtual ~MakeDescriptorAllocator() {}
 };
 
+class MakeBindlessDescriptorTable : public BindlessDescriptorTable
+{
+public:
+    MakeBindlessDescriptorTable( Device& device, uint32_t capacity )
+    : BindlessDescriptorTable( device, capacity )
+    {}
+
+    virtual ~MakeBindlessDescriptorTable() {}
+};
+
+class MakeMaterialTable : public MaterialTable
+{
+public:
+    MakeMaterialTable( Device& device )
+    : MaterialTable( device )
+    {}
+
+    virtual ~MakeMaterialTable() {}
+};
+
+class MakeStagingAllocator : public StagingAllocator
+{
+public:
+    MakeStagingAllocator( Device& device )
+    : StagingAllocator( device )
+    {}
+
+    virtual ~MakeStagingAllocator() {}
+};
+
+class MakeCommandRecorder : public CommandRecorder
+{
+public:
+    MakeCommandRecorder() {}
+
+    virtual ~MakeCommandRecorder() {}
+};
+
+class MakeStreamingUploadQueue : public StreamingUploadQueue
+{
+public:
+    MakeStreamingUploadQueue( Device& device, uint64_t frameBudget )
+    : StreamingUploadQueue( device, frameBudget )
+    {}
+
+    virtual ~MakeStreamingUploadQueue() {}
+};
+
+class MakeVirtualTextureStreamer : public VirtualTextureStreamer
+{
+public:
+    MakeVirtualTextureStreamer( Device& device, uint64_t tilePoolSize, uint32_t maxTilesPerUpdate )
+    : VirtualTextureStreamer( device, tilePoolSize, maxTilesPerUpdate )
+    {}
+
+    virtual ~MakeVirtualTextureStreamer() {}
+};
+
 class MakeSwapChain : public SwapChain
 {
 public:
@@ -205,6 +284,10 @@ public:
     : Device( adapter )
     {}
 
+    MakeDevice( std::shared_ptr<NullDeviceCounters> nullDeviceCounters )
+    : Device( nullDeviceCounters )
+    {}
+
     virtual ~MakeDevice() {}
 };
 #pragma endregion
@@ -231,9 +314,14 @@ std::shared_ptr<Device> Device::Create( std::shared_ptr<Adapter> adapter )
     return std::make_shared<MakeDevice>( adapter );
 }
 
+std::shared_ptr<Device> Device::CreateNull()
+{
+    return std::make_shared<MakeDevice>( std::make_shared<NullDeviceCounters>() );
+}
+
 std::wstring Device::GetDescription() const
 {
-    return m_Adapter->GetDescription();
+    return m_Adapter ? m_Adapter->GetDescription() : L"Null Device";
 }
 
 Device::Device( std::shared_ptr<Adapter> adapter )
@@ -286,10 +374,34 @@ Device::Device( std::shared_ptr<Adapter> adapter )
         ThrowIfFailed( pInfoQueue->PushStorageFilter( &NewFilter ) );
     }
 
+    Initialize();
+}
+
+Device::Device( std::shared_ptr<NullDeviceCounters> nullDeviceCounters )
+: m_NullDeviceCounters( nullDeviceCounters )
+{
+    m_d3d12Device = CreateNullD3D12Device( m_NullDeviceCounters );
+
+    Initialize();
+}
+
+void Device::Initialize()
+{
+    m_StagingAllocator = std::make_unique<MakeStagingAllocator>( *this );
+    m_CommandRecorder  = std::make_unique<MakeCommandRecorder>();
+
+    // The bindless descriptor table must be created before any command lists
+    // since it determines the size of the GPU visible descriptor heaps.
+    m_BindlessDescriptorTable = std::make_unique<MakeBindlessDescriptorTable>( *this, 4096 );
+
     m_DirectCommandQueue  = std::make_unique<MakeCommandQueue>( *this, D3D12_COMMAND_LIST_TYPE_DIRECT );
     m_ComputeCommandQueue = std::make_unique<MakeCommandQueue>( *this, D3D12_COMMAND_LIST_TYPE_COMPUTE );
     m_CopyCommandQueue    = std::make_unique<MakeCommandQueue>( *this, D3D12_COMMAND_LIST_TYPE_COPY );
 
+    // A single worker thread is enough for the default cache since pipeline
+    // state objects are only created asynchronously on request.
+    m_PipelineStateCache = std::make_shared<MakePipelineStateCache>( *this, L"", 1 );
+
     // Create descriptor allocators
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
     {
@@ -353,6 +465,11 @@ void Device::ReleaseStaleDescriptors()
 
 std::shared_ptr<SwapChain> Device::CreateSwapChain( HWND hWnd, DXGI_FORMAT backBufferFormat )
 {
+    if ( m_NullDeviceCounters )
+    {
+        throw std::exception( "Swap chains are not supported on the null device." );
+    }
+
     std::shared_ptr<SwapChain> swapChain;
     swapChain = std::make_shared<MakeSwapChain>( *this, hWnd, backBufferFormat );
 
@@ -366,6 +483,30 @@ std::shared_ptr<GUI> Device::CreateGUI( HWND hWnd, const RenderTarget& renderTar
     return gui;
 }
 
+std::shared_ptr<MaterialTable> Device::CreateMaterialTable()
+{
+    std::shared_ptr<MaterialTable> materialTable = std::make_shared<MakeMaterialTable>( *this );
+
+    return materialTable;
+}
+
+std::shared_ptr<StreamingUploadQueue> Device::CreateStreamingUploadQueue( uint64_t frameBudget )
+{
+    std::shared_ptr<StreamingUploadQueue> streamingUploadQueue =
+        std::make_shared<MakeStreamingUploadQueue>( *this, frameBudget );
+
+    return streamingUploadQueue;
+}
+
+std::shared_ptr<VirtualTextureStreamer> Device::CreateVirtualTextureStreamer( uint64_t tilePoolSize,
+                                                                              uint32_t maxTilesPerUpdate )
+{
+    std::shared_ptr<VirtualTextureStreamer> virtualTextureStreamer =
+        std::make_shared<MakeVirtualTextureStreamer>( *this, tilePoolSize, maxTilesPerUpdate );
+
+    return virtualTextureStreamer;
+}
+
 std::shared_ptr<ConstantBuffer> Device::CreateConstantBuffer( Microsoft::WRL::ComPtr<ID3D12Resource> resource )
 {
     std::shared_ptr<ConstantBuffer> constantBuffer = std::make_shared<MakeConstantBuffer>( *this, resource );
@@ -461,16 +602,35 @@ std::shared_ptr<dx12lib::RootSignature>
 {
     std::shared_ptr<RootSignature> rootSignature = std::make_shared<MakeRootSignature>( *this, rootSignatureDesc );
 
+    // Pipeline state objects reference the root signature by its D3D12 object.
+    m_CommandRecorder->RegisterRootSignature( rootSignature );
+
     return rootSignature;
 }
 
+std::shared_ptr<CommandSignature>
+    Device::CreateCommandSignature( const D3D12_COMMAND_SIGNATURE_DESC& commandSignatureDesc,
+                                    std::shared_ptr<RootSignature>      rootSignature )
+{
+    std::shared_ptr<CommandSignature> commandSignature =
+        std::make_shared<MakeCommandSignature>( *this, commandSignatureDesc, rootSignature );
+
+    return commandSignature;
+}
+
+std::shared_ptr<PipelineStateCache> Device::CreatePipelineStateCache( const std::wstring& libraryFileName,
+                                                                    uint32_t            numThreads )
+{
+    std::shared_ptr<PipelineStateCache> pipelineStateCache =
+        std::make_shared<MakePipelineStateCache>( *this, libraryFileName, numThreads );
+
+    return pipelineStateCache;
+}
+
 std::shared_ptr<PipelineStateObject> Device::DoCreatePipelineStateObject(
     const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc )
 {
-    std::shared_ptr<PipelineStateObject> pipelineStateObject =
-        std::make_shared<MakePipelineStateObject>( *this, pipelineStateStreamDesc );
-
-    return pipelineStateObject;
+    return m_PipelineStateCache->DoGetPipelineStateObject( pipelineStateStreamDesc );
 }
 
 std::shared_ptr<ConstantBufferView>
@@ -2,6 +2,7 @@
 
 #include <dx12lib/DynamicDescriptorHeap.h>
 
+#include <dx12lib/BindlessDescriptorTable.h>
 #include <dx12lib/CommandList.h>
 #include <dx12lib/Device.h>
 #include <dx12lib/RootSignature.h>
@@ -13,17 +14,30 @@ DynamicDescriptorHeap::DynamicDescriptorHeap( Device& device, D3D12_DESCRIPTOR_H
 : m_Device( device )
 , m_DescriptorHeapType( heapType )
 , m_NumDescriptorsPerHeap( numDescriptorsPerHeap )
+, m_BindlessDescriptorTable( nullptr )
+, m_NumReservedDescriptors( 0 )
 , m_DescriptorTableBitMask( 0 )
 , m_StaleDescriptorTableBitMask( 0 )
 , m_StaleCBVBitMask( 0 )
 , m_StaleSRVBitMask( 0 )
 , m_StaleUAVBitMask( 0 )
+, m_BindlessTableBitMask( 0 )
+, m_StagedBindlessTableBitMask( 0 )
+, m_StaleBindlessTableBitMask( 0 )
 , m_CurrentCPUDescriptorHandle( D3D12_DEFAULT )
 , m_CurrentGPUDescriptorHandle( D3D12_DEFAULT )
 , m_NumFreeHandles( 0 )
 {
     m_DescriptorHandleIncrementSize = m_Device.GetDescriptorHandleIncrementSize( heapType );
 
+    // Reserve space for the bindless descriptor table at the start of each
+    // GPU visible descriptor heap.
+    if ( heapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV )
+    {
+        m_BindlessDescriptorTable = &m_Device.GetBindlessDescriptorTable();
+        m_NumReservedDescriptors  = m_BindlessDescriptorTable->GetCapacity();
+    }
+
     // Allocate space for staging CPU visible descriptors.
     m_DescriptorHandleCache = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>( m_NumDescriptorsPerHeap );
 }
@@ -37,6 +51,8 @@ void DynamicDescriptorHeap::ParseRootSignature( const std::shared_ptr<RootSignat
     // If the root signature changes, all descriptors must be (re)bound to the
     // command list.
     m_StaleDescriptorTableBitMask = 0;
+    m_StagedBindlessTableBitMask  = 0;
+    m_StaleBindlessTableBitMask   = 0;
 
     const auto& rootSignatureDesc = rootSignature->GetRootSignatureDesc();
 
@@ -45,6 +61,9 @@ void DynamicDescriptorHeap::ParseRootSignature( const std::shared_ptr<RootSignat
     m_DescriptorTableBitMask        = rootSignature->GetDescriptorTableBitMask( m_DescriptorHeapType );
     uint32_t descriptorTableBitMask = m_DescriptorTableBitMask;
 
+    // Unbounded descriptor tables are only supported for the bindless descriptor table.
+    m_BindlessTableBitMask = m_BindlessDescriptorTable ? rootSignature->GetBindlessTableBitMask() : 0;
+
     uint32_t currentOffset = 0;
     DWORD    rootIndex;
     while ( _BitScanForward( &rootIndex, descriptorTableBitMask ) && rootIndex < rootSignatureDesc.NumParameters )
@@ -119,6 +138,16 @@ void DynamicDescriptorHeap::StageInlineUAV( uint32_t rootParamterIndex, D3D12_GP
     m_StaleUAVBitMask |= ( 1 << rootParamterIndex );
 }
 
+void DynamicDescriptorHeap::StageBindlessDescriptorTable( uint32_t rootParameterIndex )
+{
+    assert( rootParameterIndex < MaxDescriptorTables );
+    assert( ( m_BindlessTableBitMask & ( 1 << rootParameterIndex ) ) != 0 &&
+            "The root parameter is not an unbounded descriptor table." );
+
+    m_StagedBindlessTableBitMask |= ( 1 << rootParameterIndex );
+    m_StaleBindlessTableBitMask |= ( 1 << rootParameterIndex );
+}
+
 uint32_t DynamicDescriptorHeap::ComputeStaleDescriptorCount() const
 {
     uint32_t numStaleDescriptors = 0;
@@ -157,7 +186,7 @@ Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DynamicDescriptorHeap::CreateDescri
 
     D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
     descriptorHeapDesc.Type                       = m_DescriptorHeapType;
-    descriptorHeapDesc.NumDescriptors             = m_NumDescriptorsPerHeap;
+    descriptorHeapDesc.NumDescriptors             = m_NumDescriptorsPerHeap + m_NumReservedDescriptors;
     descriptorHeapDesc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
@@ -166,6 +195,40 @@ Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DynamicDescriptorHeap::CreateDescri
     return descriptorHeap;
 }
 
+void DynamicDescriptorHeap::SetCurrentDescriptorHeap( CommandList& commandList )
+{
+    m_CurrentDescriptorHeap      = RequestDescriptorHeap();
+    m_CurrentCPUDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_CurrentGPUDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+    m_NumFreeHandles             = m_NumDescriptorsPerHeap;
+
+    // Skip the descriptors that are reserved for the bindless descriptor table.
+    m_CurrentCPUDescriptorHandle.Offset( m_NumReservedDescriptors, m_DescriptorHandleIncrementSize );
+    m_CurrentGPUDescriptorHandle.Offset( m_NumReservedDescriptors, m_DescriptorHandleIncrementSize );
+
+    commandList.SetDescriptorHeap( m_DescriptorHeapType, m_CurrentDescriptorHeap.Get() );
+
+    // When updating the descriptor heap on the command list, all descriptor
+    // tables must be (re)recopied to the new descriptor heap (not just
+    // the stale descriptor tables).
+    m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+    m_StaleBindlessTableBitMask   = m_StagedBindlessTableBitMask;
+}
+
+void DynamicDescriptorHeap::UpdateBindlessDescriptors()
+{
+    uint64_t& version = m_BindlessDescriptorVersions[m_CurrentDescriptorHeap.Get()];
+    if ( version != m_BindlessDescriptorTable->GetVersion() )
+    {
+        // Only the descriptors that have been written since the last copy are
+        // copied. Released descriptors are only rewritten after the GPU has
+        // finished with them, so the descriptors that are used by previous
+        // commands in the command list don't change.
+        version = m_BindlessDescriptorTable->CopyDescriptors(
+            m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), version );
+    }
+}
+
 void DynamicDescriptorHeap::CommitDescriptorTables(
     CommandList&                                                                         commandList,
     std::function<void( ID3D12GraphicsCommandList*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE )> setFunc )
@@ -173,7 +236,7 @@ void DynamicDescriptorHeap::CommitDescriptorTables(
     // Compute the number of descriptors that need to be copied
     uint32_t numDescriptorsToCommit = ComputeStaleDescriptorCount();
 
-    if ( numDescriptorsToCommit > 0 )
+    if ( numDescriptorsToCommit > 0 || m_StaleBindlessTableBitMask != 0 )
     {
         auto d3d12Device              = m_Device.GetD3D12Device();
         auto d3d12GraphicsCommandList = commandList.GetD3D12CommandList().Get();
@@ -181,17 +244,17 @@ void DynamicDescriptorHeap::CommitDescriptorTables(
 
         if ( !m_CurrentDescriptorHeap || m_NumFreeHandles < numDescriptorsToCommit )
         {
-            m_CurrentDescriptorHeap      = RequestDescriptorHeap();
-            m_CurrentCPUDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-            m_CurrentGPUDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-            m_NumFreeHandles             = m_NumDescriptorsPerHeap;
+            SetCurrentDescriptorHeap( commandList );
+        }
 
-            commandList.SetDescriptorHeap( m_DescriptorHeapType, m_CurrentDescriptorHeap.Get() );
+        DWORD bindlessRootIndex;
+        // The bindless descriptor table is always at the start of the descriptor heap.
+        while ( _BitScanForward( &bindlessRootIndex, m_StaleBindlessTableBitMask ) )
+        {
+            setFunc( d3d12GraphicsCommandList, bindlessRootIndex,
+                     m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart() );
 
-            // When updating the descriptor heap on the command list, all descriptor
-            // tables must be (re)recopied to the new descriptor heap (not just
-            // the stale descriptor tables).
-            m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+            m_StaleBindlessTableBitMask ^= ( 1 << bindlessRootIndex );
         }
 
         DWORD rootIndex;
@@ -221,6 +284,13 @@ void DynamicDescriptorHeap::CommitDescriptorTables(
             m_StaleDescriptorTableBitMask ^= ( 1 << rootIndex );
         }
     }
+
+    // Resources may have been added to the bindless descriptor table since the
+    // last draw or dispatch.
+    if ( m_StagedBindlessTableBitMask != 0 )
+    {
+        UpdateBindlessDescriptors();
+    }
 }
 
 void DynamicDescriptorHeap::CommitInlineDescriptors(
@@ -268,17 +338,7 @@ D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor( CommandList&
 {
     if ( !m_CurrentDescriptorHeap || m_NumFreeHandles < 1 )
     {
-        m_CurrentDescriptorHeap      = RequestDescriptorHeap();
-        m_CurrentCPUDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-        m_CurrentGPUDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-        m_NumFreeHandles             = m_NumDescriptorsPerHeap;
-
-        comandList.SetDescriptorHeap( m_DescriptorHeapType, m_CurrentDescriptorHeap.Get() );
-
-        // When updating the descriptor heap on the command list, all descriptor
-        // tables must be (re)recopied to the new descriptor heap (not just
-        // the stale descriptor tables).
-        m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+        SetCurrentDescriptorHeap( comandList );
     }
 
     auto d3d12Device = m_Device.GetD3D12Device();
@@ -305,6 +365,9 @@ void DynamicDescriptorHeap::Reset()
     m_StaleCBVBitMask             = 0;
     m_StaleSRVBitMask             = 0;
     m_StaleUAVBitMask             = 0;
+    m_BindlessTableBitMask        = 0;
+    m_StagedBindlessTableBitMask  = 0;
+    m_StaleBindlessTableBitMask   = 0;
 
     // Reset the descriptor cache
     for ( int i = 0; i < MaxDescriptorTables; ++i )
@@ -0,0 +1,108 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/IndirectDrawBuilder.h>
+
+using namespace dx12lib;
+
+IndirectDrawBuilder::ArgumentDescs IndirectDrawBuilder::GetArgumentDescs( uint32_t drawConstantsRootParameterIndex,
+                                                                          uint32_t vertexBufferSlot )
+{
+    ArgumentDescs argumentDescs = {};
+
+    argumentDescs[0].Type                             = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+    argumentDescs[0].Constant.RootParameterIndex      = drawConstantsRootParameterIndex;
+    argumentDescs[0].Constant.DestOffsetIn32BitValues = 0;
+    argumentDescs[0].Constant.Num32BitValuesToSet     = sizeof( IndirectDrawConstants ) / 4;
+
+    argumentDescs[1].Type              = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+    argumentDescs[1].VertexBuffer.Slot = vertexBufferSlot;
+
+    argumentDescs[2].Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+
+    argumentDescs[3].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+    return argumentDescs;
+}
+
+IndirectDrawBuilder::IndirectDrawBuilder( uint32_t numBuckets )
+: m_NumDraws( 0 )
+{
+    SetNumBuckets( numBuckets );
+}
+
+void IndirectDrawBuilder::SetNumBuckets( uint32_t numBuckets )
+{
+    assert( numBuckets > 0 );
+
+    m_BucketDraws.resize( numBuckets );
+    m_Buckets.resize( numBuckets );
+    Clear();
+}
+
+void IndirectDrawBuilder::Clear()
+{
+    for ( auto& draws: m_BucketDraws )
+    {
+        draws.clear();
+    }
+
+    for ( auto& bucket: m_Buckets )
+    {
+        bucket.FirstCommand = 0;
+        bucket.NumCommands  = 0;
+    }
+
+    m_Commands.clear();
+    m_NumDraws = 0;
+}
+
+void IndirectDrawBuilder::Reserve( size_t numDraws )
+{
+    m_Commands.reserve( numDraws );
+}
+
+void IndirectDrawBuilder::AddDraw( uint32_t bucket, const IndirectDrawCommand& command )
+{
+    assert( bucket < m_BucketDraws.size() );
+
+    m_BucketDraws[bucket].push_back( command );
+    ++m_NumDraws;
+}
+
+void IndirectDrawBuilder::AddDraw( uint32_t bucket, uint32_t materialIndex, uint32_t transformIndex,
+                                   const D3D12_VERTEX_BUFFER_VIEW& vertexBufferView,
+                                   const D3D12_INDEX_BUFFER_VIEW& indexBufferView, uint32_t indexCount,
+                                   uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex )
+{
+    IndirectDrawCommand command;
+    command.DrawConstants.MaterialIndex                = materialIndex;
+    command.DrawConstants.TransformIndex               = transformIndex;
+    command.VertexBufferView                           = vertexBufferView;
+    command.IndexBufferView                            = indexBufferView;
+    command.DrawIndexedArguments.IndexCountPerInstance = indexCount;
+    command.DrawIndexedArguments.InstanceCount         = instanceCount;
+    command.DrawIndexedArguments.StartIndexLocation    = startIndex;
+    command.DrawIndexedArguments.BaseVertexLocation    = baseVertex;
+    command.DrawIndexedArguments.StartInstanceLocation = 0;
+
+    AddDraw( bucket, command );
+}
+
+void IndirectDrawBuilder::Build()
+{
+    // The draws are already grouped by bucket so building the commands is a
+    // copy of each bucket to its final position in the command list.
+    m_Commands.resize( m_NumDraws );
+
+    uint32_t firstCommand = 0;
+    for ( size_t i = 0; i < m_Buckets.size(); ++i )
+    {
+        const auto& draws = m_BucketDraws[i];
+
+        m_Buckets[i].FirstCommand = firstCommand;
+        m_Buckets[i].NumCommands  = static_cast<uint32_t>( draws.size() );
+
+        std::copy( draws.begin(), draws.end(), m_Commands.begin() + firstCommand );
+        firstCommand += m_Buckets[i].NumCommands;
+    }
+}
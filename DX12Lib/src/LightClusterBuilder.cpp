@@ -0,0 +1,404 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/LightClusterBuilder.h>
+
+using namespace dx12lib;
+
+LightClusterBuilder::LightClusterBuilder( uint32_t numClustersX, uint32_t numClustersY, uint32_t numClustersZ )
+: m_NumClustersX( std::max( numClustersX, 1u ) )
+, m_NumClustersY( std::max( numClustersY, 1u ) )
+, m_NumClustersZ( std::max( numClustersZ, 1u ) )
+, m_Constants {}
+{
+    // Default to a 45 degree vertical field of view.
+    SetProjectionMatrix( XMMatrixPerspectiveFovLH( XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f ) );
+}
+
+float LightClusterBuilder::GetLightRange( const XMFLOAT4& color, float constantAttenuation, float linearAttenuation,
+                                          float quadraticAttenuation, float intensity )
+{
+    float k = 256.0f * intensity * std::max( { color.x, color.y, color.z, 0.0f } );
+
+    // Solve: q * d^2 + l * d + c = k
+    if ( quadraticAttenuation > 0.0f )
+    {
+        float discriminant =
+            linearAttenuation * linearAttenuation - 4.0f * quadraticAttenuation * ( constantAttenuation - k );
+        return discriminant > 0.0f ?
+                   std::max( ( -linearAttenuation + std::sqrt( discriminant ) ) / ( 2.0f * quadraticAttenuation ),
+                             0.0f ) :
+                   0.0f;
+    }
+    if ( linearAttenuation > 0.0f )
+    {
+        return std::max( ( k - constantAttenuation ) / linearAttenuation, 0.0f );
+    }
+
+    // The light is not attenuated.
+    return InfiniteRange;
+}
+
+void XM_CALLCONV LightClusterBuilder::SetProjectionMatrix( FXMMATRIX projectionMatrix )
+{
+    XMFLOAT4X4 p;
+    XMStoreFloat4x4( &p, projectionMatrix );
+
+    if ( !m_SliceDepths.empty() && memcmp( &p, &m_ProjectionMatrix, sizeof( XMFLOAT4X4 ) ) == 0 )
+    {
+        return;
+    }
+
+    m_ProjectionMatrix = p;
+
+    // For a left-handed perspective projection:
+    // _33 = f / ( f - n ) and _43 = -n * f / ( f - n ).
+    float nearZ = -p._43 / p._33;
+    float farZ  = p._43 / ( 1.0f - p._33 );
+
+    if ( !( nearZ > 0.0f ) || !( farZ > nearZ ) )
+    {
+        throw std::exception( "LightClusterBuilder requires a perspective projection matrix with a finite far plane." );
+    }
+
+    float logDepthRange = std::log( farZ / nearZ );
+
+    m_Constants.ProjectionScale = { p._11, p._22, p._31, p._32 };
+    m_Constants.NumClustersX    = m_NumClustersX;
+    m_Constants.NumClustersY    = m_NumClustersY;
+    m_Constants.NumClustersZ    = m_NumClustersZ;
+    m_Constants.DepthSliceScale = m_NumClustersZ / logDepthRange;
+    m_Constants.DepthSliceBias  = -( m_NumClustersZ * std::log( nearZ ) / logDepthRange );
+    m_Constants.NearZ           = nearZ;
+    m_Constants.FarZ            = farZ;
+
+    UpdateClusterBounds();
+}
+
+void LightClusterBuilder::UpdateClusterBounds()
+{
+    const float nearZ = m_Constants.NearZ;
+    const float farZ  = m_Constants.FarZ;
+
+    m_SliceDepths.resize( m_NumClustersZ + 1 );
+    for ( uint32_t z = 0; z <= m_NumClustersZ; ++z )
+    {
+        m_SliceDepths[z] = nearZ * std::pow( farZ / nearZ, static_cast<float>( z ) / m_NumClustersZ );
+    }
+    // Avoid gaps between the last slice and the far plane due to rounding.
+    m_SliceDepths[0]              = nearZ;
+    m_SliceDepths[m_NumClustersZ] = farZ;
+
+    // View space extents of a tile boundary (in normalized device coordinates) between two depths.
+    auto getExtents = []( float ndc0, float ndc1, float scale, float offset, float depth0, float depth1 ) {
+        float e[4] = { depth0 * ( ndc0 - offset ) / scale, depth0 * ( ndc1 - offset ) / scale,
+                       depth1 * ( ndc0 - offset ) / scale, depth1 * ( ndc1 - offset ) / scale };
+
+        return XMFLOAT2( *std::min_element( e, e + 4 ), *std::max_element( e, e + 4 ) );
+    };
+
+    const auto& scale = m_Constants.ProjectionScale;
+
+    m_ColumnBounds.resize( m_NumClustersZ * m_NumClustersX );
+    m_RowBounds.resize( m_NumClustersZ * m_NumClustersY );
+
+    for ( uint32_t z = 0; z < m_NumClustersZ; ++z )
+    {
+        float depth0 = m_SliceDepths[z];
+        float depth1 = m_SliceDepths[z + 1];
+
+        for ( uint32_t x = 0; x < m_NumClustersX; ++x )
+        {
+            float ndc0 = -1.0f + 2.0f * x / m_NumClustersX;
+            float ndc1 = -1.0f + 2.0f * ( x + 1 ) / m_NumClustersX;
+
+            m_ColumnBounds[z * m_NumClustersX + x] = getExtents( ndc0, ndc1, scale.x, scale.z, depth0, depth1 );
+        }
+
+        for ( uint32_t y = 0; y < m_NumClustersY; ++y )
+        {
+            float ndc0 = -1.0f + 2.0f * y / m_NumClustersY;
+            float ndc1 = -1.0f + 2.0f * ( y + 1 ) / m_NumClustersY;
+
+            m_RowBounds[z * m_NumClustersY + y] = getExtents( ndc0, ndc1, scale.y, scale.w, depth0, depth1 );
+        }
+    }
+}
+
+void LightClusterBuilder::ClearLights()
+{
+    m_PointLights.clear();
+    m_SpotLights.clear();
+}
+
+void LightClusterBuilder::AddPointLight( const XMFLOAT3& positionVS, float range )
+{
+    m_PointLights.push_back( { positionVS, range } );
+}
+
+void LightClusterBuilder::AddSpotLight( const XMFLOAT3& positionVS, const XMFLOAT3& directionVS, float range,
+                                        float spotAngle )
+{
+    Cone cone;
+    cone.Bounds    = { positionVS, range };
+    cone.Direction = directionVS;
+    cone.CosAngle  = std::cos( spotAngle );
+    cone.SinAngle  = std::sin( spotAngle );
+
+    m_SpotLights.push_back( cone );
+}
+
+LightClusterBuilder::AABB LightClusterBuilder::GetClusterBounds( uint32_t x, uint32_t y, uint32_t z ) const
+{
+    const auto& column = m_ColumnBounds[z * m_NumClustersX + x];
+    const auto& row    = m_RowBounds[z * m_NumClustersY + y];
+
+    return { { column.x, row.x, m_SliceDepths[z] }, { column.y, row.y, m_SliceDepths[z + 1] } };
+}
+
+bool LightClusterBuilder::Intersects( const Sphere& sphere, const AABB& bounds )
+{
+    const float* c    = &sphere.Center.x;
+    const float* bMin = &bounds.Min.x;
+    const float* bMax = &bounds.Max.x;
+
+    float distanceSq = 0.0f;
+    for ( int i = 0; i < 3; ++i )
+    {
+        float d = c[i] < bMin[i] ? bMin[i] - c[i] : ( c[i] > bMax[i] ? c[i] - bMax[i] : 0.0f );
+        distanceSq += d * d;
+    }
+
+    return sphere.Radius >= InfiniteRange || distanceSq <= sphere.Radius * sphere.Radius;
+}
+
+bool LightClusterBuilder::Intersects( const Cone& cone, const AABB& bounds )
+{
+    if ( !Intersects( cone.Bounds, bounds ) )
+    {
+        return false;
+    }
+
+    // The cone test is only valid for cones that are narrower than a hemisphere.
+    if ( cone.CosAngle <= 0.0f )
+    {
+        return true;
+    }
+
+    // Test the bounding sphere of the cluster against the cone.
+    // See: https://bartwronski.com/2017/04/13/cull-that-cone/
+    XMVECTOR boundsMin = XMLoadFloat3( &bounds.Min );
+    XMVECTOR boundsMax = XMLoadFloat3( &bounds.Max );
+    XMVECTOR center    = ( boundsMin + boundsMax ) * 0.5f;
+    float    radius    = XMVectorGetX( XMVector3Length( boundsMax - center ) );
+
+    XMVECTOR v          = center - XMLoadFloat3( &cone.Bounds.Center );
+    float    vLenSq     = XMVectorGetX( XMVector3LengthSq( v ) );
+    float    v1Len      = XMVectorGetX( XMVector3Dot( v, XMLoadFloat3( &cone.Direction ) ) );
+    float    distToCone =
+        cone.CosAngle * std::sqrt( std::max( vLenSq - v1Len * v1Len, 0.0f ) ) - v1Len * cone.SinAngle;
+
+    bool angleCull = distToCone > radius;
+    bool frontCull = cone.Bounds.Radius < InfiniteRange && v1Len > radius + cone.Bounds.Radius;
+    bool backCull  = v1Len < -radius;
+
+    return !( angleCull || frontCull || backCull );
+}
+
+template<typename Light>
+void LightClusterBuilder::AssignLight( const Light& light, const Sphere& bounds, uint32_t lightIndex )
+{
+    const XMFLOAT3& c = bounds.Center;
+    const float     r = bounds.Radius;
+
+    bool isInfinite = r >= InfiniteRange;
+
+    // Find the range of slices that overlap the bounding sphere.
+    uint32_t z0 = 0;
+    uint32_t z1 = m_NumClustersZ;
+    if ( !isInfinite )
+    {
+        while ( z0 < m_NumClustersZ && m_SliceDepths[z0 + 1] < c.z - r )
+        {
+            ++z0;
+        }
+        while ( z1 > z0 && m_SliceDepths[z1 - 1] > c.z + r )
+        {
+            --z1;
+        }
+    }
+
+    for ( uint32_t z = z0; z < z1; ++z )
+    {
+        // The columns and rows of a slice are sorted, so only the ones that
+        // overlap the bounding sphere need to be tested.
+        const XMFLOAT2* columns = &m_ColumnBounds[z * m_NumClustersX];
+        const XMFLOAT2* rows    = &m_RowBounds[z * m_NumClustersY];
+
+        uint32_t x0 = 0;
+        uint32_t x1 = m_NumClustersX;
+        uint32_t y0 = 0;
+        uint32_t y1 = m_NumClustersY;
+        if ( !isInfinite )
+        {
+            while ( x0 < m_NumClustersX && columns[x0].y < c.x - r )
+            {
+                ++x0;
+            }
+            while ( x1 > x0 && columns[x1 - 1].x > c.x + r )
+            {
+                --x1;
+            }
+            while ( y0 < m_NumClustersY && rows[y0].y < c.y - r )
+            {
+                ++y0;
+            }
+            while ( y1 > y0 && rows[y1 - 1].x > c.y + r )
+            {
+                --y1;
+            }
+        }
+
+        for ( uint32_t y = y0; y < y1; ++y )
+        {
+            for ( uint32_t x = x0; x < x1; ++x )
+            {
+                ++m_Statistics.NumIntersectionTests;
+                if ( Intersects( light, GetClusterBounds( x, y, z ) ) )
+                {
+                    m_ClusterLights.push_back( { ( z * m_NumClustersY + y ) * m_NumClustersX + x, lightIndex } );
+                }
+            }
+        }
+    }
+}
+
+void LightClusterBuilder::Build()
+{
+    m_ClusterLights.clear();
+    m_Statistics.NumIntersectionTests = 0;
+
+    uint32_t numPointLights = static_cast<uint32_t>( m_PointLights.size() );
+
+    for ( uint32_t i = 0; i < numPointLights; ++i )
+    {
+        AssignLight( m_PointLights[i], m_PointLights[i], i );
+    }
+
+    for ( uint32_t i = 0; i < static_cast<uint32_t>( m_SpotLights.size() ); ++i )
+    {
+        AssignLight( m_SpotLights[i], m_SpotLights[i].Bounds, numPointLights + i );
+    }
+
+    BuildClusters();
+}
+
+void LightClusterBuilder::BuildBruteForce()
+{
+    m_ClusterLights.clear();
+    m_Statistics.NumIntersectionTests = 0;
+
+    uint32_t numPointLights = static_cast<uint32_t>( m_PointLights.size() );
+
+    for ( uint32_t z = 0; z < m_NumClustersZ; ++z )
+    {
+        for ( uint32_t y = 0; y < m_NumClustersY; ++y )
+        {
+            for ( uint32_t x = 0; x < m_NumClustersX; ++x )
+            {
+                uint32_t clusterIndex = ( z * m_NumClustersY + y ) * m_NumClustersX + x;
+                AABB     bounds       = GetClusterBounds( x, y, z );
+
+                for ( uint32_t i = 0; i < numPointLights; ++i )
+                {
+                    ++m_Statistics.NumIntersectionTests;
+                    if ( Intersects( m_PointLights[i], bounds ) )
+                    {
+                        m_ClusterLights.push_back( { clusterIndex, i } );
+                    }
+                }
+
+                for ( uint32_t i = 0; i < static_cast<uint32_t>( m_SpotLights.size() ); ++i )
+                {
+                    ++m_Statistics.NumIntersectionTests;
+                    if ( Intersects( m_SpotLights[i], bounds ) )
+                    {
+                        m_ClusterLights.push_back( { clusterIndex, numPointLights + i } );
+                    }
+                }
+            }
+        }
+    }
+
+    BuildClusters();
+}
+
+void LightClusterBuilder::BuildClusters()
+{
+    const uint32_t numClusters    = GetNumClusters();
+    const uint32_t numPointLights = static_cast<uint32_t>( m_PointLights.size() );
+
+    m_Clusters.assign( numClusters, LightCluster { 0, 0 } );
+
+    // Count the point and spot lights of each cluster.
+    for ( const auto& clusterLight: m_ClusterLights )
+    {
+        auto& cluster = m_Clusters[clusterLight.ClusterIndex];
+        cluster.Counts += clusterLight.LightIndex < numPointLights ? 1 : ( 1 << 16 );
+    }
+
+    // Compute the offsets (prefix sum of the counts).
+    uint32_t offset              = 0;
+    uint32_t maxLightsPerCluster = 0;
+    for ( auto& cluster: m_Clusters )
+    {
+        uint32_t numLights = cluster.GetNumPointLights() + cluster.GetNumSpotLights();
+
+        cluster.Offset = offset;
+        offset += numLights;
+        maxLightsPerCluster = std::max( maxLightsPerCluster, numLights );
+    }
+
+    // Scatter the light indices. Both builders generate the pairs of a cluster
+    // in increasing light order (point lights before spot lights) so the
+    // scatter keeps the light indices of each cluster sorted.
+    std::vector<uint32_t> cursors( numClusters );
+    for ( uint32_t i = 0; i < numClusters; ++i )
+    {
+        cursors[i] = m_Clusters[i].Offset;
+    }
+
+    m_LightIndices.resize( m_ClusterLights.size() );
+    for ( const auto& clusterLight: m_ClusterLights )
+    {
+        uint32_t lightIndex = clusterLight.LightIndex;
+        // Spot light indices index the spot light buffer.
+        m_LightIndices[cursors[clusterLight.ClusterIndex]++] =
+            lightIndex < numPointLights ? lightIndex : lightIndex - numPointLights;
+    }
+
+    m_Statistics.NumClusters         = numClusters;
+    m_Statistics.NumPointLights      = numPointLights;
+    m_Statistics.NumSpotLights       = static_cast<uint32_t>( m_SpotLights.size() );
+    m_Statistics.NumLightIndices     = static_cast<uint32_t>( m_LightIndices.size() );
+    m_Statistics.MaxLightsPerCluster = maxLightsPerCluster;
+}
+
+uint32_t LightClusterBuilder::GetClusterIndex( const XMFLOAT3& positionVS ) const
+{
+    const auto& scale = m_Constants.ProjectionScale;
+
+    float z    = std::max( positionVS.z, m_Constants.NearZ );
+    float ndcX = ( positionVS.x * scale.x + z * scale.z ) / z;
+    float ndcY = ( positionVS.y * scale.y + z * scale.w ) / z;
+
+    auto clampCluster = []( float f, uint32_t numClusters ) {
+        return static_cast<uint32_t>( std::clamp( std::floor( f ), 0.0f, static_cast<float>( numClusters - 1 ) ) );
+    };
+
+    uint32_t x = clampCluster( ( ndcX * 0.5f + 0.5f ) * m_NumClustersX, m_NumClustersX );
+    uint32_t y = clampCluster( ( ndcY * 0.5f + 0.5f ) * m_NumClustersY, m_NumClustersY );
+    uint32_t s =
+        clampCluster( std::log( z ) * m_Constants.DepthSliceScale + m_Constants.DepthSliceBias, m_NumClustersZ );
+
+    return ( s * m_NumClustersY + y ) * m_NumClustersX + x;
+}
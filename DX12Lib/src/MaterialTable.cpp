@@ -0,0 +1,110 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/MaterialTable.h>
+
+#include <dx12lib/BindlessDescriptorTable.h>
+#include <dx12lib/CommandList.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/StructuredBuffer.h>
+#include <dx12lib/Texture.h>
+
+using namespace dx12lib;
+
+MaterialTable::MaterialTable( Device& device )
+: m_Device( device )
+, m_IsDirty( false )
+{}
+
+MaterialTable::~MaterialTable() {}
+
+uint32_t MaterialTable::GetMaterialIndex( const std::shared_ptr<Material>& material )
+{
+    assert( material );
+
+    auto iter = m_Materials.find( material.get() );
+    if ( iter == m_Materials.end() )
+    {
+        MaterialRecord record;
+        record.Instance = material;
+        record.Index    = static_cast<uint32_t>( m_Entries.size() );
+
+        MaterialTableEntry entry;
+        std::fill( std::begin( entry.TextureIndices ), std::end( entry.TextureIndices ),
+                   BindlessDescriptorTable::InvalidIndex );
+        m_Entries.push_back( entry );
+
+        iter = m_Materials.emplace( material.get(), record ).first;
+
+        // Make sure the new entry is written.
+        m_IsDirty = true;
+    }
+
+    UpdateEntry( iter->second );
+
+    return iter->second.Index;
+}
+
+void MaterialTable::UpdateEntry( MaterialRecord& record )
+{
+    MaterialTableEntry& entry      = m_Entries[record.Index];
+    const auto&         properties = record.Instance->GetMaterialProperties();
+
+    if ( memcmp( &entry.Properties, &properties, sizeof( MaterialProperties ) ) != 0 )
+    {
+        entry.Properties = properties;
+        m_IsDirty        = true;
+    }
+
+    auto& bindlessDescriptorTable = m_Device.GetBindlessDescriptorTable();
+
+    for ( size_t i = 0; i < static_cast<size_t>( Material::TextureType::NumTypes ); ++i )
+    {
+        auto texture = record.Instance->GetTexture( static_cast<Material::TextureType>( i ) );
+        if ( texture == record.Textures[i] )
+        {
+            continue;
+        }
+
+        // Textures that are no longer used by the material remain registered in
+        // the bindless descriptor table since they may still be used by
+        // previous draw calls.
+        entry.TextureIndices[i] = bindlessDescriptorTable.RegisterTexture( texture );
+        record.Textures[i]      = texture;
+        m_IsDirty               = true;
+
+        if ( texture && m_Textures.insert( texture ).second )
+        {
+            m_PendingTextures.push_back( texture );
+        }
+    }
+}
+
+bool MaterialTable::Commit( CommandList& commandList )
+{
+    for ( auto& texture: m_PendingTextures )
+    {
+        commandList.TransitionBarrier( texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE );
+    }
+    m_PendingTextures.clear();
+
+    if ( !m_IsDirty )
+    {
+        return false;
+    }
+
+    // A new buffer is created so that draw calls that already reference the
+    // previous buffer are not affected.
+    m_MaterialBuffer = commandList.CopyStructuredBuffer( m_Entries );
+    m_IsDirty        = false;
+
+    return true;
+}
+
+void MaterialTable::TransitionTextures( CommandList& commandList )
+{
+    for ( auto& texture: m_Textures )
+    {
+        commandList.TransitionBarrier( texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE );
+    }
+    m_PendingTextures.clear();
+}
@@ -0,0 +1,705 @@
+#include <dx12lib/MipGenerator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Texels are filtered as 4 floats at a time.
+#if defined( _M_X64 ) || defined( __x86_64__ ) || defined( __SSE2__ )
+    #define MIPGENERATOR_SSE 1
+    #include <xmmintrin.h>
+#else
+    #define MIPGENERATOR_SSE 0
+#endif
+
+using namespace dx12lib;
+
+// The rows of a mip are filtered in bands of this many rows.
+static const uint32_t BandHeight = 32;
+
+// Mips with fewer texels than this are filtered on the calling thread.
+static const size_t MinParallelTexels = 64 * 1024;
+
+// The width (in texels of the destination mip) and alpha of the Kaiser filter.
+static const double KaiserWidth = 3.0;
+static const double KaiserAlpha = 4.0;
+
+namespace
+{
+enum class ComponentType
+{
+    UNorm8,
+    UNorm16,
+    Float16,
+    Float32,
+};
+
+struct FormatInfo
+{
+    ComponentType Type;
+    uint32_t      NumChannels;
+    bool          IsSRGB;
+};
+
+// The source texels (index into the source row) and weights of each destination texel.
+struct Filter1D
+{
+    std::vector<uint32_t> First;  // Index of the first tap of each destination texel.
+    std::vector<uint32_t> Index;
+    std::vector<float>    Weight;
+
+    uint32_t NumTaps( uint32_t i ) const
+    {
+        return First[i + 1] - First[i];
+    }
+};
+}  // namespace
+
+static bool GetFormatInfo( DXGI_FORMAT format, FormatInfo& info )
+{
+    switch ( format )
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+        info = { ComponentType::UNorm8, 4, false };
+        return true;
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        info = { ComponentType::UNorm8, 4, true };
+        return true;
+    case DXGI_FORMAT_R8G8_UNORM:
+        info = { ComponentType::UNorm8, 2, false };
+        return true;
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_A8_UNORM:
+        info = { ComponentType::UNorm8, 1, false };
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        info = { ComponentType::UNorm16, 4, false };
+        return true;
+    case DXGI_FORMAT_R16G16_UNORM:
+        info = { ComponentType::UNorm16, 2, false };
+        return true;
+    case DXGI_FORMAT_R16_UNORM:
+        info = { ComponentType::UNorm16, 1, false };
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        info = { ComponentType::Float16, 4, false };
+        return true;
+    case DXGI_FORMAT_R16G16_FLOAT:
+        info = { ComponentType::Float16, 2, false };
+        return true;
+    case DXGI_FORMAT_R16_FLOAT:
+        info = { ComponentType::Float16, 1, false };
+        return true;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        info = { ComponentType::Float32, 4, false };
+        return true;
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+        info = { ComponentType::Float32, 3, false };
+        return true;
+    case DXGI_FORMAT_R32G32_FLOAT:
+        info = { ComponentType::Float32, 2, false };
+        return true;
+    case DXGI_FORMAT_R32_FLOAT:
+        info = { ComponentType::Float32, 1, false };
+        return true;
+    default:
+        return false;
+    }
+}
+
+static float HalfToFloat( uint16_t h )
+{
+    uint32_t sign     = ( h & 0x8000u ) << 16;
+    uint32_t exponent = ( h >> 10 ) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+
+    uint32_t bits;
+    if ( exponent == 0x1f )
+    {
+        // Infinity or NaN.
+        bits = sign | 0x7f800000u | ( mantissa << 13 );
+    }
+    else if ( exponent != 0 )
+    {
+        bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+    }
+    else if ( mantissa != 0 )
+    {
+        // Denormal, normalize it.
+        exponent = 113;
+        while ( ( mantissa & 0x400 ) == 0 )
+        {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | ( exponent << 23 ) | ( ( mantissa & 0x3ff ) << 13 );
+    }
+    else
+    {
+        bits = sign;
+    }
+
+    float f;
+    std::memcpy( &f, &bits, sizeof( f ) );
+    return f;
+}
+
+// Round to nearest even.
+static uint16_t FloatToHalf( float f )
+{
+    uint32_t bits;
+    std::memcpy( &bits, &f, sizeof( bits ) );
+
+    uint16_t sign     = static_cast<uint16_t>( ( bits >> 16 ) & 0x8000u );
+    uint32_t absolute = bits & 0x7fffffffu;
+
+    if ( absolute >= 0x7f800000u )
+    {
+        // Infinity or NaN (keep NaNs quiet).
+        return sign | 0x7c00 | ( absolute > 0x7f800000u ? 0x200 : 0 );
+    }
+    if ( absolute >= 0x477ff000u )
+    {
+        // Rounds to a value larger than the largest half.
+        return sign | 0x7c00;
+    }
+    if ( absolute < 0x38800000u )
+    {
+        // Denormal (or zero): shift the mantissa (with the implicit 1) into place and round.
+        if ( absolute < 0x33000000u )
+        {
+            return sign;
+        }
+        uint32_t exponent = absolute >> 23;
+        uint32_t mantissa = ( absolute & 0x7fffffu ) | 0x800000u;
+        uint32_t shift    = 126 - exponent;
+        uint32_t half     = mantissa >> shift;
+        uint32_t rest     = mantissa & ( ( 1u << shift ) - 1 );
+        uint32_t midpoint = 1u << ( shift - 1 );
+        if ( rest > midpoint || ( rest == midpoint && ( half & 1 ) ) )
+        {
+            ++half;
+        }
+        return sign | static_cast<uint16_t>( half );
+    }
+
+    uint32_t half = ( absolute - 0x38000000u ) >> 13;
+    uint32_t rest = absolute & 0x1fff;
+    if ( rest > 0x1000 || ( rest == 0x1000 && ( half & 1 ) ) )
+    {
+        ++half;
+    }
+    return sign | static_cast<uint16_t>( half );
+}
+
+static double SRGBToLinear( double x )
+{
+    return x <= 0.04045 ? x / 12.92 : std::pow( ( x + 0.055 ) / 1.055, 2.4 );
+}
+
+// Linear values of the 8 bit sRGB values.
+static const float* GetSRGBToLinearTable()
+{
+    static const std::vector<float> table = [] {
+        std::vector<float> t( 256 );
+        for ( int i = 0; i < 256; ++i )
+        {
+            t[i] = static_cast<float>( SRGBToLinear( i / 255.0 ) );
+        }
+        return t;
+    }();
+
+    return table.data();
+}
+
+static const float* GetUNorm8ToFloatTable()
+{
+    static const std::vector<float> table = [] {
+        std::vector<float> t( 256 );
+        for ( int i = 0; i < 256; ++i )
+        {
+            t[i] = i / 255.0f;
+        }
+        return t;
+    }();
+
+    return table.data();
+}
+
+// The linear values halfway between two 8 bit sRGB values. Encoding a linear
+// value is a search in this table, which gives the same result as rounding the
+// exact sRGB value (except for values within float precision of a threshold).
+static const float* GetSRGBThresholdTable()
+{
+    static const std::vector<float> table = [] {
+        std::vector<float> t( 255 );
+        for ( int i = 0; i < 255; ++i )
+        {
+            t[i] = static_cast<float>( SRGBToLinear( ( i + 0.5 ) / 255.0 ) );
+        }
+        return t;
+    }();
+
+    return table.data();
+}
+
+// The sRGB value of the smallest float with the same upper 16 bits, for the
+// floats in [0, 1]. The sRGB value changes by at most 1 between two entries,
+// so the search in the threshold table takes at most 1 step.
+static const uint8_t* GetLinearToSRGBTable()
+{
+    static const std::vector<uint8_t> table = [] {
+        const float*         thresholds = GetSRGBThresholdTable();
+        std::vector<uint8_t> t( ( 0x3f800000u >> 16 ) + 1 );
+        for ( uint32_t i = 0; i < t.size(); ++i )
+        {
+            uint32_t bits = i << 16;
+            float    f;
+            std::memcpy( &f, &bits, sizeof( f ) );
+            t[i] = static_cast<uint8_t>( std::upper_bound( thresholds, thresholds + 255, f ) - thresholds );
+        }
+        return t;
+    }();
+
+    return table.data();
+}
+
+static inline uint8_t LinearToSRGB8( float x, const uint8_t* table, const float* thresholds )
+{
+    if ( !( x > 0.0f ) )
+    {
+        return 0;
+    }
+    if ( x >= 1.0f )
+    {
+        return 255;
+    }
+
+    uint32_t bits;
+    std::memcpy( &bits, &x, sizeof( bits ) );
+
+    uint32_t code = table[bits >> 16];
+    while ( code < 255 && x >= thresholds[code] )
+    {
+        ++code;
+    }
+    return static_cast<uint8_t>( code );
+}
+
+static inline float Saturate( float x )
+{
+    return x < 0.0f ? 0.0f : ( x > 1.0f ? 1.0f : x );
+}
+
+// Decode a row of texels to RGBA floats (missing channels are 0, alpha is 1).
+static void DecodeRow( const FormatInfo& info, const void* src, uint32_t width, float* dst )
+{
+    const uint32_t numChannels = info.NumChannels;
+
+    if ( numChannels < 4 )
+    {
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            float* texel = dst + x * 4;
+            texel[0] = texel[1] = texel[2] = 0.0f;
+            texel[3]                       = 1.0f;
+        }
+    }
+
+    switch ( info.Type )
+    {
+    case ComponentType::UNorm8:
+    {
+        // Alpha is always linear.
+        auto         s          = static_cast<const uint8_t*>( src );
+        const float* toLinear   = info.IsSRGB ? GetSRGBToLinearTable() : GetUNorm8ToFloatTable();
+        const float* toFloat    = GetUNorm8ToFloatTable();
+        const float* tables[4]  = { toLinear, toLinear, toLinear, toFloat };
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                dst[x * 4 + c] = tables[c][s[x * numChannels + c]];
+            }
+        }
+    }
+    break;
+    case ComponentType::UNorm16:
+    {
+        auto s = static_cast<const uint16_t*>( src );
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                dst[x * 4 + c] = s[x * numChannels + c] * ( 1.0f / 65535.0f );
+            }
+        }
+    }
+    break;
+    case ComponentType::Float16:
+    {
+        auto s = static_cast<const uint16_t*>( src );
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                dst[x * 4 + c] = HalfToFloat( s[x * numChannels + c] );
+            }
+        }
+    }
+    break;
+    case ComponentType::Float32:
+    {
+        auto s = static_cast<const float*>( src );
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                dst[x * 4 + c] = s[x * numChannels + c];
+            }
+        }
+    }
+    break;
+    }
+}
+
+static void EncodeRow( const FormatInfo& info, const float* src, uint32_t width, void* dst )
+{
+    const uint32_t numChannels = info.NumChannels;
+
+    switch ( info.Type )
+    {
+    case ComponentType::UNorm8:
+    {
+        auto           d          = static_cast<uint8_t*>( dst );
+        const uint8_t* toSRGB     = GetLinearToSRGBTable();
+        const float*   thresholds = GetSRGBThresholdTable();
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                float v = src[x * 4 + c];
+                d[x * numChannels + c] = ( info.IsSRGB && c < 3 )
+                                             ? LinearToSRGB8( v, toSRGB, thresholds )
+                                             : static_cast<uint8_t>( Saturate( v ) * 255.0f + 0.5f );
+            }
+        }
+    }
+    break;
+    case ComponentType::UNorm16:
+    {
+        auto d = static_cast<uint16_t*>( dst );
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                d[x * numChannels + c] = static_cast<uint16_t>( Saturate( src[x * 4 + c] ) * 65535.0f + 0.5f );
+            }
+        }
+    }
+    break;
+    case ComponentType::Float16:
+    {
+        auto d = static_cast<uint16_t*>( dst );
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                d[x * numChannels + c] = FloatToHalf( src[x * 4 + c] );
+            }
+        }
+    }
+    break;
+    case ComponentType::Float32:
+    {
+        auto d = static_cast<float*>( dst );
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            for ( uint32_t c = 0; c < numChannels; ++c )
+            {
+                d[x * numChannels + c] = src[x * 4 + c];
+            }
+        }
+    }
+    break;
+    }
+}
+
+// Zeroth order modified Bessel function of the first kind.
+static double BesselI0( double x )
+{
+    double sum  = 1.0;
+    double term = 1.0;
+    for ( int k = 1; k < 50; ++k )
+    {
+        double t = x / ( 2.0 * k );
+        term *= t * t;
+        sum += term;
+        if ( term < sum * 1e-12 )
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+static double Kaiser( double t )
+{
+    if ( std::abs( t ) >= KaiserWidth )
+    {
+        return 0.0;
+    }
+
+    const double pi   = 3.14159265358979323846;
+    double       sinc = t == 0.0 ? 1.0 : std::sin( pi * t ) / ( pi * t );
+    double       r    = t / KaiserWidth;
+
+    return sinc * BesselI0( KaiserAlpha * std::sqrt( 1.0 - r * r ) ) / BesselI0( KaiserAlpha );
+}
+
+static void BuildFilter( uint32_t srcSize, uint32_t dstSize, MipFilter filter, bool wrap, Filter1D& result )
+{
+    result.First.clear();
+    result.Index.clear();
+    result.Weight.clear();
+
+    auto address = [&]( int64_t i ) {
+        int64_t size = srcSize;
+        i            = wrap ? ( ( i % size ) + size ) % size : std::min( std::max<int64_t>( i, 0 ), size - 1 );
+        return static_cast<uint32_t>( i );
+    };
+
+    const double       scale = static_cast<double>( srcSize ) / dstSize;
+    std::vector<double> weights;
+
+    for ( uint32_t i = 0; i < dstSize; ++i )
+    {
+        result.First.push_back( static_cast<uint32_t>( result.Index.size() ) );
+        weights.clear();
+
+        if ( filter == MipFilter::Box )
+        {
+            // Area of the source texels that are covered by the destination texel.
+            double lo = i * scale;
+            double hi = ( i + 1 ) * scale;
+            for ( auto s = static_cast<int64_t>( std::floor( lo ) ); s < hi; ++s )
+            {
+                double w = std::min( hi, s + 1.0 ) - std::max( lo, static_cast<double>( s ) );
+                if ( w > 0.0 )
+                {
+                    result.Index.push_back( address( s ) );
+                    weights.push_back( w );
+                }
+            }
+        }
+        else
+        {
+            double center = ( i + 0.5 ) * scale;
+            double radius = KaiserWidth * scale;
+            for ( auto s = static_cast<int64_t>( std::floor( center - radius ) ); s <= center + radius; ++s )
+            {
+                double w = Kaiser( ( s + 0.5 - center ) / scale );
+                if ( w != 0.0 )
+                {
+                    result.Index.push_back( address( s ) );
+                    weights.push_back( w );
+                }
+            }
+        }
+
+        double sum = 0.0;
+        for ( double w: weights )
+        {
+            sum += w;
+        }
+        for ( double w: weights )
+        {
+            result.Weight.push_back( static_cast<float>( w / sum ) );
+        }
+    }
+
+    result.First.push_back( static_cast<uint32_t>( result.Index.size() ) );
+}
+
+static void FilterRow( const Filter1D& filter, const float* src, uint32_t dstWidth, float* dst )
+{
+    for ( uint32_t x = 0; x < dstWidth; ++x )
+    {
+        const uint32_t* index  = filter.Index.data() + filter.First[x];
+        const float*    weight = filter.Weight.data() + filter.First[x];
+        uint32_t        n      = filter.NumTaps( x );
+
+#if MIPGENERATOR_SSE
+        __m128 sum = _mm_setzero_ps();
+        for ( uint32_t t = 0; t < n; ++t )
+        {
+            sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( src + index[t] * 4 ), _mm_set1_ps( weight[t] ) ) );
+        }
+        _mm_storeu_ps( dst + x * 4, sum );
+#else
+        float sum[4] = {};
+        for ( uint32_t t = 0; t < n; ++t )
+        {
+            for ( int c = 0; c < 4; ++c )
+            {
+                sum[c] += src[index[t] * 4 + c] * weight[t];
+            }
+        }
+        std::memcpy( dst + x * 4, sum, sizeof( sum ) );
+#endif
+    }
+}
+
+// dst += src * weight for a row of RGBA texels.
+static void AccumulateRow( const float* src, float weight, uint32_t width, float* dst )
+{
+#if MIPGENERATOR_SSE
+    __m128 w = _mm_set1_ps( weight );
+    for ( uint32_t x = 0; x < width; ++x )
+    {
+        __m128 texel = _mm_mul_ps( _mm_loadu_ps( src + x * 4 ), w );
+        _mm_storeu_ps( dst + x * 4, _mm_add_ps( _mm_loadu_ps( dst + x * 4 ), texel ) );
+    }
+#else
+    for ( uint32_t i = 0; i < width * 4; ++i )
+    {
+        dst[i] += src[i] * weight;
+    }
+#endif
+}
+
+// Call func( i ) for i in [0, count) on up to numThreads threads (including the calling thread).
+template<typename Func>
+static void ParallelFor( size_t count, uint32_t numThreads, const Func& func )
+{
+    std::atomic<size_t> next( 0 );
+    auto                worker = [&]() {
+        for ( size_t i = next++; i < count; i = next++ )
+        {
+            func( i );
+        }
+    };
+
+    numThreads = static_cast<uint32_t>( std::min<size_t>( numThreads, count ) );
+
+    std::vector<std::thread> threads;
+    for ( uint32_t i = 1; i < numThreads; ++i )
+    {
+        threads.emplace_back( worker );
+    }
+    worker();
+
+    for ( auto& thread: threads )
+    {
+        thread.join();
+    }
+}
+
+MipGenerator::MipGenerator( const MipGenerationSettings& settings )
+: m_Settings( settings )
+{
+    if ( m_Settings.NumThreads == 0 )
+    {
+        m_Settings.NumThreads = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+}
+
+bool MipGenerator::IsFormatSupported( DXGI_FORMAT format )
+{
+    FormatInfo info;
+    return GetFormatInfo( format, info );
+}
+
+uint32_t MipGenerator::GetNumMips( uint32_t width, uint32_t height )
+{
+    uint32_t numMips = 1;
+    while ( width > 1 || height > 1 )
+    {
+        width  = std::max( width / 2, 1u );
+        height = std::max( height / 2, 1u );
+        ++numMips;
+    }
+    return numMips;
+}
+
+void MipGenerator::Generate( DXGI_FORMAT format, const Subresource* subresources, uint32_t numMips,
+                             uint32_t arraySize ) const
+{
+    // std::exception( const char* ) is an MSVC extension, so the standard exceptions are used to keep this
+    // file portable.
+    FormatInfo info;
+    if ( !GetFormatInfo( format, info ) )
+    {
+        throw std::invalid_argument( "Mip generation is not supported for the format." );
+    }
+
+    for ( uint32_t mip = 1; mip < numMips; ++mip )
+    {
+        const Subresource& src = subresources[mip - 1];
+        const Subresource& dst = subresources[mip];
+        if ( dst.Width != std::max( src.Width / 2, 1u ) || dst.Height != std::max( src.Height / 2, 1u ) )
+        {
+            throw std::invalid_argument( "Invalid mip size." );
+        }
+
+        Filter1D filterX, filterY;
+        BuildFilter( src.Width, dst.Width, m_Settings.Filter, m_Settings.Wrap, filterX );
+        BuildFilter( src.Height, dst.Height, m_Settings.Filter, m_Settings.Wrap, filterY );
+
+        uint32_t numBands   = ( dst.Height + BandHeight - 1 ) / BandHeight;
+        size_t   numTexels  = static_cast<size_t>( dst.Width ) * dst.Height * arraySize;
+        uint32_t numThreads = numTexels < MinParallelTexels ? 1 : m_Settings.NumThreads;
+
+        ParallelFor( static_cast<size_t>( numBands ) * arraySize, numThreads, [&]( size_t item ) {
+            uint32_t           slice     = static_cast<uint32_t>( item / numBands );
+            uint32_t           firstRow  = static_cast<uint32_t>( item % numBands ) * BandHeight;
+            uint32_t           lastRow   = std::min( firstRow + BandHeight, dst.Height );
+            const Subresource& srcMip    = subresources[slice * numMips + mip - 1];
+            const Subresource& dstMip    = subresources[slice * numMips + mip];
+            size_t             srcFloats = static_cast<size_t>( srcMip.Width ) * 4;
+            size_t             dstFloats = static_cast<size_t>( dstMip.Width ) * 4;
+
+            // Filter the source rows that are used by the band horizontally.
+            std::vector<uint32_t> srcRows( filterY.Index.begin() + filterY.First[firstRow],
+                                           filterY.Index.begin() + filterY.First[lastRow] );
+            std::sort( srcRows.begin(), srcRows.end() );
+            srcRows.erase( std::unique( srcRows.begin(), srcRows.end() ), srcRows.end() );
+
+            // The scratch buffers are reused for all bands that are filtered on the same thread.
+            thread_local std::vector<float> decodedRow, filteredRows, dstRow;
+            decodedRow.resize( std::max( decodedRow.size(), srcFloats ) );
+            filteredRows.resize( std::max( filteredRows.size(), srcRows.size() * dstFloats ) );
+            dstRow.resize( std::max( dstRow.size(), dstFloats ) );
+
+            for ( size_t i = 0; i < srcRows.size(); ++i )
+            {
+                auto row = static_cast<const uint8_t*>( srcMip.Pixels ) + srcRows[i] * srcMip.RowPitch;
+                DecodeRow( info, row, srcMip.Width, decodedRow.data() );
+                FilterRow( filterX, decodedRow.data(), dstMip.Width, filteredRows.data() + i * dstFloats );
+            }
+
+            // Then filter the band vertically.
+            for ( uint32_t y = firstRow; y < lastRow; ++y )
+            {
+                std::fill( dstRow.begin(), dstRow.begin() + dstFloats, 0.0f );
+                for ( uint32_t t = filterY.First[y]; t < filterY.First[y + 1]; ++t )
+                {
+                    size_t i = std::lower_bound( srcRows.begin(), srcRows.end(), filterY.Index[t] ) - srcRows.begin();
+                    AccumulateRow( filteredRows.data() + i * dstFloats, filterY.Weight[t], dstMip.Width,
+                                   dstRow.data() );
+                }
+
+                EncodeRow( info, dstRow.data(), dstMip.Width,
+                           static_cast<uint8_t*>( dstMip.Pixels ) + y * dstMip.RowPitch );
+            }
+        } );
+    }
+}
@@ -0,0 +1,1681 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/NullDevice.h>
+
+#include <dx12lib/Defines.h>
+#include <dx12lib/Helpers.h>
+
+using namespace dx12lib;
+
+NullDeviceCounters::NullDeviceCounters()
+{
+    for ( auto& counter: m_Counters )
+    {
+        counter.store( 0, std::memory_order_relaxed );
+    }
+}
+
+void NullDeviceCounters::Reset()
+{
+    for ( size_t i = 0; i < static_cast<size_t>( NullDeviceCounter::NumCounters ); ++i )
+    {
+        if ( i != static_cast<size_t>( NullDeviceCounter::NumCPUHeapBytes ) )
+        {
+            m_Counters[i].store( 0, std::memory_order_relaxed );
+        }
+    }
+}
+
+const char* NullDeviceCounters::GetName( NullDeviceCounter counter )
+{
+    switch ( counter )
+    {
+    case NullDeviceCounter::CreateResource:
+        return "CreateResource";
+    case NullDeviceCounter::CreateHeap:
+        return "CreateHeap";
+    case NullDeviceCounter::CreatePipelineState:
+        return "CreatePipelineState";
+    case NullDeviceCounter::CreateView:
+        return "CreateView";
+    case NullDeviceCounter::CopyDescriptors:
+        return "CopyDescriptors";
+    case NullDeviceCounter::NumCopiedDescriptors:
+        return "NumCopiedDescriptors";
+    case NullDeviceCounter::ExecuteCommandLists:
+        return "ExecuteCommandLists";
+    case NullDeviceCounter::NumExecutedCommandLists:
+        return "NumExecutedCommandLists";
+    case NullDeviceCounter::Signal:
+        return "Signal";
+    case NullDeviceCounter::UpdateTileMappings:
+        return "UpdateTileMappings";
+    case NullDeviceCounter::ResetCommandList:
+        return "ResetCommandList";
+    case NullDeviceCounter::CloseCommandList:
+        return "CloseCommandList";
+    case NullDeviceCounter::Draw:
+        return "Draw";
+    case NullDeviceCounter::Dispatch:
+        return "Dispatch";
+    case NullDeviceCounter::ExecuteIndirect:
+        return "ExecuteIndirect";
+    case NullDeviceCounter::Copy:
+        return "Copy";
+    case NullDeviceCounter::Clear:
+        return "Clear";
+    case NullDeviceCounter::ResourceBarrier:
+        return "ResourceBarrier";
+    case NullDeviceCounter::NumBarriers:
+        return "NumBarriers";
+    case NullDeviceCounter::SetPipelineState:
+        return "SetPipelineState";
+    case NullDeviceCounter::SetRootSignature:
+        return "SetRootSignature";
+    case NullDeviceCounter::SetRootArguments:
+        return "SetRootArguments";
+    case NullDeviceCounter::SetDescriptorHeaps:
+        return "SetDescriptorHeaps";
+    case NullDeviceCounter::SetInputAssembler:
+        return "SetInputAssembler";
+    case NullDeviceCounter::SetRasterizerState:
+        return "SetRasterizerState";
+    case NullDeviceCounter::OtherCommand:
+        return "OtherCommand";
+    case NullDeviceCounter::NumCPUHeapBytes:
+        return "NumCPUHeapBytes";
+    default:
+        return "Unknown";
+    }
+}
+
+namespace
+{
+
+// The fake descriptor handles and GPU virtual addresses that are handed out by
+// the null device start at these addresses. They are never dereferenced.
+const uint64_t FirstCPUDescriptorHandle = 0x0000100000000000ull;
+const uint64_t FirstGPUDescriptorHandle = 0x0000200000000000ull;
+const uint64_t FirstGPUVirtualAddress   = 0x0000300000000000ull;
+
+const UINT DescriptorHandleIncrementSize = 32;
+
+// Compute the layout of the subresources of a resource in a buffer. Mirrors
+// ID3D12Device::GetCopyableFootprints (for non-planar formats).
+void ComputeCopyableFootprints( const D3D12_RESOURCE_DESC& desc, UINT firstSubresource, UINT numSubresources,
+                                UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows,
+                                UINT64* rowSizeInBytes, UINT64* totalBytes )
+{
+    if ( desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER )
+    {
+        if ( numSubresources > 0 )
+        {
+            if ( layouts )
+            {
+                layouts[0].Offset    = baseOffset;
+                layouts[0].Footprint = { DXGI_FORMAT_UNKNOWN, static_cast<UINT>( desc.Width ), 1, 1,
+                                         static_cast<UINT>(
+                                             Math::AlignUp( desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT ) ) };
+            }
+            if ( numRows )
+                numRows[0] = 1;
+            if ( rowSizeInBytes )
+                rowSizeInBytes[0] = desc.Width;
+        }
+        if ( totalBytes )
+            *totalBytes = numSubresources > 0 ? desc.Width : 0;
+
+        return;
+    }
+
+    const bool   isCompressed = DirectX::IsCompressed( desc.Format );
+    const UINT16 mipLevels    = std::max<UINT16>( desc.MipLevels, 1 );
+
+    UINT64 offset = 0;
+    UINT64 total  = 0;
+
+    for ( UINT i = 0; i < numSubresources; ++i )
+    {
+        UINT mip    = ( firstSubresource + i ) % mipLevels;
+        UINT width  = std::max( static_cast<UINT>( desc.Width >> mip ), 1u );
+        UINT height = std::max( desc.Height >> mip, 1u );
+        UINT depth  = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D
+                          ? std::max( static_cast<UINT>( desc.DepthOrArraySize >> mip ), 1u )
+                          : 1u;
+
+        size_t rowPitch, slicePitch;
+        if ( FAILED( DirectX::ComputePitch( desc.Format, width, height, rowPitch, slicePitch ) ) )
+        {
+            rowPitch   = width;
+            slicePitch = static_cast<size_t>( width ) * height;
+        }
+
+        UINT   rows         = static_cast<UINT>( slicePitch / rowPitch );
+        UINT64 alignedPitch = Math::AlignUp( static_cast<UINT64>( rowPitch ), D3D12_TEXTURE_DATA_PITCH_ALIGNMENT );
+
+        offset = Math::AlignUp( offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT );
+
+        if ( layouts )
+        {
+            layouts[i].Offset    = baseOffset + offset;
+            layouts[i].Footprint = { desc.Format, isCompressed ? Math::AlignUp( width, 4 ) : width,
+                                     isCompressed ? Math::AlignUp( height, 4 ) : height, depth,
+                                     static_cast<UINT>( alignedPitch ) };
+        }
+        if ( numRows )
+            numRows[i] = rows;
+        if ( rowSizeInBytes )
+            rowSizeInBytes[i] = rowPitch;
+
+        total = offset + alignedPitch * ( static_cast<UINT64>( rows ) * depth - 1 ) + rowPitch;
+        offset += alignedPitch * rows * depth;
+    }
+
+    if ( totalBytes )
+        *totalBytes = total;
+}
+
+// Describes the tiles of a subresource in a reserved resource. Mirrors
+// ID3D12Device::GetResourceTiling for standard swizzle 2D textures.
+struct ResourceTiling
+{
+    D3D12_TILE_SHAPE      TileShape;
+    D3D12_PACKED_MIP_INFO PackedMipInfo;
+    UINT                  NumTilesPerSlice;
+    UINT                  NumTiles;
+};
+
+ResourceTiling ComputeResourceTiling( const D3D12_RESOURCE_DESC& desc )
+{
+    ResourceTiling tiling = {};
+
+    if ( desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER )
+    {
+        tiling.TileShape        = { D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES, 1, 1 };
+        tiling.NumTilesPerSlice = static_cast<UINT>(
+            Math::AlignUp( desc.Width, D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES ) /
+            D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES );
+        tiling.NumTiles = tiling.NumTilesPerSlice;
+        return tiling;
+    }
+
+    // Standard tiles are 64KB. Compressed formats are tiled in blocks of 4x4 texels.
+    const bool isCompressed = DirectX::IsCompressed( desc.Format );
+    const UINT blockSize    = isCompressed ? 4 : 1;
+    const UINT elementSize =
+        std::max<UINT>( static_cast<UINT>( DirectX::BitsPerPixel( desc.Format ) * blockSize * blockSize / 8 ), 1u );
+
+    UINT log2ElementSize = 0;
+    while ( ( 2u << log2ElementSize ) <= elementSize )
+    {
+        ++log2ElementSize;
+    }
+
+    const UINT tileWidthInElements  = 256u >> ( log2ElementSize / 2 );
+    const UINT tileHeightInElements = D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES / ( 1u << log2ElementSize ) /
+                                      tileWidthInElements;
+
+    tiling.TileShape = { tileWidthInElements * blockSize, tileHeightInElements * blockSize, 1 };
+
+    const UINT16 mipLevels     = std::max<UINT16>( desc.MipLevels, 1 );
+    UINT64       packedMipSize = 0;
+
+    for ( UINT16 mip = 0; mip < mipLevels; ++mip )
+    {
+        UINT width  = std::max( static_cast<UINT>( desc.Width >> mip ), 1u );
+        UINT height = std::max( desc.Height >> mip, 1u );
+
+        // Mips that are smaller than a tile (in either dimension) are packed.
+        if ( tiling.PackedMipInfo.NumPackedMips == 0 && width >= tiling.TileShape.WidthInTexels &&
+             height >= tiling.TileShape.HeightInTexels )
+        {
+            ++tiling.PackedMipInfo.NumStandardMips;
+            tiling.NumTilesPerSlice += ( ( width + tiling.TileShape.WidthInTexels - 1 ) /
+                                         tiling.TileShape.WidthInTexels ) *
+                                       ( ( height + tiling.TileShape.HeightInTexels - 1 ) /
+                                         tiling.TileShape.HeightInTexels );
+        }
+        else
+        {
+            size_t rowPitch, slicePitch;
+            if ( FAILED( DirectX::ComputePitch( desc.Format, width, height, rowPitch, slicePitch ) ) )
+            {
+                slicePitch = static_cast<size_t>( width ) * height;
+            }
+
+            ++tiling.PackedMipInfo.NumPackedMips;
+            packedMipSize += slicePitch;
+        }
+    }
+
+    if ( tiling.PackedMipInfo.NumPackedMips > 0 )
+    {
+        tiling.PackedMipInfo.NumTilesForPackedMips = static_cast<UINT>(
+            Math::AlignUp( packedMipSize, D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES ) /
+            D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES );
+        tiling.PackedMipInfo.StartTileIndexInOverallResource = tiling.NumTilesPerSlice;
+        tiling.NumTilesPerSlice += tiling.PackedMipInfo.NumTilesForPackedMips;
+    }
+
+    UINT arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+    tiling.NumTiles = tiling.NumTilesPerSlice * arraySize;
+
+    return tiling;
+}
+
+bool IsCPUAccessible( const D3D12_HEAP_PROPERTIES& heapProperties )
+{
+    switch ( heapProperties.Type )
+    {
+    case D3D12_HEAP_TYPE_UPLOAD:
+    case D3D12_HEAP_TYPE_READBACK:
+        return true;
+    case D3D12_HEAP_TYPE_CUSTOM:
+        return heapProperties.CPUPageProperty == D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE ||
+               heapProperties.CPUPageProperty == D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+    default:
+        return false;
+    }
+}
+
+template<typename T, typename... Args>
+HRESULT CreateObject( REFIID riid, void** ppvObject, Args&&... args )
+{
+    // A null output pointer only validates the parameters.
+    if ( !ppvObject )
+        return S_FALSE;
+
+    ComPtr<T> object;
+    object.Attach( new T( std::forward<Args>( args )... ) );
+
+    return object->QueryInterface( riid, ppvObject );
+}
+
+// Implements IUnknown and ID3D12Object for the null objects.
+// BaseInterfaces are the interfaces (other than IUnknown and ID3D12Object)
+// that Interface derives from.
+template<typename Interface, typename... BaseInterfaces>
+class NullObject : public Interface
+{
+public:
+    NullObject()
+    : m_RefCount( 1 )
+    {}
+
+    virtual ~NullObject() = default;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface( REFIID riid, void** ppvObject ) override
+    {
+        if ( !ppvObject )
+            return E_POINTER;
+
+        if ( riid == __uuidof( Interface ) || riid == __uuidof( IUnknown ) || riid == __uuidof( ID3D12Object ) ||
+             ( ( riid == __uuidof( BaseInterfaces ) ) || ... ) )
+        {
+            AddRef();
+            *ppvObject = static_cast<Interface*>( this );
+            return S_OK;
+        }
+
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++m_RefCount;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG refCount = --m_RefCount;
+        if ( refCount == 0 )
+        {
+            delete this;
+        }
+
+        return refCount;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetPrivateData( REFGUID guid, UINT* pDataSize, void* pData ) override
+    {
+        if ( !pDataSize )
+            return E_INVALIDARG;
+
+        std::lock_guard<std::mutex> lock( m_PrivateDataMutex );
+
+        for ( const auto& privateData: m_PrivateData )
+        {
+            if ( privateData.first == guid )
+            {
+                UINT size = static_cast<UINT>( privateData.second.size() );
+                if ( pData )
+                {
+                    if ( *pDataSize < size )
+                    {
+                        *pDataSize = size;
+                        return DXGI_ERROR_MORE_DATA;
+                    }
+                    std::memcpy( pData, privateData.second.data(), size );
+                }
+                *pDataSize = size;
+
+                return S_OK;
+            }
+        }
+
+        *pDataSize = 0;
+        return DXGI_ERROR_NOT_FOUND;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateData( REFGUID guid, UINT DataSize, const void* pData ) override
+    {
+        std::lock_guard<std::mutex> lock( m_PrivateDataMutex );
+
+        auto iter = std::find_if( m_PrivateData.begin(), m_PrivateData.end(),
+                                  [&guid]( const auto& privateData ) { return privateData.first == guid; } );
+        if ( iter != m_PrivateData.end() )
+        {
+            m_PrivateData.erase( iter );
+        }
+
+        if ( pData )
+        {
+            auto data = static_cast<const uint8_t*>( pData );
+            m_PrivateData.emplace_back( guid, std::vector<uint8_t>( data, data + DataSize ) );
+        }
+
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateDataInterface( REFGUID guid, const IUnknown* pData ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetName( LPCWSTR Name ) override
+    {
+        UINT size = Name ? static_cast<UINT>( ( std::wcslen( Name ) + 1 ) * sizeof( wchar_t ) ) : 0;
+        return SetPrivateData( WKPDID_D3DDebugObjectNameW, size, Name );
+    }
+
+private:
+    std::atomic<ULONG> m_RefCount;
+
+    std::mutex                                         m_PrivateDataMutex;
+    std::vector<std::pair<GUID, std::vector<uint8_t>>> m_PrivateData;
+};
+
+// Implements ID3D12DeviceChild for the objects that are created by the null device.
+template<typename Interface, typename... BaseInterfaces>
+class NullDeviceChild : public NullObject<Interface, ID3D12DeviceChild, BaseInterfaces...>
+{
+public:
+    NullDeviceChild( ID3D12Device2* device, NullDeviceCounters& counters )
+    : m_Device( device )
+    , m_Counters( counters )
+    {}
+
+    HRESULT STDMETHODCALLTYPE GetDevice( REFIID riid, void** ppvDevice ) override
+    {
+        return m_Device->QueryInterface( riid, ppvDevice );
+    }
+
+protected:
+    // Keeps the device (and the counters that are owned by the device) alive.
+    ComPtr<ID3D12Device2> m_Device;
+    NullDeviceCounters&   m_Counters;
+};
+
+class NullHeap : public NullDeviceChild<ID3D12Heap, ID3D12Pageable>
+{
+public:
+    NullHeap( ID3D12Device2* device, NullDeviceCounters& counters, const D3D12_HEAP_DESC& desc,
+              D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress )
+    : NullDeviceChild( device, counters )
+    , m_Desc( desc )
+    , m_GPUVirtualAddress( gpuVirtualAddress )
+    {}
+
+    D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+    {
+        return m_Desc;
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const
+    {
+        return m_GPUVirtualAddress;
+    }
+
+private:
+    D3D12_HEAP_DESC           m_Desc;
+    D3D12_GPU_VIRTUAL_ADDRESS m_GPUVirtualAddress;
+};
+
+class NullResource : public NullDeviceChild<ID3D12Resource, ID3D12Pageable>
+{
+public:
+    /**
+     * @param heapProperties The properties of the heap that the resource is
+     * created in (nullptr for reserved resources).
+     */
+    NullResource( ID3D12Device2* device, NullDeviceCounters& counters, const D3D12_RESOURCE_DESC& desc,
+                  const D3D12_HEAP_PROPERTIES* heapProperties, D3D12_HEAP_FLAGS heapFlags,
+                  D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress, UINT64 sizeInBytes )
+    : NullDeviceChild( device, counters )
+    , m_Desc( desc )
+    , m_HeapProperties( heapProperties ? *heapProperties : D3D12_HEAP_PROPERTIES {} )
+    , m_HeapFlags( heapFlags )
+    , m_bIsReserved( heapProperties == nullptr )
+    , m_GPUVirtualAddress( gpuVirtualAddress )
+    , m_CPUMemorySize( 0 )
+    {
+        if ( heapProperties && IsCPUAccessible( *heapProperties ) )
+        {
+            m_CPUMemorySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? desc.Width : sizeInBytes;
+            m_CPUMemory     = std::make_unique<uint8_t[]>( static_cast<size_t>( m_CPUMemorySize ) );
+            m_Counters.Add( NullDeviceCounter::NumCPUHeapBytes, m_CPUMemorySize );
+        }
+    }
+
+    virtual ~NullResource()
+    {
+        m_Counters.Subtract( NullDeviceCounter::NumCPUHeapBytes, m_CPUMemorySize );
+    }
+
+    HRESULT STDMETHODCALLTYPE Map( UINT Subresource, const D3D12_RANGE* pReadRange, void** ppData ) override
+    {
+        // Only buffers (and the first subresource of textures) can be mapped.
+        if ( !m_CPUMemory || Subresource != 0 )
+            return E_INVALIDARG;
+
+        if ( ppData )
+            *ppData = m_CPUMemory.get();
+
+        return S_OK;
+    }
+
+    void STDMETHODCALLTYPE Unmap( UINT Subresource, const D3D12_RANGE* pWrittenRange ) override {}
+
+    D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc() override
+    {
+        return m_Desc;
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress() override
+    {
+        return m_Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? m_GPUVirtualAddress : 0;
+    }
+
+    HRESULT STDMETHODCALLTYPE WriteToSubresource( UINT DstSubresource, const D3D12_BOX* pDstBox, const void* pSrcData,
+                                                  UINT SrcRowPitch, UINT SrcDepthPitch ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE ReadFromSubresource( void* pDstData, UINT DstRowPitch, UINT DstDepthPitch,
+                                                   UINT SrcSubresource, const D3D12_BOX* pSrcBox ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetHeapProperties( D3D12_HEAP_PROPERTIES* pHeapProperties,
+                                                 D3D12_HEAP_FLAGS*      pHeapFlags ) override
+    {
+        if ( m_bIsReserved )
+            return E_INVALIDARG;
+
+        if ( pHeapProperties )
+            *pHeapProperties = m_HeapProperties;
+        if ( pHeapFlags )
+            *pHeapFlags = m_HeapFlags;
+
+        return S_OK;
+    }
+
+private:
+    D3D12_RESOURCE_DESC       m_Desc;
+    D3D12_HEAP_PROPERTIES     m_HeapProperties;
+    D3D12_HEAP_FLAGS          m_HeapFlags;
+    bool                      m_bIsReserved;
+    D3D12_GPU_VIRTUAL_ADDRESS m_GPUVirtualAddress;
+
+    // Upload and readback resources are backed by CPU memory.
+    std::unique_ptr<uint8_t[]> m_CPUMemory;
+    UINT64                     m_CPUMemorySize;
+};
+
+class NullCommandAllocator : public NullDeviceChild<ID3D12CommandAllocator, ID3D12Pageable>
+{
+public:
+    NullCommandAllocator( ID3D12Device2* device, NullDeviceCounters& counters )
+    : NullDeviceChild( device, counters )
+    {}
+
+    HRESULT STDMETHODCALLTYPE Reset() override
+    {
+        return S_OK;
+    }
+};
+
+class NullFence : public NullDeviceChild<ID3D12Fence, ID3D12Pageable>
+{
+public:
+    NullFence( ID3D12Device2* device, NullDeviceCounters& counters, UINT64 initialValue )
+    : NullDeviceChild( device, counters )
+    , m_CompletedValue( initialValue )
+    {}
+
+    UINT64 STDMETHODCALLTYPE GetCompletedValue() override
+    {
+        return m_CompletedValue.load( std::memory_order_acquire );
+    }
+
+    HRESULT STDMETHODCALLTYPE SetEventOnCompletion( UINT64 Value, HANDLE hEvent ) override
+    {
+        std::unique_lock<std::mutex> lock( m_Mutex );
+
+        if ( m_CompletedValue >= Value )
+        {
+            if ( hEvent )
+                ::SetEvent( hEvent );
+        }
+        else if ( hEvent )
+        {
+            m_PendingEvents.emplace_back( Value, hEvent );
+        }
+        else
+        {
+            // Without an event, the call blocks until the fence is signaled.
+            m_Signaled.wait( lock, [this, Value]() { return m_CompletedValue >= Value; } );
+        }
+
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Signal( UINT64 Value ) override
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+
+        m_CompletedValue.store( Value, std::memory_order_release );
+
+        auto iter = m_PendingEvents.begin();
+        while ( iter != m_PendingEvents.end() )
+        {
+            if ( iter->first <= Value )
+            {
+                ::SetEvent( iter->second );
+                iter = m_PendingEvents.erase( iter );
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+
+        m_Signaled.notify_all();
+
+        return S_OK;
+    }
+
+private:
+    std::atomic_uint64_t m_CompletedValue;
+
+    std::mutex                             m_Mutex;
+    std::condition_variable                m_Signaled;
+    std::vector<std::pair<UINT64, HANDLE>> m_PendingEvents;
+};
+
+class NullPipelineState : public NullDeviceChild<ID3D12PipelineState, ID3D12Pageable>
+{
+public:
+    NullPipelineState( ID3D12Device2* device, NullDeviceCounters& counters )
+    : NullDeviceChild( device, counters )
+    {}
+
+    HRESULT STDMETHODCALLTYPE GetCachedBlob( ID3DBlob** ppBlob ) override
+    {
+        return DXGI_ERROR_UNSUPPORTED;
+    }
+};
+
+class NullRootSignature : public NullDeviceChild<ID3D12RootSignature>
+{
+public:
+    NullRootSignature( ID3D12Device2* device, NullDeviceCounters& counters )
+    : NullDeviceChild( device, counters )
+    {}
+};
+
+class NullCommandSignature : public NullDeviceChild<ID3D12CommandSignature, ID3D12Pageable>
+{
+public:
+    NullCommandSignature( ID3D12Device2* device, NullDeviceCounters& counters )
+    : NullDeviceChild( device, counters )
+    {}
+};
+
+class NullDescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap, ID3D12Pageable>
+{
+public:
+    NullDescriptorHeap( ID3D12Device2* device, NullDeviceCounters& counters, const D3D12_DESCRIPTOR_HEAP_DESC& desc,
+                        D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle, D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle )
+    : NullDeviceChild( device, counters )
+    , m_Desc( desc )
+    , m_CPUHandle( cpuHandle )
+    , m_GPUHandle( gpuHandle )
+    {}
+
+    D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+    {
+        return m_Desc;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart() override
+    {
+        return m_CPUHandle;
+    }
+
+    D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart() override
+    {
+        return m_GPUHandle;
+    }
+
+private:
+    D3D12_DESCRIPTOR_HEAP_DESC  m_Desc;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_CPUHandle;
+    D3D12_GPU_DESCRIPTOR_HANDLE m_GPUHandle;
+};
+
+class NullCommandList
+: public NullDeviceChild<ID3D12GraphicsCommandList2, ID3D12GraphicsCommandList1, ID3D12GraphicsCommandList,
+                         ID3D12CommandList>
+{
+public:
+    NullCommandList( ID3D12Device2* device, NullDeviceCounters& counters, D3D12_COMMAND_LIST_TYPE type )
+    : NullDeviceChild( device, counters )
+    , m_Type( type )
+    , m_Counts {}
+    {}
+
+    virtual ~NullCommandList()
+    {
+        FlushCounts();
+    }
+
+    D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() override
+    {
+        return m_Type;
+    }
+
+    // ID3D12GraphicsCommandList
+
+    HRESULT STDMETHODCALLTYPE Close() override
+    {
+        Count( NullDeviceCounter::CloseCommandList );
+        FlushCounts();
+
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Reset( ID3D12CommandAllocator* pAllocator,
+                                     ID3D12PipelineState*    pInitialState ) override
+    {
+        Count( NullDeviceCounter::ResetCommandList );
+
+        return S_OK;
+    }
+
+    void STDMETHODCALLTYPE ClearState( ID3D12PipelineState* pPipelineState ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE DrawInstanced( UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation,
+                                          UINT StartInstanceLocation ) override
+    {
+        Count( NullDeviceCounter::Draw );
+    }
+
+    void STDMETHODCALLTYPE DrawIndexedInstanced( UINT IndexCountPerInstance, UINT InstanceCount,
+                                                 UINT StartIndexLocation, INT BaseVertexLocation,
+                                                 UINT StartInstanceLocation ) override
+    {
+        Count( NullDeviceCounter::Draw );
+    }
+
+    void STDMETHODCALLTYPE Dispatch( UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ ) override
+    {
+        Count( NullDeviceCounter::Dispatch );
+    }
+
+    void STDMETHODCALLTYPE CopyBufferRegion( ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer,
+                                             UINT64 SrcOffset, UINT64 NumBytes ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE CopyTextureRegion( const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ,
+                                              const D3D12_TEXTURE_COPY_LOCATION* pSrc,
+                                              const D3D12_BOX*                   pSrcBox ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE CopyResource( ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE CopyTiles( ID3D12Resource* pTiledResource,
+                                      const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate,
+                                      const D3D12_TILE_REGION_SIZE* pTileRegionSize, ID3D12Resource* pBuffer,
+                                      UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE ResolveSubresource( ID3D12Resource* pDstResource, UINT DstSubresource,
+                                               ID3D12Resource* pSrcResource, UINT SrcSubresource,
+                                               DXGI_FORMAT Format ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE IASetPrimitiveTopology( D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology ) override
+    {
+        Count( NullDeviceCounter::SetInputAssembler );
+    }
+
+    void STDMETHODCALLTYPE RSSetViewports( UINT NumViewports, const D3D12_VIEWPORT* pViewports ) override
+    {
+        Count( NullDeviceCounter::SetRasterizerState );
+    }
+
+    void STDMETHODCALLTYPE RSSetScissorRects( UINT NumRects, const D3D12_RECT* pRects ) override
+    {
+        Count( NullDeviceCounter::SetRasterizerState );
+    }
+
+    void STDMETHODCALLTYPE OMSetBlendFactor( const FLOAT BlendFactor[4] ) override
+    {
+        Count( NullDeviceCounter::SetRasterizerState );
+    }
+
+    void STDMETHODCALLTYPE OMSetStencilRef( UINT StencilRef ) override
+    {
+        Count( NullDeviceCounter::SetRasterizerState );
+    }
+
+    void STDMETHODCALLTYPE SetPipelineState( ID3D12PipelineState* pPipelineState ) override
+    {
+        Count( NullDeviceCounter::SetPipelineState );
+    }
+
+    void STDMETHODCALLTYPE ResourceBarrier( UINT NumBarriers, const D3D12_RESOURCE_BARRIER* pBarriers ) override
+    {
+        Count( NullDeviceCounter::ResourceBarrier );
+        Count( NullDeviceCounter::NumBarriers, NumBarriers );
+    }
+
+    void STDMETHODCALLTYPE ExecuteBundle( ID3D12GraphicsCommandList* pCommandList ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE SetDescriptorHeaps( UINT                         NumDescriptorHeaps,
+                                               ID3D12DescriptorHeap* const* ppDescriptorHeaps ) override
+    {
+        Count( NullDeviceCounter::SetDescriptorHeaps );
+    }
+
+    void STDMETHODCALLTYPE SetComputeRootSignature( ID3D12RootSignature* pRootSignature ) override
+    {
+        Count( NullDeviceCounter::SetRootSignature );
+    }
+
+    void STDMETHODCALLTYPE SetGraphicsRootSignature( ID3D12RootSignature* pRootSignature ) override
+    {
+        Count( NullDeviceCounter::SetRootSignature );
+    }
+
+    void STDMETHODCALLTYPE SetComputeRootDescriptorTable( UINT                        RootParameterIndex,
+                                                          D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable( UINT                        RootParameterIndex,
+                                                           D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstant( UINT RootParameterIndex, UINT SrcData,
+                                                        UINT DestOffsetIn32BitValues ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant( UINT RootParameterIndex, UINT SrcData,
+                                                         UINT DestOffsetIn32BitValues ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstants( UINT RootParameterIndex, UINT Num32BitValuesToSet,
+                                                         const void* pSrcData, UINT DestOffsetIn32BitValues ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants( UINT RootParameterIndex, UINT Num32BitValuesToSet,
+                                                          const void* pSrcData, UINT DestOffsetIn32BitValues ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetComputeRootConstantBufferView( UINT                      RootParameterIndex,
+                                                             D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView( UINT                      RootParameterIndex,
+                                                              D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetComputeRootShaderResourceView( UINT                      RootParameterIndex,
+                                                             D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView( UINT                      RootParameterIndex,
+                                                              D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView( UINT                      RootParameterIndex,
+                                                              D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView( UINT                      RootParameterIndex,
+                                                               D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+    {
+        Count( NullDeviceCounter::SetRootArguments );
+    }
+
+    void STDMETHODCALLTYPE IASetIndexBuffer( const D3D12_INDEX_BUFFER_VIEW* pView ) override
+    {
+        Count( NullDeviceCounter::SetInputAssembler );
+    }
+
+    void STDMETHODCALLTYPE IASetVertexBuffers( UINT StartSlot, UINT NumViews,
+                                               const D3D12_VERTEX_BUFFER_VIEW* pViews ) override
+    {
+        Count( NullDeviceCounter::SetInputAssembler );
+    }
+
+    void STDMETHODCALLTYPE SOSetTargets( UINT StartSlot, UINT NumViews,
+                                         const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE OMSetRenderTargets( UINT                               NumRenderTargetDescriptors,
+                                               const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
+                                               BOOL                               RTsSingleHandleToDescriptorRange,
+                                               const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor ) override
+    {
+        Count( NullDeviceCounter::SetRasterizerState );
+    }
+
+    void STDMETHODCALLTYPE ClearDepthStencilView( D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView,
+                                                  D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth, UINT8 Stencil,
+                                                  UINT NumRects, const D3D12_RECT* pRects ) override
+    {
+        Count( NullDeviceCounter::Clear );
+    }
+
+    void STDMETHODCALLTYPE ClearRenderTargetView( D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView,
+                                                  const FLOAT ColorRGBA[4], UINT NumRects,
+                                                  const D3D12_RECT* pRects ) override
+    {
+        Count( NullDeviceCounter::Clear );
+    }
+
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewUint( D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap,
+                                                         D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+                                                         ID3D12Resource* pResource, const UINT Values[4],
+                                                         UINT NumRects, const D3D12_RECT* pRects ) override
+    {
+        Count( NullDeviceCounter::Clear );
+    }
+
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat( D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap,
+                                                          D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+                                                          ID3D12Resource* pResource, const FLOAT Values[4],
+                                                          UINT NumRects, const D3D12_RECT* pRects ) override
+    {
+        Count( NullDeviceCounter::Clear );
+    }
+
+    void STDMETHODCALLTYPE DiscardResource( ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion ) override
+    {
+        Count( NullDeviceCounter::Clear );
+    }
+
+    void STDMETHODCALLTYPE BeginQuery( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE EndQuery( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE ResolveQueryData( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex,
+                                             UINT NumQueries, ID3D12Resource* pDestinationBuffer,
+                                             UINT64 AlignedDestinationBufferOffset ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE SetPredication( ID3D12Resource* pBuffer, UINT64 AlignedBufferOffset,
+                                           D3D12_PREDICATION_OP Operation ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE SetMarker( UINT Metadata, const void* pData, UINT Size ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE BeginEvent( UINT Metadata, const void* pData, UINT Size ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE EndEvent() override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    void STDMETHODCALLTYPE ExecuteIndirect( ID3D12CommandSignature* pCommandSignature, UINT MaxCommandCount,
+                                            ID3D12Resource* pArgumentBuffer, UINT64 ArgumentBufferOffset,
+                                            ID3D12Resource* pCountBuffer, UINT64 CountBufferOffset ) override
+    {
+        Count( NullDeviceCounter::ExecuteIndirect );
+    }
+
+    // ID3D12GraphicsCommandList1
+
+    void STDMETHODCALLTYPE AtomicCopyBufferUINT( ID3D12Resource* pDstBuffer, UINT64 DstOffset,
+                                                 ID3D12Resource* pSrcBuffer, UINT64 SrcOffset, UINT Dependencies,
+                                                 ID3D12Resource* const*                  ppDependentResources,
+                                                 const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE AtomicCopyBufferUINT64( ID3D12Resource* pDstBuffer, UINT64 DstOffset,
+                                                   ID3D12Resource* pSrcBuffer, UINT64 SrcOffset, UINT Dependencies,
+                                                   ID3D12Resource* const* ppDependentResources,
+                                                   const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE OMSetDepthBounds( FLOAT Min, FLOAT Max ) override
+    {
+        Count( NullDeviceCounter::SetRasterizerState );
+    }
+
+    void STDMETHODCALLTYPE SetSamplePositions( UINT NumSamplesPerPixel, UINT NumPixels,
+                                               D3D12_SAMPLE_POSITION* pSamplePositions ) override
+    {
+        Count( NullDeviceCounter::SetRasterizerState );
+    }
+
+    void STDMETHODCALLTYPE ResolveSubresourceRegion( ID3D12Resource* pDstResource, UINT DstSubresource, UINT DstX,
+                                                     UINT DstY, ID3D12Resource* pSrcResource, UINT SrcSubresource,
+                                                     D3D12_RECT* pSrcRect, DXGI_FORMAT Format,
+                                                     D3D12_RESOLVE_MODE ResolveMode ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+    void STDMETHODCALLTYPE SetViewInstanceMask( UINT Mask ) override
+    {
+        Count( NullDeviceCounter::OtherCommand );
+    }
+
+    // ID3D12GraphicsCommandList2
+
+    void STDMETHODCALLTYPE WriteBufferImmediate( UINT NumParams, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER* pParams,
+                                                 const D3D12_WRITEBUFFERIMMEDIATE_MODE* pModes ) override
+    {
+        Count( NullDeviceCounter::Copy );
+    }
+
+private:
+    void Count( NullDeviceCounter counter, uint64_t value = 1 )
+    {
+        m_Counts[static_cast<size_t>( counter )] += value;
+    }
+
+    // Add the counts of the command list to the counters of the device.
+    void FlushCounts()
+    {
+        for ( size_t i = 0; i < static_cast<size_t>( NullDeviceCounter::NumCounters ); ++i )
+        {
+            if ( m_Counts[i] > 0 )
+            {
+                m_Counters.Add( static_cast<NullDeviceCounter>( i ), m_Counts[i] );
+                m_Counts[i] = 0;
+            }
+        }
+    }
+
+    D3D12_COMMAND_LIST_TYPE m_Type;
+
+    // The calls that are counted since the command list was last closed.
+    uint64_t m_Counts[static_cast<size_t>( NullDeviceCounter::NumCounters )];
+};
+
+class NullCommandQueue : public NullDeviceChild<ID3D12CommandQueue, ID3D12Pageable>
+{
+public:
+    NullCommandQueue( ID3D12Device2* device, NullDeviceCounters& counters, const D3D12_COMMAND_QUEUE_DESC& desc )
+    : NullDeviceChild( device, counters )
+    , m_Desc( desc )
+    {}
+
+    void STDMETHODCALLTYPE UpdateTileMappings( ID3D12Resource* pResource, UINT NumResourceRegions,
+                                               const D3D12_TILED_RESOURCE_COORDINATE* pResourceRegionStartCoordinates,
+                                               const D3D12_TILE_REGION_SIZE*          pResourceRegionSizes,
+                                               ID3D12Heap* pHeap, UINT NumRanges,
+                                               const D3D12_TILE_RANGE_FLAGS* pRangeFlags,
+                                               const UINT* pHeapRangeStartOffsets, const UINT* pRangeTileCounts,
+                                               D3D12_TILE_MAPPING_FLAGS Flags ) override
+    {
+        m_Counters.Add( NullDeviceCounter::UpdateTileMappings );
+    }
+
+    void STDMETHODCALLTYPE CopyTileMappings( ID3D12Resource*                        pDstResource,
+                                             const D3D12_TILED_RESOURCE_COORDINATE* pDstRegionStartCoordinate,
+                                             ID3D12Resource*                        pSrcResource,
+                                             const D3D12_TILED_RESOURCE_COORDINATE* pSrcRegionStartCoordinate,
+                                             const D3D12_TILE_REGION_SIZE*          pRegionSize,
+                                             D3D12_TILE_MAPPING_FLAGS               Flags ) override
+    {
+        m_Counters.Add( NullDeviceCounter::UpdateTileMappings );
+    }
+
+    void STDMETHODCALLTYPE ExecuteCommandLists( UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists ) override
+    {
+        m_Counters.Add( NullDeviceCounter::ExecuteCommandLists );
+        m_Counters.Add( NullDeviceCounter::NumExecutedCommandLists, NumCommandLists );
+    }
+
+    void STDMETHODCALLTYPE SetMarker( UINT Metadata, const void* pData, UINT Size ) override {}
+
+    void STDMETHODCALLTYPE BeginEvent( UINT Metadata, const void* pData, UINT Size ) override {}
+
+    void STDMETHODCALLTYPE EndEvent() override {}
+
+    HRESULT STDMETHODCALLTYPE Signal( ID3D12Fence* pFence, UINT64 Value ) override
+    {
+        m_Counters.Add( NullDeviceCounter::Signal );
+
+        // All work completes as soon as it is submitted.
+        return pFence->Signal( Value );
+    }
+
+    HRESULT STDMETHODCALLTYPE Wait( ID3D12Fence* pFence, UINT64 Value ) override
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetTimestampFrequency( UINT64* pFrequency ) override
+    {
+        LARGE_INTEGER frequency;
+        ::QueryPerformanceFrequency( &frequency );
+        *pFrequency = frequency.QuadPart;
+
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetClockCalibration( UINT64* pGpuTimestamp, UINT64* pCpuTimestamp ) override
+    {
+        LARGE_INTEGER counter;
+        ::QueryPerformanceCounter( &counter );
+        *pGpuTimestamp = counter.QuadPart;
+        *pCpuTimestamp = counter.QuadPart;
+
+        return S_OK;
+    }
+
+    D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc() override
+    {
+        return m_Desc;
+    }
+
+private:
+    D3D12_COMMAND_QUEUE_DESC m_Desc;
+};
+
+class NullD3D12Device : public NullObject<ID3D12Device2, ID3D12Device1, ID3D12Device>
+{
+public:
+    explicit NullD3D12Device( std::shared_ptr<NullDeviceCounters> counters )
+    : m_Counters( std::move( counters ) )
+    , m_NextCPUDescriptorHandle( FirstCPUDescriptorHandle )
+    , m_NextGPUDescriptorHandle( FirstGPUDescriptorHandle )
+    , m_NextGPUVirtualAddress( FirstGPUVirtualAddress )
+    {}
+
+    // ID3D12Device
+
+    UINT STDMETHODCALLTYPE GetNodeCount() override
+    {
+        return 1;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandQueue( const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid,
+                                                  void** ppCommandQueue ) override
+    {
+        return CreateObject<NullCommandQueue>( riid, ppCommandQueue, this, *m_Counters, *pDesc );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandAllocator( D3D12_COMMAND_LIST_TYPE type, REFIID riid,
+                                                      void** ppCommandAllocator ) override
+    {
+        return CreateObject<NullCommandAllocator>( riid, ppCommandAllocator, this, *m_Counters );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState( const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc,
+                                                           REFIID riid, void** ppPipelineState ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreatePipelineState );
+        return CreateObject<NullPipelineState>( riid, ppPipelineState, this, *m_Counters );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateComputePipelineState( const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid,
+                                                          void** ppPipelineState ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreatePipelineState );
+        return CreateObject<NullPipelineState>( riid, ppPipelineState, this, *m_Counters );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandList( UINT nodeMask, D3D12_COMMAND_LIST_TYPE type,
+                                                 ID3D12CommandAllocator* pCommandAllocator,
+                                                 ID3D12PipelineState* pInitialState, REFIID riid,
+                                                 void** ppCommandList ) override
+    {
+        return CreateObject<NullCommandList>( riid, ppCommandList, this, *m_Counters, type );
+    }
+
+    HRESULT STDMETHODCALLTYPE CheckFeatureSupport( D3D12_FEATURE Feature, void* pFeatureSupportData,
+                                                   UINT FeatureSupportDataSize ) override
+    {
+        switch ( Feature )
+        {
+        case D3D12_FEATURE_D3D12_OPTIONS:
+        {
+            if ( FeatureSupportDataSize != sizeof( D3D12_FEATURE_DATA_D3D12_OPTIONS ) )
+                return E_INVALIDARG;
+
+            auto options                = static_cast<D3D12_FEATURE_DATA_D3D12_OPTIONS*>( pFeatureSupportData );
+            *options                    = {};
+            options->ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+            options->TiledResourcesTier  = D3D12_TILED_RESOURCES_TIER_1;
+            options->ResourceHeapTier    = D3D12_RESOURCE_HEAP_TIER_2;
+            return S_OK;
+        }
+        case D3D12_FEATURE_ROOT_SIGNATURE:
+        {
+            if ( FeatureSupportDataSize != sizeof( D3D12_FEATURE_DATA_ROOT_SIGNATURE ) )
+                return E_INVALIDARG;
+
+            auto rootSignature            = static_cast<D3D12_FEATURE_DATA_ROOT_SIGNATURE*>( pFeatureSupportData );
+            rootSignature->HighestVersion = std::min( rootSignature->HighestVersion, D3D_ROOT_SIGNATURE_VERSION_1_1 );
+            return S_OK;
+        }
+        case D3D12_FEATURE_FORMAT_SUPPORT:
+        {
+            if ( FeatureSupportDataSize != sizeof( D3D12_FEATURE_DATA_FORMAT_SUPPORT ) )
+                return E_INVALIDARG;
+
+            // Every format supports everything.
+            auto formatSupport      = static_cast<D3D12_FEATURE_DATA_FORMAT_SUPPORT*>( pFeatureSupportData );
+            formatSupport->Support1 = static_cast<D3D12_FORMAT_SUPPORT1>( ~0u );
+            formatSupport->Support2 = static_cast<D3D12_FORMAT_SUPPORT2>( ~0u );
+            return S_OK;
+        }
+        case D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS:
+        {
+            if ( FeatureSupportDataSize != sizeof( D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS ) )
+                return E_INVALIDARG;
+
+            auto qualityLevels = static_cast<D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS*>( pFeatureSupportData );
+            qualityLevels->NumQualityLevels = qualityLevels->SampleCount <= 8 ? 1 : 0;
+            return S_OK;
+        }
+        default:
+            return E_INVALIDARG;
+        }
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateDescriptorHeap( const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc,
+                                                    REFIID riid, void** ppvHeap ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateHeap );
+
+        UINT64 size = static_cast<UINT64>( pDescriptorHeapDesc->NumDescriptors ) * DescriptorHandleIncrementSize;
+
+        D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = { static_cast<SIZE_T>( m_NextCPUDescriptorHandle.fetch_add( size ) ) };
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = { 0 };
+        if ( pDescriptorHeapDesc->Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE )
+        {
+            gpuHandle.ptr = m_NextGPUDescriptorHandle.fetch_add( size );
+        }
+
+        return CreateObject<NullDescriptorHeap>( riid, ppvHeap, this, *m_Counters, *pDescriptorHeapDesc, cpuHandle,
+                                                 gpuHandle );
+    }
+
+    UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapType ) override
+    {
+        return DescriptorHandleIncrementSize;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateRootSignature( UINT nodeMask, const void* pBlobWithRootSignature,
+                                                   SIZE_T blobLengthInBytes, REFIID riid,
+                                                   void** ppvRootSignature ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreatePipelineState );
+        return CreateObject<NullRootSignature>( riid, ppvRootSignature, this, *m_Counters );
+    }
+
+    void STDMETHODCALLTYPE CreateConstantBufferView( const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc,
+                                                     D3D12_CPU_DESCRIPTOR_HANDLE            DestDescriptor ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateView );
+    }
+
+    void STDMETHODCALLTYPE CreateShaderResourceView( ID3D12Resource*                        pResource,
+                                                     const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+                                                     D3D12_CPU_DESCRIPTOR_HANDLE            DestDescriptor ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateView );
+    }
+
+    void STDMETHODCALLTYPE CreateUnorderedAccessView( ID3D12Resource* pResource, ID3D12Resource* pCounterResource,
+                                                      const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc,
+                                                      D3D12_CPU_DESCRIPTOR_HANDLE             DestDescriptor ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateView );
+    }
+
+    void STDMETHODCALLTYPE CreateRenderTargetView( ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
+                                                   D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateView );
+    }
+
+    void STDMETHODCALLTYPE CreateDepthStencilView( ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc,
+                                                   D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateView );
+    }
+
+    void STDMETHODCALLTYPE CreateSampler( const D3D12_SAMPLER_DESC*   pDesc,
+                                          D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateView );
+    }
+
+    void STDMETHODCALLTYPE CopyDescriptors( UINT NumDestDescriptorRanges,
+                                            const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+                                            const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges,
+                                            const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts,
+                                            const UINT*                        pSrcDescriptorRangeSizes,
+                                            D3D12_DESCRIPTOR_HEAP_TYPE         DescriptorHeapsType ) override
+    {
+        uint64_t numDescriptors = NumDestDescriptorRanges;
+        if ( pDestDescriptorRangeSizes )
+        {
+            numDescriptors = 0;
+            for ( UINT i = 0; i < NumDestDescriptorRanges; ++i )
+            {
+                numDescriptors += pDestDescriptorRangeSizes[i];
+            }
+        }
+
+        m_Counters->Add( NullDeviceCounter::CopyDescriptors );
+        m_Counters->Add( NullDeviceCounter::NumCopiedDescriptors, numDescriptors );
+    }
+
+    void STDMETHODCALLTYPE CopyDescriptorsSimple( UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart,
+                                                  D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart,
+                                                  D3D12_DESCRIPTOR_HEAP_TYPE  DescriptorHeapsType ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CopyDescriptors );
+        m_Counters->Add( NullDeviceCounter::NumCopiedDescriptors, NumDescriptors );
+    }
+
+    D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE
+        GetResourceAllocationInfo( UINT visibleMask, UINT numResourceDescs,
+                                   const D3D12_RESOURCE_DESC* pResourceDescs ) override
+    {
+        D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = { 0, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+
+        for ( UINT i = 0; i < numResourceDescs; ++i )
+        {
+            const auto& desc = pResourceDescs[i];
+
+            UINT64 alignment = desc.Alignment;
+            if ( alignment == 0 )
+            {
+                alignment = desc.SampleDesc.Count > 1 ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+                                                      : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+            }
+
+            UINT64 size = desc.Width;
+            if ( desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER )
+            {
+                UINT numSubresources = std::max<UINT16>( desc.MipLevels, 1 ) *
+                                       ( desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize );
+                ComputeCopyableFootprints( desc, 0, numSubresources, 0, nullptr, nullptr, nullptr, &size );
+                size *= std::max( desc.SampleDesc.Count, 1u );
+            }
+
+            allocationInfo.SizeInBytes = Math::AlignUp( allocationInfo.SizeInBytes, alignment ) +
+                                         Math::AlignUp( size, alignment );
+            allocationInfo.Alignment   = std::max( allocationInfo.Alignment, alignment );
+        }
+
+        return allocationInfo;
+    }
+
+    D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties( UINT nodeMask, D3D12_HEAP_TYPE heapType ) override
+    {
+        D3D12_HEAP_PROPERTIES heapProperties = { D3D12_HEAP_TYPE_CUSTOM, D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE,
+                                                 D3D12_MEMORY_POOL_L0, 1, 1 };
+        switch ( heapType )
+        {
+        case D3D12_HEAP_TYPE_UPLOAD:
+            heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
+            break;
+        case D3D12_HEAP_TYPE_READBACK:
+            heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+            break;
+        default:
+            break;
+        }
+
+        return heapProperties;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommittedResource( const D3D12_HEAP_PROPERTIES* pHeapProperties,
+                                                       D3D12_HEAP_FLAGS HeapFlags, const D3D12_RESOURCE_DESC* pDesc,
+                                                       D3D12_RESOURCE_STATES    InitialResourceState,
+                                                       const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+                                                       REFIID riidResource, void** ppvResource ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateResource );
+
+        UINT64 size = GetResourceAllocationInfo( 0, 1, pDesc ).SizeInBytes;
+
+        return CreateObject<NullResource>( riidResource, ppvResource, this, *m_Counters, *pDesc, pHeapProperties,
+                                           HeapFlags, AllocateGPUVirtualAddress( size ), size );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateHeap( const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateHeap );
+
+        return CreateObject<NullHeap>( riid, ppvHeap, this, *m_Counters, *pDesc,
+                                       AllocateGPUVirtualAddress( pDesc->SizeInBytes ) );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreatePlacedResource( ID3D12Heap* pHeap, UINT64 HeapOffset,
+                                                    const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialState,
+                                                    const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid,
+                                                    void** ppvResource ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateResource );
+
+        // All heaps are created by the null device.
+        auto heap     = static_cast<NullHeap*>( pHeap );
+        auto heapDesc = heap->GetDesc();
+        UINT64 size   = GetResourceAllocationInfo( 0, 1, pDesc ).SizeInBytes;
+
+        return CreateObject<NullResource>( riid, ppvResource, this, *m_Counters, *pDesc, &heapDesc.Properties,
+                                           heapDesc.Flags, heap->GetGPUVirtualAddress() + HeapOffset, size );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateReservedResource( const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialState,
+                                                      const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid,
+                                                      void** ppvResource ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreateResource );
+
+        UINT64 size = GetResourceAllocationInfo( 0, 1, pDesc ).SizeInBytes;
+
+        return CreateObject<NullResource>( riid, ppvResource, this, *m_Counters, *pDesc, nullptr,
+                                           D3D12_HEAP_FLAG_NONE, AllocateGPUVirtualAddress( size ), size );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateSharedHandle( ID3D12DeviceChild* pObject, const SECURITY_ATTRIBUTES* pAttributes,
+                                                  DWORD Access, LPCWSTR Name, HANDLE* pHandle ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE OpenSharedHandle( HANDLE NTHandle, REFIID riid, void** ppvObj ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE OpenSharedHandleByName( LPCWSTR Name, DWORD Access, HANDLE* pNTHandle ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE MakeResident( UINT NumObjects, ID3D12Pageable* const* ppObjects ) override
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Evict( UINT NumObjects, ID3D12Pageable* const* ppObjects ) override
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateFence( UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid,
+                                           void** ppFence ) override
+    {
+        return CreateObject<NullFence>( riid, ppFence, this, *m_Counters, InitialValue );
+    }
+
+    HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override
+    {
+        return S_OK;
+    }
+
+    void STDMETHODCALLTYPE GetCopyableFootprints( const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource,
+                                                  UINT NumSubresources, UINT64 BaseOffset,
+                                                  D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows,
+                                                  UINT64* pRowSizeInBytes, UINT64* pTotalBytes ) override
+    {
+        ComputeCopyableFootprints( *pResourceDesc, FirstSubresource, NumSubresources, BaseOffset, pLayouts, pNumRows,
+                                   pRowSizeInBytes, pTotalBytes );
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateQueryHeap( const D3D12_QUERY_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetStablePowerState( BOOL Enable ) override
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandSignature( const D3D12_COMMAND_SIGNATURE_DESC* pDesc,
+                                                      ID3D12RootSignature* pRootSignature, REFIID riid,
+                                                      void** ppvCommandSignature ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreatePipelineState );
+        return CreateObject<NullCommandSignature>( riid, ppvCommandSignature, this, *m_Counters );
+    }
+
+    void STDMETHODCALLTYPE GetResourceTiling( ID3D12Resource* pTiledResource, UINT* pNumTilesForEntireResource,
+                                              D3D12_PACKED_MIP_INFO* pPackedMipDesc,
+                                              D3D12_TILE_SHAPE*      pStandardTileShapeForNonPackedMips,
+                                              UINT* pNumSubresourceTilings, UINT FirstSubresourceTilingToGet,
+                                              D3D12_SUBRESOURCE_TILING* pSubresourceTilingsForNonPackedMips ) override
+    {
+        auto desc   = pTiledResource->GetDesc();
+        auto tiling = ComputeResourceTiling( desc );
+
+        if ( pNumTilesForEntireResource )
+            *pNumTilesForEntireResource = tiling.NumTiles;
+        if ( pPackedMipDesc )
+            *pPackedMipDesc = tiling.PackedMipInfo;
+        if ( pStandardTileShapeForNonPackedMips )
+            *pStandardTileShapeForNonPackedMips = tiling.TileShape;
+
+        if ( !pNumSubresourceTilings )
+            return;
+
+        if ( desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER )
+        {
+            if ( *pNumSubresourceTilings > 0 && FirstSubresourceTilingToGet == 0 )
+            {
+                pSubresourceTilingsForNonPackedMips[0] = { tiling.NumTiles, 1, 1, 0 };
+                *pNumSubresourceTilings                = 1;
+            }
+            else
+            {
+                *pNumSubresourceTilings = 0;
+            }
+            return;
+        }
+
+        const UINT mipLevels = std::max<UINT16>( desc.MipLevels, 1 );
+        const UINT arraySize = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize;
+        const UINT numSubresources = mipLevels * arraySize;
+
+        UINT numSubresourceTilings = 0;
+        for ( UINT subresource = FirstSubresourceTilingToGet;
+              subresource < numSubresources && numSubresourceTilings < *pNumSubresourceTilings; ++subresource )
+        {
+            UINT mip   = subresource % mipLevels;
+            UINT slice = subresource / mipLevels;
+
+            D3D12_SUBRESOURCE_TILING& subresourceTiling = pSubresourceTilingsForNonPackedMips[numSubresourceTilings++];
+            if ( mip < tiling.PackedMipInfo.NumStandardMips )
+            {
+                UINT width  = std::max( static_cast<UINT>( desc.Width >> mip ), 1u );
+                UINT height = std::max( desc.Height >> mip, 1u );
+
+                subresourceTiling.WidthInTiles  = ( width + tiling.TileShape.WidthInTexels - 1 ) /
+                                                 tiling.TileShape.WidthInTexels;
+                subresourceTiling.HeightInTiles = static_cast<UINT16>(
+                    ( height + tiling.TileShape.HeightInTexels - 1 ) / tiling.TileShape.HeightInTexels );
+                subresourceTiling.DepthInTiles                   = 1;
+                subresourceTiling.StartTileIndexInOverallResource = slice * tiling.NumTilesPerSlice;
+
+                // Add the tiles of the more detailed mips.
+                for ( UINT i = 0; i < mip; ++i )
+                {
+                    UINT mipWidth  = std::max( static_cast<UINT>( desc.Width >> i ), 1u );
+                    UINT mipHeight = std::max( desc.Height >> i, 1u );
+                    subresourceTiling.StartTileIndexInOverallResource +=
+                        ( ( mipWidth + tiling.TileShape.WidthInTexels - 1 ) / tiling.TileShape.WidthInTexels ) *
+                        ( ( mipHeight + tiling.TileShape.HeightInTexels - 1 ) / tiling.TileShape.HeightInTexels );
+                }
+            }
+            else
+            {
+                subresourceTiling = { 0, 0, 0, D3D12_PACKED_TILE };
+            }
+        }
+
+        *pNumSubresourceTilings = numSubresourceTilings;
+    }
+
+    LUID STDMETHODCALLTYPE GetAdapterLuid() override
+    {
+        return LUID {};
+    }
+
+    // ID3D12Device1
+
+    HRESULT STDMETHODCALLTYPE CreatePipelineLibrary( const void* pLibraryBlob, SIZE_T BlobLength, REFIID riid,
+                                                     void** ppPipelineLibrary ) override
+    {
+        return DXGI_ERROR_UNSUPPORTED;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetEventOnMultipleFenceCompletion( ID3D12Fence* const* ppFences,
+                                                                 const UINT64* pFenceValues, UINT NumFences,
+                                                                 D3D12_MULTIPLE_FENCE_WAIT_FLAGS Flags,
+                                                                 HANDLE                          hEvent ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetResidencyPriority( UINT NumObjects, ID3D12Pageable* const* ppObjects,
+                                                    const D3D12_RESIDENCY_PRIORITY* pPriorities ) override
+    {
+        return S_OK;
+    }
+
+    // ID3D12Device2
+
+    HRESULT STDMETHODCALLTYPE CreatePipelineState( const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, REFIID riid,
+                                                   void** ppPipelineState ) override
+    {
+        m_Counters->Add( NullDeviceCounter::CreatePipelineState );
+        return CreateObject<NullPipelineState>( riid, ppPipelineState, this, *m_Counters );
+    }
+
+private:
+    D3D12_GPU_VIRTUAL_ADDRESS AllocateGPUVirtualAddress( UINT64 sizeInBytes )
+    {
+        return m_NextGPUVirtualAddress.fetch_add( Math::AlignUp( std::max<UINT64>( sizeInBytes, 1 ), _64KB ) );
+    }
+
+    std::shared_ptr<NullDeviceCounters> m_Counters;
+
+    std::atomic_uint64_t m_NextCPUDescriptorHandle;
+    std::atomic_uint64_t m_NextGPUDescriptorHandle;
+    std::atomic_uint64_t m_NextGPUVirtualAddress;
+};
+
+}  // namespace
+
+ComPtr<ID3D12Device2> dx12lib::CreateNullD3D12Device( std::shared_ptr<NullDeviceCounters> counters )
+{
+    if ( !counters )
+    {
+        counters = std::make_shared<NullDeviceCounters>();
+    }
+
+    ComPtr<ID3D12Device2> device;
+    device.Attach( new NullD3D12Device( std::move( counters ) ) );
+
+    return device;
+}
@@ -0,0 +1,972 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/PipelineStateCache.h>
+
+#include <dx12lib/CommandStream.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/PipelineStateObject.h>
+#include <dx12lib/RootSignature.h>
+
+#include <fstream>
+
+using namespace dx12lib;
+
+namespace
+{
+struct SubobjectLayout
+{
+    size_t Size;
+    size_t Alignment;
+};
+
+template<typename T>
+constexpr SubobjectLayout LayoutOf()
+{
+    return { sizeof( T ), alignof( T ) };
+}
+
+// Get the size and alignment of the data that follows the type of a pipeline state stream subobject.
+SubobjectLayout GetSubobjectLayout( D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type )
+{
+    switch ( type )
+    {
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE:
+        return LayoutOf<ID3D12RootSignature*>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS:
+        return LayoutOf<D3D12_SHADER_BYTECODE>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT:
+        return LayoutOf<D3D12_STREAM_OUTPUT_DESC>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND:
+        return LayoutOf<D3D12_BLEND_DESC>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK:
+        return LayoutOf<UINT>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER:
+        return LayoutOf<D3D12_RASTERIZER_DESC>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL:
+        return LayoutOf<D3D12_DEPTH_STENCIL_DESC>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT:
+        return LayoutOf<D3D12_INPUT_LAYOUT_DESC>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE:
+        return LayoutOf<D3D12_INDEX_BUFFER_STRIP_CUT_VALUE>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY:
+        return LayoutOf<D3D12_PRIMITIVE_TOPOLOGY_TYPE>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS:
+        return LayoutOf<D3D12_RT_FORMAT_ARRAY>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT:
+        return LayoutOf<DXGI_FORMAT>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC:
+        return LayoutOf<DXGI_SAMPLE_DESC>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK:
+        return LayoutOf<UINT>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO:
+        return LayoutOf<D3D12_CACHED_PIPELINE_STATE>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS:
+        return LayoutOf<D3D12_PIPELINE_STATE_FLAGS>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1:
+        return LayoutOf<D3D12_DEPTH_STENCIL_DESC1>();
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING:
+        return LayoutOf<D3D12_VIEW_INSTANCING_DESC>();
+    default:
+        throw std::exception( "Unknown pipeline state subobject type." );
+    }
+}
+
+void HashDepthStencilOp( Hash64& hash, const D3D12_DEPTH_STENCILOP_DESC& stencilOp )
+{
+    hash.Add( stencilOp.StencilFailOp );
+    hash.Add( stencilOp.StencilDepthFailOp );
+    hash.Add( stencilOp.StencilPassOp );
+    hash.Add( stencilOp.StencilFunc );
+}
+
+// Hash the fields of a subobject that doesn't reference other data. The
+// subobjects are hashed field by field because some of them contain padding
+// (for example, D3D12_RENDER_TARGET_BLEND_DESC) and unused array elements.
+void HashSubobjectValue( Hash64& hash, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, const uint8_t* data )
+{
+    switch ( type )
+    {
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND:
+    {
+        auto& blend = *reinterpret_cast<const D3D12_BLEND_DESC*>( data );
+
+        hash.Add( blend.AlphaToCoverageEnable );
+        hash.Add( blend.IndependentBlendEnable );
+
+        // Only the first render target is used if independent blending is disabled.
+        UINT numRenderTargets = blend.IndependentBlendEnable ? D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT : 1;
+        for ( UINT i = 0; i < numRenderTargets; ++i )
+        {
+            auto& renderTarget = blend.RenderTarget[i];
+
+            hash.Add( renderTarget.BlendEnable );
+            hash.Add( renderTarget.LogicOpEnable );
+            hash.Add( renderTarget.SrcBlend );
+            hash.Add( renderTarget.DestBlend );
+            hash.Add( renderTarget.BlendOp );
+            hash.Add( renderTarget.SrcBlendAlpha );
+            hash.Add( renderTarget.DestBlendAlpha );
+            hash.Add( renderTarget.BlendOpAlpha );
+            hash.Add( renderTarget.LogicOp );
+            hash.Add( renderTarget.RenderTargetWriteMask );
+        }
+    }
+    break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER:
+    {
+        auto& rasterizer = *reinterpret_cast<const D3D12_RASTERIZER_DESC*>( data );
+
+        hash.Add( rasterizer.FillMode );
+        hash.Add( rasterizer.CullMode );
+        hash.Add( rasterizer.FrontCounterClockwise );
+        hash.Add( rasterizer.DepthBias );
+        hash.Add( rasterizer.DepthBiasClamp );
+        hash.Add( rasterizer.SlopeScaledDepthBias );
+        hash.Add( rasterizer.DepthClipEnable );
+        hash.Add( rasterizer.MultisampleEnable );
+        hash.Add( rasterizer.AntialiasedLineEnable );
+        hash.Add( rasterizer.ForcedSampleCount );
+        hash.Add( rasterizer.ConservativeRaster );
+    }
+    break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL:
+    {
+        auto& depthStencil = *reinterpret_cast<const D3D12_DEPTH_STENCIL_DESC*>( data );
+
+        hash.Add( depthStencil.DepthEnable );
+        hash.Add( depthStencil.DepthWriteMask );
+        hash.Add( depthStencil.DepthFunc );
+        hash.Add( depthStencil.StencilEnable );
+        hash.Add( depthStencil.StencilReadMask );
+        hash.Add( depthStencil.StencilWriteMask );
+        HashDepthStencilOp( hash, depthStencil.FrontFace );
+        HashDepthStencilOp( hash, depthStencil.BackFace );
+    }
+    break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1:
+    {
+        auto& depthStencil = *reinterpret_cast<const D3D12_DEPTH_STENCIL_DESC1*>( data );
+
+        hash.Add( depthStencil.DepthEnable );
+        hash.Add( depthStencil.DepthWriteMask );
+        hash.Add( depthStencil.DepthFunc );
+        hash.Add( depthStencil.StencilEnable );
+        hash.Add( depthStencil.StencilReadMask );
+        hash.Add( depthStencil.StencilWriteMask );
+        HashDepthStencilOp( hash, depthStencil.FrontFace );
+        HashDepthStencilOp( hash, depthStencil.BackFace );
+        hash.Add( depthStencil.DepthBoundsTestEnable );
+    }
+    break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS:
+    {
+        auto& renderTargetFormats = *reinterpret_cast<const D3D12_RT_FORMAT_ARRAY*>( data );
+
+        // The formats of unused render targets are ignored.
+        UINT numRenderTargets = std::min<UINT>( renderTargetFormats.NumRenderTargets, 8 );
+
+        hash.Add( numRenderTargets );
+        hash.Add( renderTargetFormats.RTFormats, sizeof( DXGI_FORMAT ) * numRenderTargets );
+    }
+    break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC:
+    {
+        auto& sampleDesc = *reinterpret_cast<const DXGI_SAMPLE_DESC*>( data );
+
+        hash.Add( sampleDesc.Count );
+        hash.Add( sampleDesc.Quality );
+    }
+    break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK:
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK:
+        hash.Add( *reinterpret_cast<const UINT*>( data ) );
+        break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE:
+        hash.Add( *reinterpret_cast<const D3D12_INDEX_BUFFER_STRIP_CUT_VALUE*>( data ) );
+        break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY:
+        hash.Add( *reinterpret_cast<const D3D12_PRIMITIVE_TOPOLOGY_TYPE*>( data ) );
+        break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT:
+        hash.Add( *reinterpret_cast<const DXGI_FORMAT*>( data ) );
+        break;
+    case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS:
+        hash.Add( *reinterpret_cast<const D3D12_PIPELINE_STATE_FLAGS*>( data ) );
+        break;
+    default:
+        throw std::exception( "Unknown pipeline state subobject type." );
+    }
+}
+
+// Invoke a function for the type and data of every subobject in a pipeline state stream.
+template<typename Func>
+void ForEachSubobject( uint8_t* stream, size_t size, Func&& func )
+{
+    size_t offset = 0;
+    while ( offset < size )
+    {
+        auto type = *reinterpret_cast<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE*>( stream + offset );
+
+        SubobjectLayout layout     = GetSubobjectLayout( type );
+        size_t          dataOffset = Math::AlignUp( offset + sizeof( type ), layout.Alignment );
+
+        if ( dataOffset + layout.Size > size )
+        {
+            throw std::exception( "Invalid pipeline state stream." );
+        }
+
+        func( type, stream + dataOffset );
+
+        offset = Math::AlignUp( dataOffset + layout.Size, sizeof( void* ) );
+    }
+}
+}  // namespace
+
+uint64_t dx12lib::HashRootSignatureDesc( const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc )
+{
+    Hash64 hash;
+
+    hash.Add( rootSignatureDesc.NumParameters );
+    for ( UINT i = 0; i < rootSignatureDesc.NumParameters; ++i )
+    {
+        const D3D12_ROOT_PARAMETER1& rootParameter = rootSignatureDesc.pParameters[i];
+
+        hash.Add( rootParameter.ParameterType );
+        hash.Add( rootParameter.ShaderVisibility );
+
+        switch ( rootParameter.ParameterType )
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            hash.Add( rootParameter.DescriptorTable.NumDescriptorRanges );
+            hash.Add( rootParameter.DescriptorTable.pDescriptorRanges,
+                      sizeof( D3D12_DESCRIPTOR_RANGE1 ) * rootParameter.DescriptorTable.NumDescriptorRanges );
+            break;
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            hash.Add( rootParameter.Constants );
+            break;
+        default:
+            hash.Add( rootParameter.Descriptor );
+            break;
+        }
+    }
+
+    hash.Add( rootSignatureDesc.NumStaticSamplers );
+    hash.Add( rootSignatureDesc.pStaticSamplers,
+              sizeof( D3D12_STATIC_SAMPLER_DESC ) * rootSignatureDesc.NumStaticSamplers );
+    hash.Add( rootSignatureDesc.Flags );
+
+    return hash.Get();
+}
+
+PipelineStateDesc::PipelineStateDesc( const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc,
+                                      const RootSignatureHashFunc&            getRootSignatureHash )
+: m_Hash( 0 )
+, m_IsPersistent( true )
+{
+    auto stream = static_cast<const uint8_t*>( pipelineStateStreamDesc.pPipelineStateSubobjectStream );
+    m_Stream.assign( stream, stream + pipelineStateStreamDesc.SizeInBytes );
+
+    Hash64 hash;
+
+    // Every subobject in the stream is aligned to the size of a pointer (see
+    // CD3DX12_PIPELINE_STATE_STREAM_SUBOBJECT) and consists of the subobject
+    // type followed by the subobject data.
+    size_t offset = 0;
+    while ( offset < m_Stream.size() )
+    {
+        auto type = *reinterpret_cast<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE*>( &m_Stream[offset] );
+
+        SubobjectLayout layout     = GetSubobjectLayout( type );
+        size_t          dataOffset = Math::AlignUp( offset + sizeof( type ), layout.Alignment );
+
+        if ( dataOffset + layout.Size > m_Stream.size() )
+        {
+            throw std::exception( "Invalid pipeline state stream." );
+        }
+
+        uint8_t* data = &m_Stream[dataOffset];
+
+        hash.Add( type );
+
+        switch ( type )
+        {
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE:
+        {
+            auto rootSignature = *reinterpret_cast<ID3D12RootSignature**>( data );
+            m_RootSignature    = rootSignature;
+
+            uint64_t rootSignatureHash = getRootSignatureHash ? getRootSignatureHash( rootSignature ) : 0;
+            if ( rootSignatureHash == 0 )
+            {
+                // The root signature is only known by its address.
+                hash.Add( rootSignature );
+                m_IsPersistent = false;
+            }
+            else
+            {
+                hash.Add( rootSignatureHash );
+            }
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS:
+        {
+            auto& shaderBytecode = *reinterpret_cast<D3D12_SHADER_BYTECODE*>( data );
+
+            hash.Add( shaderBytecode.BytecodeLength );
+            hash.Add( shaderBytecode.pShaderBytecode, shaderBytecode.BytecodeLength );
+
+            shaderBytecode.pShaderBytecode = CopyData( shaderBytecode.pShaderBytecode, shaderBytecode.BytecodeLength );
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT:
+        {
+            auto& streamOutput = *reinterpret_cast<D3D12_STREAM_OUTPUT_DESC*>( data );
+
+            auto entries = static_cast<D3D12_SO_DECLARATION_ENTRY*>( const_cast<void*>( CopyData(
+                streamOutput.pSODeclaration, sizeof( D3D12_SO_DECLARATION_ENTRY ) * streamOutput.NumEntries ) ) );
+
+            hash.Add( streamOutput.NumEntries );
+            for ( UINT i = 0; i < streamOutput.NumEntries; ++i )
+            {
+                auto& entry = entries[i];
+
+                hash.Add( entry.Stream );
+                hash.AddString( entry.SemanticName );
+                hash.Add( entry.SemanticIndex );
+                hash.Add( entry.StartComponent );
+                hash.Add( entry.ComponentCount );
+                hash.Add( entry.OutputSlot );
+
+                entry.SemanticName = CopyString( entry.SemanticName );
+            }
+
+            hash.Add( streamOutput.NumStrides );
+            hash.Add( streamOutput.pBufferStrides, sizeof( UINT ) * streamOutput.NumStrides );
+            hash.Add( streamOutput.RasterizedStream );
+
+            streamOutput.pSODeclaration = entries;
+            streamOutput.pBufferStrides = static_cast<const UINT*>(
+                CopyData( streamOutput.pBufferStrides, sizeof( UINT ) * streamOutput.NumStrides ) );
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT:
+        {
+            auto& inputLayout = *reinterpret_cast<D3D12_INPUT_LAYOUT_DESC*>( data );
+
+            auto elements = static_cast<D3D12_INPUT_ELEMENT_DESC*>( const_cast<void*>( CopyData(
+                inputLayout.pInputElementDescs, sizeof( D3D12_INPUT_ELEMENT_DESC ) * inputLayout.NumElements ) ) );
+
+            hash.Add( inputLayout.NumElements );
+            for ( UINT i = 0; i < inputLayout.NumElements; ++i )
+            {
+                auto& element = elements[i];
+
+                hash.AddString( element.SemanticName );
+                hash.Add( element.SemanticIndex );
+                hash.Add( element.Format );
+                hash.Add( element.InputSlot );
+                hash.Add( element.AlignedByteOffset );
+                hash.Add( element.InputSlotClass );
+                hash.Add( element.InstanceDataStepRate );
+
+                element.SemanticName = CopyString( element.SemanticName );
+            }
+
+            inputLayout.pInputElementDescs = elements;
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING:
+        {
+            auto& viewInstancing = *reinterpret_cast<D3D12_VIEW_INSTANCING_DESC*>( data );
+
+            hash.Add( viewInstancing.ViewInstanceCount );
+            hash.Add( viewInstancing.pViewInstanceLocations,
+                      sizeof( D3D12_VIEW_INSTANCE_LOCATION ) * viewInstancing.ViewInstanceCount );
+            hash.Add( viewInstancing.Flags );
+
+            viewInstancing.pViewInstanceLocations = static_cast<const D3D12_VIEW_INSTANCE_LOCATION*>(
+                CopyData( viewInstancing.pViewInstanceLocations,
+                          sizeof( D3D12_VIEW_INSTANCE_LOCATION ) * viewInstancing.ViewInstanceCount ) );
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO:
+            // Cached blobs are superseded by the pipeline library.
+            *reinterpret_cast<D3D12_CACHED_PIPELINE_STATE*>( data ) = {};
+            break;
+        default:
+            HashSubobjectValue( hash, type, data );
+            break;
+        }
+
+        offset = Math::AlignUp( dataOffset + layout.Size, sizeof( void* ) );
+    }
+
+    m_Hash = hash.Get();
+}
+
+const void* PipelineStateDesc::CopyData( const void* data, size_t size )
+{
+    if ( !data || size == 0 )
+        return nullptr;
+
+    auto bytes = static_cast<const uint8_t*>( data );
+    m_Data.emplace_back( bytes, bytes + size );
+
+    return m_Data.back().data();
+}
+
+const char* PipelineStateDesc::CopyString( const char* str )
+{
+    return str ? static_cast<const char*>( CopyData( str, strlen( str ) + 1 ) ) : nullptr;
+}
+
+void PipelineStateDesc::Serialize( CommandStreamWriter&                                       writer,
+                                   const std::function<uint32_t( ID3D12RootSignature* )>& getRootSignatureId ) const
+{
+    // The stream is written as is (the pointers in the stream are patched when
+    // the stream is read) followed by the data that is referenced by the
+    // subobjects in the order of the subobjects.
+    writer.Write( static_cast<uint64_t>( m_Stream.size() ) );
+    writer.WriteBytes( m_Stream.data(), m_Stream.size() );
+
+    auto writeString = [&writer]( const char* str ) { writer.WriteString( str ? str : "" ); };
+
+    ForEachSubobject( const_cast<uint8_t*>( m_Stream.data() ), m_Stream.size(),
+                      [&]( D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, uint8_t* data ) {
+                          switch ( type )
+                          {
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE:
+                              writer.Write( getRootSignatureId( *reinterpret_cast<ID3D12RootSignature**>( data ) ) );
+                              break;
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS:
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS:
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS:
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS:
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS:
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS:
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS:
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS:
+                          {
+                              auto& shaderBytecode = *reinterpret_cast<D3D12_SHADER_BYTECODE*>( data );
+                              writer.WriteBytes( shaderBytecode.pShaderBytecode, shaderBytecode.BytecodeLength );
+                          }
+                          break;
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT:
+                          {
+                              auto& streamOutput = *reinterpret_cast<D3D12_STREAM_OUTPUT_DESC*>( data );
+                              for ( UINT i = 0; i < streamOutput.NumEntries; ++i )
+                              {
+                                  writer.Write( streamOutput.pSODeclaration[i] );
+                                  writeString( streamOutput.pSODeclaration[i].SemanticName );
+                              }
+                              writer.WriteBytes( streamOutput.pBufferStrides, sizeof( UINT ) * streamOutput.NumStrides );
+                          }
+                          break;
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT:
+                          {
+                              auto& inputLayout = *reinterpret_cast<D3D12_INPUT_LAYOUT_DESC*>( data );
+                              for ( UINT i = 0; i < inputLayout.NumElements; ++i )
+                              {
+                                  writer.Write( inputLayout.pInputElementDescs[i] );
+                                  writeString( inputLayout.pInputElementDescs[i].SemanticName );
+                              }
+                          }
+                          break;
+                          case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING:
+                          {
+                              auto& viewInstancing = *reinterpret_cast<D3D12_VIEW_INSTANCING_DESC*>( data );
+                              writer.WriteBytes( viewInstancing.pViewInstanceLocations,
+                                                 sizeof( D3D12_VIEW_INSTANCE_LOCATION ) *
+                                                     viewInstancing.ViewInstanceCount );
+                          }
+                          break;
+                          default:
+                              break;
+                          }
+                      } );
+}
+
+std::shared_ptr<PipelineStateDesc>
+    PipelineStateDesc::Deserialize( CommandStreamReader&                                       reader,
+                                    const std::function<ID3D12RootSignature*( uint32_t )>& getRootSignature )
+{
+    auto streamSize = static_cast<size_t>( reader.Read<uint64_t>() );
+    auto streamData = static_cast<const uint8_t*>( reader.ReadBytes( streamSize ) );
+
+    std::vector<uint8_t> stream( streamData, streamData + streamSize );
+
+    // Arrays that need to be patched and the semantic names are copied. The
+    // PipelineStateDesc makes a deep copy of everything.
+    std::deque<std::vector<uint8_t>> arrays;
+    std::deque<std::string>          strings;
+
+    auto readArray = [&]( size_t elementSize, UINT numElements ) {
+        auto data = static_cast<const uint8_t*>( reader.ReadBytes( elementSize * numElements ) );
+        arrays.emplace_back( data, data + elementSize * numElements );
+        return static_cast<void*>( arrays.back().data() );
+    };
+
+    auto readString = [&]() {
+        strings.push_back( reader.ReadString() );
+        return strings.back().c_str();
+    };
+
+    ForEachSubobject( stream.data(), stream.size(), [&]( D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, uint8_t* data ) {
+        switch ( type )
+        {
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE:
+            *reinterpret_cast<ID3D12RootSignature**>( data ) = getRootSignature( reader.Read<uint32_t>() );
+            break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS:
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS:
+        {
+            auto& shaderBytecode           = *reinterpret_cast<D3D12_SHADER_BYTECODE*>( data );
+            shaderBytecode.pShaderBytecode = reader.ReadBytes( shaderBytecode.BytecodeLength );
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT:
+        {
+            auto& streamOutput = *reinterpret_cast<D3D12_STREAM_OUTPUT_DESC*>( data );
+
+            arrays.emplace_back( sizeof( D3D12_SO_DECLARATION_ENTRY ) * streamOutput.NumEntries );
+            auto entries = reinterpret_cast<D3D12_SO_DECLARATION_ENTRY*>( arrays.back().data() );
+            for ( UINT i = 0; i < streamOutput.NumEntries; ++i )
+            {
+                entries[i]              = reader.Read<D3D12_SO_DECLARATION_ENTRY>();
+                entries[i].SemanticName = readString();
+            }
+
+            streamOutput.pSODeclaration = streamOutput.NumEntries > 0 ? entries : nullptr;
+            streamOutput.pBufferStrides = static_cast<const UINT*>( readArray( sizeof( UINT ), streamOutput.NumStrides ) );
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT:
+        {
+            auto& inputLayout = *reinterpret_cast<D3D12_INPUT_LAYOUT_DESC*>( data );
+
+            arrays.emplace_back( sizeof( D3D12_INPUT_ELEMENT_DESC ) * inputLayout.NumElements );
+            auto elements = reinterpret_cast<D3D12_INPUT_ELEMENT_DESC*>( arrays.back().data() );
+            for ( UINT i = 0; i < inputLayout.NumElements; ++i )
+            {
+                elements[i]              = reader.Read<D3D12_INPUT_ELEMENT_DESC>();
+                elements[i].SemanticName = readString();
+            }
+
+            inputLayout.pInputElementDescs = inputLayout.NumElements > 0 ? elements : nullptr;
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING:
+        {
+            auto& viewInstancing                  = *reinterpret_cast<D3D12_VIEW_INSTANCING_DESC*>( data );
+            viewInstancing.pViewInstanceLocations = static_cast<const D3D12_VIEW_INSTANCE_LOCATION*>(
+                readArray( sizeof( D3D12_VIEW_INSTANCE_LOCATION ), viewInstancing.ViewInstanceCount ) );
+        }
+        break;
+        case D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CACHED_PSO:
+            *reinterpret_cast<D3D12_CACHED_PIPELINE_STATE*>( data ) = {};
+            break;
+        default:
+            break;
+        }
+    } );
+
+    return std::make_shared<PipelineStateDesc>( D3D12_PIPELINE_STATE_STREAM_DESC { stream.size(), stream.data() } );
+}
+
+AsyncPipelineStateObject::AsyncPipelineStateObject( std::shared_future<std::shared_ptr<PipelineStateObject>> future,
+                                                    std::shared_ptr<PipelineStateObject> fallback )
+: m_Future( future )
+, m_Fallback( fallback )
+{}
+
+bool AsyncPipelineStateObject::IsReady() const
+{
+    return m_Future.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+}
+
+bool AsyncPipelineStateObject::IsFailed() const
+{
+    if ( !IsReady() )
+        return false;
+
+    try
+    {
+        m_Future.get();
+    }
+    catch ( ... )
+    {
+        return true;
+    }
+
+    return false;
+}
+
+std::shared_ptr<PipelineStateObject> AsyncPipelineStateObject::Get() const
+{
+    if ( IsReady() )
+    {
+        try
+        {
+            return m_Future.get();
+        }
+        catch ( ... )
+        {}
+    }
+
+    return m_Fallback;
+}
+
+std::shared_ptr<PipelineStateObject> AsyncPipelineStateObject::Wait() const
+{
+    return m_Future.get();
+}
+
+// Adapters for std::make_shared
+class MakeCachedPipelineStateObject : public PipelineStateObject
+{
+public:
+    MakeCachedPipelineStateObject( Device& device, Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState,
+                                   std::shared_ptr<PipelineStateDesc> desc )
+    : PipelineStateObject( device, pipelineState, desc )
+    {}
+
+    virtual ~MakeCachedPipelineStateObject() {}
+};
+
+class MakeAsyncPipelineStateObject : public AsyncPipelineStateObject
+{
+public:
+    MakeAsyncPipelineStateObject( std::shared_future<std::shared_ptr<PipelineStateObject>> future,
+                                  std::shared_ptr<PipelineStateObject>                     fallback )
+    : AsyncPipelineStateObject( future, fallback )
+    {}
+
+    virtual ~MakeAsyncPipelineStateObject() {}
+};
+
+PipelineStateCache::PipelineStateCache( Device& device, const std::wstring& libraryFileName, uint32_t numThreads )
+: m_Device( device )
+, m_LibraryFileName( libraryFileName )
+, m_IsLibraryDirty( false )
+, m_NumPendingJobs( 0 )
+, m_bStopWorkers( false )
+{
+    LoadPipelineLibrary();
+
+    if ( numThreads == 0 )
+    {
+        numThreads = std::max( std::thread::hardware_concurrency() / 2, 1u );
+    }
+
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        m_WorkerThreads.emplace_back( &PipelineStateCache::WorkerThread, this );
+    }
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_bStopWorkers = true;
+    }
+    m_JobsCondition.notify_all();
+
+    for ( auto& thread: m_WorkerThreads )
+    {
+        thread.join();
+    }
+}
+
+void PipelineStateCache::LoadPipelineLibrary()
+{
+    if ( m_LibraryFileName.empty() )
+        return;
+
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    std::ifstream file( fs::path( m_LibraryFileName ), std::ios::binary | std::ios::ate );
+    if ( file )
+    {
+        m_LibraryData.resize( static_cast<size_t>( file.tellg() ) );
+        file.seekg( 0 );
+        file.read( reinterpret_cast<char*>( m_LibraryData.data() ), m_LibraryData.size() );
+    }
+
+    ComPtr<ID3D12PipelineLibrary> pipelineLibrary;
+    HRESULT                       hr = E_FAIL;
+
+    if ( !m_LibraryData.empty() )
+    {
+        // Fails if the library was created with a different driver or adapter (or the file is corrupt).
+        hr = d3d12Device->CreatePipelineLibrary( m_LibraryData.data(), m_LibraryData.size(),
+                                                 IID_PPV_ARGS( &pipelineLibrary ) );
+        if ( FAILED( hr ) )
+        {
+            m_LibraryData.clear();
+        }
+    }
+
+    if ( FAILED( hr ) )
+    {
+        hr = d3d12Device->CreatePipelineLibrary( nullptr, 0, IID_PPV_ARGS( &pipelineLibrary ) );
+    }
+
+    // Pipeline libraries are not supported on all versions of the OS.
+    if ( SUCCEEDED( hr ) )
+    {
+        pipelineLibrary.As( &m_PipelineLibrary );
+    }
+}
+
+std::shared_ptr<RootSignature>
+    PipelineStateCache::GetRootSignature( const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc )
+{
+    uint64_t hash = HashRootSignatureDesc( rootSignatureDesc );
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    ++m_Statistics.NumRootSignatureRequests;
+
+    auto iter = m_RootSignatures.find( hash );
+    if ( iter != m_RootSignatures.end() )
+    {
+        ++m_Statistics.NumRootSignatureHits;
+        return iter->second;
+    }
+
+    auto rootSignature = m_Device.CreateRootSignature( rootSignatureDesc );
+
+    m_RootSignatures[hash]                                            = rootSignature;
+    m_RootSignatureHashes[rootSignature->GetD3D12RootSignature().Get()] = hash;
+
+    return rootSignature;
+}
+
+std::shared_ptr<PipelineStateDesc>
+    PipelineStateCache::CopyPipelineStateDesc( const D3D12_PIPELINE_STATE_STREAM_DESC& desc ) const
+{
+    // Root signatures that were created by the cache are identified by the hash of their description.
+    return std::make_shared<PipelineStateDesc>( desc, [this]( ID3D12RootSignature* rootSignature ) {
+        auto iter = m_RootSignatureHashes.find( rootSignature );
+        return iter != m_RootSignatureHashes.end() ? iter->second : 0;
+    } );
+}
+
+std::shared_ptr<PipelineStateObject>
+    PipelineStateCache::DoGetPipelineStateObject( const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc )
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+
+    auto     desc = CopyPipelineStateDesc( pipelineStateStreamDesc );
+    uint64_t hash = desc->GetHash();
+
+    ++m_Statistics.NumPipelineStateRequests;
+
+    auto iter = m_PipelineStates.find( hash );
+    if ( iter != m_PipelineStates.end() )
+    {
+        ++m_Statistics.NumPipelineStateHits;
+
+        // Wait for the pipeline state object if it is being created on another thread.
+        auto future = iter->second;
+        lock.unlock();
+
+        return future.get();
+    }
+
+    PipelineStatePromise promise;
+    auto                 future = promise.get_future().share();
+    m_PipelineStates[hash]      = future;
+    lock.unlock();
+
+    Resolve( desc, promise );
+
+    return future.get();
+}
+
+std::shared_ptr<AsyncPipelineStateObject>
+    PipelineStateCache::DoGetPipelineStateObjectAsync( const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc,
+                                                       std::shared_ptr<PipelineStateObject>    fallback )
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+
+    auto     desc = CopyPipelineStateDesc( pipelineStateStreamDesc );
+    uint64_t hash = desc->GetHash();
+
+    ++m_Statistics.NumPipelineStateRequests;
+
+    auto iter = m_PipelineStates.find( hash );
+    if ( iter != m_PipelineStates.end() )
+    {
+        ++m_Statistics.NumPipelineStateHits;
+        return std::make_shared<MakeAsyncPipelineStateObject>( iter->second, fallback );
+    }
+
+    PipelineStateJob job;
+    job.Desc    = std::move( desc );
+    auto future = job.Promise.get_future().share();
+
+    m_PipelineStates[hash] = future;
+    m_Jobs.push_back( std::move( job ) );
+    ++m_NumPendingJobs;
+    lock.unlock();
+
+    m_JobsCondition.notify_one();
+
+    return std::make_shared<MakeAsyncPipelineStateObject>( future, fallback );
+}
+
+std::shared_ptr<PipelineStateObject>
+    PipelineStateCache::CreatePipelineStateObject( const std::shared_ptr<PipelineStateDesc>& desc )
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    auto d3d12Device = m_Device.GetD3D12Device();
+    auto streamDesc  = desc->GetStreamDesc();
+
+    ComPtr<ID3D12PipelineState> d3d12PipelineState;
+    bool                        isLoaded = false;
+
+    wchar_t name[17] = {};
+    if ( m_PipelineLibrary && desc->IsPersistent() )
+    {
+        swprintf_s( name, L"%016llx", desc->GetHash() );
+
+        std::lock_guard<std::mutex> lock( m_LibraryMutex );
+        isLoaded =
+            SUCCEEDED( m_PipelineLibrary->LoadPipeline( name, &streamDesc, IID_PPV_ARGS( &d3d12PipelineState ) ) );
+    }
+
+    if ( !isLoaded )
+    {
+        ThrowIfFailed( d3d12Device->CreatePipelineState( &streamDesc, IID_PPV_ARGS( &d3d12PipelineState ) ) );
+
+        if ( name[0] )
+        {
+            std::lock_guard<std::mutex> lock( m_LibraryMutex );
+            if ( SUCCEEDED( m_PipelineLibrary->StorePipeline( name, d3d12PipelineState.Get() ) ) )
+            {
+                m_IsLibraryDirty = true;
+            }
+        }
+    }
+
+    std::chrono::duration<double, std::milli> creationTime = std::chrono::high_resolution_clock::now() - startTime;
+
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+
+        if ( isLoaded )
+            ++m_Statistics.NumLibraryHits;
+        else
+            ++m_Statistics.NumPipelineStatesCreated;
+
+        m_Statistics.PipelineStateCreationTime += creationTime.count();
+    }
+
+    return std::make_shared<MakeCachedPipelineStateObject>( m_Device, d3d12PipelineState, desc );
+}
+
+void PipelineStateCache::Resolve( const std::shared_ptr<PipelineStateDesc>& desc, PipelineStatePromise& promise )
+{
+    try
+    {
+        promise.set_value( CreatePipelineStateObject( desc ) );
+    }
+    catch ( ... )
+    {
+        promise.set_exception( std::current_exception() );
+
+        // Don't cache the failure so that the pipeline state can be requested again.
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_PipelineStates.erase( desc->GetHash() );
+        ++m_Statistics.NumPipelineStatesFailed;
+    }
+}
+
+void PipelineStateCache::WorkerThread()
+{
+    while ( true )
+    {
+        PipelineStateJob job;
+        {
+            std::unique_lock<std::mutex> lock( m_Mutex );
+            m_JobsCondition.wait( lock, [this] { return m_bStopWorkers || !m_Jobs.empty(); } );
+
+            // Jobs that are still queued are abandoned (their futures report a broken promise).
+            if ( m_bStopWorkers )
+                return;
+
+            job = std::move( m_Jobs.front() );
+            m_Jobs.pop_front();
+        }
+
+        Resolve( job.Desc, job.Promise );
+
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            --m_NumPendingJobs;
+        }
+        m_JobsDoneCondition.notify_all();
+    }
+}
+
+void PipelineStateCache::WaitForPendingPipelineStates()
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+    m_JobsDoneCondition.wait( lock, [this] { return m_NumPendingJobs == 0; } );
+}
+
+void PipelineStateCache::Save()
+{
+    std::lock_guard<std::mutex> lock( m_LibraryMutex );
+
+    if ( !m_PipelineLibrary || !m_IsLibraryDirty )
+        return;
+
+    std::vector<uint8_t> libraryData( m_PipelineLibrary->GetSerializedSize() );
+    ThrowIfFailed( m_PipelineLibrary->Serialize( libraryData.data(), libraryData.size() ) );
+
+    std::ofstream file( fs::path( m_LibraryFileName ), std::ios::binary | std::ios::trunc );
+    if ( !file )
+    {
+        throw std::exception( "Failed to open pipeline library file for writing." );
+    }
+
+    file.write( reinterpret_cast<const char*>( libraryData.data() ), libraryData.size() );
+
+    m_IsLibraryDirty = false;
+}
+
+PipelineStateCache::Statistics PipelineStateCache::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_Statistics;
+}
+
+void PipelineStateCache::ResetStatistics()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Statistics = Statistics();
+}
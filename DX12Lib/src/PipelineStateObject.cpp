@@ -3,13 +3,23 @@
 #include <dx12lib/PipelineStateObject.h>
 
 #include <dx12lib/Device.h>
+#include <dx12lib/PipelineStateCache.h>
 
 using namespace dx12lib;
 
 PipelineStateObject::PipelineStateObject(Device& device, const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
     : m_Device(device)
+    , m_Desc( std::make_shared<PipelineStateDesc>( desc ) )
 {
     auto d3d12Device = device.GetD3D12Device();
+    auto streamDesc  = m_Desc->GetStreamDesc();
 
-    ThrowIfFailed( d3d12Device->CreatePipelineState( &desc, IID_PPV_ARGS( &m_d3d12PipelineState ) ) );
-}
\ No newline at end of file
+    ThrowIfFailed( d3d12Device->CreatePipelineState( &streamDesc, IID_PPV_ARGS( &m_d3d12PipelineState ) ) );
+}
+
+PipelineStateObject::PipelineStateObject( Device& device, Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState,
+                                          std::shared_ptr<PipelineStateDesc> desc )
+: m_Device( device )
+, m_d3d12PipelineState( pipelineState )
+, m_Desc( desc )
+{}
@@ -12,6 +12,7 @@ RootSignature::RootSignature( Device& device, const D3D12_ROOT_SIGNATURE_DESC1&
 , m_NumDescriptorsPerTable { 0 }
 , m_SamplerTableBitMask( 0 )
 , m_DescriptorTableBitMask( 0 )
+, m_BindlessTableBitMask( 0 )
 {
     SetRootSignatureDesc( rootSignatureDesc );
 }
@@ -42,6 +43,7 @@ void RootSignature::Destroy()
 
     m_DescriptorTableBitMask = 0;
     m_SamplerTableBitMask    = 0;
+    m_BindlessTableBitMask   = 0;
 
     memset( m_NumDescriptorsPerTable, 0, sizeof( m_NumDescriptorsPerTable ) );
 }
@@ -72,8 +74,28 @@ void RootSignature::SetRootSignatureDesc( const D3D12_ROOT_SIGNATURE_DESC1& root
             pParameters[i].DescriptorTable.NumDescriptorRanges = numDescriptorRanges;
             pParameters[i].DescriptorTable.pDescriptorRanges   = pDescriptorRanges;
 
+            // Unbounded descriptor tables reference the bindless descriptor table
+            // and are not staged by the dynamic descriptor heap.
+            bool isUnbounded = false;
+            for ( UINT j = 0; j < numDescriptorRanges; ++j )
+            {
+                if ( pDescriptorRanges[j].NumDescriptors == UINT_MAX )
+                {
+                    isUnbounded = true;
+                }
+            }
+
+            if ( isUnbounded )
+            {
+                if ( numDescriptorRanges != 1 || pDescriptorRanges[0].RangeType != D3D12_DESCRIPTOR_RANGE_TYPE_SRV )
+                {
+                    throw std::exception( "Unbounded descriptor tables must contain a single SRV range." );
+                }
+
+                m_BindlessTableBitMask |= ( 1 << i );
+            }
             // Set the bit mask depending on the type of descriptor table.
-            if ( numDescriptorRanges > 0 )
+            else if ( numDescriptorRanges > 0 )
             {
                 switch ( pDescriptorRanges[0].RangeType )
                 {
@@ -89,7 +111,7 @@ void RootSignature::SetRootSignatureDesc( const D3D12_ROOT_SIGNATURE_DESC1& root
             }
 
             // Count the number of descriptors in the descriptor table.
-            for ( UINT j = 0; j < numDescriptorRanges; ++j )
+            for ( UINT j = 0; j < numDescriptorRanges && !isUnbounded; ++j )
             { m_NumDescriptorsPerTable[i] += pDescriptorRanges[j].NumDescriptors; }
         }
     }
@@ -7,6 +7,7 @@
 #include <dx12lib/Material.h>
 #include <dx12lib/Mesh.h>
 #include <dx12lib/SceneNode.h>
+#include <dx12lib/StreamingUploadQueue.h>
 #include <dx12lib/Texture.h>
 #include <dx12lib/VertexTypes.h>
 #include <dx12lib/Visitor.h>
@@ -154,6 +155,8 @@ void Scene::ImportScene( CommandList& commandList, const aiScene& scene, std::fi
 
     // Import the root node.
     m_RootNode = ImportSceneNode( commandList, nullptr, scene.mRootNode );
+
+    FinishStreamingTextures();
 }
 
 void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material, std::filesystem::path parentPath )
@@ -217,8 +220,10 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
                               &aiBlendOperation ) == aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, true );
-        pMaterial->SetTexture( Material::TextureType::Ambient, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Albedo,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         pMaterial->SetTexture( Material::TextureType::Ambient, texture );
+                     } );
     }
 
     // Load emissive textures.
@@ -227,8 +232,10 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
                               &aiBlendOperation ) == aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, true );
-        pMaterial->SetTexture( Material::TextureType::Emissive, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Albedo,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         pMaterial->SetTexture( Material::TextureType::Emissive, texture );
+                     } );
     }
 
     // Load diffuse textures.
@@ -237,8 +244,10 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
                               &aiBlendOperation ) == aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, true );
-        pMaterial->SetTexture( Material::TextureType::Diffuse, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Albedo,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         pMaterial->SetTexture( Material::TextureType::Diffuse, texture );
+                     } );
     }
 
     // Load specular texture.
@@ -247,8 +256,10 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
                               &aiBlendOperation ) == aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, true );
-        pMaterial->SetTexture( Material::TextureType::Specular, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Albedo,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         pMaterial->SetTexture( Material::TextureType::Specular, texture );
+                     } );
     }
 
     // Load specular power texture.
@@ -257,8 +268,10 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
                               &aiBlendOperation ) == aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, false );
-        pMaterial->SetTexture( Material::TextureType::SpecularPower, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Mask,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         pMaterial->SetTexture( Material::TextureType::SpecularPower, texture );
+                     } );
     }
 
     if ( material.GetTextureCount( aiTextureType_OPACITY ) > 0 &&
@@ -266,8 +279,10 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
                               &aiBlendOperation ) == aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, false );
-        pMaterial->SetTexture( Material::TextureType::Opacity, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Mask,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         pMaterial->SetTexture( Material::TextureType::Opacity, texture );
+                     } );
     }
 
     // Load normal map texture.
@@ -275,8 +290,10 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
          material.GetTexture( aiTextureType_NORMALS, 0, &aiTexturePath ) == aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, false );
-        pMaterial->SetTexture( Material::TextureType::Normal, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Normal,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         pMaterial->SetTexture( Material::TextureType::Normal, texture );
+                     } );
     }
     // Load bump map (only if there is no normal map).
     else if ( material.GetTextureCount( aiTextureType_HEIGHT ) > 0 &&
@@ -284,16 +301,20 @@ void Scene::ImportMaterial( CommandList& commandList, const aiMaterial& material
                   aiReturn_SUCCESS )
     {
         fs::path texturePath( aiTexturePath.C_Str() );
-        auto     texture = commandList.LoadTextureFromFile( parentPath / texturePath, false );
-
-        // Some materials actually store normal maps in the bump map slot. Assimp can't tell the difference between
-        // these two texture types, so we try to make an assumption about whether the texture is a normal map or a bump
-        // map based on its pixel depth. Bump maps are usually 8 BPP (grayscale) and normal maps are usually 24 BPP or
-        // higher.
-        Material::TextureType textureType =
-            ( texture->BitsPerPixel() >= 24 ) ? Material::TextureType::Normal : Material::TextureType::Bump;
-
-        pMaterial->SetTexture( textureType, texture );
+        LoadTexture( commandList, parentPath / texturePath, TextureUsage::Bump,
+                     [pMaterial]( std::shared_ptr<Texture> texture ) {
+                         // Some materials actually store normal maps in the bump map slot. Assimp can't tell the
+                         // difference between these two texture types, so we try to make an assumption about whether
+                         // the texture is a normal map or a bump map based on its pixel depth. Bump maps are usually
+                         // 8 BPP (grayscale) and normal maps are usually 24 BPP or higher. The texture cooker makes
+                         // the same assumption and compresses normal maps to BC5.
+                         bool isNormalMap = texture->BitsPerPixel() >= 24 ||
+                                            texture->GetD3D12ResourceDesc().Format == DXGI_FORMAT_BC5_UNORM;
+                         Material::TextureType textureType =
+                             isNormalMap ? Material::TextureType::Normal : Material::TextureType::Bump;
+
+                         pMaterial->SetTexture( textureType, texture );
+                     } );
     }
 
     // m_MaterialMap.insert( MaterialMap::value_type( materialName.C_Str(), pMaterial ) );
@@ -395,6 +416,60 @@ void Scene::ImportMesh( CommandList& commandList, const aiMesh& aiMesh )
     m_Meshes.push_back( mesh );
 }
 
+void Scene::LoadTexture( CommandList& commandList, const fs::path& fileName, TextureUsage usage,
+                         SetTextureFunc setTexture )
+{
+    auto& device               = commandList.GetDevice();
+    auto  streamingUploadQueue = device.GetStreamingUploadQueue();
+
+    // EXR files are loaded as tiled textures, which are not streamed.
+    if ( !streamingUploadQueue || fileName.extension() == ".exr" )
+    {
+        setTexture( commandList.LoadTextureFromFile( fileName, usage ) );
+        return;
+    }
+
+    // The cooked texture has a full mip chain and the sRGB format is set by the cooker
+    // (see CommandList::LoadTextureFromFile).
+    std::wstring textureFile = fileName;
+    bool         sRGB        = usage == TextureUsage::Albedo;
+    if ( auto textureCooker = device.GetTextureCooker() )
+    {
+        textureFile = textureCooker->Cook( textureFile, usage );
+        sRGB        = false;
+    }
+
+    auto& request = m_StreamingRequests[textureFile];
+    if ( !request )
+    {
+        // Color textures are streamed first, they have the largest impact on the image.
+        auto priority = usage == TextureUsage::Albedo ? StreamingPriority::High : StreamingPriority::Normal;
+        request       = streamingUploadQueue->RequestTexture( textureFile, sRGB, priority );
+    }
+
+    m_StreamingTextures.emplace_back( request, std::move( setTexture ) );
+}
+
+void Scene::FinishStreamingTextures()
+{
+    // The streaming upload queue only uploads a frame's budget each frame, so the
+    // textures are done only if the application keeps presenting frames
+    // (see Device::SetStreamingUploadQueue).
+    for ( auto& streamingTexture: m_StreamingTextures )
+    {
+        auto& request = streamingTexture.first;
+
+        // Rethrows the exception if the texture could not be loaded.
+        if ( request->GetFuture().get() )
+        {
+            streamingTexture.second( request->GetTexture() );
+        }
+    }
+
+    m_StreamingTextures.clear();
+    m_StreamingRequests.clear();
+}
+
 std::shared_ptr<SceneNode> Scene::ImportSceneNode( CommandList& commandList, std::shared_ptr<SceneNode> parent,
                                                    const aiNode* aiNode )
 {
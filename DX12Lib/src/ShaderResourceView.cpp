@@ -17,6 +17,11 @@ ShaderResourceView::ShaderResourceView( Device& device, const std::shared_ptr<Re
     auto d3d12Resource = m_Resource ? m_Resource->GetD3D12Resource() : nullptr;
     auto d3d12Device   = m_Device.GetD3D12Device();
 
+    if ( srv )
+    {
+        m_Desc = std::make_unique<D3D12_SHADER_RESOURCE_VIEW_DESC>( *srv );
+    }
+
     m_Descriptor = m_Device.AllocateDescriptors( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
 
     d3d12Device->CreateShaderResourceView( d3d12Resource.Get(), srv, m_Descriptor.GetDescriptorHandle() );
@@ -0,0 +1,151 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/StagingAllocator.h>
+
+#include <dx12lib/Device.h>
+#include <dx12lib/Helpers.h>
+
+using namespace dx12lib;
+
+StagingAllocator::StagingAllocator( Device& device, size_t chunkSize )
+: m_Device( device )
+, m_ChunkSize( chunkSize )
+{}
+
+StagingAllocator::~StagingAllocator() {}
+
+std::shared_ptr<StagingAllocator::Chunk> StagingAllocator::RequestChunk( size_t sizeInBytes )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    // Allocations that don't fit in a regular chunk get a dedicated chunk.
+    if ( sizeInBytes > m_ChunkSize )
+    {
+        ++m_Statistics.NumUploadResourcesCreated;
+        return std::make_shared<Chunk>( m_Device, Math::AlignUp( sizeInBytes, _64KB ) );
+    }
+
+    std::shared_ptr<Chunk> chunk;
+
+    if ( !m_AvailableChunks.empty() )
+    {
+        chunk = m_AvailableChunks.front();
+        m_AvailableChunks.pop_front();
+
+        ++m_Statistics.NumChunksRecycled;
+    }
+    else
+    {
+        chunk = std::make_shared<Chunk>( m_Device, m_ChunkSize );
+
+        ++m_Statistics.NumUploadResourcesCreated;
+    }
+
+    return chunk;
+}
+
+void StagingAllocator::RetireChunk( const std::shared_ptr<Chunk>& chunk )
+{
+    assert( chunk );
+
+    // Dedicated chunks are released as soon as they retire.
+    if ( chunk->GetSize() != m_ChunkSize )
+        return;
+
+    chunk->Reset();
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_AvailableChunks.push_back( chunk );
+}
+
+void StagingAllocator::Trim()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_AvailableChunks.clear();
+}
+
+void StagingAllocator::RecordBatch( uint64_t numUploads, uint64_t numBytes )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    ++m_Statistics.NumBatches;
+    m_Statistics.NumUploads += numUploads;
+    m_Statistics.BytesUploaded += numBytes;
+}
+
+void StagingAllocator::RecordCompletion( uint64_t numBytes, std::chrono::high_resolution_clock::duration elapsedTime )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    m_Statistics.BytesCompleted += numBytes;
+    m_Statistics.UploadSeconds += std::chrono::duration<double>( elapsedTime ).count();
+}
+
+StagingAllocator::Statistics StagingAllocator::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_Statistics;
+}
+
+void StagingAllocator::ResetStatistics()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Statistics = Statistics();
+}
+
+StagingAllocator::Chunk::Chunk( Device& device, size_t sizeInBytes )
+: m_CPUPtr( nullptr )
+, m_Size( sizeInBytes )
+, m_Offset( 0 )
+{
+    auto d3d12Device = device.GetD3D12Device();
+
+    ThrowIfFailed( d3d12Device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES( D3D12_HEAP_TYPE_UPLOAD ), D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer( m_Size ), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+        IID_PPV_ARGS( &m_d3d12Resource ) ) );
+
+    m_d3d12Resource->SetName( L"Staging Buffer (Chunk)" );
+
+    // Upload heaps are never read by the CPU.
+    CD3DX12_RANGE readRange( 0, 0 );
+    ThrowIfFailed( m_d3d12Resource->Map( 0, &readRange, &m_CPUPtr ) );
+}
+
+StagingAllocator::Chunk::~Chunk()
+{
+    m_d3d12Resource->Unmap( 0, nullptr );
+    m_CPUPtr = nullptr;
+}
+
+bool StagingAllocator::Chunk::HasSpace( size_t sizeInBytes, size_t alignment ) const
+{
+    size_t alignedOffset = Math::AlignUp( m_Offset, alignment );
+
+    return alignedOffset + sizeInBytes <= m_Size;
+}
+
+StagingAllocator::Allocation StagingAllocator::Chunk::Allocate( size_t sizeInBytes, size_t alignment )
+{
+    if ( !HasSpace( sizeInBytes, alignment ) )
+    {
+        // Can't allocate space from chunk.
+        throw std::bad_alloc();
+    }
+
+    m_Offset = Math::AlignUp( m_Offset, alignment );
+
+    Allocation allocation;
+    allocation.CPU      = static_cast<uint8_t*>( m_CPUPtr ) + m_Offset;
+    allocation.Resource = m_d3d12Resource.Get();
+    allocation.Offset   = m_Offset;
+
+    m_Offset += sizeInBytes;
+
+    return allocation;
+}
+
+void StagingAllocator::Chunk::Reset()
+{
+    m_Offset = 0;
+}
@@ -0,0 +1,717 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/StreamingUploadQueue.h>
+
+#include <dx12lib/CommandList.h>
+#include <dx12lib/CommandQueue.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/Helpers.h>
+#include <dx12lib/Resource.h>
+#include <dx12lib/Texture.h>
+
+#include <cmath>  // For std::log2
+
+using namespace dx12lib;
+
+StreamingRequest::StreamingRequest( uint64_t id, StreamingPriority priority, CompletionCallback completionCallback )
+: m_Id( id )
+, m_Priority( priority )
+, m_CompletionCallback( std::move( completionCallback ) )
+, m_Future( m_Promise.get_future().share() )
+, m_Status( Status::Queued )
+, m_bCancelled( false )
+, m_MostDetailedResidentMip( -1 )
+, m_SubmitTime( Clock::now() )
+, m_sRGB( false )
+, m_NextUploadUnit( 0 )
+, m_NumCompletedUploadUnits( 0 )
+{}
+
+StreamingRequest::~StreamingRequest() {}
+
+std::shared_ptr<Resource> StreamingRequest::GetResource() const
+{
+    std::lock_guard<std::mutex> lock( m_ResourceMutex );
+    return m_Resource;
+}
+
+std::shared_ptr<Texture> StreamingRequest::GetTexture() const
+{
+    std::lock_guard<std::mutex> lock( m_ResourceMutex );
+    return m_Texture;
+}
+
+// Adapter for std::make_shared
+class MakeStreamingRequest : public StreamingRequest
+{
+public:
+    MakeStreamingRequest( uint64_t id, StreamingPriority priority, CompletionCallback completionCallback )
+    : StreamingRequest( id, priority, std::move( completionCallback ) )
+    {}
+
+    virtual ~MakeStreamingRequest() {}
+};
+
+StreamingUploadQueue::StreamingUploadQueue( Device& device, uint64_t frameBudget )
+: m_Device( device )
+, m_NextRequestId( 0 )
+, m_FrameBudget( frameBudget )
+, m_FrameBudgetRemaining( static_cast<int64_t>( frameBudget ) )
+, m_BytesThisFrame( 0 )
+, m_NumFlushRequests( 0 )
+, m_bProcessRequests( true )
+{
+    m_Statistics.FrameBudget = m_FrameBudget;
+
+    m_ProcessRequestsThread = std::thread( &StreamingUploadQueue::ProcessRequests, this );
+}
+
+StreamingUploadQueue::~StreamingUploadQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_bProcessRequests = false;
+    }
+    m_ProcessRequestsCV.notify_one();
+
+    if ( m_ProcessRequestsThread.joinable() )
+    {
+        m_ProcessRequestsThread.join();
+    }
+
+    // Wait for the batches that are still in flight and cancel any requests that
+    // were not serviced.
+    auto&                                          commandQueue = m_Device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_COPY );
+    std::vector<std::shared_ptr<StreamingRequest>> doneRequests;
+
+    if ( !m_InFlightBatches.empty() )
+    {
+        commandQueue.WaitForFenceValue( m_InFlightBatches.back().FenceValue );
+        RetireBatches( commandQueue, doneRequests );
+    }
+
+    for ( auto& requestQueue: m_RequestQueues )
+    {
+        for ( auto& request: requestQueue )
+        {
+            request->m_Status = StreamingRequest::Status::Cancelled;
+            doneRequests.push_back( request );
+        }
+        requestQueue.clear();
+    }
+
+    for ( auto& request: doneRequests )
+    {
+        FinishRequest( *request );
+    }
+}
+
+std::shared_ptr<StreamingRequest>
+    StreamingUploadQueue::RequestTexture( const std::wstring& fileName, bool sRGB, StreamingPriority priority,
+                                          StreamingRequest::CompletionCallback completionCallback )
+{
+    if ( !fs::exists( fileName ) )
+    {
+        throw std::exception( "File not found." );
+    }
+
+    auto request = std::make_shared<MakeStreamingRequest>( m_NextRequestId++, priority, std::move( completionCallback ) );
+    request->m_FileName = fileName;
+    request->m_sRGB     = sRGB;
+
+    return Enqueue( request );
+}
+
+std::shared_ptr<StreamingRequest>
+    StreamingUploadQueue::RequestTexture( std::unique_ptr<ScratchImage> scratchImage, StreamingPriority priority,
+                                          StreamingRequest::CompletionCallback completionCallback )
+{
+    if ( !scratchImage || scratchImage->GetImageCount() == 0 )
+    {
+        throw std::exception( "Invalid scratch image." );
+    }
+
+    auto request = std::make_shared<MakeStreamingRequest>( m_NextRequestId++, priority, std::move( completionCallback ) );
+    request->m_ScratchImage = std::move( scratchImage );
+
+    // Create the texture immediately so that it can be retrieved from the request.
+    PrepareRequest( *request );
+
+    return Enqueue( request );
+}
+
+std::shared_ptr<StreamingRequest>
+    StreamingUploadQueue::RequestBuffer( const std::shared_ptr<Resource>& buffer, std::vector<uint8_t> bufferData,
+                                         StreamingPriority                    priority,
+                                         StreamingRequest::CompletionCallback completionCallback )
+{
+    if ( !buffer || bufferData.empty() )
+    {
+        throw std::exception( "Invalid buffer upload." );
+    }
+
+    auto request = std::make_shared<MakeStreamingRequest>( m_NextRequestId++, priority, std::move( completionCallback ) );
+    request->m_Resource   = buffer;
+    request->m_BufferData = std::move( bufferData );
+
+    PrepareRequest( *request );
+
+    return Enqueue( request );
+}
+
+std::shared_ptr<StreamingRequest> StreamingUploadQueue::Enqueue( std::shared_ptr<StreamingRequest> request )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_RequestQueues[static_cast<size_t>( request->GetPriority() )].push_back( request );
+    }
+    m_ProcessRequestsCV.notify_one();
+
+    return request;
+}
+
+void StreamingUploadQueue::Cancel( const std::shared_ptr<StreamingRequest>& request )
+{
+    if ( request )
+    {
+        request->Cancel();
+        m_ProcessRequestsCV.notify_one();
+    }
+}
+
+void StreamingUploadQueue::BeginFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+
+        m_Statistics.BytesLastFrame   = m_BytesThisFrame;
+        m_Statistics.MaxBytesPerFrame = std::max( m_Statistics.MaxBytesPerFrame, m_BytesThisFrame );
+        ++m_Statistics.NumFrames;
+
+        // Any overdraft from the previous frame is carried over but unused budget is not.
+        m_FrameBudgetRemaining = std::min<int64_t>( m_FrameBudgetRemaining, 0 ) + static_cast<int64_t>( m_FrameBudget );
+        m_BytesThisFrame       = 0;
+    }
+    m_ProcessRequestsCV.notify_one();
+}
+
+void StreamingUploadQueue::SetFrameBudget( uint64_t frameBudget )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    m_FrameBudget            = frameBudget;
+    m_Statistics.FrameBudget = frameBudget;
+}
+
+uint64_t StreamingUploadQueue::GetFrameBudget() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_FrameBudget;
+}
+
+void StreamingUploadQueue::Flush()
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+
+    ++m_NumFlushRequests;
+    m_ProcessRequestsCV.notify_one();
+    m_RequestDoneCV.wait( lock, [this] { return IsIdle(); } );
+    --m_NumFlushRequests;
+}
+
+StreamingUploadQueue::Statistics StreamingUploadQueue::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    Statistics statistics = m_Statistics;
+
+    statistics.QueueDepth = 0;
+    for ( const auto& requestQueue: m_RequestQueues )
+    {
+        statistics.QueueDepth += requestQueue.size();
+    }
+    statistics.NumBatchesInFlight = m_InFlightBatches.size();
+
+    return statistics;
+}
+
+void StreamingUploadQueue::ResetStatistics()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    m_Statistics             = Statistics();
+    m_Statistics.FrameBudget = m_FrameBudget;
+}
+
+bool StreamingUploadQueue::HasQueuedRequests() const
+{
+    for ( const auto& requestQueue: m_RequestQueues )
+    {
+        if ( !requestQueue.empty() )
+            return true;
+    }
+    return false;
+}
+
+bool StreamingUploadQueue::IsIdle() const
+{
+    return !HasQueuedRequests() && m_InFlightBatches.empty();
+}
+
+void StreamingUploadQueue::ProcessRequests()
+{
+    auto& commandQueue = m_Device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_COPY );
+
+    std::vector<std::shared_ptr<StreamingRequest>> doneRequests;
+
+    while ( m_bProcessRequests )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_Mutex );
+
+            auto canProcess = [this] {
+                return !m_bProcessRequests ||
+                       ( HasQueuedRequests() && ( m_FrameBudgetRemaining > 0 || m_NumFlushRequests > 0 ) );
+            };
+
+            if ( m_InFlightBatches.empty() )
+            {
+                m_ProcessRequestsCV.wait( lock, canProcess );
+            }
+            else
+            {
+                // Poll for batches that have finished executing on the copy queue.
+                m_ProcessRequestsCV.wait_for( lock, std::chrono::milliseconds( 1 ), canProcess );
+            }
+        }
+
+        if ( !m_bProcessRequests )
+            break;
+
+        RetireBatches( commandQueue, doneRequests );
+        RecordBatch( commandQueue, doneRequests );
+
+        for ( auto& request: doneRequests )
+        {
+            FinishRequest( *request );
+        }
+        doneRequests.clear();
+
+        {
+            // Make sure a thread that is about to wait in Flush doesn't miss the notification.
+            std::lock_guard<std::mutex> lock( m_Mutex );
+        }
+        m_RequestDoneCV.notify_all();
+    }
+}
+
+std::shared_ptr<StreamingRequest>
+    StreamingUploadQueue::GetNextRequest( std::vector<std::shared_ptr<StreamingRequest>>& doneRequests )
+{
+    // Service the highest priority first.
+    for ( auto iter = m_RequestQueues.rbegin(); iter != m_RequestQueues.rend(); ++iter )
+    {
+        auto& requestQueue = *iter;
+        while ( !requestQueue.empty() )
+        {
+            auto request = requestQueue.front();
+            if ( !request->IsCancelled() )
+            {
+                return request;
+            }
+
+            requestQueue.pop_front();
+
+            // If some of the upload units are still in flight, the request is
+            // finished when they are retired.
+            if ( request->m_NumCompletedUploadUnits == request->m_NextUploadUnit )
+            {
+                request->m_Status = StreamingRequest::Status::Cancelled;
+                doneRequests.push_back( request );
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void StreamingUploadQueue::RemoveRequest( const std::shared_ptr<StreamingRequest>& request )
+{
+    auto& requestQueue = m_RequestQueues[static_cast<size_t>( request->GetPriority() )];
+    auto  iter         = std::find( requestQueue.begin(), requestQueue.end(), request );
+    if ( iter != requestQueue.end() )
+    {
+        requestQueue.erase( iter );
+    }
+}
+
+void StreamingUploadQueue::PrepareRequest( StreamingRequest& request )
+{
+    if ( !request.m_FileName.empty() )
+    {
+        fs::path filePath( request.m_FileName );
+        auto     scratchImage = std::make_unique<ScratchImage>();
+
+        if ( filePath.extension() == ".dds" )
+        {
+            ThrowIfFailed( LoadFromDDSFile( filePath.c_str(), DDS_FLAGS_FORCE_RGB, nullptr, *scratchImage ) );
+        }
+        else if ( filePath.extension() == ".hdr" )
+        {
+            ThrowIfFailed( LoadFromHDRFile( filePath.c_str(), nullptr, *scratchImage ) );
+        }
+        else if ( filePath.extension() == ".tga" )
+        {
+            ThrowIfFailed( LoadFromTGAFile( filePath.c_str(), nullptr, *scratchImage ) );
+        }
+        else
+        {
+            ThrowIfFailed( LoadFromWICFile( filePath.c_str(), WIC_FLAGS_FORCE_RGB, nullptr, *scratchImage ) );
+        }
+
+        request.m_ScratchImage = std::move( scratchImage );
+    }
+
+    if ( request.m_ScratchImage )
+    {
+        TexMetadata metadata = request.m_ScratchImage->GetMetadata();
+
+        // Mips can't be generated on the copy queue so generate the mip chain on the CPU.
+        if ( metadata.mipLevels == 1 && metadata.dimension == TEX_DIMENSION_TEXTURE2D &&
+             !IsCompressed( metadata.format ) && ( metadata.width > 1 || metadata.height > 1 ) )
+        {
+            DWORD filter   = request.m_sRGB ? TEX_FILTER_SRGB : TEX_FILTER_DEFAULT;
+            auto  mipChain = std::make_unique<ScratchImage>();
+
+            ThrowIfFailed( GenerateMipMaps( request.m_ScratchImage->GetImages(),
+                                            request.m_ScratchImage->GetImageCount(), metadata, filter, 0,
+                                            *mipChain ) );
+
+            request.m_ScratchImage = std::move( mipChain );
+            metadata               = request.m_ScratchImage->GetMetadata();
+        }
+
+        // Force the texture format to be sRGB to convert to linear when sampling the texture in a shader.
+        if ( request.m_sRGB )
+        {
+            metadata.format = MakeSRGB( metadata.format );
+        }
+
+        D3D12_RESOURCE_DESC textureDesc = {};
+        switch ( metadata.dimension )
+        {
+        case TEX_DIMENSION_TEXTURE1D:
+            textureDesc = CD3DX12_RESOURCE_DESC::Tex1D( metadata.format, static_cast<UINT64>( metadata.width ),
+                                                        static_cast<UINT16>( metadata.arraySize ),
+                                                        static_cast<UINT16>( metadata.mipLevels ) );
+            break;
+        case TEX_DIMENSION_TEXTURE2D:
+            textureDesc = CD3DX12_RESOURCE_DESC::Tex2D( metadata.format, static_cast<UINT64>( metadata.width ),
+                                                        static_cast<UINT>( metadata.height ),
+                                                        static_cast<UINT16>( metadata.arraySize ),
+                                                        static_cast<UINT16>( metadata.mipLevels ) );
+            break;
+        case TEX_DIMENSION_TEXTURE3D:
+            textureDesc = CD3DX12_RESOURCE_DESC::Tex3D( metadata.format, static_cast<UINT64>( metadata.width ),
+                                                        static_cast<UINT>( metadata.height ),
+                                                        static_cast<UINT16>( metadata.depth ),
+                                                        static_cast<UINT16>( metadata.mipLevels ) );
+            break;
+        default:
+            throw std::exception( "Invalid texture dimension." );
+            break;
+        }
+
+        auto texture = m_Device.CreateTexture( textureDesc );
+        texture->SetName( request.m_FileName.empty() ? L"Streaming Texture" : request.m_FileName );
+
+        // Split the subresources into ranges of rows that fit in the frame budget (like buffers),
+        // from the least detailed mip level to the most detailed. 3D textures are split into
+        // ranges of depth slices.
+        size_t unitSize = std::max<size_t>( static_cast<size_t>( GetFrameBudget() ), _64KB );
+
+        request.m_UploadUnits.clear();
+        for ( size_t mip = metadata.mipLevels; mip-- > 0; )
+        {
+            for ( size_t item = 0; item < metadata.arraySize; ++item )
+            {
+                const Image* image = request.m_ScratchImage->GetImage( mip, item, 0 );
+
+                size_t numRows, rowSize;
+                if ( metadata.dimension == TEX_DIMENSION_TEXTURE3D )
+                {
+                    numRows = std::max<size_t>( metadata.depth >> mip, 1 );
+                    rowSize = image->slicePitch;
+                }
+                else
+                {
+                    numRows = image->slicePitch / image->rowPitch;
+                    rowSize = image->rowPitch;
+                }
+
+                size_t rowsPerUnit = std::max<size_t>( unitSize / rowSize, 1 );
+                for ( size_t row = 0; row < numRows; row += rowsPerUnit )
+                {
+                    size_t unitRows = std::min( rowsPerUnit, numRows - row );
+                    request.m_UploadUnits.push_back( { static_cast<uint32_t>( mip ), static_cast<uint32_t>( item ),
+                                                       static_cast<uint32_t>( row ), static_cast<uint32_t>( unitRows ),
+                                                       0, unitRows * rowSize, false } );
+                }
+            }
+
+            request.m_UploadUnits.back().CompletesMip = true;
+        }
+
+        std::lock_guard<std::mutex> lock( request.m_ResourceMutex );
+        request.m_Resource = texture;
+        request.m_Texture  = texture;
+    }
+    else
+    {
+        // Split buffers into ranges that fit in the frame budget.
+        size_t bufferSize = request.m_BufferData.size();
+        size_t unitSize   = std::max<size_t>( static_cast<size_t>( GetFrameBudget() ), _64KB );
+
+        request.m_UploadUnits.clear();
+        for ( size_t offset = 0; offset < bufferSize; offset += unitSize )
+        {
+            request.m_UploadUnits.push_back( { 0, 0, 0, 0, offset, std::min( unitSize, bufferSize - offset ), false } );
+        }
+    }
+}
+
+void StreamingUploadQueue::RecordBatch( CommandQueue&                                   commandQueue,
+                                        std::vector<std::shared_ptr<StreamingRequest>>& doneRequests )
+{
+    std::shared_ptr<CommandList> commandList;
+    InFlightBatch                batch;
+
+    while ( true )
+    {
+        std::shared_ptr<StreamingRequest> request;
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            if ( m_FrameBudgetRemaining <= 0 && m_NumFlushRequests == 0 )
+                break;
+
+            request = GetNextRequest( doneRequests );
+        }
+
+        if ( !request )
+            break;
+
+        // Textures that are loaded from a file are prepared on the streaming thread.
+        if ( request->m_UploadUnits.empty() )
+        {
+            try
+            {
+                PrepareRequest( *request );
+            }
+            catch ( ... )
+            {
+                request->m_Status = StreamingRequest::Status::Failed;
+                {
+                    std::lock_guard<std::mutex> lock( m_Mutex );
+                    RemoveRequest( request );
+                }
+                FinishRequest( *request, std::current_exception() );
+                continue;
+            }
+        }
+
+        if ( !commandList )
+        {
+            commandList = commandQueue.GetCommandList();
+        }
+
+        auto uploadUnit = request->m_UploadUnits[request->m_NextUploadUnit++];
+        RecordUploadUnit( *commandList, *request, uploadUnit );
+
+        request->m_Status = StreamingRequest::Status::Uploading;
+        batch.RecordedUnits.push_back( { request, uploadUnit.MipLevel, uploadUnit.CompletesMip } );
+
+        // The source data has been copied to staging memory once all units are recorded.
+        bool isRecorded = request->m_NextUploadUnit == request->m_UploadUnits.size();
+        if ( isRecorded )
+        {
+            request->m_ScratchImage.reset();
+            request->m_BufferData.clear();
+            request->m_BufferData.shrink_to_fit();
+        }
+
+        std::lock_guard<std::mutex> lock( m_Mutex );
+
+        m_FrameBudgetRemaining -= static_cast<int64_t>( uploadUnit.NumBytes );
+        m_BytesThisFrame += uploadUnit.NumBytes;
+        m_Statistics.TotalBytes += uploadUnit.NumBytes;
+
+        if ( isRecorded )
+        {
+            RemoveRequest( request );
+        }
+    }
+
+    if ( commandList )
+    {
+        batch.FenceValue = commandQueue.ExecuteCommandList( commandList );
+
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_InFlightBatches.push_back( std::move( batch ) );
+    }
+}
+
+void StreamingUploadQueue::RecordUploadUnit( CommandList& commandList, StreamingRequest& request,
+                                             const StreamingRequest::UploadUnit& uploadUnit )
+{
+    if ( request.m_Texture )
+    {
+        const auto&  metadata = request.m_ScratchImage->GetMetadata();
+        const Image* image    = request.m_ScratchImage->GetImage( uploadUnit.MipLevel, uploadUnit.ArraySlice, 0 );
+
+        UINT subresourceIndex = D3D12CalcSubresource( uploadUnit.MipLevel, uploadUnit.ArraySlice, 0,
+                                                      static_cast<UINT>( metadata.mipLevels ),
+                                                      static_cast<UINT>( metadata.arraySize ) );
+
+        uint32_t width  = static_cast<uint32_t>( image->width );
+        uint32_t height = static_cast<uint32_t>( image->height );
+
+        D3D12_SUBRESOURCE_DATA subresource;
+        subresource.RowPitch = image->rowPitch;
+
+        if ( metadata.dimension == TEX_DIMENSION_TEXTURE3D )
+        {
+            // The depth slices of a mip level are contiguous in the scratch image.
+            subresource.pData      = image->pixels + uploadUnit.FirstRow * image->slicePitch;
+            subresource.SlicePitch = image->slicePitch;
+
+            commandList.CopyTextureRegion( request.m_Texture, subresourceIndex, 0, 0, uploadUnit.FirstRow, width,
+                                           height, uploadUnit.NumRows, subresource );
+        }
+        else
+        {
+            // Block-compressed formats are addressed in rows of 4x4 blocks.
+            uint32_t rowHeight = IsCompressed( image->format ) ? 4 : 1;
+            uint32_t y         = uploadUnit.FirstRow * rowHeight;
+
+            subresource.pData      = image->pixels + uploadUnit.FirstRow * image->rowPitch;
+            subresource.SlicePitch = image->rowPitch * uploadUnit.NumRows;
+
+            commandList.CopyTextureRegion( request.m_Texture, subresourceIndex, 0, y, 0, width,
+                                           std::min( uploadUnit.NumRows * rowHeight, height - y ), 1, subresource );
+        }
+    }
+    else
+    {
+        commandList.CopyBufferRegion( request.m_Resource, uploadUnit.Offset, uploadUnit.NumBytes,
+                                      request.m_BufferData.data() + uploadUnit.Offset );
+    }
+}
+
+void StreamingUploadQueue::RetireBatches( CommandQueue&                                   commandQueue,
+                                          std::vector<std::shared_ptr<StreamingRequest>>& doneRequests )
+{
+    while ( true )
+    {
+        InFlightBatch batch;
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            if ( m_InFlightBatches.empty() || !commandQueue.IsFenceComplete( m_InFlightBatches.front().FenceValue ) )
+                break;
+
+            batch = std::move( m_InFlightBatches.front() );
+            m_InFlightBatches.pop_front();
+        }
+
+        for ( auto& recordedUnit: batch.RecordedUnits )
+        {
+            auto& request = *recordedUnit.Request;
+
+            ++request.m_NumCompletedUploadUnits;
+
+            if ( request.m_Texture && recordedUnit.CompletesMip )
+            {
+                // Mips are uploaded from the least detailed to the most detailed.
+                int32_t mip = static_cast<int32_t>( recordedUnit.MipLevel );
+                if ( request.m_MostDetailedResidentMip < 0 )
+                {
+                    std::lock_guard<std::mutex> lock( m_Mutex );
+                    RecordLatency( m_Statistics.FirstMipLatency, StreamingRequest::Clock::now() - request.m_SubmitTime );
+                }
+                if ( request.m_MostDetailedResidentMip < 0 || mip < request.m_MostDetailedResidentMip )
+                {
+                    request.m_MostDetailedResidentMip = mip;
+                }
+            }
+
+            if ( request.m_NumCompletedUploadUnits == request.m_UploadUnits.size() )
+            {
+                request.m_Status = StreamingRequest::Status::Completed;
+                doneRequests.push_back( recordedUnit.Request );
+            }
+            else if ( request.IsCancelled() && request.m_NumCompletedUploadUnits == request.m_NextUploadUnit )
+            {
+                request.m_Status = StreamingRequest::Status::Cancelled;
+                {
+                    std::lock_guard<std::mutex> lock( m_Mutex );
+                    RemoveRequest( recordedUnit.Request );
+                }
+                doneRequests.push_back( recordedUnit.Request );
+            }
+        }
+    }
+}
+
+void StreamingUploadQueue::FinishRequest( StreamingRequest& request, std::exception_ptr exception )
+{
+    auto status      = request.GetStatus();
+    bool isCompleted = status == StreamingRequest::Status::Completed;
+
+    request.m_ScratchImage.reset();
+    request.m_BufferData.clear();
+    request.m_BufferData.shrink_to_fit();
+
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        switch ( status )
+        {
+        case StreamingRequest::Status::Completed:
+            ++m_Statistics.NumCompleted;
+            RecordLatency( m_Statistics.CompletionLatency[static_cast<size_t>( request.GetPriority() )],
+                           StreamingRequest::Clock::now() - request.m_SubmitTime );
+            break;
+        case StreamingRequest::Status::Cancelled:
+            ++m_Statistics.NumCancelled;
+            break;
+        case StreamingRequest::Status::Failed:
+            ++m_Statistics.NumFailed;
+            break;
+        }
+    }
+
+    if ( exception )
+    {
+        request.m_Promise.set_exception( exception );
+    }
+    else
+    {
+        request.m_Promise.set_value( isCompleted );
+    }
+
+    if ( request.m_CompletionCallback )
+    {
+        request.m_CompletionCallback( isCompleted );
+    }
+}
+
+void StreamingUploadQueue::RecordLatency( LatencyHistogram& histogram, StreamingRequest::Clock::duration latency )
+{
+    double milliseconds = std::chrono::duration<double, std::milli>( latency ).count();
+
+    size_t bucket = 0;
+    if ( milliseconds >= 1.0 )
+    {
+        bucket = std::min( static_cast<size_t>( std::log2( milliseconds ) ) + 1, NumLatencyBuckets - 1 );
+    }
+
+    ++histogram[bucket];
+}
@@ -5,6 +5,7 @@
 #include <dx12lib/Adapter.h>
 #include <dx12lib/CommandList.h>
 #include <dx12lib/CommandQueue.h>
+#include <dx12lib/CommandRecorder.h>
 #include <dx12lib/Device.h>
 #include <dx12lib/GUI.h>
 #include <dx12lib/RenderTarget.h>
@@ -172,6 +173,9 @@ UINT SwapChain::Present( const std::shared_ptr<Texture>& texture )
     commandList->TransitionBarrier( backBuffer, D3D12_RESOURCE_STATE_PRESENT );
     m_CommandQueue.ExecuteCommandList( commandList );
 
+    // The present marks the end of a frame in a capture.
+    m_Device.GetCommandRecorder().EndFrame();
+
     UINT syncInterval = m_VSync ? 1 : 0;
     UINT presentFlags = m_TearingSupported && !m_Fullscreen && !m_VSync ? DXGI_PRESENT_ALLOW_TEARING : 0;
     ThrowIfFailed( m_dxgiSwapChain->Present( syncInterval, presentFlags ) );
@@ -0,0 +1,371 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/TextureCooker.h>
+
+#include <dx12lib/Helpers.h>
+#include <dx12lib/PipelineStateCache.h>
+
+#include <cstring>
+#include <fstream>
+
+using namespace dx12lib;
+
+// Increment to invalidate the cooked textures when the cooking process changes.
+static const uint32_t CookerVersion = 2;
+
+// Mips are compressed in strips of this many rows of texels (a multiple of the block size).
+static const size_t StripHeight = 32;
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double ElapsedMilliseconds( Clock::time_point start )
+{
+    return std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+}
+
+static std::vector<uint8_t> ReadFileData( const fs::path& filePath )
+{
+    std::ifstream file( filePath, std::ios::binary | std::ios::ate );
+    if ( !file )
+    {
+        throw std::exception( "Failed to open texture file." );
+    }
+
+    std::vector<uint8_t> data( static_cast<size_t>( file.tellg() ) );
+    file.seekg( 0 );
+    if ( !file.read( reinterpret_cast<char*>( data.data() ), data.size() ) )
+    {
+        throw std::exception( "Failed to read texture file." );
+    }
+
+    return data;
+}
+
+static void LoadImageFromMemory( const fs::path& filePath, const std::vector<uint8_t>& data, TexMetadata& metadata,
+                                 ScratchImage& image )
+{
+    if ( filePath.extension() == ".dds" )
+    {
+        ThrowIfFailed( LoadFromDDSMemory( data.data(), data.size(), DDS_FLAGS_FORCE_RGB, &metadata, image ) );
+    }
+    else if ( filePath.extension() == ".hdr" )
+    {
+        ThrowIfFailed( LoadFromHDRMemory( data.data(), data.size(), &metadata, image ) );
+    }
+    else if ( filePath.extension() == ".tga" )
+    {
+        ThrowIfFailed( LoadFromTGAMemory( data.data(), data.size(), &metadata, image ) );
+    }
+    else
+    {
+        ThrowIfFailed( LoadFromWICMemory( data.data(), data.size(), WIC_FLAGS_FORCE_RGB, &metadata, image ) );
+    }
+}
+
+// Compress all images (mips and array slices) of an image to the (already
+// initialized) images of the destination. Each image is split into strips that
+// are compressed on their own so that large mips are spread over all threads.
+static HRESULT CompressParallel( const ScratchImage& source, ScratchImage& destination, DWORD compressFlags,
+                                 uint32_t numThreads )
+{
+    struct Strip
+    {
+        size_t Image;
+        size_t Y;
+        size_t Height;
+    };
+
+    const Image* srcImages = source.GetImages();
+    const Image* dstImages = destination.GetImages();
+    DXGI_FORMAT  format    = destination.GetMetadata().format;
+
+    std::vector<Strip> strips;
+    for ( size_t i = 0; i < source.GetImageCount(); ++i )
+    {
+        for ( size_t y = 0; y < srcImages[i].height; y += StripHeight )
+        {
+            strips.push_back( { i, y, std::min( StripHeight, srcImages[i].height - y ) } );
+        }
+    }
+
+    std::atomic<size_t> nextStrip( 0 );
+    std::atomic<HRESULT> result( S_OK );
+
+    auto compressStrips = [&]() {
+        size_t i;
+        while ( SUCCEEDED( result.load() ) && ( i = nextStrip++ ) < strips.size() )
+        {
+            const Strip& strip = strips[i];
+            const Image& src   = srcImages[strip.Image];
+            const Image& dst   = dstImages[strip.Image];
+
+            Image srcStrip      = src;
+            srcStrip.height     = strip.Height;
+            srcStrip.slicePitch = src.rowPitch * strip.Height;
+            srcStrip.pixels     = src.pixels + strip.Y * src.rowPitch;
+
+            ScratchImage compressedStrip;
+            HRESULT      hr = E_FAIL;
+            try
+            {
+                hr = Compress( srcStrip, format, compressFlags, TEX_THRESHOLD_DEFAULT, compressedStrip );
+            }
+            catch ( ... )
+            {}
+
+            if ( FAILED( hr ) )
+            {
+                result = hr;
+                break;
+            }
+
+            // The strip has the same width as the destination, so its rows of blocks have the same pitch.
+            std::memcpy( dst.pixels + ( strip.Y / 4 ) * dst.rowPitch, compressedStrip.GetPixels(),
+                         compressedStrip.GetPixelsSize() );
+        }
+    };
+
+    numThreads = static_cast<uint32_t>( std::min<size_t>( numThreads, strips.size() ) );
+
+    // The calling thread compresses strips too.
+    std::vector<std::thread> threads;
+    for ( uint32_t i = 1; i < numThreads; ++i )
+    {
+        threads.emplace_back( compressStrips );
+    }
+    compressStrips();
+
+    for ( auto& thread: threads )
+    {
+        thread.join();
+    }
+
+    return result;
+}
+
+TextureCooker::TextureCooker( const std::wstring& cacheDirectory, const TextureCookSettings& settings )
+: m_CacheDirectory( cacheDirectory )
+, m_Settings( settings )
+{
+    if ( m_Settings.NumThreads == 0 )
+    {
+        m_Settings.NumThreads = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+
+    fs::create_directories( m_CacheDirectory );
+}
+
+DXGI_FORMAT TextureCooker::GetCookedFormat( TextureUsage usage, bool hasAlpha, bool isGrayscale ) const
+{
+    switch ( usage )
+    {
+    case TextureUsage::Albedo:
+        if ( m_Settings.FastCompression )
+        {
+            return hasAlpha ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM_SRGB;
+        }
+        return DXGI_FORMAT_BC7_UNORM_SRGB;
+    case TextureUsage::Normal:
+        return DXGI_FORMAT_BC5_UNORM;
+    case TextureUsage::Mask:
+        return DXGI_FORMAT_BC4_UNORM;
+    case TextureUsage::HDR:
+        return DXGI_FORMAT_BC6H_UF16;
+    case TextureUsage::Bump:
+        return isGrayscale ? DXGI_FORMAT_BC4_UNORM : DXGI_FORMAT_BC5_UNORM;
+    default:
+        throw std::exception( "Invalid texture usage." );
+    }
+}
+
+// Replace an image that only has the first mip with an image with a full mip chain.
+static void GenerateMips( ScratchImage& image, TexMetadata& metadata, DXGI_FORMAT format,
+                          const MipGenerator& mipGenerator )
+{
+    TexMetadata mipMetadata = metadata;
+    mipMetadata.mipLevels =
+        MipGenerator::GetNumMips( static_cast<uint32_t>( metadata.width ), static_cast<uint32_t>( metadata.height ) );
+
+    ScratchImage mipChain;
+    ThrowIfFailed( mipChain.Initialize( mipMetadata ) );
+
+    std::vector<MipGenerator::Subresource> subresources;
+    for ( size_t item = 0; item < mipMetadata.arraySize; ++item )
+    {
+        const Image* srcImage = image.GetImage( 0, item, 0 );
+        const Image* dstImage = mipChain.GetImage( 0, item, 0 );
+        for ( size_t y = 0; y < srcImage->height; ++y )
+        {
+            std::memcpy( dstImage->pixels + y * dstImage->rowPitch, srcImage->pixels + y * srcImage->rowPitch,
+                         std::min( srcImage->rowPitch, dstImage->rowPitch ) );
+        }
+
+        for ( size_t mip = 0; mip < mipMetadata.mipLevels; ++mip )
+        {
+            const Image* mipImage = mipChain.GetImage( mip, item, 0 );
+            subresources.push_back( { mipImage->pixels, mipImage->rowPitch, static_cast<uint32_t>( mipImage->width ),
+                                      static_cast<uint32_t>( mipImage->height ) } );
+        }
+    }
+
+    mipGenerator.Generate( format, subresources.data(), static_cast<uint32_t>( mipMetadata.mipLevels ),
+                           static_cast<uint32_t>( mipMetadata.arraySize ) );
+
+    image    = std::move( mipChain );
+    metadata = mipMetadata;
+}
+
+std::wstring TextureCooker::Cook( const std::wstring& fileName, TextureUsage usage )
+{
+    auto startTime = Clock::now();
+
+    fs::path filePath( fileName );
+    if ( !fs::exists( filePath ) )
+    {
+        throw std::exception( "File not found." );
+    }
+
+    auto fileData = ReadFileData( filePath );
+
+    // Textures that are already block compressed are not compressed again.
+    if ( filePath.extension() == ".dds" )
+    {
+        TexMetadata metadata;
+        ThrowIfFailed( GetMetadataFromDDSMemory( fileData.data(), fileData.size(), DDS_FLAGS_NONE, metadata ) );
+        if ( IsCompressed( metadata.format ) )
+        {
+            std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+            ++m_Statistics.NumPassThrough;
+            return fileName;
+        }
+    }
+
+    Hash64 hash;
+    hash.Add( fileData.data(), fileData.size() );
+    hash.Add( CookerVersion );
+    hash.Add( usage );
+    hash.Add( m_Settings.FastCompression );
+    hash.Add( m_Settings.Filter );
+
+    wchar_t hashString[17];
+    swprintf_s( hashString, L"%016llx", static_cast<unsigned long long>( hash.Get() ) );
+
+    fs::path cookedPath = fs::path( m_CacheDirectory ) / ( filePath.stem().wstring() + L"-" + hashString + L".dds" );
+    if ( fs::exists( cookedPath ) )
+    {
+        std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+        ++m_Statistics.NumCacheHits;
+        return cookedPath.wstring();
+    }
+
+    TexMetadata  metadata;
+    ScratchImage image;
+    LoadImageFromMemory( filePath, fileData, metadata, image );
+    fileData = std::vector<uint8_t>();
+
+    if ( metadata.dimension != TEX_DIMENSION_TEXTURE2D )
+    {
+        throw std::exception( "Only 2D textures can be cooked." );
+    }
+
+    // Albedo textures are filtered and compressed in linear space.
+    bool  isSRGB      = usage == TextureUsage::Albedo;
+    DWORD filterFlags = TEX_FILTER_DEFAULT | ( isSRGB ? TEX_FILTER_SRGB : 0 );
+    // Bump maps with fewer than 24 bits per pixel are assumed to be height maps (see Scene::ImportMaterial).
+    bool isGrayscale = DirectX::BitsPerPixel( metadata.format ) < 24;
+    bool hasAlpha    = HasAlpha( metadata.format ) && !image.IsAlphaAllOpaque();
+
+    auto mipStartTime = Clock::now();
+
+    // The size of the first mip of a block compressed texture must be a multiple of the block size.
+    size_t width  = Math::AlignUp( metadata.width, 4 );
+    size_t height = Math::AlignUp( metadata.height, 4 );
+    if ( width != metadata.width || height != metadata.height )
+    {
+        ScratchImage resizedImage;
+        ThrowIfFailed(
+            Resize( image.GetImages(), image.GetImageCount(), metadata, width, height, filterFlags, resizedImage ) );
+        image    = std::move( resizedImage );
+        metadata = image.GetMetadata();
+    }
+
+    if ( metadata.mipLevels == 1 && ( metadata.width > 1 || metadata.height > 1 ) )
+    {
+        // The MipGenerator filters sRGB formats in linear space.
+        DXGI_FORMAT mipFormat = isSRGB ? MakeSRGB( metadata.format ) : metadata.format;
+        if ( MipGenerator::IsFormatSupported( mipFormat ) )
+        {
+            MipGenerationSettings mipSettings;
+            mipSettings.Filter     = m_Settings.Filter;
+            mipSettings.NumThreads = m_Settings.NumThreads;
+
+            GenerateMips( image, metadata, mipFormat, MipGenerator( mipSettings ) );
+        }
+        else
+        {
+            ScratchImage mipChain;
+            ThrowIfFailed(
+                GenerateMipMaps( image.GetImages(), image.GetImageCount(), metadata, filterFlags, 0, mipChain ) );
+            image    = std::move( mipChain );
+            metadata = image.GetMetadata();
+        }
+    }
+
+    double mipTime = ElapsedMilliseconds( mipStartTime );
+
+    TexMetadata cookedMetadata = metadata;
+    cookedMetadata.format      = GetCookedFormat( usage, hasAlpha, isGrayscale );
+
+    ScratchImage cookedImage;
+    ThrowIfFailed( cookedImage.Initialize( cookedMetadata ) );
+
+    DWORD compressFlags = isSRGB ? TEX_COMPRESS_SRGB : TEX_COMPRESS_DEFAULT;
+
+    auto compressStartTime = Clock::now();
+    ThrowIfFailed( CompressParallel( image, cookedImage, compressFlags, m_Settings.NumThreads ) );
+    double compressTime = ElapsedMilliseconds( compressStartTime );
+
+    // Write to a temporary file first so that other threads (or an interrupted
+    // cook) never see an incomplete file.
+    fs::path tempPath( cookedPath );
+    tempPath += L"." + std::to_wstring( std::hash<std::thread::id>()( std::this_thread::get_id() ) ) + L".tmp";
+
+    ThrowIfFailed( SaveToDDSFile( cookedImage.GetImages(), cookedImage.GetImageCount(), cookedImage.GetMetadata(),
+                                  DDS_FLAGS_NONE, tempPath.c_str() ) );
+
+    std::error_code error;
+    fs::rename( tempPath, cookedPath, error );
+    if ( error )
+    {
+        // Another thread cooked the same texture.
+        fs::remove( tempPath, error );
+        if ( !fs::exists( cookedPath ) )
+        {
+            throw std::exception( "Failed to write cooked texture." );
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+        ++m_Statistics.NumTexturesCooked;
+        m_Statistics.NumSourceBytes += image.GetPixelsSize();
+        m_Statistics.NumCookedBytes += cookedImage.GetPixelsSize();
+        m_Statistics.CookTime += ElapsedMilliseconds( startTime );
+        m_Statistics.MipTime += mipTime;
+        m_Statistics.CompressTime += compressTime;
+    }
+
+    return cookedPath.wstring();
+}
+
+TextureCooker::Statistics TextureCooker::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+    return m_Statistics;
+}
+
+void TextureCooker::ResetStatistics()
+{
+    std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+    m_Statistics = Statistics();
+}
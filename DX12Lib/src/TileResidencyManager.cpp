@@ -0,0 +1,361 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/TileResidencyManager.h>
+
+#include <unordered_set>
+
+using namespace dx12lib;
+
+TileResidencyManager::TileResidencyManager( uint32_t numPhysicalTiles, uint32_t maxTilesPerUpdate,
+                                            uint32_t evictionDelay )
+: m_NumPhysicalTiles( numPhysicalTiles )
+, m_MaxTilesPerUpdate( maxTilesPerUpdate )
+, m_EvictionDelay( evictionDelay )
+{
+    // Hand out the lowest tile indices first.
+    m_FreeTiles.reserve( m_NumPhysicalTiles );
+    for ( uint32_t i = m_NumPhysicalTiles; i-- > 0; )
+    {
+        m_FreeTiles.push_back( i );
+    }
+
+    m_Statistics.NumPhysicalTiles = m_NumPhysicalTiles;
+}
+
+uint32_t TileResidencyManager::RegisterTexture( const std::vector<MipTiling>& mipTiling )
+{
+    assert( !mipTiling.empty() && mipTiling.size() < 0xff );
+
+    uint32_t textureId = static_cast<uint32_t>( m_Textures.size() );
+    m_Textures.emplace_back();
+
+    auto& texture        = m_Textures[textureId];
+    texture.Mips         = mipTiling;
+    texture.IsRegistered = true;
+    texture.IsDirty      = false;
+    texture.ResidencyMap.assign( static_cast<size_t>( mipTiling[0].WidthInTiles ) * mipTiling[0].HeightInTiles,
+                                 static_cast<uint8_t>( mipTiling.size() ) );
+
+    return textureId;
+}
+
+void TileResidencyManager::UnregisterTexture( uint32_t textureId, uint64_t frameIndex )
+{
+    assert( textureId < m_Textures.size() && m_Textures[textureId].IsRegistered );
+
+    for ( auto iter = m_LRU.begin(); iter != m_LRU.end(); )
+    {
+        uint64_t key = *iter++;
+        if ( TileCoord::Unpack( key ).TextureId == textureId )
+        {
+            EvictTile( key, frameIndex );
+        }
+    }
+
+    auto& texture        = m_Textures[textureId];
+    texture.IsRegistered = false;
+    texture.IsDirty      = false;
+    texture.Mips.clear();
+    texture.ResidencyMap.clear();
+
+    m_DirtyTextures.erase( std::remove( m_DirtyTextures.begin(), m_DirtyTextures.end(), textureId ),
+                           m_DirtyTextures.end() );
+}
+
+std::vector<uint32_t> TileResidencyManager::ReservePhysicalTiles( uint32_t numTiles )
+{
+    if ( numTiles > m_FreeTiles.size() )
+    {
+        throw std::bad_alloc();
+    }
+
+    std::vector<uint32_t> tiles( numTiles );
+    for ( auto& tile: tiles )
+    {
+        tile = m_FreeTiles.back();
+        m_FreeTiles.pop_back();
+    }
+
+    m_Statistics.NumReservedTiles += numTiles;
+
+    return tiles;
+}
+
+void TileResidencyManager::ReleasePhysicalTiles( const std::vector<uint32_t>& physicalTiles, uint64_t frameIndex )
+{
+    for ( uint32_t physicalTile: physicalTiles )
+    {
+        m_PendingFreeTiles.push_back( { { {}, physicalTile }, frameIndex, true } );
+    }
+
+    m_Statistics.NumReservedTiles -= static_cast<uint32_t>( physicalTiles.size() );
+}
+
+void TileResidencyManager::RequestTile( const TileCoord& tile )
+{
+    m_Requests.push_back( tile.Pack() );
+}
+
+void TileResidencyManager::RequestTiles( const uint64_t* packedTiles, size_t numTiles )
+{
+    m_Requests.insert( m_Requests.end(), packedTiles, packedTiles + numTiles );
+}
+
+TileResidencyManager::ResidencyUpdate TileResidencyManager::ProcessRequests( uint64_t frameIndex )
+{
+    ResidencyUpdate update;
+
+    // Reclaim the physical tiles that were evicted long enough ago.
+    while ( !m_PendingFreeTiles.empty() && m_PendingFreeTiles.front().EvictedFrame + m_EvictionDelay <= frameIndex )
+    {
+        const auto& pendingFreeTile = m_PendingFreeTiles.front();
+
+        m_FreeTiles.push_back( pendingFreeTile.Mapping.PhysicalTile );
+
+        // If the tile was requested again in the meantime, it is already mapped to another physical tile.
+        if ( !pendingFreeTile.IsReserved && !IsResident( pendingFreeTile.Mapping.Tile ) )
+        {
+            update.UnmappedTiles.push_back( pendingFreeTile.Mapping );
+        }
+
+        m_PendingFreeTiles.pop_front();
+    }
+
+    // Add the less detailed mips of each request and remove duplicates.
+    std::vector<uint64_t>        requests;
+    std::unordered_set<uint64_t> uniqueRequests;
+    for ( uint64_t key: m_Requests )
+    {
+        TileCoord tile = TileCoord::Unpack( key );
+        if ( !IsValidTile( tile ) )
+            continue;
+
+        uint32_t numMips = static_cast<uint32_t>( m_Textures[tile.TextureId].Mips.size() );
+        while ( true )
+        {
+            // If the tile was already requested, so were its parents.
+            if ( !uniqueRequests.insert( tile.Pack() ).second )
+                break;
+
+            requests.push_back( tile.Pack() );
+
+            if ( tile.MipLevel + 1 >= numMips )
+                break;
+
+            tile = GetParentTile( tile );
+        }
+    }
+    m_Requests.clear();
+
+    m_Statistics.NumRequests += requests.size();
+
+    std::vector<uint64_t> misses;
+    for ( uint64_t key: requests )
+    {
+        auto iter = m_ResidentTiles.find( key );
+        if ( iter != m_ResidentTiles.end() )
+        {
+            // Move the tile to the front of the LRU list.
+            auto& residentTile         = iter->second;
+            residentTile.LastUsedFrame = frameIndex;
+            m_LRU.splice( m_LRU.begin(), m_LRU, residentTile.LRUIterator );
+
+            ++m_Statistics.NumHits;
+        }
+        else
+        {
+            misses.push_back( key );
+
+            ++m_Statistics.NumMisses;
+        }
+    }
+
+    // Map the least detailed mips first so that something can be displayed as soon as possible.
+    std::stable_sort( misses.begin(), misses.end(), []( uint64_t a, uint64_t b ) {
+        return TileCoord::Unpack( a ).MipLevel > TileCoord::Unpack( b ).MipLevel;
+    } );
+
+    for ( size_t i = 0; i < misses.size(); ++i )
+    {
+        if ( update.MappedTiles.size() >= m_MaxTilesPerUpdate )
+        {
+            m_Statistics.NumDeferred += misses.size() - i;
+            break;
+        }
+
+        if ( m_FreeTiles.empty() )
+        {
+            // Evicted tiles only become available after the eviction delay so
+            // the remaining misses are deferred to a later frame. Evict enough
+            // tiles to make room for them (taking the tiles that are already
+            // waiting to be reclaimed into account).
+            size_t numDeferred = misses.size() - i;
+            size_t numPending  = m_PendingFreeTiles.size();
+            for ( size_t j = numPending; j < numDeferred; ++j )
+            {
+                if ( !EvictLeastRecentlyUsed( frameIndex ) )
+                    break;
+            }
+
+            m_Statistics.NumDeferred += numDeferred;
+            break;
+        }
+
+        uint64_t key  = misses[i];
+        uint32_t tile = m_FreeTiles.back();
+        m_FreeTiles.pop_back();
+
+        m_LRU.push_front( key );
+        m_ResidentTiles[key] = { tile, frameIndex, m_LRU.begin() };
+
+        TileCoord tileCoord = TileCoord::Unpack( key );
+        update.MappedTiles.push_back( { tileCoord, tile } );
+        MarkDirty( tileCoord.TextureId );
+
+        ++m_Statistics.NumMapped;
+    }
+
+    for ( uint32_t textureId: m_DirtyTextures )
+    {
+        UpdateResidencyMap( textureId );
+    }
+    update.DirtyTextures = std::move( m_DirtyTextures );
+    m_DirtyTextures.clear();
+
+    return update;
+}
+
+bool TileResidencyManager::IsResident( const TileCoord& tile ) const
+{
+    return m_ResidentTiles.find( tile.Pack() ) != m_ResidentTiles.end();
+}
+
+const std::vector<uint8_t>& TileResidencyManager::GetResidencyMap( uint32_t textureId ) const
+{
+    assert( textureId < m_Textures.size() );
+    return m_Textures[textureId].ResidencyMap;
+}
+
+const std::vector<TileResidencyManager::MipTiling>& TileResidencyManager::GetMipTiling( uint32_t textureId ) const
+{
+    assert( textureId < m_Textures.size() );
+    return m_Textures[textureId].Mips;
+}
+
+TileResidencyManager::Statistics TileResidencyManager::GetStatistics() const
+{
+    Statistics statistics       = m_Statistics;
+    statistics.NumResidentTiles = static_cast<uint32_t>( m_ResidentTiles.size() );
+
+    return statistics;
+}
+
+void TileResidencyManager::ResetStatistics()
+{
+    uint32_t numReservedTiles = m_Statistics.NumReservedTiles;
+
+    m_Statistics                  = Statistics();
+    m_Statistics.NumPhysicalTiles = m_NumPhysicalTiles;
+    m_Statistics.NumReservedTiles = numReservedTiles;
+}
+
+TileCoord TileResidencyManager::GetParentTile( const TileCoord& tile ) const
+{
+    const auto& parentTiling = m_Textures[tile.TextureId].Mips[tile.MipLevel + 1];
+
+    // The tile shape is the same for every standard mip so a tile covers twice
+    // the area of the previous mip.
+    TileCoord parent;
+    parent.TextureId = tile.TextureId;
+    parent.MipLevel  = tile.MipLevel + 1;
+    parent.X         = std::min( tile.X / 2, parentTiling.WidthInTiles - 1 );
+    parent.Y         = std::min( tile.Y / 2, parentTiling.HeightInTiles - 1 );
+
+    return parent;
+}
+
+bool TileResidencyManager::IsValidTile( const TileCoord& tile ) const
+{
+    if ( tile.TextureId >= m_Textures.size() || !m_Textures[tile.TextureId].IsRegistered )
+        return false;
+
+    const auto& mipTiling = m_Textures[tile.TextureId].Mips;
+    if ( tile.MipLevel >= mipTiling.size() )
+        return false;
+
+    return tile.X < mipTiling[tile.MipLevel].WidthInTiles && tile.Y < mipTiling[tile.MipLevel].HeightInTiles;
+}
+
+bool TileResidencyManager::EvictLeastRecentlyUsed( uint64_t frameIndex )
+{
+    if ( m_LRU.empty() )
+        return false;
+
+    uint64_t key = m_LRU.back();
+
+    // Never evict tiles that are used in the current frame.
+    if ( m_ResidentTiles[key].LastUsedFrame >= frameIndex )
+        return false;
+
+    EvictTile( key, frameIndex );
+
+    return true;
+}
+
+void TileResidencyManager::EvictTile( uint64_t key, uint64_t frameIndex )
+{
+    auto iter = m_ResidentTiles.find( key );
+    assert( iter != m_ResidentTiles.end() );
+
+    TileCoord tile = TileCoord::Unpack( key );
+
+    m_PendingFreeTiles.push_back( { { tile, iter->second.PhysicalTile }, frameIndex, false } );
+    m_LRU.erase( iter->second.LRUIterator );
+    m_ResidentTiles.erase( iter );
+
+    MarkDirty( tile.TextureId );
+
+    ++m_Statistics.NumEvicted;
+}
+
+void TileResidencyManager::MarkDirty( uint32_t textureId )
+{
+    auto& texture = m_Textures[textureId];
+    if ( !texture.IsDirty )
+    {
+        texture.IsDirty = true;
+        m_DirtyTextures.push_back( textureId );
+    }
+}
+
+void TileResidencyManager::UpdateResidencyMap( uint32_t textureId )
+{
+    auto&    texture = m_Textures[textureId];
+    uint32_t numMips = static_cast<uint32_t>( texture.Mips.size() );
+    uint32_t width   = texture.Mips[0].WidthInTiles;
+    uint32_t height  = texture.Mips[0].HeightInTiles;
+
+    for ( uint32_t y = 0; y < height; ++y )
+    {
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            // A mip is only usable if all of the less detailed mips are resident too.
+            uint8_t residentMip = static_cast<uint8_t>( numMips );
+            for ( uint32_t mip = numMips; mip-- > 0; )
+            {
+                const auto& mipTiling = texture.Mips[mip];
+
+                TileCoord tile = { textureId, mip, std::min( x >> mip, mipTiling.WidthInTiles - 1 ),
+                                   std::min( y >> mip, mipTiling.HeightInTiles - 1 ) };
+                if ( !IsResident( tile ) )
+                    break;
+
+                residentMip = static_cast<uint8_t>( mip );
+            }
+
+            texture.ResidencyMap[static_cast<size_t>( y ) * width + x] = residentMip;
+        }
+    }
+
+    texture.IsDirty = false;
+}
@@ -0,0 +1,1223 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/TiledImage.h>
+
+#include <dx12lib/Defines.h>
+
+#include <DirectXPackedVector.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <zlib.h>
+
+using namespace dx12lib;
+using namespace DirectX::PackedVector;
+
+static const uint32_t EXRMagic         = 20000630;
+static const uint32_t EXRVersion       = 2;
+static const uint32_t EXRTiledFlag     = 0x200;
+static const uint32_t EXRNonImageFlags = 0x800 | 0x1000;  // Deep data and multi-part files.
+
+// EXR compression methods.
+static const uint32_t EXRCompressionNone = 0;
+static const uint32_t EXRCompressionRLE  = 1;
+static const uint32_t EXRCompressionZIPS = 2;
+static const uint32_t EXRCompressionZIP  = 3;
+
+// EXR tile level modes.
+static const uint32_t EXRLevelModeOne    = 0;
+static const uint32_t EXRLevelModeMipmap = 1;
+
+// EXR pixel types.
+static const uint32_t EXRPixelTypeUInt  = 0;
+static const uint32_t EXRPixelTypeHalf  = 1;
+static const uint32_t EXRPixelTypeFloat = 2;
+
+// Compressed pyramids favor build speed over size.
+static const int PyramidZipLevel = Z_BEST_SPEED;
+
+template<typename T>
+static T ReadValue( const uint8_t* data )
+{
+    T value;
+    std::memcpy( &value, data, sizeof( T ) );
+    return value;
+}
+
+template<typename T>
+static void WriteValue( std::vector<uint8_t>& data, T value )
+{
+    auto offset = data.size();
+    data.resize( offset + sizeof( T ) );
+    std::memcpy( data.data() + offset, &value, sizeof( T ) );
+}
+
+static void WriteString( std::vector<uint8_t>& data, const char* str )
+{
+    data.insert( data.end(), str, str + std::strlen( str ) + 1 );
+}
+
+static void WriteAttribute( std::vector<uint8_t>& data, const char* name, const char* type,
+                            const std::vector<uint8_t>& value )
+{
+    WriteString( data, name );
+    WriteString( data, type );
+    WriteValue( data, static_cast<int32_t>( value.size() ) );
+    data.insert( data.end(), value.begin(), value.end() );
+}
+
+static uint32_t GetNumFullMips( uint32_t width, uint32_t height )
+{
+    uint32_t size    = std::max( width, height );
+    uint32_t numMips = 1;
+    while ( size > 1 )
+    {
+        size >>= 1;
+        ++numMips;
+    }
+
+    return numMips;
+}
+
+static uint32_t GetLevelSize( uint32_t size, uint32_t level, bool roundUp )
+{
+    uint64_t roundingOffset = roundUp ? ( 1ull << level ) - 1 : 0;
+    uint32_t levelSize      = static_cast<uint32_t>( ( size + roundingOffset ) >> level );
+    return std::max( levelSize, 1u );
+}
+
+// The EXR predictor: the bytes are split into two halves (even and odd bytes)
+// and then delta encoded.
+static void ApplyPredictor( const uint8_t* src, uint8_t* dst, size_t numBytes )
+{
+    const uint8_t* srcEnd = src + numBytes;
+    uint8_t*       t1     = dst;
+    uint8_t*       t2     = dst + ( numBytes + 1 ) / 2;
+    while ( src < srcEnd )
+    {
+        *t1++ = *src++;
+        if ( src < srcEnd )
+        {
+            *t2++ = *src++;
+        }
+    }
+
+    uint8_t prev = dst[0];
+    for ( size_t i = 1; i < numBytes; ++i )
+    {
+        uint8_t d = static_cast<uint8_t>( dst[i] - prev + 128 );
+        prev      = dst[i];
+        dst[i]    = d;
+    }
+}
+
+// Undo the predictor. The deltas are decoded in place in src.
+static void RemovePredictor( uint8_t* src, uint8_t* dst, size_t numBytes )
+{
+    for ( size_t i = 1; i < numBytes; ++i )
+    {
+        src[i] = static_cast<uint8_t>( src[i - 1] + src[i] - 128 );
+    }
+
+    const uint8_t* t1     = src;
+    const uint8_t* t2     = src + ( numBytes + 1 ) / 2;
+    uint8_t*       dstEnd = dst + numBytes;
+    while ( dst < dstEnd )
+    {
+        *dst++ = *t1++;
+        if ( dst < dstEnd )
+        {
+            *dst++ = *t2++;
+        }
+    }
+}
+
+// Decode EXR run-length encoded data. Returns false if the data is corrupt.
+static bool DecodeRLE( const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize )
+{
+    const uint8_t* srcEnd = src + srcSize;
+    uint8_t*       dstEnd = dst + dstSize;
+    while ( src < srcEnd )
+    {
+        int count = static_cast<int8_t>( *src++ );
+        if ( count < 0 )
+        {
+            count = -count;
+            if ( srcEnd - src < count || dstEnd - dst < count )
+                return false;
+
+            std::memcpy( dst, src, count );
+            src += count;
+            dst += count;
+        }
+        else
+        {
+            if ( src == srcEnd || dstEnd - dst < count + 1 )
+                return false;
+
+            std::memset( dst, *src++, count + 1 );
+            dst += count + 1;
+        }
+    }
+
+    return dst == dstEnd;
+}
+
+/**
+ * Provides the rows of a source image (from top to bottom) as RGBA floats.
+ */
+class RowSource
+{
+public:
+    virtual ~RowSource() = default;
+
+    virtual void ReadRow( float* rgba ) = 0;
+
+    uint32_t Width    = 0;
+    uint32_t Height   = 0;
+    bool     HasAlpha = false;
+};
+
+/**
+ * Decodes a Radiance (RGBE) .hdr file one scanline at a time.
+ */
+class HDRRowSource : public RowSource
+{
+public:
+    explicit HDRRowSource( const std::wstring& fileName )
+    : m_File( fs::path( fileName ), std::ios::binary )
+    , m_Buffer( _1MB )
+    , m_BufferPos( 0 )
+    , m_BufferSize( 0 )
+    {
+        if ( !m_File.is_open() )
+        {
+            throw std::exception( "Failed to open HDR file." );
+        }
+
+        std::string line = ReadLine();
+        if ( line.compare( 0, 2, "#?" ) != 0 )
+        {
+            throw std::exception( "Invalid HDR file." );
+        }
+
+        // The header ends with an empty line.
+        while ( !( line = ReadLine() ).empty() )
+        {
+            if ( line.compare( 0, 7, "FORMAT=" ) == 0 && line != "FORMAT=32-bit_rle_rgbe" )
+            {
+                throw std::exception( "Only RGBE HDR files are supported." );
+            }
+        }
+
+        // Only the standard orientation (rows from top to bottom) can be streamed.
+        char     y[3] = {}, x[3] = {};
+        uint32_t height = 0, width = 0;
+        line            = ReadLine();
+        if ( std::sscanf( line.c_str(), "%2s %u %2s %u", y, &height, x, &width ) != 4 || std::strcmp( y, "-Y" ) != 0 ||
+             std::strcmp( x, "+X" ) != 0 )
+        {
+            throw std::exception( "Unsupported HDR image orientation." );
+        }
+        if ( width == 0 || height == 0 )
+        {
+            throw std::exception( "Invalid HDR image size." );
+        }
+
+        Width  = width;
+        Height = height;
+        m_Scanline.resize( static_cast<size_t>( width ) * 4 );
+    }
+
+    void ReadRow( float* rgba ) override
+    {
+        ReadScanline();
+
+        for ( uint32_t x = 0; x < Width; ++x )
+        {
+            const uint8_t* rgbe = &m_Scanline[x * 4];
+            float          f    = rgbe[3] ? std::ldexp( 1.0f, rgbe[3] - ( 128 + 8 ) ) : 0.0f;
+
+            rgba[x * 4 + 0] = rgbe[0] * f;
+            rgba[x * 4 + 1] = rgbe[1] * f;
+            rgba[x * 4 + 2] = rgbe[2] * f;
+            rgba[x * 4 + 3] = 1.0f;
+        }
+    }
+
+private:
+    uint8_t ReadByte()
+    {
+        if ( m_BufferPos == m_BufferSize )
+        {
+            m_File.read( reinterpret_cast<char*>( m_Buffer.data() ), m_Buffer.size() );
+            m_BufferSize = static_cast<size_t>( m_File.gcount() );
+            m_BufferPos  = 0;
+            if ( m_BufferSize == 0 )
+            {
+                throw std::exception( "Unexpected end of HDR file." );
+            }
+        }
+
+        return m_Buffer[m_BufferPos++];
+    }
+
+    std::string ReadLine()
+    {
+        std::string line;
+        for ( char c = ReadByte(); c != '\n'; c = ReadByte() )
+        {
+            if ( line.size() > 1024 )
+            {
+                throw std::exception( "Invalid HDR file." );
+            }
+            line.push_back( c );
+        }
+
+        return line;
+    }
+
+    void ReadScanline()
+    {
+        uint8_t* scanline = m_Scanline.data();
+
+        uint8_t rgbe[4];
+        for ( auto& c: rgbe )
+        {
+            c = ReadByte();
+        }
+
+        // New run-length encoding: each component is encoded separately.
+        if ( Width >= 8 && Width < 0x8000 && rgbe[0] == 2 && rgbe[1] == 2 && ( rgbe[2] & 0x80 ) == 0 )
+        {
+            if ( ( static_cast<uint32_t>( rgbe[2] ) << 8 | rgbe[3] ) != Width )
+            {
+                throw std::exception( "Invalid HDR scanline." );
+            }
+
+            for ( uint32_t c = 0; c < 4; ++c )
+            {
+                for ( uint32_t x = 0; x < Width; )
+                {
+                    uint32_t count = ReadByte();
+                    if ( count > 128 )
+                    {
+                        count -= 128;
+                        if ( count > Width - x )
+                        {
+                            throw std::exception( "Invalid HDR scanline." );
+                        }
+
+                        uint8_t value = ReadByte();
+                        for ( ; count > 0; --count, ++x )
+                        {
+                            scanline[x * 4 + c] = value;
+                        }
+                    }
+                    else
+                    {
+                        if ( count == 0 || count > Width - x )
+                        {
+                            throw std::exception( "Invalid HDR scanline." );
+                        }
+
+                        for ( ; count > 0; --count, ++x )
+                        {
+                            scanline[x * 4 + c] = ReadByte();
+                        }
+                    }
+                }
+            }
+            return;
+        }
+
+        // Flat pixels, possibly with old run-length encoding (a pixel of (1, 1, 1, n) repeats the previous pixel).
+        uint32_t shift = 0;
+        for ( uint32_t x = 0; x < Width; )
+        {
+            if ( x > 0 || shift > 0 )
+            {
+                for ( auto& c: rgbe )
+                {
+                    c = ReadByte();
+                }
+            }
+
+            if ( rgbe[0] == 1 && rgbe[1] == 1 && rgbe[2] == 1 )
+            {
+                if ( x == 0 || shift > 24 )
+                {
+                    throw std::exception( "Invalid HDR scanline." );
+                }
+
+                uint32_t count = static_cast<uint32_t>( rgbe[3] ) << shift;
+                if ( count > Width - x )
+                {
+                    throw std::exception( "Invalid HDR scanline." );
+                }
+
+                for ( ; count > 0; --count, ++x )
+                {
+                    std::memcpy( &scanline[x * 4], &scanline[( x - 1 ) * 4], 4 );
+                }
+                shift += 8;
+            }
+            else
+            {
+                std::memcpy( &scanline[x * 4], rgbe, 4 );
+                ++x;
+                shift = 0;
+            }
+        }
+    }
+
+    std::ifstream        m_File;
+    std::vector<uint8_t> m_Buffer;
+    size_t               m_BufferPos;
+    size_t               m_BufferSize;
+    std::vector<uint8_t> m_Scanline;
+};
+
+/**
+ * Reads the first level of an EXR file one band of chunks at a time.
+ */
+class EXRRowSource : public RowSource
+{
+public:
+    explicit EXRRowSource( const std::wstring& fileName )
+    : m_Image( fileName )
+    , m_BandY( 0 )
+    , m_BandRows( 0 )
+    , m_Row( 0 )
+    {
+        Width    = m_Image.GetWidth();
+        Height   = m_Image.GetHeight();
+        HasAlpha = m_Image.HasAlpha();
+
+        m_Band.resize( static_cast<size_t>( Width ) * m_Image.GetTileHeight() * m_Image.GetTexelSize() );
+    }
+
+    void ReadRow( float* rgba ) override
+    {
+        if ( m_Row == m_BandY + m_BandRows )
+        {
+            m_BandY    = m_Row;
+            m_BandRows = std::min( m_Image.GetTileHeight(), Height - m_Row );
+            m_Image.ReadRegion( 0, 0, m_BandY, Width, m_BandRows, m_Band.data(), Width * m_Image.GetTexelSize() );
+        }
+
+        const uint8_t* src = m_Band.data() + static_cast<size_t>( m_Row - m_BandY ) * Width * m_Image.GetTexelSize();
+        if ( m_Image.GetFormat() == DXGI_FORMAT_R16G16B16A16_FLOAT )
+        {
+            XMConvertHalfToFloatStream( rgba, sizeof( float ), reinterpret_cast<const HALF*>( src ), sizeof( HALF ),
+                                        static_cast<size_t>( Width ) * 4 );
+        }
+        else
+        {
+            std::memcpy( rgba, src, static_cast<size_t>( Width ) * 4 * sizeof( float ) );
+        }
+        ++m_Row;
+    }
+
+private:
+    TiledImage           m_Image;
+    std::vector<uint8_t> m_Band;
+    uint32_t             m_BandY;
+    uint32_t             m_BandRows;
+    uint32_t             m_Row;
+};
+
+/**
+ * Writes a tiled, mip-mapped EXR file from the rows of the first level.
+ * Each level keeps one band of rows (one tile high) which is compressed and
+ * written as soon as it is complete, and every pair of rows is box filtered
+ * into a row of the next level.
+ */
+class PyramidWriter
+{
+public:
+    PyramidWriter( const std::wstring& fileName, uint32_t width, uint32_t height, uint32_t tileSize, bool hasAlpha,
+                   bool compress )
+    : m_File( fs::path( fileName ), std::ios::binary | std::ios::trunc )
+    , m_TileSize( tileSize )
+    , m_Compress( compress )
+    {
+        if ( !m_File.is_open() )
+        {
+            throw std::exception( "Failed to create mip pyramid file." );
+        }
+
+        // Channels are stored in alphabetical order.
+        m_Components = hasAlpha ? std::vector<uint32_t> { 3, 2, 1, 0 } : std::vector<uint32_t> { 2, 1, 0 };
+
+        uint32_t numMips = GetNumFullMips( width, height );
+        size_t   numChunks = 0;
+        m_Levels.resize( numMips );
+        for ( uint32_t mip = 0; mip < numMips; ++mip )
+        {
+            auto& level      = m_Levels[mip];
+            level.Width      = GetLevelSize( width, mip, false );
+            level.Height     = GetLevelSize( height, mip, false );
+            level.NumTilesX  = ( level.Width + tileSize - 1 ) / tileSize;
+            level.FirstChunk = numChunks;
+            level.NumRows    = 0;
+            level.BandRows   = 0;
+            level.AccumRows  = 0;
+            level.Band.resize( static_cast<size_t>( level.Width ) * tileSize * m_Components.size() );
+
+            numChunks += static_cast<size_t>( level.NumTilesX ) * ( ( level.Height + tileSize - 1 ) / tileSize );
+        }
+        for ( uint32_t mip = 0; mip + 1 < numMips; ++mip )
+        {
+            m_Levels[mip].Accum.resize( static_cast<size_t>( m_Levels[mip + 1].Width ) * 4 );
+        }
+        m_ChunkOffsets.resize( numChunks );
+
+        // Header.
+        std::vector<uint8_t> header, value;
+        WriteValue( header, EXRMagic );
+        WriteValue( header, EXRVersion | EXRTiledFlag );
+
+        const char* channelNames[] = { "R", "G", "B", "A" };
+        for ( auto component: m_Components )
+        {
+            WriteString( value, channelNames[component] );
+            WriteValue( value, static_cast<int32_t>( EXRPixelTypeHalf ) );
+            WriteValue( value, 0u );  // pLinear and reserved.
+            WriteValue( value, 1 );   // xSampling
+            WriteValue( value, 1 );   // ySampling
+        }
+        value.push_back( 0 );
+        WriteAttribute( header, "channels", "chlist", value );
+
+        WriteAttribute( header, "compression", "compression",
+                        { static_cast<uint8_t>( compress ? EXRCompressionZIP : EXRCompressionNone ) } );
+
+        value.clear();
+        WriteValue( value, 0 );
+        WriteValue( value, 0 );
+        WriteValue( value, static_cast<int32_t>( width - 1 ) );
+        WriteValue( value, static_cast<int32_t>( height - 1 ) );
+        WriteAttribute( header, "dataWindow", "box2i", value );
+        WriteAttribute( header, "displayWindow", "box2i", value );
+
+        // Tiles are written in the order that bands are completed.
+        WriteAttribute( header, "lineOrder", "lineOrder", { 2 } );
+
+        value.clear();
+        WriteValue( value, 1.0f );
+        WriteAttribute( header, "pixelAspectRatio", "float", value );
+        WriteAttribute( header, "screenWindowWidth", "float", value );
+
+        value.clear();
+        WriteValue( value, 0.0f );
+        WriteValue( value, 0.0f );
+        WriteAttribute( header, "screenWindowCenter", "v2f", value );
+
+        value.clear();
+        WriteValue( value, tileSize );
+        WriteValue( value, tileSize );
+        value.push_back( static_cast<uint8_t>( EXRLevelModeMipmap ) );  // Levels are rounded down.
+        WriteAttribute( header, "tiles", "tiledesc", value );
+
+        header.push_back( 0 );
+
+        // The offset table is written when all of the tiles are written.
+        m_OffsetTablePosition = header.size();
+        header.resize( header.size() + numChunks * sizeof( uint64_t ) );
+        Write( header.data(), header.size() );
+    }
+
+    void AddRow( const float* rgba )
+    {
+        AddRow( 0, rgba );
+    }
+
+    void Finish()
+    {
+        for ( auto& level: m_Levels )
+        {
+            if ( level.NumRows != level.Height )
+            {
+                throw std::exception( "The mip pyramid is incomplete." );
+            }
+        }
+
+        m_File.seekp( m_OffsetTablePosition );
+        m_File.write( reinterpret_cast<const char*>( m_ChunkOffsets.data() ),
+                      m_ChunkOffsets.size() * sizeof( uint64_t ) );
+        m_File.close();
+
+        if ( m_File.fail() )
+        {
+            throw std::exception( "Failed to write mip pyramid file." );
+        }
+    }
+
+private:
+    struct Level
+    {
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t NumTilesX;
+        size_t   FirstChunk;
+        uint32_t NumRows;
+        // The rows of the current band, stored as half floats in the same
+        // layout as a chunk (the samples of every channel of a row are
+        // consecutive).
+        std::vector<uint16_t> Band;
+        uint32_t              BandRows;
+        // The sum of the filtered rows of the next level's current row.
+        std::vector<float> Accum;
+        uint32_t           AccumRows;
+    };
+
+    void AddRow( size_t mip, const float* rgba )
+    {
+        auto&  level       = m_Levels[mip];
+        size_t numChannels = m_Components.size();
+
+        uint16_t* bandRow = &level.Band[level.BandRows * numChannels * level.Width];
+        for ( size_t c = 0; c < numChannels; ++c )
+        {
+            XMConvertFloatToHalfStream( reinterpret_cast<HALF*>( bandRow + c * level.Width ), sizeof( HALF ),
+                                        rgba + m_Components[c], sizeof( float ) * 4, level.Width );
+        }
+
+        ++level.NumRows;
+        if ( ++level.BandRows == m_TileSize || level.NumRows == level.Height )
+        {
+            WriteBand( mip );
+        }
+
+        if ( mip + 1 == m_Levels.size() )
+            return;
+
+        // Filter the row horizontally. Odd sizes are handled by averaging the
+        // last three texels (and rows) into the last texel of the next level.
+        auto& nextLevel = m_Levels[mip + 1];
+        for ( uint32_t x = 0; x < nextLevel.Width; ++x )
+        {
+            uint32_t x0 = x * 2;
+            uint32_t x1 = x + 1 == nextLevel.Width ? level.Width : std::min( x0 + 2, level.Width );
+            float    w  = 1.0f / ( x1 - x0 );
+            for ( uint32_t c = 0; c < 4; ++c )
+            {
+                float sum = 0.0f;
+                for ( uint32_t i = x0; i < x1; ++i )
+                {
+                    sum += rgba[i * 4 + c];
+                }
+                level.Accum[x * 4 + c] += sum * w;
+            }
+        }
+        ++level.AccumRows;
+
+        bool isLastRow      = level.NumRows == level.Height;
+        bool isBeforeOddRow = ( level.Height & 1 ) && level.NumRows == level.Height - 1;
+        if ( ( level.AccumRows == 2 && !isBeforeOddRow ) || isLastRow )
+        {
+            float w = 1.0f / level.AccumRows;
+            for ( auto& a: level.Accum )
+            {
+                a *= w;
+            }
+
+            AddRow( mip + 1, level.Accum.data() );
+
+            std::fill( level.Accum.begin(), level.Accum.end(), 0.0f );
+            level.AccumRows = 0;
+        }
+    }
+
+    void WriteBand( size_t mip )
+    {
+        auto&    level       = m_Levels[mip];
+        size_t   numChannels = m_Components.size();
+        uint32_t tileY       = ( level.NumRows - 1 ) / m_TileSize;
+
+        for ( uint32_t tileX = 0; tileX < level.NumTilesX; ++tileX )
+        {
+            uint32_t x0    = tileX * m_TileSize;
+            uint32_t width = std::min( m_TileSize, level.Width - x0 );
+
+            // Gather the tile.
+            size_t rowSize  = width * sizeof( uint16_t );
+            size_t tileSize = rowSize * numChannels * level.BandRows;
+            m_TileData.resize( tileSize );
+            uint8_t* dst = m_TileData.data();
+            for ( uint32_t row = 0; row < level.BandRows; ++row )
+            {
+                for ( size_t c = 0; c < numChannels; ++c )
+                {
+                    std::memcpy( dst, &level.Band[( row * numChannels + c ) * level.Width + x0], rowSize );
+                    dst += rowSize;
+                }
+            }
+
+            // Compress the tile, tiles that don't compress are stored uncompressed.
+            const uint8_t* data     = m_TileData.data();
+            size_t         dataSize = tileSize;
+            if ( m_Compress )
+            {
+                m_PredictedData.resize( tileSize );
+                ApplyPredictor( m_TileData.data(), m_PredictedData.data(), tileSize );
+
+                uLongf compressedSize = compressBound( static_cast<uLong>( tileSize ) );
+                m_CompressedData.resize( compressedSize );
+                if ( compress2( m_CompressedData.data(), &compressedSize, m_PredictedData.data(),
+                                static_cast<uLong>( tileSize ), PyramidZipLevel ) == Z_OK &&
+                     compressedSize < tileSize )
+                {
+                    data     = m_CompressedData.data();
+                    dataSize = compressedSize;
+                }
+            }
+
+            m_ChunkOffsets[level.FirstChunk + static_cast<size_t>( tileY ) * level.NumTilesX + tileX] = m_FilePosition;
+
+            int32_t chunkHeader[] = { static_cast<int32_t>( tileX ), static_cast<int32_t>( tileY ),
+                                      static_cast<int32_t>( mip ), static_cast<int32_t>( mip ),
+                                      static_cast<int32_t>( dataSize ) };
+            Write( chunkHeader, sizeof( chunkHeader ) );
+            Write( data, dataSize );
+        }
+
+        level.BandRows = 0;
+    }
+
+    void Write( const void* data, size_t size )
+    {
+        m_File.write( static_cast<const char*>( data ), size );
+        m_FilePosition += size;
+    }
+
+    std::ofstream         m_File;
+    uint64_t              m_FilePosition = 0;
+    uint64_t              m_OffsetTablePosition = 0;
+    uint32_t              m_TileSize;
+    bool                  m_Compress;
+    std::vector<uint32_t> m_Components;
+    std::vector<Level>    m_Levels;
+    std::vector<uint64_t> m_ChunkOffsets;
+
+    std::vector<uint8_t> m_TileData;
+    std::vector<uint8_t> m_PredictedData;
+    std::vector<uint8_t> m_CompressedData;
+};
+
+std::unique_ptr<TiledImage> TiledImage::Open( const std::wstring& fileName )
+{
+    fs::path filePath( fileName );
+    if ( !fs::exists( filePath ) )
+    {
+        throw std::exception( "File not found." );
+    }
+
+    if ( filePath.extension() == ".exr" )
+    {
+        auto image = std::make_unique<TiledImage>( fileName );
+        if ( image->IsTiled() && image->HasFullMipChain() )
+        {
+            return image;
+        }
+    }
+
+    // Build the pyramid to a temporary file first so that a failed (or
+    // interrupted) build never leaves an incomplete pyramid behind.
+    fs::path pyramidPath( GetPyramidFileName( fileName ) );
+    if ( !fs::exists( pyramidPath ) || fs::last_write_time( pyramidPath ) < fs::last_write_time( filePath ) )
+    {
+        fs::path tempPath( pyramidPath );
+        tempPath += ".tmp";
+
+        BuildPyramid( fileName, tempPath.wstring() );
+        fs::rename( tempPath, pyramidPath );
+    }
+
+    return std::make_unique<TiledImage>( pyramidPath.wstring() );
+}
+
+std::wstring TiledImage::GetPyramidFileName( const std::wstring& fileName )
+{
+    return fileName + L".mips.exr";
+}
+
+void TiledImage::BuildPyramid( const std::wstring& sourceFileName, const std::wstring& pyramidFileName,
+                               uint32_t tileSize, bool compress )
+{
+    std::unique_ptr<RowSource> source;
+    if ( fs::path( sourceFileName ).extension() == ".hdr" )
+    {
+        source = std::make_unique<HDRRowSource>( sourceFileName );
+    }
+    else
+    {
+        source = std::make_unique<EXRRowSource>( sourceFileName );
+    }
+
+    PyramidWriter writer( pyramidFileName, source->Width, source->Height, tileSize, source->HasAlpha, compress );
+
+    std::vector<float> row( static_cast<size_t>( source->Width ) * 4 );
+    for ( uint32_t y = 0; y < source->Height; ++y )
+    {
+        source->ReadRow( row.data() );
+        writer.AddRow( row.data() );
+    }
+
+    writer.Finish();
+}
+
+TiledImage::TiledImage( const std::wstring& fileName )
+: m_FileName( fileName )
+, m_File( fs::path( fileName ), std::ios::binary | std::ios::ate )
+, m_FileSize( 0 )
+, m_DataWindowX( 0 )
+, m_DataWindowY( 0 )
+, m_Compression( EXRCompressionNone )
+, m_IsTiled( false )
+, m_RoundUp( false )
+, m_TileWidth( 0 )
+, m_TileHeight( 0 )
+, m_Format( DXGI_FORMAT_R16G16B16A16_FLOAT )
+, m_ComponentMask( 0 )
+, m_IsLuminance( false )
+, m_NumBytesRead( 0 )
+, m_NumChunksDecoded( 0 )
+{
+    if ( !m_File.is_open() )
+    {
+        throw std::exception( "Failed to open EXR file." );
+    }
+
+    m_FileSize = static_cast<uint64_t>( m_File.tellg() );
+    m_File.seekg( 0 );
+
+    ReadHeader();
+}
+
+TiledImage::~TiledImage() = default;
+
+void TiledImage::ReadHeader()
+{
+    auto readBytes = [this]( void* dst, size_t size ) {
+        if ( !m_File.read( static_cast<char*>( dst ), size ) )
+        {
+            throw std::exception( "Unexpected end of EXR file." );
+        }
+        m_NumBytesRead += size;
+    };
+
+    auto readString = [&readBytes]() {
+        std::string str;
+        for ( char c; readBytes( &c, 1 ), c != 0; )
+        {
+            if ( str.size() >= 255 )
+            {
+                throw std::exception( "Invalid EXR header." );
+            }
+            str.push_back( c );
+        }
+        return str;
+    };
+
+    uint32_t magic, version;
+    readBytes( &magic, sizeof( magic ) );
+    readBytes( &version, sizeof( version ) );
+
+    if ( magic != EXRMagic || ( version & 0xff ) != EXRVersion )
+    {
+        throw std::exception( "Not an EXR file." );
+    }
+    if ( version & EXRNonImageFlags )
+    {
+        throw std::exception( "Deep and multi-part EXR files are not supported." );
+    }
+    m_IsTiled = ( version & EXRTiledFlag ) != 0;
+
+    bool     hasChannels = false, hasDataWindow = false, hasTiles = false;
+    uint32_t width = 0, height = 0, levelMode = EXRLevelModeOne;
+
+    std::vector<uint8_t> value;
+    for ( std::string name = readString(); !name.empty(); name = readString() )
+    {
+        std::string type = readString();
+        int32_t     size;
+        readBytes( &size, sizeof( size ) );
+        if ( size < 0 || static_cast<uint64_t>( size ) > m_FileSize )
+        {
+            throw std::exception( "Invalid EXR header." );
+        }
+        value.resize( size );
+        readBytes( value.data(), size );
+
+        if ( name == "channels" && type == "chlist" )
+        {
+            // Each channel is a name followed by 16 bytes.
+            for ( size_t offset = 0; offset < value.size() && value[offset] != 0; )
+            {
+                auto nameEnd = std::find( value.begin() + offset, value.end(), 0 );
+                if ( static_cast<size_t>( value.end() - nameEnd ) < 17 )
+                {
+                    throw std::exception( "Invalid EXR channel list." );
+                }
+
+                Channel channel;
+                channel.Name = std::string( value.begin() + offset, nameEnd );
+                offset       = static_cast<size_t>( nameEnd - value.begin() ) + 1;
+
+                channel.PixelType  = ReadValue<uint32_t>( &value[offset] );
+                int32_t xSampling  = ReadValue<int32_t>( &value[offset + 8] );
+                int32_t ySampling  = ReadValue<int32_t>( &value[offset + 12] );
+                offset            += 16;
+
+                if ( channel.PixelType > EXRPixelTypeFloat )
+                {
+                    throw std::exception( "Invalid EXR pixel type." );
+                }
+                if ( xSampling != 1 || ySampling != 1 )
+                {
+                    throw std::exception( "Subsampled EXR channels are not supported." );
+                }
+
+                channel.SampleSize = channel.PixelType == EXRPixelTypeHalf ? 2 : 4;
+                channel.Component  = channel.Name == "R"   ? 0
+                                     : channel.Name == "G" ? 1
+                                     : channel.Name == "B" ? 2
+                                     : channel.Name == "A" ? 3
+                                     : channel.Name == "Y" ? 4
+                                                           : -1;
+                m_Channels.push_back( channel );
+            }
+            hasChannels = true;
+        }
+        else if ( name == "compression" && size == 1 )
+        {
+            m_Compression = value[0];
+        }
+        else if ( name == "dataWindow" && size == 16 )
+        {
+            int32_t xMin = ReadValue<int32_t>( &value[0] );
+            int32_t yMin = ReadValue<int32_t>( &value[4] );
+            int32_t xMax = ReadValue<int32_t>( &value[8] );
+            int32_t yMax = ReadValue<int32_t>( &value[12] );
+            if ( xMax < xMin || yMax < yMin || static_cast<int64_t>( xMax ) - xMin >= 0x10000 ||
+                 static_cast<int64_t>( yMax ) - yMin >= 0x10000 )
+            {
+                throw std::exception( "Invalid EXR data window." );
+            }
+
+            m_DataWindowX = xMin;
+            m_DataWindowY = yMin;
+            width         = static_cast<uint32_t>( xMax - xMin + 1 );
+            height        = static_cast<uint32_t>( yMax - yMin + 1 );
+            hasDataWindow = true;
+        }
+        else if ( name == "tiles" && size == 9 )
+        {
+            m_TileWidth  = ReadValue<uint32_t>( &value[0] );
+            m_TileHeight = ReadValue<uint32_t>( &value[4] );
+            levelMode    = value[8] & 0xf;
+            m_RoundUp    = ( value[8] >> 4 ) != 0;
+            hasTiles     = true;
+        }
+    }
+
+    if ( !hasChannels || !hasDataWindow || ( m_IsTiled && !hasTiles ) )
+    {
+        throw std::exception( "Invalid EXR header." );
+    }
+    if ( m_Compression != EXRCompressionNone && m_Compression != EXRCompressionRLE &&
+         m_Compression != EXRCompressionZIPS && m_Compression != EXRCompressionZIP )
+    {
+        throw std::exception( "Unsupported EXR compression method." );
+    }
+
+    // Choose the output format from the color channels.
+    bool isHalf = true;
+    for ( const auto& channel: m_Channels )
+    {
+        if ( channel.Component >= 0 )
+        {
+            isHalf = isHalf && channel.PixelType == EXRPixelTypeHalf;
+            m_ComponentMask |= 1u << channel.Component;
+        }
+    }
+    if ( m_ComponentMask == 0 )
+    {
+        throw std::exception( "The EXR file has no color channels." );
+    }
+
+    // The luminance channel is only used if there is no red channel.
+    m_IsLuminance = ( m_ComponentMask & 0x11 ) == 0x10;
+    m_ComponentMask = ( m_ComponentMask & 0xf ) | ( m_IsLuminance ? 0x7 : 0 );
+    m_Format      = isHalf ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+    // Layout of the chunks.
+    uint32_t numLevels = 1;
+    if ( m_IsTiled )
+    {
+        if ( m_TileWidth == 0 || m_TileHeight == 0 || m_TileWidth > 0x10000 || m_TileHeight > 0x10000 )
+        {
+            throw std::exception( "Invalid EXR tile size." );
+        }
+
+        if ( levelMode == EXRLevelModeMipmap )
+        {
+            uint32_t size = std::max( width, height );
+            numLevels     = 1;
+            while ( GetLevelSize( size, numLevels - 1, m_RoundUp ) > 1 )
+            {
+                ++numLevels;
+            }
+        }
+        else if ( levelMode != EXRLevelModeOne )
+        {
+            throw std::exception( "Ripmapped EXR files are not supported." );
+        }
+    }
+    else
+    {
+        m_TileWidth  = width;
+        m_TileHeight = m_Compression == EXRCompressionZIP ? 16 : 1;
+    }
+
+    size_t numChunks = 0;
+    for ( uint32_t mip = 0; mip < numLevels; ++mip )
+    {
+        Level level;
+        level.Width      = GetLevelSize( width, mip, m_RoundUp );
+        level.Height     = GetLevelSize( height, mip, m_RoundUp );
+        level.NumTilesX  = ( level.Width + m_TileWidth - 1 ) / m_TileWidth;
+        level.NumTilesY  = ( level.Height + m_TileHeight - 1 ) / m_TileHeight;
+        level.FirstChunk = numChunks;
+        m_Levels.push_back( level );
+
+        numChunks += static_cast<size_t>( level.NumTilesX ) * level.NumTilesY;
+    }
+
+    m_ChunkOffsets.resize( numChunks );
+    readBytes( m_ChunkOffsets.data(), numChunks * sizeof( uint64_t ) );
+    for ( auto offset: m_ChunkOffsets )
+    {
+        if ( offset == 0 || offset >= m_FileSize )
+        {
+            throw std::exception( "Invalid EXR chunk offset table (the file may be incomplete)." );
+        }
+    }
+}
+
+bool TiledImage::HasFullMipChain() const
+{
+    return !m_RoundUp && GetNumMips() == GetNumFullMips( GetWidth(), GetHeight() );
+}
+
+uint32_t TiledImage::GetMostDetailedMip( uint32_t maxSize ) const
+{
+    uint32_t mip = 0;
+    if ( maxSize > 0 )
+    {
+        while ( mip + 1 < GetNumMips() && ( GetWidth( mip ) > maxSize || GetHeight( mip ) > maxSize ) )
+        {
+            ++mip;
+        }
+    }
+
+    return mip;
+}
+
+uint32_t TiledImage::DecodeChunk( uint32_t mip, uint32_t tileX, uint32_t tileY ) const
+{
+    const auto& level = m_Levels[mip];
+
+    uint32_t x0     = tileX * m_TileWidth;
+    uint32_t y0     = tileY * m_TileHeight;
+    uint32_t width  = std::min( m_TileWidth, level.Width - x0 );
+    uint32_t height = std::min( m_TileHeight, level.Height - y0 );
+
+    size_t rowSize = 0;
+    for ( const auto& channel: m_Channels )
+    {
+        rowSize += static_cast<size_t>( width ) * channel.SampleSize;
+    }
+    size_t chunkSize = rowSize * height;
+
+    m_File.seekg( m_ChunkOffsets[level.FirstChunk + static_cast<size_t>( tileY ) * level.NumTilesX + tileX] );
+
+    // Check the chunk header.
+    int32_t header[5];
+    size_t  headerSize = m_IsTiled ? 5 : 2;
+    if ( !m_File.read( reinterpret_cast<char*>( header ), headerSize * sizeof( int32_t ) ) )
+    {
+        throw std::exception( "Unexpected end of EXR file." );
+    }
+
+    bool isValid = m_IsTiled ? header[0] == static_cast<int32_t>( tileX ) &&
+                                   header[1] == static_cast<int32_t>( tileY ) &&
+                                   header[2] == static_cast<int32_t>( mip ) && header[3] == static_cast<int32_t>( mip )
+                             : header[0] == static_cast<int32_t>( m_DataWindowY + y0 );
+    int32_t packedSize = header[headerSize - 1];
+    if ( !isValid || packedSize <= 0 || static_cast<size_t>( packedSize ) > chunkSize )
+    {
+        throw std::exception( "Invalid EXR chunk." );
+    }
+
+    m_PackedData.resize( packedSize );
+    if ( !m_File.read( reinterpret_cast<char*>( m_PackedData.data() ), packedSize ) )
+    {
+        throw std::exception( "Unexpected end of EXR file." );
+    }
+    m_NumBytesRead += headerSize * sizeof( int32_t ) + packedSize;
+    ++m_NumChunksDecoded;
+
+    // Chunks that did not compress are stored uncompressed.
+    if ( static_cast<size_t>( packedSize ) == chunkSize )
+    {
+        m_ChunkData.swap( m_PackedData );
+        return height;
+    }
+
+    m_ChunkData.resize( chunkSize );
+    bool isDecoded = false;
+    if ( m_Compression == EXRCompressionRLE )
+    {
+        isDecoded = DecodeRLE( m_PackedData.data(), m_PackedData.size(), m_ChunkData.data(), chunkSize );
+    }
+    else if ( m_Compression == EXRCompressionZIP || m_Compression == EXRCompressionZIPS )
+    {
+        uLongf decodedSize = static_cast<uLongf>( chunkSize );
+        isDecoded = uncompress( m_ChunkData.data(), &decodedSize, m_PackedData.data(),
+                                static_cast<uLong>( m_PackedData.size() ) ) == Z_OK &&
+                    decodedSize == chunkSize;
+    }
+
+    if ( !isDecoded )
+    {
+        throw std::exception( "Failed to decompress EXR chunk." );
+    }
+
+    m_PackedData.resize( chunkSize );
+    RemovePredictor( m_ChunkData.data(), m_PackedData.data(), chunkSize );
+    m_ChunkData.swap( m_PackedData );
+
+    return height;
+}
+
+void TiledImage::ReadRegion( uint32_t mip, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* dst,
+                             size_t rowPitch ) const
+{
+    if ( mip >= GetNumMips() || width == 0 || height == 0 || x + width > GetWidth( mip ) ||
+         y + height > GetHeight( mip ) )
+    {
+        throw std::exception( "Invalid image region." );
+    }
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    const auto& level     = m_Levels[mip];
+    size_t      texelSize = GetTexelSize();
+    bool        isHalf    = m_Format == DXGI_FORMAT_R16G16B16A16_FLOAT;
+    uint8_t*    dstData   = static_cast<uint8_t*>( dst );
+
+    // Clear the components that are not in the file.
+    if ( m_ComponentMask != 0xf )
+    {
+        const uint16_t halfTexel[]  = { 0, 0, 0, 0x3c00 };
+        const float    floatTexel[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        for ( uint32_t row = 0; row < height; ++row )
+        {
+            uint8_t* dstRow = dstData + row * rowPitch;
+            for ( uint32_t i = 0; i < width; ++i )
+            {
+                std::memcpy( dstRow + i * texelSize, isHalf ? static_cast<const void*>( halfTexel ) : floatTexel,
+                             texelSize );
+            }
+        }
+    }
+
+    uint32_t lastTileX = ( x + width - 1 ) / m_TileWidth;
+    uint32_t lastTileY = ( y + height - 1 ) / m_TileHeight;
+    for ( uint32_t tileY = y / m_TileHeight; tileY <= lastTileY; ++tileY )
+    {
+        for ( uint32_t tileX = x / m_TileWidth; tileX <= lastTileX; ++tileX )
+        {
+            uint32_t chunkX      = tileX * m_TileWidth;
+            uint32_t chunkY      = tileY * m_TileHeight;
+            uint32_t chunkWidth  = std::min( m_TileWidth, level.Width - chunkX );
+            uint32_t chunkHeight = DecodeChunk( mip, tileX, tileY );
+
+            // The intersection of the chunk and the region.
+            uint32_t x0 = std::max( x, chunkX );
+            uint32_t x1 = std::min( x + width, chunkX + chunkWidth );
+            uint32_t y0 = std::max( y, chunkY );
+            uint32_t y1 = std::min( y + height, chunkY + chunkHeight );
+
+            size_t rowSize = 0;
+            for ( const auto& channel: m_Channels )
+            {
+                rowSize += static_cast<size_t>( chunkWidth ) * channel.SampleSize;
+            }
+
+            for ( uint32_t row = y0; row < y1; ++row )
+            {
+                const uint8_t* src    = m_ChunkData.data() + ( row - chunkY ) * rowSize;
+                uint8_t*       dstRow = dstData + ( row - y ) * rowPitch + ( x0 - x ) * texelSize;
+
+                for ( const auto& channel: m_Channels )
+                {
+                    const uint8_t* samples = src + ( x0 - chunkX ) * channel.SampleSize;
+                    src += static_cast<size_t>( chunkWidth ) * channel.SampleSize;
+
+                    if ( channel.Component < 0 )
+                        continue;
+
+                    // A luminance channel is written to red, green and blue.
+                    int32_t firstComponent = channel.Component == 4 ? 0 : channel.Component;
+                    int32_t lastComponent  = channel.Component == 4 ? 2 : channel.Component;
+                    if ( channel.Component == 4 && !m_IsLuminance )
+                        continue;
+
+                    for ( int32_t component = firstComponent; component <= lastComponent; ++component )
+                    {
+                        size_t   componentSize = isHalf ? sizeof( uint16_t ) : sizeof( float );
+                        uint8_t* dstTexel      = dstRow + component * componentSize;
+                        uint32_t count         = x1 - x0;
+
+                        if ( isHalf )
+                        {
+                            for ( uint32_t i = 0; i < count; ++i )
+                            {
+                                std::memcpy( dstTexel + i * texelSize, samples + i * sizeof( uint16_t ),
+                                             sizeof( uint16_t ) );
+                            }
+                        }
+                        else if ( channel.PixelType == EXRPixelTypeHalf )
+                        {
+                            XMConvertHalfToFloatStream( reinterpret_cast<float*>( dstTexel ), texelSize,
+                                                        reinterpret_cast<const HALF*>( samples ), sizeof( HALF ),
+                                                        count );
+                        }
+                        else if ( channel.PixelType == EXRPixelTypeFloat )
+                        {
+                            for ( uint32_t i = 0; i < count; ++i )
+                            {
+                                std::memcpy( dstTexel + i * texelSize, samples + i * sizeof( float ),
+                                             sizeof( float ) );
+                            }
+                        }
+                        else
+                        {
+                            for ( uint32_t i = 0; i < count; ++i )
+                            {
+                                float value = static_cast<float>( ReadValue<uint32_t>( samples + i * 4 ) );
+                                std::memcpy( dstTexel + i * texelSize, &value, sizeof( float ) );
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
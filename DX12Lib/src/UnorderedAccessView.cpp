@@ -28,6 +28,11 @@ UnorderedAccessView::UnorderedAccessView( Device& device, const std::shared_ptr<
         assert( ( d3d12ResourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS ) != 0 );
     }
 
+    if ( uav )
+    {
+        m_Desc = std::make_unique<D3D12_UNORDERED_ACCESS_VIEW_DESC>( *uav );
+    }
+
     m_Descriptor = m_Device.AllocateDescriptors( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
 
     d3d12Device->CreateUnorderedAccessView( d3d12Resource.Get(), d3d12CounterResource.Get(), uav,
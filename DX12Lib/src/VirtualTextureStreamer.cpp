@@ -0,0 +1,390 @@
+#include "DX12LibPCH.h"
+
+#include <dx12lib/VirtualTextureStreamer.h>
+
+#include <dx12lib/CommandList.h>
+#include <dx12lib/CommandQueue.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/Helpers.h>
+#include <dx12lib/ResourceStateTracker.h>
+#include <dx12lib/Texture.h>
+
+using namespace dx12lib;
+
+VirtualTexture::VirtualTexture()
+: m_Id( 0 )
+, m_TileShape {}
+, m_NumStandardMips( 0 )
+, m_PackedMipInfo {}
+{}
+
+VirtualTexture::~VirtualTexture() {}
+
+// Adapter for std::make_shared
+class MakeVirtualTexture : public VirtualTexture
+{
+public:
+    MakeVirtualTexture() {}
+
+    virtual ~MakeVirtualTexture() {}
+};
+
+VirtualTextureStreamer::VirtualTextureStreamer( Device& device, uint64_t tilePoolSize, uint32_t maxTilesPerUpdate )
+: m_Device( device )
+, m_TilePoolSize( Math::AlignDown( tilePoolSize, static_cast<uint64_t>( D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES ) ) )
+, m_ResidencyManager( static_cast<uint32_t>( m_TilePoolSize / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES ),
+                      maxTilesPerUpdate )
+, m_FrameIndex( 0 )
+, m_NumBytesUploaded( 0 )
+{
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    ThrowIfFailed( d3d12Device->CheckFeatureSupport( D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof( options ) ) );
+    if ( options.TiledResourcesTier == D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED )
+    {
+        throw std::exception( "Tiled resources are not supported." );
+    }
+
+    CD3DX12_HEAP_DESC heapDesc( m_TilePoolSize, D3D12_HEAP_TYPE_DEFAULT, 0,
+                                D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES );
+    ThrowIfFailed( d3d12Device->CreateHeap( &heapDesc, IID_PPV_ARGS( &m_TilePool ) ) );
+    m_TilePool->SetName( L"Virtual Texture Tile Pool" );
+}
+
+VirtualTextureStreamer::~VirtualTextureStreamer() {}
+
+std::shared_ptr<VirtualTexture>
+    VirtualTextureStreamer::CreateVirtualTexture( std::unique_ptr<DirectX::ScratchImage> image )
+{
+    if ( !image )
+    {
+        throw std::exception( "Invalid image." );
+    }
+
+    TexMetadata metadata = image->GetMetadata();
+    if ( metadata.dimension != TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 )
+    {
+        throw std::exception( "Virtual textures must be 2D textures." );
+    }
+
+    // Generate the mip chain on the CPU. The tiles of each mip are uploaded on demand.
+    if ( metadata.mipLevels == 1 && !IsCompressed( metadata.format ) )
+    {
+        DWORD filter = IsSRGB( metadata.format ) ? TEX_FILTER_SRGB : TEX_FILTER_DEFAULT;
+        auto  mipChain = std::make_unique<ScratchImage>();
+
+        ThrowIfFailed( GenerateMipMaps( image->GetImages(), image->GetImageCount(), metadata, filter, 0, *mipChain ) );
+
+        image    = std::move( mipChain );
+        metadata = image->GetMetadata();
+    }
+
+    auto d3d12Device = m_Device.GetD3D12Device();
+
+    auto textureDesc = CD3DX12_RESOURCE_DESC::Tex2D( metadata.format, static_cast<UINT64>( metadata.width ),
+                                                     static_cast<UINT>( metadata.height ), 1,
+                                                     static_cast<UINT16>( metadata.mipLevels ) );
+    textureDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+
+    ComPtr<ID3D12Resource> d3d12Resource;
+    ThrowIfFailed( d3d12Device->CreateReservedResource( &textureDesc, D3D12_RESOURCE_STATE_COMMON, nullptr,
+                                                        IID_PPV_ARGS( &d3d12Resource ) ) );
+
+    ResourceStateTracker::AddGlobalResourceState( d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON );
+
+    std::shared_ptr<VirtualTexture> virtualTexture = std::make_shared<MakeVirtualTexture>();
+
+    virtualTexture->m_Texture = m_Device.CreateTexture( d3d12Resource );
+    virtualTexture->m_Texture->SetName( L"Virtual Texture" );
+
+    UINT numTiles              = 0;
+    UINT numSubresourceTilings = static_cast<UINT>( metadata.mipLevels );
+    virtualTexture->m_SubresourceTiling.resize( numSubresourceTilings );
+    d3d12Device->GetResourceTiling( d3d12Resource.Get(), &numTiles, &virtualTexture->m_PackedMipInfo,
+                                    &virtualTexture->m_TileShape, &numSubresourceTilings, 0,
+                                    virtualTexture->m_SubresourceTiling.data() );
+
+    virtualTexture->m_NumStandardMips = virtualTexture->m_PackedMipInfo.NumStandardMips;
+    if ( virtualTexture->m_NumStandardMips == 0 )
+    {
+        throw std::exception( "Texture is too small to be used as a virtual texture." );
+    }
+
+    std::vector<TileResidencyManager::MipTiling> mipTiling;
+    for ( uint32_t mip = 0; mip < virtualTexture->m_NumStandardMips; ++mip )
+    {
+        const auto& subresourceTiling = virtualTexture->m_SubresourceTiling[mip];
+        mipTiling.push_back( { subresourceTiling.WidthInTiles, subresourceTiling.HeightInTiles } );
+    }
+
+    // The residency map stores the most detailed resident mip for each tile of the most detailed mip.
+    auto residencyMapDesc =
+        CD3DX12_RESOURCE_DESC::Tex2D( DXGI_FORMAT_R8_UINT, mipTiling[0].WidthInTiles, mipTiling[0].HeightInTiles, 1, 1 );
+    virtualTexture->m_ResidencyMap = m_Device.CreateTexture( residencyMapDesc );
+    virtualTexture->m_ResidencyMap->SetName( L"Virtual Texture Residency Map" );
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    virtualTexture->m_Id = m_ResidencyManager.RegisterTexture( mipTiling );
+
+    auto& copyQueue   = m_Device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_COPY );
+    auto  commandList = copyQueue.GetCommandList();
+
+    // The packed mips are always resident.
+    const auto& packedMipInfo = virtualTexture->m_PackedMipInfo;
+    if ( packedMipInfo.NumPackedMips > 0 )
+    {
+        virtualTexture->m_PackedTiles = m_ResidencyManager.ReservePhysicalTiles( packedMipInfo.NumTilesForPackedMips );
+
+        CD3DX12_TILED_RESOURCE_COORDINATE startCoordinate( 0, 0, 0, packedMipInfo.NumStandardMips );
+        D3D12_TILE_REGION_SIZE            regionSize = { packedMipInfo.NumTilesForPackedMips, FALSE, 0, 0, 0 };
+        std::vector<UINT>                 rangeTileCounts( virtualTexture->m_PackedTiles.size(), 1 );
+
+        copyQueue.GetD3D12CommandQueue()->UpdateTileMappings(
+            d3d12Resource.Get(), 1, &startCoordinate, &regionSize, m_TilePool.Get(),
+            static_cast<UINT>( virtualTexture->m_PackedTiles.size() ), nullptr, virtualTexture->m_PackedTiles.data(),
+            rangeTileCounts.data(), D3D12_TILE_MAPPING_FLAG_NONE );
+
+        for ( uint32_t mip = packedMipInfo.NumStandardMips; mip < metadata.mipLevels; ++mip )
+        {
+            const Image* mipImage = image->GetImage( mip, 0, 0 );
+
+            D3D12_SUBRESOURCE_DATA subresource;
+            subresource.pData      = mipImage->pixels;
+            subresource.RowPitch   = mipImage->rowPitch;
+            subresource.SlicePitch = mipImage->slicePitch;
+
+            commandList->CopyTextureSubresource( virtualTexture->m_Texture, mip, 1, &subresource );
+        }
+    }
+
+    copyQueue.ExecuteCommandList( commandList );
+    m_Device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_DIRECT ).Wait( copyQueue );
+
+    virtualTexture->m_SourceImage = std::move( image );
+
+    m_VirtualTextures.resize( virtualTexture->m_Id + 1 );
+    m_VirtualTextures[virtualTexture->m_Id] = virtualTexture;
+    m_DirtyResidencyMaps.push_back( virtualTexture->m_Id );
+
+    return virtualTexture;
+}
+
+void VirtualTextureStreamer::DestroyVirtualTexture( const std::shared_ptr<VirtualTexture>& virtualTexture )
+{
+    if ( !virtualTexture )
+        return;
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    uint32_t id = virtualTexture->m_Id;
+    assert( id < m_VirtualTextures.size() && m_VirtualTextures[id] == virtualTexture );
+
+    m_ResidencyManager.UnregisterTexture( id, m_FrameIndex );
+    m_ResidencyManager.ReleasePhysicalTiles( virtualTexture->m_PackedTiles, m_FrameIndex );
+    virtualTexture->m_PackedTiles.clear();
+
+    m_DirtyResidencyMaps.erase( std::remove( m_DirtyResidencyMaps.begin(), m_DirtyResidencyMaps.end(), id ),
+                                m_DirtyResidencyMaps.end() );
+    m_VirtualTextures[id].reset();
+}
+
+void VirtualTextureStreamer::RequestTile( const TileCoord& tile )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_ResidencyManager.RequestTile( tile );
+}
+
+void VirtualTextureStreamer::RequestTiles( const uint64_t* packedTiles, size_t numTiles )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_ResidencyManager.RequestTiles( packedTiles, numTiles );
+}
+
+void VirtualTextureStreamer::RequestRegion( const VirtualTexture& virtualTexture, uint32_t mipLevel, float u0,
+                                            float v0, float u1, float v1 )
+{
+    mipLevel = std::min( mipLevel, virtualTexture.m_NumStandardMips - 1 );
+
+    const auto& subresourceTiling = virtualTexture.m_SubresourceTiling[mipLevel];
+    auto        desc              = virtualTexture.m_Texture->GetD3D12ResourceDesc();
+
+    float mipWidth  = static_cast<float>( std::max<UINT64>( desc.Width >> mipLevel, 1 ) );
+    float mipHeight = static_cast<float>( std::max<UINT>( desc.Height >> mipLevel, 1 ) );
+    float tileWidth = static_cast<float>( virtualTexture.m_TileShape.WidthInTexels );
+    float tileHeight = static_cast<float>( virtualTexture.m_TileShape.HeightInTexels );
+
+    auto toTile = []( float uv, float size, float tileSize, uint32_t numTiles ) {
+        uv = std::min( std::max( uv, 0.0f ), 1.0f );
+        return std::min( static_cast<uint32_t>( uv * size / tileSize ), numTiles - 1 );
+    };
+
+    uint32_t x0 = toTile( std::min( u0, u1 ), mipWidth, tileWidth, subresourceTiling.WidthInTiles );
+    uint32_t x1 = toTile( std::max( u0, u1 ), mipWidth, tileWidth, subresourceTiling.WidthInTiles );
+    uint32_t y0 = toTile( std::min( v0, v1 ), mipHeight, tileHeight, subresourceTiling.HeightInTiles );
+    uint32_t y1 = toTile( std::max( v0, v1 ), mipHeight, tileHeight, subresourceTiling.HeightInTiles );
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    for ( uint32_t y = y0; y <= y1; ++y )
+    {
+        for ( uint32_t x = x0; x <= x1; ++x )
+        {
+            m_ResidencyManager.RequestTile( { virtualTexture.m_Id, mipLevel, x, y } );
+        }
+    }
+}
+
+void VirtualTextureStreamer::Update( uint64_t frameIndex )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    m_FrameIndex = frameIndex;
+
+    auto update = m_ResidencyManager.ProcessRequests( frameIndex );
+
+    // Group the tile mappings by texture.
+    using TileMappings = std::map<uint32_t, std::vector<TileResidencyManager::TileMapping>>;
+    TileMappings unmappedTiles;
+    TileMappings mappedTiles;
+
+    for ( const auto& tileMapping: update.UnmappedTiles )
+    {
+        unmappedTiles[tileMapping.Tile.TextureId].push_back( tileMapping );
+    }
+    for ( const auto& tileMapping: update.MappedTiles )
+    {
+        mappedTiles[tileMapping.Tile.TextureId].push_back( tileMapping );
+    }
+
+    // Tiles of destroyed textures don't need to be unmapped.
+    for ( const auto& textureTiles: unmappedTiles )
+    {
+        if ( m_VirtualTextures[textureTiles.first] )
+        {
+            UpdateTileMappings( *m_VirtualTextures[textureTiles.first], textureTiles.second, false );
+        }
+    }
+
+    if ( !mappedTiles.empty() )
+    {
+        auto& copyQueue   = m_Device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_COPY );
+        auto  commandList = copyQueue.GetCommandList();
+
+        for ( const auto& textureTiles: mappedTiles )
+        {
+            const auto& virtualTexture = *m_VirtualTextures[textureTiles.first];
+
+            UpdateTileMappings( virtualTexture, textureTiles.second, true );
+
+            for ( const auto& tileMapping: textureTiles.second )
+            {
+                CopyTile( *commandList, virtualTexture, tileMapping.Tile );
+            }
+        }
+
+        copyQueue.ExecuteCommandList( commandList );
+
+        // Don't render with the new tiles before they are uploaded.
+        m_Device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_DIRECT ).Wait( copyQueue );
+    }
+
+    for ( uint32_t textureId: update.DirtyTextures )
+    {
+        if ( std::find( m_DirtyResidencyMaps.begin(), m_DirtyResidencyMaps.end(), textureId ) ==
+             m_DirtyResidencyMaps.end() )
+        {
+            m_DirtyResidencyMaps.push_back( textureId );
+        }
+    }
+}
+
+void VirtualTextureStreamer::UpdateResidencyMaps( CommandList& commandList )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    for ( uint32_t textureId: m_DirtyResidencyMaps )
+    {
+        const auto& virtualTexture = m_VirtualTextures[textureId];
+        const auto& residencyMap   = m_ResidencyManager.GetResidencyMap( textureId );
+        const auto& mipTiling      = m_ResidencyManager.GetMipTiling( textureId );
+
+        D3D12_SUBRESOURCE_DATA subresource;
+        subresource.pData      = residencyMap.data();
+        subresource.RowPitch   = mipTiling[0].WidthInTiles;
+        subresource.SlicePitch = residencyMap.size();
+
+        commandList.CopyTextureSubresource( virtualTexture->m_ResidencyMap, 0, 1, &subresource );
+    }
+
+    m_DirtyResidencyMaps.clear();
+}
+
+TileResidencyManager::Statistics VirtualTextureStreamer::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_ResidencyManager.GetStatistics();
+}
+
+uint64_t VirtualTextureStreamer::GetNumBytesUploaded() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_NumBytesUploaded;
+}
+
+void VirtualTextureStreamer::UpdateTileMappings( const VirtualTexture&                                 virtualTexture,
+                                                 const std::vector<TileResidencyManager::TileMapping>& tileMappings,
+                                                 bool                                                  map )
+{
+    UINT numTiles = static_cast<UINT>( tileMappings.size() );
+
+    std::vector<D3D12_TILED_RESOURCE_COORDINATE> coordinates;
+    std::vector<D3D12_TILE_REGION_SIZE>          regionSizes( numTiles, { 1, FALSE, 0, 0, 0 } );
+    std::vector<D3D12_TILE_RANGE_FLAGS>          rangeFlags( numTiles, map ? D3D12_TILE_RANGE_FLAG_NONE
+                                                                           : D3D12_TILE_RANGE_FLAG_NULL );
+    std::vector<UINT>                            heapRangeStartOffsets;
+    std::vector<UINT>                            rangeTileCounts( numTiles, 1 );
+
+    coordinates.reserve( numTiles );
+    heapRangeStartOffsets.reserve( numTiles );
+
+    for ( const auto& tileMapping: tileMappings )
+    {
+        coordinates.push_back(
+            CD3DX12_TILED_RESOURCE_COORDINATE( tileMapping.Tile.X, tileMapping.Tile.Y, 0, tileMapping.Tile.MipLevel ) );
+        heapRangeStartOffsets.push_back( tileMapping.PhysicalTile );
+    }
+
+    auto d3d12CommandQueue = m_Device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_COPY ).GetD3D12CommandQueue();
+    d3d12CommandQueue->UpdateTileMappings( virtualTexture.m_Texture->GetD3D12Resource().Get(), numTiles,
+                                           coordinates.data(), regionSizes.data(), map ? m_TilePool.Get() : nullptr,
+                                           numTiles, rangeFlags.data(), map ? heapRangeStartOffsets.data() : nullptr,
+                                           rangeTileCounts.data(), D3D12_TILE_MAPPING_FLAG_NONE );
+}
+
+void VirtualTextureStreamer::CopyTile( CommandList& commandList, const VirtualTexture& virtualTexture,
+                                       const TileCoord& tile )
+{
+    const Image* image     = virtualTexture.m_SourceImage->GetImage( tile.MipLevel, 0, 0 );
+    const auto&  tileShape = virtualTexture.m_TileShape;
+
+    uint32_t x      = tile.X * tileShape.WidthInTexels;
+    uint32_t y      = tile.Y * tileShape.HeightInTexels;
+    uint32_t width  = std::min( tileShape.WidthInTexels, static_cast<uint32_t>( image->width ) - x );
+    uint32_t height = std::min( tileShape.HeightInTexels, static_cast<uint32_t>( image->height ) - y );
+
+    // Block-compressed formats are addressed in 4x4 blocks.
+    bool   isCompressed  = IsCompressed( image->format );
+    size_t blockSize     = isCompressed ? 4 : 1;
+    size_t bytesPerBlock = BitsPerPixel( image->format ) * blockSize * blockSize / 8;
+    size_t numRows       = ( height + blockSize - 1 ) / blockSize;
+
+    D3D12_SUBRESOURCE_DATA subresource;
+    subresource.pData      = image->pixels + ( y / blockSize ) * image->rowPitch + ( x / blockSize ) * bytesPerBlock;
+    subresource.RowPitch   = image->rowPitch;
+    subresource.SlicePitch = image->rowPitch * numRows;
+
+    commandList.CopyTextureRegion( virtualTexture.m_Texture, tile.MipLevel, x, y, 0, width, height, 1, subresource );
+
+    m_NumBytesUploaded += ( ( width + blockSize - 1 ) / blockSize ) * bytesPerBlock * numRows;
+}
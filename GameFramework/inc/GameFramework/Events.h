@@ -30,14 +30,19 @@
  *  @brief Application and Window events.
  */
 
+#include "FastDelegate.h"
 #include "KeyCodes.h"
 
 #include "../signals/signals.hpp"
 
 #include <string>
+#include <vector>
 
 /**
  * A Delegate holds function callbacks.
+ *
+ * Events that are invoked at a high rate (update and input events) use the
+ * FastDelegate instead (see FastDelegate.h) which has the same interface.
  */
 
 // Primary delegate template.
@@ -119,7 +124,7 @@ public:
     double TotalTime;
 };
 
-using UpdateEvent = Delegate<void(UpdateEventArgs&)>;
+using UpdateEvent = FastDelegate<void( UpdateEventArgs& )>;
 
 class DPIScaleEventArgs : public EventArgs
 {
@@ -190,7 +195,7 @@ public:
     bool     Alt;       // Is the Alt modifier pressed
 };
 
-using KeyboardEvent = Delegate<void(KeyEventArgs&)>;
+using KeyboardEvent = FastDelegate<void( KeyEventArgs& )>;
 
 /**
  * MouseMotionEventArgs are used to indicate the mouse moved or was dragged over
@@ -226,7 +231,7 @@ public:
     int RelY;           // How far the mouse moved since the last event (in pixels).
 };
 
-using MouseMotionEvent = Delegate<void(MouseMotionEventArgs&)>;
+using MouseMotionEvent = FastDelegate<void( MouseMotionEventArgs& )>;
 
 enum class MouseButton
 {
@@ -275,7 +280,7 @@ public:
             // the client area.
 };
 
-using MouseButtonEvent = Delegate<void(MouseButtonEventArgs&)>;
+using MouseButtonEvent = FastDelegate<void( MouseButtonEventArgs& )>;
 
 /**
  * MouseWheelEventArgs indicates if the mouse wheel was moved and how much.
@@ -312,7 +317,7 @@ public:
     int Y;              // The Y-position of the cursor relative to the upper-left corner of
                         // the client area.
 };
-using MouseWheelEvent = Delegate<void(MouseWheelEventArgs&)>;
+using MouseWheelEvent = FastDelegate<void( MouseWheelEventArgs& )>;
 
 enum class WindowState
 {
@@ -411,3 +416,18 @@ public:
     std::wstring Path;    // The file or directory path that was modified.
 };
 using FileChangeEvent = Delegate<void(FileChangedEventArgs&)>;
+
+class FileChangesEventArgs : public EventArgs
+{
+public:
+    using base = EventArgs;
+
+    FileChangesEventArgs( std::vector<FileChangedEventArgs> changes )
+    : base()
+    , Changes( std::move( changes ) )
+    {}
+
+    // The changes in the order they were first detected (at most one change per path).
+    std::vector<FileChangedEventArgs> Changes;
+};
+using FileChangesEvent = Delegate<void( FileChangesEventArgs& )>;
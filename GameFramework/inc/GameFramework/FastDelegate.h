@@ -0,0 +1,536 @@
+#pragma once
+
+/**
+ *  @file FastDelegate.h
+ *
+ *  @brief A delegate with low-overhead invocation for high-frequency events.
+ *
+ *  The callbacks of a FastDelegate are stored in a contiguous array that is
+ *  never modified after it is published. Adding or removing a callback copies
+ *  the array (under a mutex) and atomically replaces the published array, so
+ *  invoking the delegate does not take a lock, does not copy the callbacks and
+ *  does not allocate. The replaced arrays are deleted once no invocation is
+ *  running, which is tracked with a single reader counter.
+ *
+ *  This makes invoking cheap at the expense of adding and removing callbacks,
+ *  which is the right trade-off for events like Update and MouseMoved that are
+ *  invoked many times per frame but are only connected when a window is created.
+ *
+ *  The FastDelegate has the same interface as the Delegate so that an event can
+ *  be switched from one to the other by changing its alias in Events.h.
+ *
+ *  The EventCoalescer can be used to merge consecutive event args (for example,
+ *  mouse motion) into a single invocation.
+ */
+
+#include "../signals/optional.hpp"  // for opt::optional
+
+#include <atomic>       // for std::atomic
+#include <cstdint>      // for uint64_t
+#include <functional>   // for std::function
+#include <memory>       // for std::shared_ptr, std::weak_ptr
+#include <mutex>        // for std::mutex
+#include <type_traits>  // for std::is_void, std::is_member_function_pointer, std::enable_if
+#include <utility>      // for std::move
+#include <vector>       // for std::vector
+
+namespace detail
+{
+// The part of the FastDelegate that is referenced by the connections.
+class FastDelegateState
+{
+public:
+    virtual ~FastDelegateState() = default;
+
+    // Remove the callback with the specified id.
+    virtual bool Disconnect( uint64_t id ) = 0;
+};
+}  // namespace detail
+
+/**
+ * A connection can be used to remove a callback from a FastDelegate. The
+ * connection does not keep the delegate alive.
+ */
+class FastConnection
+{
+public:
+    FastConnection() = default;
+    FastConnection( std::weak_ptr<detail::FastDelegateState> state, uint64_t id )
+    : m_State( std::move( state ) )
+    , m_Id( id )
+    {}
+
+    /**
+     * Remove the callback from the delegate.
+     *
+     * @returns true if the callback was removed, false if the callback was
+     * already removed or the delegate was destroyed.
+     */
+    bool Disconnect()
+    {
+        auto state = m_State.lock();
+        m_State.reset();
+
+        return state && state->Disconnect( m_Id );
+    }
+
+    /**
+     * Check whether the delegate still exists. This does not check if the
+     * callback was removed by another copy of the connection.
+     */
+    bool IsConnected() const
+    {
+        return !m_State.expired();
+    }
+
+    uint64_t GetId() const
+    {
+        return m_Id;
+    }
+
+private:
+    std::weak_ptr<detail::FastDelegateState> m_State;
+    uint64_t                                 m_Id = 0;
+};
+
+/**
+ * A connection that removes the callback when it goes out of scope.
+ */
+class ScopedFastConnection
+{
+public:
+    ScopedFastConnection() = default;
+    ScopedFastConnection( FastConnection connection )
+    : m_Connection( std::move( connection ) )
+    {}
+
+    ScopedFastConnection( ScopedFastConnection&& ) = default;
+    ScopedFastConnection& operator=( ScopedFastConnection&& other )
+    {
+        if ( this != &other )
+        {
+            m_Connection.Disconnect();
+            m_Connection = std::move( other.m_Connection );
+        }
+        return *this;
+    }
+
+    ScopedFastConnection( const ScopedFastConnection& ) = delete;
+    ScopedFastConnection& operator=( const ScopedFastConnection& ) = delete;
+
+    ~ScopedFastConnection()
+    {
+        m_Connection.Disconnect();
+    }
+
+    bool Disconnect()
+    {
+        return m_Connection.Disconnect();
+    }
+
+    /**
+     * Release the connection without removing the callback.
+     */
+    FastConnection Release()
+    {
+        return std::move( m_Connection );
+    }
+
+private:
+    FastConnection m_Connection;
+};
+
+// Primary delegate template.
+template<typename Func>
+class FastDelegate;
+
+template<typename R, typename... Args>
+class FastDelegate<R( Args... )>
+{
+public:
+    using connection        = FastConnection;
+    using scoped_connection = ScopedFastConnection;
+
+    /**
+     * A callback of the delegate.
+     */
+    class slot
+    {
+    public:
+        /**
+         * A free function, a lambda, or any other callable.
+         */
+        template<typename Func, typename = std::enable_if_t<!std::is_same<std::decay_t<Func>, slot>::value>>
+        slot( Func&& func )
+        : m_Func( std::forward<Func>( func ) )
+        , m_IsTracked( false )
+        {}
+
+        /**
+         * A member function that is invoked on a raw pointer. The object must
+         * outlive the connection.
+         */
+        template<typename Func, typename T,
+                 typename = std::enable_if_t<std::is_member_function_pointer<Func>::value>>
+        slot( Func func, T* ptr )
+        : m_Func( [func, ptr]( Args... args ) -> R { return ( ptr->*func )( std::forward<Args>( args )... ); } )
+        , m_IsTracked( false )
+        {}
+
+        /**
+         * A member function that is invoked on a shared pointer. The object is
+         * not kept alive by the delegate: the callback is skipped after the
+         * object is destroyed.
+         */
+        template<typename Func, typename T,
+                 typename = std::enable_if_t<std::is_member_function_pointer<Func>::value>>
+        slot( Func func, const std::shared_ptr<T>& ptr )
+        : m_Func(
+              [func, p = ptr.get()]( Args... args ) -> R { return ( p->*func )( std::forward<Args>( args )... ); } )
+        , m_Tracked( ptr )
+        , m_IsTracked( true )
+        {}
+
+    private:
+        friend class FastDelegate;
+
+        std::function<R( Args... )> m_Func;
+        // The object that must be alive to invoke the callback (if m_IsTracked is true).
+        std::weak_ptr<void> m_Tracked;
+        bool                m_IsTracked;
+        uint64_t            m_Id = 0;
+    };
+
+    FastDelegate()
+    : m_State( std::make_shared<State>() )
+    {}
+
+    FastDelegate( const FastDelegate& ) = delete;
+    FastDelegate& operator=( const FastDelegate& ) = delete;
+
+    /**
+     * Add function callback to the delegate.
+     *
+     * @param s The function to add to the delegate.
+     * @returns The connection object that can be used to remove the callback
+     * from the delegate.
+     */
+    connection operator+=( slot s )
+    {
+        uint64_t id = m_State->Connect( std::move( s ) );
+        return connection( m_State, id );
+    }
+
+    /**
+     * Remove a callback function from the delegate.
+     *
+     * @param c The connection that was returned when the callback was added.
+     * @returns The number of callback functions removed.
+     */
+    std::size_t operator-=( connection c )
+    {
+        return c.Disconnect() ? 1 : 0;
+    }
+
+    /**
+     * Remove all callbacks from the delegate.
+     */
+    void Clear()
+    {
+        m_State->Clear();
+    }
+
+    /**
+     * The number of callbacks of the delegate.
+     */
+    std::size_t Size() const
+    {
+        return m_State->Size();
+    }
+
+    /**
+     * Invoke the delegate. The callbacks are invoked in the order they were
+     * added. Callbacks that are added or removed by a callback take effect on
+     * the next invocation.
+     *
+     * @returns The result of the last callback that was invoked.
+     */
+    opt::optional<R> operator()( Args... args )
+    {
+        return m_State->Invoke( args... );
+    }
+
+private:
+    using SlotList = std::vector<slot>;
+
+    class State : public detail::FastDelegateState
+    {
+    public:
+        State()
+        : m_Slots( nullptr )
+        , m_NumInvocations( 0 )
+        , m_HasRetiredSlots( false )
+        , m_NextId( 1 )
+        {}
+
+        virtual ~State()
+        {
+            delete m_Slots.load();
+            for ( auto slots: m_RetiredSlots )
+            {
+                delete slots;
+            }
+        }
+
+        uint64_t Connect( slot s )
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+
+            s.m_Id = m_NextId++;
+
+            const SlotList* slots    = m_Slots.load();
+            SlotList*       newSlots = slots ? new SlotList( *slots ) : new SlotList();
+            newSlots->push_back( std::move( s ) );
+
+            Publish( newSlots );
+
+            return newSlots->back().m_Id;
+        }
+
+        virtual bool Disconnect( uint64_t id ) override
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+
+            const SlotList* slots = m_Slots.load();
+            if ( !slots )
+            {
+                return false;
+            }
+
+            SlotList* newSlots = new SlotList();
+            newSlots->reserve( slots->size() );
+            for ( auto& s: *slots )
+            {
+                if ( s.m_Id != id )
+                {
+                    newSlots->push_back( s );
+                }
+            }
+
+            if ( newSlots->size() == slots->size() )
+            {
+                delete newSlots;
+                return false;
+            }
+
+            if ( newSlots->empty() )
+            {
+                delete newSlots;
+                newSlots = nullptr;
+            }
+
+            Publish( newSlots );
+
+            return true;
+        }
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            Publish( nullptr );
+        }
+
+        std::size_t Size() const
+        {
+            const SlotList* slots = m_Slots.load( std::memory_order_acquire );
+            return slots ? slots->size() : 0;
+        }
+
+        opt::optional<R> Invoke( Args&... args )
+        {
+            opt::optional<R> result;
+
+            // Nothing to do for a delegate without callbacks (the list is not
+            // dereferenced so it doesn't need to be protected).
+            if ( !m_Slots.load( std::memory_order_relaxed ) )
+            {
+                return result;
+            }
+
+            // The reader counter must be incremented before the slot list is
+            // loaded so that a writer that replaces the list does not delete
+            // it while it is used.
+            m_NumInvocations.fetch_add( 1 );
+            const SlotList* slots = m_Slots.load();
+
+            if ( slots )
+            {
+                for ( auto& s: *slots )
+                {
+                    std::shared_ptr<void> tracked;
+                    if ( s.m_IsTracked )
+                    {
+                        tracked = s.m_Tracked.lock();
+                        if ( !tracked )
+                        {
+                            continue;
+                        }
+                    }
+
+                    if constexpr ( std::is_void<R>::value )
+                    {
+                        s.m_Func( args... );
+                    }
+                    else
+                    {
+                        result = s.m_Func( args... );
+                    }
+                }
+            }
+
+            if ( m_NumInvocations.fetch_sub( 1 ) == 1 && m_HasRetiredSlots.load() )
+            {
+                std::lock_guard<std::mutex> lock( m_Mutex );
+                DeleteRetiredSlots();
+            }
+
+            return result;
+        }
+
+    private:
+        // Replace the published slot list. m_Mutex must be locked.
+        void Publish( const SlotList* newSlots )
+        {
+            const SlotList* oldSlots = m_Slots.exchange( newSlots );
+            if ( oldSlots )
+            {
+                m_RetiredSlots.push_back( oldSlots );
+                m_HasRetiredSlots = true;
+            }
+
+            DeleteRetiredSlots();
+        }
+
+        // Delete the replaced slot lists if no invocation is running. An
+        // invocation that starts after this check can only load the current
+        // slot list. m_Mutex must be locked.
+        void DeleteRetiredSlots()
+        {
+            if ( m_NumInvocations.load() != 0 )
+            {
+                return;
+            }
+
+            for ( auto slots: m_RetiredSlots )
+            {
+                delete slots;
+            }
+            m_RetiredSlots.clear();
+            m_HasRetiredSlots = false;
+        }
+
+        std::atomic<const SlotList*> m_Slots;
+        // The number of invocations that are currently running (on any thread).
+        std::atomic<uint32_t> m_NumInvocations;
+
+        // Slot lists that were replaced while an invocation was running.
+        std::vector<const SlotList*> m_RetiredSlots;
+        std::atomic_bool             m_HasRetiredSlots;
+
+        std::mutex m_Mutex;
+        uint64_t   m_NextId;
+    };
+
+    std::shared_ptr<State> m_State;
+};
+
+/**
+ * Merges consecutive event args into a single pending event that is invoked
+ * when the coalescer is flushed. The merge function receives the pending event
+ * args and the new event args and updates the pending event args.
+ *
+ * The coalescer must be flushed before any other event is invoked that must
+ * be observed in order with the coalesced events.
+ */
+template<typename EventArgsType>
+class EventCoalescer
+{
+public:
+    using MergeFunc = std::function<void( EventArgsType& pending, const EventArgsType& next )>;
+
+    explicit EventCoalescer( MergeFunc merge )
+    : m_Merge( std::move( merge ) )
+    , m_Enabled( false )
+    {}
+
+    /**
+     * Enable or disable coalescing. If coalescing is disabled, the events
+     * are invoked immediately.
+     */
+    void SetEnabled( bool enabled )
+    {
+        m_Enabled = enabled;
+    }
+    bool IsEnabled() const
+    {
+        return m_Enabled;
+    }
+
+    /**
+     * Add an event. If coalescing is disabled, the function is invoked
+     * immediately.
+     */
+    template<typename Func>
+    void Post( EventArgsType& e, Func&& func )
+    {
+        if ( !m_Enabled )
+        {
+            func( e );
+        }
+        else if ( m_Pending )
+        {
+            m_Merge( *m_Pending, e );
+            ++m_NumMerged;
+        }
+        else
+        {
+            m_Pending = e;
+        }
+    }
+
+    /**
+     * Invoke the function with the pending event (if there is one).
+     */
+    template<typename Func>
+    void Flush( Func&& func )
+    {
+        if ( m_Pending )
+        {
+            // The pending event is cleared before the callback is invoked so
+            // that the callback may post new events.
+            EventArgsType e = std::move( *m_Pending );
+            m_Pending       = opt::nullopt;
+
+            func( e );
+        }
+    }
+
+    bool HasPendingEvent() const
+    {
+        return static_cast<bool>( m_Pending );
+    }
+
+    /**
+     * The number of events that were merged into a pending event.
+     */
+    uint64_t GetNumMerged() const
+    {
+        return m_NumMerged;
+    }
+
+private:
+    MergeFunc                    m_Merge;
+    opt::optional<EventArgsType> m_Pending;
+    uint64_t                     m_NumMerged = 0;
+    bool                         m_Enabled;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ *  @file FileWatcher.h
+ *
+ *  @brief Watches directories for file changes on a background thread.
+ *
+ *  The watcher thread blocks until the OS reports a change (ReadDirectoryChangesW
+ *  on Windows, inotify on Linux). All pending changes are drained on each wakeup
+ *  and changes to the same path are merged into a single change. The changes
+ *  are dispatched as a batch once no new changes were reported for the debounce
+ *  time, so that saving a file (which often produces several notifications) or
+ *  saving many files at once results in a single batch.
+ */
+
+#include "Events.h"
+
+#include <atomic>         // for std::atomic_bool
+#include <chrono>         // for std::chrono::milliseconds
+#include <functional>     // for std::function
+#include <memory>         // for std::unique_ptr
+#include <string>         // for std::wstring
+#include <thread>         // for std::thread
+#include <unordered_map>  // for std::unordered_map
+#include <vector>         // for std::vector
+
+class FileWatcher
+{
+public:
+    /**
+     * Invoked on the watcher thread with the changes of a batch.
+     */
+    using Callback = std::function<void( FileChangesEventArgs& )>;
+
+    /**
+     * @param callback The function that receives the batches of changes.
+     * @param debounceTime The time without new changes before a batch is dispatched.
+     */
+    explicit FileWatcher( Callback callback,
+                          std::chrono::milliseconds debounceTime = std::chrono::milliseconds( 50 ) );
+
+    /**
+     * Stops the watcher thread. Pending changes that were not yet dispatched
+     * are discarded.
+     */
+    ~FileWatcher();
+
+    /**
+     * Start watching a directory.
+     *
+     * @param dir The directory to watch.
+     * @param recursive Whether to also watch the sub-directories.
+     */
+    void AddDirectory( const std::wstring& dir, bool recursive = true );
+
+    /**
+     * Merge a change into the previous change of the same path.
+     *
+     * @returns The merged action or FileAction::Unknown if the changes cancel
+     * each other out (for example, a temporary file that was added and removed).
+     */
+    static FileAction MergeActions( FileAction previous, FileAction next );
+
+private:
+    // Watcher thread entry point.
+    void Run();
+
+    // Merge a change into the pending batch.
+    void AddChange( FileChangedEventArgs& change );
+
+    // The platform-specific implementation.
+    class impl;
+    std::unique_ptr<impl> pImpl;
+
+    Callback                  m_Callback;
+    std::chrono::milliseconds m_DebounceTime;
+
+    // The changes that were not yet dispatched (at most one change per path).
+    std::vector<FileChangedEventArgs> m_PendingChanges;
+    // The index of the pending change of a path.
+    std::unordered_map<std::wstring, size_t> m_PendingChangeIndices;
+
+    std::atomic_bool m_bTerminate;
+    std::thread      m_Thread;
+};
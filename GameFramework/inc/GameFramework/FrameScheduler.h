@@ -0,0 +1,325 @@
+#pragma once
+
+/**
+ *  @file FrameScheduler.h
+ *
+ *  @brief Paces the frames of the main loop and measures the frame timings.
+ *
+ *  The scheduler limits the number of frames that the CPU may queue ahead of
+ *  the GPU, limits the frame rate to a target frame rate (a high-precision
+ *  sleep followed by a short spin), and measures the CPU frame time, the GPU
+ *  frame time, the time between presents, and the latency between an input
+ *  message and the present of the frame that processed it.
+ *
+ *  The GPU frame time is estimated from the time at which the fence of a frame
+ *  is found to be signaled: it is the time between the completion of the frame
+ *  and the later of the start of the frame and the completion of the previous
+ *  frame. No timestamp queries are needed, but the estimate includes the time
+ *  the GPU waited for the first command list of the frame so it is an upper
+ *  bound of the actual GPU time.
+ *
+ *  In progressive mode, the application is allowed to accumulate several
+ *  passes (for example the samples of a path tracer) in a single frame while
+ *  the view is static. The number of passes is chosen so that the GPU frame
+ *  time stays within the latency budget and only a single frame may be in
+ *  flight so that the UI stays responsive while accumulating.
+ *
+ *  All time measurements are taken from a FrameClock so that the scheduler
+ *  can be driven with a mocked clock.
+ */
+
+#include "HighResolutionTimer.h"
+
+#include <cstdint>     // for uint64_t
+#include <deque>       // for std::deque
+#include <functional>  // for std::function
+#include <memory>      // for std::unique_ptr
+
+/**
+ * The clock that is used by the FrameScheduler.
+ */
+class FrameClock
+{
+public:
+    virtual ~FrameClock() = default;
+
+    /**
+     * The current time (in seconds).
+     */
+    virtual double GetTime() = 0;
+
+    /**
+     * Block the current thread for approximately the specified duration
+     * (in seconds). The thread may wake up a little later.
+     */
+    virtual void Sleep( double seconds ) = 0;
+
+    /**
+     * Called while busy-waiting for the last part of a wait.
+     */
+    virtual void Spin() = 0;
+};
+
+/**
+ * The default clock. Time is measured with the HighResolutionTimer and sleeps
+ * use a high resolution waitable timer (if it is supported by the OS).
+ */
+class HighResolutionFrameClock : public FrameClock
+{
+public:
+    HighResolutionFrameClock();
+    virtual ~HighResolutionFrameClock();
+
+    virtual double GetTime() override;
+    virtual void   Sleep( double seconds ) override;
+    virtual void   Spin() override;
+
+private:
+    HighResolutionTimer m_Timer;
+    // Waitable timer (a HANDLE, nullptr if high resolution waitable timers are not supported).
+    void* m_hWaitableTimer;
+};
+
+/**
+ * A frame time statistic (in seconds).
+ */
+struct FrameTiming
+{
+    double Last    = 0.0;
+    double Average = 0.0;
+    double Min     = 0.0;
+    double Max     = 0.0;
+    // The number of samples since the statistics were reset.
+    uint64_t NumSamples = 0;
+
+    /**
+     * Add a sample. The average is an exponential moving average so that it
+     * follows changes in the workload.
+     */
+    void AddSample( double seconds );
+};
+
+struct FrameStatistics
+{
+    // The number of frames that have been started.
+    uint64_t NumFrames = 0;
+    // The number of frames that have been submitted but not yet completed on the GPU.
+    uint32_t NumFramesInFlight = 0;
+    // The number of progressive passes of the last frame.
+    uint32_t NumProgressivePasses = 1;
+
+    // The time between BeginFrame and EndFrame.
+    FrameTiming CpuFrameTime;
+    // The estimated time the GPU spent on a frame.
+    FrameTiming GpuFrameTime;
+    // The time between two consecutive presents.
+    FrameTiming PresentInterval;
+    // The time between the first input message of a frame and the present of that frame.
+    FrameTiming InputLatency;
+    // The time that BeginFrame waited (for frames in flight and for the target frame rate).
+    FrameTiming WaitTime;
+};
+
+class FrameScheduler
+{
+public:
+    /**
+     * Returns true if the GPU has completed the work up to the fence value.
+     */
+    using IsFenceCompleteFunc = std::function<bool( uint64_t fenceValue )>;
+
+    /**
+     * Blocks until the GPU has completed the work up to the fence value.
+     */
+    using WaitForFenceFunc = std::function<void( uint64_t fenceValue )>;
+
+    /**
+     * @param clock The clock that is used to measure and pace the frames. If
+     * no clock is specified, a HighResolutionFrameClock is used.
+     */
+    explicit FrameScheduler( std::unique_ptr<FrameClock> clock = nullptr );
+    ~FrameScheduler();
+
+    /**
+     * Set the fence functions of the command queue that presents the frames.
+     * Frames in flight are only tracked when the fence functions are set and
+     * the fence value of each frame is passed to Present.
+     */
+    void SetFrameFence( IsFenceCompleteFunc isFenceComplete, WaitForFenceFunc waitForFence );
+
+    /**
+     * The maximum number of frames that may be submitted but not yet completed
+     * on the GPU when a new frame is started (at least 1).
+     */
+    void     SetMaxFramesInFlight( uint32_t maxFramesInFlight );
+    uint32_t GetMaxFramesInFlight() const
+    {
+        return m_MaxFramesInFlight;
+    }
+
+    /**
+     * Limit the frame rate (frames per second). Use 0 to disable the frame
+     * rate limit.
+     */
+    void   SetTargetFrameRate( double framesPerSecond );
+    double GetTargetFrameRate() const
+    {
+        return m_TargetFrameRate;
+    }
+
+    /**
+     * The last part of a wait is spent spinning instead of sleeping to
+     * compensate for the inaccuracy of the OS scheduler (in seconds).
+     */
+    void   SetSpinThreshold( double seconds );
+    double GetSpinThreshold() const
+    {
+        return m_SpinThreshold;
+    }
+
+    /**
+     * Enable or disable progressive mode.
+     */
+    void SetProgressive( bool progressive );
+    bool IsProgressive() const
+    {
+        return m_Progressive;
+    }
+
+    /**
+     * Set whether the application is accumulating progressive passes (for
+     * example, the camera of a path tracer is static). This should be set
+     * every frame before GetNumProgressivePasses is queried.
+     */
+    void SetAccumulating( bool accumulating );
+    bool IsAccumulating() const
+    {
+        return m_Accumulating;
+    }
+
+    /**
+     * The GPU time (in seconds) that a frame may take while accumulating
+     * progressive passes. This bounds the latency of the UI while the view is
+     * static.
+     */
+    void   SetLatencyBudget( double seconds );
+    double GetLatencyBudget() const
+    {
+        return m_LatencyBudget;
+    }
+
+    /**
+     * The maximum number of progressive passes in a single frame.
+     */
+    void     SetMaxProgressivePasses( uint32_t maxPasses );
+    uint32_t GetMaxProgressivePasses() const
+    {
+        return m_MaxProgressivePasses;
+    }
+
+    /**
+     * Get the number of progressive passes that should be rendered in the
+     * current frame. Returns 1 unless progressive mode is enabled and the
+     * application is accumulating.
+     */
+    uint32_t GetNumProgressivePasses();
+
+    /**
+     * Notify the scheduler that an input message was received. The input
+     * latency is measured from the first input message that was received
+     * before the frame started.
+     */
+    void NotifyInput();
+
+    /**
+     * Start a new frame. This blocks until the number of frames in flight is
+     * below the maximum and the target frame time has elapsed.
+     *
+     * A frame can't be started while another frame is in progress (for
+     * example, when a modal loop dispatches WM_PAINT during a frame). In that
+     * case, BeginFrame returns false immediately and EndFrame must not be
+     * called for the nested frame.
+     *
+     * @returns true if the frame was started.
+     */
+    bool BeginFrame();
+
+    /**
+     * Notify the scheduler that the current frame was presented.
+     *
+     * @param fenceValue The fence value that is signaled by the command queue
+     * after the frame (or 0 if the frame is not tracked).
+     */
+    void Present( uint64_t fenceValue = 0 );
+
+    /**
+     * End the current frame (only if BeginFrame returned true).
+     */
+    void EndFrame();
+
+    /**
+     * Wait for all frames in flight to complete.
+     */
+    void WaitForFramesInFlight();
+
+    const FrameStatistics& GetStatistics() const
+    {
+        return m_Statistics;
+    }
+
+    void ResetStatistics();
+
+private:
+    // A frame that was submitted but not yet completed on the GPU.
+    struct FrameInFlight
+    {
+        uint64_t FenceValue;
+        // The time the frame was started.
+        double BeginTime;
+        // The number of progressive passes of the frame.
+        uint32_t NumPasses;
+    };
+
+    // Record the completion of the oldest frame in flight.
+    void CompleteFrame( double completeTime );
+    // Poll the fence for completed frames.
+    void UpdateFramesInFlight();
+    // Wait until the specified time (sleep, then spin).
+    void WaitUntil( double time );
+
+    std::unique_ptr<FrameClock> m_Clock;
+
+    IsFenceCompleteFunc m_IsFenceComplete;
+    WaitForFenceFunc    m_WaitForFence;
+
+    uint32_t m_MaxFramesInFlight;
+    double   m_TargetFrameRate;
+    double   m_SpinThreshold;
+
+    bool     m_Progressive;
+    bool     m_Accumulating;
+    double   m_LatencyBudget;
+    uint32_t m_MaxProgressivePasses;
+    // The number of progressive passes of the current frame.
+    uint32_t m_NumPasses;
+
+    std::deque<FrameInFlight> m_FramesInFlight;
+    // The time the last frame completed on the GPU.
+    double m_LastCompleteTime;
+    // The estimated GPU time of a single progressive pass.
+    double m_GpuTimePerPass;
+
+    // The time the next frame may start (if the frame rate is limited).
+    double m_NextFrameTime;
+    double m_FrameBeginTime;
+    double m_LastPresentTime;
+    bool   m_InFrame;
+
+    // The time of the first input message that was not yet processed by a
+    // frame (negative if there is no pending input).
+    double m_PendingInputTime;
+    // The time of the first input message that is processed by the current frame.
+    double m_FrameInputTime;
+
+    FrameStatistics m_Statistics;
+};
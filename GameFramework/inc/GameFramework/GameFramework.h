@@ -31,7 +31,9 @@
  */
 
 #include "Events.h"
-#include "ReadDirectoryChanges.h"
+#include "FileWatcher.h"
+#include "FrameScheduler.h"
+#include "LogBackend.h"
 
 #include <gainput/gainput.h>
 #include <spdlog/logger.h>
@@ -48,9 +50,7 @@
 #include <cstdint>      // for uint32_t
 #include <limits>       // for std::numeric_limits
 #include <memory>       // for std::shared_ptr
-#include <mutex>        // for std::mutex
 #include <string>       // for std::wstring
-#include <thread>       // for std::thread
 #include <type_traits>  // for std::enable_if
 
 class Window;
@@ -60,7 +60,7 @@ using Logger = std::shared_ptr<spdlog::logger>;
 /**
  * Windows message handler.
  */
-using WndProcEvent = Delegate<LRESULT(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)>;
+using WndProcEvent = FastDelegate<LRESULT( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam )>;
 
 
 class GameFramework
@@ -91,6 +91,14 @@ public:
      */
     Logger CreateLogger( const std::string& name );
 
+    /**
+     * Create a named log channel or get a previously created channel with the
+     * same name. Log calls on a channel don't block and the messages are
+     * formatted on a background thread (see LogBackend.h), so channels should
+     * be used for messages that are logged at a high rate or in bursts.
+     */
+    LogChannel& CreateLogChannel( const std::string& name );
+
     /**
      * Get the keyboard device ID.
      */
@@ -157,10 +165,19 @@ public:
      */
     void Stop();
 
+    /**
+     * Get the frame scheduler that paces the updates of the windows.
+     */
+    FrameScheduler& GetFrameScheduler()
+    {
+        return m_FrameScheduler;
+    }
+
     /**
      * To support hot-loading of modified files, you can register a directory
      * path for listening for file change notifications. File change
-     * notifications are set through the Application::FileChange event.
+     * notifications are set through the Application::FilesChanged and
+     * Application::FileChanged events.
      *
      * @param dir The directory to listen for file changes.
      * @param recursive Whether to listen for file changes in sub-folders.
@@ -194,7 +211,14 @@ public:
     WndProcEvent WndProcHandler;
 
     /**
-     * Invoked when a file is modified on disk.
+     * Invoked with a batch of files that were modified on disk. The changes
+     * are coalesced so that each path appears at most once in a batch. This
+     * event is invoked on the file watcher thread.
+     */
+    FileChangesEvent FilesChanged;
+
+    /**
+     * Invoked for each file in a batch after FilesChanged.
      */
     FileChangeEvent FileChanged;
 
@@ -209,6 +233,9 @@ protected:
     GameFramework( HINSTANCE hInst );
     virtual ~GameFramework();
 
+    // A batch of file modifications was detected.
+    virtual void OnFilesChanged( FileChangesEventArgs& e );
+
     // A file modification was detected.
     virtual void OnFileChange( FileChangedEventArgs& e );
 
@@ -226,30 +253,28 @@ private:
     GameFramework& operator=( GameFramework& ) = delete;
     GameFramework& operator=( GameFramework&& ) = delete;
 
-    // Directory change listener thread entry point function.
-    void CheckFileChanges();
-
     // Handle to application instance.
     HINSTANCE m_hInstance;
 
     Logger m_Logger;
 
+    // Writes the messages of the log channels (to the same sinks as the loggers).
+    std::unique_ptr<LogBackend> m_LogBackend;
+
     // Gainput input manager.
     gainput::InputManager m_InputManager;
     gainput::DeviceId     m_KeyboardDevice;
     gainput::DeviceId     m_MouseDevice;
     gainput::DeviceId     m_GamepadDevice[gainput::MaxPadCount];
 
+    // Paces the window updates and measures the frame timings.
+    FrameScheduler m_FrameScheduler;
+
     // Set to true while the application is running.
     std::atomic_bool m_bIsRunning;
     // Should the application quit?
     std::atomic_bool m_RequestQuit;
 
-    // Directory change listener.
-    CReadDirectoryChanges m_DirectoryChanges;
-    // Thread to run directory change listener.
-    std::thread m_DirectoryChangeListenerThread;
-    std::mutex  m_DirectoryChangeMutex;
-    // Flag to terminate directory change thread.
-    std::atomic_bool m_bTerminateDirectoryChangeThread;
+    // Watches the registered directories for file changes.
+    FileWatcher m_FileWatcher;
 };
\ No newline at end of file
@@ -0,0 +1,449 @@
+#pragma once
+
+/**
+ *  @file LogBackend.h
+ *
+ *  @brief A logging backend with low-overhead, non-blocking log calls.
+ *
+ *  Every thread that logs gets its own single-producer/single-consumer ring
+ *  buffer, so a log call never takes a lock and never waits for another thread.
+ *  A log call only captures the format string pointer, the arguments (in a
+ *  compact binary form), the level and the time. The message is formatted on
+ *  the background thread of the backend, which merges the records of all
+ *  threads (in time order) and writes them to the spdlog sinks.
+ *
+ *  If the ring buffer of a thread is full, the message is dropped and counted
+ *  instead of blocking the thread. The number of dropped messages is reported
+ *  by the background thread.
+ *
+ *  The format string must outlive the backend (use string literals). Strings
+ *  (const char*, std::string, std::string_view) are copied into the ring
+ *  buffer; all other arguments must be trivially copyable.
+ */
+
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/fmt/fmt.h>
+
+#include <atomic>              // for std::atomic
+#include <condition_variable>  // for std::condition_variable
+#include <cstdint>             // for uint64_t
+#include <cstring>             // for std::memcpy
+#include <map>                 // for std::map
+#include <memory>              // for std::shared_ptr, std::unique_ptr
+#include <mutex>               // for std::mutex
+#include <string>              // for std::string
+#include <string_view>         // for std::string_view
+#include <thread>              // for std::thread
+#include <tuple>               // for std::tuple, std::apply
+#include <type_traits>         // for std::decay_t, std::is_trivially_copyable
+#include <vector>              // for std::vector
+
+class LogBackend;
+
+namespace detail
+{
+// Encodes a log argument into the ring buffer and decodes it on the
+// background thread. Arguments are copied by value.
+template<typename T, typename = void>
+struct LogArg
+{
+    static_assert( std::is_trivially_copyable<T>::value,
+                   "Log arguments must be strings or trivially copyable. Format other types on the caller." );
+
+    using Decoded = T;
+
+    static size_t Size( const T& )
+    {
+        return sizeof( T );
+    }
+
+    static char* Encode( char* p, const T& value )
+    {
+        std::memcpy( p, &value, sizeof( T ) );
+        return p + sizeof( T );
+    }
+
+    static T Decode( const char*& p )
+    {
+        T value;
+        std::memcpy( &value, p, sizeof( T ) );
+        p += sizeof( T );
+        return value;
+    }
+};
+
+// Strings are copied into the ring buffer (length followed by the characters).
+struct LogStringArg
+{
+    using Decoded = fmt::string_view;
+
+    static size_t Size( std::string_view value )
+    {
+        return sizeof( uint32_t ) + value.size();
+    }
+
+    static char* Encode( char* p, std::string_view value )
+    {
+        uint32_t length = static_cast<uint32_t>( value.size() );
+        std::memcpy( p, &length, sizeof( length ) );
+        std::memcpy( p + sizeof( length ), value.data(), length );
+        return p + sizeof( length ) + length;
+    }
+
+    static fmt::string_view Decode( const char*& p )
+    {
+        uint32_t length;
+        std::memcpy( &length, p, sizeof( length ) );
+        fmt::string_view value( p + sizeof( length ), length );
+        p += sizeof( length ) + length;
+        return value;
+    }
+};
+
+template<>
+struct LogArg<const char*> : LogStringArg
+{};
+template<>
+struct LogArg<char*> : LogStringArg
+{};
+template<>
+struct LogArg<std::string> : LogStringArg
+{};
+template<>
+struct LogArg<std::string_view> : LogStringArg
+{};
+
+// Format the arguments of a record.
+using LogFormatFunc = void ( * )( const char* format, const char* data, fmt::memory_buffer& message );
+
+template<typename... Args>
+void FormatLogRecord( const char* format, const char* data, fmt::memory_buffer& message )
+{
+    // The elements of a braced initializer list are evaluated in order, so the
+    // arguments are decoded in the order they were encoded.
+    std::tuple<typename LogArg<Args>::Decoded...> args { LogArg<Args>::Decode( data )... };
+    ( void )data;
+
+    std::apply( [&]( const auto&... a ) { fmt::format_to( message, format, a... ); }, args );
+}
+
+// The header of a record in the ring buffer. The encoded arguments follow the
+// header.
+struct LogRecord
+{
+    // The size of the record (including the header) in bytes.
+    uint32_t Size;
+    // The log level (spdlog::level::level_enum).
+    uint32_t Level;
+    // nullptr for padding at the end of the ring buffer.
+    LogFormatFunc Format;
+    const char*   FormatString;
+    // The name of the channel (owned by the backend).
+    const std::string* Name;
+    // spdlog::log_clock ticks.
+    int64_t Time;
+};
+
+// A single-producer/single-consumer ring buffer of log records.
+class LogRingBuffer
+{
+public:
+    LogRingBuffer( size_t capacity, size_t threadId );
+
+    // Reserve space for a record of the specified size (multiple of 8 bytes).
+    // Returns nullptr (and counts the message as dropped) if the buffer is full.
+    char* Reserve( size_t size )
+    {
+        uint64_t writePos   = m_WritePos.load( std::memory_order_relaxed );
+        size_t   offset     = static_cast<size_t>( writePos & m_Mask );
+        size_t   contiguous = m_Capacity - offset;
+
+        // Records are not split at the end of the buffer.
+        size_t padding = size <= contiguous ? 0 : contiguous;
+
+        if ( writePos + padding + size - m_CachedReadPos > m_Capacity )
+        {
+            m_CachedReadPos = m_ReadPos.load( std::memory_order_acquire );
+            if ( writePos + padding + size - m_CachedReadPos > m_Capacity )
+            {
+                m_NumDropped.store( m_NumDropped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+                return nullptr;
+            }
+        }
+
+        if ( padding >= sizeof( LogRecord ) )
+        {
+            LogRecord* record = reinterpret_cast<LogRecord*>( m_Data.get() + offset );
+            record->Size      = static_cast<uint32_t>( padding );
+            record->Format    = nullptr;
+        }
+
+        m_PendingWritePos = writePos + padding + size;
+        return m_Data.get() + ( ( writePos + padding ) & m_Mask );
+    }
+
+    // Publish the reserved record.
+    void Commit()
+    {
+        m_WritePos.store( m_PendingWritePos, std::memory_order_release );
+    }
+
+    // Called when the producer thread no longer uses the buffer.
+    void SetAbandoned()
+    {
+        m_Abandoned = true;
+    }
+
+    bool IsAbandoned() const
+    {
+        return m_Abandoned;
+    }
+
+private:
+    friend class ::LogBackend;
+
+    std::unique_ptr<char[]> m_Data;
+    size_t                  m_Capacity;
+    size_t                  m_Mask;
+    size_t                  m_ThreadId;
+
+    // Written by the producer.
+    alignas( 64 ) std::atomic<uint64_t> m_WritePos;
+    uint64_t              m_PendingWritePos;
+    uint64_t              m_CachedReadPos;
+    std::atomic<uint64_t> m_NumDropped;
+
+    // Written by the consumer.
+    alignas( 64 ) std::atomic<uint64_t> m_ReadPos;
+    uint64_t m_NumDroppedReported;
+
+    // Set when the producer thread exits.
+    std::atomic_bool m_Abandoned;
+};
+}  // namespace detail
+
+/**
+ * A named log channel. The channel has the same log functions as the
+ * spdlog::logger so that call sites can be moved from one to the other.
+ */
+class LogChannel
+{
+public:
+    const std::string& GetName() const
+    {
+        return m_Name;
+    }
+
+    void set_level( spdlog::level::level_enum level )
+    {
+        m_Level.store( level, std::memory_order_relaxed );
+    }
+
+    spdlog::level::level_enum level() const
+    {
+        return m_Level.load( std::memory_order_relaxed );
+    }
+
+    bool should_log( spdlog::level::level_enum level ) const
+    {
+        return level >= m_Level.load( std::memory_order_relaxed );
+    }
+
+    template<typename... Args>
+    void log( spdlog::level::level_enum level, const char* format, const Args&... args );
+
+    template<typename... Args>
+    void trace( const char* format, const Args&... args )
+    {
+        log( spdlog::level::trace, format, args... );
+    }
+
+    template<typename... Args>
+    void debug( const char* format, const Args&... args )
+    {
+        log( spdlog::level::debug, format, args... );
+    }
+
+    template<typename... Args>
+    void info( const char* format, const Args&... args )
+    {
+        log( spdlog::level::info, format, args... );
+    }
+
+    template<typename... Args>
+    void warn( const char* format, const Args&... args )
+    {
+        log( spdlog::level::warn, format, args... );
+    }
+
+    template<typename... Args>
+    void error( const char* format, const Args&... args )
+    {
+        log( spdlog::level::err, format, args... );
+    }
+
+    template<typename... Args>
+    void critical( const char* format, const Args&... args )
+    {
+        log( spdlog::level::critical, format, args... );
+    }
+
+private:
+    friend class LogBackend;
+
+    LogChannel( LogBackend& backend, const std::string& name )
+    : m_Backend( backend )
+    , m_Name( name )
+    , m_Level( spdlog::level::trace )
+    {}
+
+    LogBackend&                            m_Backend;
+    std::string                            m_Name;
+    std::atomic<spdlog::level::level_enum> m_Level;
+};
+
+class LogBackend
+{
+public:
+    /**
+     * @param sinks The sinks the messages are written to (on the background
+     * thread).
+     * @param bufferSize The size of the ring buffer of each thread (in bytes,
+     * rounded up to a power of two). The default holds a burst of about 14,000
+     * messages of 100 characters (like the log of a scene import) without
+     * dropping messages, even if the background thread doesn't run.
+     */
+    explicit LogBackend( std::vector<spdlog::sink_ptr> sinks, size_t bufferSize = 2 * 1024 * 1024 );
+
+    /**
+     * Writes all pending messages and stops the background thread.
+     */
+    ~LogBackend();
+
+    /**
+     * Create a named log channel or get a previously created channel with the
+     * same name. Channels live as long as the backend.
+     */
+    LogChannel& CreateChannel( const std::string& name );
+
+    /**
+     * Block until all messages that were logged before this call are written
+     * to the sinks, then flush the sinks.
+     */
+    void Flush();
+
+    /**
+     * The total number of messages that were dropped because a ring buffer
+     * was full.
+     */
+    uint64_t GetNumDropped() const;
+
+    /**
+     * Write a record to the ring buffer of the calling thread.
+     */
+    template<typename... Args>
+    void Write( const LogChannel& channel, spdlog::level::level_enum level, const char* format, const Args&... args )
+    {
+        using namespace detail;
+
+        size_t size = sizeof( LogRecord ) + ( size_t( 0 ) + ... + LogArg<std::decay_t<Args>>::Size( args ) );
+        size        = ( size + 7 ) & ~size_t( 7 );
+
+        LogRingBuffer* buffer = GetThreadBuffer();
+        char*          p      = buffer ? buffer->Reserve( size ) : nullptr;
+        if ( !p )
+        {
+            return;
+        }
+
+        LogRecord* record    = reinterpret_cast<LogRecord*>( p );
+        record->Size         = static_cast<uint32_t>( size );
+        record->Level        = static_cast<uint32_t>( level );
+        record->Format       = &FormatLogRecord<std::decay_t<Args>...>;
+        record->FormatString = format;
+        record->Name         = &channel.GetName();
+        record->Time         = spdlog::log_clock::now().time_since_epoch().count();
+
+        char* data = p + sizeof( LogRecord );
+        ( ( data = LogArg<std::decay_t<Args>>::Encode( data, args ) ), ... );
+
+        buffer->Commit();
+    }
+
+private:
+    // The ring buffer of a thread is cached in a thread-local variable. The
+    // backend id identifies the backend that owns the cached buffer.
+    struct ThreadBufferCache
+    {
+        uint64_t                                BackendId = 0;
+        std::shared_ptr<detail::LogRingBuffer> Buffer;
+
+        ~ThreadBufferCache();
+    };
+
+    detail::LogRingBuffer* GetThreadBuffer()
+    {
+        ThreadBufferCache& cache = s_ThreadBufferCache;
+        if ( cache.BackendId == m_Id )
+        {
+            return cache.Buffer.get();
+        }
+
+        return CreateThreadBuffer();
+    }
+
+    // Create the ring buffer of the calling thread.
+    detail::LogRingBuffer* CreateThreadBuffer();
+
+    // Background thread entry point.
+    void Run();
+
+    // Write the pending records of all ring buffers to the sinks. Returns
+    // true if any records were written.
+    bool ProcessRecords();
+
+    // Write a message to the sinks.
+    void Sink( const spdlog::details::log_msg& msg );
+
+    static thread_local ThreadBufferCache s_ThreadBufferCache;
+
+    uint64_t                       m_Id;
+    size_t                         m_BufferSize;
+    std::vector<spdlog::sink_ptr> m_Sinks;
+
+    std::map<std::string, std::unique_ptr<LogChannel>> m_Channels;
+    std::mutex                                         m_ChannelsMutex;
+
+    std::vector<std::shared_ptr<detail::LogRingBuffer>> m_Buffers;
+    std::mutex                                          m_BuffersMutex;
+
+    // The records of a pass of the background thread (reused).
+    struct PendingRecord
+    {
+        const detail::LogRecord* Record;
+        size_t                   ThreadId;
+    };
+    std::vector<PendingRecord> m_PendingRecords;
+    fmt::memory_buffer         m_Message;
+
+    std::atomic<uint64_t> m_NumDropped;
+
+    // Used to wake up the background thread for a flush or to terminate.
+    std::mutex              m_Mutex;
+    std::condition_variable m_Condition;
+    uint64_t                m_FlushRequested;
+    uint64_t                m_FlushCompleted;
+    bool                    m_bTerminate;
+
+    std::thread m_Thread;
+};
+
+template<typename... Args>
+void LogChannel::log( spdlog::level::level_enum level, const char* format, const Args&... args )
+{
+    if ( should_log( level ) )
+    {
+        m_Backend.Write( *this, level, format, args... );
+    }
+}
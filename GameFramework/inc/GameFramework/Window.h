@@ -127,6 +127,21 @@ public:
      */
     void Hide();
 
+    /**
+     * Merge consecutive mouse motion messages into a single MouseMoved event.
+     * The merged event has the position and button state of the last message
+     * and the relative motion of all messages. It is invoked before the next
+     * Update event, or before the next keyboard, mouse button, or mouse wheel
+     * event so that the order of the input events is preserved.
+     *
+     * Coalescing is disabled by default.
+     */
+    void SetCoalesceMouseMotion( bool coalesce );
+    bool GetCoalesceMouseMotion() const
+    {
+        return m_MouseMotionCoalescer.IsEnabled();
+    }
+
     /**
      * Invoked when the game should be updated.
      */
@@ -283,6 +298,9 @@ protected:
     virtual void OnMouseBlur( EventArgs& e );
 
 private:
+    // Invoke the pending (coalesced) mouse motion event.
+    void FlushMouseMotion();
+
     HWND m_hWnd;
 
     std::wstring m_Name;
@@ -314,4 +332,7 @@ private:
     bool m_bHasKeyboardFocus;
 
     HighResolutionTimer m_Timer;
+
+    // Merges mouse motion messages (if enabled).
+    EventCoalescer<MouseMotionEventArgs> m_MouseMotionCoalescer;
 };
@@ -0,0 +1,417 @@
+#include "GameFrameworkPCH.h"
+
+#include <GameFramework/FileWatcher.h>
+
+#if defined( _WIN32 )
+    #include <GameFramework/ReadDirectoryChanges.h>
+#else
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+using namespace std::chrono;
+
+// Changes are dispatched after this delay even if new changes keep arriving.
+static const milliseconds MaxBatchDelay( 1000 );
+
+#if defined( _WIN32 )
+class FileWatcher::impl
+{
+public:
+    impl()
+    : m_hWakeEvent( ::CreateEvent( NULL, FALSE, FALSE, NULL ) )
+    {}
+
+    ~impl()
+    {
+        m_DirectoryChanges.Terminate();
+        ::CloseHandle( m_hWakeEvent );
+    }
+
+    void AddDirectory( const std::wstring& dir, bool recursive )
+    {
+        // The directory is added on the thread of the directory changes server.
+        m_DirectoryChanges.AddDirectory( dir, recursive, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME );
+    }
+
+    // Block until changes are reported, the timeout expires (-1 for no
+    // timeout), or Wake is called. All reported changes are returned.
+    void WaitForChanges( int timeoutMilliseconds, std::vector<FileChangedEventArgs>& changes )
+    {
+        const HANDLE handles[] = { m_hWakeEvent, m_DirectoryChanges.GetWaitHandle() };
+
+        DWORD timeout    = timeoutMilliseconds < 0 ? INFINITE : static_cast<DWORD>( timeoutMilliseconds );
+        DWORD waitSignal = ::WaitForMultipleObjects( _countof( handles ), handles, FALSE, timeout );
+        if ( waitSignal != WAIT_OBJECT_0 + 1 )
+        {
+            return;
+        }
+
+        if ( m_DirectoryChanges.CheckOverflow() )
+        {
+            // This could happen if a lot of modifications occur at once.
+            spdlog::warn( "Directory change overflow occurred." );
+            return;
+        }
+
+        DWORD        action;
+        std::wstring fileName;
+        while ( m_DirectoryChanges.Pop( action, fileName ) )
+        {
+            FileAction fileAction = FileAction::Unknown;
+            switch ( action )
+            {
+            case FILE_ACTION_ADDED:
+                fileAction = FileAction::Added;
+                break;
+            case FILE_ACTION_REMOVED:
+                fileAction = FileAction::Removed;
+                break;
+            case FILE_ACTION_MODIFIED:
+                fileAction = FileAction::Modified;
+                break;
+            case FILE_ACTION_RENAMED_OLD_NAME:
+                fileAction = FileAction::RenameOld;
+                break;
+            case FILE_ACTION_RENAMED_NEW_NAME:
+                fileAction = FileAction::RenameNew;
+                break;
+            default:
+                break;
+            }
+
+            changes.emplace_back( fileAction, fileName );
+        }
+    }
+
+    void Wake()
+    {
+        ::SetEvent( m_hWakeEvent );
+    }
+
+private:
+    CReadDirectoryChanges m_DirectoryChanges;
+    // Signaled to wake up the watcher thread.
+    HANDLE m_hWakeEvent;
+};
+#else
+class FileWatcher::impl
+{
+public:
+    impl()
+    : m_InotifyFd( ::inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) )
+    , m_WakeFd( ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) )
+    {
+        if ( m_InotifyFd < 0 || m_WakeFd < 0 )
+        {
+            throw std::runtime_error( "Failed to create the file watcher." );
+        }
+    }
+
+    ~impl()
+    {
+        ::close( m_InotifyFd );
+        ::close( m_WakeFd );
+    }
+
+    void AddDirectory( const std::wstring& dir, bool recursive )
+    {
+        scoped_lock lock( m_WatchMutex );
+        AddWatch( fs::path( dir ), recursive );
+    }
+
+    // Block until changes are reported, the timeout expires (-1 for no
+    // timeout), or Wake is called. All reported changes are returned.
+    void WaitForChanges( int timeoutMilliseconds, std::vector<FileChangedEventArgs>& changes )
+    {
+        pollfd fds[] = { { m_WakeFd, POLLIN, 0 }, { m_InotifyFd, POLLIN, 0 } };
+        if ( ::poll( fds, 2, timeoutMilliseconds ) <= 0 )
+        {
+            return;
+        }
+
+        if ( fds[0].revents & POLLIN )
+        {
+            uint64_t value;
+            ::read( m_WakeFd, &value, sizeof( value ) );
+        }
+
+        if ( fds[1].revents & POLLIN )
+        {
+            ReadEvents( changes );
+        }
+    }
+
+    void Wake()
+    {
+        uint64_t value = 1;
+        ::write( m_WakeFd, &value, sizeof( value ) );
+    }
+
+private:
+    struct WatchedDirectory
+    {
+        fs::path Path;
+        bool     Recursive;
+    };
+
+    // Watch a directory (and its sub-directories if recursive is true).
+    // m_WatchMutex must be locked.
+    void AddWatch( const fs::path& dir, bool recursive )
+    {
+        const uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+        int wd = ::inotify_add_watch( m_InotifyFd, dir.c_str(), mask );
+        if ( wd < 0 )
+        {
+            spdlog::warn( "Failed to watch directory: {}", dir.string() );
+            return;
+        }
+
+        m_WatchedDirectories[wd] = { dir, recursive };
+
+        // inotify is not recursive, each sub-directory needs its own watch.
+        if ( recursive )
+        {
+            std::error_code error;
+            for ( auto& entry: fs::directory_iterator( dir, error ) )
+            {
+                if ( entry.is_directory( error ) )
+                {
+                    AddWatch( entry.path(), true );
+                }
+            }
+        }
+    }
+
+    // Read all pending inotify events.
+    void ReadEvents( std::vector<FileChangedEventArgs>& changes )
+    {
+        alignas( inotify_event ) char buffer[16384];
+
+        scoped_lock lock( m_WatchMutex );
+
+        for ( ;; )
+        {
+            ssize_t length = ::read( m_InotifyFd, buffer, sizeof( buffer ) );
+            if ( length <= 0 )
+            {
+                break;
+            }
+
+            for ( char* p = buffer; p < buffer + length; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>( p );
+                p += sizeof( inotify_event ) + event->len;
+
+                if ( event->mask & IN_Q_OVERFLOW )
+                {
+                    // This could happen if a lot of modifications occur at once.
+                    spdlog::warn( "Directory change overflow occurred." );
+                    continue;
+                }
+
+                auto iter = m_WatchedDirectories.find( event->wd );
+                if ( iter == m_WatchedDirectories.end() )
+                {
+                    continue;
+                }
+
+                if ( event->mask & IN_IGNORED )
+                {
+                    // The directory was removed.
+                    m_WatchedDirectories.erase( iter );
+                    continue;
+                }
+
+                fs::path filePath = iter->second.Path / event->name;
+
+                if ( ( event->mask & ( IN_CREATE | IN_MOVED_TO ) ) && ( event->mask & IN_ISDIR ) &&
+                     iter->second.Recursive )
+                {
+                    AddWatch( filePath, true );
+                }
+
+                FileAction fileAction = FileAction::Unknown;
+                if ( event->mask & IN_CREATE )
+                {
+                    fileAction = FileAction::Added;
+                }
+                else if ( event->mask & IN_DELETE )
+                {
+                    fileAction = FileAction::Removed;
+                }
+                else if ( event->mask & IN_CLOSE_WRITE )
+                {
+                    fileAction = FileAction::Modified;
+                }
+                else if ( event->mask & IN_MOVED_FROM )
+                {
+                    fileAction = FileAction::RenameOld;
+                }
+                else if ( event->mask & IN_MOVED_TO )
+                {
+                    fileAction = FileAction::RenameNew;
+                }
+
+                changes.emplace_back( fileAction, filePath.wstring() );
+            }
+        }
+    }
+
+    int m_InotifyFd;
+    // Written to wake up the watcher thread.
+    int m_WakeFd;
+
+    std::map<int, WatchedDirectory> m_WatchedDirectories;
+    std::mutex                      m_WatchMutex;
+};
+#endif
+
+FileWatcher::FileWatcher( Callback callback, milliseconds debounceTime )
+: pImpl( std::make_unique<impl>() )
+, m_Callback( callback )
+, m_DebounceTime( debounceTime )
+, m_bTerminate( false )
+{
+    m_Thread = std::thread( &FileWatcher::Run, this );
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_bTerminate = true;
+    pImpl->Wake();
+
+    if ( m_Thread.joinable() )
+    {
+        m_Thread.join();
+    }
+}
+
+void FileWatcher::AddDirectory( const std::wstring& dir, bool recursive )
+{
+    pImpl->AddDirectory( dir, recursive );
+}
+
+FileAction FileWatcher::MergeActions( FileAction previous, FileAction next )
+{
+    switch ( previous )
+    {
+    case FileAction::Added:
+        // A new file is still new after it was written.
+        if ( next == FileAction::Modified )
+        {
+            return FileAction::Added;
+        }
+        // A temporary file that was removed (or renamed) before it was reported.
+        if ( next == FileAction::Removed || next == FileAction::RenameOld )
+        {
+            return FileAction::Unknown;
+        }
+        break;
+    case FileAction::Removed:
+    case FileAction::RenameOld:
+        // The file was replaced (editors often save by writing a temporary
+        // file and renaming it to the original file).
+        if ( next == FileAction::Added || next == FileAction::RenameNew )
+        {
+            return FileAction::Modified;
+        }
+        break;
+    case FileAction::RenameNew:
+        if ( next == FileAction::Modified )
+        {
+            return FileAction::RenameNew;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return next;
+}
+
+void FileWatcher::Run()
+{
+#if defined( _WIN32 )
+    ::SetThreadDescription( ::GetCurrentThread(), L"File Watcher" );
+#endif
+
+    steady_clock::time_point firstChangeTime;
+    steady_clock::time_point lastChangeTime;
+
+    std::vector<FileChangedEventArgs> changes;
+
+    while ( !m_bTerminate )
+    {
+        // Block until a change is reported. While changes are pending, also
+        // wake up when the batch is due.
+        int timeout = -1;
+        if ( !m_PendingChanges.empty() )
+        {
+            auto dispatchTime = std::min( lastChangeTime + m_DebounceTime, firstChangeTime + MaxBatchDelay );
+            auto remaining    = ceil<milliseconds>( dispatchTime - steady_clock::now() );
+            timeout           = static_cast<int>( std::max<int64_t>( 0, remaining.count() ) );
+        }
+
+        changes.clear();
+        pImpl->WaitForChanges( timeout, changes );
+
+        if ( !changes.empty() )
+        {
+            if ( m_PendingChanges.empty() )
+            {
+                firstChangeTime = steady_clock::now();
+            }
+            lastChangeTime = steady_clock::now();
+
+            for ( auto& change: changes )
+            {
+                AddChange( change );
+            }
+        }
+
+        auto now = steady_clock::now();
+        if ( !m_PendingChanges.empty() &&
+             ( now - lastChangeTime >= m_DebounceTime || now - firstChangeTime >= MaxBatchDelay ) )
+        {
+            FileChangesEventArgs fileChangesEventArgs( std::move( m_PendingChanges ) );
+            m_PendingChanges.clear();
+            m_PendingChangeIndices.clear();
+
+            m_Callback( fileChangesEventArgs );
+        }
+    }
+}
+
+void FileWatcher::AddChange( FileChangedEventArgs& change )
+{
+    auto iter = m_PendingChangeIndices.find( change.Path );
+    if ( iter == m_PendingChangeIndices.end() )
+    {
+        m_PendingChangeIndices[change.Path] = m_PendingChanges.size();
+        m_PendingChanges.push_back( change );
+        return;
+    }
+
+    size_t     index  = iter->second;
+    FileAction action = MergeActions( m_PendingChanges[index].Action, change.Action );
+    if ( action != FileAction::Unknown )
+    {
+        m_PendingChanges[index].Action = action;
+        return;
+    }
+
+    // The changes cancel each other out.
+    m_PendingChanges.erase( m_PendingChanges.begin() + index );
+    m_PendingChangeIndices.erase( iter );
+    for ( auto& pendingChangeIndex: m_PendingChangeIndices )
+    {
+        if ( pendingChangeIndex.second > index )
+        {
+            --pendingChangeIndex.second;
+        }
+    }
+}
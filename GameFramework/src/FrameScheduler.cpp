@@ -0,0 +1,330 @@
+#include "GameFrameworkPCH.h"
+
+#include <GameFramework/FrameScheduler.h>
+
+// Only defined by recent versions of the Windows SDK (Windows 10, version 1803).
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// The weight of a new sample in the average of a frame timing.
+static const double AverageSmoothing = 0.1;
+
+HighResolutionFrameClock::HighResolutionFrameClock()
+{
+    // High resolution waitable timers are not affected by the system timer
+    // resolution (which is 15.6 ms by default). If they are not supported,
+    // ::Sleep is used instead.
+    m_hWaitableTimer =
+        ::CreateWaitableTimerExW( NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+}
+
+HighResolutionFrameClock::~HighResolutionFrameClock()
+{
+    if ( m_hWaitableTimer )
+    {
+        ::CloseHandle( static_cast<HANDLE>( m_hWaitableTimer ) );
+    }
+}
+
+double HighResolutionFrameClock::GetTime()
+{
+    m_Timer.Tick();
+    return m_Timer.TotalSeconds();
+}
+
+void HighResolutionFrameClock::Sleep( double seconds )
+{
+    if ( m_hWaitableTimer )
+    {
+        // A negative due time is relative to the current time (in 100 nanosecond intervals).
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -static_cast<LONGLONG>( seconds * 1e7 );
+
+        HANDLE hWaitableTimer = static_cast<HANDLE>( m_hWaitableTimer );
+        if ( ::SetWaitableTimerEx( hWaitableTimer, &dueTime, 0, NULL, NULL, NULL, 0 ) )
+        {
+            ::WaitForSingleObject( hWaitableTimer, INFINITE );
+            return;
+        }
+    }
+
+    ::Sleep( static_cast<DWORD>( seconds * 1000.0 ) );
+}
+
+void HighResolutionFrameClock::Spin()
+{
+    YieldProcessor();
+}
+
+void FrameTiming::AddSample( double seconds )
+{
+    if ( NumSamples == 0 )
+    {
+        Average = seconds;
+        Min     = seconds;
+        Max     = seconds;
+    }
+    else
+    {
+        Average += ( seconds - Average ) * AverageSmoothing;
+        Min = std::min( Min, seconds );
+        Max = std::max( Max, seconds );
+    }
+
+    Last = seconds;
+    ++NumSamples;
+}
+
+FrameScheduler::FrameScheduler( std::unique_ptr<FrameClock> clock )
+: m_Clock( std::move( clock ) )
+, m_MaxFramesInFlight( 2 )
+, m_TargetFrameRate( 0.0 )
+, m_SpinThreshold( 0.001 )
+, m_Progressive( false )
+, m_Accumulating( false )
+, m_LatencyBudget( 1.0 / 30.0 )
+, m_MaxProgressivePasses( 16 )
+, m_NumPasses( 1 )
+, m_LastCompleteTime( 0.0 )
+, m_GpuTimePerPass( 0.0 )
+, m_NextFrameTime( 0.0 )
+, m_FrameBeginTime( 0.0 )
+, m_LastPresentTime( -1.0 )
+, m_InFrame( false )
+, m_PendingInputTime( -1.0 )
+, m_FrameInputTime( -1.0 )
+{
+    if ( !m_Clock )
+    {
+        m_Clock = std::make_unique<HighResolutionFrameClock>();
+    }
+}
+
+FrameScheduler::~FrameScheduler() {}
+
+void FrameScheduler::SetFrameFence( IsFenceCompleteFunc isFenceComplete, WaitForFenceFunc waitForFence )
+{
+    WaitForFramesInFlight();
+
+    m_IsFenceComplete = isFenceComplete;
+    m_WaitForFence    = waitForFence;
+}
+
+void FrameScheduler::SetMaxFramesInFlight( uint32_t maxFramesInFlight )
+{
+    m_MaxFramesInFlight = std::max( 1u, maxFramesInFlight );
+}
+
+void FrameScheduler::SetTargetFrameRate( double framesPerSecond )
+{
+    m_TargetFrameRate = std::max( 0.0, framesPerSecond );
+    // Start pacing from the next frame.
+    m_NextFrameTime = 0.0;
+}
+
+void FrameScheduler::SetSpinThreshold( double seconds )
+{
+    m_SpinThreshold = std::max( 0.0, seconds );
+}
+
+void FrameScheduler::SetProgressive( bool progressive )
+{
+    m_Progressive = progressive;
+}
+
+void FrameScheduler::SetAccumulating( bool accumulating )
+{
+    m_Accumulating = accumulating;
+}
+
+void FrameScheduler::SetLatencyBudget( double seconds )
+{
+    m_LatencyBudget = std::max( 0.0, seconds );
+}
+
+void FrameScheduler::SetMaxProgressivePasses( uint32_t maxPasses )
+{
+    m_MaxProgressivePasses = std::max( 1u, maxPasses );
+}
+
+uint32_t FrameScheduler::GetNumProgressivePasses()
+{
+    uint32_t numPasses = 1;
+
+    // The first accumulating frames render a single pass until the GPU time
+    // of a pass is known.
+    if ( m_Progressive && m_Accumulating && m_GpuTimePerPass > 0.0 )
+    {
+        double maxPasses = m_LatencyBudget / m_GpuTimePerPass;
+        numPasses        = static_cast<uint32_t>( std::min( maxPasses, static_cast<double>( m_MaxProgressivePasses ) ) );
+        numPasses        = std::max( 1u, numPasses );
+    }
+
+    m_NumPasses                       = numPasses;
+    m_Statistics.NumProgressivePasses = numPasses;
+
+    return numPasses;
+}
+
+void FrameScheduler::NotifyInput()
+{
+    if ( m_PendingInputTime < 0.0 )
+    {
+        m_PendingInputTime = m_Clock->GetTime();
+    }
+}
+
+bool FrameScheduler::BeginFrame()
+{
+    // A nested frame would wait for the frames in flight (and present) in the
+    // middle of the current frame.
+    if ( m_InFrame )
+    {
+        return false;
+    }
+
+    double waitBeginTime = m_Clock->GetTime();
+
+    UpdateFramesInFlight();
+
+    // Only a single frame may be in flight while accumulating progressive
+    // passes, otherwise the input latency would be a multiple of the
+    // (potentially long) GPU frame time.
+    uint32_t maxFramesInFlight = m_Progressive && m_Accumulating ? 1u : m_MaxFramesInFlight;
+    while ( m_FramesInFlight.size() >= maxFramesInFlight )
+    {
+        m_WaitForFence( m_FramesInFlight.front().FenceValue );
+        CompleteFrame( m_Clock->GetTime() );
+    }
+
+    if ( m_TargetFrameRate > 0.0 )
+    {
+        double frameTime = 1.0 / m_TargetFrameRate;
+
+        WaitUntil( m_NextFrameTime );
+
+        // The next frame is scheduled relative to the scheduled time of this
+        // frame (not the actual time) so the frame rate does not drift. If the
+        // frame is late by more than a frame, the schedule is reset instead of
+        // trying to catch up with several frames in a row.
+        double now = m_Clock->GetTime();
+        if ( m_NextFrameTime + frameTime < now )
+        {
+            m_NextFrameTime = now;
+        }
+        m_NextFrameTime += frameTime;
+    }
+
+    m_FrameBeginTime = m_Clock->GetTime();
+    m_Statistics.WaitTime.AddSample( m_FrameBeginTime - waitBeginTime );
+
+    // Input that is received during the frame is processed by the next frame.
+    m_FrameInputTime   = m_PendingInputTime;
+    m_PendingInputTime = -1.0;
+
+    m_NumPasses = 1;
+    m_InFrame   = true;
+    ++m_Statistics.NumFrames;
+
+    return true;
+}
+
+void FrameScheduler::Present( uint64_t fenceValue )
+{
+    double presentTime = m_Clock->GetTime();
+
+    if ( m_LastPresentTime >= 0.0 )
+    {
+        m_Statistics.PresentInterval.AddSample( presentTime - m_LastPresentTime );
+    }
+    m_LastPresentTime = presentTime;
+
+    if ( m_FrameInputTime >= 0.0 )
+    {
+        m_Statistics.InputLatency.AddSample( presentTime - m_FrameInputTime );
+        m_FrameInputTime = -1.0;
+    }
+
+    if ( fenceValue != 0 && m_IsFenceComplete && m_WaitForFence )
+    {
+        m_FramesInFlight.push_back( { fenceValue, m_FrameBeginTime, m_NumPasses } );
+        m_Statistics.NumFramesInFlight = static_cast<uint32_t>( m_FramesInFlight.size() );
+    }
+}
+
+void FrameScheduler::EndFrame()
+{
+    assert( m_InFrame && "FrameScheduler::BeginFrame was not called." );
+
+    m_Statistics.CpuFrameTime.AddSample( m_Clock->GetTime() - m_FrameBeginTime );
+    m_InFrame = false;
+
+    UpdateFramesInFlight();
+}
+
+void FrameScheduler::WaitForFramesInFlight()
+{
+    while ( !m_FramesInFlight.empty() )
+    {
+        m_WaitForFence( m_FramesInFlight.front().FenceValue );
+        CompleteFrame( m_Clock->GetTime() );
+    }
+}
+
+void FrameScheduler::ResetStatistics()
+{
+    m_Statistics.CpuFrameTime    = FrameTiming();
+    m_Statistics.GpuFrameTime    = FrameTiming();
+    m_Statistics.PresentInterval = FrameTiming();
+    m_Statistics.InputLatency    = FrameTiming();
+    m_Statistics.WaitTime        = FrameTiming();
+}
+
+void FrameScheduler::CompleteFrame( double completeTime )
+{
+    FrameInFlight frame = m_FramesInFlight.front();
+    m_FramesInFlight.pop_front();
+
+    // The GPU can't start a frame before the CPU starts it or before the GPU
+    // has completed the previous frame.
+    double gpuBeginTime = std::max( frame.BeginTime, m_LastCompleteTime );
+    double gpuFrameTime = std::max( 0.0, completeTime - gpuBeginTime );
+
+    m_Statistics.GpuFrameTime.AddSample( gpuFrameTime );
+    m_Statistics.NumFramesInFlight = static_cast<uint32_t>( m_FramesInFlight.size() );
+
+    double gpuTimePerPass = gpuFrameTime / frame.NumPasses;
+    if ( m_GpuTimePerPass > 0.0 )
+    {
+        m_GpuTimePerPass += ( gpuTimePerPass - m_GpuTimePerPass ) * AverageSmoothing;
+    }
+    else
+    {
+        m_GpuTimePerPass = gpuTimePerPass;
+    }
+
+    m_LastCompleteTime = completeTime;
+}
+
+void FrameScheduler::UpdateFramesInFlight()
+{
+    while ( !m_FramesInFlight.empty() && m_IsFenceComplete( m_FramesInFlight.front().FenceValue ) )
+    {
+        CompleteFrame( m_Clock->GetTime() );
+    }
+}
+
+void FrameScheduler::WaitUntil( double time )
+{
+    double remaining = time - m_Clock->GetTime();
+    if ( remaining > m_SpinThreshold )
+    {
+        m_Clock->Sleep( remaining - m_SpinThreshold );
+    }
+
+    while ( m_Clock->GetTime() < time )
+    {
+        m_Clock->Spin();
+    }
+}
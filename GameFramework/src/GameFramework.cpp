@@ -9,38 +9,6 @@ constexpr wchar_t     WINDOW_CLASS_NAME[] = L"RenderWindowClass";
 
 static LRESULT CALLBACK WndProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam );
 
-// Set the name of an std::thread.
-// Useful for debugging.
-const DWORD MS_VC_EXCEPTION = 0x406D1388;
-
-// Set the name of a running thread (for debugging)
-#pragma pack( push, 8 )
-typedef struct tagTHREADNAME_INFO
-{
-    DWORD  dwType;      // Must be 0x1000.
-    LPCSTR szName;      // Pointer to name (in user addr space).
-    DWORD  dwThreadID;  // Thread ID (-1=caller thread).
-    DWORD  dwFlags;     // Reserved for future use, must be zero.
-} THREADNAME_INFO;
-#pragma pack( pop )
-
-inline void SetThreadName( std::thread& thread, const char* threadName )
-{
-    THREADNAME_INFO info;
-    info.dwType     = 0x1000;
-    info.szName     = threadName;
-    info.dwThreadID = ::GetThreadId( reinterpret_cast<HANDLE>( thread.native_handle() ) );
-    info.dwFlags    = 0;
-
-    __try
-    {
-        ::RaiseException( MS_VC_EXCEPTION, 0, sizeof( info ) / sizeof( ULONG_PTR ), (ULONG_PTR*)&info );
-    }
-    __except ( EXCEPTION_EXECUTE_HANDLER )
-    {
-    }
-}
-
 constexpr int MAX_CONSOLE_LINES = 500;
 
 using WindowMap       = std::map<HWND, std::weak_ptr<Window>>;
@@ -117,7 +85,7 @@ GameFramework::GameFramework( HINSTANCE hInst )
 : m_hInstance( hInst )
 , m_bIsRunning( false )
 , m_RequestQuit( false )
-, m_bTerminateDirectoryChangeThread( false )
+, m_FileWatcher( [this]( FileChangesEventArgs& e ) { OnFilesChanged( e ); } )
 {
     // Windows 10 Creators update adds Per Monitor V2 DPI awareness context.
     // Using this awareness context allows the client area of the window
@@ -145,6 +113,8 @@ GameFramework::GameFramework( HINSTANCE hInst )
     spdlog::register_logger( m_Logger );
     spdlog::set_default_logger( m_Logger );
 
+    m_LogBackend = std::make_unique<LogBackend>( sinks );
+
     // Init gainput.
     m_KeyboardDevice = m_InputManager.CreateDevice<gainput::InputDeviceKeyboard>();
     m_MouseDevice    = m_InputManager.CreateDevice<gainput::InputDeviceMouse>();
@@ -183,21 +153,10 @@ GameFramework::GameFramework( HINSTANCE hInst )
     {
         MessageBoxA( NULL, "Unable to register the window class.", "Error", MB_OK | MB_ICONERROR );
     }
-
-    // Create a thread to listen for file changes.
-    m_DirectoryChangeListenerThread = std::thread( &GameFramework::CheckFileChanges, this );
-    SetThreadName( m_DirectoryChangeListenerThread, "Check File Changes" );
 }
 
 GameFramework::~GameFramework()
 {
-    // Close the thread listening for file changes.
-    m_bTerminateDirectoryChangeThread = true;
-    if ( m_DirectoryChangeListenerThread.joinable() )
-    {
-        m_DirectoryChangeListenerThread.join();
-    }
-
     gs_WindowMap.clear();
     gs_WindowMapByName.clear();
 }
@@ -243,6 +202,11 @@ Logger GameFramework::CreateLogger( const std::string& name )
     return logger;
 }
 
+LogChannel& GameFramework::CreateLogChannel( const std::string& name )
+{
+    return m_LogBackend->CreateChannel( name );
+}
+
 gainput::DeviceId GameFramework::GetKeyboardId() const
 {
     return m_KeyboardDevice;
@@ -273,6 +237,14 @@ int32_t GameFramework::Run()
     MSG msg = {};
     while ( ::PeekMessage( &msg, NULL, 0, 0, PM_REMOVE ) && msg.message != WM_QUIT )
     {
+        // Input latency is measured from the first input message that is
+        // processed by a frame.
+        if ( ( msg.message >= WM_KEYFIRST && msg.message <= WM_KEYLAST ) ||
+             ( msg.message >= WM_MOUSEFIRST && msg.message <= WM_MOUSELAST ) || msg.message == WM_INPUT )
+        {
+            m_FrameScheduler.NotifyInput();
+        }
+
         ::TranslateMessage( &msg );
         ::DispatchMessage( &msg );
 
@@ -350,66 +322,16 @@ std::shared_ptr<Window> GameFramework::GetWindowByName( const std::wstring& wind
 
 void GameFramework::RegisterDirectoryChangeListener( const std::wstring& dir, bool recursive )
 {
-    scoped_lock lock( m_DirectoryChangeMutex );
-    m_DirectoryChanges.AddDirectory( dir, recursive, FILE_NOTIFY_CHANGE_LAST_WRITE );
+    m_FileWatcher.AddDirectory( dir, recursive );
 }
 
-// This is the directory change listener thread entry point.
-void GameFramework::CheckFileChanges()
+void GameFramework::OnFilesChanged( FileChangesEventArgs& e )
 {
-    while ( !m_bTerminateDirectoryChangeThread )
-    {
-        scoped_lock lock( m_DirectoryChangeMutex );
-
-        DWORD waitSignal = ::WaitForSingleObject( m_DirectoryChanges.GetWaitHandle(), 0 );
-        switch ( waitSignal )
-        {
-        case WAIT_OBJECT_0:
-            // A file has been modified
-            if ( m_DirectoryChanges.CheckOverflow() )
-            {
-                // This could happen if a lot of modifications occur at once.
-                spdlog::warn( "Directory change overflow occurred." );
-            }
-            else
-            {
-                DWORD        action;
-                std::wstring fileName;
-                m_DirectoryChanges.Pop( action, fileName );
-
-                FileAction fileAction = FileAction::Unknown;
-                switch ( action )
-                {
-                case FILE_ACTION_ADDED:
-                    fileAction = FileAction::Added;
-                    break;
-                case FILE_ACTION_REMOVED:
-                    fileAction = FileAction::Removed;
-                    break;
-                case FILE_ACTION_MODIFIED:
-                    fileAction = FileAction::Modified;
-                    break;
-                case FILE_ACTION_RENAMED_OLD_NAME:
-                    fileAction = FileAction::RenameOld;
-                    break;
-                case FILE_ACTION_RENAMED_NEW_NAME:
-                    fileAction = FileAction::RenameNew;
-                    break;
-                default:
-                    break;
-                }
-
-                FileChangedEventArgs fileChangedEventArgs( fileAction, fileName );
-                OnFileChange( fileChangedEventArgs );
-            }
+    FilesChanged( e );
 
-            break;
-        default:
-            break;
-        }
-
-        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
-        // std::this_thread::yield();
+    for ( auto& change: e.Changes )
+    {
+        OnFileChange( change );
     }
 }
 
@@ -539,9 +461,19 @@ static LRESULT CALLBACK WndProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM
         break;
         case WM_PAINT:
         {
-            // Delta and total time will be filled in by the Window.
-            UpdateEventArgs updateEventArgs( 0.0, 0.0 );
-            pWindow->OnUpdate( updateEventArgs );
+            // Wait for the frame scheduler before updating the window. The
+            // frames of all windows are paced by the same scheduler. A
+            // WM_PAINT that is dispatched during an update (for example, by
+            // the modal loop of a dialog) is skipped.
+            auto& frameScheduler = GameFramework::Get().GetFrameScheduler();
+            if ( frameScheduler.BeginFrame() )
+            {
+                // Delta and total time will be filled in by the Window.
+                UpdateEventArgs updateEventArgs( 0.0, 0.0 );
+                pWindow->OnUpdate( updateEventArgs );
+
+                frameScheduler.EndFrame();
+            }
         }
         break;
         case WM_SYSKEYDOWN:
@@ -30,6 +30,7 @@
  *  @brief Precompiled header file for the GameFramework.
  */
 
+#if defined( _WIN32 )
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
@@ -41,6 +42,7 @@
 #pragma comment( lib, "Shlwapi.lib" )
 
 #include "..\resource.h"
+#endif
 
 // STL
 #include <algorithm>
@@ -54,6 +56,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <stdexcept>
 #include <thread>
 #include <type_traits>
 
@@ -67,7 +70,9 @@ using scoped_lock = std::lock_guard<std::mutex>;
 
 // spdlog
 #include <spdlog/async.h>
+#if defined( _WIN32 )
 #include <spdlog/sinks/msvc_sink.h>
+#endif
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
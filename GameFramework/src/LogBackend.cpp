@@ -0,0 +1,299 @@
+#include "GameFrameworkPCH.h"
+
+#include <GameFramework/LogBackend.h>
+
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/sink.h>
+
+using namespace detail;
+
+// The background thread checks for new records at this interval.
+static const std::chrono::milliseconds PollInterval( 2 );
+
+// Used to identify the backend of the cached thread buffer.
+static std::atomic<uint64_t> gs_NextBackendId( 1 );
+
+thread_local LogBackend::ThreadBufferCache LogBackend::s_ThreadBufferCache;
+
+LogRingBuffer::LogRingBuffer( size_t capacity, size_t threadId )
+: m_Capacity( capacity )
+, m_Mask( capacity - 1 )
+, m_ThreadId( threadId )
+, m_WritePos( 0 )
+, m_PendingWritePos( 0 )
+, m_CachedReadPos( 0 )
+, m_NumDropped( 0 )
+, m_ReadPos( 0 )
+, m_NumDroppedReported( 0 )
+, m_Abandoned( false )
+{
+    assert( ( capacity & m_Mask ) == 0 && "The capacity of the ring buffer must be a power of two." );
+
+    m_Data = std::make_unique<char[]>( capacity );
+}
+
+LogBackend::ThreadBufferCache::~ThreadBufferCache()
+{
+    if ( Buffer )
+    {
+        Buffer->SetAbandoned();
+    }
+}
+
+LogBackend::LogBackend( std::vector<spdlog::sink_ptr> sinks, size_t bufferSize )
+: m_Id( gs_NextBackendId++ )
+, m_BufferSize( 1024 )
+, m_Sinks( std::move( sinks ) )
+, m_NumDropped( 0 )
+, m_FlushRequested( 0 )
+, m_FlushCompleted( 0 )
+, m_bTerminate( false )
+{
+    // Round up to a power of two so the position in the ring buffer is a mask.
+    while ( m_BufferSize < bufferSize )
+    {
+        m_BufferSize *= 2;
+    }
+
+    m_Thread = std::thread( &LogBackend::Run, this );
+}
+
+LogBackend::~LogBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_bTerminate = true;
+    }
+    m_Condition.notify_all();
+
+    if ( m_Thread.joinable() )
+    {
+        m_Thread.join();
+    }
+}
+
+LogChannel& LogBackend::CreateChannel( const std::string& name )
+{
+    std::lock_guard<std::mutex> lock( m_ChannelsMutex );
+
+    auto& channel = m_Channels[name];
+    if ( !channel )
+    {
+        channel = std::unique_ptr<LogChannel>( new LogChannel( *this, name ) );
+    }
+
+    return *channel;
+}
+
+void LogBackend::Flush()
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+
+    uint64_t flushTicket = ++m_FlushRequested;
+    m_Condition.notify_all();
+    m_Condition.wait( lock, [&]() { return m_FlushCompleted >= flushTicket; } );
+}
+
+uint64_t LogBackend::GetNumDropped() const
+{
+    return m_NumDropped.load();
+}
+
+LogRingBuffer* LogBackend::CreateThreadBuffer()
+{
+    auto buffer = std::make_shared<LogRingBuffer>( m_BufferSize, spdlog::details::os::thread_id() );
+
+    {
+        std::lock_guard<std::mutex> lock( m_BuffersMutex );
+        m_Buffers.push_back( buffer );
+    }
+
+    // The buffer of another backend that was cached by this thread is no
+    // longer used.
+    ThreadBufferCache& cache = s_ThreadBufferCache;
+    if ( cache.Buffer )
+    {
+        cache.Buffer->SetAbandoned();
+    }
+
+    cache.BackendId = m_Id;
+    cache.Buffer    = buffer;
+
+    return buffer.get();
+}
+
+void LogBackend::Run()
+{
+#if defined( _WIN32 )
+    ::SetThreadDescription( ::GetCurrentThread(), L"Log Backend" );
+#endif
+
+    for ( ;; )
+    {
+        uint64_t flushRequested;
+        bool     terminate;
+        {
+            std::unique_lock<std::mutex> lock( m_Mutex );
+            m_Condition.wait_for( lock, PollInterval,
+                                  [this]() { return m_bTerminate || m_FlushRequested != m_FlushCompleted; } );
+
+            flushRequested = m_FlushRequested;
+            terminate      = m_bTerminate;
+        }
+
+        ProcessRecords();
+
+        if ( terminate )
+        {
+            // Records that were written while processing.
+            ProcessRecords();
+        }
+
+        if ( terminate || flushRequested != m_FlushCompleted )
+        {
+            for ( auto& sink: m_Sinks )
+            {
+                sink->flush();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock( m_Mutex );
+                m_FlushCompleted = flushRequested;
+            }
+            m_Condition.notify_all();
+        }
+
+        if ( terminate )
+        {
+            break;
+        }
+    }
+}
+
+bool LogBackend::ProcessRecords()
+{
+    std::vector<std::shared_ptr<LogRingBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock( m_BuffersMutex );
+        buffers = m_Buffers;
+    }
+
+    // Collect the records of all threads. The end positions are only released
+    // to the producers after the records are written.
+    std::vector<uint64_t> readPositions( buffers.size() );
+
+    m_PendingRecords.clear();
+    for ( size_t i = 0; i < buffers.size(); ++i )
+    {
+        auto&    buffer   = *buffers[i];
+        uint64_t readPos  = buffer.m_ReadPos.load( std::memory_order_relaxed );
+        uint64_t writePos = buffer.m_WritePos.load( std::memory_order_acquire );
+
+        while ( readPos < writePos )
+        {
+            size_t offset     = static_cast<size_t>( readPos & buffer.m_Mask );
+            size_t contiguous = buffer.m_Capacity - offset;
+
+            // The producer skips the end of the buffer if the header of a
+            // padding record doesn't fit.
+            if ( contiguous < sizeof( LogRecord ) )
+            {
+                readPos += contiguous;
+                continue;
+            }
+
+            const LogRecord* record = reinterpret_cast<const LogRecord*>( buffer.m_Data.get() + offset );
+            if ( record->Format )
+            {
+                m_PendingRecords.push_back( { record, buffer.m_ThreadId } );
+            }
+
+            readPos += record->Size;
+        }
+
+        readPositions[i] = readPos;
+    }
+
+    // Merge the records of all threads in time order.
+    std::stable_sort( m_PendingRecords.begin(), m_PendingRecords.end(),
+                      []( const PendingRecord& a, const PendingRecord& b ) { return a.Record->Time < b.Record->Time; } );
+
+    for ( const auto& pendingRecord: m_PendingRecords )
+    {
+        const LogRecord* record = pendingRecord.Record;
+
+        m_Message.clear();
+        try
+        {
+            record->Format( record->FormatString, reinterpret_cast<const char*>( record + 1 ), m_Message );
+        }
+        catch ( const fmt::format_error& e )
+        {
+            m_Message.clear();
+            fmt::format_to( m_Message, "Failed to format log message \"{}\": {}", record->FormatString, e.what() );
+        }
+
+        spdlog::log_clock::time_point time( spdlog::log_clock::duration( record->Time ) );
+        spdlog::details::log_msg      msg( time, spdlog::source_loc {}, *record->Name,
+                                           static_cast<spdlog::level::level_enum>( record->Level ),
+                                           spdlog::string_view_t( m_Message.data(), m_Message.size() ) );
+        msg.thread_id = pendingRecord.ThreadId;
+
+        Sink( msg );
+    }
+
+    for ( size_t i = 0; i < buffers.size(); ++i )
+    {
+        auto& buffer = *buffers[i];
+        buffer.m_ReadPos.store( readPositions[i], std::memory_order_release );
+
+        uint64_t numDropped = buffer.m_NumDropped.load( std::memory_order_relaxed );
+        if ( numDropped != buffer.m_NumDroppedReported )
+        {
+            m_NumDropped += numDropped - buffer.m_NumDroppedReported;
+
+            m_Message.clear();
+            fmt::format_to( m_Message, "{} log messages were dropped (the log buffer of the thread is full).",
+                            numDropped - buffer.m_NumDroppedReported );
+
+            spdlog::details::log_msg msg( "LogBackend", spdlog::level::warn,
+                                          spdlog::string_view_t( m_Message.data(), m_Message.size() ) );
+            msg.thread_id = buffer.m_ThreadId;
+
+            Sink( msg );
+
+            buffer.m_NumDroppedReported = numDropped;
+        }
+    }
+
+    // Remove the buffers of threads that exited once they are empty.
+    {
+        std::lock_guard<std::mutex> lock( m_BuffersMutex );
+        m_Buffers.erase( std::remove_if( m_Buffers.begin(), m_Buffers.end(),
+                                         []( const std::shared_ptr<LogRingBuffer>& buffer ) {
+                                             return buffer->IsAbandoned() &&
+                                                    buffer->m_ReadPos.load() == buffer->m_WritePos.load();
+                                         } ),
+                         m_Buffers.end() );
+    }
+
+    return !m_PendingRecords.empty();
+}
+
+void LogBackend::Sink( const spdlog::details::log_msg& msg )
+{
+    for ( auto& sink: m_Sinks )
+    {
+        if ( sink->should_log( msg.level ) )
+        {
+            try
+            {
+                sink->log( msg );
+            }
+            catch ( const std::exception& e )
+            {
+                std::fprintf( stderr, "Failed to write log message: %s\n", e.what() );
+            }
+        }
+    }
+}
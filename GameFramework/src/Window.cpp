@@ -2,6 +2,17 @@
 
 #include <GameFramework/Window.h>
 
+// Merge a mouse motion event into the pending (coalesced) mouse motion event.
+static void MergeMouseMotion( MouseMotionEventArgs& pending, const MouseMotionEventArgs& next )
+{
+    int relX = pending.RelX + next.RelX;
+    int relY = pending.RelY + next.RelY;
+
+    pending      = next;
+    pending.RelX = relX;
+    pending.RelY = relY;
+}
+
 Window::Window( HWND hWnd, const std::wstring& windowName, int clientWidth, int clientHeight )
 : m_hWnd( hWnd )
 , m_Name( windowName )
@@ -15,6 +26,7 @@ Window::Window( HWND hWnd, const std::wstring& windowName, int clientWidth, int
 , m_IsMaximized( false )
 , m_bInClientRect( false )
 , m_bHasKeyboardFocus( false )
+, m_MouseMotionCoalescer( &MergeMouseMotion )
 {
     m_DPIScaling = ::GetDpiForWindow( hWnd ) / 96.0f;
 }
@@ -44,6 +56,21 @@ void Window::Hide()
     ::ShowWindow( m_hWnd, SW_HIDE );
 }
 
+void Window::SetCoalesceMouseMotion( bool coalesce )
+{
+    if ( !coalesce )
+    {
+        FlushMouseMotion();
+    }
+
+    m_MouseMotionCoalescer.SetEnabled( coalesce );
+}
+
+void Window::FlushMouseMotion()
+{
+    m_MouseMotionCoalescer.Flush( [this]( MouseMotionEventArgs& e ) { MouseMoved( e ); } );
+}
+
 void Window::OnUpdate( UpdateEventArgs& e )
 {
     m_Timer.Tick();
@@ -51,6 +78,8 @@ void Window::OnUpdate( UpdateEventArgs& e )
     e.DeltaTime = m_Timer.ElapsedSeconds();
     e.TotalTime = m_Timer.TotalSeconds();
 
+    FlushMouseMotion();
+
     Update( e );
 }
 
@@ -111,12 +140,14 @@ void Window::OnDPIScaleChanged( DPIScaleEventArgs& e )
 // A keyboard key was pressed
 void Window::OnKeyPressed( KeyEventArgs& e )
 {
+    FlushMouseMotion();
     KeyPressed( e );
 }
 
 // A keyboard key was released
 void Window::OnKeyReleased( KeyEventArgs& e )
 {
+    FlushMouseMotion();
     KeyReleased( e );
 }
 
@@ -152,23 +183,26 @@ void Window::OnMouseMoved( MouseMotionEventArgs& e )
     m_PreviousMouseX = e.X;
     m_PreviousMouseY = e.Y;
 
-    MouseMoved( e );
+    m_MouseMotionCoalescer.Post( e, [this]( MouseMotionEventArgs& args ) { MouseMoved( args ); } );
 }
 
 // A button on the mouse was pressed
 void Window::OnMouseButtonPressed( MouseButtonEventArgs& e )
 {
+    FlushMouseMotion();
     MouseButtonPressed( e );
 }
 
 // A button on the mouse was released
 void Window::OnMouseButtonReleased( MouseButtonEventArgs& e )
 {
+    FlushMouseMotion();
     MouseButtonReleased( e );
 }
 
 void Window::OnMouseWheel( MouseWheelEventArgs& e )
 {
+    FlushMouseMotion();
     MouseWheel( e );
 }
 
@@ -187,6 +221,7 @@ void Window::OnMouseEnter( MouseMotionEventArgs& e )
 
 void Window::OnMouseLeave( EventArgs& e )
 {
+    FlushMouseMotion();
     m_bInClientRect = false;
     MouseLeave( e );
 }
@@ -19,6 +19,9 @@ std::shared_ptr<SwapChain> pSwapChain  = nullptr;
 
 Logger logger;
 
+// Log channel for the messages of the update loop (log calls on a channel don't block).
+LogChannel* updateLog = nullptr;
+
 int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdLine, int nCmdShow )
 {
 #if defined( _DEBUG )
@@ -31,7 +34,8 @@ int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdLi
     auto& gf = GameFramework::Create( hInstance );
     {
         // Create a logger for logging messages.
-        logger = gf.CreateLogger( "ClearScreen" );
+        logger    = gf.CreateLogger( "ClearScreen" );
+        updateLog = &gf.CreateLogChannel( "ClearScreen" );
 
         // Create a GPU device using the default adapter selection.
         pDevice = Device::Create();
@@ -83,7 +87,7 @@ void OnUpdate( UpdateEventArgs& e )
         frameCount = 0;
         totalTime  = 0.0;
 
-        logger->info( "FPS: {:.7}", fps );
+        updateLog->info( "FPS: {:.7}", fps );
 
         wchar_t buffer[256];
         ::swprintf_s( buffer, L"Clear Screen [FPS: %f]", fps );
@@ -42,6 +42,9 @@ std::shared_ptr<PipelineStateObject> pPipelineStateObject = nullptr;
 
 Logger logger;
 
+// Log channel for the messages of the update loop (log calls on a channel don't block).
+LogChannel* updateLog = nullptr;
+
 // Vertex data for a colored cube.
 struct VertexPosColor
 {
@@ -85,7 +88,8 @@ int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdLi
     auto& gf = GameFramework::Create( hInstance );
     {
         // Create a logger for logging messages.
-        logger = gf.CreateLogger( "Cube" );
+        logger    = gf.CreateLogger( "Cube" );
+        updateLog = &gf.CreateLogChannel( "Cube" );
 
         // Create a GPU device using the default adapter selection.
         pDevice = Device::Create();
@@ -217,7 +221,7 @@ void OnUpdate( UpdateEventArgs& e )
         frameCount = 0;
         totalTime -= 1.0;
 
-        logger->info( "FPS: {:.7}", fps );
+        updateLog->info( "FPS: {:.7}", fps );
 
         wchar_t buffer[256];
         ::swprintf_s( buffer, L"Cube [FPS: %f]", fps );
@@ -181,4 +181,7 @@ private:
 
     // Logger for logging messages
     Logger m_Logger;
+
+    // Log channel for the messages of the update loop (log calls on a channel don't block).
+    LogChannel* m_UpdateLog;
 };
\ No newline at end of file
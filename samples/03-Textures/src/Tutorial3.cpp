@@ -101,8 +101,9 @@ Tutorial3::Tutorial3( const std::wstring& name, uint32_t width, uint32_t height,
 , m_Height( height )
 , m_VSync( vSync )
 {
-    m_Logger = GameFramework::Get().CreateLogger( "Textures" );
-    m_Window = GameFramework::Get().CreateWindow( name, width, height );
+    m_Logger    = GameFramework::Get().CreateLogger( "Textures" );
+    m_UpdateLog = &GameFramework::Get().CreateLogChannel( "Textures" );
+    m_Window    = GameFramework::Get().CreateWindow( name, width, height );
 
     m_Window->Update += UpdateEvent::slot( &Tutorial3::OnUpdate, this );
     m_Window->KeyPressed += KeyboardEvent::slot( &Tutorial3::OnKeyPressed, this );
@@ -339,7 +340,7 @@ void Tutorial3::OnUpdate( UpdateEventArgs& e )
     {
         double fps = frameCount / totalTime;
 
-        m_Logger->info( "FPS: {:.7}", fps );
+        m_UpdateLog->info( "FPS: {:.7}", fps );
 
         wchar_t buffer[256];
         ::swprintf_s( buffer, L"Textures [FPS: %f]", fps );
@@ -35,6 +35,7 @@
 
 #include <GameFramework/GameFramework.h>
 
+#include <dx12lib/LightClusterBuilder.h>
 #include <dx12lib/RenderTarget.h>
 
 #include <DirectXMath.h>
@@ -199,5 +200,11 @@ private:
     std::vector<PointLight> m_PointLights;
     std::vector<SpotLight>  m_SpotLights;
 
+    // Assigns the point and spot lights to the clusters of the view frustum.
+    dx12lib::LightClusterBuilder m_LightClusterBuilder;
+
     Logger m_Logger;
+
+    // Log channel for the messages of the update loop (log calls on a channel don't block).
+    LogChannel* m_UpdateLog;
 };
\ No newline at end of file
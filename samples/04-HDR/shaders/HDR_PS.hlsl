@@ -80,6 +80,29 @@ struct LightProperties
     uint NumSpotLights;
 };
 
+struct LightClusterConstants
+{
+    float4 ProjectionScale; // ( _11, _22, _31, _32 ) of the projection matrix.
+    //----------------------------------- (16 byte boundary)
+    uint   NumClustersX;
+    uint   NumClustersY;
+    uint   NumClustersZ;
+    float  DepthSliceScale;
+    //----------------------------------- (16 byte boundary)
+    float  DepthSliceBias;
+    float  NearZ;
+    float  FarZ;
+    uint   Padding;
+    //----------------------------------- (16 byte boundary)
+    // Total:                              16 * 3 = 48 bytes
+};
+
+struct LightCluster
+{
+    uint Offset;  // Offset of the first light in the LightIndices buffer.
+    uint Counts;  // Number of point lights (low 16 bits) and spot lights (high 16 bits).
+};
+
 struct LightResult
 {
     float4 Diffuse;
@@ -88,10 +111,13 @@ struct LightResult
 
 ConstantBuffer<Material> MaterialCB : register( b0, space1 );
 ConstantBuffer<LightProperties> LightPropertiesCB : register( b1 );
+ConstantBuffer<LightClusterConstants> LightClustersCB : register( b2 );
 
 StructuredBuffer<PointLight> PointLights : register( t0 );
 StructuredBuffer<SpotLight> SpotLights : register( t1 );
 Texture2D DiffuseTexture            : register( t2 );
+StructuredBuffer<LightCluster> LightClusters : register( t3 );
+StructuredBuffer<uint> LightIndices : register( t4 );
 
 SamplerState LinearRepeatSampler    : register(s0);
 
@@ -162,6 +188,23 @@ LightResult DoSpotLight( SpotLight light, float3 V, float3 P, float3 N )
     return result;
 }
 
+// Get the light cluster that contains a view space position.
+// This must match LightClusterBuilder::GetClusterIndex.
+uint GetClusterIndex( float3 P )
+{
+    LightClusterConstants cb = LightClustersCB;
+
+    float z = max( P.z, cb.NearZ );
+    float2 ndc = ( P.xy * cb.ProjectionScale.xy + z * cb.ProjectionScale.zw ) / z;
+
+    uint3 numClusters = uint3( cb.NumClustersX, cb.NumClustersY, cb.NumClustersZ );
+    float3 cluster = float3( ( ndc * 0.5f + 0.5f ) * float2( numClusters.xy ),
+                             log( z ) * cb.DepthSliceScale + cb.DepthSliceBias );
+    uint3 c = (uint3)clamp( floor( cluster ), 0, float3( numClusters - 1 ) );
+
+    return ( c.z * numClusters.y + c.y ) * numClusters.x + c.x;
+}
+
 LightResult DoLighting( float3 P, float3 N )
 {
     uint i;
@@ -171,17 +214,22 @@ LightResult DoLighting( float3 P, float3 N )
 
     LightResult totalResult = (LightResult)0;
 
-    for ( i = 0; i < LightPropertiesCB.NumPointLights; ++i )
+    // Only evaluate the lights that affect the cluster of the pixel.
+    LightCluster cluster = LightClusters[GetClusterIndex( P )];
+    uint numPointLights = cluster.Counts & 0xffff;
+    uint numSpotLights = cluster.Counts >> 16;
+
+    for ( i = 0; i < numPointLights; ++i )
     {
-        LightResult result = DoPointLight( PointLights[i], V, P, N );
+        LightResult result = DoPointLight( PointLights[LightIndices[cluster.Offset + i]], V, P, N );
 
         totalResult.Diffuse += result.Diffuse;
         totalResult.Specular += result.Specular;
     }
 
-    for ( i = 0; i < LightPropertiesCB.NumSpotLights; ++i )
+    for ( i = 0; i < numSpotLights; ++i )
     {
-        LightResult result = DoSpotLight( SpotLights[i], V, P, N );
+        LightResult result = DoSpotLight( SpotLights[LightIndices[cluster.Offset + numPointLights + i]], V, P, N );
 
         totalResult.Diffuse += result.Diffuse;
         totalResult.Specular += result.Specular;
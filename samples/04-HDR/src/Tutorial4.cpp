@@ -106,6 +106,9 @@ enum RootParameters
     PointLights,        // StructuredBuffer<PointLight> PointLights : register( t0 );
     SpotLights,         // StructuredBuffer<SpotLight> SpotLights : register( t1 );
     Textures,           // Texture2D DiffuseTexture : register( t2 );
+    LightClustersCB,    // ConstantBuffer<LightClusterConstants> LightClustersCB : register( b2 );
+    LightClusters,      // StructuredBuffer<LightCluster> LightClusters : register( t3 );
+    LightIndices,       // StructuredBuffer<uint> LightIndices : register( t4 );
     NumRootParameters
 };
 
@@ -147,8 +150,9 @@ Tutorial4::Tutorial4( const std::wstring& name, int width, int height, bool vSyn
 , m_Fullscreen( false )
 , m_RenderScale( 1.0f )
 {
-    m_Logger = GameFramework::Get().CreateLogger( "HDR" );
-    m_Window = GameFramework::Get().CreateWindow( name, width, height );
+    m_Logger    = GameFramework::Get().CreateLogger( "HDR" );
+    m_UpdateLog = &GameFramework::Get().CreateLogChannel( "HDR" );
+    m_Window    = GameFramework::Get().CreateWindow( name, width, height );
 
     m_Window->Update += UpdateEvent::slot( &Tutorial4::OnUpdate, this );
     m_Window->KeyPressed += KeyboardEvent::slot( &Tutorial4::OnKeyPressed, this );
@@ -158,6 +162,9 @@ Tutorial4::Tutorial4( const std::wstring& name, int width, int height, bool vSyn
     m_Window->Resize += ResizeEvent::slot( &Tutorial4::OnResize, this );
     m_Window->DPIScaleChanged += DPIScaleEvent::slot( &Tutorial4::OnDPIScaleChanged, this );
 
+    // The camera only needs the accumulated mouse motion of a frame.
+    m_Window->SetCoalesceMouseMotion( true );
+
     XMVECTOR cameraPos    = XMVectorSet( 0, 5, -20, 1 );
     XMVECTOR cameraTarget = XMVectorSet( 0, 5, 0, 1 );
     XMVECTOR cameraUp     = XMVectorSet( 0, 1, 0, 0 );
@@ -220,7 +227,9 @@ bool Tutorial4::LoadContent()
     m_DirectXTexture        = commandList->LoadTextureFromFile( L"Assets/Textures/Directx9.png", true );
     m_EarthTexture          = commandList->LoadTextureFromFile( L"Assets/Textures/earth.dds", true );
     m_MonaLisaTexture       = commandList->LoadTextureFromFile( L"Assets/Textures/Mona_Lisa.jpg", true );
-    m_GraceCathedralTexture = commandList->LoadTextureFromFile( L"Assets/Textures/grace-new.hdr", true );
+    // The cubemap faces are 1024x1024 so mips of the panorama that are wider
+    // than 4 * 1024 texels are never sampled and are not loaded.
+    m_GraceCathedralTexture = commandList->LoadTiledTextureFromFile( L"Assets/Textures/grace-new.hdr", 4096 );
 
     // m_GraceCathedralTexture = commandList->LoadTextureFromFile( L"Assets/Textures/UV_Test_Pattern.png" );
 
@@ -365,6 +374,12 @@ bool Tutorial4::LoadContent()
                                                                              D3D12_SHADER_VISIBILITY_PIXEL );
         rootParameters[RootParameters::Textures].InitAsDescriptorTable( 1, &descriptorRange,
                                                                         D3D12_SHADER_VISIBILITY_PIXEL );
+        rootParameters[RootParameters::LightClustersCB].InitAsConstants( sizeof( LightClusterConstants ) / 4, 2, 0,
+                                                                         D3D12_SHADER_VISIBILITY_PIXEL );
+        rootParameters[RootParameters::LightClusters].InitAsShaderResourceView( 3, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+                                                                                D3D12_SHADER_VISIBILITY_PIXEL );
+        rootParameters[RootParameters::LightIndices].InitAsShaderResourceView( 4, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+                                                                               D3D12_SHADER_VISIBILITY_PIXEL );
 
         CD3DX12_STATIC_SAMPLER_DESC linearRepeatSampler( 0, D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR );
         CD3DX12_STATIC_SAMPLER_DESC anisotropicSampler( 0, D3D12_FILTER_ANISOTROPIC );
@@ -532,7 +547,7 @@ void Tutorial4::OnUpdate( UpdateEventArgs& e )
     {
         g_FPS = frameCount / totalTime;
 
-        m_Logger->info( "FPS: {:.7}", g_FPS );
+        m_UpdateLog->info( "FPS: {:.7}", g_FPS );
 
         wchar_t buffer[512];
         ::swprintf_s( buffer, L"HDR [FPS: %f]", g_FPS );
@@ -579,6 +594,11 @@ void Tutorial4::OnUpdate( UpdateEventArgs& e )
     const float offset  = 2.0f * XM_PI / numPointLights;
     const float offset2 = offset + ( offset / 2.0f );
 
+    // Attenuate the lights so that they have a finite range (about 50 units) and the
+    // light clusters can cull them. The intensity makes up for the attenuation in the room.
+    const float lightIntensity   = 2.0f;
+    const float lightAttenuation = 0.2f;
+
     // Setup the light buffers.
     m_PointLights.resize( numPointLights );
     for ( int i = 0; i < numPointLights; ++i )
@@ -592,8 +612,8 @@ void Tutorial4::OnUpdate( UpdateEventArgs& e )
         XMStoreFloat4( &l.PositionVS, positionVS );
 
         l.Color       = XMFLOAT4( LightColors[i] );
-        l.Intensity   = 1.0f;
-        l.Attenuation = 0.0f;
+        l.Intensity   = lightIntensity;
+        l.Attenuation = lightAttenuation;
     }
 
     m_SpotLights.resize( numSpotLights );
@@ -613,10 +633,28 @@ void Tutorial4::OnUpdate( UpdateEventArgs& e )
         XMStoreFloat4( &l.DirectionVS, directionVS );
 
         l.Color       = XMFLOAT4( LightColors[numPointLights + i] );
-        l.Intensity   = 1.0f;
+        l.Intensity   = lightIntensity;
         l.SpotAngle   = XMConvertToRadians( 45.0f );
-        l.Attenuation = 0.0f;
+        l.Attenuation = lightAttenuation;
+    }
+
+    // Assign the lights to the light clusters.
+    m_LightClusterBuilder.SetProjectionMatrix( m_Camera.get_ProjectionMatrix() );
+    m_LightClusterBuilder.ClearLights();
+    // The lights are attenuated by intensity / ( 1 + attenuation * d^2 ).
+    for ( const auto& l: m_PointLights )
+    {
+        float range = LightClusterBuilder::GetLightRange( l.Color, 1.0f, 0.0f, l.Attenuation, l.Intensity );
+        m_LightClusterBuilder.AddPointLight( { l.PositionVS.x, l.PositionVS.y, l.PositionVS.z }, range );
     }
+    for ( const auto& l: m_SpotLights )
+    {
+        float range = LightClusterBuilder::GetLightRange( l.Color, 1.0f, 0.0f, l.Attenuation, l.Intensity );
+        m_LightClusterBuilder.AddSpotLight( { l.PositionVS.x, l.PositionVS.y, l.PositionVS.z },
+                                            { l.DirectionVS.x, l.DirectionVS.y, l.DirectionVS.z }, range,
+                                            l.SpotAngle );
+    }
+    m_LightClusterBuilder.Build();
 
     OnRender();
 }
@@ -902,6 +940,13 @@ void Tutorial4::OnRender()
     commandList->SetGraphicsDynamicStructuredBuffer( RootParameters::PointLights, m_PointLights );
     commandList->SetGraphicsDynamicStructuredBuffer( RootParameters::SpotLights, m_SpotLights );
 
+    // Upload light clusters
+    commandList->SetGraphics32BitConstants( RootParameters::LightClustersCB, m_LightClusterBuilder.GetConstants() );
+    commandList->SetGraphicsDynamicStructuredBuffer( RootParameters::LightClusters,
+                                                     m_LightClusterBuilder.GetClusters() );
+    commandList->SetGraphicsDynamicStructuredBuffer( RootParameters::LightIndices,
+                                                     m_LightClusterBuilder.GetLightIndices() );
+
     // Draw the earth sphere
     XMMATRIX translationMatrix    = XMMatrixTranslation( -4.0f, 2.0f, -4.0f );
     XMMATRIX rotationMatrix       = XMMatrixIdentity();
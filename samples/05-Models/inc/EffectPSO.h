@@ -33,6 +33,8 @@
 #include "EffectPSO.h"
 #include "Light.h"
 
+#include <dx12lib/LightClusterBuilder.h>
+
 #include <DirectXMath.h>
 
 #include <memory>
@@ -40,13 +42,15 @@
 
 namespace dx12lib
 {
+class Buffer;
 class CommandList;
+class CommandSignature;
 class Device;
 class Material;
+class MaterialTable;
 class RootSignature;
 class PipelineStateObject;
-class ShaderResourceView;
-class Texture;
+class StructuredBuffer;
 }  // namespace dx12lib
 
 class EffectPSO
@@ -58,6 +62,11 @@ public:
         uint32_t NumPointLights;
         uint32_t NumSpotLights;
         uint32_t NumDirectionalLights;
+        uint32_t Padding;
+        // The sum of the ambient terms of the point and spot lights. The
+        // ambient term does not depend on the distance to the light so it is
+        // not affected by the light clusters.
+        DirectX::XMFLOAT4 Ambient;
     };
 
     // Transformation matrices for the vertex shader.
@@ -77,26 +86,34 @@ public:
         // Vertex shader parameter
         MatricesCB,  // ConstantBuffer<Matrices> MatCB : register(b0);
 
+        // Vertex and pixel shader parameter
+        DrawConstantsCB,  // ConstantBuffer<DrawConstants> DrawConstantsCB : register( b0, space1 );
+
         // Pixel shader parameters
-        MaterialCB,         // ConstantBuffer<Material> MaterialCB : register( b0, space1 );
         LightPropertiesCB,  // ConstantBuffer<LightProperties> LightPropertiesCB : register( b1 );
 
         PointLights,        // StructuredBuffer<PointLight> PointLights : register( t0 );
         SpotLights,         // StructuredBuffer<SpotLight> SpotLights : register( t1 );
         DirectionalLights,  // StructuredBuffer<DirectionalLight> DirectionalLights : register( t2 )
 
-        Textures,  // Texture2D AmbientTexture       : register( t3 );
-                   // Texture2D EmissiveTexture : register( t4 );
-                   // Texture2D DiffuseTexture : register( t5 );
-                   // Texture2D SpecularTexture : register( t6 );
-                   // Texture2D SpecularPowerTexture : register( t7 );
-                   // Texture2D NormalTexture : register( t8 );
-                   // Texture2D BumpTexture : register( t9 );
-                   // Texture2D OpacityTexture : register( t10 );
+        LightClustersCB,  // ConstantBuffer<LightClusterConstants> LightClustersCB : register( b2 );
+        LightClusters,    // StructuredBuffer<LightCluster> LightClusters : register( t11 );
+        LightIndices,     // StructuredBuffer<uint> LightIndices : register( t12 );
+
+        Materials,  // StructuredBuffer<MaterialTableEntry> Materials : register( t13 );
+        Textures,   // Texture2D Textures[] : register( t0, space2 ); (The bindless descriptor table)
+
+        // Vertex shader parameter (indirect draws)
+        Transforms,  // StructuredBuffer<Matrices> Transforms : register( t14 );
         NumRootParameters
     };
 
-    EffectPSO( std::shared_ptr<dx12lib::Device> device, bool enableLigting, bool enableDecal );
+    /**
+     * @param materialTable The material table that stores the material properties.
+     * The material table can be shared by multiple effects.
+     */
+    EffectPSO( std::shared_ptr<dx12lib::Device> device, std::shared_ptr<dx12lib::MaterialTable> materialTable,
+               bool enableLigting, bool enableDecal );
     virtual ~EffectPSO();
 
     const std::vector<PointLight>& GetPointLights() const
@@ -106,7 +123,8 @@ public:
     void SetPointLights( const std::vector<PointLight>& pointLights )
     {
         m_PointLights = pointLights;
-        m_DirtyFlags |= DF_PointLights;
+        m_DirtyFlags |= DF_PointLights | DF_LightClusters;
+        m_RebuildLightClusters = true;
     }
 
     const std::vector<SpotLight>& GetSpotLights() const
@@ -116,7 +134,8 @@ public:
     void SetSpotLights( const std::vector<SpotLight>& spotLights )
     {
         m_SpotLights = spotLights;
-        m_DirtyFlags |= DF_SpotLights;
+        m_DirtyFlags |= DF_SpotLights | DF_LightClusters;
+        m_RebuildLightClusters = true;
     }
 
     const std::vector<DirectionalLight>& GetDirectionalLights() const
@@ -163,16 +182,42 @@ public:
     void XM_CALLCONV SetProjectionMatrix( DirectX::FXMMATRIX projectionMatrix )
     {
         m_pAlignedMVP->Projection = projectionMatrix;
-        m_DirtyFlags |= DF_Matrices;
+        m_DirtyFlags |= DF_Matrices | DF_LightClusters;
+        m_RebuildLightClusters = true;
     }
     DirectX::XMMATRIX GetProjectionMatrix() const
     {
         return m_pAlignedMVP->Projection;
     }
 
+    /**
+     * The light clusters that were built the last time the effect was applied.
+     */
+    const dx12lib::LightClusterBuilder& GetLightClusters() const
+    {
+        return m_LightClusterBuilder;
+    }
+
     // Apply this effect to the rendering pipeline.
     void Apply( dx12lib::CommandList& commandList );
 
+    /**
+     * Execute the commands of an argument buffer that was built with an
+     * IndirectDrawBuilder. The material of each draw is selected by the material
+     * index of the command (instead of the material of the effect) and the
+     * matrices of each instance are read from the transforms buffer using the
+     * transform index of the command and the instance ID.
+     *
+     * @param transforms A buffer of Matrices.
+     * @param argumentBuffer A buffer of IndirectDrawCommand.
+     * @param firstCommand The index of the first command to execute.
+     * @param numCommands The number of commands to execute.
+     */
+    void ExecuteIndirect( dx12lib::CommandList&                             commandList,
+                          const std::shared_ptr<dx12lib::StructuredBuffer>& transforms,
+                          const std::shared_ptr<dx12lib::Buffer>& argumentBuffer, uint32_t firstCommand,
+                          uint32_t numCommands );
+
 private:
     enum DirtyFlags
     {
@@ -182,7 +227,10 @@ private:
         DF_DirectionalLights   = ( 1 << 2 ),
         DF_Material            = ( 1 << 3 ),
         DF_Matrices            = ( 1 << 4 ),
-        DF_All = DF_PointLights | DF_SpotLights | DF_DirectionalLights | DF_Material | DF_Matrices
+        DF_LightClusters       = ( 1 << 5 ),
+        DF_MaterialTable       = ( 1 << 6 ),
+        DF_All = DF_PointLights | DF_SpotLights | DF_DirectionalLights | DF_Material | DF_Matrices | DF_LightClusters |
+                 DF_MaterialTable
     };
 
     struct alignas( 16 ) MVP
@@ -192,27 +240,44 @@ private:
         DirectX::XMMATRIX Projection;
     };
 
-    // Helper function to bind a texture to the rendering pipeline.
-    inline void BindTexture( dx12lib::CommandList& commandList, uint32_t offset,
-                             const std::shared_ptr<dx12lib::Texture>& texture );
+    // Assign the point and spot lights to the light clusters.
+    void BuildLightClusters();
+
+    // Set the pipeline state and root signature on the command list.
+    void BindPipelineState( dx12lib::CommandList&                                commandList,
+                            const std::shared_ptr<dx12lib::PipelineStateObject>& pipelineStateObject );
+    // Bind the parameters that are shared by direct and indirect draws (the
+    // material table and the lights).
+    void BindSharedParameters( dx12lib::CommandList& commandList );
 
     std::shared_ptr<dx12lib::Device>              m_Device;
     std::shared_ptr<dx12lib::RootSignature>       m_RootSignature;
     std::shared_ptr<dx12lib::PipelineStateObject> m_PipelineStateObject;
 
+    // The pipeline state object (with a vertex shader that reads the matrices
+    // from the transforms buffer) and command signature for indirect draws.
+    std::shared_ptr<dx12lib::PipelineStateObject> m_IndirectPipelineStateObject;
+    std::shared_ptr<dx12lib::CommandSignature>    m_CommandSignature;
+
     std::vector<PointLight>       m_PointLights;
     std::vector<SpotLight>        m_SpotLights;
     std::vector<DirectionalLight> m_DirectionalLights;
 
+    // Assigns the point and spot lights to the clusters of the view frustum.
+    dx12lib::LightClusterBuilder m_LightClusterBuilder;
+    bool                         m_RebuildLightClusters;
+
     // The material to apply during rendering.
     std::shared_ptr<dx12lib::Material> m_Material;
 
-    // An SRV used pad unused texture slots.
-    std::shared_ptr<dx12lib::ShaderResourceView> m_DefaultSRV;
+    // The material table and the material buffer that is bound to the command list.
+    std::shared_ptr<dx12lib::MaterialTable>    m_MaterialTable;
+    std::shared_ptr<dx12lib::StructuredBuffer> m_MaterialBuffer;
 
     // Matrices
     MVP* m_pAlignedMVP;
-    // If the command list changes, all parameters need to be rebound.
+    // If the command list or the root signature on the command list changes,
+    // all parameters need to be rebound.
     dx12lib::CommandList* m_pPreviousCommandList;
 
     // Which properties need to be bound to the
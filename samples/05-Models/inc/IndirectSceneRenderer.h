@@ -0,0 +1,180 @@
+#pragma once
+
+/**
+ *  @file IndirectSceneRenderer.h
+ *
+ *  @brief Renders the meshes of one or more scenes with a single ExecuteIndirect
+ *  per effect instead of a draw call per mesh.
+ *
+ *  The scenes are visited once to gather the draws. Scene nodes that reference
+ *  the same mesh (imported scenes often reference a mesh from many nodes) are
+ *  merged into a single instanced command. The matrices of the instances are
+ *  written to a transforms buffer, the matrices of the instances of a mesh are
+ *  stored contiguously so that the vertex shader can find the matrices of an
+ *  instance from the transform index of the command and the instance ID. The
+ *  commands (material index, transform index, vertex and index buffer views,
+ *  index range, and instance count) are written to an argument buffer (see
+ *  dx12lib::IndirectDrawBuilder). The commands are grouped by effect and each
+ *  group is submitted with EffectPSO::ExecuteIndirect.
+ *
+ *  Meshes that can't be drawn indirectly (meshes without an index buffer, with
+ *  more than one vertex buffer, or that are not triangle lists) are drawn with
+ *  EffectPSO::Apply and Mesh::Draw after the indirect draws of their effect.
+ */
+
+#include "EffectPSO.h"
+
+#include <dx12lib/IndirectDrawBuilder.h>
+#include <dx12lib/Visitor.h>
+
+#include <DirectXMath.h>
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Camera;
+
+namespace dx12lib
+{
+class CommandList;
+class IndexBuffer;
+class MaterialTable;
+class Mesh;
+class VertexBuffer;
+}  // namespace dx12lib
+
+class IndirectSceneRenderer : public dx12lib::Visitor
+{
+public:
+    /**
+     * Used to skip the opaque or transparent meshes of a scene.
+     */
+    static const uint32_t NoEffect = 0xffffffff;
+
+    struct Statistics
+    {
+        // The number of meshes that were visited (the number of draws without instancing).
+        uint32_t NumMeshInstances = 0;
+        // The number of instanced indirect commands.
+        uint32_t NumIndirectCommands = 0;
+        // The number of meshes that could not be drawn indirectly.
+        uint32_t NumDirectDraws          = 0;
+        uint32_t NumExecuteIndirectCalls = 0;
+
+        /**
+         * The number of draws after instancing.
+         */
+        uint32_t GetNumDraws() const
+        {
+            return NumIndirectCommands + NumDirectDraws;
+        }
+    };
+
+    /**
+     * @param materialTable The material table that is used by the effects.
+     * @param effects The effects that are used to render the scenes. The
+     * effects are rendered in this order.
+     */
+    IndirectSceneRenderer( std::shared_ptr<dx12lib::MaterialTable> materialTable,
+                           const std::vector<std::shared_ptr<EffectPSO>>& effects );
+
+    /**
+     * Remove the draws of the previous frame and set the view and projection
+     * matrices of the effects.
+     */
+    void Begin( const Camera& camera );
+
+    /**
+     * Add the meshes of a scene.
+     *
+     * @param opaqueEffect The index of the effect that is used to render the
+     * opaque meshes of the scene (or NoEffect to skip the opaque meshes).
+     * @param transparentEffect The index of the effect that is used to render
+     * the transparent meshes of the scene (or NoEffect to skip the transparent
+     * meshes).
+     */
+    void AddScene( dx12lib::Scene& scene, uint32_t opaqueEffect, uint32_t transparentEffect = NoEffect );
+
+    /**
+     * Render the meshes of all scenes that were added since Begin.
+     */
+    void Render( dx12lib::CommandList& commandList );
+
+    /**
+     * The statistics of the last call to Render.
+     */
+    const Statistics& GetStatistics() const
+    {
+        return m_Statistics;
+    }
+
+    virtual void Visit( dx12lib::Scene& scene ) override;
+    virtual void Visit( dx12lib::SceneNode& sceneNode ) override;
+    virtual void Visit( dx12lib::Mesh& mesh ) override;
+
+private:
+    // Sort the transforms of the instances by instance group and add the
+    // commands of the instance groups.
+    void BuildInstances();
+
+    // The instances of a mesh that are drawn by a single command.
+    struct InstanceGroup
+    {
+        dx12lib::Mesh* Mesh;
+        uint32_t       Effect;
+        uint32_t       MaterialIndex;
+        uint32_t       NumInstances;
+        // The index of the matrices of the first instance in the transforms buffer.
+        uint32_t FirstInstance;
+    };
+
+    struct Instance
+    {
+        uint32_t Group;
+        // The index of the matrices of the scene node.
+        uint32_t NodeTransform;
+    };
+
+    // A mesh that is drawn without ExecuteIndirect.
+    struct DirectDraw
+    {
+        dx12lib::Mesh*    Mesh;
+        uint32_t          Effect;
+        DirectX::XMMATRIX WorldMatrix;
+    };
+
+    std::shared_ptr<dx12lib::MaterialTable> m_MaterialTable;
+    std::vector<std::shared_ptr<EffectPSO>> m_Effects;
+
+    dx12lib::IndirectDrawBuilder m_DrawBuilder;
+
+    std::vector<InstanceGroup> m_InstanceGroups;
+    // The instance group of a mesh (for each effect).
+    std::vector<std::unordered_map<dx12lib::Mesh*, uint32_t>> m_InstanceGroupIndices;
+    std::vector<Instance>                                     m_Instances;
+    std::vector<DirectDraw>                                   m_DirectDraws;
+
+    // The matrices of the scene nodes that have meshes and the matrices of the
+    // instances (sorted by instance group).
+    std::vector<EffectPSO::Matrices> m_NodeTransforms;
+    std::vector<EffectPSO::Matrices> m_Transforms;
+
+    // The vertex and index buffers that are used by the indirect draws.
+    std::unordered_set<std::shared_ptr<dx12lib::VertexBuffer>> m_VertexBuffers;
+    std::unordered_set<std::shared_ptr<dx12lib::IndexBuffer>>  m_IndexBuffers;
+
+    DirectX::XMMATRIX m_ViewMatrix;
+    DirectX::XMMATRIX m_ProjectionMatrix;
+
+    // The state of the scene that is currently being visited.
+    uint32_t          m_OpaqueEffect;
+    uint32_t          m_TransparentEffect;
+    DirectX::XMMATRIX m_WorldMatrix;
+    // The index of the matrices of the current scene node. The matrices are
+    // only computed when the first mesh of the scene node is drawn.
+    uint32_t m_NodeTransformIndex;
+
+    Statistics m_Statistics;
+};
@@ -49,14 +49,18 @@ namespace dx12lib
 class CommandList;
 class Device;
 class GUI;
+class MaterialTable;
 class PipelineStateObject;
 class RenderTarget;
 class RootSignature;
 class Scene;
+class StreamingUploadQueue;
 class SwapChain;
+class TextureCooker;
 }  // namespace dx12lib
 
 class EffectPSO;
+class IndirectSceneRenderer;
 
 class Tutorial5
 {
@@ -64,6 +68,16 @@ public:
     Tutorial5( const std::wstring& name, int width, int height, bool vSync = false );
     ~Tutorial5();
 
+    /**
+     * Load the textures of the scenes block compressed with a full mip chain
+     * (see TextureCooker.h). Textures are loaded uncompressed if no cooker is
+     * set. Must be called before Run.
+     */
+    void SetTextureCooker( std::shared_ptr<dx12lib::TextureCooker> textureCooker )
+    {
+        m_TextureCooker = textureCooker;
+    }
+
     /**
      * Start the main game loop.
      */
@@ -151,6 +165,12 @@ private:
     std::shared_ptr<dx12lib::SwapChain> m_SwapChain;
     std::shared_ptr<dx12lib::GUI>       m_GUI;
 
+    // Cooks the textures of the scenes (optional).
+    std::shared_ptr<dx12lib::TextureCooker> m_TextureCooker;
+
+    // Streams the textures of the scenes within a per-frame budget.
+    std::shared_ptr<dx12lib::StreamingUploadQueue> m_StreamingUploadQueue;
+
     std::shared_ptr<dx12lib::Scene> m_Scene;
 
     // Some scenes to represent the light sources.
@@ -159,11 +179,18 @@ private:
     std::shared_ptr<dx12lib::Scene> m_Axis;
 
 
+    // The properties of all materials that are used to render the scenes.
+    std::shared_ptr<dx12lib::MaterialTable> m_MaterialTable;
+
     // Pipeline state object for rendering the scene.
     std::shared_ptr<EffectPSO> m_LightingPSO;
     std::shared_ptr<EffectPSO> m_DecalPSO;
     std::shared_ptr<EffectPSO> m_UnlitPSO;
 
+    // Renders the scene with a single ExecuteIndirect per effect.
+    std::shared_ptr<IndirectSceneRenderer> m_IndirectSceneRenderer;
+    bool                                   m_UseIndirectDraws;
+
 
     // Render target
     dx12lib::RenderTarget m_RenderTarget;
@@ -194,6 +221,7 @@ private:
     bool              m_ShowFileOpenDialog;
     bool              m_CancelLoading;
     bool              m_ShowControls;
+    bool              m_ShowStatistics;
     std::atomic_bool  m_IsLoading;
     std::future<bool> m_LoadingTask;
     float             m_LoadingProgress;
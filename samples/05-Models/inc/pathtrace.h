@@ -29,6 +29,7 @@ namespace dx12lib
     class PipelineStateObject;
     class ShaderResourceView;
     class Texture;
+    class TextureCooker;
 }  // namespace dx12lib
 
 enum PTRootParams : UINT32
@@ -155,6 +156,8 @@ void PathtraceInit();
 void CreatePathTracePipelineStateObject();
 //Windows callback function
 void Render();
+// Trace a single sample per pixel.
+void TracePass();
 void CreateRenderTargets();
 void OnResize(ResizeEventArgs& e);
 void OnUpdate(UpdateEventArgs& e);
@@ -163,12 +166,15 @@ void OnUpdate(UpdateEventArgs& e);
 void OnKeyPressed(KeyEventArgs& e);
 uint32_t Run();
 //Pipeline
-PathTracePipeline(std::shared_ptr<dx12lib::Device> device, int width, int height);
+PathTracePipeline(const std::wstring& name, int width, int height);
+// Load the textures of the scene block compressed (see TextureCooker.h). Must be called before Run.
+void SetTextureCooker(std::shared_ptr<dx12lib::TextureCooker> textureCooker) { m_TextureCooker = textureCooker; }
 void Apply(dx12lib::CommandList& commandList) {};
 
 private:
 
     std::shared_ptr<Window> m_Window;
+    std::shared_ptr<dx12lib::TextureCooker> m_TextureCooker;
 
     Camera           m_Camera;
     CameraController m_CameraController;
@@ -204,6 +210,10 @@ private:
     uint64 numIntersectingSpotLights = 0;
 
     RenderTexture rtTarget;
+    // The progressive result in the format of the swap chain. It is kept in the
+    // copy source state between frames so that it can be copied to the back buffer.
+    RenderTexture rtOutput;
+    std::shared_ptr<dx12lib::Texture> m_OutputTexture;
 
     const Model* currentModel = nullptr;
 
@@ -216,6 +226,8 @@ private:
     // Ray tracing resources
     CompiledShaderPtr pathTraceShader;
     uint32 rtCurrSampleIdx = 0;
+    // The view matrix of the camera when the accumulation was restarted.
+    DirectX::XMFLOAT4X4 m_PreviousViewMatrix;
     RawBuffer rtBottomLevelAccelStructure;
     RawBuffer rtTopLevelAccelStructure;
 
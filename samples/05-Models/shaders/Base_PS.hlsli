@@ -39,6 +39,34 @@ struct Material
     // Total:                              ( 16 * 8 = 128 bytes )
 };
 
+// The indices of the material textures in the Textures table.
+#define AMBIENT_TEXTURE        0
+#define EMISSIVE_TEXTURE       1
+#define DIFFUSE_TEXTURE        2
+#define SPECULAR_TEXTURE       3
+#define SPECULAR_POWER_TEXTURE 4
+#define NORMAL_TEXTURE         5
+#define BUMP_TEXTURE           6
+#define OPACITY_TEXTURE        7
+
+// Must match dx12lib::MaterialTableEntry.
+struct MaterialTableEntry
+{
+    Material Properties;
+    //------------------------------------ ( 16 * 8 = 128 bytes )
+    uint     TextureIndices[8]; // Indices in the Textures table.
+    //------------------------------------ ( 16 * 2 = 32 bytes )
+    // Total:                              ( 16 * 10 = 160 bytes )
+};
+
+// Set for each draw. The transform index is only used by the vertex shader
+// of indirect draws.
+struct DrawConstants
+{
+    uint MaterialIndex;
+    uint TransformIndex;
+};
+
 #if ENABLE_LIGHTING
 struct PointLight
 {
@@ -98,6 +126,33 @@ struct LightProperties
     uint NumPointLights;
     uint NumSpotLights;
     uint NumDirectionalLights;
+    uint Padding;
+    //----------------------------------- (16 byte boundary)
+    float4 Ambient; // Sum of the ambient terms of the point and spot lights.
+    //----------------------------------- (16 byte boundary)
+};
+
+struct LightClusterConstants
+{
+    float4 ProjectionScale; // ( _11, _22, _31, _32 ) of the projection matrix.
+    //----------------------------------- (16 byte boundary)
+    uint   NumClustersX;
+    uint   NumClustersY;
+    uint   NumClustersZ;
+    float  DepthSliceScale;
+    //----------------------------------- (16 byte boundary)
+    float  DepthSliceBias;
+    float  NearZ;
+    float  FarZ;
+    uint   Padding;
+    //----------------------------------- (16 byte boundary)
+    // Total:                              16 * 3 = 48 bytes
+};
+
+struct LightCluster
+{
+    uint Offset;  // Offset of the first light in the LightIndices buffer.
+    uint Counts;  // Number of point lights (low 16 bits) and spot lights (high 16 bits).
 };
 
 struct LightResult
@@ -112,19 +167,19 @@ ConstantBuffer<LightProperties> LightPropertiesCB : register( b1 );
 StructuredBuffer<PointLight> PointLights : register( t0 );
 StructuredBuffer<SpotLight> SpotLights : register( t1 );
 StructuredBuffer<DirectionalLight> DirectionalLights : register( t2 );
+
+ConstantBuffer<LightClusterConstants> LightClustersCB : register( b2 );
+
+StructuredBuffer<LightCluster> LightClusters : register( t11 );
+StructuredBuffer<uint> LightIndices : register( t12 );
 #endif // ENABLE_LIGHTING
 
-ConstantBuffer<Material> MaterialCB : register( b0, space1 );
+ConstantBuffer<DrawConstants> DrawConstantsCB : register( b0, space1 );
 
-// Textures
-Texture2D AmbientTexture       : register( t3 );
-Texture2D EmissiveTexture      : register( t4 );
-Texture2D DiffuseTexture       : register( t5 );
-Texture2D SpecularTexture      : register( t6 );
-Texture2D SpecularPowerTexture : register( t7 );
-Texture2D NormalTexture        : register( t8 );
-Texture2D BumpTexture          : register( t9 );
-Texture2D OpacityTexture       : register( t10 );
+StructuredBuffer<MaterialTableEntry> Materials : register( t13 );
+
+// The bindless descriptor table.
+Texture2D Textures[]           : register( t0, space2 );
 
 SamplerState TextureSampler    : register(s0);
 
@@ -217,6 +272,23 @@ LightResult DoDirectionalLight( DirectionalLight light, float3 V, float3 P, floa
     return result;
 }
 
+// Get the light cluster that contains a view space position.
+// This must match LightClusterBuilder::GetClusterIndex.
+uint GetClusterIndex( float3 P )
+{
+    LightClusterConstants cb = LightClustersCB;
+
+    float z = max( P.z, cb.NearZ );
+    float2 ndc = ( P.xy * cb.ProjectionScale.xy + z * cb.ProjectionScale.zw ) / z;
+
+    uint3 numClusters = uint3( cb.NumClustersX, cb.NumClustersY, cb.NumClustersZ );
+    float3 cluster = float3( ( ndc * 0.5f + 0.5f ) * float2( numClusters.xy ),
+                             log( z ) * cb.DepthSliceScale + cb.DepthSliceBias );
+    uint3 c = (uint3)clamp( floor( cluster ), 0, float3( numClusters - 1 ) );
+
+    return ( c.z * numClusters.y + c.y ) * numClusters.x + c.x;
+}
+
 LightResult DoLighting( float3 P, float3 N, float specularPower )
 {
     uint i;
@@ -226,26 +298,34 @@ LightResult DoLighting( float3 P, float3 N, float specularPower )
 
     LightResult totalResult = (LightResult)0;
 
+    // Only the point and spot lights that affect the cluster of the pixel
+    // are evaluated. The light indices of a cluster are the point light
+    // indices followed by the spot light indices.
+    LightCluster cluster = LightClusters[GetClusterIndex( P )];
+    uint numPointLights = cluster.Counts & 0xffff;
+    uint numSpotLights = cluster.Counts >> 16;
+
     // Iterate point lights.
-    for ( i = 0; i < LightPropertiesCB.NumPointLights; ++i )
+    for ( i = 0; i < numPointLights; ++i )
     {
-        LightResult result = DoPointLight( PointLights[i], V, P, N, specularPower );
+        LightResult result = DoPointLight( PointLights[LightIndices[cluster.Offset + i]], V, P, N, specularPower );
 
         totalResult.Diffuse += result.Diffuse;
         totalResult.Specular += result.Specular;
-        totalResult.Ambient += result.Ambient;
     }
 
     // Iterate spot lights.
-    for ( i = 0; i < LightPropertiesCB.NumSpotLights; ++i )
+    for ( i = 0; i < numSpotLights; ++i )
     {
-        LightResult result = DoSpotLight( SpotLights[i], V, P, N, specularPower );
+        LightResult result = DoSpotLight( SpotLights[LightIndices[cluster.Offset + numPointLights + i]], V, P, N, specularPower );
 
         totalResult.Diffuse += result.Diffuse;
         totalResult.Specular += result.Specular;
-        totalResult.Ambient += result.Ambient;
     }
 
+    // The ambient term of the point and spot lights does not depend on the distance to the light.
+    totalResult.Ambient += LightPropertiesCB.Ambient;
+
     // Iterate directinal lights
     for (i = 0; i < LightPropertiesCB.NumDirectionalLights; ++i)
     {
@@ -264,15 +344,13 @@ LightResult DoLighting( float3 P, float3 N, float specularPower )
 }
 #endif // ENABLE_LIGHTING
 
-float3 ExpandNormal( float3 n )
-{
-    return n * 2.0f - 1.0f;
-}
-
 float3 DoNormalMapping( float3x3 TBN, Texture2D tex, float2 uv )
 {
-    float3 N = tex.Sample( TextureSampler, uv ).xyz;
-    N = ExpandNormal( N );
+    // Only X and Y are used so that BC5 compressed normal maps (which don't
+    // store Z) can be used. Z is reconstructed from X and Y.
+    float3 N;
+    N.xy = tex.Sample( TextureSampler, uv ).xy * 2.0f - 1.0f;
+    N.z = sqrt( saturate( 1.0f - dot( N.xy, N.xy ) ) );
 
     // Transform normal from tangent space to view space.
     N = mul( N, TBN );
@@ -321,15 +399,22 @@ float4 SampleTexture(Texture2D t, float2 uv, float4 c)
     return c;
 }
 
+// Get a texture of the material.
+Texture2D GetTexture( MaterialTableEntry entry, uint textureType )
+{
+    return Textures[entry.TextureIndices[textureType]];
+}
+
 float4 main( PixelShaderInput IN ): SV_Target
 {
-    Material material = MaterialCB;
+    MaterialTableEntry entry = Materials[DrawConstantsCB.MaterialIndex];
+    Material material = entry.Properties;
 
     // By default, use the alpha component of the diffuse color.
     float  alpha    = material.Diffuse.a;
     if (material.HasOpacityTexture) 
     {
-        alpha = OpacityTexture.Sample( TextureSampler, IN.TexCoord.xy ).r;
+        alpha = GetTexture( entry, OPACITY_TEXTURE ).Sample( TextureSampler, IN.TexCoord.xy ).r;
     }
 
 #if ENABLE_DECAL
@@ -347,19 +432,19 @@ float4 main( PixelShaderInput IN ): SV_Target
 
     if (material.HasAmbientTexture)
     {
-        ambient = SampleTexture( AmbientTexture, uv, ambient );
+        ambient = SampleTexture( GetTexture( entry, AMBIENT_TEXTURE ), uv, ambient );
     }
     if (material.HasEmissiveTexture)
     {
-        emissive = SampleTexture( EmissiveTexture, uv, emissive );
+        emissive = SampleTexture( GetTexture( entry, EMISSIVE_TEXTURE ), uv, emissive );
     }
     if ( material.HasDiffuseTexture )
     {
-        diffuse = SampleTexture( DiffuseTexture, uv, diffuse );
+        diffuse = SampleTexture( GetTexture( entry, DIFFUSE_TEXTURE ), uv, diffuse );
     }
     if (material.HasSpecularPowerTexture)
     {
-        specularPower *= SpecularPowerTexture.Sample( TextureSampler, uv ).r;
+        specularPower *= GetTexture( entry, SPECULAR_POWER_TEXTURE ).Sample( TextureSampler, uv ).r;
     }
 
     float3 N;
@@ -374,7 +459,7 @@ float4 main( PixelShaderInput IN ): SV_Target
                                  bitangent,
                                  normal );
 
-        N = DoNormalMapping( TBN, NormalTexture, uv );
+        N = DoNormalMapping( TBN, GetTexture( entry, NORMAL_TEXTURE ), uv );
     }
     else if ( material.HasBumpTexture )
     {
@@ -386,7 +471,7 @@ float4 main( PixelShaderInput IN ): SV_Target
                                  -bitangent,
                                  normal );
 
-        N = DoBumpMapping( TBN, BumpTexture, uv, material.BumpIntensity );
+        N = DoBumpMapping( TBN, GetTexture( entry, BUMP_TEXTURE ), uv, material.BumpIntensity );
     }
     else
     {
@@ -406,7 +491,7 @@ float4 main( PixelShaderInput IN ): SV_Target
         specular = material.Specular;
         if (material.HasSpecularTexture)
         {
-            specular = SampleTexture( SpecularTexture, uv, specular );
+            specular = SampleTexture( GetTexture( entry, SPECULAR_TEXTURE ), uv, specular );
         }
         specular *= lit.Specular;
     }
@@ -0,0 +1,57 @@
+// clang-format off
+struct Matrices
+{
+    matrix ModelMatrix;
+    matrix ModelViewMatrix;
+    matrix InverseTransposeModelViewMatrix;
+    matrix ModelViewProjectionMatrix;
+};
+
+// Set by the command signature for each indirect draw.
+struct DrawConstants
+{
+    uint MaterialIndex;
+    uint TransformIndex;
+};
+
+ConstantBuffer<DrawConstants> DrawConstantsCB : register( b0, space1 );
+
+// The matrices of all instances in the argument buffer. The matrices of the
+// instances of a draw are stored contiguously, starting at TransformIndex.
+StructuredBuffer<Matrices> Transforms : register( t14 );
+
+struct VertexPositionNormalTangentBitangentTexture
+{
+    float3 Position  : POSITION;
+    float3 Normal    : NORMAL;
+    float3 Tangent   : TANGENT;
+    float3 Bitangent : BITANGENT;
+    float3 TexCoord  : TEXCOORD;
+};
+
+struct VertexShaderOutput
+{
+    float4 PositionVS  : POSITION;
+    float3 NormalVS    : NORMAL;
+    float3 TangentVS   : TANGENT;
+    float3 BitangentVS : BITANGENT;
+    float2 TexCoord    : TEXCOORD;
+    float4 Position    : SV_Position;
+};
+
+VertexShaderOutput main(VertexPositionNormalTangentBitangentTexture IN, uint InstanceID : SV_InstanceID)
+{
+    // SV_InstanceID does not include the start instance location of the draw.
+    Matrices m = Transforms[DrawConstantsCB.TransformIndex + InstanceID];
+
+    VertexShaderOutput OUT;
+
+    OUT.PositionVS  = mul( m.ModelViewMatrix, float4(IN.Position, 1.0f));
+    OUT.NormalVS    = mul( (float3x3)m.InverseTransposeModelViewMatrix, IN.Normal );
+    OUT.TangentVS   = mul( (float3x3)m.InverseTransposeModelViewMatrix, IN.Tangent );
+    OUT.BitangentVS = mul( (float3x3)m.InverseTransposeModelViewMatrix, IN.Bitangent );
+    OUT.TexCoord    = IN.TexCoord.xy;
+    OUT.Position    = mul( m.ModelViewProjectionMatrix, float4( IN.Position, 1.0f ) );
+
+    return OUT;
+}
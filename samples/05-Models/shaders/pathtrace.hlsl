@@ -49,6 +49,8 @@ struct LightConstants
 
 RaytracingAccelerationStructure Scene : register(t0, space200);
 RWTexture2D<float4> RenderTarget : register(u0);
+// The progressive result in the format of the swap chain (copied to the back buffer)
+RWTexture2D<unorm float4> OutputTarget : register(u1);
 ConstantBuffer<RayTraceConstants> RayTraceCB : register(b0);
 ConstantBuffer<LightConstants> LightCBuffer : register(b1);
 SamplerState MeshSampler : register(s0);
@@ -86,6 +88,11 @@ static float2 SamplePoint(in uint pixelIdx, inout uint setIdx)
     return SampleCMJ2D(RayTraceCB.CurrSampleIdx, AppSettings.SqrtNumSamples, AppSettings.SqrtNumSamples, permutation);
 }
 
+static float3 LinearToSRGB(in float3 x)
+{
+    return x < 0.0031308f ? 12.92f * x : 1.055f * pow(abs(x), 1.0f / 2.4f) - 0.055f;
+}
+
 [shader("raygeneration")]
 void RaygenShader()
 {
@@ -145,6 +152,7 @@ void RaygenShader()
     float3 newValue = lerp(newSample, currValue, lerpFactor);
 
     RenderTarget[pixelCoord] = float4(newValue, 1.0f);
+    OutputTarget[pixelCoord] = float4(LinearToSRGB(saturate(newValue)), 1.0f);
 }
 
 static float3 PathTrace(in MeshVertex hitSurface, in Material material, in PrimaryPayload inPayload)
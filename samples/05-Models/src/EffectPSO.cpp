@@ -1,24 +1,34 @@
 #include <EffectPSO.h>
 
 #include <dx12lib/CommandList.h>
+#include <dx12lib/CommandSignature.h>
 #include <dx12lib/Device.h>
 #include <dx12lib/Helpers.h>
+#include <dx12lib/IndirectDrawBuilder.h>
 #include <dx12lib/Material.h>
+#include <dx12lib/MaterialTable.h>
+#include <dx12lib/PipelineStateCache.h>
 #include <dx12lib/PipelineStateObject.h>
 #include <dx12lib/RootSignature.h>
+#include <dx12lib/StructuredBuffer.h>
 #include <dx12lib/VertexTypes.h>
 
 #include <d3dcompiler.h>
 #include <d3dx12.h>
 #include <wrl/client.h>
 
+
 using namespace Microsoft::WRL;
 using namespace dx12lib;
+using namespace DirectX;
 
-EffectPSO::EffectPSO( std::shared_ptr<dx12lib::Device> device, bool enableLighting, bool enableDecal )
+EffectPSO::EffectPSO( std::shared_ptr<dx12lib::Device> device, std::shared_ptr<dx12lib::MaterialTable> materialTable,
+                      bool enableLighting, bool enableDecal )
 : m_Device( device )
+, m_MaterialTable( materialTable )
 , m_DirtyFlags( DF_All )
 , m_pPreviousCommandList( nullptr )
+, m_RebuildLightClusters( true )
 , m_EnableLighting(enableLighting)
 , m_EnableDecal(enableDecal)
 {
@@ -29,6 +39,10 @@ EffectPSO::EffectPSO( std::shared_ptr<dx12lib::Device> device, bool enableLighti
     ComPtr<ID3DBlob> vertexShaderBlob;
     ThrowIfFailed( D3DReadFileToBlob( L"data/shaders/05-Models/Basic_VS.cso", &vertexShaderBlob ) );
 
+    // Load the vertex shader for indirect draws.
+    ComPtr<ID3DBlob> indirectVertexShaderBlob;
+    ThrowIfFailed( D3DReadFileToBlob( L"data/shaders/05-Models/Indirect_VS.cso", &indirectVertexShaderBlob ) );
+
     // Load the pixel shader.
     ComPtr<ID3DBlob> pixelShaderBlob;
     if (enableLighting) {
@@ -52,18 +66,26 @@ EffectPSO::EffectPSO( std::shared_ptr<dx12lib::Device> device, bool enableLighti
                                                     D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
                                                     D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
 
-    // Descriptor range for the textures.
-    CD3DX12_DESCRIPTOR_RANGE1 descriptorRage( D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 8, 3 );
+    // Unbounded descriptor range for the bindless descriptor table. Textures can
+    // be added to the bindless descriptor table after it is bound so the
+    // descriptors are volatile.
+    CD3DX12_DESCRIPTOR_RANGE1 descriptorRage( D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 2,
+                                              D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE );
 
     // clang-format off
     CD3DX12_ROOT_PARAMETER1 rootParameters[RootParameters::NumRootParameters];
     rootParameters[RootParameters::MatricesCB].InitAsConstantBufferView( 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX );
-    rootParameters[RootParameters::MaterialCB].InitAsConstantBufferView( 0, 1, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL );
+    rootParameters[RootParameters::DrawConstantsCB].InitAsConstants( sizeof( IndirectDrawConstants ) / 4, 0, 1, D3D12_SHADER_VISIBILITY_ALL );
     rootParameters[RootParameters::LightPropertiesCB].InitAsConstants( sizeof( LightProperties ) / 4, 1, 0, D3D12_SHADER_VISIBILITY_PIXEL );
     rootParameters[RootParameters::PointLights].InitAsShaderResourceView( 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL );
     rootParameters[RootParameters::SpotLights].InitAsShaderResourceView( 1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL );
     rootParameters[RootParameters::DirectionalLights].InitAsShaderResourceView( 2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL );
+    rootParameters[RootParameters::LightClustersCB].InitAsConstants( sizeof( LightClusterConstants ) / 4, 2, 0, D3D12_SHADER_VISIBILITY_PIXEL );
+    rootParameters[RootParameters::LightClusters].InitAsShaderResourceView( 11, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL );
+    rootParameters[RootParameters::LightIndices].InitAsShaderResourceView( 12, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL );
+    rootParameters[RootParameters::Materials].InitAsShaderResourceView( 13, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL );
     rootParameters[RootParameters::Textures].InitAsDescriptorTable( 1, &descriptorRage, D3D12_SHADER_VISIBILITY_PIXEL );
+    rootParameters[RootParameters::Transforms].InitAsShaderResourceView( 14, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX );
 
     CD3DX12_STATIC_SAMPLER_DESC anisotropicSampler( 0, D3D12_FILTER_ANISOTROPIC );
 
@@ -71,7 +93,11 @@ EffectPSO::EffectPSO( std::shared_ptr<dx12lib::Device> device, bool enableLighti
     rootSignatureDescription.Init_1_1( RootParameters::NumRootParameters, rootParameters, 1, &anisotropicSampler, rootSignatureFlags );
     // clang-format on
 
-    m_RootSignature = m_Device->CreateRootSignature( rootSignatureDescription.Desc_1_1 );
+    // The effects share the root signature (and identical pipeline state objects) through the
+    // device's pipeline state cache.
+    auto pipelineStateCache = m_Device->GetPipelineStateCache();
+
+    m_RootSignature = pipelineStateCache->GetRootSignature( rootSignatureDescription.Desc_1_1 );
 
     // Setup the pipeline state.
     struct PipelineStateStream
@@ -114,19 +140,23 @@ EffectPSO::EffectPSO( std::shared_ptr<dx12lib::Device> device, bool enableLighti
     pipelineStateStream.RTVFormats            = rtvFormats;
     pipelineStateStream.SampleDesc            = sampleDesc;
 
-    m_PipelineStateObject = m_Device->CreatePipelineStateObject( pipelineStateStream );
+    m_PipelineStateObject = pipelineStateCache->GetPipelineStateObject( pipelineStateStream );
+
+    // Indirect draws use the same root signature and pixel shader.
+    pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE( indirectVertexShaderBlob.Get() );
 
-    // Create an SRV that can be used to pad unused texture slots.
-    D3D12_SHADER_RESOURCE_VIEW_DESC defaultSRV;
-    defaultSRV.Format                        = DXGI_FORMAT_R8G8B8A8_UNORM;
-    defaultSRV.ViewDimension                 = D3D12_SRV_DIMENSION_TEXTURE2D;
-    defaultSRV.Texture2D.MostDetailedMip     = 0;
-    defaultSRV.Texture2D.MipLevels           = 1;
-    defaultSRV.Texture2D.PlaneSlice          = 0;
-    defaultSRV.Texture2D.ResourceMinLODClamp = 0;
-    defaultSRV.Shader4ComponentMapping       = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    m_IndirectPipelineStateObject = pipelineStateCache->GetPipelineStateObject( pipelineStateStream );
 
-    m_DefaultSRV = m_Device->CreateShaderResourceView( nullptr, &defaultSRV );
+    // The command signature sets the draw constants, so it must be created
+    // for the root signature of the effect.
+    auto argumentDescs = IndirectDrawBuilder::GetArgumentDescs( RootParameters::DrawConstantsCB );
+
+    D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
+    commandSignatureDesc.ByteStride                   = sizeof( IndirectDrawCommand );
+    commandSignatureDesc.NumArgumentDescs             = static_cast<UINT>( argumentDescs.size() );
+    commandSignatureDesc.pArgumentDescs               = argumentDescs.data();
+
+    m_CommandSignature = m_Device->CreateCommandSignature( commandSignatureDesc, m_RootSignature );
 }
 
 EffectPSO::~EffectPSO()
@@ -134,24 +164,54 @@ EffectPSO::~EffectPSO()
     _aligned_free( m_pAlignedMVP );
 }
 
-inline void EffectPSO::BindTexture( CommandList& commandList, uint32_t offset, const std::shared_ptr<Texture>& texture )
+void EffectPSO::BuildLightClusters()
 {
-    if ( texture )
+    m_LightClusterBuilder.SetProjectionMatrix( m_pAlignedMVP->Projection );
+    m_LightClusterBuilder.ClearLights();
+
+    for ( const auto& l: m_PointLights )
     {
-        commandList.SetShaderResourceView( RootParameters::Textures, offset, texture,
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE );
+        m_LightClusterBuilder.AddPointLight( { l.PositionVS.x, l.PositionVS.y, l.PositionVS.z },
+                                             LightClusterBuilder::GetLightRange( l.Color, l.ConstantAttenuation,
+                                                                                 l.LinearAttenuation,
+                                                                                 l.QuadraticAttenuation ) );
     }
-    else
+
+    for ( const auto& l: m_SpotLights )
     {
-        commandList.SetShaderResourceView( RootParameters::Textures, offset, m_DefaultSRV,
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE );
+        m_LightClusterBuilder.AddSpotLight(
+            { l.PositionVS.x, l.PositionVS.y, l.PositionVS.z }, { l.DirectionVS.x, l.DirectionVS.y, l.DirectionVS.z },
+            LightClusterBuilder::GetLightRange( l.Color, l.ConstantAttenuation, l.LinearAttenuation,
+                                                l.QuadraticAttenuation ),
+            l.SpotAngle );
     }
+
+    m_LightClusterBuilder.Build();
+    m_RebuildLightClusters = false;
 }
 
-void EffectPSO::Apply( CommandList& commandList )
+void EffectPSO::BindPipelineState( CommandList&                                commandList,
+                                   const std::shared_ptr<PipelineStateObject>& pipelineStateObject )
 {
-    commandList.SetPipelineState( m_PipelineStateObject );
+    // If the command list changes, all parameters need to be rebound. Root
+    // arguments are also lost if another effect has set a different root
+    // signature on the command list.
+    if ( &commandList != m_pPreviousCommandList ||
+         commandList.GetD3D12RootSignature() != m_RootSignature->GetD3D12RootSignature().Get() )
+    {
+        m_DirtyFlags           = DF_All;
+        m_pPreviousCommandList = &commandList;
+
+        m_MaterialTable->TransitionTextures( commandList );
+    }
+
+    commandList.SetPipelineState( pipelineStateObject );
     commandList.SetGraphicsRootSignature( m_RootSignature );
+}
+
+void EffectPSO::Apply( CommandList& commandList )
+{
+    BindPipelineState( commandList, m_PipelineStateObject );
 
     if ( m_DirtyFlags & DF_Matrices )
     {
@@ -168,21 +228,63 @@ void EffectPSO::Apply( CommandList& commandList )
     {
         if ( m_Material )
         {
-            const auto& materialProps = m_Material->GetMaterialProperties();
+            // Only the index of the material is set for each draw call. The
+            // material properties are stored in the material table and the
+            // textures are referenced through the bindless descriptor table.
+            IndirectDrawConstants drawConstants;
+            drawConstants.MaterialIndex  = m_MaterialTable->GetMaterialIndex( m_Material );
+            drawConstants.TransformIndex = 0;
+
+            commandList.SetGraphics32BitConstants( RootParameters::DrawConstantsCB, drawConstants );
+        }
+    }
 
-            commandList.SetGraphicsDynamicConstantBuffer( RootParameters::MaterialCB, materialProps );
+    BindSharedParameters( commandList );
 
-            using TextureType = Material::TextureType;
+    // Clear the dirty flags to avoid setting any states the next time the effect is applied.
+    m_DirtyFlags = DF_None;
+}
 
-            BindTexture( commandList, 0, m_Material->GetTexture( TextureType::Ambient ) );
-            BindTexture( commandList, 1, m_Material->GetTexture( TextureType::Emissive ) );
-            BindTexture( commandList, 2, m_Material->GetTexture( TextureType::Diffuse ) );
-            BindTexture( commandList, 3, m_Material->GetTexture( TextureType::Specular ) );
-            BindTexture( commandList, 4, m_Material->GetTexture( TextureType::SpecularPower ) );
-            BindTexture( commandList, 5, m_Material->GetTexture( TextureType::Normal ) );
-            BindTexture( commandList, 6, m_Material->GetTexture( TextureType::Bump ) );
-            BindTexture( commandList, 7, m_Material->GetTexture( TextureType::Opacity ) );
-        }
+void EffectPSO::ExecuteIndirect( CommandList& commandList, const std::shared_ptr<StructuredBuffer>& transforms,
+                                 const std::shared_ptr<Buffer>& argumentBuffer, uint32_t firstCommand,
+                                 uint32_t numCommands )
+{
+    if ( numCommands == 0 )
+    {
+        return;
+    }
+
+    BindPipelineState( commandList, m_IndirectPipelineStateObject );
+    BindSharedParameters( commandList );
+
+    commandList.SetShaderResourceView( RootParameters::Transforms, transforms,
+                                       D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE );
+
+    commandList.ExecuteIndirect( m_CommandSignature, numCommands, argumentBuffer,
+                                 static_cast<uint64_t>( firstCommand ) * m_CommandSignature->GetByteStride() );
+
+    // The draw constants, vertex buffer, and index buffer that are set by the
+    // commands are undefined after ExecuteIndirect.
+    m_DirtyFlags |= DF_Material;
+}
+
+void EffectPSO::BindSharedParameters( CommandList& commandList )
+{
+    // The material table is only uploaded if materials were added or changed
+    // (possibly by another effect that shares the material table).
+    m_MaterialTable->Commit( commandList );
+
+    if ( ( m_DirtyFlags & DF_MaterialTable ) || m_MaterialBuffer != m_MaterialTable->GetMaterialBuffer() )
+    {
+        m_MaterialBuffer = m_MaterialTable->GetMaterialBuffer();
+
+        commandList.SetShaderResourceView( RootParameters::Materials, m_MaterialBuffer,
+                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE );
+    }
+
+    if ( m_DirtyFlags & DF_MaterialTable )
+    {
+        commandList.SetBindlessDescriptorTable( RootParameters::Textures );
     }
 
     if ( m_DirtyFlags & DF_PointLights )
@@ -206,10 +308,37 @@ void EffectPSO::Apply( CommandList& commandList )
         lightProps.NumPointLights       = static_cast<uint32_t>( m_PointLights.size() );
         lightProps.NumSpotLights        = static_cast<uint32_t>( m_SpotLights.size() );
         lightProps.NumDirectionalLights = static_cast<uint32_t>( m_DirectionalLights.size() );
+        lightProps.Padding              = 0;
+
+        XMVECTOR ambient = XMVectorZero();
+        for ( const auto& l: m_PointLights )
+        {
+            ambient += XMLoadFloat4( &l.Color ) * l.Ambient;
+        }
+        for ( const auto& l: m_SpotLights )
+        {
+            ambient += XMLoadFloat4( &l.Color ) * l.Ambient;
+        }
+        XMStoreFloat4( &lightProps.Ambient, ambient );
 
         commandList.SetGraphics32BitConstants( RootParameters::LightPropertiesCB, lightProps );
     }
 
-    // Clear the dirty flags to avoid setting any states the next time the effect is applied.
-    m_DirtyFlags = DF_None;
+    if ( m_EnableLighting && ( m_DirtyFlags & DF_LightClusters ) )
+    {
+        if ( m_RebuildLightClusters )
+        {
+            BuildLightClusters();
+        }
+
+        commandList.SetGraphics32BitConstants( RootParameters::LightClustersCB, m_LightClusterBuilder.GetConstants() );
+        commandList.SetGraphicsDynamicStructuredBuffer( RootParameters::LightClusters,
+                                                        m_LightClusterBuilder.GetClusters() );
+        commandList.SetGraphicsDynamicStructuredBuffer( RootParameters::LightIndices,
+                                                        m_LightClusterBuilder.GetLightIndices() );
+    }
+
+    // The matrices and the material of the effect are not used by indirect
+    // draws. They remain dirty until the effect is applied.
+    m_DirtyFlags &= DF_Matrices | DF_Material;
 }
@@ -0,0 +1,223 @@
+#include <IndirectSceneRenderer.h>
+
+#include <Camera.h>
+
+#include <dx12lib/CommandList.h>
+#include <dx12lib/IndexBuffer.h>
+#include <dx12lib/Material.h>
+#include <dx12lib/MaterialTable.h>
+#include <dx12lib/Mesh.h>
+#include <dx12lib/Scene.h>
+#include <dx12lib/SceneNode.h>
+#include <dx12lib/StructuredBuffer.h>
+#include <dx12lib/VertexBuffer.h>
+
+using namespace dx12lib;
+using namespace DirectX;
+
+// The current scene node does not have matrices yet.
+static const uint32_t InvalidTransformIndex = 0xffffffff;
+
+IndirectSceneRenderer::IndirectSceneRenderer( std::shared_ptr<MaterialTable>                 materialTable,
+                                              const std::vector<std::shared_ptr<EffectPSO>>& effects )
+: m_MaterialTable( materialTable )
+, m_Effects( effects )
+, m_DrawBuilder( static_cast<uint32_t>( effects.size() ) )
+, m_InstanceGroupIndices( effects.size() )
+, m_ViewMatrix( XMMatrixIdentity() )
+, m_ProjectionMatrix( XMMatrixIdentity() )
+, m_OpaqueEffect( NoEffect )
+, m_TransparentEffect( NoEffect )
+, m_WorldMatrix( XMMatrixIdentity() )
+, m_NodeTransformIndex( InvalidTransformIndex )
+{}
+
+void IndirectSceneRenderer::Begin( const Camera& camera )
+{
+    m_DrawBuilder.Clear();
+    m_InstanceGroups.clear();
+    for ( auto& groupIndices: m_InstanceGroupIndices )
+    {
+        groupIndices.clear();
+    }
+    m_Instances.clear();
+    m_DirectDraws.clear();
+    m_NodeTransforms.clear();
+    m_Transforms.clear();
+    m_VertexBuffers.clear();
+    m_IndexBuffers.clear();
+
+    m_ViewMatrix       = camera.get_ViewMatrix();
+    m_ProjectionMatrix = camera.get_ProjectionMatrix();
+
+    for ( auto& effect: m_Effects )
+    {
+        effect->SetViewMatrix( m_ViewMatrix );
+        effect->SetProjectionMatrix( m_ProjectionMatrix );
+    }
+}
+
+void IndirectSceneRenderer::AddScene( Scene& scene, uint32_t opaqueEffect, uint32_t transparentEffect )
+{
+    m_OpaqueEffect      = opaqueEffect;
+    m_TransparentEffect = transparentEffect;
+
+    scene.Accept( *this );
+}
+
+void IndirectSceneRenderer::Visit( Scene& scene ) {}
+
+void IndirectSceneRenderer::Visit( SceneNode& sceneNode )
+{
+    m_WorldMatrix        = sceneNode.GetWorldTransform();
+    m_NodeTransformIndex = InvalidTransformIndex;
+}
+
+void IndirectSceneRenderer::Visit( Mesh& mesh )
+{
+    auto     material = mesh.GetMaterial();
+    uint32_t effect   = material->IsTransparent() ? m_TransparentEffect : m_OpaqueEffect;
+    if ( effect == NoEffect )
+    {
+        return;
+    }
+
+    const auto& vertexBuffers = mesh.GetVertexBuffers();
+    auto        indexBuffer   = mesh.GetIndexBuffer();
+
+    if ( !indexBuffer || vertexBuffers.size() != 1 ||
+         mesh.GetPrimitiveTopology() != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST )
+    {
+        m_DirectDraws.push_back( { &mesh, effect, m_WorldMatrix } );
+        return;
+    }
+
+    if ( m_NodeTransformIndex == InvalidTransformIndex )
+    {
+        EffectPSO::Matrices m;
+        m.ModelMatrix                     = m_WorldMatrix;
+        m.ModelViewMatrix                 = m_WorldMatrix * m_ViewMatrix;
+        m.ModelViewProjectionMatrix       = m.ModelViewMatrix * m_ProjectionMatrix;
+        m.InverseTransposeModelViewMatrix = XMMatrixTranspose( XMMatrixInverse( nullptr, m.ModelViewMatrix ) );
+
+        m_NodeTransformIndex = static_cast<uint32_t>( m_NodeTransforms.size() );
+        m_NodeTransforms.push_back( m );
+    }
+
+    // All instances of a mesh that are rendered with the same effect are
+    // merged into a single command.
+    auto& groupIndices = m_InstanceGroupIndices[effect];
+    auto  iter         = groupIndices.find( &mesh );
+    if ( iter == groupIndices.end() )
+    {
+        InstanceGroup group;
+        group.Mesh          = &mesh;
+        group.Effect        = effect;
+        group.MaterialIndex = m_MaterialTable->GetMaterialIndex( material );
+        group.NumInstances  = 0;
+        group.FirstInstance = 0;
+
+        iter = groupIndices.emplace( &mesh, static_cast<uint32_t>( m_InstanceGroups.size() ) ).first;
+        m_InstanceGroups.push_back( group );
+
+        m_VertexBuffers.insert( vertexBuffers.begin()->second );
+        m_IndexBuffers.insert( indexBuffer );
+    }
+
+    ++m_InstanceGroups[iter->second].NumInstances;
+    m_Instances.push_back( { iter->second, m_NodeTransformIndex } );
+}
+
+void IndirectSceneRenderer::BuildInstances()
+{
+    // Assign a contiguous range of the transforms buffer to each instance
+    // group and add the instanced command of the group.
+    uint32_t firstInstance = 0;
+    for ( auto& group: m_InstanceGroups )
+    {
+        group.FirstInstance = firstInstance;
+        firstInstance += group.NumInstances;
+
+        auto vertexBuffer = group.Mesh->GetVertexBuffers().begin()->second;
+        auto indexBuffer  = group.Mesh->GetIndexBuffer();
+
+        m_DrawBuilder.AddDraw( group.Effect, group.MaterialIndex, group.FirstInstance,
+                               vertexBuffer->GetVertexBufferView(), indexBuffer->GetIndexBufferView(),
+                               static_cast<uint32_t>( indexBuffer->GetNumIndices() ), group.NumInstances );
+    }
+
+    m_DrawBuilder.Build();
+
+    // Copy the matrices of the scene nodes to the transforms of the instances.
+    // FirstInstance is used as the insertion point of the next instance of the
+    // group, so it is restored afterwards.
+    m_Transforms.resize( m_Instances.size() );
+    for ( const auto& instance: m_Instances )
+    {
+        m_Transforms[m_InstanceGroups[instance.Group].FirstInstance++] = m_NodeTransforms[instance.NodeTransform];
+    }
+
+    for ( auto& group: m_InstanceGroups )
+    {
+        group.FirstInstance -= group.NumInstances;
+    }
+}
+
+void IndirectSceneRenderer::Render( CommandList& commandList )
+{
+    std::shared_ptr<StructuredBuffer> transforms;
+    std::shared_ptr<StructuredBuffer> arguments;
+
+    m_Statistics                     = Statistics();
+    m_Statistics.NumMeshInstances    = static_cast<uint32_t>( m_Instances.size() + m_DirectDraws.size() );
+    m_Statistics.NumIndirectCommands = static_cast<uint32_t>( m_InstanceGroups.size() );
+    m_Statistics.NumDirectDraws      = static_cast<uint32_t>( m_DirectDraws.size() );
+
+    if ( !m_Instances.empty() )
+    {
+        BuildInstances();
+
+        // The vertex and index buffers are not bound to the command list so
+        // they are transitioned and tracked once for all commands.
+        for ( auto& vertexBuffer: m_VertexBuffers )
+        {
+            commandList.TransitionBarrier( vertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER );
+            commandList.TrackResource( vertexBuffer );
+        }
+
+        for ( auto& indexBuffer: m_IndexBuffers )
+        {
+            commandList.TransitionBarrier( indexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER );
+            commandList.TrackResource( indexBuffer );
+        }
+
+        transforms = commandList.CopyStructuredBuffer( m_Transforms );
+        arguments  = commandList.CopyStructuredBuffer( m_DrawBuilder.GetCommands() );
+    }
+
+    for ( uint32_t i = 0; i < m_Effects.size(); ++i )
+    {
+        auto&       effect = *m_Effects[i];
+        const auto& bucket = m_DrawBuilder.GetBucket( i );
+
+        if ( bucket.NumCommands > 0 )
+        {
+            // The topology may have been changed by a direct draw of the previous effect.
+            commandList.SetPrimitiveTopology( D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+            effect.ExecuteIndirect( commandList, transforms, arguments, bucket.FirstCommand, bucket.NumCommands );
+
+            ++m_Statistics.NumExecuteIndirectCalls;
+        }
+
+        for ( const auto& draw: m_DirectDraws )
+        {
+            if ( draw.Effect == i )
+            {
+                effect.SetWorldMatrix( draw.WorldMatrix );
+                effect.SetMaterial( draw.Mesh->GetMaterial() );
+                effect.Apply( commandList );
+                draw.Mesh->Draw( commandList );
+            }
+        }
+    }
+}
@@ -2,6 +2,7 @@
 #include <GameFramework/Window.h>
 #include <dx12lib/CommandList.h>
 #include <dx12lib/Helpers.h>
+#include <dx12lib/TextureCooker.h>
 #include <AppSettings.h>
 #include <d3d12.h>
 #include <dx12lib/Material.h>
@@ -11,12 +12,15 @@
 #include <Graphics/DXRHelper.h>
 
 #include <dx12lib/PipelineStateObject.h>
+#include <dx12lib/ResourceStateTracker.h>
 #include <dx12lib/RootSignature.h>
+#include <dx12lib/Texture.h>
 #include <dx12lib/VertexTypes.h>
 #include <dx12lib/GUI.h>
 #include <DirectXMath.h>
 #include <Windows.h>
 #include <memory>
+#include <chrono>
 #include <d3dcompiler.h>
 #include <ShObjIdl.h>  // For IFileOpenDialog
 #include <shlwapi.h>
@@ -30,7 +34,7 @@ using namespace DirectX;
 
 #define ArraySize_(x) ((sizeof(x) / sizeof(0[x])) / ((size_t)(!(sizeof(x) % sizeof(0[x])))))
 
-void PathTracePipeline::Render()
+void PathTracePipeline::TracePass()
 {
 	// Don't keep tracing rays if we've hit our maximum per-pixel sample count
 	if (rtCurrSampleIdx >= uint32(AppSettings::SqrtNumSamples * AppSettings::SqrtNumSamples))
@@ -42,7 +46,8 @@ void PathTracePipeline::Render()
 	DX12::BindGlobalSRVDescriptorTable(cmdList, PTParams_StandardDescriptors, CmdListMode::Compute);
 
 	cmdList->SetComputeRootShaderResourceView(PTParams_SceneDescriptor, rtTopLevelAccelStructure.GPUAddress);
-	DX12::BindTempDescriptorTable(cmdList, &rtTarget.UAV, 1, PTParams_UAVDescriptor, CmdListMode::Compute);
+	D3D12_CPU_DESCRIPTOR_HANDLE uavs[] = { rtTarget.UAV, rtOutput.UAV };
+	DX12::BindTempDescriptorTable(cmdList, uavs, ArraySize_(uavs), PTParams_UAVDescriptor, CmdListMode::Compute);
 
 	RayTraceConstants rtConstants;
 	CXMMATRIX viewMat = m_Camera.get_ViewMatrix();
@@ -84,15 +89,44 @@ void PathTracePipeline::Render()
 	rtTarget.MakeReadableUAV(cmdList);
 	rtCurrSampleIdx += 1;
 }
-void PathTracePipeline::OnUpdate(UpdateEventArgs& e)
+void PathTracePipeline::Render()
 {
+	// Nothing is traced until the ray tracing pipeline state object is created (see PathtraceInit).
+	if (rtPSO == nullptr)
+		return;
 
-	m_SwapChain->WaitForSwapChain();
+	ID3D12GraphicsCommandList4* cmdList = DX12::CmdList;
+	DX12::TransitionResource(cmdList, rtOutput.Texture.Resource, D3D12_RESOURCE_STATE_COPY_SOURCE,
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
+	// In progressive mode the frame scheduler allows several samples per frame
+	// while the camera is static.
+	const uint32 numPasses = GameFramework::Get().GetFrameScheduler().GetNumProgressivePasses();
+	for (uint32 pass = 0; pass < numPasses; ++pass)
+		TracePass();
+
+	DX12::TransitionResource(cmdList, rtOutput.Texture.Resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+		D3D12_RESOURCE_STATE_COPY_SOURCE);
+}
+void PathTracePipeline::OnUpdate(UpdateEventArgs& e)
+{
 	// Process keyboard, mouse, and pad input.
 	GameFramework::Get().ProcessInput();
 	m_CameraController.Update(e);
 
+	// Restart the accumulation when the camera moves. While the camera is
+	// static, the frame scheduler keeps accumulating samples within its
+	// latency budget.
+	XMFLOAT4X4 currentViewMatrix;
+	XMStoreFloat4x4(&currentViewMatrix, m_Camera.get_ViewMatrix());
+	bool cameraMoved = std::memcmp(&currentViewMatrix, &m_PreviousViewMatrix, sizeof(XMFLOAT4X4)) != 0;
+	if (cameraMoved || AppSettings::AlwaysResetPathTrace)
+	{
+		rtCurrSampleIdx = 0;
+		m_PreviousViewMatrix = currentViewMatrix;
+	}
+	GameFramework::Get().GetFrameScheduler().SetAccumulating(!cameraMoved && !AppSettings::AlwaysResetPathTrace);
+
 	// Move the Axis model to the focal point of the camera.
 	XMVECTOR cameraPoint = m_Camera.get_FocalPoint();
 	XMMATRIX translationMatrix = XMMatrixTranslationFromVector(cameraPoint);
@@ -127,7 +161,18 @@ void PathTracePipeline::OnUpdate(UpdateEventArgs& e)
 	//	l.Color = XMFLOAT4(LightColors[i]);
 	//}
 
+	DX12::BeginFrame();
 	Render();
+	// Submit the trace passes. EndFrame signals the frame fence after the command list.
+	DX12::EndFrame(nullptr, 0);
+
+	// The graphics queue of DX12 is the direct queue of the device, so the copy
+	// to the back buffer runs after the trace passes.
+	m_SwapChain->Present(m_OutputTexture);
+
+	// The frame fence lets the frame scheduler measure the GPU time of a pass,
+	// which bounds the passes of the next frame.
+	GameFramework::Get().GetFrameScheduler().Present(DX12::CurrentCPUFrame);
 }
 
 void PathTracePipeline::OnKeyPressed(KeyEventArgs& e)
@@ -170,15 +215,29 @@ void PathTracePipeline::OnResize(ResizeEventArgs& e)
 	m_RenderTarget.Resize(m_Width, m_Height);
 
 	m_SwapChain->Resize(m_Width, m_Height);
+
+	// Restart the accumulation in targets of the new size.
+	DX12::FlushGPU();
+	m_OutputTexture.reset();
+	CreateRenderTargets();
+	rtCurrSampleIdx = 0;
 }
 
-PathTracePipeline::PathTracePipeline(std::shared_ptr<dx12lib::Device> device, int width, int height)
-	:m_Device(device), m_pPreviousCommandList(nullptr), m_Width(width)
+PathTracePipeline::PathTracePipeline(const std::wstring& name, int width, int height)
+	:m_pPreviousCommandList(nullptr), m_Width(width)
 	, m_Height(height), m_CameraController(m_Camera), m_CancelLoading(false)
 {
+	m_Logger = GameFramework::Get().CreateLogger("PathTrace");
+
 	//Initiate Window
+	m_Window = GameFramework::Get().CreateWindow(name, width, height);
 	m_Window->Update += UpdateEvent::slot(&PathTracePipeline::OnUpdate, this);
+	m_Window->Resize += ResizeEvent::slot(&PathTracePipeline::OnResize, this);
 	m_Window->KeyPressed += KeyboardEvent::slot(&PathTracePipeline::OnKeyPressed, this);
+
+	XMStoreFloat4x4(&m_PreviousViewMatrix, XMMatrixIdentity());
+	// Accumulate samples while the camera is static.
+	GameFramework::Get().GetFrameScheduler().SetProgressive(true);
 }
 
 struct HitGroupRecord
@@ -189,6 +248,7 @@ struct HitGroupRecord
 void PathTracePipeline::LoadContent()
 {
 	m_Device = dx12lib::Device::Create();
+	m_Device->SetTextureCooker(m_TextureCooker);
 	m_Logger->info(L"Device created: {}", m_Device->GetDescription());
 
 	m_SwapChain = m_Device->CreateSwapChain(m_Window->GetWindowHandle(), DXGI_FORMAT_R8G8B8A8_UNORM);
@@ -198,6 +258,22 @@ void PathTracePipeline::LoadContent()
 
 	GameFramework::Get().WndProcHandler += WndProcEvent::slot(&GUI::WndProcHandler, m_GUI);
 
+	// The ray tracing passes are recorded with DX12 (SampleFramework12). It shares
+	// the device and the direct queue so that the trace passes, the copy of the
+	// result to the back buffer, and the present are ordered on a single queue.
+	auto& directQueue = m_Device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+	ComPtr<ID3D12Device5> d3d12Device;
+	ThrowIfFailed(m_Device->GetD3D12Device().As(&d3d12Device));
+	DX12::Initialize(d3d12Device.Get(), directQueue.GetD3D12CommandQueue().Get());
+
+	// Limit the number of frames in flight with the frame fence of DX12, which
+	// is signaled after the trace passes of a frame are submitted.
+	GameFramework::Get().GetFrameScheduler().SetFrameFence(
+		[](uint64_t frame) { return DX12::FrameCompleted(frame); },
+		[](uint64_t frame) { DX12::WaitForFrame(frame); });
+
+	CreateRenderTargets();
+
 	// Start the loading task to perform async loading of the scene file.
 	m_LoadingTask = std::async(std::launch::async, std::bind(&PathTracePipeline::InitScene, this,
 		L"Assets/Models/crytek-sponza/sponza_nobanner.obj"));
@@ -264,7 +340,20 @@ bool PathTracePipeline::InitScene(const std::wstring& sceneFile)
 	auto& commandQueue = m_Device->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
 	auto  commandList = commandQueue.GetCommandList();
 
+	auto startTime = std::chrono::high_resolution_clock::now();
 	auto scene = commandList->LoadSceneFromFile(sceneFile, std::bind(&PathTracePipeline::LoadingProgress, this, _1));
+	commandQueue.WaitForFenceValue(commandQueue.ExecuteCommandList(commandList));
+
+	// Report the load time and how much of it was spent cooking textures.
+	auto loadTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+	m_Logger->info("Loaded scene in {:.2f} s ({} textures)", loadTime, m_TextureCooker ? "cooked" : "uncompressed");
+	if (m_TextureCooker)
+	{
+		auto cookStats = m_TextureCooker->GetStatistics();
+		m_Logger->info("Cooked {} textures ({} cache hits) in {:.2f} s: {:.2f} MB -> {:.2f} MB",
+			cookStats.NumTexturesCooked, cookStats.NumCacheHits, cookStats.CookTime / 1000.0,
+			cookStats.NumSourceBytes / (1024.0 * 1024.0), cookStats.NumCookedBytes / (1024.0 * 1024.0));
+	}
 
 	const uint64 currSceneIdx = uint64(AppSettings::CurrentScene);
 	AppSettings::EnableWhiteFurnaceMode.SetValue(currSceneIdx == uint64(Scenes::TestBuilding));
@@ -353,13 +442,15 @@ void PathTracePipeline::PathtraceInit()
 	UINT compileFlags = 0;
 #endif
 
-	//Read shader
+	//Read shader. The byte code is read by CreatePathTracePipelineStateObject, after the batch is compiled.
+	BeginShaderBatch();
 	pathTraceShader= CompileFromFile(L"pathtrace.hlsl", nullptr, ShaderType::Library);
+	EndShaderBatch();
 	//======== Raytrace root signature =============
 
 	D3D12_DESCRIPTOR_RANGE1 uavRanges[1] = {};
 	uavRanges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
-	uavRanges[0].NumDescriptors = 1;
+	uavRanges[0].NumDescriptors = 2;
 	uavRanges[0].BaseShaderRegister = 0;
 	uavRanges[0].RegisterSpace = 0;
 	uavRanges[0].OffsetInDescriptorsFromTableStart = 0;
@@ -447,6 +538,17 @@ uint32_t PathTracePipeline::Run()
 	auto retCode = GameFramework::Get().Run();
 	// Make sure the loading task is finished
 	m_LoadingTask.get();
+	// The frame scheduler must not reference the frame fence after DX12 is shut down.
+	GameFramework::Get().GetFrameScheduler().SetFrameFence(nullptr, nullptr);
+
+	DX12::FlushGPU();
+	m_OutputTexture.reset();
+	rtTarget.Shutdown();
+	rtOutput.Shutdown();
+	depthBuffer.Shutdown();
+	spotLightClusterBuffer.Shutdown();
+	DX12::Shutdown();
+
 	return retCode;
 }
 void PathTracePipeline::CreateRenderTargets()
@@ -506,6 +608,25 @@ void PathTracePipeline::CreateRenderTargets()
 		rtTarget.Initialize(rtInit);
 	}
 
+	{
+		auto backBuffer = m_SwapChain->GetRenderTarget().GetTexture(AttachmentPoint::Color0);
+
+		RenderTextureInit rtInit;
+		rtInit.Width = width;
+		rtInit.Height = height;
+		rtInit.Format = backBuffer->GetD3D12ResourceDesc().Format;
+		rtInit.CreateUAV = true;
+		rtInit.CreateRTV = false;
+		rtInit.InitialState = D3D12_RESOURCE_STATE_COPY_SOURCE;
+		rtInit.Name = L"RT Output";
+		rtOutput.Initialize(rtInit);
+
+		// The swap chain copies the output to the back buffer.
+		dx12lib::ResourceStateTracker::AddGlobalResourceState(rtOutput.Texture.Resource, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		m_OutputTexture = m_Device->CreateTexture(rtOutput.Texture.Resource);
+		m_OutputTexture->SetName(L"RT Output");
+	}
+
 }
 
 void PathTracePipeline::CreatePathTracePipelineStateObject()
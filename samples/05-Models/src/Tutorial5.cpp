@@ -1,22 +1,28 @@
 #include <Tutorial5.h>
 
 #include <EffectPSO.h>
+#include <IndirectSceneRenderer.h>
 #include <SceneVisitor.h>
 
 #include <GameFramework/Window.h>
 
 #include <dx12lib/CommandList.h>
 #include <dx12lib/CommandQueue.h>
+#include <dx12lib/CommandRecorder.h>
 #include <dx12lib/Device.h>
 #include <dx12lib/GUI.h>
 #include <dx12lib/Helpers.h>
 #include <dx12lib/Material.h>
+#include <dx12lib/MaterialTable.h>
 #include <dx12lib/Mesh.h>
 #include <dx12lib/RootSignature.h>
 #include <dx12lib/Scene.h>
 #include <dx12lib/SceneNode.h>
+#include <dx12lib/StagingAllocator.h>
+#include <dx12lib/StreamingUploadQueue.h>
 #include <dx12lib/SwapChain.h>
 #include <dx12lib/Texture.h>
+#include <dx12lib/TextureCooker.h>
 #include <assert.h>
 #include <assimp/DefaultLogger.hpp>
 
@@ -26,6 +32,8 @@
 #include <d3dx12.h>
 
 #include <ShObjIdl.h>  // For IFileOpenDialog
+#include <chrono>
+#include <limits>
 #include <shlwapi.h>
 #include <regex>
 #include <PCH.h>
@@ -41,6 +49,15 @@ using namespace dx12lib;
 
 //============= End ==================
 
+// The effects of the indirect scene renderer in the order they are rendered.
+// Transparent geometry is rendered last.
+enum IndirectEffect : uint32_t
+{
+    Opaque,
+    Unlit,
+    Transparent
+};
+
 // Builds a look-at (world) matrix from a point, up and direction vectors.
 XMMATRIX XM_CALLCONV LookAtMatrix( FXMVECTOR Position, FXMVECTOR Direction, FXMVECTOR Up )
 {
@@ -67,8 +84,8 @@ template<spdlog::level::level_enum lvl>
 class LogStream : public Assimp::LogStream
 {
 public:
-    LogStream( Logger logger )
-    : m_Logger( logger )
+    LogStream( LogChannel& logChannel )
+    : m_LogChannel( logChannel )
     {}
 
     virtual void write( const char* message ) override
@@ -79,12 +96,12 @@ public:
 
         if ( match.size() > 1 )
         {
-            m_Logger->log( lvl, match.str( 1 ) );
+            m_LogChannel.log( lvl, "{}", match.str( 1 ) );
         }
     }
 
 private:
-    Logger m_Logger;
+    LogChannel& m_LogChannel;
 };
 
 using DebugLogStream = LogStream<spdlog::level::debug>;
@@ -96,12 +113,14 @@ Tutorial5::Tutorial5( const std::wstring& name, int width, int height, bool vSyn
 : m_ScissorRect { 0, 0, LONG_MAX, LONG_MAX }
 , m_Viewport( CD3DX12_VIEWPORT( 0.0f, 0.0f, static_cast<float>( width ), static_cast<float>( height ) ) )
 , m_CameraController( m_Camera )
+, m_UseIndirectDraws( true )
 , m_AnimateLights( false )
 , m_Fullscreen( false )
 , m_AllowFullscreenToggle( true )
 , m_ShowFileOpenDialog( false )
 , m_CancelLoading( false )
 , m_ShowControls( true )
+, m_ShowStatistics( false )
 , m_Width( width )
 , m_Height( height )
 , m_IsLoading( true )
@@ -112,8 +131,8 @@ Tutorial5::Tutorial5( const std::wstring& name, int width, int height, bool vSyn
 #endif
     // Create a spdlog logger for the demo.
     m_Logger = GameFramework::Get().CreateLogger( "05-Models" );
-    // Create logger for assimp.
-    auto assimpLogger = GameFramework::Get().CreateLogger( "ASSIMP" );
+    // Create log channel for assimp (assimp logs in bursts while loading a scene).
+    auto& assimpLogger = GameFramework::Get().CreateLogChannel( "ASSIMP" );
 
     // Setup assimp logging.
 #if defined( _DEBUG )
@@ -155,6 +174,11 @@ uint32_t Tutorial5::Run()
 
     auto retCode = GameFramework::Get().Run();
 
+    // No more frames are presented, so the textures of a scene that is still
+    // loading are streamed without a frame budget.
+    m_StreamingUploadQueue->SetFrameBudget( std::numeric_limits<int64_t>::max() );
+    m_StreamingUploadQueue->BeginFrame();
+
     // Make sure the loading task is finished
     m_LoadingTask.get();
 
@@ -178,6 +202,14 @@ bool Tutorial5::LoadScene( const std::wstring& sceneFile )
     m_IsLoading     = true;
     m_CancelLoading = false;
 
+    // Measure how long it takes to load the scene (with or without cooked textures).
+    auto startTime = std::chrono::high_resolution_clock::now();
+    if ( m_TextureCooker )
+    {
+        m_TextureCooker->ResetStatistics();
+    }
+    m_StreamingUploadQueue->ResetStatistics();
+
     auto& commandQueue = m_Device->GetCommandQueue( D3D12_COMMAND_LIST_TYPE_COPY );
     auto  commandList  = commandQueue.GetCommandList();
 
@@ -216,6 +248,39 @@ bool Tutorial5::LoadScene( const std::wstring& sceneFile )
     // Ensure that the scene is completely loaded before rendering.
     commandQueue.Flush();
 
+    auto loadTime = std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - startTime ).count();
+    m_Logger->info( "Loaded {} in {:.2f} s ({} textures)", ConvertString( sceneFile ), loadTime,
+                    m_TextureCooker ? "cooked" : "uncompressed" );
+
+    // Report how much of the load time was spent cooking textures (textures
+    // that are in the cache are only loaded).
+    if ( m_TextureCooker )
+    {
+        auto cookStats = m_TextureCooker->GetStatistics();
+        m_Logger->info( "Cooked {} textures ({} cache hits, {} already compressed) in {:.2f} s (mips {:.2f} s, "
+                        "compression {:.2f} s): {:.2f} MB -> {:.2f} MB",
+                        cookStats.NumTexturesCooked, cookStats.NumCacheHits, cookStats.NumPassThrough,
+                        cookStats.CookTime / 1000.0, cookStats.MipTime / 1000.0, cookStats.CompressTime / 1000.0,
+                        cookStats.NumSourceBytes / ( 1024.0 * 1024.0 ),
+                        cookStats.NumCookedBytes / ( 1024.0 * 1024.0 ) );
+    }
+
+    // Report how the scene's buffers and textures were uploaded.
+    auto stagingStats = m_Device->GetStagingAllocator().GetStatistics();
+    m_Logger->info( "Uploaded {} resources ({:.2f} MB) in {} batches using {} upload heaps ({} recycled): {:.2f} MB/s",
+                    stagingStats.NumUploads, stagingStats.BytesUploaded / ( 1024.0 * 1024.0 ), stagingStats.NumBatches,
+                    stagingStats.NumUploadResourcesCreated, stagingStats.NumChunksRecycled,
+                    stagingStats.GetThroughputMBps() );
+
+    // Report how the textures were streamed while the loading screen was shown.
+    auto streamingStats = m_StreamingUploadQueue->GetStatistics();
+    m_Logger->info( "Streamed {} textures ({:.2f} MB) over {} frames: {:.2f} MB/frame average, {:.2f} MB/frame max "
+                    "({:.2f} MB budget)",
+                    streamingStats.NumCompleted, streamingStats.TotalBytes / ( 1024.0 * 1024.0 ),
+                    streamingStats.NumFrames, streamingStats.GetAverageBytesPerFrame() / ( 1024.0 * 1024.0 ),
+                    streamingStats.MaxBytesPerFrame / ( 1024.0 * 1024.0 ),
+                    streamingStats.FrameBudget / ( 1024.0 * 1024.0 ) );
+
     // Loading is finished.
     m_IsLoading = false;
 
@@ -225,14 +290,26 @@ bool Tutorial5::LoadScene( const std::wstring& sceneFile )
 void Tutorial5::LoadContent()
 {
     m_Device = Device::Create();
+    m_Device->SetTextureCooker( m_TextureCooker );
     m_Logger->info( L"Device created: {}", m_Device->GetDescription() );
 
+    // The textures of the scenes are streamed on the copy queue so that loading
+    // a scene doesn't cause frame spikes (see OnRender).
+    m_StreamingUploadQueue = m_Device->CreateStreamingUploadQueue();
+    m_Device->SetStreamingUploadQueue( m_StreamingUploadQueue );
+
     m_SwapChain = m_Device->CreateSwapChain( m_Window->GetWindowHandle(), DXGI_FORMAT_R8G8B8A8_UNORM );
     m_GUI       = m_Device->CreateGUI( m_Window->GetWindowHandle(), m_SwapChain->GetRenderTarget() );
 
     // This magic here allows ImGui to process window messages.
     GameFramework::Get().WndProcHandler += WndProcEvent::slot( &GUI::WndProcHandler, m_GUI );
 
+    // Limit the number of frames in flight on the direct command queue.
+    auto& directQueue = m_Device->GetCommandQueue( D3D12_COMMAND_LIST_TYPE_DIRECT );
+    GameFramework::Get().GetFrameScheduler().SetFrameFence(
+        [&directQueue]( uint64_t fenceValue ) { return directQueue.IsFenceComplete( fenceValue ); },
+        [&directQueue]( uint64_t fenceValue ) { directQueue.WaitForFenceValue( fenceValue ); } );
+
     // Start the loading task to perform async loading of the scene file.
     m_LoadingTask = std::async( std::launch::async, std::bind( &Tutorial5::LoadScene, this,
                                                                L"Assets/Models/crytek-sponza/sponza_nobanner.obj" ) );
@@ -247,10 +324,17 @@ void Tutorial5::LoadContent()
 
     auto fence = commandQueue.ExecuteCommandList( commandList );
 
+    // The PSOs share a single material table.
+    m_MaterialTable = m_Device->CreateMaterialTable();
+
     // Create a PSOs
-    m_LightingPSO = std::make_shared<EffectPSO>( m_Device, true, false );
-    m_DecalPSO    = std::make_shared<EffectPSO>( m_Device, true, true );
-    m_UnlitPSO    = std::make_shared<EffectPSO>( m_Device, false, false );
+    m_LightingPSO = std::make_shared<EffectPSO>( m_Device, m_MaterialTable, true, false );
+    m_DecalPSO    = std::make_shared<EffectPSO>( m_Device, m_MaterialTable, true, true );
+    m_UnlitPSO    = std::make_shared<EffectPSO>( m_Device, m_MaterialTable, false, false );
+
+    // The effects are rendered in this order (see IndirectEffect).
+    m_IndirectSceneRenderer = std::make_shared<IndirectSceneRenderer>(
+        m_MaterialTable, std::vector<std::shared_ptr<EffectPSO>> { m_LightingPSO, m_UnlitPSO, m_DecalPSO } );
 
     // Create a color buffer with sRGB for gamma correction.
     DXGI_FORMAT backBufferFormat  = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
@@ -290,7 +374,11 @@ void Tutorial5::LoadContent()
     commandQueue.WaitForFenceValue( fence );
 }
 
-void Tutorial5::UnloadContent() {}
+void Tutorial5::UnloadContent()
+{
+    // The frame scheduler must not reference the command queue after the device is released.
+    GameFramework::Get().GetFrameScheduler().SetFrameFence( nullptr, nullptr );
+}
 
 void Tutorial5::OnUpdate( UpdateEventArgs& e )
 {
@@ -318,8 +406,6 @@ void Tutorial5::OnUpdate( UpdateEventArgs& e )
         OpenFile();
     }
 
-    m_SwapChain->WaitForSwapChain();
-
     // Process keyboard, mouse, and pad input.
     GameFramework::Get().ProcessInput();
     m_CameraController.Update( e );
@@ -423,12 +509,22 @@ void Tutorial5::OnRender()
         commandList->SetRenderTarget( m_RenderTarget );
 
         // Render the scene.
-        // Opaque pass.
-        m_Scene->Accept( opaquePass );
-        m_Axis->Accept( unlitPass );
+        if ( m_UseIndirectDraws )
+        {
+            m_IndirectSceneRenderer->Begin( m_Camera );
+            m_IndirectSceneRenderer->AddScene( *m_Scene, IndirectEffect::Opaque, IndirectEffect::Transparent );
+            m_IndirectSceneRenderer->AddScene( *m_Axis, IndirectEffect::Unlit );
+            m_IndirectSceneRenderer->Render( *commandList );
+        }
+        else
+        {
+            // Opaque pass.
+            m_Scene->Accept( opaquePass );
+            m_Axis->Accept( unlitPass );
 
-        // Transparent pass.
-        m_Scene->Accept( transparentPass );
+            // Transparent pass.
+            m_Scene->Accept( transparentPass );
+        }
 
         MaterialProperties lightMaterial = Material::Black;
         for ( const auto& l: m_PointLights )
@@ -470,6 +566,10 @@ void Tutorial5::OnRender()
     commandQueue.ExecuteCommandList( commandList );
 
     m_SwapChain->Present();
+    GameFramework::Get().GetFrameScheduler().Present( commandQueue.Signal() );
+
+    // Replenish the streaming budget for the next frame.
+    m_StreamingUploadQueue->BeginFrame();
 }
 
 void Tutorial5::OnKeyPressed( KeyEventArgs& e )
@@ -509,6 +609,14 @@ void Tutorial5::OnKeyPressed( KeyEventArgs& e )
                 OpenFile();
             }
             break;
+        case KeyCode::F12:
+            // Capture the next frame (replay the capture with 06-Replay).
+            if ( !m_Device->GetCommandRecorder().IsCapturing() )
+            {
+                m_Device->GetCommandRecorder().BeginCapture( L"capture.dxcs" );
+                m_Logger->info( "Capturing the next frame to capture.dxcs" );
+            }
+            break;
         }
     }
 }
@@ -603,6 +711,7 @@ void Tutorial5::OnGUI( const std::shared_ptr<CommandList>& commandList, const Re
         if ( ImGui::BeginMenu( "View" ) )
         {
             ImGui::MenuItem( "Controls", nullptr, &m_ShowControls );
+            ImGui::MenuItem( "Statistics", nullptr, &m_ShowStatistics );
 
             ImGui::EndMenu();
         }
@@ -624,6 +733,7 @@ void Tutorial5::OnGUI( const std::shared_ptr<CommandList>& commandList, const Re
             }
 
             ImGui::MenuItem( "Animate Lights", "Space", &m_AnimateLights );
+            ImGui::MenuItem( "Indirect Draws", nullptr, &m_UseIndirectDraws );
 
             bool invertY = m_CameraController.IsInverseY();
             if ( ImGui::MenuItem( "Inverse Y", nullptr, &invertY ) )
@@ -681,6 +791,36 @@ void Tutorial5::OnGUI( const std::shared_ptr<CommandList>& commandList, const Re
 
         ImGui::End();
     }
+
+    if ( m_ShowStatistics && ImGui::Begin( "Statistics", &m_ShowStatistics ) )
+    {
+        if ( m_UseIndirectDraws )
+        {
+            const auto& statistics = m_IndirectSceneRenderer->GetStatistics();
+
+            ImGui::Text( "Mesh instances: %u", statistics.NumMeshInstances );
+            ImGui::Text( "Draws: %u", statistics.GetNumDraws() );
+            ImGui::BulletText( "Instanced indirect draws: %u", statistics.NumIndirectCommands );
+            ImGui::BulletText( "Direct draws: %u", statistics.NumDirectDraws );
+            ImGui::Text( "ExecuteIndirect calls: %u", statistics.NumExecuteIndirectCalls );
+        }
+        else
+        {
+            ImGui::Text( "Enable indirect draws (Options menu) to merge mesh instances." );
+        }
+
+        const auto& frameStatistics = GameFramework::Get().GetFrameScheduler().GetStatistics();
+
+        ImGui::Separator();
+        ImGui::Text( "CPU frame time: %.2f ms", frameStatistics.CpuFrameTime.Average * 1000.0 );
+        ImGui::Text( "GPU frame time: %.2f ms", frameStatistics.GpuFrameTime.Average * 1000.0 );
+        ImGui::Text( "Present interval: %.2f ms", frameStatistics.PresentInterval.Average * 1000.0 );
+        ImGui::Text( "Input latency: %.2f ms (max %.2f ms)", frameStatistics.InputLatency.Average * 1000.0,
+                     frameStatistics.InputLatency.Max * 1000.0 );
+        ImGui::Text( "Frames in flight: %u", frameStatistics.NumFramesInFlight );
+
+        ImGui::End();
+    }
     m_GUI->Render( commandList, renderTarget );
 }
 
@@ -2,6 +2,7 @@
 #include <pathtrace.h>
 
 #include <dx12lib/Device.h>
+#include <dx12lib/TextureCooker.h>
 
 #include <shellapi.h> // For CommandLineToArgvW
 
@@ -18,6 +19,14 @@ int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdLi
     WCHAR path[MAX_PATH];
     int     argc = 0;
     LPWSTR* argv = ::CommandLineToArgvW( lpCmdLine, &argc );
+
+    // The rasterizer (Tutorial5) runs unless the path tracer is selected.
+    bool pathTrace = false;
+
+    // Textures are loaded uncompressed unless they are cooked.
+    bool                cookTextures          = false;
+    std::wstring        textureCacheDirectory = L"TextureCache";
+    TextureCookSettings textureCookSettings;
     if ( argv )
     {
         for ( int i = 0; i < argc; ++i )
@@ -28,16 +37,52 @@ int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdLi
                 ::wcscpy_s( path, argv[++i] );
                 ::SetCurrentDirectoryW( path );
             }
+            // -pathtrace Run the path tracer instead of the rasterizer.
+            else if ( ::wcscmp( argv[i], L"-pathtrace" ) == 0 )
+            {
+                pathTrace = true;
+            }
+            // -cook Load block compressed textures (cooked on first use, see TextureCooker.h).
+            else if ( ::wcscmp( argv[i], L"-cook" ) == 0 )
+            {
+                cookTextures = true;
+            }
+            // -cache Specify the directory to store the cooked textures in (implies -cook).
+            else if ( ::wcscmp( argv[i], L"-cache" ) == 0 && i + 1 < argc )
+            {
+                cookTextures          = true;
+                textureCacheDirectory = argv[++i];
+            }
+            // -fastcook Use BC1/BC3 instead of BC7 for albedo textures (implies -cook).
+            else if ( ::wcscmp( argv[i], L"-fastcook" ) == 0 )
+            {
+                cookTextures                        = true;
+                textureCookSettings.FastCompression = true;
+            }
         }
         ::LocalFree( argv );
     }
 
+    // The cache directory is relative to the working directory.
+    std::shared_ptr<TextureCooker> textureCooker;
+    if ( cookTextures )
+    {
+        textureCooker = std::make_shared<TextureCooker>( textureCacheDirectory, textureCookSettings );
+    }
+
     int retCode = 0;
 
     GameFramework::Create( hInstance );
+    if ( pathTrace )
+    {
+        auto demo = std::make_unique<PathTracePipeline>( L"Models", 1920, 1080 );
+        demo->SetTextureCooker( textureCooker );
+        retCode = demo->Run();
+    }
+    else
     {
-      // auto demo = std::make_unique<Tutorial5>( L"Models", 1920, 1080 );
-       auto demo = std::make_unique<PathTracePipeline>(L"Models", 1920, 1080);
+        auto demo = std::make_unique<Tutorial5>( L"Models", 1920, 1080 );
+        demo->SetTextureCooker( textureCooker );
         retCode = demo->Run();
     }
     // Destroy game framework resource.
@@ -0,0 +1,184 @@
+/**
+ * Replays a capture that was recorded with the CommandRecorder and reports the
+ * CPU cost of recording and submitting the captured frames.
+ *
+ * Usage: 06-Replay <capture file> [-frames <count>] [-loops <count>] [-null]
+ *
+ * -frames The number of frames of the capture to replay (0 replays all frames).
+ * -loops  The number of times the frames are replayed. The first loop is a
+ *         warm-up loop (pipeline states and descriptor heaps are created on
+ *         first use) and is not included in the results.
+ * -null   Replay on the null device (see NullDevice.h). Measures the CPU cost
+ *         of dx12lib without the driver and reports the API calls per frame.
+ */
+
+#include <dx12lib/CommandStreamPlayer.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/NullDevice.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cwchar>
+#include <exception>
+#include <string>
+#include <vector>
+
+using namespace dx12lib;
+
+static void PrintUsage()
+{
+    std::wprintf( L"Usage: 06-Replay <capture file> [-frames <count>] [-loops <count>] [-null]\n" );
+}
+
+int wmain( int argc, wchar_t* argv[] )
+{
+    std::wstring fileName;
+    uint32_t     numFrames = 0;
+    uint32_t     numLoops  = 4;
+    bool         useNull   = false;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( ::wcscmp( argv[i], L"-frames" ) == 0 && i + 1 < argc )
+        {
+            numFrames = static_cast<uint32_t>( std::wcstoul( argv[++i], nullptr, 10 ) );
+        }
+        else if ( ::wcscmp( argv[i], L"-loops" ) == 0 && i + 1 < argc )
+        {
+            numLoops = static_cast<uint32_t>( std::wcstoul( argv[++i], nullptr, 10 ) );
+        }
+        else if ( ::wcscmp( argv[i], L"-null" ) == 0 )
+        {
+            useNull = true;
+        }
+        else
+        {
+            fileName = argv[i];
+        }
+    }
+
+    if ( fileName.empty() )
+    {
+        PrintUsage();
+        return 1;
+    }
+
+#if defined( _DEBUG )
+    // Always enable the Debug layer before doing anything with DX12.
+    if ( !useNull )
+    {
+        Device::EnableDebugLayer();
+    }
+#endif
+
+    int retCode = 0;
+
+    try
+    {
+        auto device = useNull ? Device::CreateNull() : Device::Create();
+        std::wprintf( L"Device: %s\n", device->GetDescription().c_str() );
+
+        {
+            CommandStreamPlayer player( *device );
+            player.Load( fileName );
+
+            if ( numFrames == 0 || numFrames > player.GetNumFrames() )
+            {
+                numFrames = player.GetNumFrames();
+            }
+            numLoops = std::max( numLoops, 2u );
+
+            std::wprintf( L"Replaying %u of %u frames (%u loops)\n", numFrames, player.GetNumFrames(), numLoops );
+
+            std::vector<double> cpuTimes;
+            double              waitTime = 0.0;
+
+            auto nullDeviceCounters = device->GetNullDeviceCounters();
+
+            CommandStreamPlayer::FrameStatistics totals = {};
+            for ( uint32_t loop = 0; loop < numLoops; ++loop )
+            {
+                // Only count the API calls after the warm-up loop.
+                if ( loop == 1 && nullDeviceCounters )
+                {
+                    nullDeviceCounters->Reset();
+                }
+
+                for ( uint32_t frame = 0; frame < numFrames; ++frame )
+                {
+                    auto statistics = player.ReplayFrame( frame );
+
+                    // Skip the warm-up loop.
+                    if ( loop == 0 )
+                    {
+                        continue;
+                    }
+
+                    cpuTimes.push_back( statistics.CpuTime );
+                    waitTime += statistics.WaitTime;
+
+                    totals.NumCommandLists += statistics.NumCommandLists;
+                    totals.NumCommands += statistics.NumCommands;
+                    totals.NumDraws += statistics.NumDraws;
+                    totals.NumDispatches += statistics.NumDispatches;
+                    totals.NumSkippedCommands += statistics.NumSkippedCommands;
+                    totals.NumUploadBytes += statistics.NumUploadBytes;
+                }
+            }
+            player.Flush();
+
+            if ( !cpuTimes.empty() )
+            {
+                std::sort( cpuTimes.begin(), cpuTimes.end() );
+
+                double totalCpuTime = 0.0;
+                for ( auto cpuTime: cpuTimes )
+                {
+                    totalCpuTime += cpuTime;
+                }
+
+                double numReplayedFrames = static_cast<double>( cpuTimes.size() );
+
+                std::wprintf( L"CPU time (ms):  avg %.3f, min %.3f, median %.3f, max %.3f\n",
+                              totalCpuTime / numReplayedFrames * 1000.0, cpuTimes.front() * 1000.0,
+                              cpuTimes[cpuTimes.size() / 2] * 1000.0, cpuTimes.back() * 1000.0 );
+                std::wprintf( L"Wait time (ms): avg %.3f\n", waitTime / numReplayedFrames * 1000.0 );
+                std::wprintf( L"Per frame:      %.1f command lists, %.1f commands, %.1f draws, %.1f dispatches, "
+                              L"%.1f KiB uploaded\n",
+                              totals.NumCommandLists / numReplayedFrames, totals.NumCommands / numReplayedFrames,
+                              totals.NumDraws / numReplayedFrames, totals.NumDispatches / numReplayedFrames,
+                              totals.NumUploadBytes / numReplayedFrames / 1024.0 );
+
+                if ( totals.NumSkippedCommands > 0 )
+                {
+                    std::wprintf( L"Skipped %.1f commands per frame (objects that could not be created).\n",
+                                  totals.NumSkippedCommands / numReplayedFrames );
+                }
+
+                if ( nullDeviceCounters )
+                {
+                    std::wprintf( L"API calls per frame:\n" );
+                    for ( int i = 0; i < static_cast<int>( NullDeviceCounter::NumCounters ); ++i )
+                    {
+                        auto counter = static_cast<NullDeviceCounter>( i );
+                        auto value   = nullDeviceCounters->Get( counter );
+                        if ( counter != NullDeviceCounter::NumCPUHeapBytes && value > 0 )
+                        {
+                            std::wprintf( L"  %-24S %.1f\n", NullDeviceCounters::GetName( counter ),
+                                          value / numReplayedFrames );
+                        }
+                    }
+                    std::wprintf( L"CPU heap memory: %.1f MiB\n",
+                                  nullDeviceCounters->Get( NullDeviceCounter::NumCPUHeapBytes ) / ( 1024.0 * 1024.0 ) );
+                }
+            }
+        }
+    }
+    catch ( const std::exception& e )
+    {
+        std::fprintf( stderr, "Replay failed: %s\n", e.what() );
+        retCode = 1;
+    }
+
+    return retCode;
+}
@@ -0,0 +1,266 @@
+/**
+ * Cooks textures with the TextureCooker and compares the cost of loading the
+ * raw textures (decoding, uploading uncompressed and generating the mips on
+ * the GPU) with the cost of loading the cooked (block compressed) textures.
+ *
+ * Usage: 07-TextureCook <texture files or directories> [-usage <usage>] [-cache <directory>] [-clean]
+ *                       [-fast] [-threads <count>] [-cpumips] [-null]
+ *
+ * -usage   How the textures are used: albedo (default), normal, mask, hdr or bump.
+ * -cache   The directory to store the cooked textures in (TextureCache by default).
+ * -clean   Delete the cooked textures in the cache directory first so that all
+ *          textures are cooked.
+ * -fast    Use BC1/BC3 instead of BC7 for albedo textures.
+ * -threads The number of threads used to compress (all hardware threads by default).
+ * -cpumips Generate the mips of the raw textures on the CPU (with the MipGenerator)
+ *          instead of on the GPU.
+ * -null    Load the textures on the null device (see NullDevice.h). Measures the
+ *          CPU cost of loading without the driver.
+ *
+ * Textures are loaded once (the texture cache of the command list would
+ * return the same texture the second time), raw textures first. The files are
+ * read from the OS file cache in both cases as the raw textures are read when
+ * they are cooked.
+ */
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <objbase.h>  // For CoInitializeEx (needed to load images with WIC).
+
+#include <dx12lib/CommandList.h>
+#include <dx12lib/CommandQueue.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/MipGenerator.h>
+#include <dx12lib/Texture.h>
+#include <dx12lib/TextureCooker.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace dx12lib;
+namespace fs = std::filesystem;
+
+using Clock = std::chrono::high_resolution_clock;
+
+static void PrintUsage()
+{
+    std::wprintf( L"Usage: 07-TextureCook <texture files or directories> [-usage <usage>] [-cache <directory>] "
+                  L"[-clean] [-fast] [-threads <count>] [-cpumips] [-null]\n" );
+}
+
+static bool IsTextureFile( const fs::path& filePath )
+{
+    static const wchar_t* extensions[] = { L".png", L".jpg", L".jpeg", L".bmp", L".tga", L".hdr", L".dds" };
+
+    auto extension = filePath.extension().wstring();
+    for ( auto e: extensions )
+    {
+        if ( ::_wcsicmp( extension.c_str(), e ) == 0 )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool ParseUsage( const wchar_t* str, TextureUsage& usage )
+{
+    static const std::pair<const wchar_t*, TextureUsage> usages[] = {
+        { L"albedo", TextureUsage::Albedo }, { L"normal", TextureUsage::Normal }, { L"mask", TextureUsage::Mask },
+        { L"hdr", TextureUsage::HDR },       { L"bump", TextureUsage::Bump },
+    };
+
+    for ( const auto& u: usages )
+    {
+        if ( ::_wcsicmp( str, u.first ) == 0 )
+        {
+            usage = u.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint64_t GetTextureSize( Device& device, const Texture& texture )
+{
+    auto desc = texture.GetD3D12ResourceDesc();
+    return device.GetD3D12Device()->GetResourceAllocationInfo( 0, 1, &desc ).SizeInBytes;
+}
+
+// Load a texture and wait until it is on the GPU. Returns the time in milliseconds.
+static double LoadTexture( Device& device, const std::wstring& fileName, bool sRGB, const MipGenerator* mipGenerator,
+                           uint64_t& textureSize )
+{
+    auto& commandQueue = device.GetCommandQueue( D3D12_COMMAND_LIST_TYPE_DIRECT );
+
+    auto startTime   = Clock::now();
+    auto commandList = commandQueue.GetCommandList();
+    auto texture     = commandList->LoadTextureFromFile( fileName, sRGB, mipGenerator );
+    commandQueue.WaitForFenceValue( commandQueue.ExecuteCommandList( commandList ) );
+    auto loadTime = std::chrono::duration<double, std::milli>( Clock::now() - startTime ).count();
+
+    textureSize = GetTextureSize( device, *texture );
+
+    return loadTime;
+}
+
+int wmain( int argc, wchar_t* argv[] )
+{
+    std::vector<std::wstring> fileNames;
+    TextureUsage              usage          = TextureUsage::Albedo;
+    std::wstring              cacheDirectory = L"TextureCache";
+    bool                      clean          = false;
+    bool                      useNull        = false;
+    bool                      cpuMips        = false;
+    TextureCookSettings       settings;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( ::wcscmp( argv[i], L"-usage" ) == 0 && i + 1 < argc )
+        {
+            if ( !ParseUsage( argv[++i], usage ) )
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if ( ::wcscmp( argv[i], L"-cache" ) == 0 && i + 1 < argc )
+        {
+            cacheDirectory = argv[++i];
+        }
+        else if ( ::wcscmp( argv[i], L"-clean" ) == 0 )
+        {
+            clean = true;
+        }
+        else if ( ::wcscmp( argv[i], L"-fast" ) == 0 )
+        {
+            settings.FastCompression = true;
+        }
+        else if ( ::wcscmp( argv[i], L"-threads" ) == 0 && i + 1 < argc )
+        {
+            settings.NumThreads = static_cast<uint32_t>( std::wcstoul( argv[++i], nullptr, 10 ) );
+        }
+        else if ( ::wcscmp( argv[i], L"-cpumips" ) == 0 )
+        {
+            cpuMips = true;
+        }
+        else if ( ::wcscmp( argv[i], L"-null" ) == 0 )
+        {
+            useNull = true;
+        }
+        else if ( fs::is_directory( argv[i] ) )
+        {
+            for ( const auto& entry: fs::recursive_directory_iterator( argv[i] ) )
+            {
+                if ( entry.is_regular_file() && IsTextureFile( entry.path() ) )
+                {
+                    fileNames.push_back( entry.path().wstring() );
+                }
+            }
+        }
+        else
+        {
+            fileNames.push_back( argv[i] );
+        }
+    }
+
+    if ( fileNames.empty() )
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    ::CoInitializeEx( nullptr, COINIT_MULTITHREADED );
+
+#if defined( _DEBUG )
+    // Always enable the Debug layer before doing anything with DX12.
+    if ( !useNull )
+    {
+        Device::EnableDebugLayer();
+    }
+#endif
+
+    int retCode = 0;
+
+    try
+    {
+        auto device = useNull ? Device::CreateNull() : Device::Create();
+        std::wprintf( L"Device: %s\n", device->GetDescription().c_str() );
+
+        if ( clean && fs::exists( cacheDirectory ) )
+        {
+            // Only delete the cooked textures, not anything else that is in the directory.
+            for ( const auto& entry: fs::directory_iterator( cacheDirectory ) )
+            {
+                if ( entry.is_regular_file() && entry.path().extension() == L".dds" )
+                {
+                    fs::remove( entry.path() );
+                }
+            }
+        }
+
+        TextureCooker cooker( cacheDirectory, settings );
+        MipGenerator  mipGenerator;
+
+        std::wprintf( L"%-32s %10s %10s %10s %10s %10s\n", L"Texture", L"Cook ms", L"Raw ms", L"Cooked ms",
+                      L"Raw KiB", L"Cooked KiB" );
+
+        double   totalCookTime = 0.0, totalRawTime = 0.0, totalCookedTime = 0.0;
+        uint64_t totalRawSize = 0, totalCookedSize = 0;
+
+        for ( const auto& fileName: fileNames )
+        {
+            uint64_t rawSize, cookedSize;
+            double   rawTime = LoadTexture( *device, fileName, usage == TextureUsage::Albedo,
+                                          cpuMips ? &mipGenerator : nullptr, rawSize );
+
+            auto         startTime      = Clock::now();
+            std::wstring cookedFileName = cooker.Cook( fileName, usage );
+            double       cookTime       = std::chrono::duration<double, std::milli>( Clock::now() - startTime ).count();
+
+            double cookedTime = LoadTexture( *device, cookedFileName, false, nullptr, cookedSize );
+
+            std::wprintf( L"%-32s %10.1f %10.2f %10.2f %10.0f %10.0f\n",
+                          fs::path( fileName ).filename().wstring().c_str(), cookTime, rawTime, cookedTime,
+                          rawSize / 1024.0, cookedSize / 1024.0 );
+
+            totalCookTime += cookTime;
+            totalRawTime += rawTime;
+            totalCookedTime += cookedTime;
+            totalRawSize += rawSize;
+            totalCookedSize += cookedSize;
+        }
+
+        std::wprintf( L"%-32s %10.1f %10.2f %10.2f %10.0f %10.0f\n", L"Total", totalCookTime, totalRawTime,
+                      totalCookedTime, totalRawSize / 1024.0, totalCookedSize / 1024.0 );
+
+        auto statistics = cooker.GetStatistics();
+        std::wprintf( L"%llu textures cooked (%.1f ms generating mips, %.1f ms compressing on %u threads), "
+                      L"%llu cache hits, %llu already compressed\n",
+                      statistics.NumTexturesCooked, statistics.MipTime, statistics.CompressTime,
+                      cooker.GetSettings().NumThreads, statistics.NumCacheHits, statistics.NumPassThrough );
+        if ( totalCookedTime > 0.0 && totalCookedSize > 0 )
+        {
+            std::wprintf( L"Cooked textures load %.1fx faster and use %.1fx less memory.\n",
+                          totalRawTime / totalCookedTime, static_cast<double>( totalRawSize ) / totalCookedSize );
+        }
+
+        device->Flush();
+    }
+    catch ( const std::exception& e )
+    {
+        std::fprintf( stderr, "Texture cook failed: %s\n", e.what() );
+        retCode = 1;
+    }
+
+    ::CoUninitialize();
+
+    return retCode;
+}
@@ -0,0 +1,88 @@
+/**
+ * Measures the CPU cost of building the argument buffer of a scene with 100k
+ * instances with the IndirectDrawBuilder.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/IndirectDrawBuilder.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Instance
+{
+    uint32_t Bucket;
+    uint32_t Mesh;
+    uint32_t Material;
+};
+
+}  // namespace
+
+TEST_CASE( Benchmark_IndirectDrawBuilder_100kInstances )
+{
+    const uint32_t NumInstances = 100000;
+    const uint32_t NumMeshes    = 1000;
+    const uint32_t NumBuckets   = 3;
+    const int      NumFrames    = 100;
+
+    std::mt19937 random( 5 );
+
+    std::vector<D3D12_VERTEX_BUFFER_VIEW> vertexBufferViews( NumMeshes );
+    std::vector<D3D12_INDEX_BUFFER_VIEW>  indexBufferViews( NumMeshes );
+    for ( uint32_t i = 0; i < NumMeshes; ++i )
+    {
+        vertexBufferViews[i] = { 0x10000ull * i, 65536, 56 };
+        indexBufferViews[i]  = { 0x80000000ull + 0x10000ull * i, 65536, DXGI_FORMAT_R16_UINT };
+    }
+
+    std::vector<Instance> instances( NumInstances );
+    for ( auto& instance: instances )
+    {
+        instance.Bucket   = random() % NumBuckets;
+        instance.Mesh     = random() % NumMeshes;
+        instance.Material = random() % 256;
+    }
+
+    IndirectDrawBuilder builder( NumBuckets );
+    builder.Reserve( NumInstances );
+
+    double addTime = 0.0, buildTime = 0.0;
+    for ( int frame = 0; frame < NumFrames; ++frame )
+    {
+        auto startTime = Clock::now();
+
+        builder.Clear();
+        for ( uint32_t i = 0; i < NumInstances; ++i )
+        {
+            const Instance& instance = instances[i];
+            builder.AddDraw( instance.Bucket, instance.Material, i, vertexBufferViews[instance.Mesh],
+                             indexBufferViews[instance.Mesh], 36 );
+        }
+
+        auto addedTime = Clock::now();
+        builder.Build();
+        auto builtTime = Clock::now();
+
+        addTime += std::chrono::duration<double, std::milli>( addedTime - startTime ).count();
+        buildTime += std::chrono::duration<double, std::milli>( builtTime - addedTime ).count();
+    }
+
+    CHECK( builder.GetCommands().size() == NumInstances );
+
+    const double argumentBufferSize = NumInstances * sizeof( IndirectDrawCommand ) / ( 1024.0 * 1024.0 );
+    std::printf( "%u instances in %u buckets: AddDraw %.3f ms/frame, Build %.3f ms/frame, %.1f ns/instance, "
+                 "argument buffer %.2f MiB\n",
+                 NumInstances, NumBuckets, addTime / NumFrames, buildTime / NumFrames,
+                 ( addTime + buildTime ) * 1.0e6 / ( static_cast<double>( NumFrames ) * NumInstances ),
+                 argumentBufferSize );
+}
@@ -0,0 +1,204 @@
+/**
+ * Tests the contents of the argument buffer that is built by the
+ * IndirectDrawBuilder.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/IndirectDrawBuilder.h>
+
+#include <random>
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+D3D12_VERTEX_BUFFER_VIEW VertexBufferView( uint32_t mesh )
+{
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+    vertexBufferView.BufferLocation = 0x10000ull * ( mesh + 1 );
+    vertexBufferView.SizeInBytes    = 1024 * ( mesh + 1 );
+    vertexBufferView.StrideInBytes  = 56;
+    return vertexBufferView;
+}
+
+D3D12_INDEX_BUFFER_VIEW IndexBufferView( uint32_t mesh )
+{
+    D3D12_INDEX_BUFFER_VIEW indexBufferView;
+    indexBufferView.BufferLocation = 0x80000000ull + 0x10000ull * mesh;
+    indexBufferView.SizeInBytes    = 512 * ( mesh + 1 );
+    indexBufferView.Format         = mesh % 2 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+    return indexBufferView;
+}
+
+// The draw that was added as the n-th draw of the scene
+struct Draw
+{
+    uint32_t Bucket;
+    uint32_t Mesh;
+    uint32_t Material;
+    uint32_t Transform;
+    uint32_t InstanceCount;
+};
+
+void AddDraw( IndirectDrawBuilder& builder, const Draw& draw )
+{
+    builder.AddDraw( draw.Bucket, draw.Material, draw.Transform, VertexBufferView( draw.Mesh ),
+                     IndexBufferView( draw.Mesh ), 36 * ( draw.Mesh + 1 ), draw.InstanceCount, draw.Mesh * 3,
+                     -static_cast<int32_t>( draw.Mesh ) );
+}
+
+bool IsCommandOfDraw( const IndirectDrawCommand& command, const Draw& draw )
+{
+    const D3D12_VERTEX_BUFFER_VIEW     vertexBufferView = VertexBufferView( draw.Mesh );
+    const D3D12_INDEX_BUFFER_VIEW      indexBufferView  = IndexBufferView( draw.Mesh );
+    const D3D12_DRAW_INDEXED_ARGUMENTS arguments        = command.DrawIndexedArguments;
+
+    return command.DrawConstants.MaterialIndex == draw.Material &&
+           command.DrawConstants.TransformIndex == draw.Transform &&
+           command.VertexBufferView.BufferLocation == vertexBufferView.BufferLocation &&
+           command.VertexBufferView.SizeInBytes == vertexBufferView.SizeInBytes &&
+           command.VertexBufferView.StrideInBytes == vertexBufferView.StrideInBytes &&
+           command.IndexBufferView.BufferLocation == indexBufferView.BufferLocation &&
+           command.IndexBufferView.SizeInBytes == indexBufferView.SizeInBytes &&
+           command.IndexBufferView.Format == indexBufferView.Format &&
+           arguments.IndexCountPerInstance == 36 * ( draw.Mesh + 1 ) &&
+           arguments.InstanceCount == draw.InstanceCount && arguments.StartIndexLocation == draw.Mesh * 3 &&
+           arguments.BaseVertexLocation == -static_cast<int32_t>( draw.Mesh ) && arguments.StartInstanceLocation == 0;
+}
+
+// Checks that the commands of each bucket are the draws of the bucket in the order they were added.
+void CheckCommands( const IndirectDrawBuilder& builder, const std::vector<Draw>& draws )
+{
+    const auto& commands = builder.GetCommands();
+    REQUIRE( commands.size() == draws.size() );
+    REQUIRE( builder.GetNumDraws() == draws.size() );
+
+    uint32_t firstCommand = 0;
+    for ( uint32_t bucketIdx = 0; bucketIdx < builder.GetNumBuckets(); ++bucketIdx )
+    {
+        const auto& bucket = builder.GetBucket( bucketIdx );
+        CHECK( bucket.FirstCommand == firstCommand );
+
+        uint32_t commandIdx = bucket.FirstCommand;
+        for ( const auto& draw: draws )
+        {
+            if ( draw.Bucket == bucketIdx )
+            {
+                REQUIRE( commandIdx < bucket.FirstCommand + bucket.NumCommands );
+                CHECK( IsCommandOfDraw( commands[commandIdx], draw ) );
+                ++commandIdx;
+            }
+        }
+
+        CHECK( commandIdx == bucket.FirstCommand + bucket.NumCommands );
+        firstCommand += bucket.NumCommands;
+    }
+
+    CHECK( firstCommand == commands.size() );
+}
+
+}  // namespace
+
+TEST_CASE( IndirectDrawBuilder_ArgumentDescsMatchCommandLayout )
+{
+    const auto argumentDescs = IndirectDrawBuilder::GetArgumentDescs( 5, 2 );
+
+    CHECK( argumentDescs[0].Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT );
+    CHECK( argumentDescs[0].Constant.RootParameterIndex == 5 );
+    CHECK( argumentDescs[0].Constant.DestOffsetIn32BitValues == 0 );
+    CHECK( argumentDescs[0].Constant.Num32BitValuesToSet * 4 == sizeof( IndirectDrawConstants ) );
+
+    CHECK( argumentDescs[1].Type == D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW );
+    CHECK( argumentDescs[1].VertexBuffer.Slot == 2 );
+    CHECK( argumentDescs[2].Type == D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW );
+    CHECK( argumentDescs[3].Type == D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED );
+
+    // The size of a command is used as the byte stride of the command signature, which has to hold
+    // the arguments and be a multiple of 4 bytes.
+    const size_t argumentsSize = sizeof( IndirectDrawConstants ) + sizeof( D3D12_VERTEX_BUFFER_VIEW ) +
+                                 sizeof( D3D12_INDEX_BUFFER_VIEW ) + sizeof( D3D12_DRAW_INDEXED_ARGUMENTS );
+    CHECK( sizeof( IndirectDrawCommand ) >= argumentsSize );
+    CHECK( sizeof( IndirectDrawCommand ) % 4 == 0 );
+}
+
+TEST_CASE( IndirectDrawBuilder_GroupsDrawsByBucket )
+{
+    IndirectDrawBuilder builder( 3 );
+
+    const std::vector<Draw> draws = {
+        { 2, 0, 10, 0, 1 }, { 0, 1, 11, 1, 1 }, { 2, 2, 12, 2, 4 }, { 0, 3, 13, 6, 1 }, { 2, 4, 14, 7, 1 },
+    };
+    for ( const auto& draw: draws )
+    {
+        AddDraw( builder, draw );
+    }
+    builder.Build();
+
+    CheckCommands( builder, draws );
+
+    // The bucket without draws is empty, the other buckets follow each other.
+    CHECK( builder.GetBucket( 0 ).FirstCommand == 0 && builder.GetBucket( 0 ).NumCommands == 2 );
+    CHECK( builder.GetBucket( 1 ).NumCommands == 0 );
+    CHECK( builder.GetBucket( 2 ).FirstCommand == 2 && builder.GetBucket( 2 ).NumCommands == 3 );
+}
+
+TEST_CASE( IndirectDrawBuilder_ClearKeepsBuckets )
+{
+    IndirectDrawBuilder builder( 2 );
+
+    AddDraw( builder, { 1, 0, 0, 0, 1 } );
+    builder.Build();
+    CHECK( builder.GetCommands().size() == 1 );
+
+    builder.Clear();
+    CHECK( builder.GetNumDraws() == 0 );
+    CHECK( builder.GetNumBuckets() == 2 );
+    builder.Build();
+    CHECK( builder.GetCommands().empty() );
+    CHECK( builder.GetBucket( 1 ).NumCommands == 0 );
+
+    // Changing the number of buckets also removes the draws.
+    AddDraw( builder, { 0, 0, 0, 0, 1 } );
+    builder.SetNumBuckets( 4 );
+    CHECK( builder.GetNumDraws() == 0 );
+    CHECK( builder.GetNumBuckets() == 4 );
+}
+
+TEST_CASE( IndirectDrawBuilder_RandomScenes )
+{
+    std::mt19937        random( 4 );
+    IndirectDrawBuilder builder;
+    for ( int sceneIdx = 0; sceneIdx < 50; ++sceneIdx )
+    {
+        const uint32_t numBuckets = 1 + random() % 8;
+        const uint32_t numDraws   = random() % 2000;
+
+        builder.SetNumBuckets( numBuckets );
+
+        // The builder is reused for a few frames with different draws.
+        for ( int frame = 0; frame < 3; ++frame )
+        {
+            std::vector<Draw> draws( numDraws - frame * numDraws / 4 );
+            uint32_t          transform = 0;
+            for ( auto& draw: draws )
+            {
+                draw.Bucket        = random() % numBuckets;
+                draw.Mesh          = random() % 100;
+                draw.Material      = random() % 32;
+                draw.InstanceCount = 1 + random() % 4;
+                draw.Transform     = transform;
+                transform += draw.InstanceCount;
+
+                AddDraw( builder, draw );
+            }
+            builder.Build();
+
+            CheckCommands( builder, draws );
+
+            builder.Clear();
+        }
+    }
+}
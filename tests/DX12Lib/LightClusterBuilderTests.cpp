@@ -0,0 +1,97 @@
+/**
+ * Tests the light ranges and the cluster assignment of the LightClusterBuilder
+ * against brute force assignment.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/LightClusterBuilder.h>
+
+#include <cmath>
+#include <random>
+
+using namespace dx12lib;
+using namespace DirectX;
+
+TEST_CASE( LightClusterBuilder_LightRangeMatchesAttenuation )
+{
+    const XMFLOAT4 color = { 0.5f, 1.0f, 0.25f, 1.0f };
+
+    // The attenuated color drops to 1/256 at the range.
+    const float attenuations[][3] = { { 1.0f, 0.0f, 0.2f }, { 1.0f, 0.5f, 0.0f }, { 0.5f, 0.1f, 0.01f } };
+    for ( const auto& a: attenuations )
+    {
+        for ( float intensity: { 1.0f, 2.0f } )
+        {
+            float range = LightClusterBuilder::GetLightRange( color, a[0], a[1], a[2], intensity );
+            REQUIRE( range > 0.0f && range < LightClusterBuilder::InfiniteRange );
+
+            float attenuatedColor = intensity * color.y / ( a[0] + a[1] * range + a[2] * range * range );
+            CHECK_NEAR( attenuatedColor, 1.0f / 256.0f, 1.0e-6 );
+        }
+    }
+
+    // The constant attenuation alone doesn't bound the light.
+    CHECK( LightClusterBuilder::GetLightRange( color, 1.0f, 0.0f, 0.0f ) == LightClusterBuilder::InfiniteRange );
+
+    // A light that is already dark enough has no range.
+    const XMFLOAT4 black = { 0.0f, 0.0f, 0.0f, 1.0f };
+    CHECK( LightClusterBuilder::GetLightRange( black, 1.0f, 0.0f, 0.2f ) == 0.0f );
+    CHECK( LightClusterBuilder::GetLightRange( black, 1.0f, 0.5f, 0.0f ) == 0.0f );
+}
+
+TEST_CASE( LightClusterBuilder_BuildMatchesBruteForce )
+{
+    std::mt19937                          random( 6 );
+    std::uniform_real_distribution<float> signedUnit( -1.0f, 1.0f );
+
+    LightClusterBuilder builder;
+    builder.SetProjectionMatrix( XMMatrixPerspectiveFovLH( XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f ) );
+
+    for ( int i = 0; i < 300; ++i )
+    {
+        builder.AddPointLight( { 40.0f * signedUnit( random ), 20.0f * signedUnit( random ),
+                                 40.0f + 60.0f * signedUnit( random ) },
+                               4.0f * ( 1.2f + signedUnit( random ) ) );
+    }
+    builder.AddPointLight( { 0.0f, 0.0f, 5.0f }, LightClusterBuilder::InfiniteRange );
+
+    for ( int i = 0; i < 100; ++i )
+    {
+        XMFLOAT3 direction = { signedUnit( random ), signedUnit( random ), signedUnit( random ) };
+        float    length    = std::sqrt( direction.x * direction.x + direction.y * direction.y +
+                                        direction.z * direction.z );
+        direction          = { direction.x / length, direction.y / length, direction.z / length };
+
+        builder.AddSpotLight( { 40.0f * signedUnit( random ), 20.0f * signedUnit( random ),
+                                40.0f + 60.0f * signedUnit( random ) },
+                              direction, 8.0f * ( 1.2f + signedUnit( random ) ),
+                              0.3f + 0.5f * ( 1.0f + signedUnit( random ) ) );
+    }
+
+    builder.Build();
+    const auto clusters        = builder.GetClusters();
+    const auto lightIndices    = builder.GetLightIndices();
+    const auto numTests        = builder.GetStatistics().NumIntersectionTests;
+    const auto numLightIndices = builder.GetStatistics().NumLightIndices;
+
+    builder.BuildBruteForce();
+    REQUIRE( clusters.size() == builder.GetClusters().size() );
+    for ( size_t clusterIdx = 0; clusterIdx < clusters.size(); ++clusterIdx )
+    {
+        CHECK( clusters[clusterIdx].Offset == builder.GetClusters()[clusterIdx].Offset );
+        CHECK( clusters[clusterIdx].Counts == builder.GetClusters()[clusterIdx].Counts );
+    }
+    CHECK( lightIndices == builder.GetLightIndices() );
+    CHECK( numLightIndices == builder.GetStatistics().NumLightIndices );
+
+    // The light with the infinite range is in every cluster.
+    CHECK( builder.GetStatistics().MaxLightsPerCluster >= 1 );
+    for ( const auto& cluster: clusters )
+    {
+        CHECK( cluster.GetNumPointLights() >= 1 );
+    }
+
+    // Only the clusters that overlap the bounds of a light are tested.
+    CHECK( numTests < builder.GetStatistics().NumIntersectionTests );
+}
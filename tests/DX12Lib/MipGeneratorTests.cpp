@@ -0,0 +1,550 @@
+/**
+ * Tests the CPU MipGenerator against a double precision reference: the box
+ * filter against the area weighted average of the previous mip for every
+ * supported component type (sRGB in linear space), and the Kaiser filter on
+ * constant images and sinusoids. Also checks that arrays and multithreading
+ * don't change the result. The MipGenerator only depends on the standard
+ * library, so these tests also build and run off Windows.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/MipGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+const double Pi = 3.14159265358979323846;
+
+// The rows of every subresource are padded with this many bytes (of PaddingByte), like the rows of an upload buffer.
+const size_t  RowPadding  = 16;
+const uint8_t PaddingByte = 0xcd;
+
+// A texture with a full mip chain, with the subresources in the same order as
+// the subresources of a D3D12 texture.
+class TestTexture
+{
+public:
+    TestTexture( uint32_t width, uint32_t height, uint32_t arraySize, uint32_t texelSize )
+    : m_NumMips( MipGenerator::GetNumMips( width, height ) )
+    , m_ArraySize( arraySize )
+    , m_TexelSize( texelSize )
+    {
+        m_Data.resize( m_NumMips * arraySize );
+        m_Subresources.resize( m_NumMips * arraySize );
+        for ( uint32_t slice = 0; slice < arraySize; ++slice )
+        {
+            for ( uint32_t mip = 0; mip < m_NumMips; ++mip )
+            {
+                MipGenerator::Subresource& subresource = m_Subresources[mip + slice * m_NumMips];
+                subresource.Width    = std::max( width >> mip, 1u );
+                subresource.Height   = std::max( height >> mip, 1u );
+                subresource.RowPitch = subresource.Width * texelSize + RowPadding;
+
+                std::vector<uint8_t>& data = m_Data[mip + slice * m_NumMips];
+                data.resize( subresource.RowPitch * subresource.Height, PaddingByte );
+                subresource.Pixels = data.data();
+            }
+        }
+    }
+
+    uint32_t GetNumMips() const
+    {
+        return m_NumMips;
+    }
+
+    uint32_t GetArraySize() const
+    {
+        return m_ArraySize;
+    }
+
+    const MipGenerator::Subresource* GetSubresources() const
+    {
+        return m_Subresources.data();
+    }
+
+    const MipGenerator::Subresource& GetSubresource( uint32_t mip, uint32_t slice = 0 ) const
+    {
+        return m_Subresources[mip + slice * m_NumMips];
+    }
+
+    uint8_t* GetTexel( uint32_t mip, uint32_t slice, uint32_t x, uint32_t y ) const
+    {
+        const MipGenerator::Subresource& subresource = GetSubresource( mip, slice );
+        return static_cast<uint8_t*>( subresource.Pixels ) + y * subresource.RowPitch + x * m_TexelSize;
+    }
+
+    void Generate( const MipGenerator& generator, DXGI_FORMAT format ) const
+    {
+        generator.Generate( format, m_Subresources.data(), m_NumMips, m_ArraySize );
+    }
+
+    // Checks that the mips (and not only mip 0) are the same, padding included.
+    bool operator==( const TestTexture& other ) const
+    {
+        return m_Data == other.m_Data;
+    }
+
+    bool IsPaddingUntouched() const
+    {
+        for ( uint32_t i = 0; i < m_Subresources.size(); ++i )
+        {
+            const MipGenerator::Subresource& subresource = m_Subresources[i];
+            for ( uint32_t y = 0; y < subresource.Height; ++y )
+            {
+                const uint8_t* padding = m_Data[i].data() + y * subresource.RowPitch + subresource.Width * m_TexelSize;
+                if ( std::count( padding, padding + RowPadding, PaddingByte ) != ptrdiff_t( RowPadding ) )
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    uint32_t                               m_NumMips;
+    uint32_t                               m_ArraySize;
+    uint32_t                               m_TexelSize;
+    std::vector<std::vector<uint8_t>>      m_Data;
+    std::vector<MipGenerator::Subresource> m_Subresources;
+};
+
+double SRGBToLinear( double x )
+{
+    return x <= 0.04045 ? x / 12.92 : std::pow( ( x + 0.055 ) / 1.055, 2.4 );
+}
+
+double LinearToSRGB( double x )
+{
+    return x <= 0.0031308 ? x * 12.92 : 1.055 * std::pow( x, 1.0 / 2.4 ) - 0.055;
+}
+
+// Only decodes normal and denormal values, which is all the tests write.
+double HalfToDouble( uint16_t h )
+{
+    const int exponent = ( h >> 10 ) & 0x1f;
+    const int mantissa = h & 0x3ff;
+    const double value = exponent == 0 ? std::ldexp( mantissa, -24 ) : std::ldexp( 1024 + mantissa, exponent - 25 );
+    return ( h & 0x8000 ) ? -value : value;
+}
+
+uint16_t LoadUInt16( const uint8_t* component )
+{
+    uint16_t value;
+    std::memcpy( &value, component, sizeof( value ) );
+    return value;
+}
+
+float LoadFloat( const uint8_t* component )
+{
+    float value;
+    std::memcpy( &value, component, sizeof( value ) );
+    return value;
+}
+
+// A format that the box filter is tested with. The decoded values are linear,
+// the tolerance is in the stored units (codes for UNORM formats).
+struct FormatCase
+{
+    const char* Name;
+    DXGI_FORMAT Format;
+    uint32_t    NumChannels;
+    uint32_t    ComponentSize;
+    void ( *Fill )( std::mt19937& random, uint8_t* component );
+    double ( *Decode )( const uint8_t* component, uint32_t channel );
+    double ( *ToStored )( double value, uint32_t channel );
+    double Tolerance;
+};
+
+void FillRandomBytes( std::mt19937& random, uint8_t* component )
+{
+    *component = static_cast<uint8_t>( random() );
+}
+
+void FillRandomUInt16( std::mt19937& random, uint8_t* component )
+{
+    const uint16_t value = static_cast<uint16_t>( random() );
+    std::memcpy( component, &value, sizeof( value ) );
+}
+
+// Halves in [0, 1), including denormals.
+void FillRandomHalf( std::mt19937& random, uint8_t* component )
+{
+    const uint16_t value = static_cast<uint16_t>( random() % ( 15 << 10 ) );
+    std::memcpy( component, &value, sizeof( value ) );
+}
+
+void FillRandomFloat( std::mt19937& random, uint8_t* component )
+{
+    const float value = std::uniform_real_distribution<float>( -1.0f, 4.0f )( random );
+    std::memcpy( component, &value, sizeof( value ) );
+}
+
+const FormatCase FormatCases[] = {
+    { "R8G8B8A8_UNORM", DXGI_FORMAT_R8G8B8A8_UNORM, 4, 1, FillRandomBytes,
+      []( const uint8_t* c, uint32_t ) { return *c / 255.0; }, []( double v, uint32_t ) { return v * 255.0; }, 0.501 },
+    { "R8G8B8A8_UNORM_SRGB", DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4, 1, FillRandomBytes,
+      []( const uint8_t* c, uint32_t channel ) { return channel < 3 ? SRGBToLinear( *c / 255.0 ) : *c / 255.0; },
+      []( double v, uint32_t channel ) { return ( channel < 3 ? LinearToSRGB( v ) : v ) * 255.0; }, 0.501 },
+    { "R8_UNORM", DXGI_FORMAT_R8_UNORM, 1, 1, FillRandomBytes,
+      []( const uint8_t* c, uint32_t ) { return *c / 255.0; }, []( double v, uint32_t ) { return v * 255.0; }, 0.501 },
+    { "R16G16_UNORM", DXGI_FORMAT_R16G16_UNORM, 2, 2, FillRandomUInt16,
+      []( const uint8_t* c, uint32_t ) { return LoadUInt16( c ) / 65535.0; },
+      []( double v, uint32_t ) { return v * 65535.0; }, 0.51 },
+    { "R16G16B16A16_FLOAT", DXGI_FORMAT_R16G16B16A16_FLOAT, 4, 2, FillRandomHalf,
+      []( const uint8_t* c, uint32_t ) { return HalfToDouble( LoadUInt16( c ) ); },
+      []( double v, uint32_t ) { return v; }, 2.5e-4 },
+    { "R32G32B32_FLOAT", DXGI_FORMAT_R32G32B32_FLOAT, 3, 4, FillRandomFloat,
+      []( const uint8_t* c, uint32_t ) { return double( LoadFloat( c ) ); }, []( double v, uint32_t ) { return v; },
+      2e-6 },
+};
+
+// Decodes a subresource to numChannels linear values per texel.
+std::vector<double> ReadMip( const TestTexture& texture, const FormatCase& format, uint32_t mip, uint32_t slice = 0 )
+{
+    const MipGenerator::Subresource& subresource = texture.GetSubresource( mip, slice );
+
+    std::vector<double> values;
+    for ( uint32_t y = 0; y < subresource.Height; ++y )
+    {
+        for ( uint32_t x = 0; x < subresource.Width; ++x )
+        {
+            const uint8_t* texel = texture.GetTexel( mip, slice, x, y );
+            for ( uint32_t c = 0; c < format.NumChannels; ++c )
+            {
+                values.push_back( format.Decode( texel + c * format.ComponentSize, c ) );
+            }
+        }
+    }
+    return values;
+}
+
+// The length of [srcTexel, srcTexel + 1) that is covered by the destination texel.
+double Coverage( uint32_t dstTexel, uint32_t srcTexel, double scale )
+{
+    return std::max( 0.0, std::min( ( dstTexel + 1 ) * scale, srcTexel + 1.0 ) - std::max( dstTexel * scale, double( srcTexel ) ) );
+}
+
+// Filters an image to the size of the next mip: every texel is the average of
+// the source texels it covers, weighted by the covered area.
+std::vector<double> ReferenceBox( const std::vector<double>& src, uint32_t srcWidth, uint32_t srcHeight,
+                                  uint32_t numChannels )
+{
+    const uint32_t dstWidth  = std::max( srcWidth / 2, 1u );
+    const uint32_t dstHeight = std::max( srcHeight / 2, 1u );
+    const double   scaleX    = double( srcWidth ) / dstWidth;
+    const double   scaleY    = double( srcHeight ) / dstHeight;
+
+    std::vector<double> dst( size_t( dstWidth ) * dstHeight * numChannels );
+    for ( uint32_t y = 0; y < dstHeight; ++y )
+    {
+        for ( uint32_t x = 0; x < dstWidth; ++x )
+        {
+            for ( uint32_t sy = 0; sy < srcHeight; ++sy )
+            {
+                for ( uint32_t sx = 0; sx < srcWidth; ++sx )
+                {
+                    const double weight = Coverage( x, sx, scaleX ) * Coverage( y, sy, scaleY ) / ( scaleX * scaleY );
+                    for ( uint32_t c = 0; weight > 0.0 && c < numChannels; ++c )
+                    {
+                        dst[( y * dstWidth + x ) * numChannels + c] += weight * src[( sy * srcWidth + sx ) * numChannels + c];
+                    }
+                }
+            }
+        }
+    }
+    return dst;
+}
+
+// Fills mip 0 of every slice of an R32_FLOAT texture with func( x, y, slice ) at the texel centers.
+template<typename Func>
+void FillFloat( const TestTexture& texture, Func&& func )
+{
+    const MipGenerator::Subresource& mip0 = texture.GetSubresource( 0 );
+    for ( uint32_t slice = 0; slice < texture.GetArraySize(); ++slice )
+    {
+        for ( uint32_t y = 0; y < mip0.Height; ++y )
+        {
+            for ( uint32_t x = 0; x < mip0.Width; ++x )
+            {
+                const float value = float( func( x + 0.5, y + 0.5, slice ) );
+                std::memcpy( texture.GetTexel( 0, slice, x, y ), &value, sizeof( value ) );
+            }
+        }
+    }
+}
+
+void FillRandom( const TestTexture& texture, const FormatCase& format, std::mt19937& random )
+{
+    for ( uint32_t slice = 0; slice < texture.GetArraySize(); ++slice )
+    {
+        const MipGenerator::Subresource& mip0 = texture.GetSubresource( 0, slice );
+        for ( uint32_t y = 0; y < mip0.Height; ++y )
+        {
+            for ( uint32_t x = 0; x < mip0.Width; ++x )
+            {
+                for ( uint32_t c = 0; c < format.NumChannels; ++c )
+                {
+                    format.Fill( random, texture.GetTexel( 0, slice, x, y ) + c * format.ComponentSize );
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+TEST_CASE( MipGenerator_GetNumMips )
+{
+    CHECK( MipGenerator::GetNumMips( 1, 1 ) == 1 );
+    CHECK( MipGenerator::GetNumMips( 2, 1 ) == 2 );
+    CHECK( MipGenerator::GetNumMips( 256, 256 ) == 9 );
+    CHECK( MipGenerator::GetNumMips( 1, 256 ) == 9 );
+    CHECK( MipGenerator::GetNumMips( 1024, 768 ) == 11 );
+    CHECK( MipGenerator::GetNumMips( 37, 19 ) == 6 );
+}
+
+TEST_CASE( MipGenerator_RejectsInvalidInput )
+{
+    CHECK( MipGenerator::IsFormatSupported( DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ) );
+    CHECK( MipGenerator::IsFormatSupported( DXGI_FORMAT_R32G32B32_FLOAT ) );
+    CHECK( !MipGenerator::IsFormatSupported( DXGI_FORMAT_BC1_UNORM ) );
+    CHECK( !MipGenerator::IsFormatSupported( DXGI_FORMAT_R8G8B8A8_UINT ) );
+    CHECK( !MipGenerator::IsFormatSupported( DXGI_FORMAT_D32_FLOAT ) );
+
+    MipGenerator generator;
+    TestTexture  texture( 16, 16, 1, 4 );
+
+    bool threw = false;
+    try
+    {
+        texture.Generate( generator, DXGI_FORMAT_BC1_UNORM );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+    CHECK( threw );
+
+    // Mip 1 of a 16x16 texture can't be 16x8.
+    std::vector<MipGenerator::Subresource> subresources( texture.GetSubresources(), texture.GetSubresources() + 2 );
+    subresources[1].Width = 16;
+
+    threw = false;
+    try
+    {
+        generator.Generate( DXGI_FORMAT_R8G8B8A8_UNORM, subresources.data(), 2 );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        threw = true;
+    }
+    CHECK( threw );
+}
+
+TEST_CASE( MipGenerator_BoxMatchesReference )
+{
+    std::mt19937 random( 48 );
+
+    // Even sizes (a 2x2 box), odd sizes (3 texels with weights 1/2, 1, 1/2) and
+    // sizes where one side is already 1.
+    const uint32_t sizes[][2] = { { 64, 32 }, { 37, 19 }, { 1, 13 }, { 7, 1 } };
+
+    MipGenerator generator;
+    for ( const FormatCase& format: FormatCases )
+    {
+        for ( const auto& size: sizes )
+        {
+            TestTexture texture( size[0], size[1], 1, format.NumChannels * format.ComponentSize );
+            FillRandom( texture, format, random );
+            texture.Generate( generator, format.Format );
+            CHECK( texture.IsPaddingUntouched() );
+
+            // Every mip is compared with the reference filter of the previous
+            // mip, so the rounding of the previous mips doesn't add up.
+            for ( uint32_t mip = 1; mip < texture.GetNumMips(); ++mip )
+            {
+                const MipGenerator::Subresource& srcMip = texture.GetSubresource( mip - 1 );
+                const std::vector<double> reference =
+                    ReferenceBox( ReadMip( texture, format, mip - 1 ), srcMip.Width, srcMip.Height, format.NumChannels );
+                const std::vector<double> result = ReadMip( texture, format, mip );
+                REQUIRE( result.size() == reference.size() );
+
+                double maxError = 0.0;
+                for ( size_t i = 0; i < result.size(); ++i )
+                {
+                    const uint32_t channel = uint32_t( i % format.NumChannels );
+                    maxError = std::max( maxError, std::abs( format.ToStored( result[i], channel ) -
+                                                             format.ToStored( reference[i], channel ) ) );
+                }
+                if ( maxError > format.Tolerance )
+                {
+                    std::printf( "%s %ux%u mip %u: error %g\n", format.Name, size[0], size[1], mip, maxError );
+                }
+                CHECK( maxError <= format.Tolerance );
+            }
+        }
+    }
+}
+
+TEST_CASE( MipGenerator_SRGBFiltersInLinearSpace )
+{
+    // A checkerboard of black and white averages to 50% linear gray, which is
+    // 188 in sRGB (and not 128). Alpha is linear in sRGB formats.
+    TestTexture texture( 8, 8, 1, 4 );
+    for ( uint32_t y = 0; y < 8; ++y )
+    {
+        for ( uint32_t x = 0; x < 8; ++x )
+        {
+            const uint8_t value = ( x + y ) % 2 ? 255 : 0;
+            const uint8_t texel[4] = { value, value, value, value };
+            std::memcpy( texture.GetTexel( 0, 0, x, y ), texel, sizeof( texel ) );
+        }
+    }
+
+    MipGenerator generator;
+    texture.Generate( generator, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB );
+    for ( uint32_t mip = 1; mip < texture.GetNumMips(); ++mip )
+    {
+        const uint8_t* texel = texture.GetTexel( mip, 0, 0, 0 );
+        CHECK( texel[0] == 188 && texel[1] == 188 && texel[2] == 188 );
+        CHECK( texel[3] == 128 );
+    }
+}
+
+TEST_CASE( MipGenerator_FiltersSinusoids )
+{
+    // A horizontal cosine of f cycles over the width. Filtering it to half the
+    // size scales it by the frequency response of the filter: cos( pi f / w )
+    // for the 2x2 box, and about 1 for the Kaiser filter at low frequencies
+    // (and about 0 at the highest frequency of the source).
+    const uint32_t size = 256;
+    for ( double frequency: { 4.0, 16.0, 112.0 } )
+    {
+        for ( MipFilter filter: { MipFilter::Box, MipFilter::Kaiser } )
+        {
+            TestTexture texture( size, size, 1, sizeof( float ) );
+            FillFloat( texture, [&]( double x, double, uint32_t ) { return std::cos( 2.0 * Pi * frequency * x / size ); } );
+
+            MipGenerationSettings settings;
+            settings.Filter = filter;
+            settings.Wrap   = true;
+            texture.Generate( MipGenerator( settings ), DXGI_FORMAT_R32_FLOAT );
+
+            double gain = std::cos( Pi * frequency / size );
+            if ( filter == MipFilter::Kaiser )
+            {
+                gain = frequency < size / 8 ? 1.0 : 0.0;
+            }
+
+            double maxError = 0.0;
+            for ( uint32_t y = 0; y < size / 2; ++y )
+            {
+                for ( uint32_t x = 0; x < size / 2; ++x )
+                {
+                    // The texel centers of mip 1 are at odd source coordinates.
+                    const double reference = gain * std::cos( 2.0 * Pi * frequency * ( 2.0 * x + 1.0 ) / size );
+                    maxError = std::max( maxError, std::abs( LoadFloat( texture.GetTexel( 1, 0, x, y ) ) - reference ) );
+                }
+            }
+            CHECK( maxError < ( filter == MipFilter::Box ? 1e-5 : 0.01 ) );
+        }
+    }
+}
+
+TEST_CASE( MipGenerator_KaiserPreservesConstants )
+{
+    // The weights are normalized, so a constant image stays constant at the
+    // edges (clamped and wrapped) and for odd sizes.
+    for ( bool wrap: { false, true } )
+    {
+        TestTexture texture( 45, 27, 2, 4 );
+        for ( uint32_t slice = 0; slice < 2; ++slice )
+        {
+            for ( uint32_t y = 0; y < 27; ++y )
+            {
+                for ( uint32_t x = 0; x < 45; ++x )
+                {
+                    const uint8_t texel[4] = { 77, 0, 255, uint8_t( 100 + slice ) };
+                    std::memcpy( texture.GetTexel( 0, slice, x, y ), texel, sizeof( texel ) );
+                }
+            }
+        }
+
+        MipGenerationSettings settings;
+        settings.Filter = MipFilter::Kaiser;
+        settings.Wrap   = wrap;
+        texture.Generate( MipGenerator( settings ), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB );
+        CHECK( texture.IsPaddingUntouched() );
+
+        for ( uint32_t slice = 0; slice < 2; ++slice )
+        {
+            for ( uint32_t mip = 1; mip < texture.GetNumMips(); ++mip )
+            {
+                const MipGenerator::Subresource& subresource = texture.GetSubresource( mip, slice );
+                for ( uint32_t y = 0; y < subresource.Height; ++y )
+                {
+                    for ( uint32_t x = 0; x < subresource.Width; ++x )
+                    {
+                        const uint8_t* texel = texture.GetTexel( mip, slice, x, y );
+                        CHECK( texel[0] == 77 && texel[1] == 0 && texel[2] == 255 && texel[3] == 100 + slice );
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE( MipGenerator_ArraysAndThreadsMatchSingleSlice )
+{
+    // Big enough for the first mips to be filtered on several threads.
+    const uint32_t size      = 256;
+    const uint32_t arraySize = 6;
+
+    for ( MipFilter filter: { MipFilter::Box, MipFilter::Kaiser } )
+    {
+        auto fill = []( double x, double y, uint32_t slice ) {
+            return std::sin( x * 0.37 + slice ) * std::cos( y * 0.11 - slice ) + 0.1 * slice;
+        };
+
+        MipGenerationSettings settings;
+        settings.Filter     = filter;
+        settings.NumThreads = 1;
+
+        TestTexture singleThreaded( size, size, arraySize, sizeof( float ) );
+        FillFloat( singleThreaded, fill );
+        singleThreaded.Generate( MipGenerator( settings ), DXGI_FORMAT_R32_FLOAT );
+
+        settings.NumThreads = 8;
+        TestTexture multithreaded( size, size, arraySize, sizeof( float ) );
+        FillFloat( multithreaded, fill );
+        multithreaded.Generate( MipGenerator( settings ), DXGI_FORMAT_R32_FLOAT );
+        CHECK( multithreaded == singleThreaded );
+
+        // Every slice is filtered on its own.
+        for ( uint32_t slice = 0; slice < arraySize; ++slice )
+        {
+            TestTexture texture( size, size, 1, sizeof( float ) );
+            FillFloat( texture, [&]( double x, double y, uint32_t ) { return fill( x, y, slice ); } );
+            texture.Generate( MipGenerator( settings ), DXGI_FORMAT_R32_FLOAT );
+
+            for ( uint32_t mip = 1; mip < texture.GetNumMips(); ++mip )
+            {
+                const MipGenerator::Subresource& subresource = texture.GetSubresource( mip );
+                CHECK( std::memcmp( subresource.Pixels, multithreaded.GetSubresource( mip, slice ).Pixels,
+                                    subresource.RowPitch * subresource.Height ) == 0 );
+            }
+        }
+    }
+}
@@ -0,0 +1,336 @@
+/**
+ * Measures the CPU cost of dx12lib per frame on the null device (see
+ * NullDevice.h): dynamic allocations, binding root arguments and descriptor
+ * tables, and submitting command lists. The null device doesn't execute any
+ * work, so the results don't include the cost of the driver.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/CommandList.h>
+#include <dx12lib/CommandQueue.h>
+#include <dx12lib/Device.h>
+#include <dx12lib/IndexBuffer.h>
+#include <dx12lib/NullDevice.h>
+#include <dx12lib/PipelineStateObject.h>
+#include <dx12lib/RootSignature.h>
+#include <dx12lib/Texture.h>
+#include <dx12lib/VertexBuffer.h>
+
+#include <d3dx12.h>
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+const uint32_t NumTextures        = 64;
+const uint32_t NumTexturesPerDraw = 8;
+const int      NumFrames          = 100;
+
+namespace RootParameters
+{
+enum
+{
+    PerDrawCB,      // ConstantBuffer<PerDrawConstants> PerDrawCB : register( b0 );
+    DrawConstants,  // ConstantBuffer<float4> DrawConstants : register( b1 );
+    Textures,       // Texture2D Textures[8] : register( t0 );
+    NumRootParameters
+};
+}
+
+struct PerDrawConstants
+{
+    float ModelViewProjection[16];
+    float Color[4];
+};
+
+// The pipeline state and the resources that the frames are recorded with.
+struct Scene
+{
+    std::shared_ptr<RootSignature>        Signature;
+    std::shared_ptr<PipelineStateObject>  PipelineState;
+    std::vector<std::shared_ptr<Texture>> Textures;
+    std::shared_ptr<VertexBuffer>         Vertices;
+    std::shared_ptr<IndexBuffer>          Indices;
+};
+
+Scene CreateScene( Device& device )
+{
+    Scene scene;
+
+    CD3DX12_DESCRIPTOR_RANGE1 textureRange( D3D12_DESCRIPTOR_RANGE_TYPE_SRV, NumTexturesPerDraw, 0 );
+
+    CD3DX12_ROOT_PARAMETER1 rootParameters[RootParameters::NumRootParameters];
+    rootParameters[RootParameters::PerDrawCB].InitAsConstantBufferView( 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+                                                                        D3D12_SHADER_VISIBILITY_VERTEX );
+    rootParameters[RootParameters::DrawConstants].InitAsConstants( 4, 1 );
+    rootParameters[RootParameters::Textures].InitAsDescriptorTable( 1, &textureRange, D3D12_SHADER_VISIBILITY_PIXEL );
+
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription(
+        RootParameters::NumRootParameters, rootParameters, 0, nullptr,
+        D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT );
+    scene.Signature = device.CreateRootSignature( rootSignatureDescription.Desc_1_1 );
+
+    // The null device doesn't compile or execute shaders.
+    static const uint8_t shaderByteCode[4] = {};
+
+    D3D12_INPUT_ELEMENT_DESC inputLayout[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+
+    D3D12_RT_FORMAT_ARRAY rtvFormats = {};
+    rtvFormats.NumRenderTargets      = 1;
+    rtvFormats.RTFormats[0]          = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    struct PipelineStateStream
+    {
+        CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE        pRootSignature;
+        CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT          InputLayout;
+        CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY    PrimitiveTopologyType;
+        CD3DX12_PIPELINE_STATE_STREAM_VS                    VS;
+        CD3DX12_PIPELINE_STATE_STREAM_PS                    PS;
+        CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT  DSVFormat;
+        CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RTVFormats;
+    } pipelineStateStream;
+
+    pipelineStateStream.pRootSignature        = scene.Signature->GetD3D12RootSignature().Get();
+    pipelineStateStream.InputLayout           = { inputLayout, _countof( inputLayout ) };
+    pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    pipelineStateStream.VS                    = CD3DX12_SHADER_BYTECODE( shaderByteCode, sizeof( shaderByteCode ) );
+    pipelineStateStream.PS                    = CD3DX12_SHADER_BYTECODE( shaderByteCode, sizeof( shaderByteCode ) );
+    pipelineStateStream.DSVFormat             = DXGI_FORMAT_D32_FLOAT;
+    pipelineStateStream.RTVFormats            = rtvFormats;
+
+    scene.PipelineState = device.CreatePipelineStateObject( pipelineStateStream );
+
+    auto textureDesc = CD3DX12_RESOURCE_DESC::Tex2D( DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256 );
+    for ( uint32_t i = 0; i < NumTextures; ++i )
+    {
+        scene.Textures.push_back( device.CreateTexture( textureDesc ) );
+    }
+
+    scene.Vertices = device.CreateVertexBuffer( 1024, 3 * sizeof( float ) );
+    scene.Indices  = device.CreateIndexBuffer( 3072, DXGI_FORMAT_R16_UINT );
+
+    return scene;
+}
+
+// Record draws that each allocate a constant buffer, set root constants, and bind
+// NumTexturesPerDraw textures.
+void RecordDraws( CommandList& commandList, const Scene& scene, uint32_t firstDraw, uint32_t numDraws )
+{
+    commandList.SetPipelineState( scene.PipelineState );
+    commandList.SetGraphicsRootSignature( scene.Signature );
+    commandList.SetViewport( CD3DX12_VIEWPORT( 0.0f, 0.0f, 1920.0f, 1080.0f ) );
+    commandList.SetScissorRect( CD3DX12_RECT( 0, 0, LONG_MAX, LONG_MAX ) );
+    commandList.SetPrimitiveTopology( D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+    commandList.SetVertexBuffer( 0, scene.Vertices );
+    commandList.SetIndexBuffer( scene.Indices );
+
+    PerDrawConstants constants = {};
+    for ( uint32_t draw = firstDraw; draw < firstDraw + numDraws; ++draw )
+    {
+        constants.Color[0] = static_cast<float>( draw );
+
+        commandList.SetGraphicsDynamicConstantBuffer( RootParameters::PerDrawCB, constants );
+        commandList.SetGraphics32BitConstants( RootParameters::DrawConstants, constants.Color );
+        for ( uint32_t i = 0; i < NumTexturesPerDraw; ++i )
+        {
+            commandList.SetShaderResourceView( RootParameters::Textures, i,
+                                               scene.Textures[( draw + i ) % NumTextures] );
+        }
+
+        commandList.DrawIndexed( 36 );
+    }
+}
+
+double Milliseconds( Clock::duration duration )
+{
+    return std::chrono::duration<double, std::milli>( duration ).count();
+}
+
+// Print the API calls that were made per frame.
+void PrintCounters( const NullDeviceCounters& counters, int numFrames )
+{
+    std::printf( "  API calls per frame:" );
+    for ( int i = 0; i < static_cast<int>( NullDeviceCounter::NumCounters ); ++i )
+    {
+        auto counter = static_cast<NullDeviceCounter>( i );
+        auto value   = counters.Get( counter );
+        if ( counter != NullDeviceCounter::NumCPUHeapBytes && value > 0 )
+        {
+            std::printf( " %s %.1f", NullDeviceCounters::GetName( counter ), static_cast<double>( value ) / numFrames );
+        }
+    }
+    std::printf( "\n  CPU heap memory: %.1f MiB\n",
+                 counters.Get( NullDeviceCounter::NumCPUHeapBytes ) / ( 1024.0 * 1024.0 ) );
+}
+
+}  // namespace
+
+TEST_CASE( Benchmark_NullDevice_RecordFrame )
+{
+    const uint32_t NumDraws = 5000;
+
+    auto  device       = Device::CreateNull();
+    auto& counters     = *device->GetNullDeviceCounters();
+    auto& commandQueue = device->GetCommandQueue( D3D12_COMMAND_LIST_TYPE_DIRECT );
+    Scene scene        = CreateScene( *device );
+
+    double recordTime = 0.0, executeTime = 0.0;
+    for ( int frame = -1; frame < NumFrames; ++frame )
+    {
+        // The first frame is a warm-up frame (upload pages and descriptor heaps are created on first use).
+        if ( frame == 0 )
+        {
+            counters.Reset();
+        }
+
+        auto startTime = Clock::now();
+
+        auto commandList = commandQueue.GetCommandList();
+        RecordDraws( *commandList, scene, 0, NumDraws );
+
+        auto recordedTime = Clock::now();
+        commandQueue.ExecuteCommandList( commandList );
+        auto executedTime = Clock::now();
+
+        if ( frame >= 0 )
+        {
+            recordTime += Milliseconds( recordedTime - startTime );
+            executeTime += Milliseconds( executedTime - recordedTime );
+        }
+    }
+
+    CHECK( counters.Get( NullDeviceCounter::Draw ) == static_cast<uint64_t>( NumDraws ) * NumFrames );
+
+    std::printf( "%u draws with %u textures: record %.3f ms/frame (%.1f ns/draw), execute %.3f ms/frame\n", NumDraws,
+                 NumTexturesPerDraw, recordTime / NumFrames, recordTime * 1.0e6 / ( NumFrames * NumDraws ),
+                 executeTime / NumFrames );
+    PrintCounters( counters, NumFrames );
+
+    device->Flush();
+}
+
+TEST_CASE( Benchmark_NullDevice_DynamicAllocations )
+{
+    const uint32_t NumConstantBuffers  = 20000;
+    const uint32_t NumDescriptorAllocs = 2000;
+    const uint32_t DescriptorsPerAlloc = 4;
+
+    auto  device       = Device::CreateNull();
+    auto& counters     = *device->GetNullDeviceCounters();
+    auto& commandQueue = device->GetCommandQueue( D3D12_COMMAND_LIST_TYPE_DIRECT );
+    Scene scene        = CreateScene( *device );
+
+    std::vector<DescriptorAllocation> descriptorAllocations;
+    descriptorAllocations.reserve( NumDescriptorAllocs );
+
+    double uploadTime = 0.0, descriptorTime = 0.0;
+    for ( int frame = -1; frame < NumFrames; ++frame )
+    {
+        if ( frame == 0 )
+        {
+            counters.Reset();
+        }
+
+        // Dynamic constant buffers are sub-allocated from the upload pages of the command list.
+        auto startTime   = Clock::now();
+        auto commandList = commandQueue.GetCommandList();
+        commandList->SetGraphicsRootSignature( scene.Signature );
+
+        PerDrawConstants constants = {};
+        for ( uint32_t i = 0; i < NumConstantBuffers; ++i )
+        {
+            commandList->SetGraphicsDynamicConstantBuffer( RootParameters::PerDrawCB, constants );
+        }
+        commandQueue.ExecuteCommandList( commandList );
+        auto uploadedTime = Clock::now();
+
+        // CPU visible descriptors are allocated from the descriptor allocator of the
+        // device and released at the end of the frame.
+        for ( uint32_t i = 0; i < NumDescriptorAllocs; ++i )
+        {
+            descriptorAllocations.push_back(
+                device->AllocateDescriptors( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, DescriptorsPerAlloc ) );
+        }
+        descriptorAllocations.clear();
+        device->ReleaseStaleDescriptors();
+        auto allocatedTime = Clock::now();
+
+        if ( frame >= 0 )
+        {
+            uploadTime += Milliseconds( uploadedTime - startTime );
+            descriptorTime += Milliseconds( allocatedTime - uploadedTime );
+        }
+    }
+
+    std::printf( "%u dynamic constant buffers: %.3f ms/frame (%.1f ns/allocation)\n", NumConstantBuffers,
+                 uploadTime / NumFrames, uploadTime * 1.0e6 / ( NumFrames * NumConstantBuffers ) );
+    std::printf( "%u descriptor allocations of %u descriptors: %.3f ms/frame (%.1f ns/allocation)\n",
+                 NumDescriptorAllocs, DescriptorsPerAlloc, descriptorTime / NumFrames,
+                 descriptorTime * 1.0e6 / ( NumFrames * NumDescriptorAllocs ) );
+    PrintCounters( counters, NumFrames );
+
+    device->Flush();
+}
+
+TEST_CASE( Benchmark_NullDevice_Submission )
+{
+    const uint32_t NumCommandLists        = 64;
+    const uint32_t NumDrawsPerCommandList = 16;
+
+    auto  device       = Device::CreateNull();
+    auto& counters     = *device->GetNullDeviceCounters();
+    auto& commandQueue = device->GetCommandQueue( D3D12_COMMAND_LIST_TYPE_DIRECT );
+    Scene scene        = CreateScene( *device );
+
+    std::vector<std::shared_ptr<CommandList>> commandLists( NumCommandLists );
+
+    double recordTime = 0.0, executeTime = 0.0;
+    for ( int frame = -1; frame < NumFrames; ++frame )
+    {
+        if ( frame == 0 )
+        {
+            counters.Reset();
+        }
+
+        auto startTime = Clock::now();
+        for ( uint32_t i = 0; i < NumCommandLists; ++i )
+        {
+            commandLists[i] = commandQueue.GetCommandList();
+            RecordDraws( *commandLists[i], scene, i * NumDrawsPerCommandList, NumDrawsPerCommandList );
+        }
+
+        // The resource state of the textures is resolved against the global state
+        // when the command lists are executed.
+        auto recordedTime = Clock::now();
+        commandQueue.ExecuteCommandLists( commandLists );
+        auto executedTime = Clock::now();
+
+        if ( frame >= 0 )
+        {
+            recordTime += Milliseconds( recordedTime - startTime );
+            executeTime += Milliseconds( executedTime - recordedTime );
+        }
+    }
+
+    CHECK( counters.Get( NullDeviceCounter::Draw ) ==
+           static_cast<uint64_t>( NumCommandLists ) * NumDrawsPerCommandList * NumFrames );
+
+    std::printf( "%u command lists of %u draws: record %.3f ms/frame, execute %.3f ms/frame (%.2f us/command list)\n",
+                 NumCommandLists, NumDrawsPerCommandList, recordTime / NumFrames, executeTime / NumFrames,
+                 executeTime * 1.0e3 / ( NumFrames * NumCommandLists ) );
+    PrintCounters( counters, NumFrames );
+
+    commandLists.clear();
+    device->Flush();
+}
@@ -0,0 +1,358 @@
+/**
+ * Tests that pipeline state streams and root signatures are hashed by their
+ * contents: equal descriptions get the same hash (and the same object from the
+ * cache) and a change to any field gets a different hash.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/Device.h>
+#include <dx12lib/PipelineStateCache.h>
+#include <dx12lib/PipelineStateObject.h>
+#include <dx12lib/RootSignature.h>
+
+#include <d3dx12.h>
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+struct PipelineStateStream
+{
+    CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE        pRootSignature;
+    CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT          InputLayout;
+    CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY    PrimitiveTopologyType;
+    CD3DX12_PIPELINE_STATE_STREAM_VS                    VS;
+    CD3DX12_PIPELINE_STATE_STREAM_PS                    PS;
+    CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER            Rasterizer;
+    CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC            Blend;
+    CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL         DepthStencil;
+    CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT  DSVFormat;
+    CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RTVFormats;
+    CD3DX12_PIPELINE_STATE_STREAM_SAMPLE_DESC           SampleDesc;
+};
+
+struct InputElement
+{
+    std::string                SemanticName;
+    UINT                       SemanticIndex;
+    DXGI_FORMAT                Format;
+    UINT                       InputSlot;
+    UINT                       AlignedByteOffset;
+    D3D12_INPUT_CLASSIFICATION InputSlotClass;
+    UINT                       InstanceDataStepRate;
+};
+
+// The state that a pipeline state stream is built from.
+struct PipelineState
+{
+    ID3D12RootSignature*          RootSignature = nullptr;
+    std::vector<uint8_t>          VertexShader  = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+    std::vector<uint8_t>          PixelShader   = { 'D', 'X', 'B', 'C', 5, 6, 7, 8 };
+    std::vector<InputElement>     InputElements = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE Topology     = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    D3D12_RASTERIZER_DESC         Rasterizer   = CD3DX12_RASTERIZER_DESC( D3D12_DEFAULT );
+    D3D12_BLEND_DESC              Blend        = CD3DX12_BLEND_DESC( D3D12_DEFAULT );
+    D3D12_DEPTH_STENCIL_DESC      DepthStencil = CD3DX12_DEPTH_STENCIL_DESC( D3D12_DEFAULT );
+    DXGI_FORMAT                   DSVFormat    = DXGI_FORMAT_D32_FLOAT;
+    D3D12_RT_FORMAT_ARRAY         RTVFormats   = { { DXGI_FORMAT_R8G8B8A8_UNORM }, 1 };
+    DXGI_SAMPLE_DESC              SampleDesc   = { 1, 0 };
+};
+
+// A pipeline state stream with its own copies of the shader bytecode and the
+// input layout, so equal streams have equal contents but not equal pointers.
+// The stream is constructed in memory that is filled with a byte pattern so
+// that the padding of the subobjects differs between streams.
+class Stream
+{
+public:
+    Stream( const PipelineState& state, uint8_t fill )
+    : m_VertexShader( state.VertexShader )
+    , m_PixelShader( state.PixelShader )
+    , m_InputElements( state.InputElements )
+    {
+        for ( auto& element: m_InputElements )
+        {
+            m_InputElementDescs.push_back( { element.SemanticName.c_str(), element.SemanticIndex, element.Format,
+                                             element.InputSlot, element.AlignedByteOffset, element.InputSlotClass,
+                                             element.InstanceDataStepRate } );
+        }
+
+        std::memset( m_Storage, fill, sizeof( m_Storage ) );
+        m_Stream = new ( m_Storage ) PipelineStateStream();
+
+        auto numInputElements = static_cast<UINT>( m_InputElementDescs.size() );
+
+        m_Stream->pRootSignature        = state.RootSignature;
+        m_Stream->InputLayout           = { m_InputElementDescs.data(), numInputElements };
+        m_Stream->PrimitiveTopologyType = state.Topology;
+        m_Stream->VS                    = { m_VertexShader.data(), m_VertexShader.size() };
+        m_Stream->PS                    = { m_PixelShader.data(), m_PixelShader.size() };
+
+        CD3DX12_RASTERIZER_DESC&    rasterizer   = m_Stream->Rasterizer;
+        CD3DX12_BLEND_DESC&         blend        = m_Stream->Blend;
+        CD3DX12_DEPTH_STENCIL_DESC& depthStencil = m_Stream->DepthStencil;
+
+        rasterizer   = CD3DX12_RASTERIZER_DESC( state.Rasterizer );
+        blend        = CD3DX12_BLEND_DESC( state.Blend );
+        depthStencil = CD3DX12_DEPTH_STENCIL_DESC( state.DepthStencil );
+
+        m_Stream->DSVFormat  = state.DSVFormat;
+        m_Stream->RTVFormats = state.RTVFormats;
+        m_Stream->SampleDesc = state.SampleDesc;
+    }
+
+    Stream( const Stream& ) = delete;
+    Stream& operator=( const Stream& ) = delete;
+
+    PipelineStateStream& Get()
+    {
+        return *m_Stream;
+    }
+
+private:
+    std::vector<uint8_t>                  m_VertexShader;
+    std::vector<uint8_t>                  m_PixelShader;
+    std::vector<InputElement>             m_InputElements;
+    std::vector<D3D12_INPUT_ELEMENT_DESC> m_InputElementDescs;
+
+    alignas( PipelineStateStream ) uint8_t m_Storage[sizeof( PipelineStateStream )];
+    PipelineStateStream* m_Stream;
+};
+
+// The hash of a stream whose root signature has a known hash.
+uint64_t GetHash( const PipelineState& state, uint8_t fill = 0, uint64_t rootSignatureHash = 1 )
+{
+    Stream stream( state, fill );
+
+    PipelineStateDesc desc( { sizeof( PipelineStateStream ), &stream.Get() },
+                            [rootSignatureHash]( ID3D12RootSignature* ) { return rootSignatureHash; } );
+
+    return desc.GetHash();
+}
+
+struct Mutation
+{
+    const char*                          Name;
+    std::function<void( PipelineState& )> Apply;
+};
+
+// Changes to a single field of the pipeline state that must change the hash.
+std::vector<Mutation> GetMutations()
+{
+    // clang-format off
+    return {
+        { "VS bytecode",             []( PipelineState& s ) { s.VertexShader.back() = 9; } },
+        { "VS bytecode length",      []( PipelineState& s ) { s.VertexShader.pop_back(); } },
+        { "PS bytecode",             []( PipelineState& s ) { s.PixelShader.back() = 9; } },
+        { "Number of elements",      []( PipelineState& s ) { s.InputElements.pop_back(); } },
+        { "SemanticName",            []( PipelineState& s ) { s.InputElements[1].SemanticName = "NORMAL"; } },
+        { "SemanticIndex",           []( PipelineState& s ) { s.InputElements[1].SemanticIndex = 1; } },
+        { "Element Format",          []( PipelineState& s ) { s.InputElements[1].Format = DXGI_FORMAT_R16G16_FLOAT; } },
+        { "InputSlot",               []( PipelineState& s ) { s.InputElements[1].InputSlot = 1; } },
+        { "AlignedByteOffset",       []( PipelineState& s ) { s.InputElements[1].AlignedByteOffset = 16; } },
+        { "InputSlotClass",          []( PipelineState& s ) { s.InputElements[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA; } },
+        { "InstanceDataStepRate",    []( PipelineState& s ) { s.InputElements[1].InstanceDataStepRate = 1; } },
+        { "Topology",                []( PipelineState& s ) { s.Topology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; } },
+        { "FillMode",                []( PipelineState& s ) { s.Rasterizer.FillMode = D3D12_FILL_MODE_WIREFRAME; } },
+        { "CullMode",                []( PipelineState& s ) { s.Rasterizer.CullMode = D3D12_CULL_MODE_NONE; } },
+        { "FrontCounterClockwise",   []( PipelineState& s ) { s.Rasterizer.FrontCounterClockwise = TRUE; } },
+        { "DepthBias",               []( PipelineState& s ) { s.Rasterizer.DepthBias = 1; } },
+        { "DepthBiasClamp",          []( PipelineState& s ) { s.Rasterizer.DepthBiasClamp = 1.0f; } },
+        { "SlopeScaledDepthBias",    []( PipelineState& s ) { s.Rasterizer.SlopeScaledDepthBias = 1.0f; } },
+        { "DepthClipEnable",         []( PipelineState& s ) { s.Rasterizer.DepthClipEnable = FALSE; } },
+        { "MultisampleEnable",       []( PipelineState& s ) { s.Rasterizer.MultisampleEnable = TRUE; } },
+        { "AntialiasedLineEnable",   []( PipelineState& s ) { s.Rasterizer.AntialiasedLineEnable = TRUE; } },
+        { "ForcedSampleCount",       []( PipelineState& s ) { s.Rasterizer.ForcedSampleCount = 4; } },
+        { "ConservativeRaster",      []( PipelineState& s ) { s.Rasterizer.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON; } },
+        { "AlphaToCoverageEnable",   []( PipelineState& s ) { s.Blend.AlphaToCoverageEnable = TRUE; } },
+        { "IndependentBlendEnable",  []( PipelineState& s ) { s.Blend.IndependentBlendEnable = TRUE; } },
+        { "BlendEnable",             []( PipelineState& s ) { s.Blend.RenderTarget[0].BlendEnable = TRUE; } },
+        { "LogicOpEnable",           []( PipelineState& s ) { s.Blend.RenderTarget[0].LogicOpEnable = TRUE; } },
+        { "SrcBlend",                []( PipelineState& s ) { s.Blend.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA; } },
+        { "DestBlend",               []( PipelineState& s ) { s.Blend.RenderTarget[0].DestBlend = D3D12_BLEND_INV_SRC_ALPHA; } },
+        { "BlendOp",                 []( PipelineState& s ) { s.Blend.RenderTarget[0].BlendOp = D3D12_BLEND_OP_MAX; } },
+        { "SrcBlendAlpha",           []( PipelineState& s ) { s.Blend.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ZERO; } },
+        { "DestBlendAlpha",          []( PipelineState& s ) { s.Blend.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ONE; } },
+        { "BlendOpAlpha",            []( PipelineState& s ) { s.Blend.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_MIN; } },
+        { "LogicOp",                 []( PipelineState& s ) { s.Blend.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_CLEAR; } },
+        { "RenderTargetWriteMask",   []( PipelineState& s ) { s.Blend.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_RED; } },
+        { "DepthEnable",             []( PipelineState& s ) { s.DepthStencil.DepthEnable = FALSE; } },
+        { "DepthWriteMask",          []( PipelineState& s ) { s.DepthStencil.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; } },
+        { "DepthFunc",               []( PipelineState& s ) { s.DepthStencil.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL; } },
+        { "StencilEnable",           []( PipelineState& s ) { s.DepthStencil.StencilEnable = TRUE; } },
+        { "StencilReadMask",         []( PipelineState& s ) { s.DepthStencil.StencilReadMask = 0x0f; } },
+        { "StencilWriteMask",        []( PipelineState& s ) { s.DepthStencil.StencilWriteMask = 0x0f; } },
+        { "FrontFace.StencilFailOp", []( PipelineState& s ) { s.DepthStencil.FrontFace.StencilFailOp = D3D12_STENCIL_OP_ZERO; } },
+        { "FrontFace.StencilPassOp", []( PipelineState& s ) { s.DepthStencil.FrontFace.StencilPassOp = D3D12_STENCIL_OP_INCR; } },
+        { "BackFace.StencilDepthFailOp", []( PipelineState& s ) { s.DepthStencil.BackFace.StencilDepthFailOp = D3D12_STENCIL_OP_DECR; } },
+        { "BackFace.StencilFunc",    []( PipelineState& s ) { s.DepthStencil.BackFace.StencilFunc = D3D12_COMPARISON_FUNC_NEVER; } },
+        { "DSVFormat",               []( PipelineState& s ) { s.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT; } },
+        { "RTFormats[0]",            []( PipelineState& s ) { s.RTVFormats.RTFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT; } },
+        { "NumRenderTargets",        []( PipelineState& s ) { s.RTVFormats.NumRenderTargets = 2; } },
+        { "SampleDesc.Count",        []( PipelineState& s ) { s.SampleDesc.Count = 4; } },
+        { "SampleDesc.Quality",      []( PipelineState& s ) { s.SampleDesc.Quality = 1; } },
+    };
+    // clang-format on
+}
+
+}  // namespace
+
+TEST_CASE( PipelineStateCache_EqualStreamsHaveEqualHashes )
+{
+    PipelineState state;
+
+    // Separate copies of the referenced data and different padding bytes.
+    CHECK( GetHash( state, 0x00 ) == GetHash( state, 0xcd ) );
+    CHECK( GetHash( state, 0xcd ) == GetHash( state, 0xff ) );
+}
+
+TEST_CASE( PipelineStateCache_IgnoresUnusedState )
+{
+    PipelineState state;
+    uint64_t      hash = GetHash( state );
+
+    // Only RTFormats[0] is used.
+    PipelineState unusedFormats = state;
+    unusedFormats.RTVFormats.RTFormats[5] = DXGI_FORMAT_R32_FLOAT;
+    CHECK( GetHash( unusedFormats ) == hash );
+
+    // Only RenderTarget[0] is used without independent blending.
+    PipelineState unusedBlendStates = state;
+    unusedBlendStates.Blend.RenderTarget[3].BlendEnable = TRUE;
+    unusedBlendStates.Blend.RenderTarget[3].SrcBlend    = D3D12_BLEND_SRC_ALPHA;
+    CHECK( GetHash( unusedBlendStates ) == hash );
+
+    // With independent blending, the blend state of every render target is used.
+    PipelineState independentBlend = state;
+    independentBlend.Blend.IndependentBlendEnable = TRUE;
+    PipelineState independentBlendRenderTarget3 = unusedBlendStates;
+    independentBlendRenderTarget3.Blend.IndependentBlendEnable = TRUE;
+    CHECK( GetHash( independentBlend ) != GetHash( independentBlendRenderTarget3 ) );
+}
+
+TEST_CASE( PipelineStateCache_AnyFieldChangesHash )
+{
+    PipelineState state;
+    uint64_t      hash = GetHash( state );
+
+    for ( auto& mutation: GetMutations() )
+    {
+        PipelineState changed = state;
+        mutation.Apply( changed );
+
+        if ( GetHash( changed ) == hash )
+        {
+            std::printf( "  Changing %s does not change the hash.\n", mutation.Name );
+        }
+        CHECK( GetHash( changed ) != hash );
+    }
+
+    // A different root signature.
+    CHECK( GetHash( state, 0, 2 ) != hash );
+}
+
+TEST_CASE( PipelineStateCache_PersistsOnlyKnownRootSignatures )
+{
+    PipelineState state;
+    Stream        stream( state, 0 );
+
+    D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { sizeof( PipelineStateStream ), &stream.Get() };
+
+    PipelineStateDesc known( streamDesc, []( ID3D12RootSignature* ) { return 1ull; } );
+    CHECK( known.IsPersistent() );
+
+    // The root signature is only known by its address.
+    PipelineStateDesc unknown( streamDesc, []( ID3D12RootSignature* ) { return 0ull; } );
+    CHECK( !unknown.IsPersistent() );
+
+    PipelineStateDesc noHashFunc( streamDesc );
+    CHECK( !noHashFunc.IsPersistent() );
+}
+
+TEST_CASE( PipelineStateCache_RootSignatureHash )
+{
+    auto getHash = []( D3D12_SHADER_VISIBILITY visibility, UINT numConstants, D3D12_ROOT_SIGNATURE_FLAGS flags ) {
+        CD3DX12_DESCRIPTOR_RANGE1 textureRange( D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 4, 0 );
+
+        CD3DX12_ROOT_PARAMETER1 rootParameters[3];
+        rootParameters[0].InitAsConstantBufferView( 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, visibility );
+        rootParameters[1].InitAsConstants( numConstants, 1 );
+        rootParameters[2].InitAsDescriptorTable( 1, &textureRange, D3D12_SHADER_VISIBILITY_PIXEL );
+
+        CD3DX12_STATIC_SAMPLER_DESC sampler( 0, D3D12_FILTER_ANISOTROPIC );
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1( _countof( rootParameters ), rootParameters, 1, &sampler, flags );
+
+        return HashRootSignatureDesc( rootSignatureDesc.Desc_1_1 );
+    };
+
+    const auto flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+    uint64_t   hash  = getHash( D3D12_SHADER_VISIBILITY_VERTEX, 4, flags );
+
+    // The parameters are built in a new array every time.
+    CHECK( getHash( D3D12_SHADER_VISIBILITY_VERTEX, 4, flags ) == hash );
+
+    CHECK( getHash( D3D12_SHADER_VISIBILITY_ALL, 4, flags ) != hash );
+    CHECK( getHash( D3D12_SHADER_VISIBILITY_VERTEX, 8, flags ) != hash );
+    CHECK( getHash( D3D12_SHADER_VISIBILITY_VERTEX, 4, D3D12_ROOT_SIGNATURE_FLAG_NONE ) != hash );
+}
+
+TEST_CASE( PipelineStateCache_DeduplicatesOnNullDevice )
+{
+    auto device = Device::CreateNull();
+    auto cache  = device->CreatePipelineStateCache();
+
+    CD3DX12_ROOT_PARAMETER1 rootParameter;
+    rootParameter.InitAsConstants( 4, 0 );
+
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+    rootSignatureDesc.Init_1_1( 1, &rootParameter, 0, nullptr,
+                                D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT );
+
+    auto rootSignature = cache->GetRootSignature( rootSignatureDesc.Desc_1_1 );
+    CHECK( cache->GetRootSignature( rootSignatureDesc.Desc_1_1 ) == rootSignature );
+
+    PipelineState state;
+    state.RootSignature = rootSignature->GetD3D12RootSignature().Get();
+
+    Stream stream( state, 0x00 );
+    Stream equalStream( state, 0xcd );
+
+    auto pipelineStateObject = cache->GetPipelineStateObject( stream.Get() );
+    CHECK( cache->GetPipelineStateObject( equalStream.Get() ) == pipelineStateObject );
+
+    // A change to any field misses the cache.
+    auto mutations = GetMutations();
+    for ( auto& mutation: mutations )
+    {
+        PipelineState changed = state;
+        mutation.Apply( changed );
+
+        Stream changedStream( changed, 0 );
+        CHECK( cache->GetPipelineStateObject( changedStream.Get() ) != pipelineStateObject );
+    }
+
+    auto statistics = cache->GetStatistics();
+    CHECK( statistics.NumRootSignatureRequests == 2 );
+    CHECK( statistics.NumRootSignatureHits == 1 );
+    CHECK( statistics.NumPipelineStateRequests == 2 + mutations.size() );
+    CHECK( statistics.NumPipelineStateHits == 1 );
+    CHECK( statistics.NumPipelineStatesCreated == 1 + mutations.size() );
+
+    // The device creates its pipeline state objects through its own cache.
+    auto devicePipelineStateObject = device->CreatePipelineStateObject( stream.Get() );
+    CHECK( device->CreatePipelineStateObject( equalStream.Get() ) == devicePipelineStateObject );
+}
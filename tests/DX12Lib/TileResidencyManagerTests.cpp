@@ -0,0 +1,331 @@
+/**
+ * Tests the page table and the eviction policy of the TileResidencyManager
+ * with synthetic access traces.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/TileResidencyManager.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+// A texture with a single mip level of numTiles x 1 tiles (requests don't imply other tiles).
+uint32_t RegisterStrip( TileResidencyManager& manager, uint32_t numTiles )
+{
+    return manager.RegisterTexture( { { numTiles, 1 } } );
+}
+
+void RequestStrip( TileResidencyManager& manager, uint32_t textureId, const std::vector<uint32_t>& tiles )
+{
+    for ( uint32_t x: tiles )
+    {
+        manager.RequestTile( { textureId, 0, x, 0 } );
+    }
+}
+
+}  // namespace
+
+TEST_CASE( TileResidencyManager_PackRoundTrips )
+{
+    const TileCoord tile = { 0x123456, 11, 0xfedc, 0x1234 };
+    const TileCoord back = TileCoord::Unpack( tile.Pack() );
+
+    CHECK( back.TextureId == tile.TextureId );
+    CHECK( back.MipLevel == tile.MipLevel );
+    CHECK( back.X == tile.X );
+    CHECK( back.Y == tile.Y );
+}
+
+TEST_CASE( TileResidencyManager_MapsLessDetailedMipsFirst )
+{
+    TileResidencyManager manager( 16 );
+    const uint32_t       textureId = manager.RegisterTexture( { { 4, 4 }, { 2, 2 }, { 1, 1 } } );
+
+    // Nothing is resident, the residency map points at the packed mips.
+    for ( uint8_t mip: manager.GetResidencyMap( textureId ) )
+    {
+        CHECK( mip == 3 );
+    }
+
+    manager.RequestTile( { textureId, 0, 3, 2 } );
+    auto update = manager.ProcessRequests( 1 );
+
+    // The request implies the tiles of the less detailed mips that cover it.
+    REQUIRE( update.MappedTiles.size() == 3 );
+    CHECK( update.MappedTiles[0].Tile == TileCoord( { textureId, 2, 0, 0 } ) );
+    CHECK( update.MappedTiles[1].Tile == TileCoord( { textureId, 1, 1, 1 } ) );
+    CHECK( update.MappedTiles[2].Tile == TileCoord( { textureId, 0, 3, 2 } ) );
+    CHECK( update.UnmappedTiles.empty() );
+    REQUIRE( update.DirtyTextures.size() == 1 );
+    CHECK( update.DirtyTextures[0] == textureId );
+
+    // The residency map stores the most detailed resident mip of each tile of mip 0.
+    const auto& residencyMap = manager.GetResidencyMap( textureId );
+    for ( uint32_t y = 0; y < 4; ++y )
+    {
+        for ( uint32_t x = 0; x < 4; ++x )
+        {
+            uint8_t expectedMip = ( x == 3 && y == 2 ) ? 0 : ( x >= 2 && y >= 2 ) ? 1 : 2;
+            CHECK( residencyMap[y * 4 + x] == expectedMip );
+        }
+    }
+
+    // Requesting the same tile again hits all three tiles.
+    manager.RequestTile( { textureId, 0, 3, 2 } );
+    update = manager.ProcessRequests( 2 );
+    CHECK( update.MappedTiles.empty() );
+    CHECK( update.DirtyTextures.empty() );
+
+    auto statistics = manager.GetStatistics();
+    CHECK( statistics.NumRequests == 6 );
+    CHECK( statistics.NumHits == 3 );
+    CHECK( statistics.NumMisses == 3 );
+    CHECK( statistics.NumResidentTiles == 3 );
+}
+
+TEST_CASE( TileResidencyManager_EvictsLeastRecentlyUsedAfterDelay )
+{
+    TileResidencyManager manager( 4, 64, 2 );
+    const uint32_t       textureId = RegisterStrip( manager, 8 );
+
+    RequestStrip( manager, textureId, { 0, 1, 2, 3 } );
+    auto update = manager.ProcessRequests( 1 );
+    REQUIRE( update.MappedTiles.size() == 4 );
+    const uint32_t physicalTile = update.MappedTiles[1].PhysicalTile;
+
+    // Tile 1 becomes the least recently used tile.
+    RequestStrip( manager, textureId, { 0, 2, 3 } );
+    CHECK( manager.ProcessRequests( 2 ).MappedTiles.empty() );
+
+    // The pool is full: tile 1 is evicted, but its physical tile is only reused after the eviction delay.
+    RequestStrip( manager, textureId, { 0, 2, 3, 4 } );
+    update = manager.ProcessRequests( 3 );
+    CHECK( update.MappedTiles.empty() );
+    CHECK( !manager.IsResident( { textureId, 0, 1, 0 } ) );
+    CHECK( manager.GetStatistics().NumEvicted == 1 );
+    CHECK( manager.GetStatistics().NumDeferred == 1 );
+
+    // The miss is deferred again, without evicting another tile.
+    RequestStrip( manager, textureId, { 0, 2, 3, 4 } );
+    update = manager.ProcessRequests( 4 );
+    CHECK( update.MappedTiles.empty() );
+    CHECK( update.UnmappedTiles.empty() );
+    CHECK( manager.GetStatistics().NumEvicted == 1 );
+
+    RequestStrip( manager, textureId, { 0, 2, 3, 4 } );
+    update = manager.ProcessRequests( 5 );
+    REQUIRE( update.UnmappedTiles.size() == 1 );
+    REQUIRE( update.MappedTiles.size() == 1 );
+    CHECK( update.UnmappedTiles[0].Tile == TileCoord( { textureId, 0, 1, 0 } ) );
+    CHECK( update.UnmappedTiles[0].PhysicalTile == physicalTile );
+    CHECK( update.MappedTiles[0].Tile == TileCoord( { textureId, 0, 4, 0 } ) );
+    CHECK( update.MappedTiles[0].PhysicalTile == physicalTile );
+}
+
+TEST_CASE( TileResidencyManager_KeepsTilesOfCurrentFrame )
+{
+    TileResidencyManager manager( 2, 64, 1 );
+    const uint32_t       textureId = RegisterStrip( manager, 4 );
+
+    // Only two of the three tiles fit, and neither of them can be evicted for the third.
+    RequestStrip( manager, textureId, { 0, 1, 2 } );
+    auto update = manager.ProcessRequests( 1 );
+    CHECK( update.MappedTiles.size() == 2 );
+    CHECK( manager.IsResident( { textureId, 0, 0, 0 } ) );
+    CHECK( manager.IsResident( { textureId, 0, 1, 0 } ) );
+
+    auto statistics = manager.GetStatistics();
+    CHECK( statistics.NumEvicted == 0 );
+    CHECK( statistics.NumDeferred == 1 );
+}
+
+TEST_CASE( TileResidencyManager_LimitsTilesPerUpdate )
+{
+    TileResidencyManager manager( 16, 2 );
+    const uint32_t       textureId = RegisterStrip( manager, 5 );
+
+    RequestStrip( manager, textureId, { 0, 1, 2, 3, 4 } );
+    CHECK( manager.ProcessRequests( 1 ).MappedTiles.size() == 2 );
+    CHECK( manager.GetStatistics().NumDeferred == 3 );
+
+    RequestStrip( manager, textureId, { 0, 1, 2, 3, 4 } );
+    CHECK( manager.ProcessRequests( 2 ).MappedTiles.size() == 2 );
+
+    RequestStrip( manager, textureId, { 0, 1, 2, 3, 4 } );
+    CHECK( manager.ProcessRequests( 3 ).MappedTiles.size() == 1 );
+    CHECK( manager.GetStatistics().NumResidentTiles == 5 );
+}
+
+TEST_CASE( TileResidencyManager_ReservedTiles )
+{
+    TileResidencyManager manager( 4, 64, 3 );
+    const uint32_t       textureId = RegisterStrip( manager, 4 );
+
+    auto reservedTiles = manager.ReservePhysicalTiles( 3 );
+    CHECK( reservedTiles.size() == 3 );
+    CHECK( manager.GetStatistics().NumReservedTiles == 3 );
+
+    bool threw = false;
+    try
+    {
+        manager.ReservePhysicalTiles( 2 );
+    }
+    catch ( const std::bad_alloc& )
+    {
+        threw = true;
+    }
+    CHECK( threw );
+
+    RequestStrip( manager, textureId, { 1, 2 } );
+    CHECK( manager.ProcessRequests( 1 ).MappedTiles.size() == 1 );
+
+    // Released tiles are reused after the eviction delay and are not reported as unmapped.
+    manager.ReleasePhysicalTiles( reservedTiles, 1 );
+    CHECK( manager.GetStatistics().NumReservedTiles == 0 );
+
+    RequestStrip( manager, textureId, { 1, 2 } );
+    CHECK( manager.ProcessRequests( 2 ).MappedTiles.empty() );
+
+    RequestStrip( manager, textureId, { 1, 2, 3 } );
+    auto update = manager.ProcessRequests( 4 );
+    CHECK( update.UnmappedTiles.empty() );
+    CHECK( update.MappedTiles.size() == 2 );
+}
+
+TEST_CASE( TileResidencyManager_UnregisterEvictsTexture )
+{
+    TileResidencyManager manager( 8, 64, 1 );
+    const uint32_t       first  = RegisterStrip( manager, 2 );
+    const uint32_t       second = RegisterStrip( manager, 2 );
+    CHECK( first != second );
+
+    RequestStrip( manager, first, { 0, 1 } );
+    RequestStrip( manager, second, { 0 } );
+    CHECK( manager.ProcessRequests( 1 ).MappedTiles.size() == 3 );
+
+    manager.UnregisterTexture( first, 1 );
+    CHECK( manager.GetStatistics().NumResidentTiles == 1 );
+    CHECK( manager.GetResidencyMap( first ).empty() );
+
+    // Requests for the unregistered texture are ignored.
+    RequestStrip( manager, first, { 0 } );
+    auto update = manager.ProcessRequests( 2 );
+    CHECK( update.MappedTiles.empty() );
+    CHECK( update.UnmappedTiles.size() == 2 );
+    CHECK( update.DirtyTextures.empty() );
+}
+
+TEST_CASE( TileResidencyManager_RandomTraces )
+{
+    const uint32_t NumPhysicalTiles = 48;
+    const uint32_t EvictionDelay    = 3;
+
+    std::mt19937         random( 7 );
+    TileResidencyManager manager( NumPhysicalTiles, 16, EvictionDelay );
+
+    std::vector<uint32_t> textureIds;
+    for ( int i = 0; i < 4; ++i )
+    {
+        textureIds.push_back( manager.RegisterTexture( { { 8, 6 }, { 4, 3 }, { 2, 2 }, { 1, 1 } } ) );
+    }
+
+    // The mappings that the GPU would have, to check that a physical tile is never mapped to two
+    // virtual tiles and is only reused after the eviction delay.
+    std::map<uint64_t, uint32_t> virtualToPhysical;
+    std::map<uint32_t, uint64_t> physicalOwner;
+    std::map<uint32_t, uint64_t> physicalEvictedFrame;
+
+    for ( uint64_t frame = 1; frame < 500; ++frame )
+    {
+        // The camera looks at a region of one of the textures that moves slowly over time.
+        const uint32_t textureId = textureIds[( frame / 50 ) % textureIds.size()];
+        const uint32_t centerX   = static_cast<uint32_t>( frame / 8 ) % 8;
+        for ( int i = 0; i < 20; ++i )
+        {
+            uint32_t mip = random() % 2;
+            uint32_t x   = ( centerX + random() % 3 ) % 8;
+            uint32_t y   = random() % 6;
+            manager.RequestTile( { textureId, mip, x >> mip, y >> mip } );
+        }
+
+        auto update = manager.ProcessRequests( frame );
+
+        for ( const auto& mapping: update.UnmappedTiles )
+        {
+            auto iter = virtualToPhysical.find( mapping.Tile.Pack() );
+            REQUIRE( iter != virtualToPhysical.end() );
+            CHECK( iter->second == mapping.PhysicalTile );
+            virtualToPhysical.erase( iter );
+            physicalOwner.erase( mapping.PhysicalTile );
+        }
+
+        for ( const auto& mapping: update.MappedTiles )
+        {
+            // The physical tile is free or it belongs to a tile that was mapped again in the meantime.
+            auto owner = physicalOwner.find( mapping.PhysicalTile );
+            if ( owner != physicalOwner.end() )
+            {
+                CHECK( virtualToPhysical[owner->second] != mapping.PhysicalTile );
+            }
+            auto evicted = physicalEvictedFrame.find( mapping.PhysicalTile );
+            if ( evicted != physicalEvictedFrame.end() )
+            {
+                CHECK( frame >= evicted->second + EvictionDelay );
+                physicalEvictedFrame.erase( evicted );
+            }
+
+            virtualToPhysical[mapping.Tile.Pack()] = mapping.PhysicalTile;
+            physicalOwner[mapping.PhysicalTile]    = mapping.Tile.Pack();
+        }
+
+        // Record when the resident tiles are evicted.
+        for ( const auto& mapping: virtualToPhysical )
+        {
+            if ( physicalOwner[mapping.second] == mapping.first &&
+                 !manager.IsResident( TileCoord::Unpack( mapping.first ) ) &&
+                 physicalEvictedFrame.count( mapping.second ) == 0 )
+            {
+                physicalEvictedFrame[mapping.second] = frame;
+            }
+        }
+
+        CHECK( manager.GetStatistics().NumResidentTiles <= NumPhysicalTiles );
+    }
+
+    // The residency map matches the resident tiles.
+    for ( uint32_t textureId: textureIds )
+    {
+        const auto& residencyMap = manager.GetResidencyMap( textureId );
+        for ( uint32_t y = 0; y < 6; ++y )
+        {
+            for ( uint32_t x = 0; x < 8; ++x )
+            {
+                uint8_t residentMip = 4;
+                for ( uint32_t mip = 4; mip-- > 0; )
+                {
+                    const auto& mipTiling = manager.GetMipTiling( textureId )[mip];
+                    TileCoord   tile      = { textureId, mip, std::min( x >> mip, mipTiling.WidthInTiles - 1 ),
+                                       std::min( y >> mip, mipTiling.HeightInTiles - 1 ) };
+                    if ( !manager.IsResident( tile ) )
+                        break;
+
+                    residentMip = static_cast<uint8_t>( mip );
+                }
+                CHECK( residencyMap[y * 8 + x] == residentMip );
+            }
+        }
+    }
+
+    // Tiles of the textures that are looked at most recently are resident most of the time.
+    auto statistics = manager.GetStatistics();
+    CHECK( statistics.NumEvicted > 0 );
+    CHECK( statistics.GetHitRate() > 0.5 );
+}
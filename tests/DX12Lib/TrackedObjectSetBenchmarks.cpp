@@ -0,0 +1,131 @@
+/**
+ * Compares the CPU cost per draw of keeping the objects that a command list
+ * references alive with the TrackedObjectSet against pushing a reference for
+ * every use (how CommandList::TrackResource used to track objects).
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/TrackedObjectSet.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+// An object with an atomic reference count like a D3D12 object (it is owned by the benchmark).
+class FakeObject : public ID3D12Object
+{
+public:
+    FakeObject()
+    : RefCount( 1 )
+    {}
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface( REFIID, void** object ) override
+    {
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++RefCount;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        return --RefCount;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetPrivateData( REFGUID, UINT*, void* ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetPrivateData( REFGUID, UINT, const void* ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetPrivateDataInterface( REFGUID, const IUnknown* ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetName( LPCWSTR ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    std::atomic<ULONG> RefCount;
+};
+
+}  // namespace
+
+TEST_CASE( Benchmark_TrackedObjectSet_PerDrawTracking )
+{
+    const uint32_t NumObjects        = 2000;
+    const uint32_t NumDraws          = 10000;
+    const uint32_t NumObjectsPerDraw = 12;
+    const int      NumFrames         = 100;
+
+    std::mt19937 random( 8 );
+
+    // Each draw references the pipeline state, the root signature, a few
+    // buffers and some textures of the scene.
+    std::vector<FakeObject>    objects( NumObjects );
+    std::vector<ID3D12Object*> drawObjects( NumDraws * NumObjectsPerDraw );
+    for ( uint32_t draw = 0; draw < NumDraws; ++draw )
+    {
+        ID3D12Object** objectsOfDraw = &drawObjects[draw * NumObjectsPerDraw];
+        objectsOfDraw[0]             = &objects[draw / 1000];
+        objectsOfDraw[1]             = &objects[10];
+        for ( uint32_t i = 2; i < NumObjectsPerDraw; ++i )
+        {
+            objectsOfDraw[i] = &objects[11 + random() % ( NumObjects - 11 )];
+        }
+    }
+
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Object>> trackedObjects;
+    TrackedObjectSet                                  trackedObjectSet;
+
+    double pushTime = 0.0, setTime = 0.0;
+    for ( int frame = 0; frame < NumFrames; ++frame )
+    {
+        auto startTime = Clock::now();
+
+        for ( ID3D12Object* object: drawObjects )
+        {
+            trackedObjects.emplace_back( object );
+        }
+        trackedObjects.clear();
+
+        auto pushedTime = Clock::now();
+
+        for ( ID3D12Object* object: drawObjects )
+        {
+            trackedObjectSet.Insert( object );
+        }
+        trackedObjectSet.Clear();
+
+        auto insertedTime = Clock::now();
+
+        pushTime += std::chrono::duration<double, std::milli>( pushedTime - startTime ).count();
+        setTime += std::chrono::duration<double, std::milli>( insertedTime - pushedTime ).count();
+    }
+
+    CHECK( objects[0].RefCount == 1 );
+
+    std::printf( "%u draws referencing %u objects each: reference per use %.3f ms/frame (%.1f ns/draw), "
+                 "TrackedObjectSet %.3f ms/frame (%.1f ns/draw)\n",
+                 NumDraws, NumObjectsPerDraw, pushTime / NumFrames, pushTime * 1.0e6 / ( NumFrames * NumDraws ),
+                 setTime / NumFrames, setTime * 1.0e6 / ( NumFrames * NumDraws ) );
+}
@@ -0,0 +1,140 @@
+/**
+ * Tests that the TrackedObjectSet holds a single reference to every object
+ * that is added to it.
+ */
+
+#include "TestHarness.h"
+
+#include <dx12lib/TrackedObjectSet.h>
+
+#include <vector>
+
+using namespace dx12lib;
+
+namespace
+{
+
+// An object that only counts its references (it is owned by the test).
+class FakeObject : public ID3D12Object
+{
+public:
+    FakeObject()
+    : RefCount( 1 )
+    {}
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface( REFIID, void** object ) override
+    {
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++RefCount;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        return --RefCount;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetPrivateData( REFGUID, UINT*, void* ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetPrivateData( REFGUID, UINT, const void* ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetPrivateDataInterface( REFGUID, const IUnknown* ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetName( LPCWSTR ) override
+    {
+        return E_NOTIMPL;
+    }
+
+    ULONG RefCount;
+};
+
+}  // namespace
+
+TEST_CASE( TrackedObjectSet_InsertDeduplicates )
+{
+    std::vector<FakeObject> objects( 3 );
+    TrackedObjectSet        set;
+
+    CHECK( set.Insert( &objects[0] ) );
+    CHECK( set.Insert( &objects[1] ) );
+    CHECK( !set.Insert( &objects[0] ) );
+    CHECK( set.Insert( &objects[2] ) );
+    CHECK( !set.Insert( &objects[1] ) );
+    CHECK( !set.Insert( nullptr ) );
+
+    CHECK( set.Size() == 3 );
+    for ( auto& object: objects )
+    {
+        CHECK( set.Contains( &object ) );
+        CHECK( object.RefCount == 2 );
+    }
+}
+
+TEST_CASE( TrackedObjectSet_ClearReleasesObjects )
+{
+    std::vector<FakeObject> objects( 8 );
+    TrackedObjectSet        set;
+
+    // The set is reused for many command lists.
+    for ( int generation = 0; generation < 100; ++generation )
+    {
+        for ( int i = 0; i < 3; ++i )
+        {
+            for ( size_t j = generation % 2; j < objects.size(); j += 2 )
+            {
+                set.Insert( &objects[j] );
+            }
+        }
+        CHECK( set.Size() == objects.size() / 2 );
+        CHECK( set.Contains( &objects[generation % 2] ) );
+        CHECK( !set.Contains( &objects[1 - generation % 2] ) );
+
+        set.Clear();
+        CHECK( set.Size() == 0 );
+        for ( auto& object: objects )
+        {
+            CHECK( !set.Contains( &object ) );
+            CHECK( object.RefCount == 1 );
+        }
+    }
+}
+
+TEST_CASE( TrackedObjectSet_Grows )
+{
+    std::vector<FakeObject> objects( 5000 );
+    TrackedObjectSet        set( 16 );
+
+    for ( int pass = 0; pass < 2; ++pass )
+    {
+        for ( auto& object: objects )
+        {
+            CHECK( set.Insert( &object ) == ( pass == 0 ) );
+        }
+    }
+
+    CHECK( set.Size() == objects.size() );
+    for ( auto& object: objects )
+    {
+        CHECK( set.Contains( &object ) );
+        CHECK( object.RefCount == 2 );
+    }
+
+    set.Clear();
+    for ( auto& object: objects )
+    {
+        CHECK( object.RefCount == 1 );
+    }
+}
@@ -0,0 +1,130 @@
+/**
+ * Compares the cost of invoking a FastDelegate with invoking the sig::signal it
+ * replaced for the high-frequency events (Update, MouseMoved), and measures the
+ * cost of invoking while another thread connects and disconnects callbacks.
+ */
+
+#include "TestHarness.h"
+
+#include <GameFramework/FastDelegate.h>
+#include <signals/signals.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct MotionArgs
+{
+    int RelX = 1;
+    int RelY = 2;
+};
+
+// A member function callback, like the OnMouseMoved of a sample.
+struct Listener
+{
+    void OnMouseMoved( MotionArgs& e )
+    {
+        Sum += e.RelX;
+    }
+
+    int64_t Sum = 0;
+};
+
+// Returns the average time of a call in nanoseconds.
+template<typename Func>
+double TimePerCall( Func&& func, int numCalls )
+{
+    auto startTime = Clock::now();
+    for ( int i = 0; i < numCalls; ++i )
+    {
+        func();
+    }
+    std::chrono::duration<double, std::nano> time = Clock::now() - startTime;
+    return time.count() / numCalls;
+}
+
+}  // namespace
+
+TEST_CASE( Benchmark_FastDelegate_Invoke )
+{
+    // The game always runs several threads. Start one so that the reference
+    // counting of the shared_ptrs that sig::signal copies is atomic (libstdc++
+    // skips the atomics in single-threaded programs).
+    std::thread( []() {} ).join();
+
+    std::printf( "%10s %14s %14s\n", "Listeners", "sig::signal", "FastDelegate" );
+
+    for ( int numListeners: { 0, 1, 4, 16, 64, 256 } )
+    {
+        std::vector<Listener>             listeners( numListeners );
+        sig::signal<void( MotionArgs& )>  signal;
+        FastDelegate<void( MotionArgs& )> fastDelegate;
+        using Slot = FastDelegate<void( MotionArgs& )>::slot;
+
+        for ( auto& listener: listeners )
+        {
+            signal.connect( &Listener::OnMouseMoved, &listener );
+            fastDelegate += Slot( &Listener::OnMouseMoved, &listener );
+        }
+
+        MotionArgs e;
+        int        numCalls = 2000000 / ( numListeners + 1 );
+
+        // Warm up the caches before measuring.
+        TimePerCall( [&]() { signal( e ); }, numCalls );
+        TimePerCall( [&]() { fastDelegate( e ); }, numCalls );
+
+        double signalTime       = TimePerCall( [&]() { signal( e ); }, numCalls );
+        double fastDelegateTime = TimePerCall( [&]() { fastDelegate( e ); }, numCalls );
+
+        std::printf( "%10d %11.1f ns %11.1f ns\n", numListeners, signalTime, fastDelegateTime );
+    }
+}
+
+TEST_CASE( Benchmark_FastDelegate_InvokeWhileConnecting )
+{
+    const int NumListeners = 4;
+    const int NumCalls     = 1000000;
+
+    std::vector<Listener>             listeners( NumListeners );
+    FastDelegate<void( MotionArgs& )> fastDelegate;
+    using Slot = FastDelegate<void( MotionArgs& )>::slot;
+
+    for ( auto& listener: listeners )
+    {
+        fastDelegate += Slot( &Listener::OnMouseMoved, &listener );
+    }
+
+    MotionArgs e;
+    double     idleTime = TimePerCall( [&]() { fastDelegate( e ); }, NumCalls );
+
+    // Another thread keeps connecting and disconnecting a callback, so every
+    // invocation races with the publishing of a new array of callbacks.
+    std::atomic<bool>    stop { false };
+    std::atomic<int64_t> numConnections { 0 };
+    std::thread          connectThread( [&]() {
+        Listener listener;
+        while ( !stop )
+        {
+            FastConnection connection = fastDelegate += Slot( &Listener::OnMouseMoved, &listener );
+            connection.Disconnect();
+            ++numConnections;
+        }
+    } );
+
+    double busyTime = TimePerCall( [&]() { fastDelegate( e ); }, NumCalls );
+
+    stop = true;
+    connectThread.join();
+
+    std::printf( "Invoke (%d listeners): %.1f ns idle, %.1f ns while connecting (%lld connections)\n", NumListeners,
+                 idleTime, busyTime, static_cast<long long>( numConnections.load() ) );
+}
@@ -0,0 +1,131 @@
+/**
+ * Tests the FastDelegate (connecting, disconnecting and tracked objects) and the
+ * EventCoalescer.
+ */
+
+#include "TestHarness.h"
+
+#include <GameFramework/FastDelegate.h>
+
+#include <memory>
+
+namespace
+{
+
+struct Listener
+{
+    void OnEvent( int& value )
+    {
+        Sum += value;
+    }
+
+    int Sum = 0;
+};
+
+}  // namespace
+
+TEST_CASE( FastDelegate_ConnectAndDisconnect )
+{
+    FastDelegate<int( int )> fastDelegate;
+
+    // Invoking a delegate without callbacks returns no result.
+    CHECK( !fastDelegate( 1 ) );
+
+    FastConnection connection = fastDelegate += []( int x ) { return x + 1; };
+    CHECK( fastDelegate.Size() == 1 );
+    CHECK( connection.IsConnected() );
+
+    auto result = fastDelegate( 1 );
+    REQUIRE( result );
+    CHECK( *result == 2 );
+
+    CHECK( ( fastDelegate -= connection ) == 1 );
+    CHECK( fastDelegate.Size() == 0 );
+    CHECK( !fastDelegate( 1 ) );
+
+    // The callback was already removed.
+    CHECK( !connection.Disconnect() );
+}
+
+TEST_CASE( FastDelegate_TrackedObject )
+{
+    FastDelegate<void( int& )> fastDelegate;
+    using Slot = FastDelegate<void( int& )>::slot;
+
+    auto listener = std::make_shared<Listener>();
+    fastDelegate += Slot( &Listener::OnEvent, listener );
+
+    int value = 1;
+    fastDelegate( value );
+    CHECK( listener->Sum == 1 );
+
+    // The callback of an expired object is skipped.
+    std::weak_ptr<Listener> weakListener = listener;
+    listener.reset();
+    fastDelegate( value );
+    CHECK( weakListener.expired() );
+}
+
+TEST_CASE( FastDelegate_DisconnectWhileInvoking )
+{
+    FastDelegate<void()> fastDelegate;
+    FastConnection       connection;
+    int                  numCalls = 0;
+
+    // A callback that disconnects itself is still invoked once.
+    connection = fastDelegate += [&]() {
+        ++numCalls;
+        connection.Disconnect();
+    };
+    fastDelegate += [&]() { ++numCalls; };
+
+    fastDelegate();
+    fastDelegate();
+    CHECK( numCalls == 3 );
+
+    // A scoped connection is disconnected when it goes out of scope.
+    {
+        ScopedFastConnection scopedConnection = fastDelegate += [&]() { numCalls += 10; };
+        fastDelegate();
+    }
+    fastDelegate();
+    CHECK( numCalls == 3 + 11 + 1 );
+}
+
+TEST_CASE( EventCoalescer_MergesEvents )
+{
+    EventCoalescer<int> coalescer( []( int& pending, const int& next ) { pending += next; } );
+
+    int  numCalls = 0;
+    int  sum      = 0;
+    auto invoke   = [&]( int& value ) {
+        ++numCalls;
+        sum += value;
+    };
+
+    // A disabled coalescer invokes every event.
+    for ( int i = 0; i < 3; ++i )
+    {
+        int value = 1;
+        coalescer.Post( value, invoke );
+    }
+    CHECK( numCalls == 3 );
+    CHECK( !coalescer.HasPendingEvent() );
+
+    coalescer.SetEnabled( true );
+    numCalls = 0;
+    sum      = 0;
+    for ( int i = 0; i < 5; ++i )
+    {
+        int value = 1;
+        coalescer.Post( value, invoke );
+    }
+    CHECK( numCalls == 0 );
+    CHECK( coalescer.HasPendingEvent() );
+
+    coalescer.Flush( invoke );
+    CHECK( numCalls == 1 );
+    CHECK( sum == 5 );
+    CHECK( coalescer.GetNumMerged() == 4 );
+    CHECK( !coalescer.HasPendingEvent() );
+}
@@ -0,0 +1,252 @@
+/**
+ * Tests the FileWatcher: the merging of the changes of a path and the batches
+ * that are dispatched for the changes of files in a temporary directory.
+ */
+
+#include "TestHarness.h"
+
+#include <GameFramework/FileWatcher.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using namespace std::chrono;
+
+namespace
+{
+
+// A temporary directory that is removed with all its files.
+class TempDirectory
+{
+public:
+    TempDirectory()
+    {
+        auto ticks = steady_clock::now().time_since_epoch().count();
+        m_Path     = fs::temp_directory_path() / ( "FileWatcherTests-" + std::to_string( ticks ) );
+        fs::create_directories( m_Path );
+    }
+
+    ~TempDirectory()
+    {
+        std::error_code error;
+        fs::remove_all( m_Path, error );
+    }
+
+    const fs::path& GetPath() const
+    {
+        return m_Path;
+    }
+
+    void WriteFile( const std::string& fileName, const std::string& contents ) const
+    {
+        std::ofstream file( m_Path / fileName, std::ios::trunc );
+        file << contents;
+    }
+
+    void RenameFile( const std::string& oldFileName, const std::string& newFileName ) const
+    {
+        fs::rename( m_Path / oldFileName, m_Path / newFileName );
+    }
+
+    void RemoveFile( const std::string& fileName ) const
+    {
+        fs::remove( m_Path / fileName );
+    }
+
+private:
+    fs::path m_Path;
+};
+
+// Collects the batches that are dispatched by a FileWatcher.
+class Batches
+{
+public:
+    struct Batch
+    {
+        // The time the batch was dispatched.
+        steady_clock::time_point Time;
+
+        std::vector<FileChangedEventArgs> Changes;
+
+        // Returns the merged action of a file (FileAction::Unknown if the file
+        // is not part of the batch).
+        FileAction GetAction( const std::string& fileName ) const
+        {
+            for ( auto& change: Changes )
+            {
+                if ( fs::path( change.Path ).filename() == fileName )
+                {
+                    return change.Action;
+                }
+            }
+            return FileAction::Unknown;
+        }
+    };
+
+    FileWatcher::Callback GetCallback()
+    {
+        return [this]( FileChangesEventArgs& e ) {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            m_Batches.push_back( { steady_clock::now(), e.Changes } );
+            m_Condition.notify_all();
+        };
+    }
+
+    // Wait for the next batch. Returns false if no batch was dispatched within the timeout.
+    bool WaitForBatch( Batch& batch, milliseconds timeout = milliseconds( 3000 ) )
+    {
+        std::unique_lock<std::mutex> lock( m_Mutex );
+        if ( !m_Condition.wait_for( lock, timeout, [this]() { return !m_Batches.empty(); } ) )
+        {
+            return false;
+        }
+
+        batch = m_Batches.front();
+        m_Batches.erase( m_Batches.begin() );
+        return true;
+    }
+
+private:
+    std::mutex              m_Mutex;
+    std::condition_variable m_Condition;
+    std::vector<Batch>      m_Batches;
+};
+
+struct Fixture
+{
+    Fixture()
+    : Watcher( Collector.GetCallback(), milliseconds( 50 ) )
+    {
+        Watcher.AddDirectory( Directory.GetPath().wstring() );
+        // On Windows, the directory is added on the thread of the directory
+        // changes server.
+        std::this_thread::sleep_for( milliseconds( 100 ) );
+    }
+
+    TempDirectory Directory;
+    Batches       Collector;
+    FileWatcher   Watcher;
+};
+
+}  // namespace
+
+TEST_CASE( FileWatcher_MergeActions )
+{
+    // A new file is still new after it was written.
+    CHECK( FileWatcher::MergeActions( FileAction::Added, FileAction::Modified ) == FileAction::Added );
+    // A temporary file that is removed or renamed before it was reported is dropped.
+    CHECK( FileWatcher::MergeActions( FileAction::Added, FileAction::Removed ) == FileAction::Unknown );
+    CHECK( FileWatcher::MergeActions( FileAction::Added, FileAction::RenameOld ) == FileAction::Unknown );
+    // A file that is replaced (by a new file or by a rename) was modified.
+    CHECK( FileWatcher::MergeActions( FileAction::Removed, FileAction::Added ) == FileAction::Modified );
+    CHECK( FileWatcher::MergeActions( FileAction::Removed, FileAction::RenameNew ) == FileAction::Modified );
+    CHECK( FileWatcher::MergeActions( FileAction::RenameOld, FileAction::Added ) == FileAction::Modified );
+    CHECK( FileWatcher::MergeActions( FileAction::RenameOld, FileAction::RenameNew ) == FileAction::Modified );
+    // A renamed file is still renamed after it was written.
+    CHECK( FileWatcher::MergeActions( FileAction::RenameNew, FileAction::Modified ) == FileAction::RenameNew );
+    // Otherwise the last action wins.
+    CHECK( FileWatcher::MergeActions( FileAction::Modified, FileAction::Modified ) == FileAction::Modified );
+    CHECK( FileWatcher::MergeActions( FileAction::Modified, FileAction::Removed ) == FileAction::Removed );
+    CHECK( FileWatcher::MergeActions( FileAction::RenameNew, FileAction::Removed ) == FileAction::Removed );
+}
+
+TEST_CASE( FileWatcher_ReportsChanges )
+{
+    Fixture fixture;
+    auto&   directory = fixture.Directory;
+
+    Batches::Batch batch;
+
+    directory.WriteFile( "a.hlsl", "a" );
+    REQUIRE( fixture.Collector.WaitForBatch( batch ) );
+    CHECK( batch.GetAction( "a.hlsl" ) == FileAction::Added );
+
+    directory.WriteFile( "a.hlsl", "b" );
+    REQUIRE( fixture.Collector.WaitForBatch( batch ) );
+    CHECK( batch.GetAction( "a.hlsl" ) == FileAction::Modified );
+
+    directory.RenameFile( "a.hlsl", "b.hlsl" );
+    REQUIRE( fixture.Collector.WaitForBatch( batch ) );
+    CHECK( batch.GetAction( "a.hlsl" ) == FileAction::RenameOld );
+    CHECK( batch.GetAction( "b.hlsl" ) == FileAction::RenameNew );
+
+    directory.RemoveFile( "b.hlsl" );
+    REQUIRE( fixture.Collector.WaitForBatch( batch ) );
+    CHECK( batch.GetAction( "b.hlsl" ) == FileAction::Removed );
+}
+
+TEST_CASE( FileWatcher_MergesBurst )
+{
+    Fixture fixture;
+    auto&   directory = fixture.Directory;
+
+    directory.WriteFile( "a.hlsl", "a" );
+    directory.WriteFile( "b.hlsl", "b" );
+
+    Batches::Batch batch;
+    REQUIRE( fixture.Collector.WaitForBatch( batch ) );
+
+    // Saving a file several times, writing a temporary file that is removed,
+    // and creating a file by renaming a temporary file.
+    for ( int i = 0; i < 20; ++i )
+    {
+        directory.WriteFile( "a.hlsl", std::to_string( i ) );
+    }
+    directory.WriteFile( "temp.tmp", "temp" );
+    directory.RemoveFile( "temp.tmp" );
+    directory.WriteFile( "c.tmp", "c" );
+    directory.RenameFile( "c.tmp", "c.hlsl" );
+
+    REQUIRE( fixture.Collector.WaitForBatch( batch ) );
+    CHECK( batch.Changes.size() == 2 );
+    CHECK( batch.GetAction( "a.hlsl" ) == FileAction::Modified );
+    CHECK( batch.GetAction( "c.hlsl" ) == FileAction::RenameNew );
+    CHECK( batch.GetAction( "temp.tmp" ) == FileAction::Unknown );
+    CHECK( batch.GetAction( "c.tmp" ) == FileAction::Unknown );
+    CHECK( batch.GetAction( "b.hlsl" ) == FileAction::Unknown );
+
+    // Everything was reported in a single batch.
+    CHECK( !fixture.Collector.WaitForBatch( batch, milliseconds( 200 ) ) );
+}
+
+TEST_CASE( FileWatcher_DebounceLimits )
+{
+    Fixture fixture;
+    auto&   directory = fixture.Directory;
+
+    // A single change is dispatched once no new changes were reported for the
+    // debounce time (50 ms).
+    auto changeTime = steady_clock::now();
+    directory.WriteFile( "a.hlsl", "a" );
+
+    Batches::Batch batch;
+    REQUIRE( fixture.Collector.WaitForBatch( batch ) );
+    auto delay = duration_cast<milliseconds>( batch.Time - changeTime );
+    CHECK( delay >= milliseconds( 50 ) );
+    CHECK( delay < milliseconds( 500 ) );
+
+    // Changes that keep arriving faster than the debounce time are dispatched
+    // after at most 1 s.
+    auto firstChangeTime = steady_clock::now();
+    bool dispatched      = false;
+    for ( int i = 0; i < 150 && !dispatched; ++i )
+    {
+        directory.WriteFile( "a.hlsl", std::to_string( i ) );
+        std::this_thread::sleep_for( milliseconds( 10 ) );
+        dispatched = fixture.Collector.WaitForBatch( batch, milliseconds( 0 ) );
+    }
+
+    REQUIRE( dispatched );
+    delay = duration_cast<milliseconds>( batch.Time - firstChangeTime );
+    CHECK( delay >= milliseconds( 1000 ) );
+    CHECK( delay < milliseconds( 1300 ) );
+    CHECK( batch.GetAction( "a.hlsl" ) == FileAction::Modified );
+}
@@ -0,0 +1,329 @@
+/**
+ * Tests the FrameScheduler with a mocked clock and a simulated GPU that
+ * executes the submitted frames one after another.
+ */
+
+#include "TestHarness.h"
+
+#include <GameFramework/FrameScheduler.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+
+namespace
+{
+
+// A clock that only advances when the scheduler (or the test) waits.
+class MockClock : public FrameClock
+{
+public:
+    explicit MockClock( double oversleep = 0.0 )
+    : Time( 0.0 )
+    , Oversleep( oversleep )
+    , NumSleeps( 0 )
+    , NumSpins( 0 )
+    {}
+
+    virtual double GetTime() override
+    {
+        return Time;
+    }
+
+    virtual void Sleep( double seconds ) override
+    {
+        // Like the OS scheduler, the thread wakes up a little late.
+        Time += seconds + Oversleep;
+        ++NumSleeps;
+    }
+
+    virtual void Spin() override
+    {
+        Time += 1.0e-6;
+        ++NumSpins;
+    }
+
+    double   Time;
+    double   Oversleep;
+    uint64_t NumSleeps;
+    uint64_t NumSpins;
+};
+
+// A GPU that executes the frames in the order they are submitted. Each frame
+// takes a fixed time per pass and can't start before it is submitted.
+class MockGpu
+{
+public:
+    explicit MockGpu( MockClock& clock )
+    : m_Clock( clock )
+    , m_LastFenceValue( 0 )
+    , m_LastCompleteTime( 0.0 )
+    {}
+
+    uint64_t Submit( double gpuTime )
+    {
+        double beginTime   = std::max( m_Clock.Time, m_LastCompleteTime );
+        m_LastCompleteTime = beginTime + gpuTime;
+        m_CompleteTimes.push_back( m_LastCompleteTime );
+
+        return ++m_LastFenceValue;
+    }
+
+    bool IsFenceComplete( uint64_t fenceValue ) const
+    {
+        return m_CompleteTimes[fenceValue - 1] <= m_Clock.Time;
+    }
+
+    void WaitForFenceValue( uint64_t fenceValue )
+    {
+        m_Clock.Time = std::max( m_Clock.Time, m_CompleteTimes[fenceValue - 1] );
+    }
+
+    // The number of submitted frames that are not yet completed.
+    uint32_t NumPendingFrames() const
+    {
+        return static_cast<uint32_t>( std::count_if( m_CompleteTimes.begin(), m_CompleteTimes.end(),
+                                                     [this]( double time ) { return time > m_Clock.Time; } ) );
+    }
+
+private:
+    MockClock&         m_Clock;
+    std::deque<double> m_CompleteTimes;
+    uint64_t           m_LastFenceValue;
+    double             m_LastCompleteTime;
+};
+
+struct Fixture
+{
+    explicit Fixture( double oversleep = 0.0 )
+    : Clock( new MockClock( oversleep ) )
+    , Gpu( *Clock )
+    , Scheduler( std::unique_ptr<FrameClock>( Clock ) )
+    {
+        Scheduler.SetFrameFence( [this]( uint64_t fenceValue ) { return Gpu.IsFenceComplete( fenceValue ); },
+                                 [this]( uint64_t fenceValue ) { Gpu.WaitForFenceValue( fenceValue ); } );
+    }
+
+    ~Fixture()
+    {
+        Scheduler.SetFrameFence( nullptr, nullptr );
+    }
+
+    // Run a frame that takes cpuTime on the CPU and gpuTimePerPass for every
+    // progressive pass on the GPU. Returns the number of passes of the frame.
+    uint32_t RunFrame( double cpuTime, double gpuTimePerPass )
+    {
+        Scheduler.BeginFrame();
+        uint32_t numPasses = Scheduler.GetNumProgressivePasses();
+        Clock->Time += cpuTime;
+        Scheduler.Present( Gpu.Submit( numPasses * gpuTimePerPass ) );
+        Scheduler.EndFrame();
+
+        return numPasses;
+    }
+
+    // Owned by the scheduler.
+    MockClock*     Clock;
+    MockGpu        Gpu;
+    FrameScheduler Scheduler;
+};
+
+}  // namespace
+
+TEST_CASE( FrameScheduler_PacesToTargetFrameRate )
+{
+    // The clock oversleeps by 0.2 ms, which the spin has to absorb.
+    Fixture fixture( 0.0002 );
+    fixture.Scheduler.SetTargetFrameRate( 100.0 );
+
+    for ( int frame = 0; frame < 200; ++frame )
+    {
+        fixture.RunFrame( 0.002, 0.001 );
+    }
+
+    const FrameStatistics& statistics = fixture.Scheduler.GetStatistics();
+    CHECK( statistics.NumFrames == 200 );
+    CHECK( statistics.PresentInterval.NumSamples == 199 );
+    CHECK_NEAR( statistics.PresentInterval.Average, 0.01, 1.0e-5 );
+    CHECK_NEAR( statistics.PresentInterval.Min, 0.01, 1.0e-5 );
+    CHECK_NEAR( statistics.PresentInterval.Max, 0.01, 1.0e-5 );
+    CHECK_NEAR( statistics.CpuFrameTime.Average, 0.002, 1.0e-9 );
+
+    // Most of the wait is spent sleeping.
+    CHECK( fixture.Clock->NumSleeps >= 199 );
+    CHECK( fixture.Clock->NumSpins < 200 * 1000 );
+}
+
+TEST_CASE( FrameScheduler_ResetsScheduleOfLateFrames )
+{
+    Fixture fixture;
+    fixture.Scheduler.SetTargetFrameRate( 100.0 );
+
+    fixture.RunFrame( 0.002, 0.001 );
+    fixture.RunFrame( 0.05, 0.001 );
+
+    // The frame after a hitch starts right away, but the frames after it are
+    // paced again instead of catching up with a burst of frames.
+    const FrameStatistics& statistics = fixture.Scheduler.GetStatistics();
+    for ( int frame = 0; frame < 5; ++frame )
+    {
+        fixture.RunFrame( 0.002, 0.001 );
+        if ( frame > 0 )
+        {
+            CHECK_NEAR( statistics.PresentInterval.Last, 0.01, 1.0e-5 );
+        }
+    }
+}
+
+TEST_CASE( FrameScheduler_LimitsFramesInFlight )
+{
+    for ( uint32_t maxFramesInFlight = 1; maxFramesInFlight <= 3; ++maxFramesInFlight )
+    {
+        Fixture fixture;
+        fixture.Scheduler.SetMaxFramesInFlight( maxFramesInFlight );
+
+        // The GPU is the bottleneck.
+        for ( int frame = 0; frame < 50; ++frame )
+        {
+            fixture.Scheduler.BeginFrame();
+            CHECK( fixture.Gpu.NumPendingFrames() < maxFramesInFlight );
+            CHECK( fixture.Scheduler.GetStatistics().NumFramesInFlight < maxFramesInFlight );
+
+            fixture.Clock->Time += 0.001;
+            fixture.Scheduler.Present( fixture.Gpu.Submit( 0.02 ) );
+            fixture.Scheduler.EndFrame();
+        }
+
+        // The CPU waits for the GPU, so the frames are presented at the rate of the GPU. With a
+        // single frame in flight, the GPU also waits for the CPU.
+        const FrameStatistics& statistics = fixture.Scheduler.GetStatistics();
+        CHECK_NEAR( statistics.PresentInterval.Last, maxFramesInFlight == 1 ? 0.021 : 0.02, 1.0e-6 );
+        CHECK( statistics.WaitTime.Max > 0.0 );
+    }
+}
+
+TEST_CASE( FrameScheduler_EstimatesGpuFrameTime )
+{
+    Fixture fixture;
+
+    for ( int frame = 0; frame < 50; ++frame )
+    {
+        fixture.RunFrame( 0.005, 0.02 );
+    }
+
+    const FrameStatistics& statistics = fixture.Scheduler.GetStatistics();
+    CHECK( statistics.GpuFrameTime.NumSamples >= 48 );
+    CHECK_NEAR( statistics.GpuFrameTime.Average, 0.02, 1.0e-4 );
+    CHECK_NEAR( statistics.GpuFrameTime.Last, 0.02, 1.0e-6 );
+}
+
+TEST_CASE( FrameScheduler_ProgressivePassesStayWithinBudget )
+{
+    Fixture fixture;
+    fixture.Scheduler.SetProgressive( true );
+    fixture.Scheduler.SetLatencyBudget( 0.033 );
+    fixture.Scheduler.SetAccumulating( true );
+
+    // A single pass is rendered until the GPU time of a pass is known.
+    CHECK( fixture.RunFrame( 0.001, 0.005 ) == 1 );
+
+    uint32_t numPasses = 0;
+    for ( int frame = 0; frame < 50; ++frame )
+    {
+        numPasses = fixture.RunFrame( 0.001, 0.005 );
+
+        // Only a single frame is in flight while accumulating.
+        CHECK( fixture.Scheduler.GetStatistics().NumFramesInFlight <= 1 );
+        CHECK( numPasses * 0.005 <= 0.033 );
+    }
+    CHECK( numPasses == 6 );
+    CHECK( fixture.Scheduler.GetStatistics().GpuFrameTime.Max <= 0.033 );
+
+    // The number of passes is limited when a pass is cheap.
+    fixture.Scheduler.SetMaxProgressivePasses( 4 );
+    for ( int frame = 0; frame < 50; ++frame )
+    {
+        CHECK( fixture.RunFrame( 0.001, 0.0001 ) == 4 );
+    }
+
+    // A single pass is rendered when the view changes.
+    fixture.Scheduler.SetAccumulating( false );
+    CHECK( fixture.RunFrame( 0.001, 0.005 ) == 1 );
+}
+
+TEST_CASE( FrameScheduler_SinglePassWhenNotProgressive )
+{
+    Fixture fixture;
+    fixture.Scheduler.SetAccumulating( true );
+
+    for ( int frame = 0; frame < 10; ++frame )
+    {
+        CHECK( fixture.RunFrame( 0.001, 0.001 ) == 1 );
+    }
+}
+
+TEST_CASE( FrameScheduler_MeasuresInputLatency )
+{
+    Fixture fixture;
+    fixture.RunFrame( 0.001, 0.001 );
+
+    // Input that arrives before the frame starts is processed by that frame.
+    fixture.Clock->Time += 0.004;
+    fixture.Scheduler.NotifyInput();
+    fixture.Clock->Time += 0.002;
+    fixture.Scheduler.NotifyInput();
+    fixture.RunFrame( 0.003, 0.001 );
+
+    const FrameStatistics& statistics = fixture.Scheduler.GetStatistics();
+    CHECK( statistics.InputLatency.NumSamples == 1 );
+    CHECK_NEAR( statistics.InputLatency.Last, 0.005, 1.0e-9 );
+
+    // Frames without input don't add a sample.
+    fixture.RunFrame( 0.003, 0.001 );
+    CHECK( statistics.InputLatency.NumSamples == 1 );
+}
+
+TEST_CASE( FrameScheduler_UntrackedWithoutFence )
+{
+    MockClock*     clock = new MockClock();
+    FrameScheduler scheduler( ( std::unique_ptr<FrameClock>( clock ) ) );
+
+    for ( int frame = 0; frame < 10; ++frame )
+    {
+        scheduler.BeginFrame();
+        clock->Time += 0.001;
+        scheduler.Present( frame + 1 );
+        scheduler.EndFrame();
+    }
+
+    const FrameStatistics& statistics = scheduler.GetStatistics();
+    CHECK( statistics.NumFrames == 10 );
+    CHECK( statistics.NumFramesInFlight == 0 );
+    CHECK( statistics.GpuFrameTime.NumSamples == 0 );
+}
+
+TEST_CASE( FrameScheduler_SkipsNestedFrames )
+{
+    Fixture fixture;
+    fixture.Scheduler.SetMaxFramesInFlight( 1 );
+
+    fixture.RunFrame( 0.001, 0.02 );
+
+    REQUIRE( fixture.Scheduler.BeginFrame() );
+    double beginTime = fixture.Clock->Time;
+
+    // A nested frame (WM_PAINT dispatched by a modal loop during the frame)
+    // doesn't wait for the frame in flight and isn't counted.
+    CHECK( !fixture.Scheduler.BeginFrame() );
+    CHECK( fixture.Clock->Time == beginTime );
+    CHECK( fixture.Scheduler.GetStatistics().NumFrames == 2 );
+
+    fixture.Clock->Time += 0.001;
+    fixture.Scheduler.Present( fixture.Gpu.Submit( 0.02 ) );
+    fixture.Scheduler.EndFrame();
+
+    // The next frame starts normally.
+    CHECK( fixture.Scheduler.BeginFrame() );
+    CHECK( fixture.Scheduler.GetStatistics().NumFrames == 3 );
+    fixture.Scheduler.EndFrame();
+}
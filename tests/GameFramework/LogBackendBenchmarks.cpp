@@ -0,0 +1,135 @@
+/**
+ * Measures the latency of a log call on the calling thread for the spdlog
+ * async logger (with the block overflow policy that the GameFramework logger
+ * uses) and for a LogChannel, both writing to a file, and the number of
+ * messages the LogBackend drops with its default buffer size.
+ */
+
+#include "TestHarness.h"
+
+#include <GameFramework/LogBackend.h>
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Times every call and prints the mean and the percentiles (in ns). If a pause
+// is specified, the calls are spread out by busy waiting in between.
+template<typename LogFunc>
+void MeasureLatency( const char* name, int numCalls, LogFunc&& logFunc,
+                     std::chrono::microseconds pause = std::chrono::microseconds( 0 ) )
+{
+    std::vector<double> times( numCalls );
+    for ( int i = 0; i < numCalls; ++i )
+    {
+        auto startTime = Clock::now();
+        logFunc( i );
+        auto endTime = Clock::now();
+
+        times[i] = std::chrono::duration<double, std::nano>( endTime - startTime ).count();
+
+        while ( Clock::now() - endTime < pause )
+        {}
+    }
+
+    double totalTime = 0.0;
+    for ( double time: times )
+    {
+        totalTime += time;
+    }
+    std::sort( times.begin(), times.end() );
+
+    std::printf( "%-32s mean %7.0f  p50 %6.0f  p99 %7.0f  p99.9 %8.0f ns\n", name, totalTime / numCalls,
+                 times[numCalls / 2], times[numCalls * 99 / 100], times[numCalls * 999 / 1000] );
+}
+
+spdlog::sink_ptr CreateFileSink()
+{
+    auto path = std::filesystem::temp_directory_path() / "LogBackendBenchmarks.log";
+    return std::make_shared<spdlog::sinks::basic_file_sink_mt>( path.string(), true );
+}
+
+}  // namespace
+
+TEST_CASE( Benchmark_LogBackend_ProducerLatency )
+{
+    const int NumBurstCalls = 100000;
+    const int NumPacedCalls = 20000;
+
+    // The burst is logged as fast as possible (like a scene import), the paced
+    // calls are 10 us apart (like the messages of a frame).
+    const std::chrono::microseconds PacedInterval( 10 );
+
+    auto sink = CreateFileSink();
+
+    {
+        spdlog::init_thread_pool( 8192, 1 );
+        auto logger = std::make_shared<spdlog::async_logger>( "spdlog", sink, spdlog::thread_pool(),
+                                                              spdlog::async_overflow_policy::block );
+
+        MeasureLatency( "spdlog async, burst", NumBurstCalls,
+                        [&]( int i ) { logger->info( "Frame {} took {:.3f} ms on {}", i, i * 0.001, "render" ); } );
+        MeasureLatency(
+            "spdlog async, paced", NumPacedCalls,
+            [&]( int i ) { logger->info( "Frame {} took {:.3f} ms on {}", i, i * 0.001, "render" ); },
+            PacedInterval );
+
+        logger->flush();
+        spdlog::shutdown();
+    }
+
+    {
+        LogBackend backend( { sink } );
+        auto&      channel = backend.CreateChannel( "LogBackend" );
+
+        MeasureLatency( "LogBackend, burst", NumBurstCalls,
+                        [&]( int i ) { channel.info( "Frame {} took {:.3f} ms on {}", i, i * 0.001, "render" ); } );
+        backend.Flush();
+        std::printf( "  %llu of %d messages dropped\n", static_cast<unsigned long long>( backend.GetNumDropped() ),
+                     NumBurstCalls );
+
+        MeasureLatency(
+            "LogBackend, paced", NumPacedCalls,
+            [&]( int i ) { channel.info( "Frame {} took {:.3f} ms on {}", i, i * 0.001, "render" ); },
+            PacedInterval );
+        backend.Flush();
+        std::printf( "  %llu messages dropped in total\n", static_cast<unsigned long long>( backend.GetNumDropped() ) );
+    }
+}
+
+TEST_CASE( Benchmark_LogBackend_BurstDrops )
+{
+    // The number of messages of 100 characters that are dropped by a burst
+    // with the default buffer size.
+    std::string message( 100, 'x' );
+
+    std::printf( "%10s %10s %10s\n", "Messages", "Dropped", "Time" );
+    for ( int numMessages: { 1000, 10000, 20000, 50000, 100000 } )
+    {
+        LogBackend backend( { CreateFileSink() } );
+        auto&      channel = backend.CreateChannel( "ASSIMP" );
+
+        auto startTime = Clock::now();
+        for ( int i = 0; i < numMessages; ++i )
+        {
+            channel.debug( "{}", message );
+        }
+        std::chrono::duration<double, std::milli> time = Clock::now() - startTime;
+
+        backend.Flush();
+        std::printf( "%10d %10llu %7.2f ms\n", numMessages, static_cast<unsigned long long>( backend.GetNumDropped() ),
+                     time.count() );
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * Tests the LogBackend: formatting on the background thread, level filtering,
+ * dropping messages when the ring buffer of a thread is full, and logging from
+ * several threads.
+ */
+
+#include "TestHarness.h"
+
+#include <GameFramework/LogBackend.h>
+
+#include <spdlog/sinks/ostream_sink.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Collects the messages of a backend as "<channel> <level> <message>" lines.
+struct Fixture
+{
+    Fixture()
+    : Sink( std::make_shared<spdlog::sinks::ostream_sink_mt>( Stream ) )
+    {
+        Sink->set_pattern( "%n %l %v" );
+    }
+
+    std::string GetOutput()
+    {
+        return Stream.str();
+    }
+
+    // Returns the number of lines that start with the prefix.
+    size_t GetNumLines( const std::string& prefix )
+    {
+        std::istringstream lines( Stream.str() );
+        std::string        line;
+        size_t             numLines = 0;
+        while ( std::getline( lines, line ) )
+        {
+            numLines += line.compare( 0, prefix.size(), prefix ) == 0;
+        }
+        return numLines;
+    }
+
+    std::ostringstream                              Stream;
+    std::shared_ptr<spdlog::sinks::ostream_sink_mt> Sink;
+};
+
+}  // namespace
+
+TEST_CASE( LogBackend_FormatsArguments )
+{
+    Fixture    fixture;
+    LogBackend backend( { fixture.Sink } );
+
+    auto& channel = backend.CreateChannel( "Test" );
+    CHECK( &backend.CreateChannel( "Test" ) == &channel );
+
+    // Strings are copied, so the message is formatted correctly after they are destroyed.
+    {
+        std::string string = "string";
+        channel.info( "{} {} {:.2f} {} {}", 1, string, 2.5, "literal", std::string_view( "view" ) );
+    }
+    backend.Flush();
+
+    CHECK( fixture.GetOutput() == "Test info 1 string 2.50 literal view\n" );
+}
+
+TEST_CASE( LogBackend_FiltersLevels )
+{
+    Fixture    fixture;
+    LogBackend backend( { fixture.Sink } );
+
+    auto& channel = backend.CreateChannel( "Test" );
+    channel.set_level( spdlog::level::warn );
+    CHECK( !channel.should_log( spdlog::level::info ) );
+
+    channel.info( "filtered" );
+    channel.warn( "warning" );
+    backend.Flush();
+
+    CHECK( fixture.GetOutput() == "Test warning warning\n" );
+}
+
+TEST_CASE( LogBackend_ReportsFormatErrors )
+{
+    Fixture    fixture;
+    LogBackend backend( { fixture.Sink } );
+
+    // A format error is reported by the background thread instead of throwing
+    // on the logging thread.
+    backend.CreateChannel( "Test" ).warn( "{} {}", 1 );
+    backend.Flush();
+
+    CHECK( fixture.GetOutput().find( "Failed to format log message" ) != std::string::npos );
+}
+
+TEST_CASE( LogBackend_DropsMessagesIfFull )
+{
+    Fixture    fixture;
+    LogBackend backend( { fixture.Sink }, 4096 );
+
+    auto& channel = backend.CreateChannel( "Test" );
+    for ( int i = 0; i < 1000; ++i )
+    {
+        channel.info( "Message {}", i );
+    }
+    backend.Flush();
+
+    uint64_t numDropped = backend.GetNumDropped();
+    CHECK( numDropped > 0 );
+    // Every message is either written or dropped, and the drops are reported.
+    CHECK( fixture.GetNumLines( "Test info" ) == 1000 - numDropped );
+    CHECK( fixture.GetNumLines( "LogBackend warning" ) > 0 );
+}
+
+TEST_CASE( LogBackend_HoldsImportBurst )
+{
+    Fixture    fixture;
+    LogBackend backend( { fixture.Sink } );
+
+    // A verbose scene import logs thousands of messages as fast as it can. The
+    // default buffer holds a burst of 10,000 messages of 100 characters even if
+    // the background thread doesn't get to run.
+    const int   NumMessages = 10000;
+    std::string message( 100, 'x' );
+
+    auto& channel = backend.CreateChannel( "ASSIMP" );
+    for ( int i = 0; i < NumMessages; ++i )
+    {
+        channel.debug( "{}", message );
+    }
+    backend.Flush();
+
+    CHECK( backend.GetNumDropped() == 0 );
+    CHECK( fixture.GetNumLines( "ASSIMP debug" ) == NumMessages );
+}
+
+TEST_CASE( LogBackend_LogsFromThreads )
+{
+    Fixture    fixture;
+    LogBackend backend( { fixture.Sink } );
+
+    auto& channel = backend.CreateChannel( "Test" );
+
+    std::vector<std::thread> threads;
+    for ( int t = 0; t < 4; ++t )
+    {
+        threads.emplace_back( [&channel, t]() {
+            for ( int i = 0; i < 100; ++i )
+            {
+                channel.info( "{} {}", t, i );
+            }
+        } );
+    }
+    for ( auto& thread: threads )
+    {
+        thread.join();
+    }
+    backend.Flush();
+
+    // The buffers of the threads are drained after the threads exited.
+    CHECK( backend.GetNumDropped() == 0 );
+    CHECK( fixture.GetNumLines( "Test info" ) == 400 );
+}
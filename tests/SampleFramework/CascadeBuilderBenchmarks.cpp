@@ -0,0 +1,107 @@
+/**
+ * Measures the time it takes to compute the cascades of a set of lights with
+ * ShadowHelper::PrepareCascades and with the CascadeBuilder.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/ShadowHelper.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+const uint64 NumLights     = 8;
+const uint64 NumIterations = 20000;
+
+double MicrosecondsPerLight( Clock::time_point startTime )
+{
+    return std::chrono::duration<double, std::micro>( Clock::now() - startTime ).count() / ( NumIterations * NumLights );
+}
+
+void RunBenchmark( bool stabilize, uint64 numBounds )
+{
+    std::mt19937                          random( 3 );
+    std::uniform_real_distribution<float> signedUnit( -1.0f, 1.0f );
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+
+    PerspectiveCamera camera;
+    camera.Initialize( 16.0f / 9.0f, 1.0f, 0.1f, 100.0f );
+    camera.SetLookAt( Float3( 5.0f, 3.0f, 5.0f ), Float3( 0.0f ), Float3( 0.0f, 1.0f, 0.0f ) );
+
+    std::vector<CascadeLightDesc> lights( NumLights );
+    for ( auto& light: lights )
+    {
+        light.LightDir  = Float3::Normalize( Float3( signedUnit( random ), 0.5f + unit( random ), signedUnit( random ) ) );
+        light.Stabilize = stabilize;
+    }
+
+    std::vector<Float3> boundsMins( numBounds ), boundsMaxes( numBounds );
+    for ( uint64 i = 0; i < numBounds; ++i )
+    {
+        Float3 center( 30.0f * signedUnit( random ), 4.0f * unit( random ), 30.0f * signedUnit( random ) );
+        Float3 extent( 1.0f + unit( random ) );
+        boundsMins[i]  = center - extent;
+        boundsMaxes[i] = center + extent;
+    }
+
+    std::vector<SunShadowConstantsBase> constants( NumLights );
+    std::vector<OrthographicCamera>     cameras( NumLights * NumCascades );
+
+    auto startTime = Clock::now();
+    for ( uint64 i = 0; i < NumIterations; ++i )
+    {
+        for ( uint64 lightIdx = 0; lightIdx < NumLights; ++lightIdx )
+        {
+            const CascadeLightDesc& light = lights[lightIdx];
+            ShadowHelper::PrepareCascades( light.LightDir, light.ShadowMapSize, light.Stabilize, camera,
+                                           constants[lightIdx], &cameras[lightIdx * NumCascades] );
+        }
+    }
+    const double prepareCascadesTime = MicrosecondsPerLight( startTime );
+
+    CascadeBuilder builder;
+    if ( numBounds > 0 )
+    {
+        builder.SetCasterBounds( boundsMins.data(), boundsMaxes.data(), numBounds );
+    }
+
+    startTime = Clock::now();
+    for ( uint64 i = 0; i < NumIterations; ++i )
+    {
+        builder.Invalidate();
+        builder.Build( camera, lights.data(), NumLights, constants.data(), cameras.data() );
+    }
+    const double buildTime = MicrosecondsPerLight( startTime );
+
+    startTime = Clock::now();
+    for ( uint64 i = 0; i < NumIterations; ++i )
+    {
+        builder.Build( camera, lights.data(), NumLights, constants.data(), cameras.data() );
+    }
+    const double cachedTime = MicrosecondsPerLight( startTime );
+
+    std::printf( "Stabilize %d, %4llu caster bounds: PrepareCascades %.2f us/light, CascadeBuilder %.2f us/light, "
+                 "cached %.3f us/light\n",
+                 stabilize ? 1 : 0, static_cast<unsigned long long>( numBounds ), prepareCascadesTime, buildTime,
+                 cachedTime );
+}
+
+}  // namespace
+
+TEST_CASE( Benchmark_CascadeBuilder )
+{
+    for ( bool stabilize: { true, false } )
+    {
+        RunBenchmark( stabilize, 0 );
+        RunBenchmark( stabilize, 1000 );
+    }
+}
@@ -0,0 +1,271 @@
+/**
+ * Tests the CascadeBuilder (v1.02) against ShadowHelper::PrepareCascades,
+ * which computes the cascades of a single light one cascade at a time.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/ShadowHelper.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+float RelativeError( float a, float b )
+{
+    return std::abs( a - b ) / std::max( 1.0f, std::max( std::abs( a ), std::abs( b ) ) );
+}
+
+float MaxError( const Float4x4& a, const Float4x4& b )
+{
+    float error = 0.0f;
+    for ( int i = 0; i < 16; ++i )
+    {
+        error = std::max( error, RelativeError( ( &a._11 )[i], ( &b._11 )[i] ) );
+    }
+    return error;
+}
+
+float MaxError( const Float4& a, const Float4& b )
+{
+    return std::max( std::max( RelativeError( a.x, b.x ), RelativeError( a.y, b.y ) ),
+                     std::max( RelativeError( a.z, b.z ), RelativeError( a.w, b.w ) ) );
+}
+
+float MaxError( const SunShadowConstantsBase& a, const SunShadowConstantsBase& b )
+{
+    float error = MaxError( a.ShadowMatrix, b.ShadowMatrix );
+    for ( uint64 i = 0; i < NumCascades; ++i )
+    {
+        error = std::max( error, RelativeError( a.CascadeSplits[i], b.CascadeSplits[i] ) );
+        error = std::max( error, MaxError( a.CascadeOffsets[i], b.CascadeOffsets[i] ) );
+        error = std::max( error, MaxError( a.CascadeScales[i], b.CascadeScales[i] ) );
+    }
+    return error;
+}
+
+struct Scene
+{
+    PerspectiveCamera Camera;
+    std::vector<CascadeLightDesc> Lights;
+};
+
+Scene RandomScene( std::mt19937& random, uint64 numLights )
+{
+    std::uniform_real_distribution<float> signedUnit( -1.0f, 1.0f );
+
+    Scene scene;
+    scene.Camera.Initialize( 16.0f / 9.0f, 1.0f + 0.5f * signedUnit( random ), 0.1f, 50.0f + 40.0f * signedUnit( random ) );
+
+    Float3 eye( 10.0f * signedUnit( random ), 5.0f + 5.0f * signedUnit( random ), 10.0f * signedUnit( random ) );
+    Float3 lookAt( signedUnit( random ), signedUnit( random ), signedUnit( random ) );
+    scene.Camera.SetLookAt( eye, lookAt, Float3( 0.0f, 1.0f, 0.0f ) );
+
+    scene.Lights.resize( numLights );
+    for ( auto& light: scene.Lights )
+    {
+        Float3 lightDir( signedUnit( random ), 1.0f + 0.5f * signedUnit( random ), signedUnit( random ) );
+        light.LightDir      = Float3::Normalize( lightDir );
+        light.ShadowMapSize = 1024ull << ( random() % 3 );
+        light.Stabilize     = random() % 2 != 0;
+    }
+
+    return scene;
+}
+
+Float3 Project( const Float4x4& viewProjection, const Float3& position )
+{
+    return Float3::Transform( position, viewProjection );
+}
+
+}  // namespace
+
+TEST_CASE( CascadeBuilder_MatchesPrepareCascades )
+{
+    std::mt19937 random( 1 );
+    for ( int i = 0; i < 1000; ++i )
+    {
+        Scene scene = RandomScene( random, 1 );
+        const CascadeLightDesc& light = scene.Lights[0];
+
+        SunShadowConstantsBase expected;
+        OrthographicCamera     expectedCameras[NumCascades];
+        ShadowHelper::PrepareCascades( light.LightDir, light.ShadowMapSize, light.Stabilize, scene.Camera, expected,
+                                       expectedCameras );
+
+        CascadeBuilder         builder;
+        SunShadowConstantsBase constants;
+        OrthographicCamera     cameras[NumCascades];
+        builder.Build( scene.Camera, &light, 1, &constants, cameras );
+
+        // Stabilized cascades are snapped to texels, so rounding can move them by a texel
+        const float tolerance = light.Stabilize ? 4.0f / light.ShadowMapSize : 1.0e-3f;
+
+        CHECK( MaxError( expected, constants ) < tolerance );
+        for ( uint64 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx )
+        {
+            CHECK( MaxError( expectedCameras[cascadeIdx].ViewProjectionMatrix(),
+                             cameras[cascadeIdx].ViewProjectionMatrix() ) < tolerance );
+        }
+    }
+}
+
+TEST_CASE( CascadeBuilder_BuildsLightsIndependently )
+{
+    std::mt19937 random( 2 );
+    for ( int i = 0; i < 100; ++i )
+    {
+        Scene scene = RandomScene( random, 8 );
+
+        CascadeBuilder                      builder;
+        std::vector<SunShadowConstantsBase> constants( scene.Lights.size() );
+        std::vector<OrthographicCamera>     cameras( scene.Lights.size() * NumCascades );
+        builder.Build( scene.Camera, scene.Lights.data(), scene.Lights.size(), constants.data(), cameras.data() );
+
+        for ( uint64 lightIdx = 0; lightIdx < scene.Lights.size(); ++lightIdx )
+        {
+            CascadeBuilder         singleBuilder;
+            SunShadowConstantsBase singleConstants;
+            OrthographicCamera     singleCameras[NumCascades];
+            singleBuilder.Build( scene.Camera, &scene.Lights[lightIdx], 1, &singleConstants, singleCameras );
+
+            CHECK( MaxError( singleConstants, constants[lightIdx] ) == 0.0f );
+        }
+    }
+}
+
+TEST_CASE( CascadeBuilder_CachesUntilInputsChange )
+{
+    std::mt19937 random( 3 );
+    Scene        scene     = RandomScene( random, 4 );
+    const uint64 numLights = scene.Lights.size();
+
+    CascadeBuilder                      builder;
+    std::vector<SunShadowConstantsBase> constants( numLights );
+    std::vector<OrthographicCamera>     cameras( numLights * NumCascades );
+    auto build = [&]() {
+        builder.Build( scene.Camera, scene.Lights.data(), numLights, constants.data(), cameras.data() );
+    };
+
+    build();
+    CHECK( builder.NumLightsBuilt() == numLights );
+    CHECK( builder.NumCacheHits() == 0 );
+
+    build();
+    CHECK( builder.NumLightsBuilt() == numLights );
+    CHECK( builder.NumCacheHits() == numLights );
+
+    // Only the light that changed is built again.
+    scene.Lights[2].LightDir = Float3::Normalize( scene.Lights[2].LightDir + Float3( 0.01f, 0.0f, 0.0f ) );
+    build();
+    CHECK( builder.NumLightsBuilt() == numLights + 1 );
+
+    // Setting the same bounds twice only invalidates once.
+    Float3 boundsMin( -1.0f ), boundsMax( 1.0f );
+    builder.SetCasterBounds( &boundsMin, &boundsMax, 1 );
+    builder.SetCasterBounds( &boundsMin, &boundsMax, 1 );
+    build();
+    CHECK( builder.NumLightsBuilt() == 2 * numLights + 1 );
+
+    scene.Camera.SetLookAt( Float3( 1.0f, 2.0f, 3.0f ), Float3( 0.0f ), Float3( 0.0f, 1.0f, 0.0f ) );
+    build();
+    CHECK( builder.NumLightsBuilt() == 3 * numLights + 1 );
+
+    builder.Invalidate();
+    build();
+    CHECK( builder.NumLightsBuilt() == 4 * numLights + 1 );
+    CHECK( builder.NumCacheHits() == 2 * numLights - 1 );
+}
+
+TEST_CASE( CascadeBuilder_FittedCascadesContainCasters )
+{
+    std::mt19937                          random( 7 );
+    std::uniform_real_distribution<float> signedUnit( -1.0f, 1.0f );
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+
+    uint64 numChecked = 0;
+    uint64 numShrunk  = 0;
+    for ( int i = 0; i < 100; ++i )
+    {
+        PerspectiveCamera camera;
+        camera.Initialize( 16.0f / 9.0f, 1.0f, 0.1f, 60.0f );
+        camera.SetLookAt( Float3( 20.0f * signedUnit( random ), 3.0f + 2.0f * unit( random ), 20.0f * signedUnit( random ) ),
+                          Float3( 5.0f * signedUnit( random ), 0.0f, 5.0f * signedUnit( random ) ),
+                          Float3( 0.0f, 1.0f, 0.0f ) );
+
+        CascadeLightDesc light;
+        light.LightDir  = Float3::Normalize( Float3( signedUnit( random ), 0.5f + unit( random ), signedUnit( random ) ) );
+        light.Stabilize = i % 2 != 0;
+
+        // A ground plane with boxes on it
+        std::vector<Float3> boundsMins = { Float3( -40.0f, -0.1f, -40.0f ) };
+        std::vector<Float3> boundsMaxes = { Float3( 40.0f, 0.0f, 40.0f ) };
+        const int           numBoxes = random() % 200;
+        for ( int boxIdx = 0; boxIdx < numBoxes; ++boxIdx )
+        {
+            Float3 center( 30.0f * signedUnit( random ), 8.0f * unit( random ), 30.0f * signedUnit( random ) );
+            Float3 extent( 0.2f + 2.0f * unit( random ), 0.2f + 4.0f * unit( random ), 0.2f + 2.0f * unit( random ) );
+            boundsMins.push_back( center - extent );
+            boundsMaxes.push_back( center + extent );
+        }
+
+        SunShadowConstantsBase expected;
+        OrthographicCamera     expectedCameras[NumCascades];
+        ShadowHelper::PrepareCascades( light.LightDir, light.ShadowMapSize, light.Stabilize, camera, expected,
+                                       expectedCameras );
+
+        CascadeBuilder builder;
+        builder.SetCasterBounds( boundsMins.data(), boundsMaxes.data(), boundsMins.size() );
+
+        SunShadowConstantsBase constants;
+        OrthographicCamera     cameras[NumCascades];
+        builder.Build( camera, &light, 1, &constants, cameras );
+
+        // Every point of a caster that is covered by the unfitted cascade (or that is in front of it)
+        // has to be covered by the fitted cascade
+        for ( uint64 cascadeIdx = 0; cascadeIdx < NumCascades; ++cascadeIdx )
+        {
+            const Float4x4& expectedViewProjection = expectedCameras[cascadeIdx].ViewProjectionMatrix();
+            const Float4x4& viewProjection         = cameras[cascadeIdx].ViewProjectionMatrix();
+            for ( uint64 boundsIdx = 0; boundsIdx < boundsMins.size(); ++boundsIdx )
+            {
+                const Float3 boundsMin = boundsMins[boundsIdx];
+                const Float3 boundsSize = boundsMaxes[boundsIdx] - boundsMin;
+                for ( int sampleIdx = 0; sampleIdx < 20; ++sampleIdx )
+                {
+                    Float3 position = boundsMin + boundsSize * Float3( unit( random ), unit( random ), unit( random ) );
+                    Float3 expectedPosition = Project( expectedViewProjection, position );
+                    if ( std::abs( expectedPosition.x ) > 1.0f || std::abs( expectedPosition.y ) > 1.0f ||
+                         expectedPosition.z > 1.0f )
+                    {
+                        continue;
+                    }
+
+                    Float3 fittedPosition = Project( viewProjection, position );
+                    CHECK( std::abs( fittedPosition.x ) <= 1.0001f && std::abs( fittedPosition.y ) <= 1.0001f );
+                    CHECK( fittedPosition.z >= -0.0001f && fittedPosition.z <= 1.0001f );
+                    ++numChecked;
+                }
+            }
+
+            // Cascades only shrink in the plane of the shadow map
+            const Float4x4& expectedProjection = expectedCameras[cascadeIdx].ProjectionMatrix();
+            const Float4x4& projection         = cameras[cascadeIdx].ProjectionMatrix();
+            CHECK( projection._11 >= expectedProjection._11 * 0.9999f );
+            CHECK( projection._22 >= expectedProjection._22 * 0.9999f );
+            if ( !light.Stabilize && ( projection._11 > expectedProjection._11 * 1.0001f ) )
+            {
+                ++numShrunk;
+            }
+        }
+    }
+
+    CHECK( numChecked > 0 );
+    CHECK( numShrunk > 0 );
+}
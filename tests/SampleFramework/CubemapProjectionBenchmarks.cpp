@@ -0,0 +1,135 @@
+/**
+ * Compares the throughput of the SIMD cubemap projections (v1.02) onto SH9 and
+ * SGs with the scalar loops they replaced, which computed the direction and the
+ * weight of every texel and projected it with ProjectOntoSH9Color/ProjectOntoSGs.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/SG.h>
+#include <Graphics/SH.h>
+#include <Graphics/Textures.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+const uint64 NumSGs        = 12;
+const uint64 NumIterations = 4;
+
+void RandomCubemap( uint32 size, TextureData<Float4>& cubemap )
+{
+    std::mt19937                          random( size );
+    std::uniform_real_distribution<float> radiance( 0.0f, 4.0f );
+
+    cubemap.Init( size, size, 6 );
+    for ( uint64 i = 0; i < cubemap.Texels.Size(); ++i )
+    {
+        cubemap.Texels[i] = Float4( radiance( random ), radiance( random ), radiance( random ), 1.0f );
+    }
+}
+
+SH9Color ScalarProjectCubemapToSH( const TextureData<Float4>& cubemap )
+{
+    SH9Color result;
+    float    weightSum = 0.0f;
+    for ( uint32 face = 0; face < 6; ++face )
+    {
+        for ( uint32 y = 0; y < cubemap.Height; ++y )
+        {
+            for ( uint32 x = 0; x < cubemap.Width; ++x )
+            {
+                const float u      = ( ( x + 0.5f ) / cubemap.Width ) * 2.0f - 1.0f;
+                const float v      = ( ( y + 0.5f ) / cubemap.Height ) * 2.0f - 1.0f;
+                const float temp   = 1.0f + u * u + v * v;
+                const float weight = 4.0f / ( std::sqrt( temp ) * temp );
+
+                const uint64 idx    = face * uint64( cubemap.Width ) * cubemap.Height + y * uint64( cubemap.Width ) + x;
+                const Float3 dir    = MapXYSToDirection( x, y, face, cubemap.Width, cubemap.Height );
+                const Float3 sample = cubemap.Texels[idx].To3D();
+
+                result += ProjectOntoSH9Color( dir, sample ) * weight;
+                weightSum += weight;
+            }
+        }
+    }
+    result *= ( 4.0f * 3.14159f ) / weightSum;
+    return result;
+}
+
+void ScalarSolveSGsForCubemap( const TextureData<Float4>& cubemap, SG* outSGs, uint64 numSGs )
+{
+    GenerateUniformSGs( outSGs, numSGs, SGDistribution::Spherical );
+    for ( uint32 face = 0; face < 6; ++face )
+    {
+        for ( uint32 y = 0; y < cubemap.Height; ++y )
+        {
+            for ( uint32 x = 0; x < cubemap.Width; ++x )
+            {
+                const uint64 idx = face * uint64( cubemap.Width ) * cubemap.Height + y * uint64( cubemap.Width ) + x;
+                const Float3 dir = MapXYSToDirection( x, y, face, cubemap.Width, cubemap.Height );
+                ProjectOntoSGs( dir, cubemap.Texels[idx].To3D(), outSGs, numSGs );
+            }
+        }
+    }
+
+    const float monteCarloFactor = ( 4.0f * Pi ) / cubemap.Texels.Size();
+    for ( uint64 i = 0; i < numSGs; ++i )
+    {
+        outSGs[i].Amplitude *= monteCarloFactor;
+    }
+}
+
+// Returns the average time of a call in milliseconds.
+template<typename Func>
+double MillisecondsPerCall( Func&& func )
+{
+    // The first call builds the texel table of the resolution and starts the worker threads.
+    func();
+
+    auto startTime = Clock::now();
+    for ( uint64 i = 0; i < NumIterations; ++i )
+    {
+        func();
+    }
+    return std::chrono::duration<double, std::milli>( Clock::now() - startTime ).count() / NumIterations;
+}
+
+void PrintResult( const char* name, uint32 size, double scalarTime, double simdTime )
+{
+    const double numMegaTexels = size * size * 6 / 1000000.0;
+    std::printf( "%-4s %4u^2 %9.2f ms %8.1f Mtexels/s %9.2f ms %8.1f Mtexels/s %6.1fx\n", name, size, scalarTime,
+                 numMegaTexels / ( scalarTime / 1000.0 ), simdTime, numMegaTexels / ( simdTime / 1000.0 ),
+                 scalarTime / simdTime );
+}
+
+}  // namespace
+
+TEST_CASE( Benchmark_CubemapProjection_Throughput )
+{
+    std::printf( "%-11s %30s %30s\n", "", "Scalar", "SIMD" );
+
+    for ( uint32 size: { 128, 256, 512 } )
+    {
+        TextureData<Float4> cubemap;
+        RandomCubemap( size, cubemap );
+
+        SH9Color sh;
+        double   scalarTime = MillisecondsPerCall( [&]() { sh = ScalarProjectCubemapToSH( cubemap ); } );
+        double   simdTime   = MillisecondsPerCall( [&]() { sh = ProjectCubemapToSH( cubemap ); } );
+        PrintResult( "SH9", size, scalarTime, simdTime );
+
+        SG sgs[NumSGs];
+        scalarTime = MillisecondsPerCall( [&]() { ScalarSolveSGsForCubemap( cubemap, sgs, NumSGs ); } );
+        simdTime   = MillisecondsPerCall( [&]() { SolveSGsForCubemap( cubemap, sgs, NumSGs, SGSolveMode::Projection ); } );
+        PrintResult( "SG12", size, scalarTime, simdTime );
+    }
+}
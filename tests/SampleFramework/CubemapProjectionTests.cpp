@@ -0,0 +1,245 @@
+/**
+ * Tests the SIMD cubemap projections (v1.02) onto SH9 and SGs against a scalar
+ * projection that walks the texels one at a time in double precision, the way
+ * ProjectCubemapToSH and SolveSGsForCubemap did before they used the texel
+ * table and the worker threads.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/SG.h>
+#include <Graphics/SH.h>
+#include <Graphics/Textures.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+struct Double3
+{
+    double x = 0.0, y = 0.0, z = 0.0;
+};
+
+void RandomCubemap( uint32 size, uint32 seed, TextureData<Float4>& cubemap )
+{
+    std::mt19937                          random( seed );
+    std::uniform_real_distribution<float> radiance( 0.0f, 4.0f );
+
+    cubemap.Init( size, size, 6 );
+    for ( uint64 i = 0; i < cubemap.Texels.Size(); ++i )
+    {
+        cubemap.Texels[i] = Float4( radiance( random ), radiance( random ), radiance( random ), 1.0f );
+    }
+}
+
+// Calls the function with the direction, solid angle weight and radiance of every texel.
+template<typename Func>
+void ForEachTexel( const TextureData<Float4>& cubemap, Func&& func )
+{
+    const uint32 width  = cubemap.Width;
+    const uint32 height = cubemap.Height;
+    for ( uint32 face = 0; face < 6; ++face )
+    {
+        for ( uint32 y = 0; y < height; ++y )
+        {
+            for ( uint32 x = 0; x < width; ++x )
+            {
+                const double u      = ( ( x + 0.5 ) / width ) * 2.0 - 1.0;
+                const double v      = ( ( y + 0.5 ) / height ) * 2.0 - 1.0;
+                const double temp   = 1.0 + u * u + v * v;
+                const double weight = 4.0 / ( std::sqrt( temp ) * temp );
+
+                const uint64 idx = face * uint64( width ) * height + y * uint64( width ) + x;
+                func( MapXYSToDirection( x, y, face, width, height ), weight, cubemap.Texels[idx] );
+            }
+        }
+    }
+}
+
+std::vector<Double3> ReferenceSH9( const TextureData<Float4>& cubemap )
+{
+    std::vector<Double3> sh( 9 );
+    double               weightSum = 0.0;
+    ForEachTexel( cubemap, [&]( const Float3& dir, double weight, const Float4& texel ) {
+        const double basis[9] = {
+            0.282095,
+            0.488603 * dir.y,
+            0.488603 * dir.z,
+            0.488603 * dir.x,
+            1.092548 * dir.x * dir.y,
+            1.092548 * dir.y * dir.z,
+            0.315392 * ( 3.0 * dir.z * dir.z - 1.0 ),
+            1.092548 * dir.x * dir.z,
+            0.546274 * ( dir.x * dir.x - dir.y * dir.y ),
+        };
+        for ( int i = 0; i < 9; ++i )
+        {
+            sh[i].x += basis[i] * weight * texel.x;
+            sh[i].y += basis[i] * weight * texel.y;
+            sh[i].z += basis[i] * weight * texel.z;
+        }
+        weightSum += weight;
+    } );
+
+    const double scale = ( 4.0 * 3.14159 ) / weightSum;
+    for ( auto& coefficient: sh )
+    {
+        coefficient.x *= scale;
+        coefficient.y *= scale;
+        coefficient.z *= scale;
+    }
+    return sh;
+}
+
+std::vector<Double3> ReferenceSGAmplitudes( const TextureData<Float4>& cubemap, uint64 numSGs )
+{
+    std::vector<SG> sgs( numSGs );
+    GenerateUniformSGs( sgs.data(), numSGs, SGDistribution::Spherical );
+
+    std::vector<Double3> amplitudes( numSGs );
+    ForEachTexel( cubemap, [&]( const Float3& dir, double, const Float4& texel ) {
+        for ( uint64 i = 0; i < numSGs; ++i )
+        {
+            const double dot = double( dir.x ) * sgs[i].Axis.x + double( dir.y ) * sgs[i].Axis.y +
+                               double( dir.z ) * sgs[i].Axis.z;
+            if ( dot > 0.0 )
+            {
+                const double weight = std::exp( ( dot - 1.0 ) * sgs[i].Sharpness );
+                amplitudes[i].x += weight * texel.x;
+                amplitudes[i].y += weight * texel.y;
+                amplitudes[i].z += weight * texel.z;
+            }
+        }
+    } );
+
+    // The Monte Carlo factor of a uniformly sampled sphere, and the fudge factor
+    // that SG.cpp applies to 9 lobes.
+    double scale = ( 4.0 * Pi ) / cubemap.Texels.Size();
+    if ( numSGs == 9 )
+    {
+        scale *= Pi / 2.46373701;
+    }
+    for ( auto& amplitude: amplitudes )
+    {
+        amplitude.x *= scale;
+        amplitude.y *= scale;
+        amplitude.z *= scale;
+    }
+    return amplitudes;
+}
+
+// The largest difference of a channel, relative to the largest magnitude of the reference.
+double MaxRelativeError( const std::vector<Double3>& reference, const Float3* values )
+{
+    double magnitude = 0.0, error = 0.0;
+    for ( size_t i = 0; i < reference.size(); ++i )
+    {
+        const Double3& r = reference[i];
+        magnitude        = std::max( { magnitude, std::abs( r.x ), std::abs( r.y ), std::abs( r.z ) } );
+        error            = std::max( { error, std::abs( r.x - values[i].x ), std::abs( r.y - values[i].y ),
+                            std::abs( r.z - values[i].z ) } );
+    }
+    return error / magnitude;
+}
+
+// Sizes that leave a remainder for the scalar loop (1, 3, 17) and sizes that
+// are split into several batches (64, 128).
+const uint32 CubemapSizes[] = { 1, 3, 17, 64, 128 };
+
+}  // namespace
+
+TEST_CASE( CubemapProjection_SH9MatchesScalar )
+{
+    for ( uint32 size: CubemapSizes )
+    {
+        TextureData<Float4> cubemap;
+        RandomCubemap( size, size, cubemap );
+
+        std::vector<Double3> reference = ReferenceSH9( cubemap );
+        SH9Color             sh        = ProjectCubemapToSH( cubemap );
+
+        CHECK( MaxRelativeError( reference, sh.Coefficients ) < 1e-5 );
+    }
+}
+
+TEST_CASE( CubemapProjection_SH9OfConstantRadiance )
+{
+    // A constant radiance only has the DC term: L * 0.282095 * 4 * Pi.
+    TextureData<Float4> cubemap;
+    cubemap.Init( 32, 32, 6 );
+    for ( uint64 i = 0; i < cubemap.Texels.Size(); ++i )
+    {
+        cubemap.Texels[i] = Float4( 1.0f, 2.0f, 0.5f, 1.0f );
+    }
+
+    SH9Color sh = ProjectCubemapToSH( cubemap );
+
+    const float dc = 0.282095f * 4.0f * 3.14159f;
+    CHECK_NEAR( sh.Coefficients[0].x, 1.0f * dc, 1e-4f );
+    CHECK_NEAR( sh.Coefficients[0].y, 2.0f * dc, 1e-4f );
+    CHECK_NEAR( sh.Coefficients[0].z, 0.5f * dc, 1e-4f );
+    for ( uint64 i = 1; i < 9; ++i )
+    {
+        CHECK_NEAR( sh.Coefficients[i].x, 0.0f, 1e-4f );
+        CHECK_NEAR( sh.Coefficients[i].y, 0.0f, 1e-4f );
+        CHECK_NEAR( sh.Coefficients[i].z, 0.0f, 1e-4f );
+    }
+}
+
+TEST_CASE( CubemapProjection_SGsMatchScalar )
+{
+    for ( uint32 size: CubemapSizes )
+    {
+        TextureData<Float4> cubemap;
+        RandomCubemap( size, size + 100, cubemap );
+
+        for ( uint64 numSGs: { 9, 12, 24 } )
+        {
+            std::vector<Double3> reference = ReferenceSGAmplitudes( cubemap, numSGs );
+
+            std::vector<SG> sgs( numSGs );
+            SolveSGsForCubemap( cubemap, sgs.data(), numSGs, SGSolveMode::Projection );
+
+            std::vector<Float3> amplitudes( numSGs );
+            for ( uint64 i = 0; i < numSGs; ++i )
+            {
+                amplitudes[i] = sgs[i].Amplitude;
+            }
+
+            CHECK( MaxRelativeError( reference, amplitudes.data() ) < 1e-5 );
+        }
+    }
+}
+
+TEST_CASE( CubemapProjection_IsDeterministic )
+{
+    // The partial sums of the batches are added up in order, so the result
+    // doesn't depend on how the batches were scheduled on the worker threads.
+    TextureData<Float4> cubemap;
+    RandomCubemap( 128, 7, cubemap );
+
+    SH9Color first  = ProjectCubemapToSH( cubemap );
+    SH9Color second = ProjectCubemapToSH( cubemap );
+    for ( uint64 i = 0; i < 9; ++i )
+    {
+        CHECK( first.Coefficients[i].x == second.Coefficients[i].x );
+        CHECK( first.Coefficients[i].y == second.Coefficients[i].y );
+        CHECK( first.Coefficients[i].z == second.Coefficients[i].z );
+    }
+
+    SG firstSGs[12], secondSGs[12];
+    SolveSGsForCubemap( cubemap, firstSGs, 12, SGSolveMode::Projection );
+    SolveSGsForCubemap( cubemap, secondSGs, 12, SGSolveMode::Projection );
+    for ( uint64 i = 0; i < 12; ++i )
+    {
+        CHECK( firstSGs[i].Amplitude.x == secondSGs[i].Amplitude.x );
+        CHECK( firstSGs[i].Amplitude.y == secondSGs[i].Amplitude.y );
+        CHECK( firstSGs[i].Amplitude.z == secondSGs[i].Amplitude.z );
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * Measures the generation throughput of the low-discrepancy samplers (v1.02):
+ * the Owen-scrambled Sobol sequence one dimension at a time, 4 dimensions at a
+ * time and batched, against RadicalInverseFast from Sampling.cpp, plus the cost
+ * of generating PMJ02 sets, the blue noise mask and the sample tables.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/SampleSequences.h>
+#include <Graphics/Sampling.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+const uint32 NumSamples = 1 << 20;
+
+double Seconds( Clock::time_point startTime )
+{
+    return std::chrono::duration<double>( Clock::now() - startTime ).count();
+}
+
+void PrintThroughput( const char* name, double numDims, double seconds )
+{
+    std::printf( "%-40s %9.2f ms %8.1f M dims/s\n", name, seconds * 1000.0, numDims / seconds / 1000000.0 );
+}
+
+}  // namespace
+
+TEST_CASE( Benchmark_SampleSequences_Throughput )
+{
+    // Keeps the compiler from removing the loops.
+    volatile float sink = 0.0f;
+
+    // Bases 3 to 11, the first 4 dimensions after the 2 of Hammersley2D.
+    auto startTime = Clock::now();
+    for ( uint32 i = 0; i < NumSamples; ++i )
+    {
+        sink = sink + RadicalInverseFast( 1, i ) + RadicalInverseFast( 2, i ) + RadicalInverseFast( 3, i ) +
+               RadicalInverseFast( 4, i );
+    }
+    PrintThroughput( "RadicalInverseFast", 4.0 * NumSamples, Seconds( startTime ) );
+
+    startTime = Clock::now();
+    for ( uint32 i = 0; i < NumSamples; ++i )
+    {
+        for ( uint32 dimIdx = 0; dimIdx < 4; ++dimIdx )
+        {
+            sink = sink + SampleSobolOwen( i, dimIdx, 7 );
+        }
+    }
+    PrintThroughput( "SampleSobolOwen", 4.0 * NumSamples, Seconds( startTime ) );
+
+    startTime = Clock::now();
+    for ( uint32 i = 0; i < NumSamples; ++i )
+    {
+        const Float4 group = SampleSobolOwen4D( i, 0, 7 );
+        sink               = sink + group.x + group.y + group.z + group.w;
+    }
+    PrintThroughput( "SampleSobolOwen4D", 4.0 * NumSamples, Seconds( startTime ) );
+
+    std::vector<float> samples( uint64( NumSamples ) * 8 );
+    startTime = Clock::now();
+    GenerateSobolOwenSamples( samples.data(), NumSamples, 8, 7 );
+    PrintThroughput( "GenerateSobolOwenSamples (8 dims)", 8.0 * NumSamples, Seconds( startTime ) );
+    sink = sink + samples[NumSamples];
+
+    std::vector<Float2> pmj02Samples( 4096 );
+    Random              rng;
+    rng.Seed( 1 );
+    startTime = Clock::now();
+    for ( uint32 set = 0; set < 16; ++set )
+    {
+        GeneratePMJ02Samples2D( pmj02Samples.data(), pmj02Samples.size(), rng );
+    }
+    std::printf( "%-40s %9.2f ms per set\n", "GeneratePMJ02Samples2D (4096)", Seconds( startTime ) * 1000.0 / 16 );
+    sink = sink + pmj02Samples[0].x;
+
+    std::vector<uint16> ranks( 64 * 64 );
+    startTime = Clock::now();
+    GenerateBlueNoiseRanks( ranks.data(), 64, 0 );
+    std::printf( "%-40s %9.2f ms\n", "GenerateBlueNoiseRanks (64^2)", Seconds( startTime ) * 1000.0 );
+
+    SampleTablesInit init;
+    SampleTables     tables;
+    startTime = Clock::now();
+    tables.Generate( init );
+    const double generateTime = Seconds( startTime );
+    std::printf( "%-40s %9.2f ms %8.1f KB\n", "SampleTables::Generate (defaults)", generateTime * 1000.0,
+                 tables.Size() / 1024.0 );
+
+    startTime = Clock::now();
+    for ( uint32 i = 0; i < NumSamples; ++i )
+    {
+        const Float2 sample = tables.SamplePMJ02( i >> 12, i );
+        sink                = sink + sample.x + sample.y;
+    }
+    PrintThroughput( "SampleTables::SamplePMJ02", 2.0 * NumSamples, Seconds( startTime ) );
+
+    startTime = Clock::now();
+    for ( uint32 i = 0; i < NumSamples; ++i )
+    {
+        sink = sink + tables.SampleSobolOwenDithered( i >> 12, i & 7, 3, i & 63, ( i >> 6 ) & 63 );
+    }
+    PrintThroughput( "SampleTables::SampleSobolOwenDithered", double( NumSamples ), Seconds( startTime ) );
+    tables.Shutdown();
+}
@@ -0,0 +1,277 @@
+/**
+ * Tests the low-discrepancy samplers (v1.02): the stratification of the
+ * Owen-scrambled Sobol and PMJ02 sequences, the batched Sobol generator against
+ * the single sample functions, the blue noise mask, and the convergence rate of
+ * the sequences on known integrals and their L2-star discrepancy, compared with
+ * uniform random samples.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/SampleSequences.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+const double Pi64 = 3.14159265358979323846;
+
+uint32 ToFixedPoint( float value )
+{
+    return uint32( double( value ) * 4294967296.0 );
+}
+
+// Returns true if the first 2^m points are a (0,m,2)-net: every elementary
+// interval with an area of 2^-m contains exactly one point.
+bool IsNet( const std::vector<Float2>& samples, uint32 m )
+{
+    const uint64      numSamples = 1ull << m;
+    std::vector<bool> occupied( numSamples );
+    for ( uint32 xBits = 0; xBits <= m; ++xBits )
+    {
+        std::fill( occupied.begin(), occupied.end(), false );
+        for ( uint64 i = 0; i < numSamples; ++i )
+        {
+            const uint64 cellX = uint64( ToFixedPoint( samples[i].x ) ) >> ( 32 - xBits );
+            const uint64 cellY = uint64( ToFixedPoint( samples[i].y ) ) >> ( 32 - ( m - xBits ) );
+            const uint64 cell  = ( cellX << ( m - xBits ) ) + cellY;
+            if ( occupied[cell] )
+            {
+                return false;
+            }
+            occupied[cell] = true;
+        }
+    }
+    return true;
+}
+
+// The L2-star discrepancy of a 2D point set, with Warnock's formula.
+double L2StarDiscrepancy( const std::vector<Float2>& samples )
+{
+    const double n    = double( samples.size() );
+    double       sum1 = 0.0;
+    double       sum2 = 0.0;
+    for ( const Float2& a: samples )
+    {
+        sum1 += ( 1.0 - a.x * a.x ) * ( 1.0 - a.y * a.y );
+        for ( const Float2& b: samples )
+        {
+            sum2 += ( 1.0 - std::max( a.x, b.x ) ) * ( 1.0 - std::max( a.y, b.y ) );
+        }
+    }
+    return std::sqrt( 1.0 / 9.0 - sum1 / ( 2.0 * n ) + sum2 / ( n * n ) );
+}
+
+// The number of horizontally or vertically adjacent pairs of texels with a rank below the threshold.
+uint32 CountNeighbors( const std::vector<uint16>& ranks, uint32 size, uint32 threshold )
+{
+    uint32 numNeighbors = 0;
+    for ( uint32 y = 0; y < size; ++y )
+    {
+        for ( uint32 x = 0; x < size; ++x )
+        {
+            if ( ranks[y * size + x] < threshold )
+            {
+                numNeighbors += ranks[y * size + ( x + 1 ) % size] < threshold;
+                numNeighbors += ranks[( ( y + 1 ) % size ) * size + x] < threshold;
+            }
+        }
+    }
+    return numNeighbors;
+}
+
+enum class Sequence
+{
+    Random,
+    SobolOwen,
+    PMJ02,
+};
+
+std::vector<Float2> GenerateSamples( Sequence sequence, uint32 numSamples, uint32 seed )
+{
+    std::vector<Float2> samples( numSamples );
+    Random              rng;
+    rng.Seed( seed );
+    if ( sequence == Sequence::Random )
+    {
+        for ( Float2& sample: samples )
+        {
+            sample = rng.RandomFloat2();
+        }
+    }
+    else if ( sequence == Sequence::SobolOwen )
+    {
+        GenerateSobolOwenSamples2D( samples.data(), numSamples, 0, seed );
+    }
+    else
+    {
+        GeneratePMJ02Samples2D( samples.data(), numSamples, rng );
+    }
+    return samples;
+}
+
+// A smooth integrand: exp(-x^2 - y^2) over the unit square.
+double Gaussian( const Float2& p )
+{
+    return std::exp( -( double( p.x ) * p.x + double( p.y ) * p.y ) );
+}
+
+// A discontinuous integrand: the quarter disc x^2 + y^2 < 1.
+double QuarterDisc( const Float2& p )
+{
+    return double( p.x ) * p.x + double( p.y ) * p.y < 1.0 ? 1.0 : 0.0;
+}
+
+const double GaussianIntegral    = std::pow( std::sqrt( Pi64 ) / 2.0 * std::erf( 1.0 ), 2.0 );
+const double QuarterDiscIntegral = Pi64 / 4.0;
+
+const uint32 NumRandomizations = 32;
+
+// The RMS error of the integral over independent randomizations of the sequence.
+template<typename Func>
+double RMSError( Sequence sequence, uint32 numSamples, Func&& integrand, double reference )
+{
+    double sumSquaredError = 0.0;
+    for ( uint32 rep = 0; rep < NumRandomizations; ++rep )
+    {
+        std::vector<Float2> samples  = GenerateSamples( sequence, numSamples, rep * 977 + 1 );
+        double              estimate = 0.0;
+        for ( const Float2& sample: samples )
+        {
+            estimate += integrand( sample );
+        }
+        estimate /= numSamples;
+        sumSquaredError += ( estimate - reference ) * ( estimate - reference );
+    }
+    return std::sqrt( sumSquaredError / NumRandomizations );
+}
+
+// The slope of the error on a log-log plot, between 16 and 4096 samples.
+template<typename Func>
+double ConvergenceRate( Sequence sequence, Func&& integrand, double reference )
+{
+    const double errorLow  = RMSError( sequence, 16, integrand, reference );
+    const double errorHigh = RMSError( sequence, 4096, integrand, reference );
+    return std::log( errorHigh / errorLow ) / std::log( 4096.0 / 16.0 );
+}
+
+}  // namespace
+
+TEST_CASE( SampleSequences_SobolOwenIsNet )
+{
+    // Dimensions 0 and 1 of every group form a (0,2)-sequence, so every power
+    // of 2 prefix is a (0,m,2)-net.
+    for ( uint32 seed: { 0u, 7919u, 123456u } )
+    {
+        for ( uint32 groupIdx = 0; groupIdx < 3; ++groupIdx )
+        {
+            std::vector<Float2> samples( 4096 );
+            for ( uint32 i = 0; i < 4096; ++i )
+            {
+                samples[i] = SampleSobolOwen2D( i, groupIdx * SobolOwenGroupSize, seed );
+            }
+            for ( uint32 m = 0; m <= 12; ++m )
+            {
+                CHECK( IsNet( samples, m ) );
+            }
+        }
+    }
+}
+
+TEST_CASE( SampleSequences_SobolOwenBatchedMatchesSingle )
+{
+    const uint32       numSamples = 1000;
+    const uint32       numDims    = 10;
+    std::vector<float> samples( numSamples * numDims );
+    GenerateSobolOwenSamples( samples.data(), numSamples, numDims, 42 );
+
+    for ( uint32 i = 0; i < numSamples; ++i )
+    {
+        for ( uint32 dimIdx = 0; dimIdx < numDims; ++dimIdx )
+        {
+            const float sample = SampleSobolOwen( i, dimIdx, 42 );
+            CHECK( samples[i * numDims + dimIdx] == sample );
+            CHECK( sample >= 0.0f && sample < 1.0f );
+        }
+
+        const Float4 group = SampleSobolOwen4D( i, 1, 42 );
+        CHECK( group.x == SampleSobolOwen( i, 4, 42 ) );
+        CHECK( group.w == SampleSobolOwen( i, 7, 42 ) );
+    }
+}
+
+TEST_CASE( SampleSequences_PMJ02IsNet )
+{
+    for ( uint32 seed = 0; seed < 4; ++seed )
+    {
+        std::vector<Float2> samples = GenerateSamples( Sequence::PMJ02, 4096, seed );
+        for ( uint32 m = 0; m <= 12; ++m )
+        {
+            CHECK( IsNet( samples, m ) );
+        }
+    }
+
+    // A size that isn't a power of 2 still stratifies its power of 2 prefixes.
+    std::vector<Float2> samples = GenerateSamples( Sequence::PMJ02, 1000, 5 );
+    CHECK( IsNet( samples, 9 ) );
+}
+
+TEST_CASE( SampleSequences_BlueNoiseMask )
+{
+    const uint32        size = 32;
+    std::vector<uint16> ranks( size * size );
+    GenerateBlueNoiseRanks( ranks.data(), size, 0 );
+
+    std::vector<bool> seen( size * size );
+    for ( uint16 rank: ranks )
+    {
+        REQUIRE( rank < size * size );
+        CHECK( !seen[rank] );
+        seen[rank] = true;
+    }
+
+    // Any threshold of the mask is spread out: the first 10% of the ranks has no
+    // two texels next to each other, not even across the tile edges, and the
+    // first 25% has less than half as many neighbors as white noise would have.
+    CHECK( CountNeighbors( ranks, size, size * size / 10 ) == 0 );
+
+    const double whiteNoiseNeighbors = 2.0 * size * size * ( 1.0 / 4.0 ) * ( 1.0 / 4.0 );
+    CHECK( CountNeighbors( ranks, size, size * size / 4 ) < 0.5 * whiteNoiseNeighbors );
+}
+
+TEST_CASE( SampleSequences_ConvergenceRate )
+{
+    // Random samples converge with N^-0.5. Scrambled (0,2)-sequences converge
+    // with up to N^-1.5 on smooth integrands and N^-0.75 on discontinuous ones.
+    // Measured slopes are about -1.4 and -0.76 for both sequences.
+    const double randomRate = ConvergenceRate( Sequence::Random, Gaussian, GaussianIntegral );
+    CHECK( randomRate > -0.7 && randomRate < -0.3 );
+
+    for ( Sequence sequence: { Sequence::SobolOwen, Sequence::PMJ02 } )
+    {
+        CHECK( ConvergenceRate( sequence, Gaussian, GaussianIntegral ) < -1.2 );
+        CHECK( ConvergenceRate( sequence, QuarterDisc, QuarterDiscIntegral ) < -0.65 );
+
+        CHECK( RMSError( sequence, 4096, Gaussian, GaussianIntegral ) <
+               RMSError( Sequence::Random, 4096, Gaussian, GaussianIntegral ) / 20.0 );
+    }
+}
+
+TEST_CASE( SampleSequences_Discrepancy )
+{
+    // At 1024 samples: random about 1e-2, Hammersley 1.8e-3, Sobol-Owen and PMJ02 about 7e-4.
+    const double randomDiscrepancy = L2StarDiscrepancy( GenerateSamples( Sequence::Random, 1024, 3 ) );
+    CHECK( randomDiscrepancy > 4e-3 );
+
+    for ( Sequence sequence: { Sequence::SobolOwen, Sequence::PMJ02 } )
+    {
+        const double discrepancy = L2StarDiscrepancy( GenerateSamples( sequence, 1024, 3 ) );
+        CHECK( discrepancy < 1.5e-3 );
+        CHECK( discrepancy < randomDiscrepancy / 4.0 );
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * Measures the cost of computing the sky of a SkyCache (everything that
+ * SkyCache::Init does except for creating the cubemap texture) with the sun LUT
+ * and the SIMD cubemap, and with the code they replaced, which allocated a
+ * spectral sky state per wavelength and evaluated the sky one texel at a time.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/Skybox.h>
+#include <Graphics/Spectrum.h>
+#include <Graphics/Textures.h>
+#include <HosekSky/ArHosekSkyModel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+using Clock = std::chrono::high_resolution_clock;
+
+const Float3 GroundAlbedo( 0.3f, 0.5f, 0.2f );
+const float  Turbidity = 3.0f;
+const float  SunSize   = 1.0f;
+
+Float3 SunDirection( float elevationDegrees )
+{
+    const float elevation = DegToRad( elevationDegrees );
+    return Float3::Normalize( Float3( std::cos( elevation ) * 0.6f, std::sin( elevation ), std::cos( elevation ) * 0.8f ) );
+}
+
+float AngleBetween( const Float3& dir0, const Float3& dir1 )
+{
+    return std::acos( std::max( Float3::Dot( dir0, dir1 ), 0.00001f ) );
+}
+
+// SkyCache::Init before the sun LUT: the solar disc is integrated with a
+// spectral sky state per wavelength, and the cubemap, SH and SGs are computed
+// one texel at a time.
+void OldComputeSky( const Float3& sunDirection, float sunSize, const Float3& groundAlbedo, float turbidity, bool createCubemap,
+                    SkyCacheResults& results )
+{
+    const float thetaS    = AngleBetween( sunDirection, Float3( 0, 1, 0 ) );
+    const float elevation = Pi_2 - thetaS;
+    results.StateR        = arhosek_rgb_skymodelstate_alloc_init( turbidity, groundAlbedo.x, elevation );
+    results.StateG        = arhosek_rgb_skymodelstate_alloc_init( turbidity, groundAlbedo.y, elevation );
+    results.StateB        = arhosek_rgb_skymodelstate_alloc_init( turbidity, groundAlbedo.z, elevation );
+
+    SampledSpectrum       groundAlbedoSpectrum = SampledSpectrum::FromRGB( groundAlbedo, SpectrumType::Reflectance );
+    ArHosekSkyModelState* skyStates[NumSpectralSamples] = {};
+    for ( int32 i = 0; i < NumSpectralSamples; ++i )
+    {
+        skyStates[i] = arhosekskymodelstate_alloc_init( thetaS, turbidity, groundAlbedoSpectrum[i] );
+    }
+
+    const float  cosSunSize = std::cos( DegToRad( 0.27f ) );
+    const Float3 sunDirX    = Float3::Perpendicular( sunDirection );
+    const Float3 sunDirY    = Float3::Cross( sunDirection, sunDirX );
+
+    const uint64    NumSamples = 8;
+    SampledSpectrum solarRadiance;
+    Float3          sunIrradiance;
+    for ( uint64 x = 0; x < NumSamples; ++x )
+    {
+        for ( uint64 y = 0; y < NumSamples; ++y )
+        {
+            const float cosTheta = ( 1.0f - ( x + 0.5f ) / NumSamples ) + ( ( x + 0.5f ) / NumSamples ) * cosSunSize;
+            const float sinTheta = std::sqrt( 1.0f - cosTheta * cosTheta );
+            const float phi      = ( ( y + 0.5f ) / NumSamples ) * Pi2;
+            const Float3 sampleDir =
+                sunDirX * ( std::cos( phi ) * sinTheta ) + sunDirY * ( std::sin( phi ) * sinTheta ) + sunDirection * cosTheta;
+
+            const float sampleThetaS = AngleBetween( sampleDir, Float3( 0, 1, 0 ) );
+            const float sampleGamma  = AngleBetween( sampleDir, sunDirection );
+            for ( int32 i = 0; i < NumSpectralSamples; ++i )
+            {
+                const float wavelength = Lerp( float( SampledLambdaStart ), float( SampledLambdaEnd ), i / float( NumSpectralSamples ) );
+                solarRadiance[i] = float( arhosekskymodel_solar_radiance( skyStates[i], sampleThetaS, sampleGamma, wavelength ) );
+            }
+            sunIrradiance += solarRadiance.ToRGB() * FP16Scale * Saturate( Float3::Dot( sampleDir, sunDirection ) );
+        }
+    }
+    results.SunIrradiance = sunIrradiance * ( 2.0f * Pi * ( 1.0f - cosSunSize ) / ( NumSamples * NumSamples ) ) * 683.0f * 100.0f;
+
+    for ( int32 i = 0; i < NumSpectralSamples; ++i )
+    {
+        arhosekskymodelstate_free( skyStates[i] );
+    }
+
+    if ( createCubemap )
+    {
+        const uint64  NumTexels = uint64( SkyCubeMapRes ) * SkyCubeMapRes * 6;
+        Array<Float3> samples( NumTexels );
+        Array<Float3> sampleDirs( NumTexels );
+        results.CubeMapTexels.Init( NumTexels );
+
+        float weightSum = 0.0f;
+        for ( uint32 face = 0; face < 6; ++face )
+        {
+            for ( uint32 y = 0; y < SkyCubeMapRes; ++y )
+            {
+                for ( uint32 x = 0; x < SkyCubeMapRes; ++x )
+                {
+                    const Float3 dir   = MapXYSToDirection( x, y, face, SkyCubeMapRes, SkyCubeMapRes );
+                    const float  gamma = AngleBetween( dir, sunDirection );
+                    const float  theta = AngleBetween( dir, Float3( 0, 1, 0 ) );
+
+                    Float3 radiance;
+                    radiance.x = float( arhosek_tristim_skymodel_radiance( results.StateR, theta, gamma, 0 ) );
+                    radiance.y = float( arhosek_tristim_skymodel_radiance( results.StateG, theta, gamma, 1 ) );
+                    radiance.z = float( arhosek_tristim_skymodel_radiance( results.StateB, theta, gamma, 2 ) );
+                    radiance *= 683.0f * FP16Scale;
+
+                    const uint64 idx           = ( face * SkyCubeMapRes + y ) * uint64( SkyCubeMapRes ) + x;
+                    samples[idx]               = radiance;
+                    sampleDirs[idx]            = dir;
+                    results.CubeMapTexels[idx] = Half4( Float4( radiance, 1.0f ) );
+
+                    const float u      = ( ( x + 0.5f ) / SkyCubeMapRes ) * 2.0f - 1.0f;
+                    const float v      = ( ( y + 0.5f ) / SkyCubeMapRes ) * 2.0f - 1.0f;
+                    const float temp   = 1.0f + u * u + v * v;
+                    const float weight = 4.0f / ( std::sqrt( temp ) * temp );
+
+                    results.SH += ProjectOntoSH9Color( dir, radiance ) * weight;
+                    weightSum += weight;
+                }
+            }
+        }
+        results.SH *= ( 4.0f * 3.14159f ) / weightSum;
+
+        SGSolveParams solveParams;
+        solveParams.SampleDirs   = sampleDirs.Data();
+        solveParams.SampleValues = samples.Data();
+        solveParams.NumSamples   = NumTexels;
+        solveParams.SolveMode    = SGSolveMode::NNLS;
+        solveParams.Distribution = SGDistribution::Spherical;
+        solveParams.NumSGs       = 9;
+        solveParams.OutSGs       = results.SG.Lobes;
+        SolveSGs( solveParams );
+    }
+}
+
+// Moves the sun by a small step every frame, like an animated time of day, and
+// prints the mean and the largest time of a frame.
+template<typename ComputeFunc>
+void RunAnimation( const char* name, ComputeFunc&& computeFunc, bool createCubemap, int numFrames )
+{
+    double totalTime = 0.0;
+    double maxTime   = 0.0;
+    for ( int frame = 0; frame < numFrames; ++frame )
+    {
+        Float3 sunDirection = SunDirection( 20.0f + frame * 0.05f );
+        Float3 groundAlbedo = GroundAlbedo;
+        float  sunSize      = SunSize;
+        float  turbidity    = Turbidity;
+        ClampSkyParams( sunDirection, sunSize, groundAlbedo, turbidity );
+
+        auto startTime = Clock::now();
+
+        SkyCacheResults results;
+        computeFunc( sunDirection, sunSize, groundAlbedo, turbidity, createCubemap, results );
+
+        const double time = std::chrono::duration<double, std::milli>( Clock::now() - startTime ).count();
+        totalTime += time;
+        maxTime = std::max( maxTime, time );
+    }
+
+    std::printf( "%-36s %9.3f ms %9.3f ms\n", name, totalTime / numFrames, maxTime );
+}
+
+}  // namespace
+
+TEST_CASE( Benchmark_SkyModel_Init )
+{
+    SampledSpectrum::Init();
+
+    // Warms up the cubemap texel table and the worker threads, but not the
+    // cells of the sun LUT that the animation moves through.
+    {
+        SkyCacheResults results;
+        ComputeSky( SunDirection( 60.0f ), SunSize, GroundAlbedo, Turbidity, true, results );
+    }
+
+    std::printf( "%-36s %12s %12s\n", "", "Mean", "Max" );
+
+    // The first pass of the new code includes computing the LUT nodes, the
+    // second pass reads them from the LUT.
+    RunAnimation( "Old, sun only", OldComputeSky, false, 100 );
+    RunAnimation( "New, sun only (LUT cold)", ComputeSky, false, 100 );
+    RunAnimation( "New, sun only (LUT warm)", ComputeSky, false, 100 );
+    RunAnimation( "Old, with cubemap, SH and SG9", OldComputeSky, true, 10 );
+    RunAnimation( "New, with cubemap, SH and SG9", ComputeSky, true, 10 );
+}
@@ -0,0 +1,180 @@
+/**
+ * Tests the CPU side of the sky cache (v1.02): the sun irradiance that is
+ * interpolated from the spectral LUT against a double precision integration of
+ * the spectral model over the solar disc, and the SIMD sky cubemap against the
+ * RGB model evaluated one texel at a time.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/Skybox.h>
+#include <Graphics/Spectrum.h>
+#include <Graphics/Textures.h>
+#include <HosekSky/ArHosekSkyModel.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+// The sun irradiance of SkyCache is scaled to FP16 and photometric units.
+const double SunIrradianceScale = FP16Scale * 683.0 * 100.0;
+
+// The angular radius of the sun that the irradiance is integrated over.
+const double PhysicalSunSize = 0.27 * 3.14159265358979 / 180.0;
+
+Float3 SunDirection( float elevationDegrees )
+{
+    const float elevation = DegToRad( elevationDegrees );
+    return Float3::Normalize( Float3( std::cos( elevation ) * 0.6f, std::sin( elevation ), std::cos( elevation ) * 0.8f ) );
+}
+
+// Integrates the spectral solar radiance over the solar disc with 32x32
+// stratified samples and a sky state for every wavelength, like SkyCache::Init
+// did before the LUT, but in double precision.
+Float3 ReferenceSunIrradiance( double elevation, double turbidity, const Float3& groundAlbedo )
+{
+    const int NumSamples = 32;
+
+    SampledSpectrum albedo = SampledSpectrum::FromRGB( groundAlbedo, SpectrumType::Reflectance );
+    SampledSpectrum irradiance;
+
+    const double pi         = 3.14159265358979;
+    const double thetaS     = pi / 2.0 - elevation;
+    const double cosSunSize = std::cos( PhysicalSunSize );
+    for ( int i = 0; i < NumSpectralSamples; ++i )
+    {
+        ArHosekSkyModelState* state = arhosekskymodelstate_alloc_init( thetaS, turbidity, albedo[i] );
+        const double wavelength = SampledLambdaStart + ( SampledLambdaEnd - SampledLambdaStart ) * double( i ) / NumSpectralSamples;
+
+        double sum = 0.0;
+        for ( int x = 0; x < NumSamples; ++x )
+        {
+            for ( int y = 0; y < NumSamples; ++y )
+            {
+                const double u1       = ( x + 0.5 ) / NumSamples;
+                const double u2       = ( y + 0.5 ) / NumSamples;
+                const double cosGamma = ( 1.0 - u1 ) + u1 * cosSunSize;
+                const double sinGamma = std::sqrt( 1.0 - cosGamma * cosGamma );
+                const double phi      = u2 * 2.0 * pi;
+                const double cosTheta = std::sin( elevation ) * cosGamma - std::cos( elevation ) * std::sin( phi ) * sinGamma;
+
+                sum += arhosekskymodel_solar_radiance( state, std::acos( std::max( cosTheta, 0.00001 ) ), std::acos( cosGamma ),
+                                                       wavelength ) *
+                       cosGamma;
+            }
+        }
+        arhosekskymodelstate_free( state );
+
+        irradiance[i] = float( sum / ( NumSamples * NumSamples ) * 2.0 * pi * ( 1.0 - cosSunSize ) );
+    }
+    return irradiance.ToRGB();
+}
+
+// The largest difference of a channel, relative to the largest channel of the reference.
+double MaxRelativeError( const Float3& value, const Float3& reference )
+{
+    const double magnitude = std::max( { reference.x, reference.y, reference.z } );
+    const double error     = std::max( { std::abs( value.x - reference.x ), std::abs( value.y - reference.y ),
+                                     std::abs( value.z - reference.z ) } );
+    return error / magnitude;
+}
+
+}  // namespace
+
+TEST_CASE( SkyModel_ClampsParams )
+{
+    Float3 sunDirection( 0.5f, -0.2f, 0.0f );
+    float  sunSize      = 0.0f;
+    Float3 groundAlbedo = Float3( -1.0f, 0.5f, 2.0f );
+    float  turbidity    = 32.0f;
+    ClampSkyParams( sunDirection, sunSize, groundAlbedo, turbidity );
+
+    // The model only has data up to a turbidity of 10, and the sun can't go below the horizon.
+    CHECK( turbidity == 10.0f );
+    CHECK( sunSize == 0.01f );
+    CHECK( groundAlbedo.x == 0.0f && groundAlbedo.y == 0.5f && groundAlbedo.z == 1.0f );
+    CHECK( sunDirection.y == 0.0f );
+    CHECK_NEAR( sunDirection.x, 1.0f, 1e-6f );
+}
+
+TEST_CASE( SkyModel_SunIrradianceWithinBounds )
+{
+    SampledSpectrum::Init();
+
+    const Float3 albedos[] = { Float3( 0.0f ), Float3( 0.3f, 0.5f, 0.2f ), Float3( 1.0f ) };
+
+    double sumError = 0.0;
+    double maxError = 0.0;
+    int    numSamples = 0;
+    for ( float elevation: { 1.0f, 4.0f, 17.0f, 45.0f, 89.0f } )
+    {
+        for ( float turbidity: { 1.0f, 2.6f, 6.3f, 10.0f } )
+        {
+            for ( const Float3& albedo: albedos )
+            {
+                Float3 sunDirection = SunDirection( elevation );
+                float  sunSize      = 1.0f;
+                Float3 groundAlbedo = albedo;
+                float  clamped      = turbidity;
+                ClampSkyParams( sunDirection, sunSize, groundAlbedo, clamped );
+
+                SkyCacheResults results;
+                ComputeSky( sunDirection, sunSize, groundAlbedo, clamped, false, results );
+                REQUIRE( results.CubeMapTexels.Size() == 0 );
+
+                const Float3 reference = ReferenceSunIrradiance( results.Elevation, turbidity, albedo );
+                const Float3 irradiance = results.SunIrradiance / float( SunIrradianceScale );
+                const double error      = MaxRelativeError( irradiance, reference );
+                sumError += error;
+                maxError = std::max( maxError, error );
+                ++numSamples;
+            }
+        }
+    }
+
+    // The error is relative to the largest channel. On these points the LUT
+    // has 0.05% mean and 0.22% max error, the largest near the horizon.
+    CHECK( sumError / numSamples < 0.001 );
+    CHECK( maxError < 0.005 );
+}
+
+TEST_CASE( SkyModel_CubemapMatchesModel )
+{
+    SampledSpectrum::Init();
+
+    for ( float elevation: { 2.0f, 30.0f, 80.0f } )
+    {
+        SkyCacheResults results;
+        ComputeSky( SunDirection( elevation ), 1.0f, Float3( 0.3f, 0.5f, 0.2f ), 3.0f, true, results );
+        REQUIRE( results.CubeMapTexels.Size() == uint64( SkyCubeMapRes ) * SkyCubeMapRes * 6 );
+
+        // The texels are stored as FP16, which has a relative precision of 2^-11.
+        double maxError = 0.0;
+        for ( uint32 face = 0; face < 6; ++face )
+        {
+            for ( uint32 y = 0; y < SkyCubeMapRes; ++y )
+            {
+                for ( uint32 x = 0; x < SkyCubeMapRes; ++x )
+                {
+                    const Float3 dir   = MapXYSToDirection( x, y, face, SkyCubeMapRes, SkyCubeMapRes );
+                    const double gamma = std::acos( std::max( double( Float3::Dot( dir, results.SunDirection ) ), 0.00001 ) );
+                    const double theta = std::acos( std::max( double( dir.y ), 0.00001 ) );
+
+                    const uint64 idx = ( face * SkyCubeMapRes + y ) * uint64( SkyCubeMapRes ) + x;
+                    Float3       radiance;
+                    radiance.x = float( arhosek_tristim_skymodel_radiance( results.StateR, theta, gamma, 0 ) );
+                    radiance.y = float( arhosek_tristim_skymodel_radiance( results.StateG, theta, gamma, 1 ) );
+                    radiance.z = float( arhosek_tristim_skymodel_radiance( results.StateB, theta, gamma, 2 ) );
+                    radiance *= 683.0f * FP16Scale;
+
+                    maxError = std::max( maxError, MaxRelativeError( results.CubeMapTexels[idx].ToFloat3(), radiance ) );
+                }
+            }
+        }
+        CHECK( maxError < 1e-3 );
+    }
+}
@@ -0,0 +1,452 @@
+/**
+ * Tests the pooling policy of the TempRenderTargetPool (v1.02) with a stub
+ * device that checks that the pool never lets two targets that are in use
+ * share memory and always aliases from the target that last used a heap.
+ */
+
+#include "TestHarness.h"
+
+#include <Graphics/TempRenderTargetPool.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace SampleFramework12;
+
+namespace
+{
+
+class StubDevice : public TempRenderTargetDevice
+{
+public:
+    uint64 Fence        = 1;
+    uint64 NumAliases   = 0;
+    bool   InvalidAlias = false;
+
+    std::set<PooledRenderTarget*>                       Targets;
+    std::map<const PooledRenderTarget*, ID3D12Heap*>    TargetHeaps;
+    std::map<ID3D12Heap*, uint64>                       Heaps;
+    std::map<ID3D12Heap*, const PooledRenderTarget*>    Resident;
+
+    virtual uint64 CurrentFence() const override
+    {
+        return Fence;
+    }
+
+    virtual uint64 TargetSize( const TempRenderTargetDesc& desc ) const override
+    {
+        uint64 bytesPerPixel = desc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+        uint64 size          = desc.Width * desc.Height * bytesPerPixel;
+        return ( size + 65535 ) / 65536 * 65536;
+    }
+
+    virtual ID3D12Heap* CreateHeap( uint64 size ) override
+    {
+        // The pool never dereferences heaps, so any unique pointer will do.
+        auto heap = reinterpret_cast<ID3D12Heap*>( static_cast<uintptr_t>( ( m_NextHeap++ ) * 64 ) );
+        Heaps[heap] = size;
+        return heap;
+    }
+
+    virtual void DestroyHeap( ID3D12Heap* heap ) override
+    {
+        CHECK( Heaps.count( heap ) == 1 );
+        Heaps.erase( heap );
+        Resident.erase( heap );
+    }
+
+    virtual PooledRenderTarget* CreateTarget( const TempRenderTargetDesc& desc, ID3D12Heap* heap ) override
+    {
+        CHECK( heap == nullptr || Heaps.count( heap ) == 1 );
+        CHECK( heap == nullptr || Heaps[heap] >= TargetSize( desc ) );
+
+        auto target = new PooledRenderTarget();
+        Targets.insert( target );
+        TargetHeaps[target] = heap;
+        return target;
+    }
+
+    virtual void DestroyTarget( PooledRenderTarget* target ) override
+    {
+        CHECK( Targets.count( target ) == 1 );
+        CHECK( !target->InUse );
+
+        ID3D12Heap* heap = TargetHeaps[target];
+        if ( heap && Resident[heap] == target )
+        {
+            Resident[heap] = nullptr;
+        }
+
+        Targets.erase( target );
+        TargetHeaps.erase( target );
+        delete target;
+    }
+
+    virtual void AliasTarget( const PooledRenderTarget* target, const PooledRenderTarget* previous ) override
+    {
+        ID3D12Heap* heap = TargetHeaps[target];
+        if ( heap == nullptr || Resident[heap] != previous || ( previous && previous->InUse ) )
+        {
+            InvalidAlias = true;
+        }
+
+        Resident[heap] = target;
+        ++NumAliases;
+    }
+
+private:
+    uint64 m_NextHeap = 1;
+};
+
+TempRenderTargetDesc Desc( uint64 width, uint64 height, DXGI_FORMAT format, bool uav = false )
+{
+    TempRenderTargetDesc desc;
+    desc.Width  = width;
+    desc.Height = height;
+    desc.Format = format;
+    desc.UAV    = uav;
+    return desc;
+}
+
+TempRenderTargetPoolSettings Settings( uint64 trimFrames, bool useSharedHeaps )
+{
+    TempRenderTargetPoolSettings settings;
+    settings.TrimFrames     = trimFrames;
+    settings.UseSharedHeaps = useSharedHeaps;
+    return settings;
+}
+
+// Checks that the targets that are in use never share the memory of a heap.
+void CheckInvariants( const TempRenderTargetPool& pool, StubDevice& device )
+{
+    CHECK( !device.InvalidAlias );
+    CHECK( pool.NumTargets() == device.Targets.size() );
+    CHECK( pool.NumHeaps() == device.Heaps.size() );
+
+    std::map<ID3D12Heap*, int> numInUse;
+    for ( uint64 i = 0; i < pool.NumTargets(); ++i )
+    {
+        const PooledRenderTarget* target = pool.Target( i );
+        ID3D12Heap*               heap   = device.TargetHeaps[target];
+        if ( target->InUse && heap )
+        {
+            CHECK( ++numInUse[heap] == 1 );
+            CHECK( device.Resident[heap] == target );
+        }
+    }
+}
+
+const DXGI_FORMAT HDRFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+const DXGI_FORMAT LDRFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+// A frame of post processing: a bloom chain followed by tone mapping. Each pass
+// releases its input once it has written its output.
+void PostProcessFrame( TempRenderTargetPool& pool, StubDevice& device, bool bloom )
+{
+    PooledRenderTarget* scene = pool.Acquire( Desc( 1920, 1080, HDRFormat ) );
+    if ( bloom )
+    {
+        PooledRenderTarget* input = pool.Acquire( Desc( 960, 540, HDRFormat ) );
+        for ( uint64 divisor = 4; divisor <= 32; divisor *= 2 )
+        {
+            PooledRenderTarget* output = pool.Acquire( Desc( 1920 / divisor, 1080 / divisor, HDRFormat ) );
+            input->InUse               = false;
+            input                      = output;
+            CheckInvariants( pool, device );
+        }
+        input->InUse = false;
+    }
+
+    PooledRenderTarget* toneMapped = pool.Acquire( Desc( 1920, 1080, LDRFormat ) );
+    scene->InUse                   = false;
+    toneMapped->InUse              = false;
+    CheckInvariants( pool, device );
+
+    pool.Trim();
+    ++device.Fence;
+    CheckInvariants( pool, device );
+}
+
+}  // namespace
+
+TEST_CASE( TempRenderTargetPool_ReusesReleasedTargets )
+{
+    StubDevice           device;
+    TempRenderTargetPool pool;
+    pool.Initialize( &device, Settings( 60, false ) );
+
+    PooledRenderTarget* a = pool.Acquire( Desc( 256, 256, HDRFormat ) );
+    PooledRenderTarget* b = pool.Acquire( Desc( 256, 256, HDRFormat ) );
+    CHECK( a != b );
+    CHECK( a->InUse && b->InUse );
+
+    // A released target is handed out to the next pass in the same frame.
+    a->InUse              = false;
+    PooledRenderTarget* c = pool.Acquire( Desc( 256, 256, HDRFormat ) );
+    CHECK( c == a );
+
+    // A different size or format needs a new target.
+    b->InUse              = false;
+    c->InUse              = false;
+    PooledRenderTarget* d = pool.Acquire( Desc( 128, 256, HDRFormat ) );
+    PooledRenderTarget* e = pool.Acquire( Desc( 256, 256, LDRFormat ) );
+    CHECK( d != a && d != b && e != a && e != b );
+    d->InUse = false;
+    e->InUse = false;
+
+    CHECK( pool.Stats().NumCreated == 4 );
+    CHECK( pool.Stats().NumReused == 1 );
+
+    pool.Shutdown();
+    CHECK( device.Targets.empty() );
+}
+
+TEST_CASE( TempRenderTargetPool_UAVTargetsServeNonUAVRequests )
+{
+    StubDevice           device;
+    TempRenderTargetPool pool;
+    pool.Initialize( &device, Settings( 60, false ) );
+
+    PooledRenderTarget* uav = pool.Acquire( Desc( 64, 64, LDRFormat, true ) );
+    uav->InUse              = false;
+    PooledRenderTarget* rt  = pool.Acquire( Desc( 64, 64, LDRFormat, false ) );
+    CHECK( rt == uav );
+    rt->InUse = false;
+
+    PooledRenderTarget* rt2 = pool.Acquire( Desc( 32, 32, LDRFormat, false ) );
+    rt2->InUse              = false;
+    PooledRenderTarget* uav2 = pool.Acquire( Desc( 32, 32, LDRFormat, true ) );
+    CHECK( uav2 != rt2 );
+    CHECK( uav2->Desc.UAV );
+    uav2->InUse = false;
+
+    // An exact match is preferred over a target with a UAV.
+    PooledRenderTarget* rt3 = pool.Acquire( Desc( 32, 32, LDRFormat, false ) );
+    CHECK( rt3 == rt2 );
+    rt3->InUse = false;
+
+    pool.Shutdown();
+}
+
+TEST_CASE( TempRenderTargetPool_TrimsTargetsAfterTrimFrames )
+{
+    StubDevice           device;
+    TempRenderTargetPool pool;
+    pool.Initialize( &device, Settings( 10, false ) );
+
+    for ( int frame = 0; frame < 5; ++frame )
+    {
+        PostProcessFrame( pool, device, true );
+    }
+
+    // Once warmed up, frames don't create targets.
+    const uint64 numCreated = pool.Stats().NumCreated;
+    const uint64 numTargets = pool.NumTargets();
+    for ( int frame = 0; frame < 5; ++frame )
+    {
+        PostProcessFrame( pool, device, true );
+    }
+    CHECK( pool.Stats().NumCreated == numCreated );
+
+    // Without bloom, the bloom targets are released after exactly 10 frames.
+    for ( int frame = 0; frame < 9; ++frame )
+    {
+        PostProcessFrame( pool, device, false );
+    }
+    CHECK( pool.NumTargets() == numTargets );
+
+    PostProcessFrame( pool, device, false );
+    CHECK( pool.NumTargets() == 2 );
+    CHECK( pool.Stats().NumTrimmed == numTargets - 2 );
+
+    pool.Shutdown();
+    CHECK( device.Targets.empty() );
+}
+
+TEST_CASE( TempRenderTargetPool_NeverTrimsWithZeroTrimFrames )
+{
+    StubDevice           device;
+    TempRenderTargetPool pool;
+    pool.Initialize( &device, Settings( 0, false ) );
+
+    PostProcessFrame( pool, device, true );
+    const uint64 numTargets = pool.NumTargets();
+    for ( int frame = 0; frame < 100; ++frame )
+    {
+        PostProcessFrame( pool, device, false );
+    }
+    CHECK( pool.NumTargets() == numTargets );
+    CHECK( pool.Stats().NumTrimmed == 0 );
+
+    pool.Shutdown();
+}
+
+TEST_CASE( TempRenderTargetPool_AliasesSequentialTargetsInSharedHeaps )
+{
+    StubDevice           device;
+    TempRenderTargetPool pool;
+    pool.Initialize( &device, Settings( 60, true ) );
+
+    // Two passes that don't overlap share one heap, even with different formats.
+    PooledRenderTarget* a = pool.Acquire( Desc( 512, 512, HDRFormat ) );
+    CHECK( device.NumAliases == 1 );  // A new placed target needs to be initialized.
+    a->InUse              = false;
+    PooledRenderTarget* b = pool.Acquire( Desc( 512, 512, LDRFormat ) );
+    CHECK( b != a );
+    CHECK( pool.NumHeaps() == 1 );
+    CHECK( device.TargetHeaps[a] == device.TargetHeaps[b] );
+    CHECK( pool.Stats().NumAliased == 1 );
+    CheckInvariants( pool, device );
+
+    // While b is in use, a can't be handed out.
+    PooledRenderTarget* c = pool.Acquire( Desc( 512, 512, HDRFormat ) );
+    CHECK( c != a );
+    CHECK( pool.NumHeaps() == 2 );
+    CheckInvariants( pool, device );
+
+    // Once b is released, a takes the memory back.
+    b->InUse = false;
+    c->InUse = false;
+    PooledRenderTarget* d = pool.Acquire( Desc( 512, 512, HDRFormat ) );
+    CHECK( d == c );  // c is still resident, so it is preferred over a.
+    PooledRenderTarget* e = pool.Acquire( Desc( 512, 512, HDRFormat ) );
+    CHECK( e == a );
+    CheckInvariants( pool, device );
+    d->InUse = false;
+    e->InUse = false;
+
+    CHECK( pool.Stats().PeakAllocatedBytes == 2 * device.TargetSize( Desc( 512, 512, HDRFormat ) ) );
+
+    pool.Shutdown();
+    CHECK( device.Targets.empty() );
+    CHECK( device.Heaps.empty() );
+}
+
+TEST_CASE( TempRenderTargetPool_SharedHeapsReducePeakMemory )
+{
+    uint64 peakBytes[2] = {};
+    for ( int shared = 0; shared < 2; ++shared )
+    {
+        StubDevice           device;
+        TempRenderTargetPool pool;
+        pool.Initialize( &device, Settings( 60, shared != 0 ) );
+
+        for ( int frame = 0; frame < 4; ++frame )
+        {
+            // Passes that each use a different format one after the other.
+            const DXGI_FORMAT formats[] = { HDRFormat, LDRFormat, DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R11G11B10_FLOAT };
+            for ( DXGI_FORMAT format: formats )
+            {
+                PooledRenderTarget* target = pool.Acquire( Desc( 1024, 1024, format ) );
+                target->InUse              = false;
+            }
+            pool.Trim();
+            ++device.Fence;
+            CheckInvariants( pool, device );
+        }
+
+        peakBytes[shared] = pool.Stats().PeakAllocatedBytes;
+        CHECK( pool.Stats().PeakInUseBytes == device.TargetSize( Desc( 1024, 1024, HDRFormat ) ) );
+        pool.Shutdown();
+    }
+
+    CHECK( peakBytes[1] < peakBytes[0] );
+}
+
+TEST_CASE( TempRenderTargetPool_ReportsPeakMemory )
+{
+    StubDevice           device;
+    TempRenderTargetPool pool;
+    pool.Initialize( &device, Settings( 1, false ) );
+
+    const uint64 size = device.TargetSize( Desc( 256, 256, LDRFormat ) );
+
+    PooledRenderTarget* a = pool.Acquire( Desc( 256, 256, LDRFormat ) );
+    PooledRenderTarget* b = pool.Acquire( Desc( 256, 256, LDRFormat ) );
+    PooledRenderTarget* c = pool.Acquire( Desc( 256, 256, LDRFormat ) );
+    CHECK( pool.Stats().InUseBytes == 3 * size );
+    a->InUse = false;
+    b->InUse = false;
+    c->InUse = false;
+
+    ++device.Fence;
+    pool.Trim();
+    CHECK( pool.Stats().AllocatedBytes == 0 );
+    CHECK( pool.Stats().PeakAllocatedBytes == 3 * size );
+    CHECK( pool.Stats().PeakInUseBytes == 3 * size );
+
+    pool.ResetPeakStats();
+    CHECK( pool.Stats().PeakAllocatedBytes == 0 );
+
+    PooledRenderTarget* d = pool.Acquire( Desc( 256, 256, LDRFormat ) );
+    CHECK( pool.Stats().PeakInUseBytes == size );
+    d->InUse = false;
+
+    pool.Shutdown();
+}
+
+TEST_CASE( TempRenderTargetPool_RandomizedLifetimes )
+{
+    for ( uint32_t seed = 0; seed < 100; ++seed )
+    {
+        for ( int shared = 0; shared < 2; ++shared )
+        {
+            StubDevice           device;
+            TempRenderTargetPool pool;
+            pool.Initialize( &device, Settings( 3, shared != 0 ) );
+
+            std::mt19937                     random( seed );
+            std::vector<PooledRenderTarget*> inUse;
+            for ( int frame = 0; frame < 100; ++frame )
+            {
+                const int numPasses = random() % 20;
+                for ( int pass = 0; pass < numPasses; ++pass )
+                {
+                    if ( !inUse.empty() && random() % 2 )
+                    {
+                        size_t idx          = random() % inUse.size();
+                        inUse[idx]->InUse = false;
+                        inUse.erase( inUse.begin() + idx );
+                    }
+                    else
+                    {
+                        const uint64         size   = 64ull << ( random() % 4 );
+                        const DXGI_FORMAT    format = random() % 2 ? HDRFormat : LDRFormat;
+                        TempRenderTargetDesc desc   = Desc( size, size, format, random() % 3 == 0 );
+
+                        PooledRenderTarget* target = pool.Acquire( desc );
+                        for ( auto other: inUse )
+                        {
+                            CHECK( other != target );
+                        }
+                        CHECK( target->Desc.Width == desc.Width && target->Desc.Format == desc.Format );
+                        CHECK( target->Desc.UAV || !desc.UAV );
+                        inUse.push_back( target );
+                    }
+                    CheckInvariants( pool, device );
+                }
+
+                for ( auto target: inUse )
+                {
+                    target->InUse = false;
+                }
+                inUse.clear();
+
+                pool.Trim();
+                for ( uint64 i = 0; i < pool.NumTargets(); ++i )
+                {
+                    CHECK( device.Fence < pool.Target( i )->LastUseFence + 3 );
+                }
+                ++device.Fence;
+                CheckInvariants( pool, device );
+            }
+
+            pool.Shutdown();
+            CHECK( device.Targets.empty() );
+            CHECK( device.Heaps.empty() );
+        }
+    }
+}
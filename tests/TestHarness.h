@@ -0,0 +1,74 @@
+#pragma once
+
+/**
+ *  @file TestHarness.h
+ *
+ *  @brief A minimal unit test harness.
+ *
+ *  Test cases are registered with TEST_CASE and are run by TestMain.cpp, which
+ *  is linked into every test executable. A failed CHECK reports the expression
+ *  and continues the test case, a failed REQUIRE also stops the test case.
+ *  The test executable returns the number of test cases that failed, so it can
+ *  be registered with CTest as is.
+ *
+ *  Usage: <test executable> [filter]
+ *  Only the test cases whose name contains the filter are run.
+ */
+
+#include <cmath>
+#include <vector>
+
+namespace Test
+{
+
+using TestFunction = void ( * )();
+
+struct TestCase
+{
+    const char*  Name;
+    TestFunction Function;
+};
+
+std::vector<TestCase>& GetTestCases();
+
+void ReportFailure( const char* expression, const char* file, int line );
+
+struct Registrar
+{
+    Registrar( const char* name, TestFunction function )
+    {
+        GetTestCases().push_back( { name, function } );
+    }
+};
+
+// Thrown by a failed REQUIRE to stop the test case.
+struct RequireFailed
+{};
+
+}  // namespace Test
+
+#define TEST_CASE( name )                                    \
+    static void            name();                           \
+    static Test::Registrar name##_Registrar( #name, &name ); \
+    static void            name()
+
+#define CHECK( expression )                                                \
+    do                                                                     \
+    {                                                                      \
+        if ( !( expression ) )                                             \
+        {                                                                  \
+            Test::ReportFailure( #expression, __FILE__, __LINE__ );        \
+        }                                                                  \
+    } while ( false )
+
+#define REQUIRE( expression )                                              \
+    do                                                                     \
+    {                                                                      \
+        if ( !( expression ) )                                             \
+        {                                                                  \
+            Test::ReportFailure( #expression, __FILE__, __LINE__ );        \
+            throw Test::RequireFailed();                                   \
+        }                                                                  \
+    } while ( false )
+
+#define CHECK_NEAR( a, b, epsilon ) CHECK( std::abs( ( a ) - ( b ) ) <= ( epsilon ) )
@@ -0,0 +1,67 @@
+#include "TestHarness.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+namespace Test
+{
+
+static bool s_TestFailed = false;
+
+std::vector<TestCase>& GetTestCases()
+{
+    static std::vector<TestCase> testCases;
+    return testCases;
+}
+
+void ReportFailure( const char* expression, const char* file, int line )
+{
+    std::fprintf( stderr, "%s(%d): check failed: %s\n", file, line, expression );
+    s_TestFailed = true;
+}
+
+}  // namespace Test
+
+int main( int argc, char* argv[] )
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    int numRun = 0, numFailed = 0;
+    for ( const auto& testCase: Test::GetTestCases() )
+    {
+        if ( filter && std::strstr( testCase.Name, filter ) == nullptr )
+        {
+            continue;
+        }
+
+        Test::s_TestFailed = false;
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        try
+        {
+            testCase.Function();
+        }
+        catch ( const Test::RequireFailed& )
+        {}
+        catch ( const std::exception& e )
+        {
+            std::fprintf( stderr, "%s: unexpected exception: %s\n", testCase.Name, e.what() );
+            Test::s_TestFailed = true;
+        }
+        auto time = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - startTime );
+
+        std::printf( "[%s] %s (%.1f ms)\n", Test::s_TestFailed ? "FAIL" : " OK ", testCase.Name, time.count() );
+
+        ++numRun;
+        if ( Test::s_TestFailed )
+        {
+            ++numFailed;
+        }
+    }
+
+    std::printf( "%d of %d test cases passed.\n", numRun - numFailed, numRun );
+
+    return numFailed;
+}